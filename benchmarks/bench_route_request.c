@@ -0,0 +1,133 @@
+/**
+ * bench_route_request.c - Decide body to RouteRequest transcoding benchmark
+ *
+ * Builds RouteRequests from decide bodies of growing payload size, once
+ * with the streaming transcoder and once with the jansson
+ * parse-and-rebuild path, and reports the time per request of each.
+ */
+
+#define _GNU_SOURCE
+#include "route_request.h"
+#include <jansson.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_ITERATIONS 20000
+#define DEFAULT_MAX_PAYLOAD 65536
+#define MIN_PAYLOAD 256
+
+typedef int (*build_fn)(const char *, size_t, const route_request_overrides_t *,
+                        route_request_ids_t *, char **, size_t *);
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [OPTIONS]\n", prog);
+    printf("\nRouteRequest Transcoding Benchmark\n");
+    printf("\nOptions:\n");
+    printf("  -n <count>     Requests per size and path (default: %d)\n", DEFAULT_ITERATIONS);
+    printf("  -p <bytes>     Largest payload, sizes grow 4x from %d (default: %d)\n",
+           MIN_PAYLOAD, DEFAULT_MAX_PAYLOAD);
+    printf("  -h             Show this help\n");
+    printf("\n");
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* A decide body whose payload and context hold about payload_size bytes */
+static char *make_body(size_t payload_size, size_t *len) {
+    size_t cap = payload_size * 2U + 1024U;
+    char *body = malloc(cap);
+    if (!body) return NULL;
+
+    size_t n = (size_t)snprintf(body, cap,
+        "{\"version\":\"1\",\"tenant_id\":\"tenant-bench\",\"request_id\":\"req-0001\","
+        "\"trace_id\":\"trace-0001\",\"run_id\":\"run-0001\",\"message_id\":\"msg-1\","
+        "\"message_type\":\"chat\",\"policy_id\":\"default\","
+        "\"task\":{\"type\":\"text.generate\",\"payload\":{\"max_tokens\":256}},"
+        "\"metadata\":{\"source\":\"bench\",\"priority\":3},\"payload\":{\"items\":[");
+    /* Mixed records: strings with escapes, numbers, nested objects */
+    for (int i = 0; n < payload_size * 3U / 4U + 200U; i++) {
+        n += (size_t)snprintf(body + n, cap - n,
+            "%s{\"id\":%d,\"text\":\"line %d \\\"quoted\\\" caf\\u00e9\",\"score\":%d.25,"
+            "\"tags\":[\"a\",\"b\"],\"ok\":true}", i ? "," : "", i, i, i);
+    }
+    n += (size_t)snprintf(body + n, cap - n, "]},\"context\":{\"history\":[");
+    for (int i = 0; n < payload_size + 400U; i++) {
+        n += (size_t)snprintf(body + n, cap - n, "%s{\"role\":\"user\",\"n\":%d}", i ? "," : "", i);
+    }
+    n += (size_t)snprintf(body + n, cap - n, "]}}");
+    *len = n;
+    return body;
+}
+
+static double run(build_fn fn, const char *body, size_t len, const route_request_overrides_t *ov,
+                  int iterations, size_t *out_len) {
+    json_malloc_t jmalloc;
+    json_free_t jfree;
+    json_get_alloc_funcs(&jmalloc, &jfree);
+
+    double start = now_sec();
+    for (int i = 0; i < iterations; i++) {
+        route_request_ids_t ids;
+        char *out = NULL;
+        if (fn(body, len, ov, &ids, &out, out_len) != ROUTE_REQUEST_OK) {
+            fprintf(stderr, "build failed\n");
+            exit(1);
+        }
+        jfree(out);
+    }
+    return (now_sec() - start) / (double)iterations;
+}
+
+int main(int argc, char **argv) {
+    int iterations = DEFAULT_ITERATIONS;
+    size_t max_payload = DEFAULT_MAX_PAYLOAD;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:p:h")) != -1) {
+        switch (opt) {
+            case 'n': iterations = atoi(optarg); break;
+            case 'p': max_payload = (size_t)atol(optarg); break;
+            case 'h': print_usage(argv[0]); return 0;
+            default: print_usage(argv[0]); return 1;
+        }
+    }
+    if (iterations <= 0 || max_payload < MIN_PAYLOAD) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    route_request_overrides_t ov = { "tenant-from-ctx", "trace-from-ctx" };
+
+    printf("=== RouteRequest Transcoding Benchmark ===\n");
+    printf("Requests per size and path: %d\n\n", iterations);
+    printf("%10s %10s %14s %14s %9s\n", "body", "output", "streaming", "jansson", "speedup");
+
+    for (size_t size = MIN_PAYLOAD; size <= max_payload; size *= 4U) {
+        size_t len = 0;
+        char *body = make_body(size, &len);
+        if (!body) {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+        /* Scale down so large bodies do not dominate the run */
+        int n = iterations;
+        if (size > 4096U) n = (int)((size_t)iterations * 4096U / size);
+        if (n < 100) n = 100;
+
+        size_t out_len = 0;
+        (void)run(route_request_build, body, len, &ov, n / 10 + 1, &out_len);
+        double streaming = run(route_request_build, body, len, &ov, n, &out_len);
+        double dom = run(route_request_build_dom, body, len, &ov, n, NULL);
+        printf("%9zuB %9zuB %11.2f us %11.2f us %8.1fx\n", len, out_len,
+               streaming * 1e6, dom * 1e6, dom / streaming);
+        free(body);
+    }
+    return 0;
+}
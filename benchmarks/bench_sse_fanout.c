@@ -0,0 +1,212 @@
+/**
+ * bench_sse_fanout.c - SSE fan-out throughput benchmark
+ *
+ * Subscribes N socket pairs to one tenant on an sse_hub, publishes E
+ * events and measures how fast every frame reaches every subscriber.
+ * Reader threads drain the client ends with epoll, as browsers would.
+ */
+
+#define _GNU_SOURCE
+#include "sse_hub.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+#define DEFAULT_SUBSCRIBERS 10000
+#define DEFAULT_EVENTS      200
+#define DEFAULT_PAYLOAD     256
+#define DEFAULT_READERS     4
+#define QUEUE_EVENTS        256
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [OPTIONS]\n", prog);
+    printf("\nSSE Fan-out Benchmark\n");
+    printf("\nOptions:\n");
+    printf("  -n <count>     Subscribers (default: %d)\n", DEFAULT_SUBSCRIBERS);
+    printf("  -e <count>     Events published (default: %d)\n", DEFAULT_EVENTS);
+    printf("  -p <bytes>     Event payload size (default: %d)\n", DEFAULT_PAYLOAD);
+    printf("  -t <threads>   Reader threads (default: %d)\n", DEFAULT_READERS);
+    printf("  -h             Show this help\n");
+    printf("\n");
+}
+
+static atomic_ulong g_bytes_read = 0;
+static atomic_int g_running = 1;
+
+typedef struct {
+    int epoll_fd;
+} reader_t;
+
+static void *reader_main(void *arg) {
+    reader_t *r = arg;
+    struct epoll_event events[256];
+    char buf[65536];
+
+    while (atomic_load(&g_running)) {
+        int n = epoll_wait(r->epoll_fd, events, 256, 50);
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            for (;;) {
+                ssize_t got = read(fd, buf, sizeof(buf));
+                if (got > 0) {
+                    atomic_fetch_add_explicit(&g_bytes_read, (unsigned long)got,
+                                              memory_order_relaxed);
+                    continue;
+                }
+                if (got < 0 && errno == EINTR) continue;
+                if (got == 0) (void)epoll_ctl(r->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+                break;
+            }
+        }
+    }
+    return NULL;
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+    int subscribers = DEFAULT_SUBSCRIBERS;
+    int events = DEFAULT_EVENTS;
+    size_t payload_size = DEFAULT_PAYLOAD;
+    int readers = DEFAULT_READERS;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:e:p:t:h")) != -1) {
+        switch (opt) {
+            case 'n': subscribers = atoi(optarg); break;
+            case 'e': events = atoi(optarg); break;
+            case 'p': payload_size = (size_t)atol(optarg); break;
+            case 't': readers = atoi(optarg); break;
+            case 'h': print_usage(argv[0]); return 0;
+            default: print_usage(argv[0]); return 1;
+        }
+    }
+    if (subscribers <= 0 || events <= 0 || payload_size == 0 || readers <= 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    /* Two fds per subscriber plus slack */
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0) {
+        rlim_t need = (rlim_t)subscribers * 2U + 64U;
+        if (rl.rlim_cur < need) {
+            rl.rlim_cur = need < rl.rlim_max ? need : rl.rlim_max;
+            (void)setrlimit(RLIMIT_NOFILE, &rl);
+        }
+        if (rl.rlim_cur < need) {
+            subscribers = (int)((rl.rlim_cur - 64U) / 2U);
+            printf("Note: fd limit caps subscribers at %d\n", subscribers);
+        }
+    }
+
+    sse_hub_config_t config;
+    sse_hub_get_default_config(&config);
+    config.max_subscribers = subscribers;
+    config.queue_events = QUEUE_EVENTS;
+    sse_hub_t *hub = sse_hub_create(&config);
+    if (!hub || sse_hub_start(hub) != 0) {
+        fprintf(stderr, "Failed to start SSE hub\n");
+        return 1;
+    }
+
+    reader_t *rs = calloc((size_t)readers, sizeof(reader_t));
+    pthread_t *threads = calloc((size_t)readers, sizeof(pthread_t));
+    int *client_fds = calloc((size_t)subscribers, sizeof(int));
+    if (!rs || !threads || !client_fds) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    for (int i = 0; i < readers; i++) {
+        rs[i].epoll_fd = epoll_create1(0);
+    }
+
+    for (int i = 0; i < subscribers; i++) {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+            fprintf(stderr, "socketpair failed after %d subscribers: %s\n", i, strerror(errno));
+            return 1;
+        }
+        (void)fcntl(sv[0], F_SETFL, fcntl(sv[0], F_GETFL, 0) | O_NONBLOCK);
+        (void)fcntl(sv[1], F_SETFL, fcntl(sv[1], F_GETFL, 0) | O_NONBLOCK);
+        struct epoll_event ev = { .events = EPOLLIN | EPOLLET, .data.fd = sv[1] };
+        (void)epoll_ctl(rs[i % readers].epoll_fd, EPOLL_CTL_ADD, sv[1], &ev);
+        client_fds[i] = sv[1];
+        if (sse_hub_subscribe(hub, sv[0], "dashboard") != 0) {
+            fprintf(stderr, "subscribe failed at %d\n", i);
+            return 1;
+        }
+    }
+    for (int i = 0; i < readers; i++) {
+        pthread_create(&threads[i], NULL, reader_main, &rs[i]);
+    }
+
+    char *payload = malloc(payload_size);
+    memset(payload, 'x', payload_size);
+    payload[0] = '{';
+    payload[payload_size - 1U] = '}';
+    size_t frame_len = strlen("event: bench\ndata: ") + payload_size + 2U;
+    unsigned long expect = (unsigned long)subscribers * (unsigned long)events * frame_len;
+
+    printf("=== SSE Fan-out Benchmark ===\n");
+    printf("Subscribers: %d, events: %d, frame: %zu bytes, readers: %d\n",
+           subscribers, events, frame_len, readers);
+
+    double start = now_sec();
+    for (int e = 0; e < events; e++) {
+        (void)sse_hub_publish(hub, "dashboard", "bench", payload, payload_size);
+        /* Stay within half a ring of the slowest reader so nobody is evicted */
+        for (;;) {
+            sse_hub_stats_t st;
+            (void)sse_hub_get_stats(hub, &st);
+            uint64_t owed = (uint64_t)(e + 1) * (uint64_t)subscribers;
+            if (owed - st.delivered < (uint64_t)subscribers * (QUEUE_EVENTS / 2U)) break;
+            usleep(100);
+        }
+    }
+    while (atomic_load(&g_bytes_read) < expect && now_sec() - start < 120.0) {
+        usleep(1000);
+    }
+    double elapsed = now_sec() - start;
+
+    sse_hub_stats_t stats;
+    (void)sse_hub_get_stats(hub, &stats);
+    unsigned long bytes = atomic_load(&g_bytes_read);
+    printf("\nElapsed: %.3f s\n", elapsed);
+    printf("Frames delivered: %lu / %lu\n", (unsigned long)stats.delivered,
+           (unsigned long)subscribers * (unsigned long)events);
+    printf("Events/s: %.0f\n", (double)events / elapsed);
+    printf("Frames/s (event x subscriber): %.0f\n", (double)stats.delivered / elapsed);
+    printf("Throughput: %.1f MB/s\n", (double)bytes / elapsed / 1e6);
+    printf("Evicted: %lu overflow, %lu stalled\n",
+           (unsigned long)stats.evicted_overflow, (unsigned long)stats.evicted_stalled);
+
+    atomic_store(&g_running, 0);
+    for (int i = 0; i < readers; i++) {
+        pthread_join(threads[i], NULL);
+        close(rs[i].epoll_fd);
+    }
+    sse_hub_destroy(hub);
+    for (int i = 0; i < subscribers; i++) {
+        close(client_fds[i]);
+    }
+    free(payload);
+    free(client_fds);
+    free(threads);
+    free(rs);
+    return bytes == expect ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+/**
+ * nats_standin_server.c - NATS stand-in with a mock Router, as a process
+ *
+ * Serves the NATS client protocol on a local port and answers Router
+ * requests with the configured latency, error rate and answer size, so
+ * the gateway, the IPC bridge and the rate-limit benchmarks can run
+ * without a nats-server or a Router. Options override the
+ * NATS_STANDIN_* environment. Runs until SIGINT or SIGTERM.
+ */
+
+#define _GNU_SOURCE
+#include "nats_standin.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+
+static volatile sig_atomic_t g_running = 1;
+
+static void on_signal(int sig) {
+    (void)sig;
+    g_running = 0;
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [OPTIONS]\n", prog);
+    printf("\nNATS stand-in with a mock Router responder\n");
+    printf("\nOptions:\n");
+    printf("  -H <addr>      Listen address (default: 127.0.0.1)\n");
+    printf("  -p <port>      Port, 0 for any free port (default: 4222)\n");
+    printf("  -l <kind>      Latency: fixed, lognormal or bimodal (default: fixed)\n");
+    printf("  -m <us>        Median latency (default: 0)\n");
+    printf("  -s <sigma>     Lognormal shape (default: 0.5)\n");
+    printf("  -S <us>        Bimodal slow latency (default: 0)\n");
+    printf("  -r <ratio>     Bimodal slow share, 0..1 (default: 0.01)\n");
+    printf("  -e <rate>      Share of requests answered with an error (default: 0)\n");
+    printf("  -b <bytes>     Pad answers to this size (default: 0)\n");
+    printf("  -R <subject>   Responder subject (default: beamline.router.>)\n");
+    printf("  -n             No responder (plain NATS stand-in)\n");
+    printf("  -i <seconds>   Print statistics every interval, 0 for never (default: 10)\n");
+    printf("  -h             Show this help\n");
+    printf("\n");
+}
+
+static void print_stats(nats_standin_t *s) {
+    nats_standin_stats_t st;
+    nats_standin_get_stats(s, &st);
+    printf("[standin] clients=%llu conns=%llu in=%llu out=%llu requests=%llu responses=%llu "
+           "errors=%llu slow=%llu proto_errors=%llu\n",
+           (unsigned long long)st.clients, (unsigned long long)st.connections,
+           (unsigned long long)st.msgs_in, (unsigned long long)st.msgs_out,
+           (unsigned long long)st.requests, (unsigned long long)st.responses,
+           (unsigned long long)st.errors_injected, (unsigned long long)st.slow_consumers,
+           (unsigned long long)st.protocol_errors);
+    fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+    nats_standin_config_t config;
+    nats_standin_get_default_config(&config);
+    if (nats_standin_parse_config(&config) != 0) {
+        fprintf(stderr, "Invalid NATS_STANDIN_* environment\n");
+        return 1;
+    }
+    int interval = 10;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "H:p:l:m:s:S:r:e:b:R:ni:h")) != -1) {
+        switch (opt) {
+            case 'H': config.host = optarg; break;
+            case 'p': config.port = (uint16_t)atoi(optarg); break;
+            case 'l':
+                if (nats_standin_parse_latency_kind(optarg, &config.latency.kind) != 0) {
+                    print_usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'm': config.latency.median_us = strtoull(optarg, NULL, 10); break;
+            case 's': config.latency.sigma = atof(optarg); break;
+            case 'S': config.latency.slow_us = strtoull(optarg, NULL, 10); break;
+            case 'r': config.latency.slow_ratio = atof(optarg); break;
+            case 'e': config.error_rate = atof(optarg); break;
+            case 'b': config.response_bytes = (size_t)atol(optarg); break;
+            case 'R': config.responder_subject = optarg; break;
+            case 'n': config.responder = 0; break;
+            case 'i': interval = atoi(optarg); break;
+            case 'h': print_usage(argv[0]); return 0;
+            default: print_usage(argv[0]); return 1;
+        }
+    }
+
+    nats_standin_t *s = nats_standin_create(&config);
+    if (!s) {
+        fprintf(stderr, "Failed to start the stand-in on %s:%u\n", config.host, (unsigned)config.port);
+        return 1;
+    }
+
+    struct sigaction sa = {0};
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    static const char *const kinds[] = { "fixed", "lognormal", "bimodal" };
+    printf("[standin] listening on nats://%s:%u responder=%s latency=%s median_us=%llu "
+           "error_rate=%.3f response_bytes=%zu\n",
+           config.host, (unsigned)nats_standin_get_port(s),
+           config.responder ? config.responder_subject : "off", kinds[config.latency.kind],
+           (unsigned long long)config.latency.median_us, config.error_rate, config.response_bytes);
+    fflush(stdout);
+
+    int elapsed = 0;
+    while (g_running) {
+        sleep(1);
+        if (interval > 0 && ++elapsed % interval == 0) print_stats(s);
+    }
+
+    print_stats(s);
+    nats_standin_destroy(s);
+    return 0;
+}
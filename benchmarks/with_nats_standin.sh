@@ -0,0 +1,64 @@
+#!/bin/bash
+# with_nats_standin.sh - Run a command against a local NATS stand-in
+#
+# Starts build/nats-standin-server (NATS protocol plus a mock Router),
+# exports NATS_URL (and CGW_IPC_NATS_URL for the IPC bridge) pointing at
+# it, runs the given command, then stops the stand-in and prints its
+# counters. Replaces nats-server + tests/mock_router.py for benchmarks.
+#
+# Usage:
+#   NATS_STANDIN_LATENCY=lognormal NATS_STANDIN_LATENCY_US=2000 \
+#       ./benchmarks/with_nats_standin.sh ./build/c-gateway
+#   ./benchmarks/with_nats_standin.sh ./build/soak-test-nats-pool 60
+#
+# Environment:
+#   BUILD_DIR              Where nats-standin-server lives (default: build)
+#   NATS_STANDIN_PORT      Port (default: 4222)
+#   NATS_STANDIN_*         Latency, error rate and answer size; see
+#                          nats-standin-server -h
+
+set -e
+
+BUILD_DIR=${BUILD_DIR:-build}
+NATS_STANDIN_PORT=${NATS_STANDIN_PORT:-4222}
+STANDIN="${BUILD_DIR}/nats-standin-server"
+LOG=${NATS_STANDIN_LOG:-/tmp/nats-standin.log}
+
+if [ $# -eq 0 ]; then
+    sed -n '2,17p' "$0" | sed 's/^# \{0,1\}//'
+    exit 1
+fi
+
+if [ ! -x "$STANDIN" ]; then
+    echo "Error: $STANDIN not found"
+    echo "Run: cmake --build $BUILD_DIR --target nats-standin-server"
+    exit 1
+fi
+
+NATS_STANDIN_PORT=$NATS_STANDIN_PORT "$STANDIN" -i 0 > "$LOG" 2>&1 &
+STANDIN_PID=$!
+
+cleanup() {
+    kill -TERM "$STANDIN_PID" 2>/dev/null || true
+    wait "$STANDIN_PID" 2>/dev/null || true
+    tail -n 1 "$LOG"
+}
+trap cleanup EXIT
+
+for _ in $(seq 1 50); do
+    if grep -q "listening on" "$LOG" 2>/dev/null; then
+        break
+    fi
+    if ! kill -0 "$STANDIN_PID" 2>/dev/null; then
+        echo "Error: stand-in failed to start"
+        cat "$LOG"
+        exit 1
+    fi
+    sleep 0.1
+done
+head -n 1 "$LOG"
+
+export NATS_URL="nats://127.0.0.1:${NATS_STANDIN_PORT}"
+export CGW_IPC_NATS_URL="$NATS_URL"
+
+"$@"
@@ -0,0 +1,198 @@
+/**
+ * admin_view_cache.h - Background-refreshed views of Router admin replies
+ *
+ * Router admin endpoints (extension health, circuit breaker states,
+ * pipeline complexity) are polled by monitoring from many places, yet
+ * their answers change slowly. Each distinct lookup becomes a view: the
+ * latest reply, fetched once and then kept fresh by a refresher thread
+ * for as long as someone keeps reading it. Reads never wait on the
+ * Router once a view exists; a view older than the refresh interval is
+ * still served (stale-while-revalidate) while one refresh runs, up to
+ * max_stale_ms. Every view carries a strong ETag over its status and
+ * body for If-None-Match.
+ *
+ * The cache does not know how to reach the Router: the owner supplies a
+ * fetch function that starts one lookup and reports back through
+ * admin_view_cache_publish(), from any thread, possibly before it
+ * returns.
+ *
+ *   const admin_view_t *view;
+ *   switch (admin_view_cache_get(c, key, key_len, on_loaded, arg, &view)) {
+ *   case ADMIN_VIEW_HIT:     ... send view, then admin_view_release(view)
+ *   case ADMIN_VIEW_WAITING: ... on_loaded(view, arg) runs once the first fetch lands
+ *   case ADMIN_VIEW_ERROR:   ... ask the Router directly
+ *   }
+ */
+
+#ifndef ADMIN_VIEW_CACHE_H
+#define ADMIN_VIEW_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ADMIN_VIEW_ETAG_MAX 20           /* "\"" + 16 hex digits + "\"" + NUL */
+
+/**
+ * Cache configuration
+ */
+typedef struct {
+    int refresh_ms;                  /* Age at which a view is refetched */
+    int max_stale_ms;                /* Oldest view served while a refetch runs */
+    int idle_ms;                     /* Views unread this long are dropped */
+    int max_views;                   /* Distinct keys kept at once */
+    int background;                  /* Run the refresher thread (0 in tests) */
+} admin_view_cache_config_t;
+
+/**
+ * One published reply (reference counted, immutable)
+ */
+typedef struct {
+    int status;                      /* Caller-defined, e.g. an HTTP status */
+    size_t len;
+    const char *body;                /* len bytes, NUL-terminated */
+    char etag[ADMIN_VIEW_ETAG_MAX];  /* Quoted strong entity tag */
+} admin_view_t;
+
+/**
+ * Outcome of admin_view_cache_get()
+ */
+typedef enum {
+    ADMIN_VIEW_HIT = 0,              /* View returned, possibly stale */
+    ADMIN_VIEW_WAITING,              /* Queued on the first fetch of the key */
+    ADMIN_VIEW_ERROR                 /* Bad arguments, out of memory or too many views */
+} admin_view_result_t;
+
+/**
+ * Cache counters
+ */
+typedef struct {
+    uint64_t hits;                   /* Served a view younger than refresh_ms */
+    uint64_t stale_hits;             /* Served an older view while it was refetched */
+    uint64_t misses;                 /* Reads that started a view's first fetch */
+    uint64_t coalesced;              /* Reads queued on a fetch already running */
+    uint64_t refreshes;              /* Fetches that published a reply */
+    uint64_t refresh_failures;       /* Fetches that came back empty */
+    uint64_t views;                  /* Keys held right now */
+} admin_view_cache_stats_t;
+
+typedef struct admin_view_cache_t admin_view_cache_t;
+typedef struct admin_view_fetch_t admin_view_fetch_t;
+
+/**
+ * Start fetching key; must lead to exactly one admin_view_cache_publish()
+ * on fetch. Called without any cache lock held.
+ */
+typedef void (*admin_view_fetch_fn)(admin_view_fetch_t *fetch, const char *key, size_t key_len,
+                                    void *arg);
+
+/**
+ * Wakes a read queued on a first fetch (called on the publishing thread,
+ * outside any cache lock). view is NULL if the fetch failed; otherwise
+ * the callback owns one reference and must release it.
+ */
+typedef void (*admin_view_waiter_fn)(const admin_view_t *view, void *arg);
+
+/**
+ * Fill config with defaults (refresh every 5 s, serve up to 60 s stale,
+ * drop after 5 minutes unread, 1024 views, background refresher on)
+ */
+void admin_view_cache_get_default_config(admin_view_cache_config_t *config);
+
+/**
+ * Apply environment overrides on top of defaults
+ *
+ * GATEWAY_ADMIN_CACHE_REFRESH_MS, GATEWAY_ADMIN_CACHE_MAX_STALE_MS,
+ * GATEWAY_ADMIN_CACHE_IDLE_MS, GATEWAY_ADMIN_CACHE_MAX_VIEWS
+ *
+ * @return 0 on success, -1 on error
+ */
+int admin_view_cache_parse_config(admin_view_cache_config_t *config);
+
+/**
+ * Create a cache (and start its refresher thread if configured)
+ *
+ * @return Cache handle on success, NULL on error
+ */
+admin_view_cache_t *admin_view_cache_create(const admin_view_cache_config_t *config,
+                                            admin_view_fetch_fn fetch, void *fetch_arg);
+
+/**
+ * Read a view, creating it on first use
+ *
+ * @param waiter  Called once the first fetch lands, if WAITING
+ * @param view    Receives a reference on HIT
+ * @return One of admin_view_result_t
+ */
+admin_view_result_t admin_view_cache_get(admin_view_cache_t *c, const char *key, size_t key_len,
+                                         admin_view_waiter_fn waiter, void *waiter_arg,
+                                         const admin_view_t **view);
+
+/**
+ * Read at an explicit monotonic time in milliseconds
+ */
+admin_view_result_t admin_view_cache_get_at(admin_view_cache_t *c, const char *key, size_t key_len,
+                                            admin_view_waiter_fn waiter, void *waiter_arg,
+                                            const admin_view_t **view, uint64_t now_ms);
+
+/**
+ * Report the outcome of a fetch; the fetch handle is consumed
+ *
+ * A NULL body means the fetch failed: the previous reply, if any, stays
+ * and is refetched on the next pass.
+ */
+void admin_view_cache_publish(admin_view_fetch_t *fetch, int status, const char *body, size_t len);
+
+/**
+ * Publish at an explicit monotonic time in milliseconds
+ */
+void admin_view_cache_publish_at(admin_view_fetch_t *fetch, int status, const char *body, size_t len,
+                                 uint64_t now_ms);
+
+/**
+ * One refresher pass: refetch views due for it and drop idle ones
+ *
+ * The background thread runs this every refresh_ms / 2.
+ */
+void admin_view_cache_tick_at(admin_view_cache_t *c, uint64_t now_ms);
+
+/**
+ * The ETag a reply with this status and body is published under
+ */
+void admin_view_etag(int status, const char *body, size_t len, char etag[ADMIN_VIEW_ETAG_MAX]);
+
+/**
+ * Whether an If-None-Match field value lists etag (weak comparison)
+ *
+ * @return 1 on a match (including "*"), 0 otherwise
+ */
+int admin_view_etag_matches(const char *etag, const char *if_none_match, size_t len);
+
+/**
+ * Release a view reference (NULL is a no-op)
+ */
+void admin_view_release(const admin_view_t *view);
+
+/**
+ * Read counters
+ *
+ * @return 0 on success, -1 on error
+ */
+int admin_view_cache_get_stats(admin_view_cache_t *c, admin_view_cache_stats_t *stats);
+
+/**
+ * Stop the refresher and free the cache
+ *
+ * Fetches still in flight may publish afterwards; the last of them frees
+ * what is left. Views still referenced stay valid until released.
+ */
+void admin_view_cache_destroy(admin_view_cache_t *c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADMIN_VIEW_CACHE_H */
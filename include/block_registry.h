@@ -0,0 +1,186 @@
+/**
+ * block_registry.h - Extension block registry store
+ *
+ * Holds the manifest of every registered block version, indexed by
+ * (type, version) in a hash table with no fixed capacity. Lookups never
+ * take a lock: writers are serialized among themselves, publish changes
+ * with atomic pointer swaps and free what they replaced only once every
+ * reader that might still see it has moved on (epoch-based reclamation).
+ *
+ * A record is immutable and reference counted: its manifest is
+ * serialized once, at write time, next to a strong ETag, so a GET sends
+ * the stored bytes as they are.
+ *
+ * A record can also carry one attachment: something derived from the
+ * manifest (a compiled schema, say) that lives and dies with the record,
+ * so readers get it with the same lookup and never see it for another
+ * manifest.
+ *
+ * The whole registry can be written to a snapshot file laid out for
+ * mmap (fixed header, 8-byte aligned records) and loaded back on start.
+ *
+ *   const block_record_t *rec = block_registry_get(reg, type, tlen, version, vlen);
+ *   if (rec) { ... send rec->manifest, rec->etag; block_record_release(rec); }
+ */
+
+#ifndef BLOCK_REGISTRY_H
+#define BLOCK_REGISTRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLOCK_REGISTRY_KEY_MAX   1024    /* Longest type or version accepted */
+#define BLOCK_REGISTRY_ETAG_MAX  20      /* "\"" + 16 hex digits + "\"" + NUL */
+
+/**
+ * One stored block version (reference counted, immutable)
+ */
+typedef struct {
+    const char *type;                    /* NUL-terminated */
+    const char *version;                 /* NUL-terminated */
+    const char *manifest;                /* manifest_len bytes, NUL-terminated */
+    size_t type_len;
+    size_t version_len;
+    size_t manifest_len;
+    char etag[BLOCK_REGISTRY_ETAG_MAX];  /* Quoted strong entity tag */
+    const void *attachment;              /* NULL if none */
+} block_record_t;
+
+/**
+ * One write of a batch
+ */
+typedef struct {
+    const char *type;
+    size_t type_len;
+    const char *version;
+    size_t version_len;
+    const char *manifest;
+    size_t manifest_len;
+    void *attachment;                    /* Given to the registry, may be NULL */
+} block_registry_item_t;
+
+/**
+ * Derive an attachment for a record written without one (as on snapshot
+ * load); may return NULL
+ */
+typedef void *(*block_registry_attach_fn)(const block_record_t *rec, void *arg);
+
+/**
+ * Free an attachment
+ */
+typedef void (*block_registry_detach_fn)(void *attachment);
+
+/**
+ * Registry counters
+ */
+typedef struct {
+    uint64_t entries;                    /* Block versions stored */
+    uint64_t bytes;                      /* Their keys and manifests */
+    uint64_t buckets;                    /* Hash index size */
+    uint64_t retired;                    /* Replaced objects awaiting reclamation */
+} block_registry_stats_t;
+
+typedef struct block_registry_t block_registry_t;
+
+/**
+ * Create an empty registry
+ *
+ * @return Registry handle on success, NULL on error
+ */
+block_registry_t *block_registry_create(void);
+
+/**
+ * Install attachment hooks (before the first write)
+ *
+ * detach frees attachments when their record goes away, and also those
+ * of items a failed write did not store: from an upsert call on, item
+ * attachments belong to the registry.
+ */
+void block_registry_set_hooks(block_registry_t *reg, block_registry_attach_fn attach,
+                              block_registry_detach_fn detach, void *arg);
+
+/**
+ * Look a block version up without locking
+ *
+ * @return A record reference (release with block_record_release()), or
+ *         NULL if there is none
+ */
+const block_record_t *block_registry_get(block_registry_t *reg, const char *type, size_t type_len,
+                                         const char *version, size_t version_len);
+
+/**
+ * Release a record reference (NULL is a no-op)
+ */
+void block_record_release(const block_record_t *rec);
+
+/**
+ * Insert or replace one block version
+ *
+ * @param created  Set to 1 if the version was new, 0 if it replaced one
+ * @return 0 on success, -1 on bad arguments or out of memory
+ */
+int block_registry_upsert(block_registry_t *reg, const char *type, size_t type_len,
+                          const char *version, size_t version_len,
+                          const char *manifest, size_t manifest_len, int *created);
+
+/**
+ * Insert or replace several block versions as one write
+ *
+ * Either every item is stored or, on error, none is. Later items win
+ * over earlier ones with the same key.
+ *
+ * @param created  If not NULL, receives 1 or 0 per item as for upsert
+ * @return 0 on success, -1 on bad arguments or out of memory
+ */
+int block_registry_upsert_batch(block_registry_t *reg, const block_registry_item_t *items, size_t count,
+                                int *created);
+
+/**
+ * Remove one block version
+ *
+ * @return 0 on success, -1 if it was not registered
+ */
+int block_registry_delete(block_registry_t *reg, const char *type, size_t type_len,
+                          const char *version, size_t version_len);
+
+/**
+ * Write every block version to path (through a temporary file and a
+ * rename, so readers of path never see a partial snapshot)
+ *
+ * @return 0 on success, -1 on error
+ */
+int block_registry_save_snapshot(block_registry_t *reg, const char *path);
+
+/**
+ * Map a snapshot file and upsert its contents as one batch
+ *
+ * @param loaded  If not NULL, receives the number of block versions read
+ * @return 0 on success (including a missing file), -1 if the file is
+ *         unreadable or malformed
+ */
+int block_registry_load_snapshot(block_registry_t *reg, const char *path, size_t *loaded);
+
+/**
+ * Read counters
+ *
+ * @return 0 on success, -1 on error
+ */
+int block_registry_get_stats(block_registry_t *reg, block_registry_stats_t *stats);
+
+/**
+ * Free the registry
+ *
+ * No lookup may be running. Records still referenced stay valid until
+ * released.
+ */
+void block_registry_destroy(block_registry_t *reg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLOCK_REGISTRY_H */
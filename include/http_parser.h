@@ -0,0 +1,114 @@
+/**
+ * http_parser.h - Incremental zero-copy HTTP/1.x request head parser
+ *
+ * The parser is fed the whole receive buffer each time more bytes
+ * arrive and resumes where the previous call stopped, so every byte is
+ * scanned once no matter how the head was split across reads. Line
+ * ends and the header colon are located with a vectorized scan (SSE2
+ * when available). Nothing is copied: the method, target and headers
+ * are recorded as offsets into the buffer, which stay valid when the
+ * buffer is reallocated.
+ */
+
+#ifndef HTTP_PARSER_H
+#define HTTP_PARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HTTP_PARSER_MAX_HEADERS 64
+
+/**
+ * Parse result
+ */
+typedef enum {
+    HTTP_PARSE_INCOMPLETE = 0,       /* Need more bytes */
+    HTTP_PARSE_DONE = 1,             /* Head complete; see head_len */
+    HTTP_PARSE_ERROR = -1,           /* Malformed head (answer 400) */
+    HTTP_PARSE_UNSUPPORTED = -2      /* Transfer-Encoding body (answer 501) */
+} http_parse_status_t;
+
+/**
+ * Byte range inside the receive buffer
+ */
+typedef struct {
+    uint32_t off;
+    uint32_t len;
+} http_span_t;
+
+typedef struct {
+    http_span_t name;                /* Without the colon */
+    http_span_t value;               /* Leading and trailing OWS trimmed */
+} http_header_t;
+
+/**
+ * Parsed request head
+ *
+ * Method and target are empty spans when the request line lacks them;
+ * the handler decides how to answer such requests.
+ */
+typedef struct {
+    http_span_t method;
+    http_span_t target;
+    http_header_t headers[HTTP_PARSER_MAX_HEADERS];
+    uint32_t num_headers;
+    uint32_t head_len;               /* Bytes up to and including CRLFCRLF */
+    size_t content_length;           /* 0 when absent */
+    int http11;                      /* Request line ends in HTTP/1.1 */
+    int keep_alive;                  /* Version default adjusted by Connection */
+} http_request_head_t;
+
+/**
+ * Resumable parser state
+ */
+typedef struct {
+    uint32_t pos;                    /* Next byte to scan */
+    uint32_t line_start;             /* Start of the line being scanned */
+    uint32_t colon;                  /* Colon of the current header line, 0 if none yet */
+    int in_headers;                  /* Request line already parsed */
+    int seen_length;                 /* A Content-Length header was seen */
+    int done;
+    http_request_head_t head;
+} http_parser_t;
+
+/**
+ * Reset the parser for a new request
+ */
+void http_parser_init(http_parser_t *parser);
+
+/**
+ * Continue parsing
+ *
+ * @param buf  Start of the request (the same request on every call; it
+ *             may have moved in memory since the previous call)
+ * @param len  Bytes available at buf; must not exceed UINT32_MAX
+ * @return Parse status; HTTP_PARSE_DONE is returned again on later calls
+ */
+http_parse_status_t http_parser_execute(http_parser_t *parser, const char *buf, size_t len);
+
+/**
+ * Case-insensitive header lookup
+ *
+ * @param buf   Buffer the head was parsed from
+ * @param name  Header name without the colon
+ * @return First matching header, or NULL
+ */
+const http_header_t *http_request_find_header(const http_request_head_t *head,
+                                              const char *buf, const char *name);
+
+/**
+ * Offset of the first CR, LF or (if want_colon) ':' in p[0..len), or len
+ *
+ * Exposed for tests; uses SSE2 when the target supports it.
+ */
+size_t http_parser_scan(const char *p, size_t len, int want_colon);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HTTP_PARSER_H */
@@ -0,0 +1,242 @@
+/**
+ * http_reactor.h - Multi-reactor epoll HTTP connection engine
+ *
+ * N reactor threads, each owning an epoll instance and its own
+ * SO_REUSEPORT listening socket, so the kernel spreads accepts across
+ * cores. Every accepted socket is driven by a small per-connection state
+ * machine that accumulates a complete request before dispatching it.
+ * Connections are persistent (HTTP/1.1 keep-alive) and pipelined requests
+ * are answered in order. A handler that waits on a backend parks its
+ * connection and resumes it from any thread once the answer is in.
+ */
+
+#ifndef HTTP_REACTOR_H
+#define HTTP_REACTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+#include "http_parser.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * What the reactor should do with a connection after dispatch
+ */
+typedef enum {
+    HTTP_CONN_CLOSE = 0,        /* Reactor closes the socket */
+    HTTP_CONN_KEEP_ALIVE,       /* Reactor waits for the next request */
+    HTTP_CONN_DETACH,           /* Handler took ownership of the fd (e.g. SSE);
+                                   bytes pipelined behind the request are dropped */
+    HTTP_CONN_PARK              /* Handler answers later via http_reactor_resume() */
+} http_conn_action_t;
+
+/**
+ * Handle to a parked connection (see HTTP_CONN_PARK)
+ */
+typedef struct http_reactor_ticket_t http_reactor_ticket_t;
+
+/**
+ * A complete request handed to the handler
+ *
+ * The data buffer holds the head and body, is NUL-terminated at
+ * data[len], and may be modified in place by the handler. It is only
+ * valid until the handler returns, or, when the handler parks, until the
+ * resume function returns.
+ */
+typedef struct {
+    int fd;                          /* Client socket (non-blocking; write it with
+                                        http_reactor_send_all) */
+    char *data;                      /* Raw request bytes (head + body) */
+    size_t len;                      /* Number of request bytes */
+    const http_request_head_t *head; /* Parsed head; spans are offsets into data */
+    int keep_alive;                  /* 1 if the connection may be reused after this
+                                        request: client asked for it and the
+                                        per-connection cap is not reached */
+    unsigned int seq;                /* 1-based request number on this connection */
+    http_reactor_ticket_t *ticket;   /* Pass to http_reactor_resume() after parking */
+    uint64_t received_ms;            /* Monotonic ms when the connection was accepted
+                                        or this request's first byte was read
+                                        (pipelined requests: when the previous
+                                        one finished) */
+} http_reactor_request_t;
+
+/**
+ * Request handler invoked on a reactor thread
+ *
+ * Handlers run inline: while one executes, no other connection owned by
+ * the same reactor is served, so handlers must not block on slow peers.
+ * A handler waiting on a backend returns HTTP_CONN_PARK instead and
+ * calls http_reactor_resume() with req->ticket when the backend answers.
+ *
+ * The handler must answer with "Connection: close" and return
+ * HTTP_CONN_CLOSE when req->keep_alive is 0. Returning
+ * HTTP_CONN_KEEP_ALIVE otherwise keeps the socket for the next
+ * (possibly already pipelined) request.
+ *
+ * @param req        Request to serve
+ * @param user_data  Opaque pointer from the reactor config
+ * @return Connection disposition
+ */
+typedef http_conn_action_t (*http_reactor_handler_t)(const http_reactor_request_t *req,
+                                                     void *user_data);
+
+/**
+ * Completion of a parked request, invoked on the connection's reactor thread
+ *
+ * Writes the response and returns the disposition, with the same rules
+ * as the handler. keep_alive is the request's value, forced to 0 once
+ * the reactor is stopping.
+ */
+typedef http_conn_action_t (*http_reactor_resume_fn)(int fd, int keep_alive, void *arg);
+
+/**
+ * Reactor configuration
+ */
+typedef struct {
+    uint16_t port;                   /* Listen port (0 = ephemeral) */
+    int num_threads;                 /* Reactor threads (0 = online CPUs) */
+    int listen_backlog;              /* listen() backlog per reactor socket */
+    int max_connections;             /* Open connections per reactor */
+    size_t max_request_size;         /* Largest accepted request (head + body) */
+    int request_timeout_ms;          /* Max time to receive a full request */
+    int keepalive_timeout_ms;        /* Idle time allowed between requests */
+    int max_requests_per_connection; /* Requests served before forcing close */
+    int send_timeout_ms;             /* Max wait for a client to accept response bytes */
+    http_reactor_handler_t handler;  /* Request handler */
+    void *user_data;                 /* Passed through to handler */
+} http_reactor_config_t;
+
+/**
+ * Opaque reactor handle
+ */
+typedef struct http_reactor_t http_reactor_t;
+
+/**
+ * Reactor statistics (summed over all reactor threads)
+ */
+typedef struct {
+    uint64_t accepted;               /* Connections accepted */
+    uint64_t rejected;               /* Connections refused at max_connections */
+    uint64_t requests;               /* Requests dispatched */
+    uint64_t timeouts;               /* Connections closed by request timeout */
+    uint64_t idle_closed;            /* Keep-alive connections closed while idle */
+    uint64_t reused;                 /* Requests served on an already-used connection */
+    uint64_t unsupported;            /* Requests rejected with 501 (chunked bodies) */
+    uint64_t oversized;              /* Requests rejected with 413 */
+    uint64_t active_connections;     /* Currently open connections */
+    uint64_t parked;                 /* Connections waiting for http_reactor_resume */
+} http_reactor_stats_t;
+
+/**
+ * Fill config with defaults (backlog 1024, 64KB requests, 30s request
+ * timeout, 5s keep-alive idle timeout, 1000 requests per connection,
+ * 10s send timeout)
+ */
+void http_reactor_get_default_config(http_reactor_config_t *config);
+
+/**
+ * Apply environment overrides on top of defaults
+ *
+ * GATEWAY_REACTOR_THREADS, GATEWAY_LISTEN_BACKLOG,
+ * GATEWAY_MAX_CONNECTIONS_PER_REACTOR, GATEWAY_HTTP_REQUEST_TIMEOUT_MS,
+ * GATEWAY_HTTP_KEEPALIVE_TIMEOUT_MS, GATEWAY_HTTP_MAX_REQUESTS_PER_CONNECTION,
+ * GATEWAY_HTTP_SEND_TIMEOUT_MS
+ *
+ * @return 0 on success, -1 on error
+ */
+int http_reactor_parse_config(http_reactor_config_t *config);
+
+/**
+ * Create reactors and bind their listening sockets
+ *
+ * Binding happens here so address errors surface before any thread runs.
+ *
+ * @param config  Reactor configuration (handler is required)
+ * @return Reactor handle on success, NULL on error
+ */
+http_reactor_t* http_reactor_create(const http_reactor_config_t *config);
+
+/**
+ * Start reactor threads
+ *
+ * SIGINT and SIGTERM are blocked in reactor threads so that process
+ * signals land on the calling thread.
+ *
+ * @return 0 on success, -1 on error
+ */
+int http_reactor_start(http_reactor_t *reactor);
+
+/**
+ * Ask all reactor threads to stop (non-blocking)
+ */
+void http_reactor_stop(http_reactor_t *reactor);
+
+/**
+ * Stop, join threads, close every connection and free the reactor
+ */
+void http_reactor_destroy(http_reactor_t *reactor);
+
+/**
+ * Resume a parked connection
+ *
+ * Safe from any thread, exactly once per HTTP_CONN_PARK. fn runs on the
+ * connection's reactor thread; the request is served again from there,
+ * including any requests pipelined behind it. Stopping the reactor waits
+ * for parked connections to be resumed.
+ */
+void http_reactor_resume(http_reactor_ticket_t *ticket, http_reactor_resume_fn fn, void *arg);
+
+/**
+ * Set the send timeout used by http_reactor_send_all() on the calling thread
+ *
+ * Reactor threads use the config's send_timeout_ms; threads that answer
+ * requests on the reactor's behalf (a worker pool) call this once.
+ */
+void http_reactor_set_thread_send_timeout(int timeout_ms);
+
+/**
+ * Write a whole buffer to a non-blocking client socket
+ *
+ * Waits for writability when the socket buffer is full, for at most the
+ * calling reactor's send timeout (10s outside reactor threads).
+ *
+ * @return 0 on success, -1 on error or timeout
+ */
+int http_reactor_send_all(int fd, const void *data, size_t len);
+
+/**
+ * Gather-write a vector of buffers to a non-blocking client socket
+ *
+ * Same waiting rules as http_reactor_send_all(). Short writes are resumed
+ * where they stopped, so the whole vector goes out in as few syscalls as
+ * the socket buffer allows. The iov array is modified.
+ *
+ * @return 0 on success, -1 on error or timeout
+ */
+int http_reactor_sendv(int fd, struct iovec *iov, int iovcnt);
+
+/**
+ * Get the bound port (useful when config.port was 0)
+ */
+uint16_t http_reactor_get_port(const http_reactor_t *reactor);
+
+/**
+ * Get number of reactor threads
+ */
+int http_reactor_get_num_threads(const http_reactor_t *reactor);
+
+/**
+ * Get aggregated statistics
+ *
+ * @return 0 on success, -1 on error
+ */
+int http_reactor_get_stats(const http_reactor_t *reactor, http_reactor_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HTTP_REACTOR_H */
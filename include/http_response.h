@@ -0,0 +1,93 @@
+/**
+ * http_response.h - Scatter-gather HTTP response writer
+ *
+ * A response is assembled as an iovec over pre-rendered constants (the
+ * status line, fixed header lines, the Connection trailer) and a small
+ * per-response field buffer holding only the parts that vary:
+ * Content-Length, rate-limit counters, Retry-After and the like. The body
+ * is referenced, not copied, and everything goes out through one
+ * http_reactor_sendv() call, which also resumes short writes.
+ *
+ *   http_response_t resp;
+ *   http_response_init(&resp, "HTTP/1.1 429 Too Many Requests");
+ *   http_response_add_raw(&resp, HTTP_RESPONSE_CONTENT_TYPE_JSON);
+ *   http_response_add_uint(&resp, "Retry-After", 60);
+ *   http_response_send(&resp, fd, keep_alive, body, body_len);
+ *
+ * Strings passed to the writer must stay valid until send returns.
+ */
+
+#ifndef HTTP_RESPONSE_H
+#define HTTP_RESPONSE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HTTP_RESPONSE_MAX_IOV     16
+#define HTTP_RESPONSE_FIELDS_SIZE 512
+
+/* Pre-rendered header lines for http_response_add_raw() */
+#define HTTP_RESPONSE_CONTENT_TYPE_JSON "Content-Type: application/json\r\n"
+#define HTTP_RESPONSE_CONTENT_TYPE_TEXT "Content-Type: text/plain\r\n"
+
+typedef struct {
+    struct iovec iov[HTTP_RESPONSE_MAX_IOV];
+    int iovcnt;
+    char fields[HTTP_RESPONSE_FIELDS_SIZE];  /* Rendered variable header lines */
+    size_t fields_len;
+    int overflow;                            /* Set when iov or fields ran out */
+} http_response_t;
+
+/**
+ * Start a response
+ *
+ * @param status_line  e.g. "HTTP/1.1 200 OK", without CRLF
+ */
+void http_response_init(http_response_t *resp, const char *status_line);
+
+/**
+ * Append pre-rendered header text (one or more CRLF-terminated lines)
+ *
+ * The text is referenced, not copied.
+ */
+void http_response_add_raw(http_response_t *resp, const char *text);
+
+/**
+ * Append "name: value\r\n", copying both into the field buffer
+ */
+void http_response_add_header(http_response_t *resp, const char *name, const char *value);
+
+/**
+ * Append "name: <decimal>\r\n"
+ */
+void http_response_add_uint(http_response_t *resp, const char *name, uint64_t value);
+
+/**
+ * Append Content-Length and Connection, then write headers and body
+ *
+ * @param keep_alive  Nonzero for "Connection: keep-alive", else "close"
+ * @return 0 on success, -1 if the response did not fit or the write failed
+ */
+int http_response_send(http_response_t *resp, int fd, int keep_alive,
+                       const void *body, size_t body_len);
+
+/**
+ * Append Connection, then write the headers alone
+ *
+ * For responses that never carry a body and whose Content-Length, if
+ * sent, would describe another response's body (304 Not Modified).
+ *
+ * @return 0 on success, -1 if the response did not fit or the write failed
+ */
+int http_response_send_head(http_response_t *resp, int fd, int keep_alive);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HTTP_RESPONSE_H */
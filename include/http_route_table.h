@@ -0,0 +1,111 @@
+/**
+ * http_route_table.h - Compiled HTTP route table
+ *
+ * Routes are registered once at startup as method + path pattern and
+ * compiled into a segment trie. A lookup walks the request path one
+ * segment at a time, so its cost depends on the path length rather than
+ * on how many routes exist.
+ *
+ * Pattern syntax (segments separated by '/'):
+ *   literal     matches the same segment exactly
+ *   :name       matches any single segment, possibly empty
+ *   *name       last segment only; matches the rest of the path,
+ *               slashes included, possibly empty
+ *
+ * Literal segments win over parameters, and parameters win over
+ * wildcards. A branch that matches the path but has no route for the
+ * request method is abandoned in favour of the next candidate.
+ */
+
+#ifndef HTTP_ROUTE_TABLE_H
+#define HTTP_ROUTE_TABLE_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HTTP_ROUTE_MAX_PARAMS 4
+
+/**
+ * Methods the table dispatches on
+ */
+typedef enum {
+    HTTP_ROUTE_GET = 0,
+    HTTP_ROUTE_POST,
+    HTTP_ROUTE_PUT,
+    HTTP_ROUTE_DELETE,
+    HTTP_ROUTE_METHOD_COUNT
+} http_route_method_t;
+
+/**
+ * Captured path parameter; value points into the looked-up path and is
+ * not NUL-terminated
+ */
+typedef struct {
+    const char *name;
+    const char *value;
+    size_t len;
+} http_route_param_t;
+
+/**
+ * Lookup result
+ */
+typedef struct {
+    const void *data;                /* Payload given to http_route_table_add */
+    http_route_param_t params[HTTP_ROUTE_MAX_PARAMS];
+    size_t num_params;
+} http_route_match_t;
+
+typedef struct http_route_table_t http_route_table_t;
+
+/**
+ * Create an empty table
+ *
+ * @return Table or NULL on allocation failure
+ */
+http_route_table_t *http_route_table_create(void);
+
+/**
+ * Register a route
+ *
+ * @param method   "GET", "POST", "PUT" or "DELETE"
+ * @param pattern  Path pattern starting with '/'
+ * @param data     Payload returned by lookups (must outlive the table)
+ * @return 0 on success, -1 on a bad pattern, a duplicate route, a
+ *         parameter name clash, or allocation failure
+ */
+int http_route_table_add(http_route_table_t *table, const char *method,
+                         const char *pattern, const void *data);
+
+/**
+ * Find the route for a request
+ *
+ * @param method    Request method (not NUL-terminated)
+ * @param path      Request path without the query string
+ * @return 0 and a filled match, or -1 if no route matches
+ */
+int http_route_table_match(const http_route_table_t *table,
+                           const char *method, size_t method_len,
+                           const char *path, size_t path_len,
+                           http_route_match_t *match);
+
+/**
+ * Parameter captured by name
+ *
+ * @return The parameter, or NULL if the matched route has none by that name
+ */
+const http_route_param_t *http_route_match_param(const http_route_match_t *match,
+                                                 const char *name);
+
+/**
+ * Free the table
+ */
+void http_route_table_destroy(http_route_table_t *table);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HTTP_ROUTE_TABLE_H */
@@ -0,0 +1,196 @@
+/**
+ * idempotency_cache.h - Idempotency-Key response cache
+ *
+ * Remembers the response to a request that carried an Idempotency-Key,
+ * so a client retrying it gets the same answer without the Router being
+ * asked twice. Keys are spread over independently locked shards, each an
+ * LRU bounded in bytes with a TTL on completed entries.
+ *
+ * The same structure backs the decision lookup cache, keyed by message
+ * id with a zero fingerprint and a TTL chosen per response.
+ *
+ * The first request for a key claims it and goes on to do the work;
+ * duplicates that arrive while the claim is open are queued on it and
+ * woken with the same response when the claimant completes, so a burst
+ * of retries costs one Router call.
+ *
+ *   idempotency_claim_t *claim;
+ *   const idempotency_response_t *hit;
+ *   switch (idempotency_cache_begin(c, key, key_len, fp, on_done, arg, &claim, &hit)) {
+ *   case IDEMPOTENCY_MISS:    ... do the work, then idempotency_cache_complete(claim, ...)
+ *   case IDEMPOTENCY_HIT:     ... send hit, then idempotency_response_release(hit)
+ *   case IDEMPOTENCY_WAITING: ... on_done(response, arg) runs once the claim completes
+ *   ...
+ *   }
+ */
+
+#ifndef IDEMPOTENCY_CACHE_H
+#define IDEMPOTENCY_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IDEMPOTENCY_KEY_MAX 255          /* Longest Idempotency-Key accepted */
+#define IDEMPOTENCY_TTL_DEFAULT (-1)     /* complete(): keep for the configured TTL */
+
+/**
+ * Cache configuration
+ */
+typedef struct {
+    size_t max_bytes;                /* Keys, responses and bookkeeping, all shards */
+    int shards;                      /* Rounded up to a power of two */
+    int ttl_ms;                      /* Default lifetime of a completed response */
+    int max_waiters;                 /* Duplicates queued on one claim */
+} idempotency_cache_config_t;
+
+/**
+ * Outcome of idempotency_cache_begin()
+ */
+typedef enum {
+    IDEMPOTENCY_MISS = 0,            /* Key claimed: do the work, then complete */
+    IDEMPOTENCY_HIT,                 /* Stored response returned */
+    IDEMPOTENCY_WAITING,             /* Queued on an open claim */
+    IDEMPOTENCY_MISMATCH,            /* Key already used with another fingerprint */
+    IDEMPOTENCY_BUSY,                /* Claim open and its queue is full */
+    IDEMPOTENCY_ERROR                /* Bad arguments or out of memory */
+} idempotency_result_t;
+
+/**
+ * A stored response (reference counted, immutable)
+ */
+typedef struct {
+    int status;                      /* Caller-defined, e.g. an HTTP status */
+    size_t len;
+    const char *body;                /* len bytes, NUL-terminated */
+} idempotency_response_t;
+
+/**
+ * Cache counters
+ */
+typedef struct {
+    uint64_t hits;                   /* Answered from a stored response */
+    uint64_t misses;                 /* Claims handed out */
+    uint64_t coalesced;              /* Duplicates queued on an open claim */
+    uint64_t mismatches;
+    uint64_t busy;
+    uint64_t evictions;              /* Completed entries dropped for space */
+    uint64_t expirations;            /* Completed entries dropped for age */
+    uint64_t entries;                /* Stored and claimed keys right now */
+    uint64_t bytes;                  /* Charged against max_bytes right now */
+} idempotency_cache_stats_t;
+
+typedef struct idempotency_cache_t idempotency_cache_t;
+typedef struct idempotency_claim_t idempotency_claim_t;
+
+/**
+ * Wakes a queued duplicate (called on the completing thread, outside any
+ * cache lock). response is NULL if the claim was abandoned; otherwise
+ * the callback owns one reference and must release it.
+ */
+typedef void (*idempotency_waiter_fn)(const idempotency_response_t *response, void *arg);
+
+/**
+ * Fill config with defaults (64 MiB, 16 shards, 10 minute TTL, 64
+ * waiters per claim)
+ */
+void idempotency_cache_get_default_config(idempotency_cache_config_t *config);
+
+/**
+ * Apply environment overrides on top of defaults
+ *
+ * GATEWAY_IDEMPOTENCY_MAX_BYTES, GATEWAY_IDEMPOTENCY_SHARDS,
+ * GATEWAY_IDEMPOTENCY_TTL_MS, GATEWAY_IDEMPOTENCY_MAX_WAITERS
+ *
+ * @return 0 on success, -1 on error
+ */
+int idempotency_cache_parse_config(idempotency_cache_config_t *config);
+
+/**
+ * Create a cache
+ *
+ * @return Cache handle on success, NULL on error
+ */
+idempotency_cache_t *idempotency_cache_create(const idempotency_cache_config_t *config);
+
+/**
+ * Fingerprint of a request body (FNV-1a), to tell a retry from a key
+ * reused for a different request
+ */
+uint64_t idempotency_cache_fingerprint(const void *data, size_t len);
+
+/**
+ * Look a key up and claim it if nobody has
+ *
+ * The key should already be scoped by the caller (tenant, route).
+ *
+ * @param waiter  Called once the open claim completes, if WAITING
+ * @param claim   Receives the claim on MISS
+ * @param hit     Receives a response reference on HIT
+ * @return One of idempotency_result_t
+ */
+idempotency_result_t idempotency_cache_begin(idempotency_cache_t *c, const char *key, size_t key_len,
+                                             uint64_t fingerprint, idempotency_waiter_fn waiter,
+                                             void *waiter_arg, idempotency_claim_t **claim,
+                                             const idempotency_response_t **hit);
+
+/**
+ * Begin at an explicit monotonic time in milliseconds
+ */
+idempotency_result_t idempotency_cache_begin_at(idempotency_cache_t *c, const char *key, size_t key_len,
+                                                uint64_t fingerprint, idempotency_waiter_fn waiter,
+                                                void *waiter_arg, idempotency_claim_t **claim,
+                                                const idempotency_response_t **hit, uint64_t now_ms);
+
+/**
+ * Publish the claimant's response to every queued duplicate and, when it
+ * fits, keep it for later lookups
+ *
+ * The claim is consumed.
+ *
+ * @param ttl_ms  How long to keep the response: IDEMPOTENCY_TTL_DEFAULT
+ *                for the configured TTL, 0 to hand it to waiters only
+ */
+void idempotency_cache_complete(idempotency_claim_t *claim, int status, const char *body, size_t len,
+                                int ttl_ms);
+
+/**
+ * Complete at an explicit monotonic time in milliseconds
+ */
+void idempotency_cache_complete_at(idempotency_claim_t *claim, int status, const char *body, size_t len,
+                                   int ttl_ms, uint64_t now_ms);
+
+/**
+ * Drop a claim without a response; queued duplicates are woken with NULL
+ * and the key is free again
+ */
+void idempotency_cache_abandon(idempotency_claim_t *claim);
+
+/**
+ * Release a response reference (NULL is a no-op)
+ */
+void idempotency_response_release(const idempotency_response_t *response);
+
+/**
+ * Read counters
+ *
+ * @return 0 on success, -1 on error
+ */
+int idempotency_cache_get_stats(idempotency_cache_t *c, idempotency_cache_stats_t *stats);
+
+/**
+ * Free the cache
+ *
+ * No claim may be open. Responses still referenced stay valid until
+ * released.
+ */
+void idempotency_cache_destroy(idempotency_cache_t *c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IDEMPOTENCY_CACHE_H */
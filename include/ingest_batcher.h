@@ -0,0 +1,158 @@
+/**
+ * ingest_batcher.h - Per-subject batching for fire-and-forget ingest
+ *
+ * Producers that do not need the Router's answer inline hand their
+ * messages to the batcher and are answered as soon as the message is
+ * queued. Messages are gathered per subject into one JSON array and
+ * flushed when the batch reaches max_batch_messages or max_batch_bytes,
+ * or when its first message has waited linger_ms. A single background
+ * thread hands flushed batches to the send callback, which publishes
+ * them and later reports the publish acknowledgement (or its failure)
+ * through ingest_batch_done().
+ *
+ * Everything queued or waiting for an ack counts against
+ * max_pending_bytes; past it new messages are refused, so a slow or
+ * absent consumer turns into backpressure rather than unbounded memory.
+ *
+ *   static int send_batch(ingest_batch_t *batch, void *arg) {
+ *       return publish_async(batch->subject, batch->payload, on_ack, batch);
+ *   }
+ *   static void on_ack(int status, void *closure) {
+ *       ingest_batch_done((ingest_batch_t *)closure, status);
+ *   }
+ *
+ *   ingest_batcher_t *b = ingest_batcher_create(&config, send_batch, on_result, NULL);
+ *   if (ingest_batcher_submit(b, "ingest.acme", id, json, len) != 0) {
+ *       // over the limit: answer 503
+ *   }
+ */
+
+#ifndef INGEST_BATCHER_H
+#define INGEST_BATCHER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Batcher configuration
+ */
+typedef struct {
+    int max_batch_messages;              /* Messages per batch */
+    size_t max_batch_bytes;              /* Payload bytes per batch; a larger
+                                            message goes out alone */
+    int linger_ms;                       /* Longest a message waits for its
+                                            batch to fill */
+    size_t max_pending_bytes;            /* Queued plus unacknowledged */
+    int max_subjects;                    /* Batches open at once; the oldest
+                                            is flushed to make room */
+} ingest_batcher_config_t;
+
+/**
+ * Batcher statistics (counters are messages unless noted)
+ */
+typedef struct {
+    uint64_t accepted;                   /* Queued */
+    uint64_t refused;                    /* Over max_pending_bytes or closed */
+    uint64_t batches;                    /* Batches handed to send */
+    uint64_t acked;                      /* Acknowledged by the consumer */
+    uint64_t failed;                     /* Send or ack failed */
+    uint64_t failed_batches;
+    size_t pending_bytes;                /* Queued or waiting for an ack */
+    size_t in_flight;                    /* Batches waiting for an ack */
+} ingest_batcher_stats_t;
+
+/**
+ * A flushed batch, valid until ingest_batch_done()
+ */
+typedef struct {
+    uint64_t seq;                        /* Flush order, from 1 */
+    const char *subject;
+    const char *payload;                 /* "[m1,m2,...]", NUL-terminated */
+    size_t payload_len;
+    size_t count;                        /* Messages in it */
+    const char *const *ids;              /* Their ids, in payload order */
+    uint64_t oldest_us;                  /* CLOCK_MONOTONIC of the first */
+} ingest_batch_t;
+
+/**
+ * Publish a batch (batcher thread)
+ *
+ * @return 0 if submitted: ingest_batch_done() must then be called once,
+ *         from any thread, possibly before send returns; non-zero if not
+ *         (the batch is failed with that status)
+ */
+typedef int (*ingest_send_fn)(ingest_batch_t *batch, void *arg);
+
+/**
+ * Outcome of a batch, just before it is freed (status 0 when acked)
+ */
+typedef void (*ingest_result_fn)(const ingest_batch_t *batch, int status, void *arg);
+
+typedef struct ingest_batcher_t ingest_batcher_t;
+
+/**
+ * Fill config with defaults (256 messages or 256KB per batch, 5ms
+ * linger, 64MB pending, 1024 open subjects)
+ */
+void ingest_batcher_get_default_config(ingest_batcher_config_t *config);
+
+/**
+ * Apply environment overrides on top of defaults
+ *
+ * GATEWAY_INGEST_BATCH_MESSAGES, GATEWAY_INGEST_BATCH_KB,
+ * GATEWAY_INGEST_LINGER_MS, GATEWAY_INGEST_MAX_PENDING_MB,
+ * GATEWAY_INGEST_MAX_SUBJECTS
+ *
+ * @return 0 on success, -1 on error
+ */
+int ingest_batcher_parse_config(ingest_batcher_config_t *config);
+
+/**
+ * Create a batcher and start its thread
+ *
+ * @param result May be NULL
+ * @return Batcher on success, NULL on error
+ */
+ingest_batcher_t *ingest_batcher_create(const ingest_batcher_config_t *config,
+                                        ingest_send_fn send, ingest_result_fn result, void *arg);
+
+/**
+ * Queue one JSON message on subject (any thread)
+ *
+ * The subject, id and message are copied.
+ *
+ * @return 0 if queued, -1 if refused
+ */
+int ingest_batcher_submit(ingest_batcher_t *b, const char *subject, const char *id,
+                          const char *json, size_t len);
+
+/**
+ * Report the outcome of a sent batch and free it (any thread)
+ */
+void ingest_batch_done(ingest_batch_t *batch, int status);
+
+/**
+ * Send every open batch now instead of at its linger deadline
+ */
+void ingest_batcher_flush(ingest_batcher_t *b);
+
+/**
+ * Get statistics
+ */
+void ingest_batcher_get_stats(ingest_batcher_t *b, ingest_batcher_stats_t *stats);
+
+/**
+ * Refuse new messages, send what is queued, wait for every outstanding
+ * ack, then free the batcher
+ */
+void ingest_batcher_destroy(ingest_batcher_t *b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INGEST_BATCHER_H */
@@ -0,0 +1,121 @@
+/**
+ * json_scan.h - Validating JSON lexer for single-pass readers
+ *
+ * A cursor over raw JSON bytes for code that needs a few fields out of
+ * a document without building a tree. It accepts exactly what jansson's
+ * json_loads(..., 0, ...) accepts (strict grammar, UTF-8 strings, no
+ * \u0000, nesting up to 2048, integers that fit json_int_t and reals
+ * that do not overflow), so a reader built on it agrees with jansson on
+ * which documents are valid. Nothing is allocated.
+ *
+ *   json_scan_t s;
+ *   json_scan_init(&s, buf, len);
+ *   if (json_scan_object_open(&s) != 0) ...
+ *   int count = 0;
+ *   char key[32];
+ *   while ((rc = json_scan_object_next(&s, &count, key, sizeof(key))) == 1) {
+ *       if (strcmp(key, "id") == 0) json_scan_string(&s, id, sizeof(id));
+ *       else json_scan_value(&s);
+ *   }
+ */
+
+#ifndef JSON_SCAN_H
+#define JSON_SCAN_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define JSON_SCAN_MAX_DEPTH 2048
+
+/**
+ * Cursor state
+ */
+typedef struct {
+    const char *base;                /* Start of the document */
+    const char *p;                   /* Next unread byte */
+    const char *end;                 /* One past the last byte */
+    int depth;                       /* Open objects and arrays */
+} json_scan_t;
+
+/**
+ * Start a cursor over len bytes (need not be NUL-terminated)
+ */
+void json_scan_init(json_scan_t *s, const char *json, size_t len);
+
+/**
+ * Skip whitespace and return the first byte of the next value: one of
+ * '{' '[' '"' 't' 'f' 'n', '-' or a digit, or 0 at the end of input
+ */
+char json_scan_peek(json_scan_t *s);
+
+/**
+ * Consume a string, decoding it into out
+ *
+ * out is NUL-terminated and truncated to size; pass NULL to only skip.
+ *
+ * @return 0 on success, -1 if the next value is not a valid string
+ */
+int json_scan_string(json_scan_t *s, char *out, size_t size);
+
+/**
+ * Consume any value
+ *
+ * @return 0 on success, -1 on malformed input
+ */
+int json_scan_value(json_scan_t *s);
+
+/**
+ * Consume the '{' of an object
+ *
+ * @return 0 on success, -1 if the next value is not an object or nests
+ *         too deep
+ */
+int json_scan_object_open(json_scan_t *s);
+
+/**
+ * Step to the next member of the innermost open object
+ *
+ * count starts at 0 for each object and is maintained by the call. On a
+ * member the decoded key is stored in key (keys that do not fit come
+ * back empty, so they never match a short name) and the cursor is left
+ * at the value, which the caller must consume.
+ *
+ * @return 1 on a member, 0 once the closing '}' was consumed (it is at
+ *         s->p - 1), -1 on malformed input
+ */
+int json_scan_object_next(json_scan_t *s, int *count, char *key, size_t key_size);
+
+/**
+ * Consume the '[' of an array
+ *
+ * @return 0 on success, -1 if the next value is not an array or nests
+ *         too deep
+ */
+int json_scan_array_open(json_scan_t *s);
+
+/**
+ * Step to the next element of the innermost open array
+ *
+ * count works as for json_scan_object_next(). On an element the cursor
+ * is left at it, and the caller must consume it.
+ *
+ * @return 1 on an element, 0 once the closing ']' was consumed, -1 on
+ *         malformed input
+ */
+int json_scan_array_next(json_scan_t *s, int *count);
+
+/**
+ * Check that only whitespace is left
+ *
+ * @return 0 at the end of input, -1 on trailing bytes
+ */
+int json_scan_finish(json_scan_t *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JSON_SCAN_H */
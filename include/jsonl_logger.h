@@ -74,12 +74,15 @@ void jsonl_log_error(const char *component, const char *request_id,
 /**
  * Sanitize JSON string (mask sensitive keys)
  * 
- * Masks values for keys: token, api_key, authorization, password, secret
+ * Replaces the value, of any type, of every key containing token,
+ * api_key, authorization, password, secret, auth, bearer or key with
+ * "***", at any depth
  * 
  * @param json_str  Input JSON string
  * @param out_buf   Output buffer
  * @param buf_size  Output buffer size
- * @return 0 on success, -1 on error
+ * @return 0 on success, -1 on error (input that is not JSON or output
+ *         that does not fit leaves out_buf empty)
  */
 int jsonl_sanitize_json(const char *json_str, char *out_buf, size_t buf_size);
 
@@ -0,0 +1,120 @@
+/**
+ * latency_histogram.h - Mergeable log-linear latency histograms
+ *
+ * Values are recorded in microseconds into HDR-style buckets: exact below
+ * 128us, then 64 linear sub-buckets per power of two, so any reported
+ * value is within 1/64 (about 1.6%) of the recorded one up to 2^32us
+ * (about 71 minutes; larger values are clamped).
+ *
+ * Every recording thread writes its own shard with plain relaxed stores,
+ * no locks and no read-modify-write instructions. Each shard keeps a ring
+ * of time slices; a reader merges the slices of every shard that fall in
+ * the requested window, so a 1m and a 5m view come from the same data
+ * and old samples age out as slices are reused.
+ *
+ *   latency_histogram_t *h = latency_histogram_create(&config);
+ *   latency_histogram_record(h, elapsed_us);          // any thread
+ *   latency_histogram_snapshot(h, 60000, &snap);      // last minute
+ *   uint64_t p99_us = latency_histogram_percentile(&snap, 99.0);
+ */
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LATENCY_HISTOGRAM_SUB_BITS   6     /* 64 sub-buckets per power of two */
+#define LATENCY_HISTOGRAM_MAX_BITS   32    /* Values clamp at 2^32 - 1 us */
+#define LATENCY_HISTOGRAM_BUCKETS \
+    ((2 << LATENCY_HISTOGRAM_SUB_BITS) + \
+     (LATENCY_HISTOGRAM_MAX_BITS - LATENCY_HISTOGRAM_SUB_BITS - 1) * (1 << LATENCY_HISTOGRAM_SUB_BITS))
+
+/**
+ * Histogram configuration
+ */
+typedef struct {
+    int slice_ms;                    /* Rotation granularity of the windows */
+    int slices;                      /* Slices kept; slice_ms * slices is the
+                                        longest window a snapshot can cover */
+} latency_histogram_config_t;
+
+/**
+ * Opaque histogram handle
+ */
+typedef struct latency_histogram_t latency_histogram_t;
+
+/**
+ * Merged view of one window
+ */
+typedef struct {
+    uint64_t counts[LATENCY_HISTOGRAM_BUCKETS];
+    uint64_t total;                  /* Samples in the window */
+} latency_histogram_snapshot_t;
+
+/**
+ * Fill config with defaults (10s slices, 30 of them: a 5m window)
+ */
+void latency_histogram_get_default_config(latency_histogram_config_t *config);
+
+/**
+ * Create a histogram
+ *
+ * @return Histogram handle on success, NULL on error
+ */
+latency_histogram_t *latency_histogram_create(const latency_histogram_config_t *config);
+
+/**
+ * Record one sample (any thread, lock-free; NULL h is a no-op)
+ *
+ * The first sample from a thread allocates that thread's shard.
+ */
+void latency_histogram_record(latency_histogram_t *h, uint64_t value_us);
+
+/**
+ * Record one sample at an explicit monotonic time in milliseconds
+ */
+void latency_histogram_record_at(latency_histogram_t *h, uint64_t value_us, uint64_t now_ms);
+
+/**
+ * Merge every shard's samples from the last window_ms
+ *
+ * The window is rounded up to whole slices and includes the current,
+ * partly filled one, so a 60s window over 10s slices covers 50-60s.
+ *
+ * @return 0 on success, -1 on error
+ */
+int latency_histogram_snapshot(const latency_histogram_t *h, int window_ms,
+                               latency_histogram_snapshot_t *snap);
+
+/**
+ * Snapshot at an explicit monotonic time in milliseconds
+ */
+int latency_histogram_snapshot_at(const latency_histogram_t *h, int window_ms, uint64_t now_ms,
+                                  latency_histogram_snapshot_t *snap);
+
+/**
+ * Value at a percentile (0-100) of a snapshot
+ *
+ * Reports the highest value that shares the sample's bucket, so the
+ * answer never understates the latency.
+ *
+ * @return Microseconds, or 0 for an empty snapshot
+ */
+uint64_t latency_histogram_percentile(const latency_histogram_snapshot_t *snap, double percentile);
+
+/**
+ * Free the histogram and every shard
+ *
+ * No thread may record into h once this is called.
+ */
+void latency_histogram_destroy(latency_histogram_t *h);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LATENCY_HISTOGRAM_H */
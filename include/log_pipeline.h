@@ -0,0 +1,223 @@
+/**
+ * log_pipeline.h - Asynchronous batched JSONL logging
+ *
+ * A call site copies the values of a log line (strings and integers)
+ * into a compact record in its own thread's ring buffer, together with
+ * the function that will format them and a timestamp. Each ring has one
+ * producer and one consumer, so queuing a record takes no lock and no
+ * read-modify-write instruction. One background thread drains every
+ * ring, formats the records into JSON lines and writes them with large
+ * writev calls, so the calling thread never waits on log I/O.
+ *
+ * A full ring either drops the record (counted) or makes the caller wait
+ * for room, per configuration. log_pipeline_flush() waits until every
+ * record queued before it has been written; log_pipeline_close() does
+ * that one last time and stops the thread, after which lines are
+ * written synchronously by the caller so that nothing logged during
+ * shutdown is lost.
+ *
+ *   static size_t format_event(const log_record_t *rec, char *out, size_t cap) {
+ *       log_line_t l = { out, cap, 0 };
+ *       log_line_raw(&l, "{\"timestamp\":");
+ *       log_line_timestamp(&l, rec->ts_us, 3);
+ *       log_line_raw(&l, ",\"message\":");
+ *       log_line_value(&l, &rec->values[0]);
+ *       log_line_raw(&l, "}");
+ *       return log_line_end(&l);
+ *   }
+ *
+ *   log_value_t v[] = { LOG_STR(message) };
+ *   log_pipeline_write(log_pipeline_default(), STDERR_FILENO, format_event, v, 1);
+ */
+
+#ifndef LOG_PIPELINE_H
+#define LOG_PIPELINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LOG_PIPELINE_MAX_VALUES  32      /* Values per record */
+#define LOG_PIPELINE_STRING_MAX  2048    /* Longer strings are truncated */
+#define LOG_PIPELINE_LINE_MAX    8192    /* Formatted line, without the newline */
+
+/**
+ * What a full ring does to a new record
+ */
+typedef enum {
+    LOG_OVERFLOW_DROP = 0,               /* Drop it and count the drop */
+    LOG_OVERFLOW_BLOCK                   /* Wait for the writer to make room */
+} log_overflow_t;
+
+/**
+ * Pipeline configuration
+ */
+typedef struct {
+    int ring_kb;                         /* Per-thread ring size (rounded up
+                                            to a power of two, at least 64);
+                                            records over a quarter of it
+                                            are dropped */
+    int batch_kb;                        /* Bytes gathered per stream before
+                                            a writev */
+    int flush_interval_ms;               /* Longest a queued record waits */
+    log_overflow_t overflow;
+} log_pipeline_config_t;
+
+/**
+ * Pipeline statistics
+ */
+typedef struct {
+    uint64_t queued;                     /* Records accepted into a ring */
+    uint64_t dropped;                    /* Records lost to a full ring or
+                                            that could not be formatted */
+    uint64_t blocked;                    /* Writes that had to wait for room */
+    uint64_t written;                    /* Lines written */
+    uint64_t batches;                    /* writev calls */
+    uint64_t write_errors;               /* Batches the stream refused */
+} log_pipeline_stats_t;
+
+typedef enum {
+    LOG_VALUE_NULL = 0,
+    LOG_VALUE_STR,
+    LOG_VALUE_INT
+} log_value_kind_t;
+
+/**
+ * One value of a record
+ *
+ * Queued strings are copied; a NULL string is queued as LOG_VALUE_NULL.
+ * Formatters see NUL-terminated strings with their length.
+ */
+typedef struct {
+    log_value_kind_t kind;
+    const char *str;
+    size_t len;                          /* LOG_VALUE_CSTR: up to the NUL */
+    long long num;
+} log_value_t;
+
+#define LOG_VALUE_CSTR ((size_t)-1)
+
+#define LOG_STR(s)     ((log_value_t){ .kind = LOG_VALUE_STR, .str = (s), .len = LOG_VALUE_CSTR })
+#define LOG_STRN(s, n) ((log_value_t){ .kind = LOG_VALUE_STR, .str = (s), .len = (n) })
+#define LOG_INT(n)     ((log_value_t){ .kind = LOG_VALUE_INT, .num = (long long)(n) })
+
+/**
+ * A queued record as its formatter sees it
+ */
+typedef struct {
+    uint64_t ts_us;                      /* Wall clock at the call, us since the epoch */
+    const log_value_t *values;
+    size_t count;
+} log_record_t;
+
+/**
+ * Format rec into out as one JSON line (no newline)
+ *
+ * Runs on the pipeline thread, or on the caller once the pipeline is
+ * closed, never on two threads at once for the same pipeline.
+ *
+ * @return Line length (at most cap), 0 to drop the record
+ */
+typedef size_t (*log_format_fn)(const log_record_t *rec, char *out, size_t cap);
+
+typedef struct log_pipeline_t log_pipeline_t;
+
+/**
+ * Fill config with defaults (256KB rings, 256KB batches, 20ms flush
+ * interval, drop on overflow)
+ */
+void log_pipeline_get_default_config(log_pipeline_config_t *config);
+
+/**
+ * Apply environment overrides on top of defaults
+ *
+ * GATEWAY_LOG_RING_KB, GATEWAY_LOG_BATCH_KB, GATEWAY_LOG_FLUSH_MS,
+ * GATEWAY_LOG_OVERFLOW (drop or block)
+ *
+ * @return 0 on success, -1 on error
+ */
+int log_pipeline_parse_config(log_pipeline_config_t *config);
+
+/**
+ * Create a pipeline and start its thread
+ *
+ * @return Pipeline on success, NULL on error
+ */
+log_pipeline_t *log_pipeline_create(const log_pipeline_config_t *config);
+
+/**
+ * The process-wide pipeline, created from the environment on first use
+ * and closed at exit (NULL if it could not be created)
+ */
+log_pipeline_t *log_pipeline_default(void);
+
+/**
+ * Queue one record for fd (any thread)
+ *
+ * The first record from a thread allocates that thread's ring. A NULL
+ * pipeline formats and writes the line synchronously.
+ *
+ * @return 0 if queued or written, -1 if dropped
+ */
+int log_pipeline_write(log_pipeline_t *p, int fd, log_format_fn format,
+                       const log_value_t *values, size_t count);
+
+/**
+ * Wait until every record queued before the call has been written
+ */
+void log_pipeline_flush(log_pipeline_t *p);
+
+/**
+ * Flush and stop the thread; later writes are synchronous
+ */
+void log_pipeline_close(log_pipeline_t *p);
+
+/**
+ * Get statistics
+ */
+void log_pipeline_get_stats(log_pipeline_t *p, log_pipeline_stats_t *stats);
+
+/**
+ * Close and free a pipeline (no writer may still be using it)
+ */
+void log_pipeline_destroy(log_pipeline_t *p);
+
+/* ---------------- Line building for formatters ---------------- */
+
+/**
+ * Output being built: len past cap means the line did not fit
+ */
+typedef struct {
+    char *buf;
+    size_t cap;
+    size_t len;
+} log_line_t;
+
+/** Append literal text */
+void log_line_raw(log_line_t *l, const char *text);
+
+/** Append a JSON string (quoted, escaped) */
+void log_line_str(log_line_t *l, const char *s, size_t len);
+
+/** Append an integer */
+void log_line_int(log_line_t *l, long long n);
+
+/** Append a value: string, integer or null */
+void log_line_value(log_line_t *l, const log_value_t *v);
+
+/** Append "YYYY-MM-DDTHH:MM:SS.<digits>Z" (UTC, 3 or 6 fraction digits) */
+void log_line_timestamp(log_line_t *l, uint64_t ts_us, int digits);
+
+/**
+ * @return Line length, or 0 if it did not fit
+ */
+size_t log_line_end(const log_line_t *l);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOG_PIPELINE_H */
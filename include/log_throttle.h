@@ -0,0 +1,175 @@
+/**
+ * log_throttle.h - Per-callsite rate limiting for repetitive log lines
+ *
+ * A line that can fire once per request (a degraded dependency, a
+ * fallback taken, a payload dump) gets a static callsite. Before
+ * formatting anything the call site asks log_throttle_allow(), which
+ * applies three filters in order:
+ *
+ *   1. level: callsites above the configured level are skipped;
+ *   2. sampling: one in sample_every[level] messages is kept;
+ *   3. a token bucket per callsite (rate_per_sec, burst).
+ *
+ * Messages stopped by sampling or by the bucket are counted on the
+ * callsite; the next line it emits reports how many similar messages
+ * were suppressed since the previous one. All settings can be changed
+ * while the process runs; callsites pick them up on their next call.
+ *
+ *   static log_callsite_t degraded_site = LOG_CALLSITE_INIT("redis_degraded", LOG_LEVEL_WARN);
+ *
+ *   uint64_t suppressed;
+ *   if (log_throttle_allow(&degraded_site, &suppressed)) {
+ *       log_json("warn", "rate_limit", "Redis degraded (suppressed %llu similar messages)",
+ *                (unsigned long long)suppressed);
+ *   }
+ *
+ * Nothing locks: a suppressed message costs a few relaxed loads and two
+ * atomic increments, an emitted one a compare-and-swap on its bucket.
+ */
+
+#ifndef LOG_THROTTLE_H
+#define LOG_THROTTLE_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    LOG_LEVEL_ERROR = 0,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_DEBUG,
+    LOG_LEVEL_COUNT
+} log_level_t;
+
+/**
+ * Why a message was not emitted
+ */
+typedef enum {
+    LOG_THROTTLE_SAMPLED = 0,            /* Not the one in sample_every */
+    LOG_THROTTLE_RATE_LIMITED            /* Callsite bucket empty */
+} log_throttle_reason_t;
+
+/**
+ * Throttle settings, shared by every callsite
+ */
+typedef struct {
+    log_level_t level;                   /* Callsites above it are skipped */
+    int rate_per_sec;                    /* Lines per callsite per second,
+                                            0 for no limit */
+    int burst;                           /* Lines a quiet callsite may emit
+                                            back to back */
+    int sample_every[LOG_LEVEL_COUNT];   /* Keep one message in N per level */
+} log_throttle_config_t;
+
+/**
+ * One logging statement; define it static at the call site
+ */
+typedef struct log_callsite {
+    const char *name;
+    log_level_t level;
+    atomic_uint_fast64_t tat_us;         /* Bucket: theoretical arrival time */
+    atomic_uint_fast64_t seen;           /* Messages offered while sampling */
+    atomic_uint_fast64_t pending;        /* Suppressed since the last line */
+    atomic_uint_fast64_t emitted;
+    atomic_uint_fast64_t suppressed;
+    atomic_int registered;
+    struct log_callsite *next;           /* Immutable once registered */
+} log_callsite_t;
+
+#define LOG_CALLSITE_INIT(site_name, site_level) { .name = (site_name), .level = (site_level) }
+
+/**
+ * Callsite counters
+ */
+typedef struct {
+    const char *name;
+    log_level_t level;
+    uint64_t emitted;                    /* Lines allowed out */
+    uint64_t suppressed;                 /* Sampled out or rate limited */
+} log_callsite_stats_t;
+
+/**
+ * Called for every suppressed message (any thread, must not log through
+ * a throttled callsite)
+ */
+typedef void (*log_throttle_hook_fn)(const log_callsite_t *site, log_throttle_reason_t reason);
+
+/**
+ * Fill config with defaults (level info, 1 line per second per callsite
+ * with bursts of 5, no sampling)
+ */
+void log_throttle_get_default_config(log_throttle_config_t *config);
+
+/**
+ * Apply environment overrides on top of defaults
+ *
+ * GATEWAY_LOG_LEVEL (error, warn, info or debug), GATEWAY_LOG_RATE
+ * (0 for no limit), GATEWAY_LOG_BURST, GATEWAY_LOG_SAMPLE_ERROR,
+ * GATEWAY_LOG_SAMPLE_WARN, GATEWAY_LOG_SAMPLE_INFO, GATEWAY_LOG_SAMPLE_DEBUG
+ *
+ * @return 0 on success, -1 on error
+ */
+int log_throttle_parse_config(log_throttle_config_t *config);
+
+/**
+ * Replace the settings (any thread, any time)
+ *
+ * Until the first call the settings come from the environment.
+ *
+ * @return 0 on success, -1 if config is invalid
+ */
+int log_throttle_configure(const log_throttle_config_t *config);
+
+/**
+ * Current settings
+ */
+void log_throttle_get_config(log_throttle_config_t *config);
+
+/**
+ * Install the suppression hook (NULL to remove)
+ */
+void log_throttle_set_hook(log_throttle_hook_fn hook);
+
+/**
+ * Should this message be logged?
+ *
+ * @param suppressed Set, when the message is allowed, to the messages of
+ *                   this callsite suppressed since its previous line
+ * @return 1 to log it, 0 to drop it
+ */
+int log_throttle_allow(log_callsite_t *site, uint64_t *suppressed);
+
+/**
+ * log_throttle_allow() at a given CLOCK_MONOTONIC time in microseconds
+ */
+int log_throttle_allow_at(log_callsite_t *site, uint64_t now_us, uint64_t *suppressed);
+
+/**
+ * Counters of the callsites that have been reached so far
+ *
+ * @return Callsites known (may exceed max; only max are written)
+ */
+size_t log_throttle_get_stats(log_callsite_stats_t *stats, size_t max);
+
+/**
+ * Level name ("error", "warn", "info", "debug")
+ */
+const char *log_level_name(log_level_t level);
+
+/**
+ * Parse a level name
+ *
+ * @return 0 on success, -1 if name is not a level
+ */
+int log_level_parse(const char *name, log_level_t *level);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOG_THROTTLE_H */
@@ -3,6 +3,18 @@
  * 
  * Task 23: Connection pooling for NATS to improve performance
  * and reduce overhead of connection establishment.
+ *
+ * Built with USE_NATS_LIB the pool holds real natsConnection objects:
+ * health follows the library's connection events and
+ * natsConnection_Status(). Without it the pool manages placeholder
+ * handles, so the pooling logic can be exercised without a server.
+ *
+ * A connection can be used two ways:
+ *   - acquired: exclusive until released (nats_pool_acquire/release);
+ *   - bound to a thread: shared, since a NATS connection is thread
+ *     safe. nats_pool_thread_connection() gives every worker thread its
+ *     own connection while there are enough of them, and after the first
+ *     call returns it without taking the pool lock.
  */
 
 #ifndef NATS_POOL_H
@@ -16,6 +28,33 @@
 extern "C" {
 #endif
 
+/**
+ * Opaque NATS connection pool handle
+ */
+typedef struct nats_pool_t nats_pool_t;
+
+/**
+ * Opaque pooled connection handle
+ */
+typedef struct nats_connection_t nats_connection_t;
+
+/**
+ * Connection lifecycle hooks (each optional)
+ *
+ * on_open runs when a connection has been created, before anyone can
+ * use it; a non-zero return discards the connection. on_close runs once
+ * the connection is closed and before it is destroyed. on_state runs on
+ * the library's event thread when a connection goes down or comes back,
+ * with the number of healthy connections in the pool after the change;
+ * it must not call back into the pool.
+ */
+typedef struct {
+    int (*on_open)(nats_connection_t *conn, void *arg);
+    void (*on_close)(nats_connection_t *conn, void *arg);
+    void (*on_state)(nats_connection_t *conn, int connected, size_t healthy, void *arg);
+    void *arg;
+} nats_pool_hooks_t;
+
 /**
  * NATS connection pool configuration
  */
@@ -24,20 +63,18 @@ typedef struct {
     size_t max_connections;          /* Maximum pool size */
     int connection_timeout_ms;       /* Connection timeout */
     int idle_timeout_sec;            /* Idle connection timeout */
-    int max_reconnect_attempts;      /* Max reconnect attempts per connection */
+    int max_reconnect_attempts;      /* Max reconnect attempts per connection
+                                        (-1 = forever) */
     const char *nats_url;            /* NATS server URL */
+    const char *name;                /* Client name prefix (optional) */
+    int reconnect_wait_ms;           /* Between reconnect attempts (0 = library default) */
+    int reconnect_buf_kb;            /* Publishes buffered while reconnecting
+                                        (0 = library default) */
+    int retry_connect;               /* 1: a failed first connect is retried in
+                                        the background instead of failing */
+    nats_pool_hooks_t hooks;
 } nats_pool_config_t;
 
-/**
- * Opaque NATS connection pool handle
- */
-typedef struct nats_pool_t nats_pool_t;
-
-/**
- * Opaque pooled connection handle
- */
-typedef struct nats_connection_t nats_connection_t;
-
 /**
  * Connection pool statistics
  */
@@ -50,6 +87,10 @@ typedef struct {
     size_t total_released;           /* Total releases */
     size_t acquire_timeouts;         /* Acquisition timeouts */
     size_t health_check_failures;    /* Failed health checks */
+    size_t open_connections;         /* Currently open */
+    size_t healthy_connections;      /* Open and connected */
+    size_t bound_threads;            /* Threads with a connection affinity */
+    size_t rebinds;                  /* Affinities moved off an unhealthy connection */
 } nats_pool_stats_t;
 
 /**
@@ -80,6 +121,24 @@ nats_connection_t* nats_pool_acquire(nats_pool_t *pool, int timeout_ms);
  */
 void nats_pool_release(nats_pool_t *pool, nats_connection_t *conn);
 
+/**
+ * Connection bound to the calling thread
+ *
+ * The first call binds the thread to an unbound healthy connection,
+ * opening one if the pool is below max_connections, else to the healthy
+ * connection with the fewest threads. Later calls return it without
+ * locking while it stays healthy; once it goes down the thread moves to
+ * a healthy one if there is any. The connection is shared, not
+ * acquired: never release it.
+ *
+ * A bound connection is not closed by health checks. Bindings of
+ * threads that exit are kept until the pool is destroyed.
+ *
+ * @param pool  Pool handle
+ * @return Connection, or NULL if the pool has none and cannot open one
+ */
+nats_connection_t* nats_pool_thread_connection(nats_pool_t *pool);
+
 /**
  * Get pool statistics
  * 
@@ -92,7 +151,9 @@ int nats_pool_get_stats(const nats_pool_t *pool, nats_pool_stats_t *stats);
 /**
  * Health check idle connections
  * 
- * Removes stale or unhealthy connections from pool.
+ * Removes stale or unhealthy connections from pool. Connections that
+ * are acquired or bound to a thread are left alone, and idle ones are
+ * only closed down to min_connections.
  * Should be called periodically (e.g., every 30 seconds).
  * 
  * @param pool  Pool handle
@@ -119,6 +180,24 @@ void nats_pool_destroy(nats_pool_t *pool);
  */
 void* nats_pool_get_handle(nats_connection_t *conn);
 
+/**
+ * Is the connection up?
+ *
+ * @param conn  Pooled connection
+ * @return 1 if connected, 0 if down, reconnecting or closed
+ */
+int nats_pool_connection_healthy(const nats_connection_t *conn);
+
+/**
+ * Attach caller state to a connection (typically from on_open)
+ */
+void nats_pool_set_user(nats_connection_t *conn, void *user);
+
+/**
+ * Caller state attached with nats_pool_set_user()
+ */
+void* nats_pool_get_user(const nats_connection_t *conn);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,155 @@
+/**
+ * nats_standin.h - Local NATS server stand-in with a mock Router
+ *
+ * Enough of the NATS client protocol for libnats and the gateway to run
+ * against it without a real nats-server: INFO, CONNECT, PING/PONG, SUB
+ * (with queue groups and the * and > wildcards), UNSUB (with a message
+ * limit), PUB and HPUB, delivered as MSG and HMSG. There is no
+ * clustering, authentication, TLS or JetStream; one thread serves every
+ * client with epoll.
+ *
+ * The built-in responder answers requests (messages with a reply
+ * subject) published on Router subjects as the Router would, after a
+ * latency drawn from a fixed, lognormal or bimodal distribution. A
+ * share of them can be answered with an error, and successful answers
+ * can be padded to a given size. Ingest subjects get a JetStream-style
+ * publish ack instead of a decision.
+ *
+ *   nats_standin_config_t config;
+ *   nats_standin_get_default_config(&config);
+ *   config.latency.kind = NATS_STANDIN_LATENCY_LOGNORMAL;
+ *   config.latency.median_us = 2000;
+ *   nats_standin_t *s = nats_standin_create(&config);
+ *   // NATS_URL=nats://127.0.0.1:<nats_standin_get_port(s)>
+ *   nats_standin_destroy(s);
+ *
+ * The nats-standin-server executable wraps this for benchmarks that
+ * want it as a separate process.
+ */
+
+#ifndef NATS_STANDIN_H
+#define NATS_STANDIN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Responder latency distribution
+ */
+typedef enum {
+    NATS_STANDIN_LATENCY_FIXED = 0,      /* Always median_us */
+    NATS_STANDIN_LATENCY_LOGNORMAL,      /* Median median_us, shape sigma */
+    NATS_STANDIN_LATENCY_BIMODAL         /* median_us, or slow_us with
+                                            probability slow_ratio */
+} nats_standin_latency_kind_t;
+
+typedef struct {
+    nats_standin_latency_kind_t kind;
+    uint64_t median_us;
+    double sigma;                        /* Lognormal: sd of the log */
+    uint64_t slow_us;                    /* Bimodal: slow mode */
+    double slow_ratio;                   /* Bimodal: 0..1 */
+} nats_standin_latency_t;
+
+/**
+ * Stand-in configuration
+ */
+typedef struct {
+    const char *host;                    /* Listen address */
+    uint16_t port;                       /* 0: any free port */
+    int max_clients;
+    size_t max_payload;                  /* Announced in INFO and enforced */
+    size_t max_pending;                  /* Unsent bytes per client before
+                                            it is dropped as a slow consumer */
+    int responder;                       /* Answer Router requests */
+    const char *responder_subject;       /* Subjects it listens on */
+    nats_standin_latency_t latency;
+    double error_rate;                   /* Share answered with an error */
+    size_t response_bytes;               /* Pad answers to at least this */
+    uint64_t seed;                       /* Latency and error draws */
+} nats_standin_config_t;
+
+/**
+ * Stand-in statistics
+ */
+typedef struct {
+    uint64_t connections;                /* Accepted so far */
+    uint64_t clients;                    /* Connected now */
+    uint64_t msgs_in;                    /* PUB and HPUB */
+    uint64_t msgs_out;                   /* MSG and HMSG */
+    uint64_t bytes_in;                   /* Payload bytes */
+    uint64_t bytes_out;
+    uint64_t requests;                   /* Taken by the responder */
+    uint64_t responses;
+    uint64_t errors_injected;
+    uint64_t slow_consumers;             /* Clients dropped for max_pending */
+    uint64_t protocol_errors;
+} nats_standin_stats_t;
+
+typedef struct nats_standin_t nats_standin_t;
+
+/**
+ * Fill config with defaults (127.0.0.1:4222, 1024 clients, 1MB
+ * payloads, 64MB pending per client, responder on "beamline.router.>"
+ * with no latency, no errors, no padding)
+ */
+void nats_standin_get_default_config(nats_standin_config_t *config);
+
+/**
+ * Apply environment overrides on top of defaults
+ *
+ * NATS_STANDIN_PORT, NATS_STANDIN_LATENCY (fixed, lognormal or bimodal),
+ * NATS_STANDIN_LATENCY_US, NATS_STANDIN_SIGMA, NATS_STANDIN_SLOW_US,
+ * NATS_STANDIN_SLOW_RATIO, NATS_STANDIN_ERROR_RATE,
+ * NATS_STANDIN_RESPONSE_BYTES
+ *
+ * @return 0 on success, -1 if a value is invalid
+ */
+int nats_standin_parse_config(nats_standin_config_t *config);
+
+/**
+ * Parse a latency kind name ("fixed", "lognormal", "bimodal")
+ *
+ * @return 0 on success, -1 if name is not a kind
+ */
+int nats_standin_parse_latency_kind(const char *name, nats_standin_latency_kind_t *kind);
+
+/**
+ * Draw one responder latency
+ *
+ * @param rng State of the generator, advanced by the call (not 0)
+ */
+uint64_t nats_standin_sample_latency(const nats_standin_latency_t *latency, uint64_t *rng);
+
+/**
+ * Bind, listen and start the server thread
+ *
+ * @return Stand-in on success, NULL on error
+ */
+nats_standin_t *nats_standin_create(const nats_standin_config_t *config);
+
+/**
+ * Port the stand-in listens on
+ */
+uint16_t nats_standin_get_port(const nats_standin_t *s);
+
+/**
+ * Get statistics
+ */
+void nats_standin_get_stats(nats_standin_t *s, nats_standin_stats_t *stats);
+
+/**
+ * Stop the thread, disconnect every client and free the stand-in
+ * (answers still waiting on their latency are dropped)
+ */
+void nats_standin_destroy(nats_standin_t *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NATS_STANDIN_H */
@@ -0,0 +1,98 @@
+/**
+ * pii_redactor.h - Sensitive key matching and streaming JSON redaction
+ *
+ * A redactor compiles a set of sensitive key names into one automaton
+ * (a DFA over the bytes that occur in the names, ASCII case folded), so
+ * deciding whether a key is sensitive costs one table step per byte
+ * whatever the number of names. Exact mode accepts keys equal to a
+ * name; contains mode accepts keys with a name anywhere in them (an
+ * Aho-Corasick automaton).
+ *
+ * Redaction walks serialized JSON once and replaces the value of every
+ * member with a sensitive key, whatever its type, with a fixed mask.
+ * Bytes between masked values are moved as whole runs and nothing is
+ * allocated; the output can be written over the input itself.
+ *
+ *   static const char *const keys[] = { "password", "token" };
+ *   pii_redactor_t *r = pii_redactor_create(keys, 2, PII_MATCH_EXACT, "\"[REDACTED]\"");
+ *   size_t n;
+ *   if (pii_redact_in_place(r, buf, len, sizeof(buf), &n) == 0) fwrite(buf, 1, n, f);
+ */
+
+#ifndef PII_REDACTOR_H
+#define PII_REDACTOR_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PII_REDACT_MAX_DEPTH 256         /* Deepest nesting redacted */
+
+/**
+ * How keys are matched against the names
+ */
+typedef enum {
+    PII_MATCH_EXACT = 0,                 /* Key equals a name */
+    PII_MATCH_CONTAINS                   /* Key contains a name */
+} pii_match_t;
+
+typedef struct pii_redactor_t pii_redactor_t;
+
+/**
+ * Compile a redactor
+ *
+ * @param keys   count non-empty ASCII names, matched case-insensitively
+ * @param mask   JSON text written in place of sensitive values
+ * @return Redactor on success, NULL on bad arguments or out of memory
+ */
+pii_redactor_t *pii_redactor_create(const char *const *keys, size_t count, pii_match_t match,
+                                    const char *mask);
+
+/**
+ * Match len bytes of decoded text (a key) against the names
+ *
+ * @return 1 if sensitive, 0 otherwise
+ */
+int pii_redactor_matches(const pii_redactor_t *r, const char *text, size_t len);
+
+/**
+ * Largest output redacting len bytes can produce (excluding a NUL)
+ */
+size_t pii_redact_bound(const pii_redactor_t *r, size_t len);
+
+/**
+ * Redact len bytes of JSON into out
+ *
+ * out is NUL-terminated when there is room for it. json and out must
+ * not overlap; see pii_redact_in_place() for that.
+ *
+ * @param out_len  Receives the output length
+ * @return 0 on success, -1 if the input is not JSON (as far as read),
+ *         nests too deep or the output does not fit
+ */
+int pii_redact(const pii_redactor_t *r, const char *json, size_t len, char *out, size_t out_size,
+               size_t *out_len);
+
+/**
+ * Redact the len bytes of JSON at the start of buf, which holds cap
+ *
+ * Masks longer than the values they replace need room past len: with
+ * cap >= pii_redact_bound(r, len) it always fits. On failure the
+ * buffer contents are unspecified.
+ *
+ * @return 0 on success, -1 as for pii_redact()
+ */
+int pii_redact_in_place(const pii_redactor_t *r, char *buf, size_t len, size_t cap, size_t *out_len);
+
+/**
+ * Free a redactor (NULL is a no-op)
+ */
+void pii_redactor_free(pii_redactor_t *r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PII_REDACTOR_H */
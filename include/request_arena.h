@@ -0,0 +1,146 @@
+/**
+ * request_arena.h - Per-request bump allocator
+ *
+ * Each reactor thread owns one arena. handle_client opens a request
+ * scope before touching the request and closes it once the response is
+ * written; everything allocated in between (jansson values and dumps,
+ * log entries, spans, scratch buffers) is carved from the arena and
+ * released in one step when the scope ends. Chunks are kept across
+ * requests, so a warmed-up thread serves the same request shape without
+ * calling malloc.
+ *
+ * Memory from a scope must not outlive it: data that is cached or handed
+ * to another thread has to be copied to the heap (strdup and friends).
+ */
+
+#ifndef REQUEST_ARENA_H
+#define REQUEST_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define REQUEST_ARENA_CHUNK_SIZE (64U * 1024U)
+
+typedef struct request_arena_t request_arena_t;
+
+/**
+ * Arena counters (for tests and /_metrics)
+ */
+typedef struct {
+    uint64_t chunk_allocs;           /* Chunks obtained from malloc */
+    uint64_t allocations;            /* Allocations served from the arena */
+    uint64_t resets;                 /* Completed request scopes */
+    size_t high_water;               /* Most bytes used by one scope */
+} request_arena_stats_t;
+
+/**
+ * Create an arena
+ *
+ * @param chunk_size  Size of each retained chunk (0 = REQUEST_ARENA_CHUNK_SIZE)
+ * @return Arena or NULL on allocation failure
+ */
+request_arena_t *request_arena_create(size_t chunk_size);
+
+/**
+ * Free the arena and all its chunks
+ */
+void request_arena_destroy(request_arena_t *arena);
+
+/**
+ * Allocate 16-byte aligned memory from the arena
+ *
+ * Requests larger than the chunk size get a dedicated chunk that is
+ * returned to malloc on the next reset.
+ *
+ * @return Pointer or NULL on allocation failure
+ */
+void *request_arena_alloc(request_arena_t *arena, size_t size);
+
+/**
+ * Zeroed allocation of n * size bytes (NULL on overflow)
+ */
+void *request_arena_calloc(request_arena_t *arena, size_t n, size_t size);
+
+/**
+ * Give memory back; only the most recent allocation is actually reclaimed
+ */
+void request_arena_release(request_arena_t *arena, void *ptr);
+
+/**
+ * Whether ptr lies inside one of the arena's chunks
+ */
+int request_arena_owns(const request_arena_t *arena, const void *ptr);
+
+/**
+ * Drop every allocation, keeping standard-size chunks for reuse
+ */
+void request_arena_reset(request_arena_t *arena);
+
+/**
+ * Copy out the arena counters
+ */
+void request_arena_get_stats(const request_arena_t *arena, request_arena_stats_t *stats);
+
+/* ---------------- Thread request scope ---------------- */
+
+/**
+ * Open the calling thread's request scope (creates its arena lazily)
+ *
+ * Scopes do not nest; a second begin is ignored.
+ */
+void request_arena_begin(void);
+
+/**
+ * Close the calling thread's request scope and reset its arena
+ */
+void request_arena_end(void);
+
+/**
+ * Arena of the open scope on this thread, or NULL outside a scope
+ */
+request_arena_t *request_arena_current(void);
+
+/**
+ * Scratch allocation: from the open scope, or malloc outside one
+ */
+void *request_arena_scratch_alloc(size_t size);
+
+/**
+ * Zeroed scratch allocation
+ */
+void *request_arena_scratch_calloc(size_t n, size_t size);
+
+/**
+ * Free scratch memory from either source
+ *
+ * Also the free function installed into jansson, so strings returned by
+ * json_dumps() must be released with it rather than free().
+ */
+void request_arena_scratch_free(void *ptr);
+
+/**
+ * Move a scratch allocation out of the open scope
+ *
+ * For values that must outlive the request scope (e.g. a span kept
+ * while the request waits on a backend). Returns a heap copy of size
+ * bytes when ptr belongs to the scope, ptr itself otherwise, NULL if
+ * the copy fails. Release the result with request_arena_scratch_free().
+ */
+void *request_arena_scratch_detach(void *ptr, size_t size);
+
+/**
+ * Route jansson allocations through the scratch functions
+ *
+ * Call once at startup, before any thread uses jansson.
+ */
+void request_arena_install_json(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* REQUEST_ARENA_H */
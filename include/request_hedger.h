@@ -0,0 +1,160 @@
+/**
+ * request_hedger.h - Hedged requests for idempotent Router calls
+ *
+ * A request submitted through the hedger goes out once. If no reply has
+ * arrived by the time the subject's observed latency percentile (p95 by
+ * default) has passed, the same request is sent a second time, which
+ * usually lands on another replica. Whichever reply comes first is
+ * handed to the caller and the other attempt is cancelled. A failed
+ * attempt defers to the other one while it is still outstanding.
+ *
+ * Thresholds come from a per-subject latency histogram of single
+ * attempts over the last minute and are refreshed once a second; a
+ * subject hedges only once it has min_samples in that window. Each
+ * request earns budget_percent hundredths of a hedge, so hedges add at
+ * most that share of extra load (plus a small burst).
+ *
+ * Only submit requests that are safe to repeat.
+ *
+ *   static int send(const char *subject, const char *request,
+ *                   request_hedger_reply_fn reply, void *closure,
+ *                   uint64_t *handle, void *arg) {
+ *       return publish_request(subject, request, reply, closure, handle);
+ *   }
+ *   static int cancel(uint64_t handle, void *arg) {
+ *       return drop_pending(handle);
+ *   }
+ *
+ *   request_hedger_t *h = request_hedger_create(&config, send, cancel, NULL);
+ *   request_hedger_submit(h, "router.get", "{...}", on_reply, ctx);
+ */
+
+#ifndef REQUEST_HEDGER_H
+#define REQUEST_HEDGER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Hedger configuration
+ */
+typedef struct {
+    int budget_percent;                  /* Hedges per 100 requests, 0: never */
+    int burst;                           /* Hedges the budget can bank */
+    double percentile;                   /* Threshold percentile, 50..99.9 */
+    int min_samples;                     /* Samples a subject needs to hedge */
+    int min_delay_us;                    /* Threshold floor */
+    int max_subjects;                    /* Subjects tracked; others unhedged */
+} request_hedger_config_t;
+
+/**
+ * Hedger statistics
+ */
+typedef struct {
+    uint64_t requests;                   /* Submitted */
+    uint64_t hedges_sent;
+    uint64_t hedges_won;                 /* Answered by the second attempt */
+    uint64_t budget_exhausted;           /* Due a hedge, but out of budget */
+    uint64_t cancelled;                  /* Losing attempts cancelled */
+    size_t in_flight;                    /* Requests not yet answered */
+} request_hedger_stats_t;
+
+/**
+ * Reply to one attempt, or to the caller for the request
+ *
+ * @param status 0 on success; reply is then NUL-terminated and only
+ *               valid during the call
+ */
+typedef void (*request_hedger_reply_fn)(int status, const char *reply, void *closure);
+
+/**
+ * Send one attempt (any thread)
+ *
+ * @param handle Set to a value cancel accepts, before reply can run
+ * @return 0 if sent: reply then runs once, from any thread, possibly
+ *         before send returns, unless the attempt is cancelled;
+ *         non-zero if not sent (reply will not run)
+ */
+typedef int (*request_hedger_send_fn)(const char *subject, const char *request,
+                                      request_hedger_reply_fn reply, void *closure,
+                                      uint64_t *handle, void *arg);
+
+/**
+ * Cancel an attempt
+ *
+ * @return 0 if it was still outstanding and its reply will now never
+ *         run, non-zero if the reply has run or is running
+ */
+typedef int (*request_hedger_cancel_fn)(uint64_t handle, void *arg);
+
+typedef struct request_hedger_t request_hedger_t;
+
+/**
+ * Fill config with defaults (5% budget, burst of 10, p95, 50 samples,
+ * 1ms floor, 32 subjects)
+ */
+void request_hedger_get_default_config(request_hedger_config_t *config);
+
+/**
+ * Apply environment overrides on top of defaults
+ *
+ * GATEWAY_HEDGE_BUDGET_PERCENT, GATEWAY_HEDGE_BURST,
+ * GATEWAY_HEDGE_PERCENTILE, GATEWAY_HEDGE_MIN_SAMPLES,
+ * GATEWAY_HEDGE_MIN_DELAY_MS
+ *
+ * @return 0 on success, -1 on error
+ */
+int request_hedger_parse_config(request_hedger_config_t *config);
+
+/**
+ * Create a hedger and start its timer thread
+ *
+ * @return Hedger on success, NULL on error
+ */
+request_hedger_t *request_hedger_create(const request_hedger_config_t *config,
+                                        request_hedger_send_fn send,
+                                        request_hedger_cancel_fn cancel, void *arg);
+
+/**
+ * Send request on subject and hedge it if it runs late (any thread)
+ *
+ * The request is copied.
+ *
+ * @return 0 if submitted: reply then runs exactly once, from any thread,
+ *         possibly before submit returns; non-zero if not (reply will
+ *         not run)
+ */
+int request_hedger_submit(request_hedger_t *h, const char *subject, const char *request,
+                          request_hedger_reply_fn reply, void *closure);
+
+/**
+ * Current hedge threshold of subject in microseconds (0: not hedging yet)
+ */
+uint64_t request_hedger_threshold_us(request_hedger_t *h, const char *subject);
+
+/**
+ * Get statistics
+ */
+void request_hedger_get_stats(request_hedger_t *h, request_hedger_stats_t *stats);
+
+/**
+ * Stop hedging: join the timer thread, so send is no longer called from
+ * it, and refuse new requests. Outstanding attempts still complete.
+ */
+void request_hedger_stop(request_hedger_t *h);
+
+/**
+ * Stop, wait until every submitted request has been answered, then free
+ * the hedger
+ */
+void request_hedger_destroy(request_hedger_t *h);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* REQUEST_HEDGER_H */
@@ -0,0 +1,95 @@
+/**
+ * route_request.h - Decide request to RouteRequest transcoding
+ *
+ * The Router takes a RouteRequest built from the client's decide body:
+ * the envelope fields (version, tenant_id, request_id, trace_id, run_id,
+ * policy_id, context) plus a "message" object gathering message_id,
+ * message_type, payload and metadata. tenant_id and trace_id come from
+ * the request context when it has them.
+ *
+ * route_request_build() tokenizes the body once with json_scan,
+ * validating the decide DTO on the way, and writes the RouteRequest
+ * straight into its output by copying the selected values' bytes. Bodies
+ * it does not handle itself go through route_request_build_dom(), the
+ * jansson parse-and-rebuild path, which stays available on its own for
+ * comparison.
+ *
+ *   route_request_overrides_t ov = { ctx->tenant_id, ctx->trace_id };
+ *   route_request_ids_t ids;
+ *   char *json;
+ *   if (route_request_build(body, len, &ov, &ids, &json, NULL) == 0) ...
+ */
+
+#ifndef ROUTE_REQUEST_H
+#define ROUTE_REQUEST_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ROUTE_REQUEST_ID_MAX 64          /* Including the terminating NUL */
+
+/**
+ * Result codes
+ */
+#define ROUTE_REQUEST_OK        0
+#define ROUTE_REQUEST_INVALID  -1        /* Body is not a valid decide request */
+#define ROUTE_REQUEST_FAILED   -2        /* Out of memory */
+
+/**
+ * Values taken from the request instead of the body
+ */
+typedef struct {
+    const char *tenant_id;           /* Replaces the body's when non-empty */
+    const char *trace_id;            /* Replaces the body's when non-empty */
+} route_request_overrides_t;
+
+/**
+ * Identifiers read from the body for the request context
+ */
+typedef struct {
+    char request_id[ROUTE_REQUEST_ID_MAX];   /* Truncated to fit */
+    char run_id[ROUTE_REQUEST_ID_MAX];
+    int has_run_id;                  /* Body carried run_id as a string */
+    char task_type[ROUTE_REQUEST_ID_MAX];    /* task.type, truncated to fit */
+    char task_version[ROUTE_REQUEST_ID_MAX]; /* task.version, "" if not a string */
+    int has_task_block;              /* task.type and task.version were
+                                        strings that fit: they name a block */
+    const char *task_payload;        /* task.payload's bytes in the body,
+                                        NULL from route_request_build_dom() */
+    size_t task_payload_len;
+} route_request_ids_t;
+
+/**
+ * Validate a decide body and build its RouteRequest in one pass
+ *
+ * A valid body has version "1", string tenant_id and request_id, and a
+ * task object with a string type and an object payload. Values are
+ * copied byte for byte, so escapes and number spellings reach the
+ * Router as the client wrote them.
+ *
+ * @param body     Decide request JSON, len bytes
+ * @param ov       Context overrides (may be NULL)
+ * @param ids      Filled on success (may be NULL)
+ * @param out      Receives the NUL-terminated RouteRequest, allocated with
+ *                 jansson's allocator: release it as json_dumps() output
+ * @param out_len  Receives its length (may be NULL)
+ * @return ROUTE_REQUEST_OK, ROUTE_REQUEST_INVALID or ROUTE_REQUEST_FAILED
+ */
+int route_request_build(const char *body, size_t len, const route_request_overrides_t *ov,
+                        route_request_ids_t *ids, char **out, size_t *out_len);
+
+/**
+ * Same contract, by parsing the body into a jansson tree and dumping a
+ * rebuilt one (ids->task_payload stays NULL: the tree is gone on return)
+ */
+int route_request_build_dom(const char *body, size_t len, const route_request_overrides_t *ov,
+                            route_request_ids_t *ids, char **out, size_t *out_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROUTE_REQUEST_H */
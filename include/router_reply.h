@@ -0,0 +1,82 @@
+/**
+ * router_reply.h - Single-pass reader for Router replies
+ *
+ * A Router reply is forwarded to the client almost always byte for byte;
+ * the gateway only needs a few fields to pick the HTTP status and log
+ * the error. router_reply_scan() validates the whole document and pulls
+ * those fields out in one pass without building a tree, and the splice
+ * helper adds the one field the error contract requires when the Router
+ * left it out, leaving every other byte as the Router wrote it.
+ *
+ *   router_reply_t r;
+ *   if (router_reply_scan(buf, len, &r) == 0 && r.http_status >= 400) ...
+ */
+
+#ifndef ROUTER_REPLY_H
+#define ROUTER_REPLY_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ROUTER_REPLY_CODE_MAX     64     /* Including the terminating NUL */
+#define ROUTER_REPLY_MESSAGE_MAX  256    /* Longer messages are truncated */
+
+/* Bytes router_reply_add_intake_null() adds at most */
+#define ROUTER_REPLY_INTAKE_NULL_EXTRA (sizeof(",\"intake_error_code\":null") - 1U)
+
+/**
+ * Fields of one reply
+ *
+ * Field lookups follow jansson's: the last of duplicate keys wins, and
+ * the error fields are only read when "error" is an object.
+ */
+typedef struct {
+    int ok_false;                    /* Top-level "ok" is the literal false */
+    int has_error;                   /* Top-level "error" is an object */
+    int has_code;                    /* error.code is a string */
+    int has_message;                 /* error.message is a string */
+    int has_intake_key;              /* error.intake_error_code present, any type */
+    int has_intake_code;             /* error.intake_error_code is a string */
+    int error_empty;                 /* The error object has no members */
+    size_t error_close;              /* Offset of the error object's '}' */
+    char code[ROUTER_REPLY_CODE_MAX];
+    char message[ROUTER_REPLY_MESSAGE_MAX];
+    char intake_error_code[ROUTER_REPLY_CODE_MAX];
+    int http_status;                 /* Mapped from error.code when ok is
+                                        false, 0 if the reply is a success
+                                        or the code is unknown */
+} router_reply_t;
+
+/**
+ * Validate a reply and extract its fields
+ *
+ * @param json  Reply bytes (need not be NUL-terminated)
+ * @return 0 if json is a well-formed JSON object, -1 otherwise (reply
+ *         is zeroed, so http_status is 0)
+ */
+int router_reply_scan(const char *json, size_t len, router_reply_t *reply);
+
+/**
+ * HTTP status for a Router error code, 0 if the code is not mapped
+ */
+int router_reply_status_for_code(const char *code);
+
+/**
+ * Copy json into out with "intake_error_code":null added as the last
+ * member of the error object
+ *
+ * @param reply     Result of scanning json (must have has_error set)
+ * @param out_size  At least len + ROUTER_REPLY_INTAKE_NULL_EXTRA + 1
+ * @return Bytes written (excluding the NUL), 0 if not applicable
+ */
+size_t router_reply_add_intake_null(const char *json, size_t len, const router_reply_t *reply,
+                                    char *out, size_t out_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROUTER_REPLY_H */
@@ -0,0 +1,95 @@
+/**
+ * schema_validator.h - Compiled JSON Schema (Draft-07 subset) validators
+ *
+ * A schema is compiled once into a flat program: one node per subschema,
+ * with property tables sorted for lookup, required properties numbered
+ * into a bitset and $ref already resolved to node indices. Checking an
+ * instance then walks the raw bytes once with json_scan, without
+ * building a tree and without looking at the schema document again.
+ *
+ * Supported keywords are those the registry has always accepted: type,
+ * properties, required, items (one schema), additionalProperties, enum,
+ * allOf/anyOf/oneOf, minimum/maximum, minLength/maxLength and $ref to
+ * any JSON pointer within the same document. format is an annotation
+ * only, as Draft-07 allows, and references to other documents are not
+ * followed (they accept anything).
+ *
+ *   char err[128];
+ *   schema_validator_t *v = schema_validator_compile(schema, err, sizeof(err));
+ *   schema_error_t why;
+ *   if (schema_validator_check(v, payload, len, &why) == SCHEMA_INVALID) ...
+ *   schema_validator_free(v);
+ */
+
+#ifndef SCHEMA_VALIDATOR_H
+#define SCHEMA_VALIDATOR_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SCHEMA_PATH_MAX  128             /* Including the terminating NUL */
+#define SCHEMA_MAX_DEPTH 64              /* Deepest schema nesting compiled */
+
+struct json_t;
+
+/**
+ * Outcome of schema_validator_check()
+ */
+typedef enum {
+    SCHEMA_VALID = 0,
+    SCHEMA_INVALID,                      /* Well-formed, but violates the schema */
+    SCHEMA_MALFORMED,                    /* Not JSON (as far as it was read) */
+    SCHEMA_FAILED                        /* Bad arguments or out of memory */
+} schema_result_t;
+
+/**
+ * Where and why an instance was rejected
+ */
+typedef struct {
+    char path[SCHEMA_PATH_MAX];          /* URI fragment JSON pointer ("#/a/0"),
+                                            percent-encoded, possibly truncated */
+    const char *reason;                  /* Static text */
+} schema_error_t;
+
+typedef struct schema_validator_t schema_validator_t;
+
+/**
+ * Compile a schema
+ *
+ * @param schema    A jansson object; it is not referenced afterwards
+ * @param err       Receives why compilation failed (may be NULL)
+ * @return Validator on success, NULL if the schema is not a valid
+ *         schema of the supported subset or memory ran out
+ */
+schema_validator_t *schema_validator_compile(const struct json_t *schema, char *err, size_t err_size);
+
+/**
+ * Check one JSON document of len bytes against a validator
+ *
+ * Checking stops at the first violation, so bytes after it are not
+ * looked at.
+ *
+ * @param error  Filled on SCHEMA_INVALID (may be NULL)
+ * @return One of schema_result_t
+ */
+schema_result_t schema_validator_check(const schema_validator_t *v, const char *json, size_t len,
+                                       schema_error_t *error);
+
+/**
+ * Number of nodes in the compiled program
+ */
+size_t schema_validator_size(const schema_validator_t *v);
+
+/**
+ * Free a validator (NULL is a no-op)
+ */
+void schema_validator_free(schema_validator_t *v);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCHEMA_VALIDATOR_H */
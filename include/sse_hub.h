@@ -0,0 +1,137 @@
+/**
+ * sse_hub.h - Server-Sent Events fan-out engine
+ *
+ * One event-loop thread owns every subscriber socket. Publishers on any
+ * thread encode an event once into a shared, reference-counted frame and
+ * hand it to the loop through a lock-free inbox; the loop appends a
+ * reference to the bounded outbound ring of each matching subscriber
+ * (looked up through a per-tenant index) and flushes rings with writev
+ * as sockets become writable. A subscriber whose ring overflows, or that
+ * makes no write progress for stall_timeout_ms, is evicted so that one
+ * slow consumer never holds up the others. Idle streams get a comment
+ * heartbeat every heartbeat_ms.
+ *
+ *   sse_hub_t *hub = sse_hub_create(&config);
+ *   sse_hub_start(hub);
+ *   sse_hub_subscribe(hub, fd, "tenant-a");           // hub owns fd now
+ *   sse_hub_publish(hub, "tenant-a", "message_created", json, json_len);
+ *   sse_hub_destroy(hub);
+ */
+
+#ifndef SSE_HUB_H
+#define SSE_HUB_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SSE_HUB_TENANT_MAX 64        /* Including the terminating NUL */
+
+/**
+ * Hub configuration
+ */
+typedef struct {
+    int max_subscribers;             /* Open streams across all tenants */
+    int queue_events;                /* Outbound ring slots per subscriber
+                                        (rounded up to a power of two) */
+    int heartbeat_ms;                /* Idle time before a ": ping" comment */
+    int stall_timeout_ms;            /* Max time with queued bytes and no progress */
+} sse_hub_config_t;
+
+/**
+ * Opaque hub handle
+ */
+typedef struct sse_hub_t sse_hub_t;
+
+/**
+ * Hub statistics
+ */
+typedef struct {
+    uint64_t subscribers;            /* Currently open streams */
+    uint64_t subscribed;             /* Streams ever accepted */
+    uint64_t refused;                /* Subscriptions refused at max_subscribers */
+    uint64_t published;              /* Events published */
+    uint64_t delivered;              /* Frames fully written to a subscriber */
+    uint64_t heartbeats;             /* Heartbeat comments queued */
+    uint64_t evicted_overflow;       /* Subscribers dropped on a full ring */
+    uint64_t evicted_stalled;        /* Subscribers dropped for no write progress */
+    uint64_t disconnected;           /* Subscribers that hung up or failed a write */
+} sse_hub_stats_t;
+
+/**
+ * Fill config with defaults (32768 subscribers, 64 queued events each,
+ * 15s heartbeat, 30s stall timeout)
+ */
+void sse_hub_get_default_config(sse_hub_config_t *config);
+
+/**
+ * Apply environment overrides on top of defaults
+ *
+ * GATEWAY_SSE_MAX_SUBSCRIBERS, GATEWAY_SSE_QUEUE_EVENTS,
+ * GATEWAY_SSE_HEARTBEAT_MS, GATEWAY_SSE_STALL_TIMEOUT_MS
+ *
+ * @return 0 on success, -1 on error
+ */
+int sse_hub_parse_config(sse_hub_config_t *config);
+
+/**
+ * Create the hub
+ *
+ * @return Hub handle on success, NULL on error
+ */
+sse_hub_t *sse_hub_create(const sse_hub_config_t *config);
+
+/**
+ * Start the event-loop thread
+ *
+ * @return 0 on success, -1 on error
+ */
+int sse_hub_start(sse_hub_t *hub);
+
+/**
+ * Hand a client socket to the hub (any thread)
+ *
+ * The stream head must already have been written. On success the hub
+ * owns fd and closes it when the subscriber goes away; on failure the
+ * caller keeps it.
+ *
+ * @param fd         Connected non-blocking socket
+ * @param tenant_id  Events published for this tenant reach the stream
+ * @return 0 on success, -1 if the hub is full, stopping, or out of memory
+ */
+int sse_hub_subscribe(sse_hub_t *hub, int fd, const char *tenant_id);
+
+/**
+ * Publish "event: <event>\ndata: <data>\n\n" (any thread, never blocks)
+ *
+ * The frame is encoded here once and shared by every recipient.
+ *
+ * @param tenant_id  Recipient tenant; NULL or "" reaches every subscriber
+ * @param data       Single-line payload (JSON), len bytes
+ * @return 0 if queued for delivery, -1 on error
+ */
+int sse_hub_publish(sse_hub_t *hub, const char *tenant_id, const char *event,
+                    const char *data, size_t len);
+
+/**
+ * Get statistics
+ *
+ * @return 0 on success, -1 on error
+ */
+int sse_hub_get_stats(const sse_hub_t *hub, sse_hub_stats_t *stats);
+
+/**
+ * Stop the loop, close every subscriber socket and free the hub
+ *
+ * Events still queued are dropped.
+ */
+void sse_hub_destroy(sse_hub_t *hub);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SSE_HUB_H */
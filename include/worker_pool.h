@@ -0,0 +1,114 @@
+/**
+ * worker_pool.h - Bounded worker pool with deadline-aware admission
+ *
+ * Producers hand tasks to a fixed set of worker threads through a
+ * bounded lock-free MPMC ring. Admission is decided twice: a task is
+ * refused outright when the ring is full, and a task whose deadline has
+ * passed by the time a worker picks it up is shed instead of run, so an
+ * overloaded server fails fast rather than serving everything late.
+ */
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Task callback
+ *
+ * @param task        Pointer passed to worker_pool_submit()
+ * @param sojourn_us  Time the task spent queued
+ * @param user_data   Opaque pointer from the pool config
+ */
+typedef void (*worker_pool_task_fn)(void *task, uint64_t sojourn_us, void *user_data);
+
+/**
+ * Pool configuration
+ */
+typedef struct {
+    int num_threads;                 /* Worker threads (0 = online CPUs) */
+    size_t queue_capacity;           /* Ring slots, rounded up to a power of two */
+    worker_pool_task_fn run;         /* Task picked up before its deadline */
+    worker_pool_task_fn shed;        /* Task whose deadline passed while queued */
+    void (*thread_init)(void *user_data); /* Optional, once per worker thread */
+    void *user_data;                 /* Passed through to the callbacks */
+} worker_pool_config_t;
+
+/**
+ * Opaque pool handle
+ */
+typedef struct worker_pool_t worker_pool_t;
+
+/**
+ * Pool statistics
+ */
+typedef struct {
+    uint64_t submitted;              /* Tasks accepted into the queue */
+    uint64_t rejected;               /* Tasks refused because the queue was full */
+    uint64_t completed;              /* Tasks run */
+    uint64_t expired;                /* Tasks shed at their deadline */
+    uint64_t depth;                  /* Tasks currently queued */
+    uint64_t sojourn_us_total;       /* Sum of queueing delays of dequeued tasks */
+} worker_pool_stats_t;
+
+/**
+ * Monotonic clock in milliseconds, the time base for deadlines
+ */
+uint64_t worker_pool_now_ms(void);
+
+/**
+ * Create the pool and start its threads
+ *
+ * Threads inherit the caller's signal mask.
+ *
+ * @param config  Pool configuration (run and shed are required)
+ * @return Pool handle on success, NULL on error
+ */
+worker_pool_t *worker_pool_create(const worker_pool_config_t *config);
+
+/**
+ * Queue a task (any thread, never blocks)
+ *
+ * @param task         Handed to run or shed exactly once
+ * @param deadline_ms  Latest worker_pool_now_ms() at which the task may
+ *                     still start
+ * @return 0 if queued, -1 if the queue is full or the pool is stopping
+ *         (neither callback will see the task)
+ */
+int worker_pool_submit(worker_pool_t *pool, void *task, uint64_t deadline_ms);
+
+/**
+ * Get the number of worker threads
+ */
+int worker_pool_get_num_threads(const worker_pool_t *pool);
+
+/**
+ * Number of tasks currently queued
+ */
+uint64_t worker_pool_depth(const worker_pool_t *pool);
+
+/**
+ * Get statistics
+ *
+ * @return 0 on success, -1 on error
+ */
+int worker_pool_get_stats(const worker_pool_t *pool, worker_pool_stats_t *stats);
+
+/**
+ * Stop the pool once the queue is empty, join the threads and free it
+ *
+ * Tasks already queued are still run (or shed). Submissions must have
+ * stopped before this is called.
+ */
+void worker_pool_destroy(worker_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORKER_POOL_H */
@@ -15,6 +15,7 @@
 #include <stdio.h>
 #include <time.h>
 #include <sys/time.h>
+#include <pthread.h>
 
 /* Simple hash table for tracking (in-memory) */
 #define MAX_TRACKING_ENTRIES 10000
@@ -31,6 +32,10 @@ static uint32_t g_active_tenants_count = 0;
 static time_t g_multi_tenant_window_start = 0;
 static uint32_t g_multi_tenant_total_requests = 0;
 
+/* Guards the tracking table and flood window; requests are tracked
+ * concurrently from every HTTP reactor thread. */
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /* Simple hash function for tenant_id */
 static uint32_t hash_tenant(const char *tenant_id) {
     uint32_t hash = 5381;
@@ -194,12 +199,12 @@ void abuse_detection_cleanup(void) {
     g_initialized = 0;
 }
 
-/* Track request for abuse detection */
-int abuse_detection_track_request(const char *tenant_id, 
-                                   const char *api_key,
-                                   const char *client_ip,
-                                   int payload_size,
-                                   rl_endpoint_id_t endpoint) {
+/* Track request for abuse detection (caller holds g_lock) */
+static int track_request_locked(const char *tenant_id,
+                                const char *api_key,
+                                const char *client_ip,
+                                int payload_size,
+                                rl_endpoint_id_t endpoint) {
     (void)endpoint; /* Not used yet */
     
     if (!g_initialized || !g_config.enabled) {
@@ -260,12 +265,24 @@ int abuse_detection_track_request(const char *tenant_id,
     return 0;
 }
 
-/* Check for abuse patterns */
-abuse_event_type_t abuse_detection_check_patterns(const char *tenant_id,
-                                                    const char *api_key,
-                                                    const char *client_ip,
-                                                    int payload_size,
-                                                    rl_endpoint_id_t endpoint) {
+/* Track request for abuse detection */
+int abuse_detection_track_request(const char *tenant_id, 
+                                   const char *api_key,
+                                   const char *client_ip,
+                                   int payload_size,
+                                   rl_endpoint_id_t endpoint) {
+    pthread_mutex_lock(&g_lock);
+    int rc = track_request_locked(tenant_id, api_key, client_ip, payload_size, endpoint);
+    pthread_mutex_unlock(&g_lock);
+    return rc;
+}
+
+/* Check for abuse patterns (caller holds g_lock) */
+static abuse_event_type_t check_patterns_locked(const char *tenant_id,
+                                                const char *api_key,
+                                                const char *client_ip,
+                                                int payload_size,
+                                                rl_endpoint_id_t endpoint) {
     (void)api_key; /* Not used in pattern detection yet */
     (void)client_ip; /* Not used in pattern detection yet */
     (void)endpoint; /* Not used in pattern detection yet */
@@ -351,6 +368,18 @@ abuse_event_type_t abuse_detection_check_patterns(const char *tenant_id,
     return ABUSE_EMPTY_PAYLOAD; /* No abuse detected */
 }
 
+/* Check for abuse patterns */
+abuse_event_type_t abuse_detection_check_patterns(const char *tenant_id,
+                                                    const char *api_key,
+                                                    const char *client_ip,
+                                                    int payload_size,
+                                                    rl_endpoint_id_t endpoint) {
+    pthread_mutex_lock(&g_lock);
+    abuse_event_type_t result = check_patterns_locked(tenant_id, api_key, client_ip, payload_size, endpoint);
+    pthread_mutex_unlock(&g_lock);
+    return result;
+}
+
 /* Block tenant for specified duration (stub implementation) */
 int abuse_detection_block_tenant(const char *tenant_id, int duration_seconds) {
     (void)tenant_id;
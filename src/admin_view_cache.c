@@ -0,0 +1,523 @@
+/**
+ * admin_view_cache.c - Background-refreshed views of Router admin replies
+ *
+ * One chained hash table under one mutex: admin traffic is light and the
+ * lock is only held to look a key up or swap a view in, never across a
+ * fetch. An entry holds its latest view, whether a fetch is running and
+ * the reads queued on its first fetch.
+ *
+ * Views are reference counted so a read can send one after the lock is
+ * dropped while a refresh replaces it. Entries are only dropped when no
+ * fetch is running on them, so a fetch handle (which is the entry) stays
+ * valid until it is published; on destroy, entries with a fetch in
+ * flight are left to that fetch, and the last one frees the cache.
+ */
+
+#define _GNU_SOURCE
+#include "admin_view_cache.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MIN_BUCKETS 64                   /* Power of two */
+#define MIN_TICK_MS 10
+
+typedef struct {
+    admin_view_t pub;                    /* First: handed out as the view */
+    atomic_size_t refs;
+    char data[];
+} view_t;
+
+typedef struct waiter {
+    admin_view_waiter_fn fn;
+    void *arg;
+    struct waiter *next;
+} waiter_t;
+
+struct admin_view_fetch_t {
+    struct admin_view_fetch_t *hnext;    /* Hash chain */
+    struct admin_view_fetch_t *due;      /* Fetches started by one tick */
+    admin_view_cache_t *cache;
+    uint64_t hash;
+    view_t *view;                        /* NULL until the first fetch lands */
+    uint64_t fetched_ms;
+    uint64_t read_ms;
+    int fetching;
+    waiter_t *waiters;                   /* FIFO */
+    waiter_t **waiters_tail;
+    size_t key_len;
+    char key[];
+};
+
+typedef struct admin_view_fetch_t entry_t;
+
+struct admin_view_cache_t {
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_t refresher;
+    int has_refresher;
+    int closing;
+    int inflight;                        /* Fetches not yet published */
+    entry_t **buckets;
+    size_t bucket_mask;
+    size_t count;
+    uint64_t refresh_ms;
+    uint64_t max_stale_ms;
+    uint64_t idle_ms;
+    size_t max_views;
+    admin_view_fetch_fn fetch;
+    void *fetch_arg;
+    admin_view_cache_stats_t stats;      /* views filled on read */
+};
+
+static uint64_t now_ms_monotonic(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000U + (uint64_t)ts.tv_nsec / 1000000U;
+}
+
+static int env_positive_int(const char *name, int def_val) {
+    const char *val = getenv(name);
+    if (val == NULL || *val == '\0') {
+        return def_val;
+    }
+    int parsed = atoi(val);
+    return parsed > 0 ? parsed : def_val;
+}
+
+static uint64_t fnv1a(uint64_t h, const void *data, size_t len) {
+    const unsigned char *p = data;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static uint64_t hash_key(const char *key, size_t len) {
+    return fnv1a(14695981039346656037ULL, key, len);
+}
+
+/* ---------------- Views and ETags ---------------- */
+
+void admin_view_etag(int status, const char *body, size_t len, char etag[ADMIN_VIEW_ETAG_MAX]) {
+    uint32_t s = (uint32_t)status;
+    uint64_t h = fnv1a(14695981039346656037ULL, &s, sizeof(s));
+    h = fnv1a(h, body, body ? len : 0U);
+    snprintf(etag, ADMIN_VIEW_ETAG_MAX, "\"%016llx\"", (unsigned long long)h);
+}
+
+int admin_view_etag_matches(const char *etag, const char *if_none_match, size_t len) {
+    if (!etag || !if_none_match) return 0;
+    size_t etag_len = strlen(etag);
+    size_t i = 0;
+    while (i < len) {
+        while (i < len && (if_none_match[i] == ' ' || if_none_match[i] == '\t' || if_none_match[i] == ',')) {
+            i++;
+        }
+        if (i >= len) break;
+        if (if_none_match[i] == '*') return 1;
+        if (len - i >= 2 && if_none_match[i] == 'W' && if_none_match[i + 1] == '/') {
+            i += 2;                          /* Weak comparison ignores W/ */
+        }
+        size_t start = i;
+        if (i < len && if_none_match[i] == '"') {
+            i++;
+            while (i < len && if_none_match[i] != '"') i++;
+            if (i < len) i++;
+        } else {
+            while (i < len && if_none_match[i] != ',') i++;
+        }
+        if (i - start == etag_len && memcmp(if_none_match + start, etag, etag_len) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static view_t *view_new(int status, const char *body, size_t len) {
+    view_t *v = malloc(sizeof(*v) + len + 1U);
+    if (!v) return NULL;
+    if (len > 0) memcpy(v->data, body, len);
+    v->data[len] = '\0';
+    v->pub.status = status;
+    v->pub.len = len;
+    v->pub.body = v->data;
+    admin_view_etag(status, body, len, v->pub.etag);
+    atomic_init(&v->refs, 1);
+    return v;
+}
+
+static const admin_view_t *view_ref(view_t *v) {
+    atomic_fetch_add_explicit(&v->refs, 1, memory_order_relaxed);
+    return &v->pub;
+}
+
+void admin_view_release(const admin_view_t *view) {
+    if (!view) return;
+    view_t *v = (view_t *)(uintptr_t)view;
+    if (atomic_fetch_sub_explicit(&v->refs, 1, memory_order_acq_rel) == 1) {
+        free(v);
+    }
+}
+
+/* ---------------- Table internals (lock held) ---------------- */
+
+static entry_t *table_find(admin_view_cache_t *c, uint64_t hash, const char *key, size_t key_len) {
+    for (entry_t *e = c->buckets[hash & c->bucket_mask]; e; e = e->hnext) {
+        if (e->hash == hash && e->key_len == key_len && memcmp(e->key, key, key_len) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/* Mark a fetch as started; the caller runs it once the lock is dropped */
+static void start_fetch(admin_view_cache_t *c, entry_t *e) {
+    e->fetching = 1;
+    c->inflight++;
+}
+
+static void entry_free(entry_t *e) {
+    if (e->view) {
+        admin_view_release(&e->view->pub);
+    }
+    free(e);
+}
+
+static void cache_free(admin_view_cache_t *c) {
+    pthread_cond_destroy(&c->wake);
+    pthread_mutex_destroy(&c->lock);
+    free(c->buckets);
+    free(c);
+}
+
+static void wake_waiters(waiter_t *w, view_t *v) {
+    while (w) {
+        waiter_t *next = w->next;
+        w->fn(v ? &v->pub : NULL, w->arg);
+        free(w);
+        w = next;
+    }
+}
+
+/* ---------------- Refresher ---------------- */
+
+void admin_view_cache_tick_at(admin_view_cache_t *c, uint64_t now_ms) {
+    if (!c) return;
+    entry_t *due = NULL;
+
+    pthread_mutex_lock(&c->lock);
+    if (c->closing) {
+        pthread_mutex_unlock(&c->lock);
+        return;
+    }
+    for (size_t b = 0; b <= c->bucket_mask; b++) {
+        entry_t **pp = &c->buckets[b];
+        while (*pp) {
+            entry_t *e = *pp;
+            if (e->fetching) {
+                pp = &e->hnext;
+            } else if (e->read_ms + c->idle_ms <= now_ms) {
+                *pp = e->hnext;              /* Nobody is looking any more */
+                c->count--;
+                entry_free(e);
+            } else {
+                if (!e->view || e->fetched_ms + c->refresh_ms <= now_ms) {
+                    start_fetch(c, e);
+                    e->due = due;
+                    due = e;
+                }
+                pp = &e->hnext;
+            }
+        }
+    }
+    pthread_mutex_unlock(&c->lock);
+
+    while (due) {
+        entry_t *next = due->due;            /* due may be published inline */
+        c->fetch(due, due->key, due->key_len, c->fetch_arg);
+        due = next;
+    }
+}
+
+static void *refresher_main(void *arg) {
+    admin_view_cache_t *c = arg;
+    uint64_t period = c->refresh_ms / 2U;
+    if (period < MIN_TICK_MS) period = MIN_TICK_MS;
+
+    pthread_mutex_lock(&c->lock);
+    while (!c->closing) {
+        pthread_mutex_unlock(&c->lock);
+        admin_view_cache_tick_at(c, now_ms_monotonic());
+        pthread_mutex_lock(&c->lock);
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += (time_t)(period / 1000U);
+        deadline.tv_nsec += (long)(period % 1000U) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        while (!c->closing && pthread_cond_timedwait(&c->wake, &c->lock, &deadline) == 0) {
+        }
+    }
+    pthread_mutex_unlock(&c->lock);
+    return NULL;
+}
+
+/* ---------------- API ---------------- */
+
+void admin_view_cache_get_default_config(admin_view_cache_config_t *config) {
+    if (!config) return;
+    config->refresh_ms = 5000;
+    config->max_stale_ms = 60000;
+    config->idle_ms = 5 * 60 * 1000;
+    config->max_views = 1024;
+    config->background = 1;
+}
+
+int admin_view_cache_parse_config(admin_view_cache_config_t *config) {
+    if (!config) return -1;
+
+    config->refresh_ms = env_positive_int("GATEWAY_ADMIN_CACHE_REFRESH_MS", config->refresh_ms);
+    config->max_stale_ms = env_positive_int("GATEWAY_ADMIN_CACHE_MAX_STALE_MS", config->max_stale_ms);
+    config->idle_ms = env_positive_int("GATEWAY_ADMIN_CACHE_IDLE_MS", config->idle_ms);
+    config->max_views = env_positive_int("GATEWAY_ADMIN_CACHE_MAX_VIEWS", config->max_views);
+    return 0;
+}
+
+admin_view_cache_t *admin_view_cache_create(const admin_view_cache_config_t *config,
+                                            admin_view_fetch_fn fetch, void *fetch_arg) {
+    admin_view_cache_config_t defaults;
+    if (!config) {
+        admin_view_cache_get_default_config(&defaults);
+        config = &defaults;
+    }
+    if (!fetch || config->refresh_ms <= 0 || config->max_stale_ms < config->refresh_ms ||
+        config->idle_ms <= 0 || config->max_views <= 0) {
+        return NULL;
+    }
+
+    admin_view_cache_t *c = calloc(1, sizeof(*c));
+    if (!c) return NULL;
+    size_t buckets = MIN_BUCKETS;
+    while (buckets < (size_t)config->max_views) {
+        buckets <<= 1;
+    }
+    c->buckets = calloc(buckets, sizeof(*c->buckets));
+    if (!c->buckets) {
+        free(c);
+        return NULL;
+    }
+    c->bucket_mask = buckets - 1U;
+    c->refresh_ms = (uint64_t)config->refresh_ms;
+    c->max_stale_ms = (uint64_t)config->max_stale_ms;
+    c->idle_ms = (uint64_t)config->idle_ms;
+    c->max_views = (size_t)config->max_views;
+    c->fetch = fetch;
+    c->fetch_arg = fetch_arg;
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&c->wake, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&c->lock, NULL);
+
+    if (config->background) {
+        if (pthread_create(&c->refresher, NULL, refresher_main, c) != 0) {
+            cache_free(c);
+            return NULL;
+        }
+        c->has_refresher = 1;
+    }
+    return c;
+}
+
+admin_view_result_t admin_view_cache_get(admin_view_cache_t *c, const char *key, size_t key_len,
+                                         admin_view_waiter_fn waiter, void *waiter_arg,
+                                         const admin_view_t **view) {
+    return admin_view_cache_get_at(c, key, key_len, waiter, waiter_arg, view, now_ms_monotonic());
+}
+
+admin_view_result_t admin_view_cache_get_at(admin_view_cache_t *c, const char *key, size_t key_len,
+                                            admin_view_waiter_fn waiter, void *waiter_arg,
+                                            const admin_view_t **view, uint64_t now_ms) {
+    if (view) *view = NULL;
+    if (!c || !key || !view) {
+        return ADMIN_VIEW_ERROR;
+    }
+
+    uint64_t hash = hash_key(key, key_len);
+    pthread_mutex_lock(&c->lock);
+    entry_t *e = table_find(c, hash, key, key_len);
+
+    if (e && e->view && now_ms < e->fetched_ms + c->max_stale_ms) {
+        e->read_ms = now_ms;
+        *view = view_ref(e->view);
+        int refetch = 0;
+        if (now_ms < e->fetched_ms + c->refresh_ms) {
+            c->stats.hits++;
+        } else {
+            /* Serve what we have; the next read sees the new one */
+            c->stats.stale_hits++;
+            if (!e->fetching) {
+                start_fetch(c, e);
+                refetch = 1;
+            }
+        }
+        pthread_mutex_unlock(&c->lock);
+        if (refetch) {
+            c->fetch(e, e->key, e->key_len, c->fetch_arg);
+        }
+        return ADMIN_VIEW_HIT;
+    }
+
+    /* Nothing servable: queue on the fetch, starting it if needed */
+    waiter_t *w = waiter ? malloc(sizeof(*w)) : NULL;
+    if (!w) {
+        pthread_mutex_unlock(&c->lock);
+        return ADMIN_VIEW_ERROR;
+    }
+    if (!e) {
+        if (c->count >= c->max_views) {
+            pthread_mutex_unlock(&c->lock);
+            free(w);
+            return ADMIN_VIEW_ERROR;
+        }
+        e = calloc(1, sizeof(*e) + key_len + 1U);
+        if (!e) {
+            pthread_mutex_unlock(&c->lock);
+            free(w);
+            return ADMIN_VIEW_ERROR;
+        }
+        memcpy(e->key, key, key_len);
+        e->key_len = key_len;
+        e->hash = hash;
+        e->cache = c;
+        e->waiters_tail = &e->waiters;
+        size_t b = hash & c->bucket_mask;
+        e->hnext = c->buckets[b];
+        c->buckets[b] = e;
+        c->count++;
+    }
+    e->read_ms = now_ms;
+    w->fn = waiter;
+    w->arg = waiter_arg;
+    w->next = NULL;
+    *e->waiters_tail = w;
+    e->waiters_tail = &w->next;
+
+    int fetch = 0;
+    if (e->fetching) {
+        c->stats.coalesced++;
+    } else {
+        c->stats.misses++;
+        start_fetch(c, e);
+        fetch = 1;
+    }
+    pthread_mutex_unlock(&c->lock);
+    if (fetch) {
+        c->fetch(e, e->key, e->key_len, c->fetch_arg);
+    }
+    return ADMIN_VIEW_WAITING;
+}
+
+void admin_view_cache_publish(admin_view_fetch_t *fetch, int status, const char *body, size_t len) {
+    admin_view_cache_publish_at(fetch, status, body, len, now_ms_monotonic());
+}
+
+void admin_view_cache_publish_at(admin_view_fetch_t *fetch, int status, const char *body, size_t len,
+                                 uint64_t now_ms) {
+    if (!fetch) return;
+    entry_t *e = fetch;
+    admin_view_cache_t *c = e->cache;
+    view_t *fresh = body ? view_new(status, body, len) : NULL;
+
+    pthread_mutex_lock(&c->lock);
+    waiter_t *w = e->waiters;
+    e->waiters = NULL;
+    e->waiters_tail = &e->waiters;
+    e->fetching = 0;
+    c->inflight--;
+
+    if (c->closing) {
+        /* Orphaned by destroy: this fetch owns the entry, and the last
+         * fetch out owns the cache */
+        int last = c->inflight == 0;
+        pthread_mutex_unlock(&c->lock);
+        entry_free(e);
+        wake_waiters(w, NULL);
+        admin_view_release(fresh ? &fresh->pub : NULL);
+        if (last) cache_free(c);
+        return;
+    }
+
+    view_t *old = NULL;
+    if (fresh) {
+        old = e->view;
+        e->view = fresh;
+        e->fetched_ms = now_ms;
+        c->stats.refreshes++;
+    } else {
+        c->stats.refresh_failures++;
+    }
+    /* Waiters get the new view, or on failure the old one if still
+     * servable */
+    view_t *answer = e->view;
+    if (answer && !fresh && e->fetched_ms + c->max_stale_ms <= now_ms) {
+        answer = NULL;
+    }
+    for (waiter_t *x = w; x && answer; x = x->next) {
+        (void)view_ref(answer);
+    }
+    pthread_mutex_unlock(&c->lock);
+
+    wake_waiters(w, answer);
+    admin_view_release(old ? &old->pub : NULL);
+}
+
+int admin_view_cache_get_stats(admin_view_cache_t *c, admin_view_cache_stats_t *stats) {
+    if (!c || !stats) return -1;
+    pthread_mutex_lock(&c->lock);
+    *stats = c->stats;
+    stats->views = c->count;
+    pthread_mutex_unlock(&c->lock);
+    return 0;
+}
+
+void admin_view_cache_destroy(admin_view_cache_t *c) {
+    if (!c) return;
+
+    pthread_mutex_lock(&c->lock);
+    c->closing = 1;
+    pthread_cond_broadcast(&c->wake);
+    pthread_mutex_unlock(&c->lock);
+    if (c->has_refresher) {
+        pthread_join(c->refresher, NULL);
+    }
+
+    pthread_mutex_lock(&c->lock);
+    for (size_t b = 0; b <= c->bucket_mask; b++) {
+        entry_t *e = c->buckets[b];
+        while (e) {
+            entry_t *next = e->hnext;
+            if (!e->fetching) {
+                entry_free(e);               /* No waiters without a fetch */
+            }
+            e = next;
+        }
+        c->buckets[b] = NULL;
+    }
+    c->count = 0;
+    int last = c->inflight == 0;
+    pthread_mutex_unlock(&c->lock);
+    if (last) {
+        cache_free(c);
+    }
+}
@@ -27,6 +27,7 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <stdint.h>
+#include <pthread.h>
 
 /* Note: For CP2, we use a simple approach: read from Router metrics via HTTP
  * For production, consider using NATS pub/sub or gRPC health check
@@ -36,12 +37,16 @@
  * TODO (CP3/Release): Replace with proper HTTP client library or gRPC
  */
 
-/* Simple cache for backpressure status */
-static backpressure_status_t g_cached_status = BACKPRESSURE_INACTIVE;
-static time_t g_last_check = 0;
+/* Simple cache for backpressure status (read lock-free by every reactor thread) */
+static _Atomic backpressure_status_t g_cached_status = BACKPRESSURE_INACTIVE;
+static _Atomic time_t g_last_check = 0;
 static backpressure_client_config_t g_config = {0};
 static int g_initialized = 0;
 
+/* Serializes cache refreshes: one reactor thread polls the Router while
+ * the others keep answering from the cached status. */
+static pthread_mutex_t g_refresh_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /* Simple HTTP client (socket-based, no curl dependency) */
 static int http_get(const char *url, char *response_buf, size_t response_size) {
     /* Parse URL (simplified: http://host:port/path) */
@@ -280,10 +285,22 @@ backpressure_status_t backpressure_client_check_router_status(void) {
     }
     
     time_t now = time(NULL);
-    time_t elapsed = now - g_last_check;
+    time_t last = g_last_check;
     
     /* Check cache first */
-    if (elapsed < g_config.check_interval_seconds && g_last_check > 0) {
+    if (last > 0 && now - last < g_config.check_interval_seconds) {
+        return g_cached_status;
+    }
+    
+    /* Another thread is already refreshing: serve the cached value */
+    if (pthread_mutex_trylock(&g_refresh_lock) != 0) {
+        return g_cached_status;
+    }
+    
+    /* A refresh may have completed between the check and the lock */
+    last = g_last_check;
+    if (last > 0 && now - last < g_config.check_interval_seconds) {
+        pthread_mutex_unlock(&g_refresh_lock);
         return g_cached_status;
     }
     
@@ -293,6 +310,7 @@ backpressure_status_t backpressure_client_check_router_status(void) {
     /* Update cache */
     g_cached_status = status;
     g_last_check = now;
+    pthread_mutex_unlock(&g_refresh_lock);
     
     return status;
 }
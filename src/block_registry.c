@@ -0,0 +1,665 @@
+/**
+ * block_registry.c - Extension block registry store
+ *
+ * The index is a power-of-two array of bucket chains. Chain nodes hold an
+ * atomic pointer to an immutable record, so replacing a manifest is one
+ * pointer store, inserting links a node in at a bucket head and deleting
+ * unlinks it; growing the index builds a new table beside the old one
+ * and publishes it with one store. Writers hold write_lock; readers only
+ * load pointers.
+ *
+ * Whatever a writer unlinks is retired, stamped with the epoch the write
+ * closed, and freed once no reader is still inside that epoch. Reader
+ * epochs live in a process-wide array of slots, one per thread, claimed
+ * on a thread's first lookup and given back when it exits. A thread that
+ * finds every slot taken looks up under write_lock instead.
+ */
+
+#define _GNU_SOURCE
+#include "block_registry.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define MIN_BUCKETS      64              /* Power of two */
+#define READER_SLOTS     256
+
+#define SNAPSHOT_MAGIC   "GWBLKREG"
+#define SNAPSHOT_VERSION 1U
+
+typedef struct {
+    block_record_t pub;                  /* First: handed out as the record */
+    atomic_size_t refs;
+    uint64_t hash;
+    block_registry_detach_fn detach;     /* For pub.attachment */
+    char data[];                         /* type, version, manifest, each NUL-terminated */
+} record_t;
+
+typedef struct node {
+    _Atomic(struct node *) next;
+    _Atomic(record_t *) rec;
+} node_t;
+
+typedef struct {
+    size_t mask;
+    _Atomic(node_t *) buckets[];
+} table_t;
+
+typedef enum {
+    RETIRED_RECORD,
+    RETIRED_NODE,
+    RETIRED_TABLE
+} retired_kind_t;
+
+typedef struct retired {
+    struct retired *next;
+    uint64_t epoch;
+    retired_kind_t kind;
+    void *ptr;
+} retired_t;
+
+struct block_registry_t {
+    _Atomic(table_t *) table;
+    pthread_mutex_t write_lock;
+    size_t count;                        /* Below: write_lock held */
+    size_t bytes;
+    retired_t *retired;
+    size_t num_retired;
+    block_registry_attach_fn attach;
+    block_registry_detach_fn detach;
+    void *hook_arg;
+};
+
+/* Snapshot layout, host byte order; records follow the header, each
+ * padded to 8 bytes */
+typedef struct {
+    char magic[8];
+    uint32_t format;
+    uint32_t reserved;
+    uint64_t count;
+    uint64_t size;                       /* Whole file */
+} snapshot_header_t;
+
+typedef struct {
+    uint32_t type_len;
+    uint32_t version_len;
+    uint32_t manifest_len;
+    uint32_t reserved;
+} snapshot_record_t;
+
+/* ---------------- Reader epochs ---------------- */
+
+typedef struct {
+    _Atomic uint64_t epoch;              /* 0 outside a lookup */
+    atomic_int used;
+} __attribute__((aligned(64))) reader_slot_t;
+
+static reader_slot_t g_slots[READER_SLOTS];
+static _Atomic uint64_t g_epoch = 1;
+static _Thread_local int tls_slot = -1;
+static pthread_key_t g_slot_key;
+static pthread_once_t g_slot_once = PTHREAD_ONCE_INIT;
+
+static void slot_release(void *value) {
+    int slot = (int)(intptr_t)value - 1;
+    atomic_store(&g_slots[slot].epoch, 0);
+    atomic_store(&g_slots[slot].used, 0);
+}
+
+static void slot_key_init(void) {
+    (void)pthread_key_create(&g_slot_key, slot_release);
+}
+
+/* This thread's slot, -1 if all are taken */
+static int reader_slot(void) {
+    if (tls_slot >= 0) return tls_slot;
+    pthread_once(&g_slot_once, slot_key_init);
+    for (int i = 0; i < READER_SLOTS; i++) {
+        int expected = 0;
+        if (atomic_load_explicit(&g_slots[i].used, memory_order_relaxed) == 0 &&
+            atomic_compare_exchange_strong(&g_slots[i].used, &expected, 1)) {
+            tls_slot = i;
+            (void)pthread_setspecific(g_slot_key, (void *)(intptr_t)(i + 1));
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Oldest epoch a reader is still in, UINT64_MAX if none */
+static uint64_t oldest_reader_epoch(void) {
+    uint64_t oldest = UINT64_MAX;
+    for (int i = 0; i < READER_SLOTS; i++) {
+        uint64_t e = atomic_load(&g_slots[i].epoch);
+        if (e != 0 && e < oldest) oldest = e;
+    }
+    return oldest;
+}
+
+/* ---------------- Records ---------------- */
+
+static uint64_t fnv1a(const void *data, size_t len) {
+    uint64_t h = 14695981039346656037ULL;
+    const unsigned char *p = data;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static uint64_t hash_key(const char *type, size_t type_len, const char *version, size_t version_len) {
+    uint64_t h = fnv1a(type, type_len);
+    h ^= fnv1a(version, version_len) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    return h;
+}
+
+static record_t *record_new(const block_registry_item_t *item) {
+    size_t size = sizeof(record_t) + item->type_len + item->version_len + item->manifest_len + 3U;
+    record_t *r = malloc(size);
+    if (!r) return NULL;
+    char *p = r->data;
+    memcpy(p, item->type, item->type_len);
+    p[item->type_len] = '\0';
+    r->pub.type = p;
+    p += item->type_len + 1U;
+    memcpy(p, item->version, item->version_len);
+    p[item->version_len] = '\0';
+    r->pub.version = p;
+    p += item->version_len + 1U;
+    if (item->manifest_len > 0) memcpy(p, item->manifest, item->manifest_len);
+    p[item->manifest_len] = '\0';
+    r->pub.manifest = p;
+    r->pub.type_len = item->type_len;
+    r->pub.version_len = item->version_len;
+    r->pub.manifest_len = item->manifest_len;
+    snprintf(r->pub.etag, sizeof(r->pub.etag), "\"%016llx\"",
+             (unsigned long long)fnv1a(item->manifest, item->manifest_len));
+    r->pub.attachment = NULL;
+    r->hash = hash_key(item->type, item->type_len, item->version, item->version_len);
+    r->detach = NULL;
+    atomic_init(&r->refs, 1);            /* The registry's */
+    return r;
+}
+
+static void record_free(record_t *r) {
+    if (!r) return;
+    if (r->detach && r->pub.attachment) r->detach((void *)(uintptr_t)r->pub.attachment);
+    free(r);
+}
+
+static size_t record_bytes(const record_t *r) {
+    return r->pub.type_len + r->pub.version_len + r->pub.manifest_len;
+}
+
+static int record_matches(const record_t *r, uint64_t hash, const char *type, size_t type_len,
+                          const char *version, size_t version_len) {
+    return r->hash == hash && r->pub.type_len == type_len && r->pub.version_len == version_len &&
+           memcmp(r->pub.type, type, type_len) == 0 && memcmp(r->pub.version, version, version_len) == 0;
+}
+
+void block_record_release(const block_record_t *rec) {
+    if (!rec) return;
+    record_t *r = (record_t *)(uintptr_t)rec;
+    if (atomic_fetch_sub_explicit(&r->refs, 1, memory_order_acq_rel) == 1) {
+        record_free(r);
+    }
+}
+
+/* ---------------- Tables ---------------- */
+
+static table_t *table_new(size_t buckets) {
+    table_t *t = calloc(1, sizeof(*t) + buckets * sizeof(t->buckets[0]));
+    if (!t) return NULL;
+    t->mask = buckets - 1U;
+    return t;
+}
+
+static node_t *table_find(table_t *t, uint64_t hash, const char *type, size_t type_len,
+                          const char *version, size_t version_len) {
+    for (node_t *n = atomic_load(&t->buckets[hash & t->mask]); n; n = atomic_load(&n->next)) {
+        if (record_matches(atomic_load(&n->rec), hash, type, type_len, version, version_len)) {
+            return n;
+        }
+    }
+    return NULL;
+}
+
+static void table_link(table_t *t, node_t *n, record_t *r) {
+    _Atomic(node_t *) *head = &t->buckets[r->hash & t->mask];
+    atomic_store_explicit(&n->rec, r, memory_order_relaxed);
+    atomic_store_explicit(&n->next, atomic_load_explicit(head, memory_order_relaxed), memory_order_relaxed);
+    atomic_store(head, n);               /* Publishes the node and its record */
+}
+
+/* ---------------- Writers (write_lock held) ---------------- */
+
+static int retire(retired_t **list, retired_kind_t kind, void *ptr) {
+    retired_t *r = malloc(sizeof(*r));
+    if (!r) return -1;
+    r->kind = kind;
+    r->ptr = ptr;
+    r->next = *list;
+    *list = r;
+    return 0;
+}
+
+static void retired_free(retired_t *r) {
+    switch (r->kind) {
+        case RETIRED_RECORD: block_record_release(&((record_t *)r->ptr)->pub); break;
+        case RETIRED_NODE:
+        case RETIRED_TABLE:  free(r->ptr); break;
+    }
+    free(r);
+}
+
+/* Close the write's epoch, queue what it unlinked and free whatever no
+ * reader can still see */
+static void retire_commit(block_registry_t *reg, retired_t *list) {
+    uint64_t epoch = atomic_fetch_add(&g_epoch, 1);
+    while (list) {
+        retired_t *next = list->next;
+        list->epoch = epoch;
+        list->next = reg->retired;
+        reg->retired = list;
+        reg->num_retired++;
+        list = next;
+    }
+
+    uint64_t oldest = oldest_reader_epoch();
+    retired_t **pp = &reg->retired;
+    while (*pp) {
+        retired_t *r = *pp;
+        if (r->epoch < oldest) {
+            *pp = r->next;
+            reg->num_retired--;
+            retired_free(r);
+        } else {
+            pp = &r->next;
+        }
+    }
+}
+
+static void retired_list_free(retired_t *list) {
+    while (list) {
+        retired_t *next = list->next;
+        free(list);
+        list = next;
+    }
+}
+
+/* ---------------- API ---------------- */
+
+block_registry_t *block_registry_create(void) {
+    block_registry_t *reg = calloc(1, sizeof(*reg));
+    if (!reg) return NULL;
+    table_t *t = table_new(MIN_BUCKETS);
+    if (!t) {
+        free(reg);
+        return NULL;
+    }
+    atomic_init(&reg->table, t);
+    pthread_mutex_init(&reg->write_lock, NULL);
+    return reg;
+}
+
+void block_registry_set_hooks(block_registry_t *reg, block_registry_attach_fn attach,
+                              block_registry_detach_fn detach, void *arg) {
+    if (!reg) return;
+    pthread_mutex_lock(&reg->write_lock);
+    reg->attach = attach;
+    reg->detach = detach;
+    reg->hook_arg = arg;
+    pthread_mutex_unlock(&reg->write_lock);
+}
+
+const block_record_t *block_registry_get(block_registry_t *reg, const char *type, size_t type_len,
+                                         const char *version, size_t version_len) {
+    if (!reg || !type || !version) return NULL;
+    uint64_t hash = hash_key(type, type_len, version, version_len);
+
+    int slot = reader_slot();
+    if (slot >= 0) {
+        atomic_store(&g_slots[slot].epoch, atomic_load(&g_epoch));
+    } else {
+        pthread_mutex_lock(&reg->write_lock);
+    }
+
+    record_t *found = NULL;
+    node_t *n = table_find(atomic_load(&reg->table), hash, type, type_len, version, version_len);
+    if (n) {
+        found = atomic_load(&n->rec);
+        atomic_fetch_add_explicit(&found->refs, 1, memory_order_relaxed);
+    }
+
+    if (slot >= 0) {
+        atomic_store(&g_slots[slot].epoch, 0);
+    } else {
+        pthread_mutex_unlock(&reg->write_lock);
+    }
+    return found ? &found->pub : NULL;
+}
+
+int block_registry_upsert(block_registry_t *reg, const char *type, size_t type_len,
+                          const char *version, size_t version_len,
+                          const char *manifest, size_t manifest_len, int *created) {
+    block_registry_item_t item = { type, type_len, version, version_len, manifest, manifest_len, NULL };
+    return block_registry_upsert_batch(reg, &item, 1, created);
+}
+
+/* Free the attachments of items from..count that no record took */
+static void items_detach(block_registry_t *reg, const block_registry_item_t *items, size_t from, size_t count) {
+    for (size_t i = from; reg->detach && i < count; i++) {
+        if (items[i].attachment) reg->detach(items[i].attachment);
+    }
+}
+
+int block_registry_upsert_batch(block_registry_t *reg, const block_registry_item_t *items, size_t count,
+                                int *created) {
+    if (!reg || (!items && count > 0)) return -1;
+    for (size_t i = 0; i < count; i++) {
+        const block_registry_item_t *it = &items[i];
+        if (!it->type || !it->version || (!it->manifest && it->manifest_len > 0) ||
+            it->type_len == 0 || it->type_len > BLOCK_REGISTRY_KEY_MAX ||
+            it->version_len == 0 || it->version_len > BLOCK_REGISTRY_KEY_MAX) {
+            items_detach(reg, items, 0, count);
+            return -1;
+        }
+    }
+    if (count == 0) return 0;
+
+    /* Allocate everything up front so a failure leaves the registry as it was */
+    record_t **recs = calloc(count, sizeof(*recs));
+    node_t **nodes = calloc(count, sizeof(*nodes));
+    int ok = recs != NULL && nodes != NULL;
+    size_t taken = 0;                    /* Items whose attachment a record holds */
+    for (size_t i = 0; ok && i < count; i++) {
+        recs[i] = record_new(&items[i]);
+        nodes[i] = calloc(1, sizeof(node_t));
+        ok = recs[i] != NULL && nodes[i] != NULL;
+        if (recs[i]) {
+            recs[i]->detach = reg->detach;
+            recs[i]->pub.attachment = items[i].attachment;
+            if (!items[i].attachment && reg->attach) {
+                recs[i]->pub.attachment = reg->attach(&recs[i]->pub, reg->hook_arg);
+            }
+            taken = i + 1U;
+        }
+    }
+
+    retired_t *dead = NULL;
+    pthread_mutex_lock(&reg->write_lock);
+    table_t *old = atomic_load(&reg->table);
+    table_t *t = old;
+
+    /* Grow to keep chains short: a new table with fresh nodes for every
+     * current record, filled before anyone can see it */
+    size_t buckets = old->mask + 1U;
+    if (ok && reg->count + count > buckets) {
+        while (buckets < (reg->count + count) * 2U) buckets <<= 1;
+        t = table_new(buckets);
+        ok = t != NULL;
+        for (size_t b = 0; ok && b <= old->mask; b++) {
+            for (node_t *n = atomic_load(&old->buckets[b]); ok && n; n = atomic_load(&n->next)) {
+                node_t *copy = calloc(1, sizeof(*copy));
+                ok = copy != NULL && retire(&dead, RETIRED_NODE, n) == 0;
+                if (copy) table_link(t, copy, atomic_load(&n->rec));
+            }
+        }
+        ok = ok && retire(&dead, RETIRED_TABLE, old) == 0;
+    }
+    /* At most one retirement per item: its replaced record */
+    retired_t *spare = NULL;
+    for (size_t i = 0; ok && i < count; i++) {
+        ok = retire(&spare, RETIRED_RECORD, NULL) == 0;
+    }
+
+    if (!ok) {
+        pthread_mutex_unlock(&reg->write_lock);
+        if (t && t != old) {
+            for (size_t b = 0; b <= t->mask; b++) {
+                node_t *n = atomic_load(&t->buckets[b]);
+                while (n) {
+                    node_t *next = atomic_load(&n->next);
+                    free(n);
+                    n = next;
+                }
+            }
+            free(t);
+        }
+        retired_list_free(dead);
+        retired_list_free(spare);
+        for (size_t i = 0; recs && nodes && i < count; i++) {
+            record_free(recs[i]);
+            free(nodes[i]);
+        }
+        items_detach(reg, items, taken, count);
+        free(recs);
+        free(nodes);
+        return -1;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        record_t *r = recs[i];
+        node_t *n = table_find(t, r->hash, r->pub.type, r->pub.type_len, r->pub.version, r->pub.version_len);
+        if (n) {
+            record_t *prev = atomic_load(&n->rec);
+            atomic_store(&n->rec, r);
+            reg->bytes -= record_bytes(prev);
+            retired_t *x = spare;
+            spare = x->next;
+            x->ptr = prev;
+            x->next = dead;
+            dead = x;
+            free(nodes[i]);
+            if (created) created[i] = 0;
+        } else {
+            table_link(t, nodes[i], r);
+            reg->count++;
+            if (created) created[i] = 1;
+        }
+        reg->bytes += record_bytes(r);
+    }
+    if (t != old) {
+        atomic_store(&reg->table, t);
+    }
+    retire_commit(reg, dead);
+    pthread_mutex_unlock(&reg->write_lock);
+
+    retired_list_free(spare);
+    free(recs);
+    free(nodes);
+    return 0;
+}
+
+int block_registry_delete(block_registry_t *reg, const char *type, size_t type_len,
+                          const char *version, size_t version_len) {
+    if (!reg || !type || !version) return -1;
+    uint64_t hash = hash_key(type, type_len, version, version_len);
+
+    pthread_mutex_lock(&reg->write_lock);
+    table_t *t = atomic_load(&reg->table);
+    _Atomic(node_t *) *link = &t->buckets[hash & t->mask];
+    node_t *n = atomic_load(link);
+    while (n && !record_matches(atomic_load(&n->rec), hash, type, type_len, version, version_len)) {
+        link = &n->next;
+        n = atomic_load(link);
+    }
+    retired_t *dead = NULL;
+    if (!n || retire(&dead, RETIRED_NODE, n) != 0) {
+        pthread_mutex_unlock(&reg->write_lock);
+        return -1;
+    }
+    record_t *r = atomic_load(&n->rec);
+    if (retire(&dead, RETIRED_RECORD, r) != 0) {
+        pthread_mutex_unlock(&reg->write_lock);
+        retired_list_free(dead);
+        return -1;
+    }
+    /* Readers already on n still find their way down the chain */
+    atomic_store(link, atomic_load(&n->next));
+    reg->count--;
+    reg->bytes -= record_bytes(r);
+    retire_commit(reg, dead);
+    pthread_mutex_unlock(&reg->write_lock);
+    return 0;
+}
+
+int block_registry_save_snapshot(block_registry_t *reg, const char *path) {
+    if (!reg || !path) return -1;
+    char tmp[4096];
+    int n = snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    if (n < 0 || (size_t)n >= sizeof(tmp)) return -1;
+
+    pthread_mutex_lock(&reg->write_lock);
+    FILE *f = fopen(tmp, "wb");
+    if (!f) {
+        pthread_mutex_unlock(&reg->write_lock);
+        return -1;
+    }
+    table_t *t = atomic_load(&reg->table);
+    static const char pad[8] = { 0 };
+
+    snapshot_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.format = SNAPSHOT_VERSION;
+    header.count = reg->count;
+    header.size = sizeof(header);
+    for (size_t b = 0; b <= t->mask; b++) {
+        for (node_t *nd = atomic_load(&t->buckets[b]); nd; nd = atomic_load(&nd->next)) {
+            size_t payload = record_bytes(atomic_load(&nd->rec)) + 3U;
+            header.size += sizeof(snapshot_record_t) + ((payload + 7U) & ~(size_t)7U);
+        }
+    }
+
+    int ok = fwrite(&header, sizeof(header), 1, f) == 1;
+    for (size_t b = 0; ok && b <= t->mask; b++) {
+        for (node_t *nd = atomic_load(&t->buckets[b]); ok && nd; nd = atomic_load(&nd->next)) {
+            const block_record_t *r = &atomic_load(&nd->rec)->pub;
+            if (r->manifest_len > UINT32_MAX) {
+                ok = 0;
+                break;
+            }
+            snapshot_record_t sr = { (uint32_t)r->type_len, (uint32_t)r->version_len,
+                                     (uint32_t)r->manifest_len, 0 };
+            size_t payload = r->type_len + r->version_len + r->manifest_len + 3U;
+            /* The three strings are stored back to back with their NULs */
+            ok = fwrite(&sr, sizeof(sr), 1, f) == 1 &&
+                 fwrite(r->type, 1, payload, f) == payload &&
+                 fwrite(pad, 1, ((payload + 7U) & ~(size_t)7U) - payload, f) ==
+                     ((payload + 7U) & ~(size_t)7U) - payload;
+        }
+    }
+    ok = ok && fflush(f) == 0 && fsync(fileno(f)) == 0;
+    ok = fclose(f) == 0 && ok;
+    ok = ok && rename(tmp, path) == 0;
+    if (!ok) {
+        (void)unlink(tmp);
+    }
+    pthread_mutex_unlock(&reg->write_lock);
+    return ok ? 0 : -1;
+}
+
+int block_registry_load_snapshot(block_registry_t *reg, const char *path, size_t *loaded) {
+    if (loaded) *loaded = 0;
+    if (!reg || !path) return -1;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return errno == ENOENT ? 0 : -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(snapshot_header_t)) {
+        close(fd);
+        return -1;
+    }
+    size_t size = (size_t)st.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+
+    const char *base = map;
+    const snapshot_header_t *header = map;
+    int rc = -1;
+    block_registry_item_t *items = NULL;
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 ||
+        header->format != SNAPSHOT_VERSION || header->size != size ||
+        header->count > size / sizeof(snapshot_record_t)) {
+        goto out;
+    }
+    items = calloc(header->count ? (size_t)header->count : 1U, sizeof(*items));
+    if (!items) goto out;
+
+    size_t off = sizeof(*header);
+    for (uint64_t i = 0; i < header->count; i++) {
+        if (size - off < sizeof(snapshot_record_t)) goto out;
+        const snapshot_record_t *sr = (const snapshot_record_t *)(const void *)(base + off);
+        size_t payload = (size_t)sr->type_len + sr->version_len + sr->manifest_len + 3U;
+        size_t padded = (payload + 7U) & ~(size_t)7U;
+        off += sizeof(*sr);
+        if (size - off < padded) goto out;
+        const char *p = base + off;
+        if (p[sr->type_len] != '\0' || p[sr->type_len + 1U + sr->version_len] != '\0' ||
+            p[payload - 1U] != '\0') {
+            goto out;
+        }
+        items[i].type = p;
+        items[i].type_len = sr->type_len;
+        items[i].version = p + sr->type_len + 1U;
+        items[i].version_len = sr->version_len;
+        items[i].manifest = p + sr->type_len + sr->version_len + 2U;
+        items[i].manifest_len = sr->manifest_len;
+        off += padded;
+    }
+    if (off != size) goto out;
+    if (block_registry_upsert_batch(reg, items, (size_t)header->count, NULL) != 0) goto out;
+    if (loaded) *loaded = (size_t)header->count;
+    rc = 0;
+
+out:
+    free(items);
+    munmap(map, size);
+    return rc;
+}
+
+int block_registry_get_stats(block_registry_t *reg, block_registry_stats_t *stats) {
+    if (!reg || !stats) return -1;
+    pthread_mutex_lock(&reg->write_lock);
+    stats->entries = reg->count;
+    stats->bytes = reg->bytes;
+    stats->buckets = atomic_load(&reg->table)->mask + 1U;
+    stats->retired = reg->num_retired;
+    pthread_mutex_unlock(&reg->write_lock);
+    return 0;
+}
+
+void block_registry_destroy(block_registry_t *reg) {
+    if (!reg) return;
+    /* Retired objects are no longer reachable from the table */
+    while (reg->retired) {
+        retired_t *next = reg->retired->next;
+        retired_free(reg->retired);
+        reg->retired = next;
+    }
+    table_t *t = atomic_load(&reg->table);
+    for (size_t b = 0; b <= t->mask; b++) {
+        node_t *n = atomic_load(&t->buckets[b]);
+        while (n) {
+            node_t *next = atomic_load(&n->next);
+            block_record_release(&atomic_load(&n->rec)->pub);
+            free(n);
+            n = next;
+        }
+    }
+    free(t);
+    pthread_mutex_destroy(&reg->write_lock);
+    free(reg);
+}
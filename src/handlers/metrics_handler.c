@@ -1,57 +1,46 @@
 #include "metrics_handler.h"
 #include "../metrics/prometheus.h"
 
+#include "http_response.h"
+
+#include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <unistd.h>
 
-// Buffer for metrics export (512KB should be enough)
+// Buffer for metrics export (512KB should be enough); allocated per scrape
+// because concurrent scrapes run on different reactor threads
 #define METRICS_BUFFER_SIZE (512 * 1024)
-static char metrics_buffer[METRICS_BUFFER_SIZE];
 
 /**
  * Handle GET /metrics request
  * Returns Prometheus text format metrics
  */
-int handle_metrics_request(int client_fd) {
+int handle_metrics_request(int client_fd, int keep_alive) {
+    char *metrics_buffer = malloc(METRICS_BUFFER_SIZE);
+    int bytes_written = -1;
+
     // Export metrics to text format
-    int bytes_written = prometheus_export_text(metrics_buffer, METRICS_BUFFER_SIZE);
+    if (metrics_buffer != NULL) {
+        bytes_written = prometheus_export_text(metrics_buffer, METRICS_BUFFER_SIZE);
+    }
     
+    http_response_t resp;
     if (bytes_written < 0) {
+        free(metrics_buffer);
         // Export failed
-        const char *error_response =
-            "HTTP/1.1 500 Internal Server Error\r\n"
-            "Content-Type: text/plain\r\n"
-            "Content-Length: 35\r\n"
-            "\r\n"
-            "Internal Server Error: metrics export failed\n";
-        (void)write(client_fd, error_response, strlen(error_response));
+        static const char error_body[] = "Internal Server Error: metrics export failed\n";
+        http_response_init(&resp, "HTTP/1.1 500 Internal Server Error");
+        http_response_add_raw(&resp, HTTP_RESPONSE_CONTENT_TYPE_TEXT);
+        (void)http_response_send(&resp, client_fd, keep_alive, error_body, sizeof(error_body) - 1U);
         return -1;
     }
     
-    // Success - return metrics
-    char headers[512];
-    int header_len = snprintf(headers, sizeof(headers),
-        "HTTP/1.1 200 OK\r\n"
-        "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
-        "Content-Length: %d\r\n"
-        "\r\n",
-        bytes_written);
+    // Success - headers and metrics body in one write
+    http_response_init(&resp, "HTTP/1.1 200 OK");
+    http_response_add_raw(&resp, "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n");
+    int rc = http_response_send(&resp, client_fd, keep_alive, metrics_buffer, (size_t)bytes_written);
     
-    if (header_len < 0 || (size_t)header_len >= sizeof(headers)) {
-        return -1;
-    }
-    
-    // Send headers
-    if (write(client_fd, headers, (size_t)header_len) < 0) {
-        return -1;
-    }
-    
-    // Send metrics body
-    if (write(client_fd, metrics_buffer, (size_t)bytes_written) < 0) {
-        return -1;
-    }
-    
-    return 0;
+    free(metrics_buffer);
+    return rc;
 }
-
@@ -5,9 +5,10 @@
  * Handle GET /metrics request
  * Returns Prometheus text format metrics
  * @param client_fd Client socket file descriptor
- * @return 0 on success, -1 on error
+ * @param keep_alive Non-zero if the connection stays open after the response
+ * @return 0 on success, -1 on error (the caller should close the connection)
  */
-int handle_metrics_request(int client_fd);
+int handle_metrics_request(int client_fd, int keep_alive);
 
 #endif // METRICS_HANDLER_H
 
@@ -0,0 +1,245 @@
+/**
+ * http_parser.c - Incremental zero-copy HTTP/1.x request head parser
+ *
+ * The head is consumed line by line. A line ends at CRLF; a bare CR or
+ * LF is rejected, as is a header line without a colon or with
+ * whitespace before it, so the head is read the same way by every hop
+ * that forwards it. Framing headers (Content-Length, Transfer-Encoding,
+ * Connection) are interpreted as soon as their line completes.
+ */
+
+#include "http_parser.h"
+#include <string.h>
+#include <strings.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+size_t http_parser_scan(const char *p, size_t len, int want_colon) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    /* Without a colon to look for, the third compare repeats CR */
+    const __m128i colon = _mm_set1_epi8(want_colon ? ':' : '\r');
+    for (; i + 16U <= len; i += 16U) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(const void *)(p + i));
+        __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, lf)),
+                                   _mm_cmpeq_epi8(v, colon));
+        int mask = _mm_movemask_epi8(hit);
+        if (mask != 0) {
+            return i + (size_t)__builtin_ctz((unsigned int)mask);
+        }
+    }
+#endif
+    for (; i < len; i++) {
+        char c = p[i];
+        if (c == '\r' || c == '\n' || (want_colon && c == ':')) {
+            return i;
+        }
+    }
+    return len;
+}
+
+void http_parser_init(http_parser_t *parser) {
+    memset(parser, 0, sizeof(*parser));
+}
+
+static int span_equals_ci(const char *buf, http_span_t span, const char *name) {
+    size_t n = strlen(name);
+    return span.len == n && strncasecmp(buf + span.off, name, n) == 0;
+}
+
+/**
+ * Case-insensitive search for a comma-separated token in a header value
+ */
+static int value_has_token(const char *v, const char *end, const char *token) {
+    size_t tlen = strlen(token);
+    while (v < end) {
+        while (v < end && (*v == ' ' || *v == '\t' || *v == ',')) {
+            v++;
+        }
+        const char *t = v;
+        while (v < end && *v != ',') {
+            v++;
+        }
+        const char *te = v;
+        while (te > t && (te[-1] == ' ' || te[-1] == '\t')) {
+            te--;
+        }
+        if ((size_t)(te - t) == tlen && strncasecmp(t, token, tlen) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Content-Length must be a bare decimal; repeats are tolerated only when
+ * every copy carries the same value (RFC 9112 section 6.3).
+ */
+static http_parse_status_t apply_content_length(http_parser_t *parser, const char *v, size_t len) {
+    if (len == 0) {
+        return HTTP_PARSE_ERROR;
+    }
+    size_t value = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (v[i] < '0' || v[i] > '9') {
+            return HTTP_PARSE_ERROR;
+        }
+        if (value > (SIZE_MAX - 9U) / 10U) {
+            return HTTP_PARSE_ERROR;
+        }
+        value = value * 10U + (size_t)(v[i] - '0');
+    }
+    if (parser->seen_length && value != parser->head.content_length) {
+        return HTTP_PARSE_ERROR;
+    }
+    parser->seen_length = 1;
+    parser->head.content_length = value;
+    return HTTP_PARSE_INCOMPLETE;
+}
+
+/**
+ * Record method, target and version from the line [start, end)
+ */
+static void parse_request_line(http_request_head_t *head, const char *buf,
+                               uint32_t start, uint32_t end) {
+    const char *line = buf + start;
+    size_t len = end - start;
+
+    const char *sp1 = memchr(line, ' ', len);
+    if (sp1 == NULL) {
+        return;
+    }
+    head->method.off = start;
+    head->method.len = (uint32_t)(sp1 - line);
+
+    const char *target = sp1 + 1;
+    const char *sp2 = memchr(target, ' ', len - (size_t)(target - line));
+    if (sp2 != NULL) {
+        head->target.off = (uint32_t)(target - buf);
+        head->target.len = (uint32_t)(sp2 - target);
+    }
+
+    head->http11 = len >= 8U && memcmp(line + len - 8U, "HTTP/1.1", 8) == 0;
+    head->keep_alive = head->http11;
+}
+
+/**
+ * Record the header line [start, end) whose colon is at `colon`
+ */
+static http_parse_status_t parse_header_line(http_parser_t *parser, const char *buf,
+                                             uint32_t start, uint32_t colon, uint32_t end) {
+    http_request_head_t *head = &parser->head;
+
+    if (colon <= start || colon >= end) {
+        return HTTP_PARSE_ERROR;
+    }
+    /* "Name :" and obs-fold continuation lines are rejected */
+    if (buf[colon - 1U] == ' ' || buf[colon - 1U] == '\t' ||
+        buf[start] == ' ' || buf[start] == '\t') {
+        return HTTP_PARSE_ERROR;
+    }
+    if (head->num_headers >= HTTP_PARSER_MAX_HEADERS) {
+        return HTTP_PARSE_ERROR;
+    }
+
+    uint32_t vs = colon + 1U;
+    uint32_t ve = end;
+    while (vs < ve && (buf[vs] == ' ' || buf[vs] == '\t')) {
+        vs++;
+    }
+    while (ve > vs && (buf[ve - 1U] == ' ' || buf[ve - 1U] == '\t')) {
+        ve--;
+    }
+
+    http_header_t *h = &head->headers[head->num_headers++];
+    h->name.off = start;
+    h->name.len = colon - start;
+    h->value.off = vs;
+    h->value.len = ve - vs;
+
+    if (span_equals_ci(buf, h->name, "content-length")) {
+        return apply_content_length(parser, buf + vs, ve - vs);
+    }
+    if (span_equals_ci(buf, h->name, "transfer-encoding")) {
+        /* Without chunked decoding the body boundary is unknown */
+        return HTTP_PARSE_UNSUPPORTED;
+    }
+    if (span_equals_ci(buf, h->name, "connection")) {
+        if (value_has_token(buf + vs, buf + ve, "close")) {
+            head->keep_alive = 0;
+        } else if (value_has_token(buf + vs, buf + ve, "keep-alive")) {
+            head->keep_alive = 1;
+        }
+    }
+    return HTTP_PARSE_INCOMPLETE;
+}
+
+http_parse_status_t http_parser_execute(http_parser_t *parser, const char *buf, size_t len) {
+    if (parser->done) {
+        return HTTP_PARSE_DONE;
+    }
+    if (len > UINT32_MAX) {
+        return HTTP_PARSE_ERROR;
+    }
+    const uint32_t avail = (uint32_t)len;
+
+    while (parser->pos < avail) {
+        int want_colon = parser->in_headers && parser->colon == 0;
+        uint32_t hit = parser->pos + (uint32_t)http_parser_scan(buf + parser->pos,
+                                                                avail - parser->pos, want_colon);
+        if (hit >= avail) {
+            parser->pos = avail;
+            return HTTP_PARSE_INCOMPLETE;
+        }
+        if (buf[hit] == ':') {
+            parser->colon = hit;
+            parser->pos = hit + 1U;
+            continue;
+        }
+        if (buf[hit] == '\n') {
+            return HTTP_PARSE_ERROR;         /* Bare LF */
+        }
+        if (hit + 1U >= avail) {
+            parser->pos = hit;               /* CR is the last byte so far */
+            return HTTP_PARSE_INCOMPLETE;
+        }
+        if (buf[hit + 1U] != '\n') {
+            return HTTP_PARSE_ERROR;         /* Bare CR */
+        }
+
+        uint32_t start = parser->line_start;
+        parser->pos = hit + 2U;
+        parser->line_start = parser->pos;
+
+        if (!parser->in_headers) {
+            parse_request_line(&parser->head, buf, start, hit);
+            parser->in_headers = 1;
+            continue;
+        }
+        if (hit == start) {
+            parser->head.head_len = parser->pos;
+            parser->done = 1;
+            return HTTP_PARSE_DONE;
+        }
+        http_parse_status_t rc = parse_header_line(parser, buf, start, parser->colon, hit);
+        parser->colon = 0;
+        if (rc != HTTP_PARSE_INCOMPLETE) {
+            return rc;
+        }
+    }
+    return HTTP_PARSE_INCOMPLETE;
+}
+
+const http_header_t *http_request_find_header(const http_request_head_t *head,
+                                              const char *buf, const char *name) {
+    for (uint32_t i = 0; i < head->num_headers; i++) {
+        if (span_equals_ci(buf, head->headers[i].name, name)) {
+            return &head->headers[i];
+        }
+    }
+    return NULL;
+}
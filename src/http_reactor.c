@@ -0,0 +1,961 @@
+/**
+ * http_reactor.c - Multi-reactor epoll HTTP connection engine
+ *
+ * Each reactor thread owns an epoll instance, an SO_REUSEPORT listener
+ * bound to the shared port, and the connections it accepted. Sockets stay
+ * non-blocking and registered for their whole life; once a complete request
+ * is buffered it is handed to the configured handler on the same thread.
+ * Handlers write through http_reactor_send_all() or its gather variant
+ * http_reactor_sendv(), which wait for writability only up to the send
+ * timeout, so a client that stops reading cannot freeze the reactor
+ * indefinitely.
+ *
+ * Keep-alive connections go back to READ_HEAD after each response. Bytes
+ * that arrived behind the dispatched request (pipelining) stay in the
+ * buffer and are framed before the socket is polled again, so responses
+ * leave in request order.
+ *
+ * A handler waiting on a backend parks the connection instead of
+ * blocking: the fd leaves the epoll set and the buffer is kept as is.
+ * http_reactor_resume() pushes the connection onto its reactor's resume
+ * stack (lock-free, any thread) and kicks the eventfd; the reactor then
+ * runs the resume function and continues exactly where dispatch would
+ * have.
+ */
+
+#define _GNU_SOURCE
+#include "http_reactor.h"
+#include "http_parser.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <limits.h>
+
+#define REACTOR_MAX_THREADS      256
+#define REACTOR_MAX_EVENTS       256
+#define REACTOR_TICK_MS          1000
+#define CONN_INITIAL_BUFFER_SIZE 4096U
+
+/**
+ * Per-connection state machine
+ *
+ *   READ_HEAD --(CRLFCRLF seen)--> READ_BODY --(Content-Length bytes)--> DISPATCH
+ *       ^                                                               |    ^
+ *       +----------------------------(keep-alive)-----------------------+    |
+ *                                                                       v    |
+ *                                                       PARKED --(resume)----+
+ *
+ * READ_BODY completes immediately when the request has no body.
+ */
+typedef enum {
+    CONN_STATE_READ_HEAD = 0,
+    CONN_STATE_READ_BODY,
+    CONN_STATE_DISPATCH,
+    CONN_STATE_PARKED
+} conn_state_t;
+
+struct reactor_thread;
+
+typedef struct http_conn_t {
+    int fd;
+    conn_state_t state;
+    struct reactor_thread *rt;      /* Owning reactor thread */
+    char *buf;
+    size_t len;
+    size_t cap;
+    http_parser_t parser;           /* Head of the request at buf[0] */
+    unsigned int served;            /* Requests dispatched on this connection */
+    uint64_t deadline_ms;           /* Request (or idle period) ends by then */
+    uint64_t received_ms;           /* Accept, or first byte of the current request */
+
+    /* In-flight request (DISPATCH and PARKED) */
+    size_t req_len;                 /* Bytes of buf that belong to it */
+    char saved;                     /* Pipelined byte overwritten by its NUL */
+    int keep_alive;                 /* req.keep_alive it was dispatched with */
+    http_reactor_resume_fn resume_fn;
+    void *resume_arg;
+    struct http_conn_t *resume_next; /* Link in the reactor's resume stack */
+
+    struct http_conn_t *prev;
+    struct http_conn_t *next;
+} http_conn_t;
+
+/**
+ * One reactor thread
+ */
+typedef struct reactor_thread {
+    http_reactor_t *owner;
+    int listen_fd;
+    int epoll_fd;
+    int wake_fd;                    /* eventfd used by http_reactor_stop */
+    pthread_t thread;
+    int thread_started;
+
+    http_conn_t *conns;             /* Open connections owned by this thread */
+    int num_conns;
+    int num_parked;                 /* Connections waiting for http_reactor_resume */
+    _Atomic(http_conn_t *) resumed; /* Resumed connections (LIFO, any thread pushes) */
+
+    atomic_uint_fast64_t accepted;
+    atomic_uint_fast64_t rejected;
+    atomic_uint_fast64_t requests;
+    atomic_uint_fast64_t timeouts;
+    atomic_uint_fast64_t idle_closed;
+    atomic_uint_fast64_t reused;
+    atomic_uint_fast64_t unsupported;
+    atomic_uint_fast64_t oversized;
+    atomic_int_fast64_t active;
+    atomic_int_fast64_t parked;
+} reactor_thread_t;
+
+struct http_reactor_t {
+    http_reactor_config_t config;
+    reactor_thread_t *reactors;
+    int num_reactors;
+    uint16_t port;
+    atomic_int stopping;
+};
+
+/* epoll tags for the non-connection fds */
+static char listener_tag;
+static char wake_tag;
+
+/* Send timeout of the reactor running on this thread (see http_reactor_send_all) */
+#define REACTOR_DEFAULT_SEND_TIMEOUT_MS 10000
+static _Thread_local int tls_send_timeout_ms = REACTOR_DEFAULT_SEND_TIMEOUT_MS;
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000ULL;
+}
+
+static int env_positive_int(const char *name, int def_val) {
+    const char *val = getenv(name);
+    if (val == NULL || *val == '\0') {
+        return def_val;
+    }
+    int parsed = atoi(val);
+    return parsed > 0 ? parsed : def_val;
+}
+
+/**
+ * Best-effort status reply for requests the reactor rejects itself
+ */
+static void send_simple_status(int fd, const char *status_line) {
+    char resp[160];
+    int len = snprintf(resp, sizeof(resp),
+                       "%s\r\nContent-Length: 0\r\nConnection: close\r\n\r\n",
+                       status_line);
+    if (len > 0 && (size_t)len < sizeof(resp)) {
+        (void)send(fd, resp, (size_t)len, MSG_NOSIGNAL);
+    }
+}
+
+/* ---------------- Connection lifecycle ---------------- */
+
+static void conn_unlink(reactor_thread_t *rt, http_conn_t *conn) {
+    if (conn->prev) {
+        conn->prev->next = conn->next;
+    } else {
+        rt->conns = conn->next;
+    }
+    if (conn->next) {
+        conn->next->prev = conn->prev;
+    }
+    conn->prev = NULL;
+    conn->next = NULL;
+    rt->num_conns--;
+    atomic_fetch_sub_explicit(&rt->active, 1, memory_order_relaxed);
+}
+
+static void conn_free(http_conn_t *conn) {
+    free(conn->buf);
+    free(conn);
+}
+
+/**
+ * Unregister and close a connection owned by the reactor
+ */
+static void conn_close(reactor_thread_t *rt, http_conn_t *conn) {
+    (void)epoll_ctl(rt->epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+    /* Unlink first: a peer that sees the EOF also sees the updated stats */
+    conn_unlink(rt, conn);
+    close(conn->fd);
+    conn_free(conn);
+}
+
+static http_conn_t *conn_create(reactor_thread_t *rt, int fd) {
+    http_conn_t *conn = calloc(1, sizeof(http_conn_t));
+    if (!conn) {
+        return NULL;
+    }
+    conn->fd = fd;
+    conn->state = CONN_STATE_READ_HEAD;
+    conn->rt = rt;
+    conn->received_ms = now_ms();
+    conn->deadline_ms = conn->received_ms + (uint64_t)rt->owner->config.request_timeout_ms;
+
+    conn->next = rt->conns;
+    if (rt->conns) {
+        rt->conns->prev = conn;
+    }
+    rt->conns = conn;
+    rt->num_conns++;
+    atomic_fetch_add_explicit(&rt->active, 1, memory_order_relaxed);
+    return conn;
+}
+
+/**
+ * Ensure room for at least one more byte plus the NUL terminator
+ */
+static int conn_reserve(http_conn_t *conn, size_t limit) {
+    if (conn->len + 1U < conn->cap) {
+        return 0;
+    }
+    if (conn->cap >= limit + 1U) {
+        return -1;
+    }
+    size_t new_cap = conn->cap ? conn->cap * 2U : CONN_INITIAL_BUFFER_SIZE;
+    if (new_cap > limit + 1U) {
+        new_cap = limit + 1U;
+    }
+    char *nb = realloc(conn->buf, new_cap);
+    if (!nb) {
+        return -1;
+    }
+    conn->buf = nb;
+    conn->cap = new_cap;
+    return 0;
+}
+
+/* ---------------- Request framing ---------------- */
+
+static int conn_request_complete(const http_conn_t *conn) {
+    return conn->state == CONN_STATE_READ_BODY &&
+           conn->len >= conn->parser.head.head_len + conn->parser.head.content_length;
+}
+
+/**
+ * Advance READ_HEAD -> READ_BODY once the parser has seen the whole head
+ *
+ * The parser resumes where the previous read left off, so a head that
+ * trickles in over many segments is still scanned only once.
+ *
+ * @return 0 to continue, -1 if the connection was closed
+ */
+static int conn_try_frame(reactor_thread_t *rt, http_conn_t *conn) {
+    const size_t limit = rt->owner->config.max_request_size;
+
+    if (conn->state != CONN_STATE_READ_HEAD) {
+        return 0;
+    }
+    http_parse_status_t rc = http_parser_execute(&conn->parser, conn->buf, conn->len);
+    if (rc == HTTP_PARSE_INCOMPLETE) {
+        return 0;
+    }
+    if (rc == HTTP_PARSE_UNSUPPORTED) {
+        atomic_fetch_add_explicit(&rt->unsupported, 1, memory_order_relaxed);
+        send_simple_status(conn->fd, "HTTP/1.1 501 Not Implemented");
+        conn_close(rt, conn);
+        return -1;
+    }
+    if (rc != HTTP_PARSE_DONE) {
+        send_simple_status(conn->fd, "HTTP/1.1 400 Bad Request");
+        conn_close(rt, conn);
+        return -1;
+    }
+    const http_request_head_t *head = &conn->parser.head;
+    if (head->content_length > limit - head->head_len) {
+        atomic_fetch_add_explicit(&rt->oversized, 1, memory_order_relaxed);
+        send_simple_status(conn->fd, "HTTP/1.1 413 Payload Too Large");
+        conn_close(rt, conn);
+        return -1;
+    }
+    conn->state = CONN_STATE_READ_BODY;
+    return 0;
+}
+
+/**
+ * Apply the handler's verdict on the in-flight request
+ *
+ * @return 0 if the connection waits for its next request, -1 if it was
+ *         closed, detached or parked
+ */
+static int conn_finish(reactor_thread_t *rt, http_conn_t *conn, http_conn_action_t action) {
+    const http_reactor_config_t *cfg = &rt->owner->config;
+    size_t req_len = conn->req_len;
+
+    if (action == HTTP_CONN_PARK) {
+        /* Nothing is read while parked; pipelined bytes wait in the buffer */
+        (void)epoll_ctl(rt->epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+        conn->state = CONN_STATE_PARKED;
+        rt->num_parked++;
+        atomic_fetch_add_explicit(&rt->parked, 1, memory_order_relaxed);
+        return -1;
+    }
+    if (action == HTTP_CONN_DETACH) {
+        /* Pipelined bytes behind a detached request are dropped with the buffer */
+        (void)epoll_ctl(rt->epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+        conn_unlink(rt, conn);
+        conn_free(conn);
+        return -1;
+    }
+    if (action != HTTP_CONN_KEEP_ALIVE || !conn->keep_alive) {
+        conn_close(rt, conn);
+        return -1;
+    }
+
+    /* Keep pipelined bytes and start over on the next request */
+    conn->buf[req_len] = conn->saved;
+    size_t rest = conn->len - req_len;
+    if (rest > 0) {
+        memmove(conn->buf, conn->buf + req_len, rest);
+    }
+    conn->len = rest;
+    http_parser_init(&conn->parser);
+    conn->state = CONN_STATE_READ_HEAD;
+    conn->received_ms = now_ms();
+    conn->deadline_ms = conn->received_ms + (uint64_t)(rest > 0 ? cfg->request_timeout_ms
+                                                                : cfg->keepalive_timeout_ms);
+    return 0;
+}
+
+/**
+ * Hand a complete request to the handler
+ *
+ * @return 0 if the connection stays with the reactor, -1 if it is gone
+ *         (or parked)
+ */
+static int conn_dispatch(reactor_thread_t *rt, http_conn_t *conn) {
+    const http_reactor_config_t *cfg = &rt->owner->config;
+    size_t req_len = conn->parser.head.head_len + conn->parser.head.content_length;
+
+    conn->state = CONN_STATE_DISPATCH;
+    conn->served++;
+    atomic_fetch_add_explicit(&rt->requests, 1, memory_order_relaxed);
+    if (conn->served > 1U) {
+        atomic_fetch_add_explicit(&rt->reused, 1, memory_order_relaxed);
+    }
+
+    /* Save the first pipelined byte; the handler sees a NUL-terminated request */
+    conn->req_len = req_len;
+    conn->saved = conn->buf[req_len];
+    conn->buf[req_len] = '\0';
+    conn->keep_alive = conn->parser.head.keep_alive &&
+                       conn->served < (unsigned int)cfg->max_requests_per_connection &&
+                       !atomic_load(&rt->owner->stopping);
+
+    http_reactor_request_t req;
+    req.fd = conn->fd;
+    req.data = conn->buf;
+    req.len = req_len;
+    req.seq = conn->served;
+    req.head = &conn->parser.head;
+    req.keep_alive = conn->keep_alive;
+    req.ticket = (http_reactor_ticket_t *)conn;
+    req.received_ms = conn->received_ms;
+
+    /* The fd stays registered: this thread polls nothing until the handler returns */
+    http_conn_action_t action = cfg->handler(&req, cfg->user_data);
+    return conn_finish(rt, conn, action);
+}
+
+/**
+ * Serve every complete request already buffered (pipelining)
+ *
+ * @return 0 if the connection is still owned by the reactor, -1 otherwise
+ */
+static int conn_drain_buffered(reactor_thread_t *rt, http_conn_t *conn) {
+    while (conn_request_complete(conn)) {
+        if (conn_dispatch(rt, conn) != 0) {
+            return -1;
+        }
+        if (conn->len == 0) {
+            return 0;
+        }
+        if (conn_try_frame(rt, conn) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Drain readable bytes and advance the state machine
+ */
+static void conn_on_readable(reactor_thread_t *rt, http_conn_t *conn) {
+    const http_reactor_config_t *cfg = &rt->owner->config;
+    const size_t limit = cfg->max_request_size;
+
+    for (;;) {
+        if (conn_reserve(conn, limit) != 0) {
+            atomic_fetch_add_explicit(&rt->oversized, 1, memory_order_relaxed);
+            send_simple_status(conn->fd, "HTTP/1.1 413 Payload Too Large");
+            conn_close(rt, conn);
+            return;
+        }
+
+        ssize_t n = recv(conn->fd, conn->buf + conn->len, conn->cap - conn->len - 1U, 0);
+        if (n == 0) {
+            conn_close(rt, conn);
+            return;
+        }
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return;
+            }
+            conn_close(rt, conn);
+            return;
+        }
+
+        size_t prev_len = conn->len;
+        conn->len += (size_t)n;
+        if (prev_len == 0 && conn->served > 0U) {
+            /* First byte of the next request ends the idle period */
+            conn->received_ms = now_ms();
+            conn->deadline_ms = conn->received_ms + (uint64_t)cfg->request_timeout_ms;
+        }
+
+        if (conn_try_frame(rt, conn) != 0) {
+            return;
+        }
+        if (conn_drain_buffered(rt, conn) != 0) {
+            return;
+        }
+    }
+}
+
+/* ---------------- Reactor loop ---------------- */
+
+static void reactor_accept(reactor_thread_t *rt) {
+    const http_reactor_config_t *cfg = &rt->owner->config;
+
+    for (;;) {
+        int fd = accept4(rt->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            /* EAGAIN: backlog drained; anything else is transient (EMFILE, ECONNABORTED) */
+            return;
+        }
+
+        if (rt->num_conns >= cfg->max_connections) {
+            atomic_fetch_add_explicit(&rt->rejected, 1, memory_order_relaxed);
+            send_simple_status(fd, "HTTP/1.1 503 Service Unavailable");
+            close(fd);
+            continue;
+        }
+
+        int one = 1;
+        (void)setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        http_conn_t *conn = conn_create(rt, fd);
+        if (!conn) {
+            close(fd);
+            continue;
+        }
+
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.ptr = conn;
+        if (epoll_ctl(rt->epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            close(fd);
+            conn_unlink(rt, conn);
+            conn_free(conn);
+            continue;
+        }
+        atomic_fetch_add_explicit(&rt->accepted, 1, memory_order_relaxed);
+    }
+}
+
+/**
+ * Close connections that have not delivered a full request in time, and
+ * keep-alive connections that stayed idle past the keep-alive timeout
+ */
+static void reactor_sweep(reactor_thread_t *rt) {
+    uint64_t now = now_ms();
+    http_conn_t *conn = rt->conns;
+    while (conn) {
+        http_conn_t *next = conn->next;
+        if (conn->state != CONN_STATE_PARKED && now >= conn->deadline_ms) {
+            if (conn->len > 0) {
+                atomic_fetch_add_explicit(&rt->timeouts, 1, memory_order_relaxed);
+                send_simple_status(conn->fd, "HTTP/1.1 408 Request Timeout");
+            } else if (conn->served > 0U) {
+                atomic_fetch_add_explicit(&rt->idle_closed, 1, memory_order_relaxed);
+            } else {
+                atomic_fetch_add_explicit(&rt->timeouts, 1, memory_order_relaxed);
+            }
+            conn_close(rt, conn);
+        }
+        conn = next;
+    }
+}
+
+/**
+ * Run the resume functions queued by http_reactor_resume()
+ */
+static void reactor_run_resumed(reactor_thread_t *rt) {
+    http_conn_t *stack = atomic_exchange(&rt->resumed, NULL);
+
+    /* Reverse the LIFO so connections resume in the order they were queued */
+    http_conn_t *queue = NULL;
+    while (stack) {
+        http_conn_t *next = stack->resume_next;
+        stack->resume_next = queue;
+        queue = stack;
+        stack = next;
+    }
+
+    while (queue) {
+        http_conn_t *conn = queue;
+        queue = conn->resume_next;
+        conn->resume_next = NULL;
+
+        rt->num_parked--;
+        atomic_fetch_sub_explicit(&rt->parked, 1, memory_order_relaxed);
+        conn->state = CONN_STATE_DISPATCH;
+        if (atomic_load(&rt->owner->stopping)) {
+            conn->keep_alive = 0;
+        }
+
+        http_conn_action_t action = conn->resume_fn(conn->fd, conn->keep_alive, conn->resume_arg);
+        if (action == HTTP_CONN_DETACH) {
+            /* Already out of epoll; the new owner may even have closed the
+             * fd and this thread accepted another under the same number */
+            conn_unlink(rt, conn);
+            conn_free(conn);
+            continue;
+        }
+        if (conn_finish(rt, conn, action) != 0) {
+            continue;
+        }
+
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.ptr = conn;
+        if (epoll_ctl(rt->epoll_fd, EPOLL_CTL_ADD, conn->fd, &ev) != 0) {
+            conn_close(rt, conn);
+            continue;
+        }
+        /* Requests pipelined behind the parked one */
+        if (conn->len > 0 && conn_try_frame(rt, conn) == 0) {
+            (void)conn_drain_buffered(rt, conn);
+        }
+    }
+}
+
+static void *reactor_thread_main(void *arg) {
+    reactor_thread_t *rt = (reactor_thread_t *)arg;
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+    uint64_t next_sweep = now_ms() + REACTOR_TICK_MS;
+    int listening = 1;
+
+    tls_send_timeout_ms = rt->owner->config.send_timeout_ms;
+
+    /* After stop, keep running until every parked request was answered */
+    while (!atomic_load(&rt->owner->stopping) || rt->num_parked > 0) {
+        if (listening && atomic_load(&rt->owner->stopping)) {
+            (void)epoll_ctl(rt->epoll_fd, EPOLL_CTL_DEL, rt->listen_fd, NULL);
+            listening = 0;
+        }
+
+        int n = epoll_wait(rt->epoll_fd, events, REACTOR_MAX_EVENTS, REACTOR_TICK_MS);
+        if (n < 0 && errno != EINTR) {
+            break;
+        }
+
+        int woken = 0;
+        for (int i = 0; i < n; i++) {
+            void *tag = events[i].data.ptr;
+            if (tag == &listener_tag) {
+                reactor_accept(rt);
+            } else if (tag == &wake_tag) {
+                uint64_t count;
+                (void)read(rt->wake_fd, &count, sizeof(count));
+                woken = 1;
+            } else {
+                http_conn_t *conn = (http_conn_t *)tag;
+                if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                    conn_on_readable(rt, conn);
+                }
+            }
+        }
+        if (woken) {
+            reactor_run_resumed(rt);
+        }
+
+        uint64_t now = now_ms();
+        if (now >= next_sweep) {
+            reactor_sweep(rt);
+            next_sweep = now + REACTOR_TICK_MS;
+        }
+    }
+    return NULL;
+}
+
+/* ---------------- Setup / teardown ---------------- */
+
+static int create_listener(uint16_t port, int backlog) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    int opt = 1;
+    (void)setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) != 0) {
+        perror("setsockopt(SO_REUSEPORT)");
+        close(fd);
+        return -1;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("bind");
+        close(fd);
+        return -1;
+    }
+    if (listen(fd, backlog) < 0) {
+        perror("listen");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int reactor_thread_init(reactor_thread_t *rt, http_reactor_t *owner, uint16_t port) {
+    rt->owner = owner;
+    rt->listen_fd = -1;
+    rt->epoll_fd = -1;
+    rt->wake_fd = -1;
+
+    rt->listen_fd = create_listener(port, owner->config.listen_backlog);
+    if (rt->listen_fd < 0) {
+        return -1;
+    }
+    rt->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (rt->epoll_fd < 0) {
+        return -1;
+    }
+    rt->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (rt->wake_fd < 0) {
+        return -1;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = &listener_tag;
+    if (epoll_ctl(rt->epoll_fd, EPOLL_CTL_ADD, rt->listen_fd, &ev) != 0) {
+        return -1;
+    }
+    ev.data.ptr = &wake_tag;
+    if (epoll_ctl(rt->epoll_fd, EPOLL_CTL_ADD, rt->wake_fd, &ev) != 0) {
+        return -1;
+    }
+
+    atomic_init(&rt->accepted, 0);
+    atomic_init(&rt->rejected, 0);
+    atomic_init(&rt->requests, 0);
+    atomic_init(&rt->timeouts, 0);
+    atomic_init(&rt->idle_closed, 0);
+    atomic_init(&rt->reused, 0);
+    atomic_init(&rt->unsupported, 0);
+    atomic_init(&rt->oversized, 0);
+    atomic_init(&rt->active, 0);
+    atomic_init(&rt->parked, 0);
+    atomic_init(&rt->resumed, NULL);
+    return 0;
+}
+
+static void reactor_thread_cleanup(reactor_thread_t *rt) {
+    while (rt->conns) {
+        conn_close(rt, rt->conns);
+    }
+    if (rt->listen_fd >= 0) close(rt->listen_fd);
+    if (rt->epoll_fd >= 0) close(rt->epoll_fd);
+    if (rt->wake_fd >= 0) close(rt->wake_fd);
+    rt->listen_fd = rt->epoll_fd = rt->wake_fd = -1;
+}
+
+void http_reactor_get_default_config(http_reactor_config_t *config) {
+    if (!config) return;
+
+    memset(config, 0, sizeof(http_reactor_config_t));
+    config->port = 8080;
+    config->num_threads = 0;
+    config->listen_backlog = 1024;
+    config->max_connections = 10000;
+    config->max_request_size = 65536U;
+    config->request_timeout_ms = 30000;
+    config->keepalive_timeout_ms = 5000;
+    config->max_requests_per_connection = 1000;
+    config->send_timeout_ms = REACTOR_DEFAULT_SEND_TIMEOUT_MS;
+}
+
+int http_reactor_parse_config(http_reactor_config_t *config) {
+    if (!config) return -1;
+
+    config->num_threads = env_positive_int("GATEWAY_REACTOR_THREADS", config->num_threads);
+    config->listen_backlog = env_positive_int("GATEWAY_LISTEN_BACKLOG", config->listen_backlog);
+    config->max_connections = env_positive_int("GATEWAY_MAX_CONNECTIONS_PER_REACTOR",
+                                               config->max_connections);
+    config->request_timeout_ms = env_positive_int("GATEWAY_HTTP_REQUEST_TIMEOUT_MS",
+                                                  config->request_timeout_ms);
+    config->keepalive_timeout_ms = env_positive_int("GATEWAY_HTTP_KEEPALIVE_TIMEOUT_MS",
+                                                    config->keepalive_timeout_ms);
+    config->max_requests_per_connection = env_positive_int("GATEWAY_HTTP_MAX_REQUESTS_PER_CONNECTION",
+                                                           config->max_requests_per_connection);
+    config->send_timeout_ms = env_positive_int("GATEWAY_HTTP_SEND_TIMEOUT_MS",
+                                               config->send_timeout_ms);
+    return 0;
+}
+
+http_reactor_t* http_reactor_create(const http_reactor_config_t *config) {
+    if (!config || !config->handler || config->max_request_size == 0 ||
+        config->max_request_size >= UINT32_MAX ||
+        config->listen_backlog <= 0 || config->max_connections <= 0 ||
+        config->request_timeout_ms <= 0 || config->keepalive_timeout_ms <= 0 ||
+        config->max_requests_per_connection <= 0 || config->send_timeout_ms <= 0) {
+        return NULL;
+    }
+
+    http_reactor_t *reactor = calloc(1, sizeof(http_reactor_t));
+    if (!reactor) return NULL;
+
+    reactor->config = *config;
+    atomic_init(&reactor->stopping, 0);
+
+    int threads = config->num_threads;
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (threads > REACTOR_MAX_THREADS) {
+        threads = REACTOR_MAX_THREADS;
+    }
+
+    reactor->reactors = calloc((size_t)threads, sizeof(reactor_thread_t));
+    if (!reactor->reactors) {
+        free(reactor);
+        return NULL;
+    }
+
+    uint16_t port = config->port;
+    for (int i = 0; i < threads; i++) {
+        reactor_thread_t *rt = &reactor->reactors[i];
+        reactor->num_reactors = i + 1;
+        if (reactor_thread_init(rt, reactor, port) != 0) {
+            http_reactor_destroy(reactor);
+            return NULL;
+        }
+        if (i == 0) {
+            /* Resolve an ephemeral port once so every listener shares it */
+            struct sockaddr_in bound;
+            socklen_t blen = sizeof(bound);
+            if (getsockname(rt->listen_fd, (struct sockaddr *)&bound, &blen) == 0) {
+                port = ntohs(bound.sin_port);
+            }
+        }
+    }
+    reactor->port = port;
+    return reactor;
+}
+
+int http_reactor_start(http_reactor_t *reactor) {
+    if (!reactor) return -1;
+
+    /* Keep process signals on the caller's thread */
+    sigset_t block, saved;
+    sigemptyset(&block);
+    sigaddset(&block, SIGINT);
+    sigaddset(&block, SIGTERM);
+    sigaddset(&block, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &block, &saved);
+
+    int rc = 0;
+    for (int i = 0; i < reactor->num_reactors; i++) {
+        reactor_thread_t *rt = &reactor->reactors[i];
+        if (pthread_create(&rt->thread, NULL, reactor_thread_main, rt) != 0) {
+            rc = -1;
+            break;
+        }
+        rt->thread_started = 1;
+    }
+
+    pthread_sigmask(SIG_SETMASK, &saved, NULL);
+    if (rc != 0) {
+        http_reactor_stop(reactor);
+    }
+    return rc;
+}
+
+void http_reactor_stop(http_reactor_t *reactor) {
+    if (!reactor) return;
+
+    atomic_store(&reactor->stopping, 1);
+    for (int i = 0; i < reactor->num_reactors; i++) {
+        if (reactor->reactors[i].wake_fd >= 0) {
+            uint64_t one = 1;
+            (void)write(reactor->reactors[i].wake_fd, &one, sizeof(one));
+        }
+    }
+}
+
+void http_reactor_destroy(http_reactor_t *reactor) {
+    if (!reactor) return;
+
+    http_reactor_stop(reactor);
+    for (int i = 0; i < reactor->num_reactors; i++) {
+        if (reactor->reactors[i].thread_started) {
+            pthread_join(reactor->reactors[i].thread, NULL);
+            reactor->reactors[i].thread_started = 0;
+        }
+    }
+    for (int i = 0; i < reactor->num_reactors; i++) {
+        reactor_thread_cleanup(&reactor->reactors[i]);
+    }
+    free(reactor->reactors);
+    free(reactor);
+}
+
+void http_reactor_resume(http_reactor_ticket_t *ticket, http_reactor_resume_fn fn, void *arg) {
+    http_conn_t *conn = (http_conn_t *)ticket;
+    reactor_thread_t *rt = conn->rt;
+
+    conn->resume_fn = fn;
+    conn->resume_arg = arg;
+    http_conn_t *head = atomic_load(&rt->resumed);
+    do {
+        conn->resume_next = head;
+    } while (!atomic_compare_exchange_weak(&rt->resumed, &head, conn));
+
+    /* The reactor drains the whole stack per wakeup; only the first push kicks it */
+    if (head == NULL) {
+        uint64_t one = 1;
+        (void)write(rt->wake_fd, &one, sizeof(one));
+    }
+}
+
+void http_reactor_set_thread_send_timeout(int timeout_ms) {
+    tls_send_timeout_ms = timeout_ms > 0 ? timeout_ms : REACTOR_DEFAULT_SEND_TIMEOUT_MS;
+}
+
+int http_reactor_sendv(int fd, struct iovec *iov, int iovcnt) {
+    uint64_t deadline = 0;
+
+    /* Skip leading empty entries so a short write resumes mid-vector */
+    while (iovcnt > 0 && iov->iov_len == 0) {
+        iov++;
+        iovcnt--;
+    }
+    while (iovcnt > 0) {
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = (size_t)(iovcnt < IOV_MAX ? iovcnt : IOV_MAX);
+
+        ssize_t n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (n > 0) {
+            size_t sent = (size_t)n;
+            while (iovcnt > 0 && sent >= iov->iov_len) {
+                sent -= iov->iov_len;
+                iov++;
+                iovcnt--;
+            }
+            if (iovcnt > 0) {
+                iov->iov_base = (char *)iov->iov_base + sent;
+                iov->iov_len -= sent;
+                while (iovcnt > 0 && iov->iov_len == 0) {
+                    iov++;
+                    iovcnt--;
+                }
+            }
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            return -1;
+        }
+
+        /* Socket buffer full: wait for the client to drain it, but not forever */
+        uint64_t now = now_ms();
+        if (deadline == 0) {
+            deadline = now + (uint64_t)tls_send_timeout_ms;
+        }
+        if (now >= deadline) {
+            return -1;
+        }
+        struct pollfd pfd = { .fd = fd, .events = POLLOUT, .revents = 0 };
+        int rc = poll(&pfd, 1, (int)(deadline - now));
+        if (rc == 0 || (rc < 0 && errno != EINTR)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int http_reactor_send_all(int fd, const void *data, size_t len) {
+    struct iovec iov = { .iov_base = (void *)(uintptr_t)data, .iov_len = len };
+    return http_reactor_sendv(fd, &iov, 1);
+}
+
+uint16_t http_reactor_get_port(const http_reactor_t *reactor) {
+    return reactor ? reactor->port : 0;
+}
+
+int http_reactor_get_num_threads(const http_reactor_t *reactor) {
+    return reactor ? reactor->num_reactors : 0;
+}
+
+int http_reactor_get_stats(const http_reactor_t *reactor, http_reactor_stats_t *stats) {
+    if (!reactor || !stats) return -1;
+
+    memset(stats, 0, sizeof(http_reactor_stats_t));
+    for (int i = 0; i < reactor->num_reactors; i++) {
+        const reactor_thread_t *rt = &reactor->reactors[i];
+        stats->accepted += atomic_load_explicit(&rt->accepted, memory_order_relaxed);
+        stats->rejected += atomic_load_explicit(&rt->rejected, memory_order_relaxed);
+        stats->requests += atomic_load_explicit(&rt->requests, memory_order_relaxed);
+        stats->timeouts += atomic_load_explicit(&rt->timeouts, memory_order_relaxed);
+        stats->idle_closed += atomic_load_explicit(&rt->idle_closed, memory_order_relaxed);
+        stats->reused += atomic_load_explicit(&rt->reused, memory_order_relaxed);
+        stats->unsupported += atomic_load_explicit(&rt->unsupported, memory_order_relaxed);
+        stats->oversized += atomic_load_explicit(&rt->oversized, memory_order_relaxed);
+        int64_t active = atomic_load_explicit(&rt->active, memory_order_relaxed);
+        stats->active_connections += active > 0 ? (uint64_t)active : 0U;
+        int64_t parked = atomic_load_explicit(&rt->parked, memory_order_relaxed);
+        stats->parked += parked > 0 ? (uint64_t)parked : 0U;
+    }
+    return 0;
+}
@@ -0,0 +1,143 @@
+/**
+ * http_response.c - Scatter-gather HTTP response writer
+ *
+ * Variable header lines are rendered back to back into resp->fields;
+ * consecutive lines share one iovec entry, so a typical response is
+ * status line, CRLF, constant headers, one field run, the Connection
+ * trailer and the body.
+ */
+
+#include "http_response.h"
+#include "http_reactor.h"
+#include <string.h>
+
+static const char CRLF[] = "\r\n";
+static const char CONNECTION_KEEP_ALIVE[] = "Connection: keep-alive\r\n\r\n";
+static const char CONNECTION_CLOSE[] = "Connection: close\r\n\r\n";
+
+static void push_iov(http_response_t *resp, const void *base, size_t len) {
+    if (len == 0) {
+        return;
+    }
+    if (resp->iovcnt >= HTTP_RESPONSE_MAX_IOV) {
+        resp->overflow = 1;
+        return;
+    }
+    resp->iov[resp->iovcnt].iov_base = (void *)(uintptr_t)base;
+    resp->iov[resp->iovcnt].iov_len = len;
+    resp->iovcnt++;
+}
+
+/* Reserve room in the field buffer, or NULL (and overflow) when full */
+static char *fields_reserve(http_response_t *resp, size_t len) {
+    if (resp->fields_len + len > sizeof(resp->fields)) {
+        resp->overflow = 1;
+        return NULL;
+    }
+    return resp->fields + resp->fields_len;
+}
+
+/* Account for len bytes written at the reserved spot, merging with the
+ * previous field run when it ends right there */
+static void fields_commit(http_response_t *resp, size_t len) {
+    char *start = resp->fields + resp->fields_len;
+    resp->fields_len += len;
+
+    if (resp->iovcnt > 0) {
+        struct iovec *last = &resp->iov[resp->iovcnt - 1];
+        if ((char *)last->iov_base + last->iov_len == start) {
+            last->iov_len += len;
+            return;
+        }
+    }
+    push_iov(resp, start, len);
+}
+
+static size_t render_uint(char *out, uint64_t v) {
+    char tmp[20];
+    size_t n = 0;
+    do {
+        tmp[n++] = (char)('0' + (int)(v % 10U));
+        v /= 10U;
+    } while (v != 0);
+    for (size_t i = 0; i < n; i++) {
+        out[i] = tmp[n - 1U - i];
+    }
+    return n;
+}
+
+void http_response_init(http_response_t *resp, const char *status_line) {
+    resp->iovcnt = 0;
+    resp->fields_len = 0;
+    resp->overflow = 0;
+    push_iov(resp, status_line, strlen(status_line));
+    push_iov(resp, CRLF, sizeof(CRLF) - 1U);
+}
+
+void http_response_add_raw(http_response_t *resp, const char *text) {
+    if (text) {
+        push_iov(resp, text, strlen(text));
+    }
+}
+
+void http_response_add_header(http_response_t *resp, const char *name, const char *value) {
+    size_t nlen = strlen(name);
+    size_t vlen = value ? strlen(value) : 0U;
+    char *p = fields_reserve(resp, nlen + vlen + 4U);
+    if (!p) {
+        return;
+    }
+    memcpy(p, name, nlen);
+    p[nlen] = ':';
+    p[nlen + 1U] = ' ';
+    if (vlen > 0) {
+        memcpy(p + nlen + 2U, value, vlen);
+    }
+    p[nlen + 2U + vlen] = '\r';
+    p[nlen + 3U + vlen] = '\n';
+    fields_commit(resp, nlen + vlen + 4U);
+}
+
+void http_response_add_uint(http_response_t *resp, const char *name, uint64_t value) {
+    size_t nlen = strlen(name);
+    char *p = fields_reserve(resp, nlen + 20U + 4U);
+    if (!p) {
+        return;
+    }
+    memcpy(p, name, nlen);
+    p[nlen] = ':';
+    p[nlen + 1U] = ' ';
+    size_t vlen = render_uint(p + nlen + 2U, value);
+    p[nlen + 2U + vlen] = '\r';
+    p[nlen + 3U + vlen] = '\n';
+    fields_commit(resp, nlen + vlen + 4U);
+}
+
+static void push_connection(http_response_t *resp, int keep_alive) {
+    if (keep_alive) {
+        push_iov(resp, CONNECTION_KEEP_ALIVE, sizeof(CONNECTION_KEEP_ALIVE) - 1U);
+    } else {
+        push_iov(resp, CONNECTION_CLOSE, sizeof(CONNECTION_CLOSE) - 1U);
+    }
+}
+
+int http_response_send_head(http_response_t *resp, int fd, int keep_alive) {
+    push_connection(resp, keep_alive);
+    if (resp->overflow) {
+        return -1;
+    }
+    return http_reactor_sendv(fd, resp->iov, resp->iovcnt);
+}
+
+int http_response_send(http_response_t *resp, int fd, int keep_alive,
+                       const void *body, size_t body_len) {
+    http_response_add_uint(resp, "Content-Length", body_len);
+    push_connection(resp, keep_alive);
+    if (body) {
+        push_iov(resp, body, body_len);
+    }
+    if (resp->overflow) {
+        return -1;
+    }
+    return http_reactor_sendv(fd, resp->iov, resp->iovcnt);
+}
@@ -0,0 +1,289 @@
+/**
+ * http_route_table.c - Compiled HTTP route table (segment trie)
+ *
+ * Each node owns its literal children, at most one ":param" child and
+ * an optional "*wildcard" terminal. Literal children carry a hash of
+ * their segment, so a level costs one pass over the request segment
+ * plus a memcmp on the (rare) hash hit.
+ */
+
+#include "http_route_table.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct route_node_t {
+    char *segment;                   /* Literal segment (NULL for root and params) */
+    size_t segment_len;
+    uint32_t hash;
+
+    struct route_node_t **children;  /* Literal children */
+    size_t num_children;
+
+    struct route_node_t *param;      /* ":name" child */
+    char *param_name;
+
+    char *wildcard_name;             /* "*name" terminal */
+    const void *wildcard_data[HTTP_ROUTE_METHOD_COUNT];
+
+    const void *data[HTTP_ROUTE_METHOD_COUNT];
+} route_node_t;
+
+struct http_route_table_t {
+    route_node_t root;
+};
+
+/* FNV-1a */
+static uint32_t segment_hash(const char *s, size_t len) {
+    uint32_t h = 2166136261U;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (uint8_t)s[i];
+        h *= 16777619U;
+    }
+    return h;
+}
+
+static int method_index(const char *m, size_t len) {
+    switch (len) {
+        case 3:
+            if (memcmp(m, "GET", 3) == 0) return HTTP_ROUTE_GET;
+            if (memcmp(m, "PUT", 3) == 0) return HTTP_ROUTE_PUT;
+            break;
+        case 4:
+            if (memcmp(m, "POST", 4) == 0) return HTTP_ROUTE_POST;
+            break;
+        case 6:
+            if (memcmp(m, "DELETE", 6) == 0) return HTTP_ROUTE_DELETE;
+            break;
+        default:
+            break;
+    }
+    return -1;
+}
+
+static char *dup_range(const char *s, size_t len) {
+    char *d = malloc(len + 1U);
+    if (d) {
+        memcpy(d, s, len);
+        d[len] = '\0';
+    }
+    return d;
+}
+
+static route_node_t *find_literal(const route_node_t *node, const char *seg, size_t len,
+                                  uint32_t hash) {
+    for (size_t i = 0; i < node->num_children; i++) {
+        route_node_t *c = node->children[i];
+        if (c->hash == hash && c->segment_len == len && memcmp(c->segment, seg, len) == 0) {
+            return c;
+        }
+    }
+    return NULL;
+}
+
+static route_node_t *add_literal(route_node_t *node, const char *seg, size_t len) {
+    uint32_t hash = segment_hash(seg, len);
+    route_node_t *c = find_literal(node, seg, len, hash);
+    if (c) {
+        return c;
+    }
+    route_node_t **grown = realloc(node->children, (node->num_children + 1U) * sizeof(*grown));
+    if (!grown) {
+        return NULL;
+    }
+    node->children = grown;
+    c = calloc(1, sizeof(*c));
+    if (!c) {
+        return NULL;
+    }
+    c->segment = dup_range(seg, len);
+    if (!c->segment) {
+        free(c);
+        return NULL;
+    }
+    c->segment_len = len;
+    c->hash = hash;
+    node->children[node->num_children++] = c;
+    return c;
+}
+
+static route_node_t *add_param(route_node_t *node, const char *name, size_t len) {
+    if (node->param) {
+        /* Sibling routes must agree on the parameter name */
+        if (strlen(node->param_name) != len || memcmp(node->param_name, name, len) != 0) {
+            return NULL;
+        }
+        return node->param;
+    }
+    node->param_name = dup_range(name, len);
+    if (!node->param_name) {
+        return NULL;
+    }
+    node->param = calloc(1, sizeof(route_node_t));
+    if (!node->param) {
+        free(node->param_name);
+        node->param_name = NULL;
+    }
+    return node->param;
+}
+
+http_route_table_t *http_route_table_create(void) {
+    return calloc(1, sizeof(http_route_table_t));
+}
+
+int http_route_table_add(http_route_table_t *table, const char *method,
+                         const char *pattern, const void *data) {
+    if (!table || !method || !pattern || pattern[0] != '/' || !data) {
+        return -1;
+    }
+    int m = method_index(method, strlen(method));
+    if (m < 0) {
+        return -1;
+    }
+
+    route_node_t *node = &table->root;
+    size_t params = 0;
+    const char *seg = pattern + 1;
+    for (;;) {
+        const char *slash = strchr(seg, '/');
+        size_t len = slash ? (size_t)(slash - seg) : strlen(seg);
+
+        if (len > 0 && seg[0] == '*') {
+            /* Wildcard: named, last segment, one route per method */
+            if (slash || len == 1U || ++params > HTTP_ROUTE_MAX_PARAMS) {
+                return -1;
+            }
+            if (node->wildcard_name) {
+                if (strlen(node->wildcard_name) != len - 1U ||
+                    memcmp(node->wildcard_name, seg + 1, len - 1U) != 0) {
+                    return -1;
+                }
+            } else {
+                node->wildcard_name = dup_range(seg + 1, len - 1U);
+                if (!node->wildcard_name) {
+                    return -1;
+                }
+            }
+            if (node->wildcard_data[m]) {
+                return -1;
+            }
+            node->wildcard_data[m] = data;
+            return 0;
+        }
+
+        if (len > 0 && seg[0] == ':') {
+            if (len == 1U || ++params > HTTP_ROUTE_MAX_PARAMS) {
+                return -1;
+            }
+            node = add_param(node, seg + 1, len - 1U);
+        } else {
+            node = add_literal(node, seg, len);
+        }
+        if (!node) {
+            return -1;
+        }
+        if (!slash) {
+            break;
+        }
+        seg = slash + 1;
+    }
+
+    if (node->data[m]) {
+        return -1;
+    }
+    node->data[m] = data;
+    return 0;
+}
+
+/**
+ * Match the segments from seg (NULL once the path is exhausted) under node
+ */
+static int match_node(const route_node_t *node, const char *seg, const char *end,
+                      int m, http_route_match_t *match) {
+    if (!seg) {
+        if (node->data[m]) {
+            match->data = node->data[m];
+            return 1;
+        }
+        return 0;
+    }
+
+    const char *slash = memchr(seg, '/', (size_t)(end - seg));
+    const char *seg_end = slash ? slash : end;
+    const char *next = slash ? slash + 1 : NULL;
+    size_t len = (size_t)(seg_end - seg);
+
+    if (node->num_children > 0) {
+        const route_node_t *lit = find_literal(node, seg, len, segment_hash(seg, len));
+        if (lit && match_node(lit, next, end, m, match)) {
+            return 1;
+        }
+    }
+
+    if (node->param && match->num_params < HTTP_ROUTE_MAX_PARAMS) {
+        http_route_param_t *p = &match->params[match->num_params++];
+        p->name = node->param_name;
+        p->value = seg;
+        p->len = len;
+        if (match_node(node->param, next, end, m, match)) {
+            return 1;
+        }
+        match->num_params--;
+    }
+
+    if (node->wildcard_data[m] && match->num_params < HTTP_ROUTE_MAX_PARAMS) {
+        http_route_param_t *p = &match->params[match->num_params++];
+        p->name = node->wildcard_name;
+        p->value = seg;
+        p->len = (size_t)(end - seg);
+        match->data = node->wildcard_data[m];
+        return 1;
+    }
+    return 0;
+}
+
+int http_route_table_match(const http_route_table_t *table,
+                           const char *method, size_t method_len,
+                           const char *path, size_t path_len,
+                           http_route_match_t *match) {
+    memset(match, 0, sizeof(*match));
+    if (!table || !method || !path || path_len == 0 || path[0] != '/') {
+        return -1;
+    }
+    int m = method_index(method, method_len);
+    if (m < 0) {
+        return -1;
+    }
+    return match_node(&table->root, path + 1, path + path_len, m, match) ? 0 : -1;
+}
+
+const http_route_param_t *http_route_match_param(const http_route_match_t *match,
+                                                 const char *name) {
+    for (size_t i = 0; i < match->num_params; i++) {
+        if (strcmp(match->params[i].name, name) == 0) {
+            return &match->params[i];
+        }
+    }
+    return NULL;
+}
+
+static void node_free(route_node_t *node) {
+    for (size_t i = 0; i < node->num_children; i++) {
+        node_free(node->children[i]);
+        free(node->children[i]);
+    }
+    free(node->children);
+    free(node->segment);
+    if (node->param) {
+        node_free(node->param);
+        free(node->param);
+    }
+    free(node->param_name);
+    free(node->wildcard_name);
+}
+
+void http_route_table_destroy(http_route_table_t *table) {
+    if (!table) return;
+    node_free(&table->root);
+    free(table);
+}
@@ -18,6 +18,7 @@
 #include <string.h>
 #include <strings.h>  /* For strcasecmp */
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <time.h>
 #include <unistd.h>
 #include <sys/wait.h>
@@ -26,6 +27,25 @@
 #include <jansson.h>
 #include <stdarg.h> /* For va_list, va_start, va_end */
 #include <signal.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "http_reactor.h"
+#include "http_route_table.h"
+#include "http_response.h"
+#include "request_arena.h"
+#include "worker_pool.h"
+#include "sse_hub.h"
+#include "latency_histogram.h"
+#include "router_reply.h"
+#include "route_request.h"
+#include "idempotency_cache.h"
+#include "admin_view_cache.h"
+#include "block_registry.h"
+#include "schema_validator.h"
+#include "pii_redactor.h"
+#include "log_pipeline.h"
+#include "log_throttle.h"
+#include "ingest_batcher.h"
 
 /* Request context available for prototypes below */
 typedef struct {
@@ -34,6 +54,12 @@ typedef struct {
     char tenant_id[64];
     char run_id[64];
     otel_span_t *otel_span;  // OpenTelemetry span for this request
+    const char *method;      // Points into the receive buffer
+    const char *path;        // Points into the receive buffer
+    const char *body;        // Points into the receive buffer (NUL-terminated)
+    size_t body_len;
+    idempotency_claim_t *idempotency;  // Open Idempotency-Key claim, answered by decide_reply
+    idempotency_claim_t *decision;     // Open decision-cache claim, answered by get_decision_reply
 } request_context_t;
 
 /* NATS status (implemented in nats_client_stub/real) */
@@ -41,129 +67,126 @@ const char *nats_get_status_string(void);
 
 /* Forward declarations to avoid implicit prototypes */
 static void log_json(const char *level, const char *subsystem, const char *message, ...);
-static json_t *filter_pii_json(json_t *obj);
-static json_t *filter_pii_json_array(json_t *arr);
 int map_router_error_status(const char *resp_json);
 
+/* Gateway event line: level, subsystem, message */
+static size_t format_gateway_event(const log_record_t *rec, char *out, size_t cap) {
+    log_line_t l = { out, cap, 0 };
+    log_line_raw(&l, "{\"timestamp\":");
+    log_line_timestamp(&l, rec->ts_us, 3);
+    log_line_raw(&l, ",\"level\":");
+    log_line_value(&l, &rec->values[0]);
+    log_line_raw(&l, ",\"component\":\"c-gateway\",\"subsystem\":");
+    log_line_value(&l, &rec->values[1]);
+    log_line_raw(&l, ",\"message\":");
+    log_line_value(&l, &rec->values[2]);
+    log_line_raw(&l, "}");
+    return log_line_end(&l);
+}
+
 static void log_json(const char *level, const char *subsystem, const char *message, ...) {
-    char log_buffer[2048] = {0};
     va_list args;
     va_start(args, message);
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    time_t now = tv.tv_sec;
-    struct tm *tm_info = gmtime(&now);
-    char timestamp[64];
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S", tm_info);
-    snprintf(timestamp + strlen(timestamp), sizeof(timestamp) - strlen(timestamp), ".%03ldZ", tv.tv_usec / 1000);
     char formatted_message[1024];
     vsnprintf(formatted_message, sizeof(formatted_message), message, args);
     va_end(args);
-    snprintf(log_buffer, sizeof(log_buffer),
-        "{\"timestamp\":\"%s\",\"level\":\"%s\",\"component\":\"c-gateway\",\"subsystem\":\"%s\",\"message\":\"%s\"}",
-        timestamp, level, subsystem, formatted_message);
-    if (strcasecmp(level, "error") == 0) {
-        fprintf(stderr, "%s\n", log_buffer);
+    log_value_t values[] = { LOG_STR(level), LOG_STR(subsystem), LOG_STR(formatted_message) };
+    int fd = strcasecmp(level, "error") == 0 ? STDERR_FILENO : STDOUT_FILENO;
+    (void)log_pipeline_write(log_pipeline_default(), fd, format_gateway_event, values, 3);
+}
+
+/* Event line from a hot path: the callsite decides whether it goes out,
+ * and the first line after a suppressed run says how long the run was */
+static void log_throttled(log_callsite_t *site, const char *subsystem, const char *message, ...) {
+    uint64_t suppressed = 0;
+    if (!log_throttle_allow(site, &suppressed)) return;
+    va_list args;
+    va_start(args, message);
+    char formatted_message[1024];
+    int len = vsnprintf(formatted_message, sizeof(formatted_message), message, args);
+    va_end(args);
+    if (suppressed > 0 && len >= 0 && (size_t)len < sizeof(formatted_message)) {
+        (void)snprintf(formatted_message + len, sizeof(formatted_message) - (size_t)len,
+                       " (suppressed %llu similar messages)", (unsigned long long)suppressed);
+    }
+    log_json(log_level_name(site->level), subsystem, "%s", formatted_message);
+}
+
+static void log_throttle_metrics(const log_callsite_t *site, log_throttle_reason_t reason) {
+    (void)site;
+    if (reason == LOG_THROTTLE_SAMPLED) {
+        metrics_record_log_sampled();
     } else {
-        fprintf(stdout, "%s\n", log_buffer);
+        metrics_record_log_rate_limited();
     }
 }
 
+static log_callsite_t log_site_rate_limiter_unavailable =
+    LOG_CALLSITE_INIT("rate_limiter_unavailable", LOG_LEVEL_WARN);
+static log_callsite_t log_site_redis_degraded =
+    LOG_CALLSITE_INIT("redis_rate_limiter_degraded", LOG_LEVEL_WARN);
+static log_callsite_t log_site_ingest_failed =
+    LOG_CALLSITE_INIT("ingest_batch_failed", LOG_LEVEL_WARN);
+
 static volatile sig_atomic_t g_terminate = 0;
-static int g_server_fd = -1;
 
 static void on_signal(int sig)
 {
     (void)sig;
     g_terminate = 1;
-    if (g_server_fd != -1) {
-        close(g_server_fd);
-        g_server_fd = -1;
-    }
 }
 
-/* ---------------- SSE clients pool (non-blocking, simple) ---------------- */
-#define SSE_MAX_CLIENTS 64
-typedef struct {
-    int fd;
-    char tenant_id[64];
-    time_t last_write;
-} sse_client_t;
-
-static sse_client_t sse_clients[SSE_MAX_CLIENTS];
-
-static void sse_init_pool(void)
-{
-    for (int i=0;i<SSE_MAX_CLIENTS;i++) { sse_clients[i].fd = -1; sse_clients[i].tenant_id[0]='\0'; sse_clients[i].last_write=0; }
-}
+/* ---------------- SSE streams (fan-out engine in sse_hub.c) ---------------- */
+static sse_hub_t *g_sse_hub = NULL;
 
-static void sse_unregister_fd(int fd)
+static int sse_start(void)
 {
-    for (int i=0;i<SSE_MAX_CLIENTS;i++) {
-        if (sse_clients[i].fd == fd) {
-            close(sse_clients[i].fd);
-            sse_clients[i].fd = -1;
-            sse_clients[i].tenant_id[0] = '\0';
-            sse_clients[i].last_write = 0;
-            break;
-        }
+    sse_hub_config_t config;
+    sse_hub_get_default_config(&config);
+    (void)sse_hub_parse_config(&config);
+    g_sse_hub = sse_hub_create(&config);
+    if (!g_sse_hub || sse_hub_start(g_sse_hub) != 0) {
+        sse_hub_destroy(g_sse_hub);
+        g_sse_hub = NULL;
+        return -1;
     }
+    return 0;
 }
 
 static int sse_register_client(int client_fd, const char *tenant_id)
 {
-    /* set non-blocking */
-    int flags = fcntl(client_fd, F_GETFL, 0);
-    if (flags != -1) (void)fcntl(client_fd, F_SETFL, flags | O_NONBLOCK);
-
-    const char *hdr =
+    /* Headers plus an initial ping/comment to flush proxies, in one write */
+    static const char preamble[] =
         "HTTP/1.1 200 OK\r\n"
         "Content-Type: text/event-stream\r\n"
         "Cache-Control: no-cache\r\n"
         "Connection: keep-alive\r\n"
-        "Access-Control-Allow-Origin: *\r\n\r\n";
-    (void)write(client_fd, hdr, strlen(hdr));
-    /* initial ping/comment to flush proxies */
-    (void)write(client_fd, ": connected\n\n", strlen(": connected\n\n"));
-
-    for (int i=0;i<SSE_MAX_CLIENTS;i++) {
-        if (sse_clients[i].fd == -1) {
-            sse_clients[i].fd = client_fd;
-            strncpy(sse_clients[i].tenant_id, tenant_id, sizeof(sse_clients[i].tenant_id)-1);
-            sse_clients[i].tenant_id[sizeof(sse_clients[i].tenant_id)-1] = '\0';
-            sse_clients[i].last_write = time(NULL);
-            return 0;
-        }
+        "Access-Control-Allow-Origin: *\r\n\r\n"
+        ": connected\n\n";
+    if (http_reactor_send_all(client_fd, preamble, sizeof(preamble) - 1U) != 0) {
+        return -1;
+    }
+
+    /* On success the hub owns the (non-blocking) socket */
+    if (sse_hub_subscribe(g_sse_hub, client_fd, tenant_id) == 0) {
+        return 0;
     }
     /* pool full */
     const char *msg = ":pool_full\n\n";
-    (void)write(client_fd, msg, strlen(msg));
+    (void)http_reactor_send_all(client_fd, msg, strlen(msg));
     return -1;
 }
 
+/* Encoded once here, shared by every subscriber of the tenant */
 static void sse_broadcast_json(const char *tenant_id, const char *event, const char *json)
 {
-    char line1[128];
-    int l1 = snprintf(line1, sizeof(line1), "event: %s\n", event);
-    for (int i=0;i<SSE_MAX_CLIENTS;i++) {
-        if (sse_clients[i].fd == -1) continue;
-        if (tenant_id && tenant_id[0] && strcmp(tenant_id, sse_clients[i].tenant_id) != 0) continue;
-        int fd = sse_clients[i].fd;
-        if (write(fd, line1, (size_t)l1) < 0) { sse_unregister_fd(fd); continue; }
-        if (write(fd, "data: ", 6) < 0) { sse_unregister_fd(fd); continue; }
-        if (write(fd, json, strlen(json)) < 0) { sse_unregister_fd(fd); continue; }
-        if (write(fd, "\n\n", 2) < 0) { sse_unregister_fd(fd); continue; }
-        sse_clients[i].last_write = time(NULL);
-    }
+    (void)sse_hub_publish(g_sse_hub, tenant_id, event, json, strlen(json));
 }
 
 static void sse_shutdown(void)
 {
-    for (int i=0;i<SSE_MAX_CLIENTS;i++) {
-        if (sse_clients[i].fd != -1) {
-            sse_unregister_fd(sse_clients[i].fd);
-        }
-    }
+    sse_hub_destroy(g_sse_hub);
+    g_sse_hub = NULL;
 }
 static const char *query_get_param(const char *path_with_query, const char *key, char *buf, size_t buflen)
 {
@@ -187,11 +210,28 @@ static const char *query_get_param(const char *path_with_query, const char *key,
     return NULL;
 }
 
+/* Whether the request being served on this reactor thread may keep its
+ * connection open; set by handle_client from the reactor's decision. */
+static _Thread_local int tls_keep_alive = 0;
+
+/* Bounded copy of a header value out of the receive buffer */
+static void copy_header_value(char *dst, size_t dst_size, const char *buf,
+                              const http_header_t *header) {
+    size_t n = header->value.len;
+    if (n > dst_size - 1U) {
+        n = dst_size - 1U;
+    }
+    memcpy(dst, buf + header->value.off, n);
+    dst[n] = '\0';
+}
+
+static http_conn_action_t response_conn_action(void) {
+    return tls_keep_alive ? HTTP_CONN_KEEP_ALIVE : HTTP_CONN_CLOSE;
+}
+
 /* Forward declarations for helpers used before their definitions */
 static void send_response(int client_fd, const char *status_line,
                           const char *content_type, const char *body);
-static void send_response_with_headers(int client_fd, const char *status_line,
-                                        const char *extra_headers, const char *body);
 static void send_error_response(int client_fd,
                                 const char *status_line,
                                 const char *error_code,
@@ -231,177 +271,40 @@ static void send_error_response_with_conflict(int client_fd,
                                               conflict_type_t conflict_type,
                                               const char *intake_error_code);
 
-/* ---------------- Extensions Registry (in-memory, CP1) ---------------- */
-typedef struct {
-    char type[128];
-    char version[64];
-    char *manifest_json; /* owned heap json string */
-} block_entry_t;
-
-#define REGISTRY_CAP 64
-static block_entry_t registry_entries[REGISTRY_CAP];
-static int registry_count = 0;
-
-static int registry_find(const char *type, const char *version)
-{
-    for (int i = 0; i < registry_count; i++) {
-        if (strcmp(registry_entries[i].type, type) == 0 && strcmp(registry_entries[i].version, version) == 0) {
-            return i;
-        }
-    }
-    return -1;
-}
-
-static int registry_upsert(const char *type, const char *version, const char *manifest_json, int *created)
-{
-    int idx = registry_find(type, version);
-    if (idx >= 0) {
-        /* update */
-        free(registry_entries[idx].manifest_json);
-        registry_entries[idx].manifest_json = strdup(manifest_json);
-        if (created) *created = 0;
-        return 0;
-    }
-    if (registry_count >= REGISTRY_CAP) return -1;
-    strncpy(registry_entries[registry_count].type, type, sizeof(registry_entries[registry_count].type)-1);
-    registry_entries[registry_count].type[sizeof(registry_entries[registry_count].type)-1] = '\0';
-    strncpy(registry_entries[registry_count].version, version, sizeof(registry_entries[registry_count].version)-1);
-    registry_entries[registry_count].version[sizeof(registry_entries[registry_count].version)-1] = '\0';
-    registry_entries[registry_count].manifest_json = strdup(manifest_json);
-    registry_count++;
-    if (created) *created = 1;
-    return 0;
-}
-
-static int registry_delete(const char *type, const char *version)
-{
-    int idx = registry_find(type, version);
-    if (idx < 0) return -1;
-    free(registry_entries[idx].manifest_json);
-    registry_entries[idx] = registry_entries[registry_count - 1];
-    registry_count--;
-    return 0;
-}
-
-/* ---------------- Strict JSON Schema validator (Draft-07 subset) in C ---------------- */
-static int is_valid_type_string(const char *s)
-{
-    static const char *allowed[] = {"object","array","string","number","integer","boolean","null"};
-    for (size_t i=0;i<sizeof(allowed)/sizeof(allowed[0]);i++) if (strcmp(s, allowed[i])==0) return 1;
-    return 0;
-}
-
-static int validate_jsonschema_node(json_t *node, int depth);
-
-static int validate_string_array(json_t *arr)
-{
-    if (!json_is_array(arr)) return 0;
-    size_t i, n = json_array_size(arr);
-    for (i=0;i<n;i++) if (!json_is_string(json_array_get(arr, i))) return 0;
-    return 1;
-}
-
-static int validate_type(json_t *type)
-{
-    if (json_is_string(type)) return is_valid_type_string(json_string_value(type));
-    if (json_is_array(type)) {
-        size_t i, n = json_array_size(type);
-        if (n==0) return 0;
-        for (i=0;i<n;i++) {
-            json_t *v = json_array_get(type, i);
-            if (!json_is_string(v) || !is_valid_type_string(json_string_value(v))) return 0;
-        }
-        return 1;
-    }
-    return 0;
-}
+/* ---------------- Extensions Registry ---------------- */
+/* Manifests by (type, version); lookups take no lock (block_registry.h) */
+static block_registry_t *g_registry = NULL;
+static const char *g_registry_snapshot_path = NULL;  /* GATEWAY_REGISTRY_SNAPSHOT_PATH */
 
-static int validate_properties(json_t *props, int depth)
+/* Rewrite the snapshot after a registry change; the change itself stands */
+static void registry_persist(void)
 {
-    if (!json_is_object(props)) return 0;
-    const char *key; json_t *val;
-    json_object_foreach(props, key, val) {
-        if (!json_is_object(val)) return 0;
-        if (!validate_jsonschema_node(val, depth+1)) return 0;
+    if (g_registry_snapshot_path == NULL) return;
+    if (block_registry_save_snapshot(g_registry, g_registry_snapshot_path) != 0) {
+        log_json("warn", "registry", "Failed to write registry snapshot %s", g_registry_snapshot_path);
     }
-    return 1;
 }
 
-static int validate_composition_array(json_t *arr, int depth)
-{
-    if (!json_is_array(arr)) return 0;
-    size_t i, n = json_array_size(arr);
-    if (n==0) return 0;
-    for (i=0;i<n;i++) {
-        json_t *v = json_array_get(arr, i);
-        if (!json_is_object(v) || !validate_jsonschema_node(v, depth+1)) return 0;
-    }
-    return 1;
-}
+/* ---------------- Block input schemas ----------------
+ *
+ * Each registry record carries its compiled schema.input as its
+ * attachment, so a decide that names a block version checks the task
+ * payload with the same lookup that finds the manifest. */
 
-static int validate_jsonschema_node(json_t *node, int depth)
+/* Records written without a program (snapshot load) compile their own */
+static void *registry_attach_validator(const block_record_t *rec, void *arg)
 {
-    if (depth > 64) return 0;
-    if (!json_is_object(node)) return 0;
-
-    /* $schema (optional) */
-    json_t *js = json_object_get(node, "$schema");
-    if (js && (!json_is_string(js) || strstr(json_string_value(js), "draft-07") == NULL)) return 0;
-
-    /* type */
-    json_t *jtype = json_object_get(node, "type");
-    if (jtype && !validate_type(jtype)) return 0;
-
-    /* properties */
-    json_t *jprops = json_object_get(node, "properties");
-    if (jprops && !validate_properties(jprops, depth)) return 0;
-
-    /* required */
-    json_t *jreq = json_object_get(node, "required");
-    if (jreq && !validate_string_array(jreq)) return 0;
-
-    /* items */
-    json_t *jitems = json_object_get(node, "items");
-    if (jitems) {
-        if (json_is_object(jitems)) { if (!validate_jsonschema_node(jitems, depth+1)) return 0; }
-        else return 0;
-    }
-
-    /* additionalProperties */
-    json_t *jaddp = json_object_get(node, "additionalProperties");
-    if (jaddp && !(json_is_boolean(jaddp) || (json_is_object(jaddp) && validate_jsonschema_node(jaddp, depth+1)))) return 0;
-
-    /* enum */
-    json_t *jenum = json_object_get(node, "enum");
-    if (jenum && !json_is_array(jenum)) return 0;
-
-    /* oneOf/anyOf/allOf */
-    json_t *jone = json_object_get(node, "oneOf");
-    if (jone && !validate_composition_array(jone, depth)) return 0;
-    json_t *jany = json_object_get(node, "anyOf");
-    if (jany && !validate_composition_array(jany, depth)) return 0;
-    json_t *jall = json_object_get(node, "allOf");
-    if (jall && !validate_composition_array(jall, depth)) return 0;
-
-    /* simple numeric/string constraints if present */
-    json_t *jmin = json_object_get(node, "minimum"); if (jmin && !json_is_number(jmin)) return 0;
-    json_t *jmax = json_object_get(node, "maximum"); if (jmax && !json_is_number(jmax)) return 0;
-    json_t *jminl = json_object_get(node, "minLength"); if (jminl && !json_is_integer(jminl)) return 0;
-    json_t *jmaxl = json_object_get(node, "maxLength"); if (jmaxl && !json_is_integer(jmaxl)) return 0;
-    json_t *jformat = json_object_get(node, "format"); if (jformat && !json_is_string(jformat)) return 0;
-    json_t *jref = json_object_get(node, "$ref"); if (jref && !json_is_string(jref)) return 0;
-
-    /* definitions/$defs can be objects; skip deep validation for brevity */
-    json_t *jdefs = json_object_get(node, "definitions"); if (jdefs && !json_is_object(jdefs)) return 0;
-    json_t *jdefs2 = json_object_get(node, "$defs"); if (jdefs2 && !json_is_object(jdefs2)) return 0;
-
-    return 1;
+    (void)arg;
+    json_t *root = json_loadb(rec->manifest, rec->manifest_len, 0, NULL);
+    schema_validator_t *v = schema_validator_compile(
+        json_object_get(json_object_get(root, "schema"), "input"), NULL, 0);
+    json_decref(root);
+    return v;
 }
 
-static int validate_jsonschemas_strict(json_t *schema_input, json_t *schema_output)
+static void registry_detach_validator(void *attachment)
 {
-    if (!json_is_object(schema_input) || !json_is_object(schema_output)) return -1;
-    return (validate_jsonschema_node(schema_input, 0) && validate_jsonschema_node(schema_output, 0)) ? 0 : -1;
+    schema_validator_free(attachment);
 }
 
 static int handle_registry_write_common(int client_fd, const char *method,
@@ -433,24 +336,40 @@ static int handle_registry_write_common(int client_fd, const char *method,
     json_t *meta = json_object_get(root, "metadata");
     if (meta && !json_is_object(meta)) { json_decref(root); send_error_response(client_fd, "HTTP/1.1 400 Bad Request","invalid_request","metadata must be object", NULL); return -1; }
 
-    /* Strict validate JSON Schema fields */
+    /* Compiling both schemas is what validates them; the input program
+     * is stored with the record */
     json_t *schema = json_object_get(root, "schema");
-    json_t *schema_input = schema ? json_object_get(schema, "input") : NULL;
-    json_t *schema_output = schema ? json_object_get(schema, "output") : NULL;
-    if (validate_jsonschemas_strict(schema_input, schema_output) != 0) {
+    char schema_err[128];
+    schema_validator_t *input_validator = schema_validator_compile(json_object_get(schema, "input"),
+                                                                   schema_err, sizeof(schema_err));
+    schema_validator_t *output_validator = input_validator == NULL ? NULL :
+        schema_validator_compile(json_object_get(schema, "output"), schema_err, sizeof(schema_err));
+    schema_validator_free(output_validator);
+    if (output_validator == NULL) {
+        schema_validator_free(input_validator);
         json_decref(root);
-        send_error_response(client_fd, "HTTP/1.1 400 Bad Request","invalid_schema","schema validation failed", NULL);
+        char msg[192];
+        snprintf(msg, sizeof(msg), "schema validation failed: %s", schema_err);
+        send_error_response(client_fd, "HTTP/1.1 400 Bad Request","invalid_schema",msg, NULL);
         return -1;
     }
 
     /* Store manifest */
     char *manifest_json = json_dumps(root, JSON_COMPACT);
     json_decref(root);
-    if (!manifest_json) { send_error_response(client_fd, "HTTP/1.1 500 Internal Server Error","internal","failed to serialize manifest", NULL); return -1; }
+    if (!manifest_json) {
+        schema_validator_free(input_validator);
+        send_error_response(client_fd, "HTTP/1.1 500 Internal Server Error","internal","failed to serialize manifest", NULL);
+        return -1;
+    }
 
-    int created = 0; int rc = registry_upsert(type, version, manifest_json, &created);
-    free(manifest_json);
-    if (rc != 0) { send_error_response(client_fd, "HTTP/1.1 500 Internal Server Error","internal","registry capacity reached", NULL); return -1; }
+    int created = 0;
+    block_registry_item_t item = { type, strlen(type), version, strlen(version),
+                                   manifest_json, strlen(manifest_json), input_validator };
+    int rc = block_registry_upsert_batch(g_registry, &item, 1, &created);
+    request_arena_scratch_free(manifest_json);
+    if (rc != 0) { send_error_response(client_fd, "HTTP/1.1 500 Internal Server Error","internal","failed to store manifest", NULL); return -1; }
+    registry_persist();
 
     /* Build response */
     char resp[256]; time_t now = time(NULL);
@@ -461,15 +380,39 @@ static int handle_registry_write_common(int client_fd, const char *method,
 
 static void handle_registry_delete(int client_fd, const char *type, const char *version)
 {
-    if (registry_delete(type, version) != 0) {
+    if (block_registry_delete(g_registry, type, strlen(type), version, strlen(version)) != 0) {
         send_error_response(client_fd, "HTTP/1.1 404 Not Found","not_found","block not found", NULL);
         return;
     }
+    registry_persist();
     char resp[256]; time_t now = time(NULL);
     snprintf(resp, sizeof(resp), "{\"status\":\"unregistered\",\"type\":\"%s\",\"version\":\"%s\",\"ts\":%ld}", type, version, (long)now);
     send_response(client_fd, "HTTP/1.1 200 OK", "application/json", resp);
 }
 
+/* The stored manifest goes out as it is, under its ETag */
+static void handle_registry_get(int client_fd, const char *type, const char *version,
+                                const char *if_none_match, size_t if_none_match_len)
+{
+    const block_record_t *rec = block_registry_get(g_registry, type, strlen(type), version, strlen(version));
+    if (!rec) {
+        send_error_response(client_fd, "HTTP/1.1 404 Not Found","not_found","block not found", NULL);
+        return;
+    }
+    http_response_t resp;
+    if (admin_view_etag_matches(rec->etag, if_none_match, if_none_match_len)) {
+        http_response_init(&resp, "HTTP/1.1 304 Not Modified");
+        http_response_add_header(&resp, "ETag", rec->etag);
+        (void)http_response_send_head(&resp, client_fd, tls_keep_alive);
+    } else {
+        http_response_init(&resp, "HTTP/1.1 200 OK");
+        http_response_add_raw(&resp, HTTP_RESPONSE_CONTENT_TYPE_JSON);
+        http_response_add_header(&resp, "ETag", rec->etag);
+        (void)http_response_send(&resp, client_fd, tls_keep_alive, rec->manifest, rec->manifest_len);
+    }
+    block_record_release(rec);
+}
+
 #define MAX_REQUEST_SIZE  65536U
 #define MAX_RESPONSE_SIZE 65536U
 
@@ -483,6 +426,7 @@ typedef enum {
     ENDPOINT_REGISTRY_POST,
     ENDPOINT_REGISTRY_PUT,
     ENDPOINT_REGISTRY_DELETE,
+    ENDPOINT_REGISTRY_GET,
     ENDPOINT_ROUTES_DECIDE_POST,
     ENDPOINT_ROUTES_DECIDE_GET,
 } endpoint_id_t;
@@ -507,12 +451,12 @@ static void send_rate_limit_error(int client_fd,
 /* Global rate limiter instance */
 static rate_limiter_t *g_rate_limiter = NULL;
 static int rl_initialized = 0;
-static const char *rl_mode = "unknown"; /* "memory" | "redis" | "fallback" */
+static const char *_Atomic rl_mode = "unknown"; /* "memory" | "redis" | "fallback"; switched by any reactor */
 
 /* Rate limiting metrics (for backward compatibility) */
-static unsigned long rl_total_hits = 0;
-static unsigned long rl_total_exceeded = 0;
-static unsigned long rl_exceeded_by_endpoint[RL_ENDPOINT_MAX] = {0};
+static _Atomic unsigned long rl_total_hits = 0;
+static _Atomic unsigned long rl_total_exceeded = 0;
+static _Atomic unsigned long rl_exceeded_by_endpoint[RL_ENDPOINT_MAX] = {0};
 
 /*
  * Minimal auth skeleton for CP1.
@@ -689,19 +633,16 @@ static int get_ttl_seconds(void) {
     return env_to_int("GATEWAY_RATE_LIMIT_TTL_SECONDS", 60);
 }
 
-static void add_rate_limit_headers(char *header_buf, size_t buf_size, 
-                                     int limit, unsigned int remaining) {
+static void add_rate_limit_headers(http_response_t *resp, int limit, unsigned int remaining) {
     time_t now = time(NULL);
     int ttl = get_ttl_seconds();
     time_t reset_at = now + ttl;
     int retry_after = ttl;
-    
-    snprintf(header_buf, buf_size,
-        "X-RateLimit-Limit: %d\r\n"
-        "X-RateLimit-Remaining: %u\r\n"
-        "X-RateLimit-Reset: %ld\r\n"
-        "Retry-After: %d\r\n",
-        limit, remaining, (long)reset_at, retry_after);
+
+    http_response_add_uint(resp, "X-RateLimit-Limit", limit > 0 ? (uint64_t)limit : 0U);
+    http_response_add_uint(resp, "X-RateLimit-Remaining", remaining);
+    http_response_add_uint(resp, "X-RateLimit-Reset", reset_at > 0 ? (uint64_t)reset_at : 0U);
+    http_response_add_uint(resp, "Retry-After", retry_after > 0 ? (uint64_t)retry_after : 0U);
 }
 
 /* Check rate limit using rate_limiter API (CP1/CP2+ compatible) */
@@ -711,7 +652,8 @@ static int rate_limit_check(rl_endpoint_id_t endpoint, const char *tenant_id, co
     
     if (!g_rate_limiter || !g_rate_limiter->check) {
         /* Fallback: allow request if rate limiter unavailable */
-        fprintf(stderr, "WARNING: Rate limiter unavailable, allowing request\n");
+        log_throttled(&log_site_rate_limiter_unavailable, "rate_limit",
+                      "Rate limiter unavailable, allowing request");
         if (remaining_out) *remaining_out = 0;
         return 0;
     }
@@ -747,10 +689,10 @@ static int rate_limit_check(rl_endpoint_id_t endpoint, const char *tenant_id, co
             
             if (fallback_enabled) {
                 /* Track fallback usage */
-                static unsigned long fallback_count = 0;
-                fallback_count++;
-                if (fallback_count == 1 || (fallback_count % 100) == 0) {
-                    fprintf(stderr, "INFO: Fallback to local mode enabled, allowing request (fallback count: %lu)\n", fallback_count);
+                static _Atomic unsigned long fallback_count = 0;
+                unsigned long fallback_seen = ++fallback_count;
+                if (fallback_seen == 1 || (fallback_seen % 100) == 0) {
+                    fprintf(stderr, "INFO: Fallback to local mode enabled, allowing request (fallback count: %lu)\n", fallback_seen);
                 }
                 
                 /* Update mode if not already in fallback */
@@ -797,12 +739,13 @@ static int rate_limit_check_routes_decide(int client_fd, const request_context_t
 static void get_iso8601_timestamp(char *buf, size_t buflen)
 {
     struct timeval tv;
+    struct tm tm_buf;
     struct tm *tm_info;
     time_t now;
     
     gettimeofday(&tv, NULL);
     now = tv.tv_sec;
-    tm_info = gmtime(&now);
+    tm_info = gmtime_r(&now, &tm_buf);
     
     if (tm_info != NULL && buflen >= 32)
     {
@@ -821,156 +764,87 @@ static void get_iso8601_timestamp(char *buf, size_t buflen)
     }
 }
 
-/* Check if field name is sensitive (case-insensitive) */
-static int is_sensitive_field(const char *field_name)
+/* ---------------- PII redaction (engine in pii_redactor.c) ---------------- */
+
+/* Members whose values never reach a log line (case-insensitive) */
+static const char *const pii_fields[] = {
+    "password", "api_key", "secret", "token", "access_token",
+    "refresh_token", "authorization", "credit_card", "ssn", "email", "phone",
+    /* Header-like fields (case variations) */
+    "bearer", "x-api-key", "x-auth-token", "x-authorization"
+};
+
+/* Messages mentioning any of these are replaced whole */
+static const char *const pii_keywords[] = {
+    "password", "api_key", "secret", "token", "access_token",
+    "refresh_token", "authorization", "credit_card", "ssn", "email", "phone"
+};
+
+static pii_redactor_t *g_pii_fields = NULL;
+static pii_redactor_t *g_pii_keywords = NULL;
+static pthread_once_t g_pii_once = PTHREAD_ONCE_INIT;
+
+static void pii_init(void)
 {
-    if (field_name == NULL) return 0;
-    
-    /* List of sensitive field names to filter */
-    const char *sensitive_fields[] = {
-        "password", "api_key", "secret", "token", "access_token",
-        "refresh_token", "authorization", "credit_card", "ssn", "email", "phone",
-        /* Header-like fields (case variations) */
-        "bearer", "x-api-key", "x-auth-token", "x-authorization"
-    };
-    size_t num_fields = sizeof(sensitive_fields) / sizeof(sensitive_fields[0]);
-    
-    /* Case-insensitive comparison */
-    for (size_t i = 0; i < num_fields; i++)
-    {
-        if (strcasecmp(field_name, sensitive_fields[i]) == 0)
-        {
-            return 1;
-        }
-    }
-    
-    return 0;
+    g_pii_fields = pii_redactor_create(pii_fields, sizeof(pii_fields) / sizeof(pii_fields[0]),
+                                       PII_MATCH_EXACT, "\"[REDACTED]\"");
+    g_pii_keywords = pii_redactor_create(pii_keywords, sizeof(pii_keywords) / sizeof(pii_keywords[0]),
+                                         PII_MATCH_CONTAINS, "\"[REDACTED]\"");
 }
 
-/* Filter PII/sensitive data from string (simple keyword-based filtering for messages) */
-static void filter_pii(const char *input, char *output, size_t outlen)
+/* Append a message, replaced whole if it mentions a sensitive keyword */
+static void put_message(log_line_t *l, const char *message, size_t len)
 {
-    if (input == NULL || output == NULL || outlen == 0)
-    {
-        if (output && outlen > 0) output[0] = '\0';
-        return;
-    }
-    
-    /* List of sensitive keywords to filter */
-    const char *sensitive_keywords[] = {
-        "password", "api_key", "secret", "token", "access_token",
-        "refresh_token", "authorization", "credit_card", "ssn", "email", "phone"
-    };
-    size_t num_keywords = sizeof(sensitive_keywords) / sizeof(sensitive_keywords[0]);
-    
-    /* Simple check: if input contains any sensitive keyword, mask it */
-    int should_mask = 0;
-    for (size_t i = 0; i < num_keywords; i++)
-    {
-        if (strstr(input, sensitive_keywords[i]) != NULL)
-        {
-            should_mask = 1;
-            break;
-        }
-    }
-    
-    if (should_mask)
+    if (g_pii_keywords == NULL || pii_redactor_matches(g_pii_keywords, message, len))
     {
-        snprintf(output, outlen, "[REDACTED]");
+        log_line_raw(l, "\"[REDACTED]\"");
     }
     else
     {
-        strncpy(output, input, outlen - 1);
-        output[outlen - 1] = '\0';
+        log_line_str(l, message, len);
     }
 }
 
-/* Filter PII from JSON array recursively */
-static json_t *filter_pii_json_array(json_t *arr)
+/* Append *sep "name":value unless the value is an empty string or null */
+static void put_optional(log_line_t *l, const char **sep, const char *name, const log_value_t *v)
 {
-    if (!json_is_array(arr)) return arr;
-    
-    json_t *filtered = json_array();
-    if (filtered == NULL) return arr;
-    
-    size_t index;
-    json_t *value;
-    json_array_foreach(arr, index, value)
-    {
-        if (json_is_object(value))
-        {
-            /* filter_pii_json returns new object, use append_new to transfer ownership */
-            json_t *filtered_value = filter_pii_json(value);
-            json_array_append_new(filtered, filtered_value);
-        }
-        else if (json_is_array(value))
-        {
-            /* filter_pii_json_array returns new array, use append_new to transfer ownership */
-            json_t *filtered_value = filter_pii_json_array(value);
-            json_array_append_new(filtered, filtered_value);
-        }
-        else
-        {
-            /* For primitive values, use append (no ownership transfer) */
-            json_array_append(filtered, value);
-        }
-    }
-    
-    return filtered;
+    if (v->kind == LOG_VALUE_NULL || (v->kind == LOG_VALUE_STR && v->len == 0)) return;
+    log_line_raw(l, *sep);
+    log_line_raw(l, "\"");
+    log_line_raw(l, name);
+    log_line_raw(l, "\":");
+    log_line_value(l, v);
+    *sep = ",";
 }
 
-/* Filter PII from JSON object recursively */
-static json_t *filter_pii_json(json_t *obj)
+/* Close a log entry, masking the values of sensitive members in place */
+static size_t finish_entry(log_line_t *l)
 {
-    if (obj == NULL) return NULL;
-    
-    /* If not an object, return as-is (or filter array) */
-    if (!json_is_object(obj))
-    {
-        if (json_is_array(obj))
-        {
-            return filter_pii_json_array(obj);
-        }
-        return obj;
-    }
-    
-    /* Create new filtered object */
-    json_t *filtered = json_object();
-    if (filtered == NULL) return obj;
-    
-    const char *key;
-    json_t *value;
-    
-    json_object_foreach(obj, key, value)
+    size_t len = log_line_end(l);
+    size_t n = 0;
+    if (len == 0 || g_pii_fields == NULL ||
+        pii_redact_in_place(g_pii_fields, l->buf, len, l->cap, &n) != 0)
     {
-        /* Check if field name is sensitive */
-        if (is_sensitive_field(key))
-        {
-            /* Replace sensitive field with [REDACTED] */
-            json_object_set_new(filtered, key, json_string("[REDACTED]"));
-        }
-        else if (json_is_object(value))
-        {
-            /* Recursively filter nested objects */
-            json_t *filtered_value = filter_pii_json(value);
-            /* Use set_new to transfer ownership of the new filtered object */
-            json_object_set_new(filtered, key, filtered_value);
-        }
-        else if (json_is_array(value))
-        {
-            /* Recursively filter arrays */
-            json_t *filtered_value = filter_pii_json_array(value);
-            /* Use set_new to transfer ownership of the new filtered array */
-            json_object_set_new(filtered, key, filtered_value);
-        }
-        else
-        {
-            /* Copy non-sensitive fields as-is */
-            json_object_set(filtered, key, value);
-        }
+        return 0;
     }
-    
-    return filtered;
+    return n;
+}
+
+/* Correlation ids of a log entry record, in this order ("" when absent) */
+enum { ENTRY_TENANT, ENTRY_RUN, ENTRY_TRACE, ENTRY_REQUEST, ENTRY_IDS };
+
+static void entry_ids(const request_context_t *ctx, log_value_t *ids)
+{
+    ids[ENTRY_TENANT] = LOG_STR(ctx != NULL ? ctx->tenant_id : "");
+    ids[ENTRY_RUN] = LOG_STR(ctx != NULL ? ctx->run_id : "");
+    ids[ENTRY_TRACE] = LOG_STR(ctx != NULL ? ctx->trace_id : "");
+    ids[ENTRY_REQUEST] = LOG_STR(ctx != NULL ? ctx->request_id : "");
+}
+
+/* Queue a log entry for stderr; the formatter runs on the log thread */
+static void write_entry(log_format_fn format, const log_value_t *values, size_t count)
+{
+    (void)log_pipeline_write(log_pipeline_default(), STDERR_FILENO, format, values, count);
 }
 
 /* Conflict contract error types */
@@ -1015,6 +889,63 @@ static void __attribute__((unused)) log_error(const char *stage,
                                   CONFLICT_TYPE_INTERNAL_GATEWAY, NULL, 0);
 }
 
+/* Conflict entry record: the ids, then these */
+enum {
+    CONFLICT_SEVERITY = ENTRY_IDS, CONFLICT_SUBSYSTEM, CONFLICT_MESSAGE, CONFLICT_ERROR_TYPE,
+    CONFLICT_HTTP_STATUS, CONFLICT_CODE, CONFLICT_INTAKE, CONFLICT_PRIORITY, CONFLICT_STAGE,
+    CONFLICT_VALUES
+};
+
+static size_t format_conflict_entry(const log_record_t *rec, char *out, size_t cap)
+{
+    pthread_once(&g_pii_once, pii_init);
+    const log_value_t *v = rec->values;
+    log_line_t l = { out, cap, 0 };
+    log_line_raw(&l, "{\"timestamp\":");
+    log_line_timestamp(&l, rec->ts_us, 6);
+    log_line_raw(&l, ",\"level\":");
+    log_line_value(&l, &v[CONFLICT_SEVERITY]);
+    log_line_raw(&l, ",\"component\":\"c-gateway\",\"subsystem\":");
+    log_line_value(&l, &v[CONFLICT_SUBSYSTEM]);
+    log_line_raw(&l, ",\"message\":");
+    put_message(&l, v[CONFLICT_MESSAGE].str, v[CONFLICT_MESSAGE].len);
+
+    /* Conflict contract fields */
+    log_line_raw(&l, ",\"severity\":");
+    log_line_value(&l, &v[CONFLICT_SEVERITY]);
+    log_line_raw(&l, ",\"error_type\":");
+    log_line_value(&l, &v[CONFLICT_ERROR_TYPE]);
+    log_line_raw(&l, ",\"http_status\":");
+    log_line_value(&l, &v[CONFLICT_HTTP_STATUS]);
+    log_line_raw(&l, ",\"gateway_error_code\":");
+    if (v[CONFLICT_CODE].kind == LOG_VALUE_STR)
+    {
+        log_line_value(&l, &v[CONFLICT_CODE]);
+    }
+    else
+    {
+        log_line_raw(&l, "\"internal\"");
+    }
+    log_line_raw(&l, ",\"intake_error_code\":");
+    log_line_value(&l, &v[CONFLICT_INTAKE]);
+    log_line_raw(&l, ",\"conflict_priority_level\":");
+    log_line_value(&l, &v[CONFLICT_PRIORITY]);
+    const char *sep = ",";
+    put_optional(&l, &sep, "tenant_id", &v[ENTRY_TENANT]);
+    put_optional(&l, &sep, "run_id", &v[ENTRY_RUN]);
+    put_optional(&l, &sep, "trace_id", &v[ENTRY_TRACE]);
+    put_optional(&l, &sep, "request_id", &v[ENTRY_REQUEST]);
+
+    /* Context object */
+    log_line_raw(&l, ",\"context\":{");
+    sep = "";
+    put_optional(&l, &sep, "stage", &v[CONFLICT_STAGE]);
+    put_optional(&l, &sep, "error_code", &v[CONFLICT_CODE]);
+    put_optional(&l, &sep, "request_id", &v[ENTRY_REQUEST]);
+    log_line_raw(&l, "}}");
+    return finish_entry(&l);
+}
+
 /* Enhanced log_error with conflict contract fields */
 static void log_error_with_conflict_info(const char *stage,
                                          const request_context_t *ctx,
@@ -1024,108 +955,32 @@ static void log_error_with_conflict_info(const char *stage,
                                          const char *intake_error_code,
                                          int http_status)
 {
-    char timestamp[32];
-    get_iso8601_timestamp(timestamp, sizeof(timestamp));
-    
-    const char *rid = (ctx != NULL && ctx->request_id[0] != '\0')
-                          ? ctx->request_id
-                          : "";
-    const char *tid = (ctx != NULL && ctx->trace_id[0] != '\0')
-                          ? ctx->trace_id
-                          : "";
-    const char *ten = (ctx != NULL && ctx->tenant_id[0] != '\0')
-                          ? ctx->tenant_id
-                          : "";
-    const char *run = (ctx != NULL && ctx->run_id[0] != '\0')
-                          ? ctx->run_id
-                          : "";
-    
-    char filtered_message[512];
-    filter_pii(message, filtered_message, sizeof(filtered_message));
-
-    /* Build JSON log entry using jansson */
-    json_t *log_entry = json_object();
-    if (log_entry == NULL) return;
-    
-    json_object_set_new(log_entry, "timestamp", json_string(timestamp));
-    json_object_set_new(log_entry, "level", json_string(get_severity_from_type(conflict_type)));
-    json_object_set_new(log_entry, "component", json_string("c-gateway"));
-    json_object_set_new(log_entry, "subsystem", json_string(stage ? stage : "http_response"));
-    json_object_set_new(log_entry, "message", json_string(filtered_message));
-    
-    /* Conflict contract fields */
-    json_object_set_new(log_entry, "severity", json_string(get_severity_from_type(conflict_type)));
-    json_object_set_new(log_entry, "error_type", json_string(get_error_type_string(conflict_type)));
-    json_object_set_new(log_entry, "http_status", json_integer(http_status));
-    json_object_set_new(log_entry, "gateway_error_code", json_string(code ? code : "internal"));
-    json_object_set_new(log_entry, "intake_error_code", 
-                        intake_error_code ? json_string(intake_error_code) : json_null());
-    json_object_set_new(log_entry, "conflict_priority_level", json_integer((int)conflict_type));
-    
-    if (ten[0] != '\0')
-    {
-        json_object_set_new(log_entry, "tenant_id", json_string(ten));
-    }
-    if (run[0] != '\0')
-    {
-        json_object_set_new(log_entry, "run_id", json_string(run));
-    }
-    if (tid[0] != '\0')
-    {
-        json_object_set_new(log_entry, "trace_id", json_string(tid));
-    }
-    if (rid[0] != '\0')
-    {
-        json_object_set_new(log_entry, "request_id", json_string(rid));
-    }
-    
-    /* Build context object */
-    json_t *context = json_object();
-    if (context != NULL)
-    {
-        if (stage != NULL)
-        {
-            json_object_set_new(context, "stage", json_string(stage));
-        }
-        if (code != NULL)
-        {
-            json_object_set_new(context, "error_code", json_string(code));
-        }
-        if (rid[0] != '\0')
-        {
-            json_object_set_new(context, "request_id", json_string(rid));
-        }
-        
-        /* Filter PII from context before adding to log entry */
-        json_t *filtered_context = filter_pii_json(context);
-        json_object_set_new(log_entry, "context", filtered_context);
-        json_decref(context); /* Free original context */
-    }
-    
-    /* Output JSON log */
-    char *json_str = json_dumps(log_entry, JSON_COMPACT);
-    if (json_str != NULL)
-    {
-        fprintf(stderr, "%s\n", json_str);
-        free(json_str);
-    }
-    
-    json_decref(log_entry);
+    log_value_t values[CONFLICT_VALUES];
+    entry_ids(ctx, values);
+    values[CONFLICT_SEVERITY] = LOG_STR(get_severity_from_type(conflict_type));
+    values[CONFLICT_SUBSYSTEM] = LOG_STR(stage ? stage : "http_response");
+    values[CONFLICT_MESSAGE] = LOG_STR(message ? message : "");
+    values[CONFLICT_ERROR_TYPE] = LOG_STR(get_error_type_string(conflict_type));
+    values[CONFLICT_HTTP_STATUS] = LOG_INT(http_status);
+    values[CONFLICT_CODE] = LOG_STR(code);
+    values[CONFLICT_INTAKE] = LOG_STR(intake_error_code);
+    values[CONFLICT_PRIORITY] = LOG_INT((int)conflict_type);
+    values[CONFLICT_STAGE] = LOG_STR(stage);
+    write_entry(format_conflict_entry, values, CONFLICT_VALUES);
 }
 
-static unsigned long metric_requests_total        = 0UL;
-static unsigned long metric_requests_errors_total = 0UL;
-static unsigned long metric_requests_errors_4xx   = 0UL;
-static unsigned long metric_requests_errors_5xx   = 0UL;
+static _Atomic unsigned long metric_requests_total        = 0UL;
+static _Atomic unsigned long metric_requests_errors_total = 0UL;
+static _Atomic unsigned long metric_requests_errors_4xx   = 0UL;
+static _Atomic unsigned long metric_requests_errors_5xx   = 0UL;
 
-static unsigned long metric_requests_routes_decide_post = 0UL;
-static unsigned long metric_requests_routes_decide_get  = 0UL;
+static _Atomic unsigned long metric_requests_routes_decide_post = 0UL;
+static _Atomic unsigned long metric_requests_routes_decide_get  = 0UL;
 
 static void send_rate_limit_error(int client_fd,
                                   rl_endpoint_id_t endpoint,
                                   const request_context_t *ctx)
 {
-    char headers[512];
     char body[MAX_RESPONSE_SIZE];
     
     /* Get current rate limit info */
@@ -1138,9 +993,6 @@ static void send_rate_limit_error(int client_fd,
     /* Conflict Contract: Priority 1 - Rate Limiting (RL) */
     /* error_type: rate_limit, conflict_priority_level: 1, intake_error_code: null */
     
-    /* Add rate limit headers */
-    add_rate_limit_headers(headers, sizeof(headers), limit, remaining);
-    
     /* Get endpoint name for error details */
     const char *endpoint_name = "unknown";
     switch (endpoint) {
@@ -1196,22 +1048,11 @@ static void send_rate_limit_error(int client_fd,
                                   CONFLICT_TYPE_RATE_LIMIT, NULL, 429);
     
     /* Send response with rate limit headers */
-    char full_response[MAX_RESPONSE_SIZE + 512];
-    len = snprintf(full_response, sizeof(full_response),
-                   "HTTP/1.1 429 Too Many Requests\r\n"
-                   "Content-Type: application/json\r\n"
-                   "Content-Length: %zu\r\n"
-                   "%s"  /* Rate limit headers */
-                   "\r\n"
-                   "%s",
-                   strlen(body), headers, body);
-    
-    if (len < 0 || (size_t)len >= sizeof(full_response)) {
-        /* Fallback if full response formatting fails */
-        send_response(client_fd, "HTTP/1.1 429 Too Many Requests", "application/json", body);
-    } else {
-        (void)write(client_fd, full_response, strlen(full_response));
-    }
+    http_response_t resp;
+    http_response_init(&resp, "HTTP/1.1 429 Too Many Requests");
+    http_response_add_raw(&resp, HTTP_RESPONSE_CONTENT_TYPE_JSON);
+    add_rate_limit_headers(&resp, limit, remaining);
+    (void)http_response_send(&resp, client_fd, tls_keep_alive, body, (size_t)len);
     
     /* Increment error metric */
     metric_requests_errors_total++;
@@ -1220,337 +1061,176 @@ static void send_rate_limit_error(int client_fd,
     metrics_record_rate_limit_hit(ctx != NULL ? ctx->tenant_id : NULL);
 }
 
-/* Simple latency ring buffer to estimate percentiles */
-#define LAT_BUF_SIZE 256
-static int latency_buf[LAT_BUF_SIZE];
-static int latency_count = 0;
-static int latency_index = 0;
-
-static void record_latency_ms(int ms)
-{
-    if (ms < 0) ms = 0;
-    latency_buf[latency_index] = ms;
-    latency_index = (latency_index + 1) % LAT_BUF_SIZE;
-    if (latency_count < LAT_BUF_SIZE) latency_count++;
-}
+/* Request latencies, recorded lock-free per thread (latency_histogram.c) */
+#define LATENCY_WINDOW_1M_MS 60000
+#define LATENCY_WINDOW_5M_MS 300000
+static latency_histogram_t *g_latency = NULL;
 
-static int cmp_int(const void *a, const void *b)
+/* Wall-clock microseconds since start (clock() is process CPU time and
+ * is meaningless once several reactor threads serve requests) */
+static uint64_t elapsed_us_since(const struct timeval *start)
 {
-    int ia = *(const int *)a;
-    int ib = *(const int *)b;
-    return (ia > ib) - (ia < ib);
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    long long us = ((long long)now.tv_sec - (long long)start->tv_sec) * 1000000LL +
+                   ((long long)now.tv_usec - (long long)start->tv_usec);
+    return us < 0 ? 0U : (uint64_t)us;
 }
 
-static int percentile_ms(int p)
+/* Records the request and returns its latency in milliseconds */
+static int record_latency_since(const struct timeval *start)
 {
-    if (latency_count == 0) return -1;
-    int n = latency_count;
-    int tmp[LAT_BUF_SIZE];
-    for (int i = 0; i < n; i++) tmp[i] = latency_buf[i];
-    qsort(tmp, (size_t)n, sizeof(int), cmp_int);
-    int idx = (p * (n - 1)) / 100; /* nearest-rank */
-    if (idx < 0) idx = 0; if (idx >= n) idx = n - 1;
-    return tmp[idx];
+    uint64_t us = elapsed_us_since(start);
+    latency_histogram_record(g_latency, us);
+    return (int)(us / 1000U);
 }
 
 /* crude RPS since start */
 static time_t start_time_sec = 0;
 
-static void log_info(const char *stage,
-                     const request_context_t *ctx,
-                     const char *method,
-                     const char *path,
-                     int status_code,
-                     int latency_ms)
+/* Request entry record: the ids, then these */
+enum {
+    REQUEST_STAGE = ENTRY_IDS, REQUEST_METHOD, REQUEST_PATH, REQUEST_STATUS, REQUEST_LATENCY,
+    REQUEST_VALUES
+};
+
+static size_t format_request_entry(const log_record_t *rec, char *out, size_t cap)
 {
-    char timestamp[32];
-    get_iso8601_timestamp(timestamp, sizeof(timestamp));
-    
-    const char *rid = (ctx != NULL && ctx->request_id[0] != '\0')
-                          ? ctx->request_id
-                          : "";
-    const char *tid = (ctx != NULL && ctx->trace_id[0] != '\0')
-                          ? ctx->trace_id
-                          : "";
-    const char *ten = (ctx != NULL && ctx->tenant_id[0] != '\0')
-                          ? ctx->tenant_id
-                          : "";
-    const char *run = (ctx != NULL && ctx->run_id[0] != '\0')
-                          ? ctx->run_id
-                          : "";
-    
+    pthread_once(&g_pii_once, pii_init);
+    const log_value_t *v = rec->values;
+
     /* Build message based on stage */
     char message[256];
-    if (stage != NULL && strcmp(stage, "http_request") == 0)
+    int message_len;
+    if (v[REQUEST_STAGE].kind == LOG_VALUE_STR && strcmp(v[REQUEST_STAGE].str, "http_request") == 0)
     {
-        snprintf(message, sizeof(message), "Request processed successfully");
+        message_len = snprintf(message, sizeof(message), "Request processed successfully");
     }
     else
     {
-        snprintf(message, sizeof(message), "%s completed", stage != NULL ? stage : "operation");
-    }
-    
-    /* Filter message for PII */
-    char filtered_message[512];
-    filter_pii(message, filtered_message, sizeof(filtered_message));
+        message_len = snprintf(message, sizeof(message), "%s completed",
+                               v[REQUEST_STAGE].kind == LOG_VALUE_STR ? v[REQUEST_STAGE].str : "operation");
+    }
+    if (message_len < 0) return 0;
+    if ((size_t)message_len >= sizeof(message)) message_len = (int)sizeof(message) - 1;
+
+    log_line_t l = { out, cap, 0 };
+    log_line_raw(&l, "{\"timestamp\":");
+    log_line_timestamp(&l, rec->ts_us, 6);
+    log_line_raw(&l, ",\"level\":\"INFO\",\"component\":\"gateway\",\"message\":");
+    put_message(&l, message, (size_t)message_len);
+    const char *sep = ",";
+    put_optional(&l, &sep, "tenant_id", &v[ENTRY_TENANT]);
+    put_optional(&l, &sep, "run_id", &v[ENTRY_RUN]);
+    put_optional(&l, &sep, "trace_id", &v[ENTRY_TRACE]);
+    log_line_raw(&l, ",\"latency_ms\":");
+    log_line_value(&l, &v[REQUEST_LATENCY]);
+
+    /* Context object */
+    log_line_raw(&l, ",\"context\":{");
+    sep = "";
+    put_optional(&l, &sep, "stage", &v[REQUEST_STAGE]);
+    put_optional(&l, &sep, "method", &v[REQUEST_METHOD]);
+    put_optional(&l, &sep, "path", &v[REQUEST_PATH]);
+    put_optional(&l, &sep, "status_code", &v[REQUEST_STATUS]);
+    put_optional(&l, &sep, "request_id", &v[ENTRY_REQUEST]);
+    log_line_raw(&l, "}}");
+    return finish_entry(&l);
+}
 
-    /* Build JSON log entry using jansson */
-    json_t *log_entry = json_object();
-    if (log_entry == NULL) return;
-    
-    json_object_set_new(log_entry, "timestamp", json_string(timestamp));
-    json_object_set_new(log_entry, "level", json_string("INFO"));
-    json_object_set_new(log_entry, "component", json_string("gateway"));
-    json_object_set_new(log_entry, "message", json_string(filtered_message));
-    
-    if (ten[0] != '\0')
-    {
-        json_object_set_new(log_entry, "tenant_id", json_string(ten));
-    }
-    if (run[0] != '\0')
-    {
-        json_object_set_new(log_entry, "run_id", json_string(run));
-    }
-    if (tid[0] != '\0')
-    {
-        json_object_set_new(log_entry, "trace_id", json_string(tid));
-    }
-    
-    json_object_set_new(log_entry, "latency_ms", json_integer(latency_ms));
-    
-    /* Build context object */
-    json_t *context = json_object();
-    if (context != NULL)
-    {
-        if (stage != NULL)
-        {
-            json_object_set_new(context, "stage", json_string(stage));
-        }
-        if (method != NULL)
-        {
-            json_object_set_new(context, "method", json_string(method));
-        }
-        if (path != NULL)
-        {
-            json_object_set_new(context, "path", json_string(path));
-        }
-        json_object_set_new(context, "status_code", json_integer(status_code));
-        if (rid[0] != '\0')
-        {
-            json_object_set_new(context, "request_id", json_string(rid));
-        }
-        
-        /* Filter PII from context before adding to log entry */
-        json_t *filtered_context = filter_pii_json(context);
-        json_object_set_new(log_entry, "context", filtered_context);
-        json_decref(context); /* Free original context */
-    }
-    
-    /* Output JSON log */
-    char *json_str = json_dumps(log_entry, JSON_COMPACT);
-    if (json_str != NULL)
-    {
-        fprintf(stderr, "%s\n", json_str);
-        free(json_str);
-    }
-    
-    json_decref(log_entry);
+static void log_info(const char *stage,
+                     const request_context_t *ctx,
+                     const char *method,
+                     const char *path,
+                     int status_code,
+                     int latency_ms)
+{
+    log_value_t values[REQUEST_VALUES];
+    entry_ids(ctx, values);
+    values[REQUEST_STAGE] = LOG_STR(stage);
+    values[REQUEST_METHOD] = LOG_STR(method);
+    values[REQUEST_PATH] = LOG_STR(path);
+    values[REQUEST_STATUS] = LOG_INT(status_code);
+    values[REQUEST_LATENCY] = LOG_INT(latency_ms);
+    write_entry(format_request_entry, values, REQUEST_VALUES);
+}
+
+/* Stage entry record (log_warn, log_debug): the ids, then these */
+enum { STAGE_LEVEL = ENTRY_IDS, STAGE_NAME, STAGE_MESSAGE, STAGE_VALUES };
+
+static size_t format_stage_entry(const log_record_t *rec, char *out, size_t cap)
+{
+    pthread_once(&g_pii_once, pii_init);
+    const log_value_t *v = rec->values;
+    log_line_t l = { out, cap, 0 };
+    log_line_raw(&l, "{\"timestamp\":");
+    log_line_timestamp(&l, rec->ts_us, 6);
+    log_line_raw(&l, ",\"level\":");
+    log_line_value(&l, &v[STAGE_LEVEL]);
+    log_line_raw(&l, ",\"component\":\"gateway\",\"message\":");
+    put_message(&l, v[STAGE_MESSAGE].str, v[STAGE_MESSAGE].len);
+    const char *sep = ",";
+    put_optional(&l, &sep, "tenant_id", &v[ENTRY_TENANT]);
+    put_optional(&l, &sep, "run_id", &v[ENTRY_RUN]);
+    put_optional(&l, &sep, "trace_id", &v[ENTRY_TRACE]);
+
+    /* Context object */
+    log_line_raw(&l, ",\"context\":{");
+    sep = "";
+    put_optional(&l, &sep, "stage", &v[STAGE_NAME]);
+    put_optional(&l, &sep, "request_id", &v[ENTRY_REQUEST]);
+    log_line_raw(&l, "}}");
+    return finish_entry(&l);
+}
+
+static void log_stage(const char *level,
+                      const char *stage,
+                      const request_context_t *ctx,
+                      const char *message)
+{
+    log_value_t values[STAGE_VALUES];
+    entry_ids(ctx, values);
+    values[STAGE_LEVEL] = LOG_STR(level);
+    values[STAGE_NAME] = LOG_STR(stage);
+    values[STAGE_MESSAGE] = LOG_STR(message ? message : "");
+    write_entry(format_stage_entry, values, STAGE_VALUES);
 }
 
 static void __attribute__((unused)) log_warn(const char *stage,
                      const request_context_t *ctx,
                      const char *message)
 {
-    char timestamp[32];
-    get_iso8601_timestamp(timestamp, sizeof(timestamp));
-    
-    const char *rid = (ctx != NULL && ctx->request_id[0] != '\0')
-                          ? ctx->request_id
-                          : "";
-    const char *tid = (ctx != NULL && ctx->trace_id[0] != '\0')
-                          ? ctx->trace_id
-                          : "";
-    const char *ten = (ctx != NULL && ctx->tenant_id[0] != '\0')
-                          ? ctx->tenant_id
-                          : "";
-    const char *run = (ctx != NULL && ctx->run_id[0] != '\0')
-                          ? ctx->run_id
-                          : "";
-    
-    char filtered_message[512];
-    filter_pii(message, filtered_message, sizeof(filtered_message));
-
-    /* Build JSON log entry using jansson */
-    json_t *log_entry = json_object();
-    if (log_entry == NULL) return;
-    
-    json_object_set_new(log_entry, "timestamp", json_string(timestamp));
-    json_object_set_new(log_entry, "level", json_string("WARN"));
-    json_object_set_new(log_entry, "component", json_string("gateway"));
-    json_object_set_new(log_entry, "message", json_string(filtered_message));
-    
-    if (ten[0] != '\0')
-    {
-        json_object_set_new(log_entry, "tenant_id", json_string(ten));
-    }
-    if (run[0] != '\0')
-    {
-        json_object_set_new(log_entry, "run_id", json_string(run));
-    }
-    if (tid[0] != '\0')
-    {
-        json_object_set_new(log_entry, "trace_id", json_string(tid));
-    }
-    
-    /* Build context object */
-    json_t *context = json_object();
-    if (context != NULL)
-    {
-        if (stage != NULL)
-        {
-            json_object_set_new(context, "stage", json_string(stage));
-        }
-        if (rid[0] != '\0')
-        {
-            json_object_set_new(context, "request_id", json_string(rid));
-        }
-        
-        /* Filter PII from context before adding to log entry */
-        json_t *filtered_context = filter_pii_json(context);
-        json_object_set_new(log_entry, "context", filtered_context);
-        json_decref(context); /* Free original context */
-    }
-    
-    /* Output JSON log */
-    char *json_str = json_dumps(log_entry, JSON_COMPACT);
-    if (json_str != NULL)
-    {
-        fprintf(stderr, "%s\n", json_str);
-        free(json_str);
-    }
-    
-    json_decref(log_entry);
+    log_stage("WARN", stage, ctx, message);
 }
 
 static void __attribute__((unused)) log_debug(const char *stage,
                       const request_context_t *ctx,
                       const char *message)
 {
-    char timestamp[32];
-    get_iso8601_timestamp(timestamp, sizeof(timestamp));
-    
-    const char *rid = (ctx != NULL && ctx->request_id[0] != '\0')
-                          ? ctx->request_id
-                          : "";
-    const char *tid = (ctx != NULL && ctx->trace_id[0] != '\0')
-                          ? ctx->trace_id
-                          : "";
-    const char *ten = (ctx != NULL && ctx->tenant_id[0] != '\0')
-                          ? ctx->tenant_id
-                          : "";
-    const char *run = (ctx != NULL && ctx->run_id[0] != '\0')
-                          ? ctx->run_id
-                          : "";
-    
-    char filtered_message[512];
-    filter_pii(message, filtered_message, sizeof(filtered_message));
-
-    /* Build JSON log entry using jansson */
-    json_t *log_entry = json_object();
-    if (log_entry == NULL) return;
-    
-    json_object_set_new(log_entry, "timestamp", json_string(timestamp));
-    json_object_set_new(log_entry, "level", json_string("DEBUG"));
-    json_object_set_new(log_entry, "component", json_string("gateway"));
-    json_object_set_new(log_entry, "message", json_string(filtered_message));
-    
-    if (ten[0] != '\0')
-    {
-        json_object_set_new(log_entry, "tenant_id", json_string(ten));
-    }
-    if (run[0] != '\0')
-    {
-        json_object_set_new(log_entry, "run_id", json_string(run));
-    }
-    if (tid[0] != '\0')
-    {
-        json_object_set_new(log_entry, "trace_id", json_string(tid));
-    }
-    
-    /* Build context object */
-    json_t *context = json_object();
-    if (context != NULL)
-    {
-        if (stage != NULL)
-        {
-            json_object_set_new(context, "stage", json_string(stage));
-        }
-        if (rid[0] != '\0')
-        {
-            json_object_set_new(context, "request_id", json_string(rid));
-        }
-        
-        /* Filter PII from context before adding to log entry */
-        json_t *filtered_context = filter_pii_json(context);
-        json_object_set_new(log_entry, "context", filtered_context);
-        json_decref(context); /* Free original context */
-    }
-    
-    /* Output JSON log */
-    char *json_str = json_dumps(log_entry, JSON_COMPACT);
-    if (json_str != NULL)
-    {
-        fprintf(stderr, "%s\n", json_str);
-        free(json_str);
-    }
-    
-    json_decref(log_entry);
+    log_stage("DEBUG", stage, ctx, message);
 }
 
 static void send_response(int client_fd, const char *status_line,
                           const char *content_type, const char *body) {
-    char header[512];
-    size_t body_len = body ? strlen(body) : 0U;
-
-    int header_len = snprintf(header, sizeof(header),
-                              "%s\r\n"
-                              "Content-Type: %s\r\n"
-                              "Content-Length: %zu\r\n"
-                              "Connection: close\r\n"
-                              "\r\n",
-                              status_line,
-                              content_type,
-                              body_len);
-
-    if (header_len > 0) {
-        (void)write(client_fd, header, (size_t)header_len);
-    }
-    if (body_len > 0) {
-        (void)write(client_fd, body, body_len);
+    http_response_t resp;
+    http_response_init(&resp, status_line);
+    if (strcmp(content_type, "application/json") == 0) {
+        http_response_add_raw(&resp, HTTP_RESPONSE_CONTENT_TYPE_JSON);
+    } else {
+        http_response_add_header(&resp, "Content-Type", content_type);
     }
+    (void)http_response_send(&resp, client_fd, tls_keep_alive, body, body ? strlen(body) : 0U);
 }
 
-static void send_response_with_headers(int client_fd, const char *status_line,
-                                        const char *extra_headers, const char *body) {
-    char header[1024];
-    size_t body_len = body ? strlen(body) : 0U;
-
-    int header_len = snprintf(header, sizeof(header),
-                              "%s\r\n"
-                              "%s"
-                              "Content-Length: %zu\r\n"
-                              "Connection: close\r\n"
-                              "\r\n",
-                              status_line,
-                              extra_headers ? extra_headers : "",
-                              body_len);
-
-    if (header_len > 0) {
-        (void)write(client_fd, header, (size_t)header_len);
-    }
-    if (body_len > 0) {
-        (void)write(client_fd, body, body_len);
-    }
+/* JSON response carrying a Retry-After header (429 and 503 paths) */
+static void send_json_with_retry_after(int client_fd, const char *status_line,
+                                       int retry_after_seconds, const char *body) {
+    http_response_t resp;
+    http_response_init(&resp, status_line);
+    http_response_add_raw(&resp, HTTP_RESPONSE_CONTENT_TYPE_JSON);
+    http_response_add_uint(&resp, "Retry-After",
+                           retry_after_seconds > 0 ? (uint64_t)retry_after_seconds : 0U);
+    (void)http_response_send(&resp, client_fd, tls_keep_alive, body, strlen(body));
 }
 
 static void send_error_response_with_retry_after(int client_fd,
@@ -1599,13 +1279,7 @@ static void send_error_response_with_retry_after(int client_fd,
     {
         /* Fallback to minimal error JSON if formatting fails */
         const char *fallback = "{\"ok\":false,\"error\":{\"code\":\"internal\",\"message\":\"internal error\",\"intake_error_code\":null,\"details\":{}},\"context\":{\"request_id\":\"\",\"trace_id\":\"\",\"tenant_id\":\"\"}}";
-        char headers[256];
-        snprintf(headers, sizeof(headers),
-                 "Content-Type: application/json\r\n"
-                 "Content-Length: %zu\r\n"
-                 "Retry-After: %d\r\n",
-                 strlen(fallback), retry_after_seconds);
-        send_response_with_headers(client_fd, status_line, headers, fallback);
+        send_json_with_retry_after(client_fd, status_line, retry_after_seconds, fallback);
         metric_requests_errors_total++;
         if (strncmp(status_line, "HTTP/1.1 4", 10) == 0) {
             metric_requests_errors_4xx++;
@@ -1617,14 +1291,7 @@ static void send_error_response_with_retry_after(int client_fd,
         return;
     }
 
-    char headers[256];
-    snprintf(headers, sizeof(headers),
-             "Content-Type: application/json\r\n"
-             "Content-Length: %zu\r\n"
-             "Retry-After: %d\r\n",
-             strlen(body), retry_after_seconds);
-    
-    send_response_with_headers(client_fd, status_line, headers, body);
+    send_json_with_retry_after(client_fd, status_line, retry_after_seconds, body);
     metric_requests_errors_total++;
     if (strncmp(status_line, "HTTP/1.1 4", 10) == 0) {
         metric_requests_errors_4xx++;
@@ -1740,238 +1407,6 @@ static void send_error_response(int client_fd,
                                       conflict_type, NULL);
 }
 
-static int validate_decide_request(const char *request_body,
-                                   request_context_t *ctx)
-{
-    json_error_t error;
-    json_t      *root = json_loads(request_body, 0, &error);
-
-    if (root == NULL)
-    {
-        return -1;
-    }
-
-    if (!json_is_object(root))
-    {
-        json_decref(root);
-        return -1;
-    }
-
-    json_t *version      = json_object_get(root, "version");
-    json_t *tenant_id    = json_object_get(root, "tenant_id");
-    json_t *request_id   = json_object_get(root, "request_id");
-    json_t *run_id       = json_object_get(root, "run_id");
-    json_t *task         = json_object_get(root, "task");
-    json_t *task_type    = task != NULL ? json_object_get(task, "type") : NULL;
-    json_t *task_payload = task != NULL ? json_object_get(task, "payload") : NULL;
-
-    int ok = 1;
-
-    if (!json_is_string(version) || strcmp(json_string_value(version), "1") != 0)
-    {
-        ok = 0;
-    }
-
-    if (!json_is_string(tenant_id) || !json_is_string(request_id))
-    {
-        ok = 0;
-    }
-
-    if (!json_is_object(task) || !json_is_string(task_type) || !json_is_object(task_payload))
-    {
-        ok = 0;
-    }
-
-    if (ok && ctx != NULL)
-    {
-        const char *rid_val = json_string_value(request_id);
-        if (rid_val != NULL)
-        {
-            strncpy(ctx->request_id, rid_val, sizeof(ctx->request_id) - 1U);
-            ctx->request_id[sizeof(ctx->request_id) - 1U] = '\0';
-        }
-        
-        /* Extract run_id if present (optional field) */
-        if (run_id != NULL && json_is_string(run_id))
-        {
-            const char *run_id_val = json_string_value(run_id);
-            if (run_id_val != NULL)
-            {
-                strncpy(ctx->run_id, run_id_val, sizeof(ctx->run_id) - 1U);
-                ctx->run_id[sizeof(ctx->run_id) - 1U] = '\0';
-            }
-        }
-    }
-
-    json_decref(root);
-
-    return ok ? 0 : -1;
-}
-
-static int build_route_request_json(const char *http_body,
-                                   request_context_t *ctx,
-                                   char **out_json)
-{
-    if (out_json == NULL)
-    {
-        return -1;
-    }
-
-    *out_json = NULL;
-
-    json_error_t error;
-    json_t      *in_root = json_loads(http_body, 0, &error);
-    if (in_root == NULL || !json_is_object(in_root))
-    {
-        if (in_root != NULL)
-        {
-            json_decref(in_root);
-        }
-        return -1;
-    }
-
-    /* Build dedicated RouteRequest object */
-    json_t *route = json_object();
-    if (route == NULL)
-    {
-        json_decref(in_root);
-        return -1;
-    }
-
-    /* version: proxy as-is if present */
-    json_t *version = json_object_get(in_root, "version");
-    if (json_is_string(version))
-    {
-        json_object_set(route, "version", version);
-    }
-
-    /* tenant_id: prefer header/context, fallback to body */
-    const char *tenant_src = (ctx != NULL && ctx->tenant_id[0] != '\0')
-                                 ? ctx->tenant_id
-                                 : NULL;
-    if (tenant_src != NULL)
-    {
-        json_t *tenant = json_string(tenant_src);
-        if (tenant != NULL)
-        {
-            json_object_set_new(route, "tenant_id", tenant);
-        }
-    }
-    else
-    {
-        json_t *tenant_body = json_object_get(in_root, "tenant_id");
-        if (json_is_string(tenant_body))
-        {
-            json_object_set(route, "tenant_id", tenant_body);
-        }
-    }
-
-    /* request_id */
-    json_t *request_id = json_object_get(in_root, "request_id");
-    if (json_is_string(request_id))
-    {
-        json_object_set(route, "request_id", request_id);
-    }
-
-    /* trace_id: prefer context, fallback to body */
-    const char *trace_src = (ctx != NULL && ctx->trace_id[0] != '\0')
-                                ? ctx->trace_id
-                                : NULL;
-    if (trace_src != NULL)
-    {
-        json_t *trace = json_string(trace_src);
-        if (trace != NULL)
-        {
-            json_object_set_new(route, "trace_id", trace);
-        }
-    }
-    else
-    {
-        json_t *trace_body = json_object_get(in_root, "trace_id");
-        if (json_is_string(trace_body))
-        {
-            json_object_set(route, "trace_id", trace_body);
-        }
-    }
-
-    /* run_id: CP2+ optional field for multi-step workflows */
-    json_t *run_id = json_object_get(in_root, "run_id");
-    if (json_is_string(run_id))
-    {
-        json_object_set(route, "run_id", run_id);
-        
-        /* Save run_id to context if not already set */
-        if (ctx != NULL && ctx->run_id[0] == '\0')
-        {
-            const char *run_id_val = json_string_value(run_id);
-            if (run_id_val != NULL)
-            {
-                strncpy(ctx->run_id, run_id_val, sizeof(ctx->run_id) - 1U);
-                ctx->run_id[sizeof(ctx->run_id) - 1U] = '\0';
-            }
-        }
-    }
-
-    /* message.* fields */
-    json_t *message_obj = json_object();
-    if (message_obj == NULL)
-    {
-        json_decref(in_root);
-        json_decref(route);
-        return -1;
-    }
-
-    json_t *msg_id    = json_object_get(in_root, "message_id");
-    json_t *msg_type  = json_object_get(in_root, "message_type");
-    json_t *payload   = json_object_get(in_root, "payload");
-    json_t *metadata  = json_object_get(in_root, "metadata");
-
-    if (json_is_string(msg_id))
-    {
-        json_object_set(message_obj, "message_id", msg_id);
-    }
-    if (json_is_string(msg_type))
-    {
-        json_object_set(message_obj, "message_type", msg_type);
-    }
-    if (payload != NULL && json_is_object(payload))
-    {
-        json_object_set(message_obj, "payload", payload);
-    }
-    if (metadata != NULL && json_is_object(metadata))
-    {
-        json_object_set(message_obj, "metadata", metadata);
-    }
-
-    json_object_set_new(route, "message", message_obj);
-
-    /* policy_id */
-    json_t *policy_id = json_object_get(in_root, "policy_id");
-    if (json_is_string(policy_id))
-    {
-        json_object_set(route, "policy_id", policy_id);
-    }
-
-    /* context object (transparent passthrough) */
-    json_t *context = json_object_get(in_root, "context");
-    if (context != NULL && json_is_object(context))
-    {
-        json_object_set(route, "context", context);
-    }
-
-    char *dumped = json_dumps(route, JSON_COMPACT);
-    json_decref(in_root);
-    json_decref(route);
-
-    if (dumped == NULL)
-    {
-        return -1;
-    }
-
-    *out_json = dumped;
-    return 0;
-}
-
 /* Exported for testing - map_router_error_status is used by contract tests */
 int map_router_error_status(const char *resp_json)
 {
@@ -1980,75 +1415,9 @@ int map_router_error_status(const char *resp_json)
         return 0;
     }
 
-    json_error_t error;
-    json_t      *resp_root = json_loads(resp_json, 0, &error);
-    if (resp_root == NULL || !json_is_object(resp_root))
-    {
-        if (resp_root != NULL)
-        {
-            json_decref(resp_root);
-        }
-        return 0;
-    }
-
-    int status_code = 0;
-
-    json_t *ok_val = json_object_get(resp_root, "ok");
-    if (json_is_boolean(ok_val) && !json_boolean_value(ok_val))
-    {
-        json_t *err_obj = json_object_get(resp_root, "error");
-        json_t *code    = err_obj != NULL ? json_object_get(err_obj, "code") : NULL;
-        const char *code_str = json_is_string(code) ? json_string_value(code) : NULL;
-
-        if (code_str != NULL)
-        {
-            if (strcmp(code_str, "invalid_request") == 0)
-            {
-                status_code = 400;
-            }
-            else if (strcmp(code_str, "unauthorized") == 0)
-            {
-                status_code = 401;
-            }
-            else if (strcmp(code_str, "policy_not_found") == 0)
-            {
-                status_code = 404;
-            }
-            /* Extension error codes (CP2-LC) */
-            else if (strcmp(code_str, "extension_not_found") == 0)
-            {
-                status_code = 404;
-            }
-            else if (strcmp(code_str, "extension_timeout") == 0)
-            {
-                status_code = 504;
-            }
-            else if (strcmp(code_str, "validator_blocked") == 0)
-            {
-                status_code = 403;
-            }
-            else if (strcmp(code_str, "post_processor_failed") == 0)
-            {
-                status_code = 500;
-            }
-            else if (strcmp(code_str, "extension_unavailable") == 0)
-            {
-                status_code = 503;
-            }
-            else if (strcmp(code_str, "extension_error") == 0)
-            {
-                status_code = 500;
-            }
-            else if (strcmp(code_str, "decision_failed") == 0 ||
-                     strcmp(code_str, "internal") == 0)
-            {
-                status_code = 500;
-            }
-        }
-    }
-
-    json_decref(resp_root);
-    return status_code;
+    router_reply_t reply;
+    (void)router_reply_scan(resp_json, strlen(resp_json), &reply);
+    return reply.http_status;
 }
 
 static void handle_health(int client_fd) {
@@ -2070,7 +1439,7 @@ static void handle_health(int client_fd) {
     char *body = json_dumps(health_response, JSON_COMPACT);
     if (body != NULL) {
         send_response(client_fd, "HTTP/1.1 200 OK", "application/json", body);
-        free(body);
+        request_arena_scratch_free(body);
     } else {
         /* Fallback if json_dumps fails */
         const char *fallback = "{\"status\":\"healthy\",\"timestamp\":\"error\"}";
@@ -2082,17 +1451,46 @@ static void handle_health(int client_fd) {
 
 /* Old handle_metrics function removed - now using handle_metrics_request from metrics_handler.c */
 
+/* {"count":N,"p50":..,"p90":..,"p99":..,"p999":..} in microseconds */
+static void format_latency_window(char *buf, size_t size, int window_ms)
+{
+    latency_histogram_snapshot_t snap;
+    if (latency_histogram_snapshot(g_latency, window_ms, &snap) != 0) {
+        memset(&snap, 0, sizeof(snap));
+    }
+    (void)snprintf(buf, size,
+                   "{\"count\":%llu,\"p50\":%llu,\"p90\":%llu,\"p99\":%llu,\"p999\":%llu}",
+                   (unsigned long long)snap.total,
+                   (unsigned long long)latency_histogram_percentile(&snap, 50.0),
+                   (unsigned long long)latency_histogram_percentile(&snap, 90.0),
+                   (unsigned long long)latency_histogram_percentile(&snap, 99.0),
+                   (unsigned long long)latency_histogram_percentile(&snap, 99.9));
+}
+
 static void handle_metrics_json(int client_fd)
 {
-    char body[512];
+    char body[1024];
     time_t now = time(NULL);
     if (start_time_sec == 0) start_time_sec = now;
     double uptime = difftime(now, start_time_sec);
     if (uptime < 1.0) uptime = 1.0;
 
     double rps = ((double)metric_requests_total) / uptime;
-    int p50 = percentile_ms(50);
-    int p95 = percentile_ms(95);
+
+    /* "latency" keeps its millisecond p50/p95 (last minute, -1 when idle)
+     * for existing dashboards; "latency_us" has the full tail per window */
+    latency_histogram_snapshot_t snap;
+    int p50 = -1;
+    int p95 = -1;
+    if (latency_histogram_snapshot(g_latency, LATENCY_WINDOW_1M_MS, &snap) == 0 && snap.total > 0) {
+        p50 = (int)(latency_histogram_percentile(&snap, 50.0) / 1000U);
+        p95 = (int)(latency_histogram_percentile(&snap, 95.0) / 1000U);
+    }
+    char window_1m[160];
+    char window_5m[160];
+    format_latency_window(window_1m, sizeof(window_1m), LATENCY_WINDOW_1M_MS);
+    format_latency_window(window_5m, sizeof(window_5m), LATENCY_WINDOW_5M_MS);
+
     double err_rate = 0.0;
     if (metric_requests_total > 0) {
         err_rate = ((double)metric_requests_errors_total) / ((double)metric_requests_total);
@@ -2102,11 +1500,12 @@ static void handle_metrics_json(int client_fd)
     if (nats == NULL) nats = "unknown";
 
     int len = snprintf(body, sizeof(body),
-                       "{\"rps\":%.3f,\"latency\":{\"p50\":%d,\"p95\":%d},\"error_rate\":%.5f,"
+                       "{\"rps\":%.3f,\"latency\":{\"p50\":%d,\"p95\":%d},"
+                       "\"latency_us\":{\"1m\":%s,\"5m\":%s},\"error_rate\":%.5f,"
                        "\"rate_limit\":{\"total_hits\":%lu,\"total_exceeded\":%lu,"
                        "\"exceeded_by_endpoint\":{\"routes_decide\":%lu,\"messages\":%lu,\"registry_blocks\":%lu}}},"
                        "\"nats\":\"%s\",\"ts\":%ld}",
-                       rps, p50, p95, err_rate, 
+                       rps, p50, p95, window_1m, window_5m, err_rate,
                        rl_total_hits, rl_total_exceeded,
                        rl_exceeded_by_endpoint[RL_ENDPOINT_ROUTES_DECIDE],
                        rl_exceeded_by_endpoint[RL_ENDPOINT_MESSAGES],
@@ -2123,17 +1522,134 @@ static void handle_metrics_json(int client_fd)
     send_response(client_fd, "HTTP/1.1 200 OK", "application/json", body);
 }
 
-static void handle_get_decision(int client_fd,
-                                const char *message_id,
-                                request_context_t *ctx)
+#define LOG_VIEW_MAX_SITES 64
+
+static void put_cstr(log_line_t *l, const char *s) {
+    log_line_str(l, s, strlen(s));
+}
+
+/* GET /_log: throttle settings and per-callsite counters */
+static void handle_log_settings(int client_fd)
 {
-    if (message_id == NULL || message_id[0] == '\0') {
-        send_error_response(client_fd,
-                            "HTTP/1.1 400 Bad Request",
-                            "invalid_request",
+    log_throttle_config_t config;
+    log_throttle_get_config(&config);
+    log_callsite_stats_t sites[LOG_VIEW_MAX_SITES];
+    size_t count = log_throttle_get_stats(sites, LOG_VIEW_MAX_SITES);
+    if (count > LOG_VIEW_MAX_SITES) count = LOG_VIEW_MAX_SITES;
+
+    char body[8192];
+    log_line_t l = { body, sizeof(body) - 1U, 0 };
+    log_line_raw(&l, "{\"level\":");
+    put_cstr(&l, log_level_name(config.level));
+    log_line_raw(&l, ",\"rate_per_sec\":");
+    log_line_int(&l, config.rate_per_sec);
+    log_line_raw(&l, ",\"burst\":");
+    log_line_int(&l, config.burst);
+    log_line_raw(&l, ",\"sample_every\":{");
+    for (int i = 0; i < LOG_LEVEL_COUNT; i++) {
+        if (i > 0) log_line_raw(&l, ",");
+        put_cstr(&l, log_level_name((log_level_t)i));
+        log_line_raw(&l, ":");
+        log_line_int(&l, config.sample_every[i]);
+    }
+    log_line_raw(&l, "},\"callsites\":[");
+    for (size_t i = 0; i < count; i++) {
+        log_line_raw(&l, i > 0 ? ",{\"name\":" : "{\"name\":");
+        put_cstr(&l, sites[i].name);
+        log_line_raw(&l, ",\"level\":");
+        put_cstr(&l, log_level_name(sites[i].level));
+        log_line_raw(&l, ",\"emitted\":");
+        log_line_int(&l, (long long)sites[i].emitted);
+        log_line_raw(&l, ",\"suppressed\":");
+        log_line_int(&l, (long long)sites[i].suppressed);
+        log_line_raw(&l, "}");
+    }
+    log_line_raw(&l, "]}");
+    size_t len = log_line_end(&l);
+    if (len == 0) {
+        send_response(client_fd, "HTTP/1.1 500 Internal Server Error", "application/json",
+                      "{\"error\":\"log settings too large\"}");
+        return;
+    }
+    body[len] = '\0';
+    send_response(client_fd, "HTTP/1.1 200 OK", "application/json", body);
+}
+
+/* Apply a PUT /_log body on top of config; any field may be left out.
+ * Returns 0 on success, -1 with *error set */
+static int parse_log_settings(const char *body, log_throttle_config_t *config, const char **error)
+{
+    json_error_t jerr;
+    json_t *root = body ? json_loads(body, 0, &jerr) : NULL;
+    if (!json_is_object(root)) {
+        json_decref(root);
+        *error = "body must be a JSON object";
+        return -1;
+    }
+    int rc = 0;
+    json_t *level = json_object_get(root, "level");
+    if (level && (!json_is_string(level) ||
+                  log_level_parse(json_string_value(level), &config->level) != 0)) {
+        *error = "level must be error, warn, info or debug";
+        rc = -1;
+    }
+    json_t *rate = json_object_get(root, "rate_per_sec");
+    if (rc == 0 && rate) {
+        if (!json_is_integer(rate) || json_integer_value(rate) < 0 || json_integer_value(rate) > 1000000) {
+            *error = "rate_per_sec must be an integer from 0 to 1000000";
+            rc = -1;
+        } else {
+            config->rate_per_sec = (int)json_integer_value(rate);
+        }
+    }
+    json_t *burst = json_object_get(root, "burst");
+    if (rc == 0 && burst) {
+        if (!json_is_integer(burst) || json_integer_value(burst) < 1 || json_integer_value(burst) > 1000000) {
+            *error = "burst must be an integer from 1 to 1000000";
+            rc = -1;
+        } else {
+            config->burst = (int)json_integer_value(burst);
+        }
+    }
+    json_t *sample = json_object_get(root, "sample_every");
+    if (rc == 0 && sample && !json_is_object(sample)) {
+        *error = "sample_every must be an object";
+        rc = -1;
+    }
+    for (int i = 0; rc == 0 && sample && i < LOG_LEVEL_COUNT; i++) {
+        json_t *every = json_object_get(sample, log_level_name((log_level_t)i));
+        if (!every) continue;
+        if (!json_is_integer(every) || json_integer_value(every) < 1 || json_integer_value(every) > 1000000) {
+            *error = "sample_every values must be integers from 1 to 1000000";
+            rc = -1;
+        } else {
+            config->sample_every[i] = (int)json_integer_value(every);
+        }
+    }
+    json_decref(root);
+    return rc;
+}
+
+/*
+ * Router-backed endpoints come in two halves: a check that runs before
+ * the request goes out (and answers the client itself on bad input),
+ * and a *_reply function that renders the Router's answer. The reply
+ * may run later, when the reactor resumes the parked connection; rc is
+ * 0 and resp holds the Router JSON on success.
+ */
+
+/* Returns 0 if the lookup may go to the Router, -1 if an error was sent */
+static int get_decision_check(int client_fd,
+                              const char *message_id,
+                              request_context_t *ctx)
+{
+    if (message_id == NULL || message_id[0] == '\0') {
+        send_error_response(client_fd,
+                            "HTTP/1.1 400 Bad Request",
+                            "invalid_request",
                             "empty message_id",
                             ctx);
-        return;
+        return -1;
     }
 
     if (ctx == NULL || ctx->tenant_id[0] == '\0') {
@@ -2142,17 +1658,37 @@ static void handle_get_decision(int client_fd,
                             "invalid_request",
                             "missing tenant_id for decision lookup",
                             ctx);
-        return;
+        return -1;
+    }
+    return 0;
+}
+
+/* Status line a Router lookup (decision, complexity) goes out with, from
+ * the Router error status */
+static const char *router_lookup_status_line(int status_code)
+{
+    switch (status_code)
+    {
+        case 400: return "HTTP/1.1 400 Bad Request";
+        case 401: return "HTTP/1.1 401 Unauthorized";
+        case 404: return "HTTP/1.1 404 Not Found";
+        case 500: return "HTTP/1.1 500 Internal Server Error";
+        default:  return "HTTP/1.1 200 OK";
     }
+}
 
-    char resp_buf[MAX_RESPONSE_SIZE];
-    memset(resp_buf, 0, sizeof(resp_buf));
+/* Lifetimes of cached decision lookups (see the decision cache section) */
+static int g_decision_ttl_ms = 300000;
+static int g_decision_negative_ttl_ms = 1000;
 
-    int rc = nats_request_get_decision(ctx->tenant_id,
-                                       message_id,
-                                       resp_buf,
-                                       sizeof(resp_buf));
+static void get_decision_reply(int client_fd, request_context_t *ctx, int rc, const char *resp_buf)
+{
     if (rc != 0) {
+        /* Polls waiting on this lookup answer 503 too; the next one retries */
+        if (ctx != NULL) {
+            idempotency_cache_abandon(ctx->decision);
+            ctx->decision = NULL;
+        }
         send_error_response(client_fd,
                             "HTTP/1.1 503 Service Unavailable",
                             "internal",
@@ -2161,31 +1697,34 @@ static void handle_get_decision(int client_fd,
         return;
     }
 
-    int status_code = map_router_error_status(resp_buf);
-    const char *status_line = "HTTP/1.1 200 OK";
-
-    switch (status_code)
-    {
-        case 400: status_line = "HTTP/1.1 400 Bad Request"; break;
-        case 401: status_line = "HTTP/1.1 401 Unauthorized"; break;
-        case 404: status_line = "HTTP/1.1 404 Not Found"; break;
-        case 500: status_line = "HTTP/1.1 500 Internal Server Error"; break;
-        default:  status_line = "HTTP/1.1 200 OK"; break;
-    }
+    router_reply_t reply;
+    int well_formed = router_reply_scan(resp_buf, strlen(resp_buf), &reply) == 0;
+    int status_code = reply.http_status;
+    const char *status_line = router_lookup_status_line(status_code);
 
     send_response(client_fd, status_line, "application/json", resp_buf);
     if (strcmp(status_line, "HTTP/1.1 200 OK") == 0 && ctx && ctx->tenant_id[0] != '\0') {
         /* Broadcast creation event for realtime UI */
         sse_broadcast_json(ctx->tenant_id, "message_created", resp_buf);
     }
+
+    /* A decision, once made, does not change; "not found" may stop being
+     * true soon, and other errors are only shared with polls already
+     * waiting */
+    if (ctx != NULL && ctx->decision != NULL) {
+        int ttl_ms = 0;
+        if (well_formed && !reply.ok_false) {
+            ttl_ms = g_decision_ttl_ms;
+        } else if (status_code == 404) {
+            ttl_ms = g_decision_negative_ttl_ms;
+        }
+        idempotency_cache_complete(ctx->decision, status_code, resp_buf, strlen(resp_buf), ttl_ms);
+        ctx->decision = NULL;
+    }
 }
 
-static void handle_extensions_health(int client_fd, const request_context_t *ctx)
+static void extensions_health_reply(int client_fd, request_context_t *ctx, int rc, const char *resp_buf)
 {
-    char resp_buf[MAX_RESPONSE_SIZE];
-    memset(resp_buf, 0, sizeof(resp_buf));
-
-    int rc = nats_request_get_extension_health(resp_buf, sizeof(resp_buf));
     if (rc != 0) {
         send_error_response(client_fd,
                             "HTTP/1.1 503 Service Unavailable",
@@ -2198,12 +1737,8 @@ static void handle_extensions_health(int client_fd, const request_context_t *ctx
     send_response(client_fd, "HTTP/1.1 200 OK", "application/json", resp_buf);
 }
 
-static void handle_circuit_breakers(int client_fd, const request_context_t *ctx)
+static void circuit_breakers_reply(int client_fd, request_context_t *ctx, int rc, const char *resp_buf)
 {
-    char resp_buf[MAX_RESPONSE_SIZE];
-    memset(resp_buf, 0, sizeof(resp_buf));
-
-    int rc = nats_request_get_circuit_breaker_states(resp_buf, sizeof(resp_buf));
     if (rc != 0) {
         send_error_response(client_fd,
                             "HTTP/1.1 503 Service Unavailable",
@@ -2216,9 +1751,10 @@ static void handle_circuit_breakers(int client_fd, const request_context_t *ctx)
     send_response(client_fd, "HTTP/1.1 200 OK", "application/json", resp_buf);
 }
 
-static void handle_dry_run_pipeline(int client_fd,
-                                    const char *request_body,
-                                    const request_context_t *ctx)
+/* Returns 0 if the dry run may go to the Router, -1 if an error was sent */
+static int dry_run_pipeline_check(int client_fd,
+                                  const char *request_body,
+                                  const request_context_t *ctx)
 {
     if (request_body == NULL || request_body[0] == '\0') {
         send_error_response(client_fd,
@@ -2226,13 +1762,13 @@ static void handle_dry_run_pipeline(int client_fd,
                             "INVALID_REQUEST",
                             "empty request body",
                             ctx);
-        return;
+        return -1;
     }
+    return 0;
+}
 
-    char resp_buf[MAX_RESPONSE_SIZE];
-    memset(resp_buf, 0, sizeof(resp_buf));
-
-    int rc = nats_request_dry_run_pipeline(request_body, resp_buf, sizeof(resp_buf));
+static void dry_run_pipeline_reply(int client_fd, request_context_t *ctx, int rc, const char *resp_buf)
+{
     if (rc != 0) {
         send_error_response(client_fd,
                             "HTTP/1.1 503 Service Unavailable",
@@ -2258,10 +1794,11 @@ static void handle_dry_run_pipeline(int client_fd,
     send_response(client_fd, status_line, "application/json", resp_buf);
 }
 
-static void handle_pipeline_complexity(int client_fd,
-                                      const char *tenant_id,
-                                      const char *policy_id,
-                                      const request_context_t *ctx)
+/* Returns 0 if the lookup may go to the Router, -1 if an error was sent */
+static int pipeline_complexity_check(int client_fd,
+                                     const char *tenant_id,
+                                     const char *policy_id,
+                                     const request_context_t *ctx)
 {
     if (tenant_id == NULL || tenant_id[0] == '\0' ||
         policy_id == NULL || policy_id[0] == '\0') {
@@ -2270,13 +1807,13 @@ static void handle_pipeline_complexity(int client_fd,
                             "INVALID_REQUEST",
                             "missing tenant_id or policy_id",
                             ctx);
-        return;
+        return -1;
     }
+    return 0;
+}
 
-    char resp_buf[MAX_RESPONSE_SIZE];
-    memset(resp_buf, 0, sizeof(resp_buf));
-
-    int rc = nats_request_get_pipeline_complexity(tenant_id, policy_id, resp_buf, sizeof(resp_buf));
+static void pipeline_complexity_reply(int client_fd, request_context_t *ctx, int rc, const char *resp_buf)
+{
     if (rc != 0) {
         send_error_response(client_fd,
                             "HTTP/1.1 503 Service Unavailable",
@@ -2288,26 +1825,18 @@ static void handle_pipeline_complexity(int client_fd,
 
     /* Check for error in response JSON */
     int status_code = map_router_error_status(resp_buf);
-    const char *status_line = "HTTP/1.1 200 OK";
-
-    switch (status_code)
-    {
-        case 400: status_line = "HTTP/1.1 400 Bad Request"; break;
-        case 401: status_line = "HTTP/1.1 401 Unauthorized"; break;
-        case 404: status_line = "HTTP/1.1 404 Not Found"; break;
-        case 500: status_line = "HTTP/1.1 500 Internal Server Error"; break;
-        default:  status_line = "HTTP/1.1 200 OK"; break;
-    }
-
-    send_response(client_fd, status_line, "application/json", resp_buf);
+    send_response(client_fd, router_lookup_status_line(status_code), "application/json", resp_buf);
 }
 
-static void handle_decide(int client_fd,
-                          const char *request_body,
-                          request_context_t *ctx,
-                          otel_span_t *parent_span) {
-    (void)parent_span; // Will be used for NATS span creation
-    
+/*
+ * Gate and translate a decide request
+ *
+ * Returns the RouteRequest JSON to send to the Router (release with
+ * request_arena_scratch_free), or NULL once a response has been sent.
+ */
+static char *decide_prepare(int client_fd,
+                            const char *request_body,
+                            request_context_t *ctx) {
     /* Extract client IP for abuse detection */
     char client_ip[64] = {0};
     struct sockaddr_in client_addr;
@@ -2330,7 +1859,7 @@ static void handle_decide(int client_fd,
                             ctx,
                             CONFLICT_TYPE_REQUEST_GATEWAY,
                             NULL);
-        return;
+        return NULL;
     }
     
     /* Check Router backpressure status before processing */
@@ -2344,7 +1873,7 @@ static void handle_decide(int client_fd,
                                                 "Router is overloaded, please retry later",
                                                 30, /* Retry-After: 30 seconds */
                                                 ctx);
-            return;
+            return NULL;
         case BACKPRESSURE_WARNING:
             /* Router is under stress - apply stricter rate limiting */
             /* Continue processing but with reduced rate limits */
@@ -2367,23 +1896,8 @@ static void handle_decide(int client_fd,
     if (redis_rate_limiter_check(&redis_rl_ctx, &redis_rl_result) == 0) {
         if (redis_rl_result.decision == REDIS_RL_DENY) {
             /* Rate limit exceeded - return 429 */
-            char headers[1024] = {0};
             char body[512] = {0};
             
-            /* Build headers */
-            snprintf(headers, sizeof(headers),
-                "HTTP/1.1 429 Too Many Requests\r\n"
-                "Content-Type: application/json\r\n"
-                "Retry-After: %u\r\n"
-                "X-RateLimit-Limit: %u\r\n"
-                "X-RateLimit-Remaining: %u\r\n"
-                "X-RateLimit-Reset: %lu\r\n"
-                "\r\n",
-                redis_rl_result.retry_after_sec,
-                redis_rl_result.limit,
-                redis_rl_result.remaining,
-                redis_rl_result.reset_at);
-            
             /* Build body with conflict contract compliance */
             const char *rid = (ctx && ctx->request_id[0] != '\0') ? ctx->request_id : "";
             const char *tid = (ctx && ctx->trace_id[0] != '\0') ? ctx->trace_id : "";
@@ -2398,8 +1912,14 @@ static void handle_decide(int client_fd,
                 "\"context\":{\"request_id\":\"%s\",\"trace_id\":\"%s\",\"tenant_id\":\"%s\"}}",
                 redis_rl_result.retry_after_sec, rid, tid, ten);
             
-            send(client_fd, headers, strlen(headers), 0);
-            send(client_fd, body, strlen(body), 0);
+            http_response_t resp;
+            http_response_init(&resp, "HTTP/1.1 429 Too Many Requests");
+            http_response_add_raw(&resp, HTTP_RESPONSE_CONTENT_TYPE_JSON);
+            http_response_add_uint(&resp, "Retry-After", redis_rl_result.retry_after_sec);
+            http_response_add_uint(&resp, "X-RateLimit-Limit", redis_rl_result.limit);
+            http_response_add_uint(&resp, "X-RateLimit-Remaining", redis_rl_result.remaining);
+            http_response_add_uint(&resp, "X-RateLimit-Reset", redis_rl_result.reset_at);
+            (void)http_response_send(&resp, client_fd, tls_keep_alive, body, strlen(body));
             
             /* Log with conflict contract fields */
             log_error_with_conflict_info("redis_rate_limiter", ctx, "rate_limit_exceeded",
@@ -2411,12 +1931,12 @@ static void handle_decide(int client_fd,
                 otel_span_set_status(ctx->otel_span, SPAN_STATUS_ERROR);
                 otel_span_end(ctx->otel_span);
             }
-            return;
+            return NULL;
         }
         /* If degraded (Redis unavailable), log but continue */
         if (redis_rl_result.degraded) {
-            /* Log degradation (would use proper logging in production) */
-            fprintf(stderr, "Redis rate limiter degraded (circuit breaker open), allowing request\n");
+            log_throttled(&log_site_redis_degraded, "rate_limit",
+                          "Redis rate limiter degraded (circuit breaker open), allowing request");
         }
     }
     
@@ -2435,7 +1955,7 @@ static void handle_decide(int client_fd,
                                 "rate_limit_exceeded",
                                 "Tenant temporarily blocked due to abuse detection",
                                 ctx);
-            return;
+            return NULL;
         }
         
         /* Check for abuse patterns */
@@ -2458,7 +1978,7 @@ static void handle_decide(int client_fd,
                                         "rate_limit_exceeded",
                                         "Tenant temporarily blocked due to abuse detection",
                                         ctx);
-                    return;
+                    return NULL;
                 case ABUSE_RESPONSE_RATE_LIMIT:
                     /* Apply stricter rate limiting (already handled by rate limiter) */
                     /* Continue processing but with stricter limits */
@@ -2471,8 +1991,19 @@ static void handle_decide(int client_fd,
         }
     }
 
+    /* One pass validates the DTO and writes the RouteRequest */
+    route_request_overrides_t overrides = {
+        ctx != NULL ? ctx->tenant_id : NULL,
+        ctx != NULL ? ctx->trace_id : NULL
+    };
+    route_request_ids_t ids;
+    char *route_req_json = NULL;
+    size_t body_len = request_body != NULL ? strlen(request_body) : 0U;
+    int rc = route_request_build(request_body, body_len, &overrides, &ids,
+                                 &route_req_json, NULL);
+
     /* Conflict Contract: Priority 3 - Request Gateway Validation (REQ_GW) */
-    if (validate_decide_request(request_body, ctx) != 0)
+    if (rc == ROUTE_REQUEST_INVALID)
     {
         send_error_response_with_conflict(client_fd,
                             "HTTP/1.1 400 Bad Request",
@@ -2481,47 +2012,95 @@ static void handle_decide(int client_fd,
                             ctx,
                             CONFLICT_TYPE_REQUEST_GATEWAY,
                             NULL);
-        return;
+        return NULL;
     }
-
-    char *route_req_json = NULL;
-    if (build_route_request_json(request_body, ctx, &route_req_json) != 0)
+    if (rc != ROUTE_REQUEST_OK)
     {
         send_error_response(client_fd,
                             "HTTP/1.1 400 Bad Request",
                             "invalid_request",
                             "failed to build RouteRequest",
                             ctx);
-        return;
+        return NULL;
     }
 
-    char resp_buf[MAX_RESPONSE_SIZE];
-    memset(resp_buf, 0, sizeof(resp_buf));
+    if (ctx != NULL)
+    {
+        memcpy(ctx->request_id, ids.request_id, sizeof(ctx->request_id));
+        if (ids.has_run_id)
+        {
+            memcpy(ctx->run_id, ids.run_id, sizeof(ctx->run_id));
+        }
+    }
 
-    // Create NATS publish span (child of HTTP span)
-    otel_span_t *nats_span = NULL;
-    if (parent_span) {
-        nats_span = otel_span_start("gateway.nats.publish", SPAN_KIND_CLIENT, parent_span);
-        if (nats_span) {
-            const char *subject = getenv("ROUTER_DECIDE_SUBJECT");
-            if (!subject || subject[0] == '\0') {
-                subject = "beamline.router.v1.decide";
-            }
-            otel_span_set_attribute(nats_span, "nats.subject", subject);
+    /* A task that names a registered block version must match its input
+     * schema; unknown blocks are left to the Router */
+    if (ids.has_task_block && ids.task_payload != NULL)
+    {
+        const block_record_t *rec = block_registry_get(g_registry, ids.task_type, strlen(ids.task_type),
+                                                       ids.task_version, strlen(ids.task_version));
+        schema_error_t why;
+        if (rec != NULL && rec->attachment != NULL &&
+            schema_validator_check(rec->attachment, ids.task_payload, ids.task_payload_len, &why) ==
+                SCHEMA_INVALID)
+        {
+            char msg[256];
+            snprintf(msg, sizeof(msg), "task payload does not match the block input schema at %s: %s",
+                     why.path, why.reason);
+            block_record_release(rec);
+            request_arena_scratch_free(route_req_json);
+            send_error_response_with_conflict(client_fd,
+                                "HTTP/1.1 400 Bad Request",
+                                "invalid_payload",
+                                msg,
+                                ctx,
+                                CONFLICT_TYPE_REQUEST_GATEWAY,
+                                NULL);
+            return NULL;
         }
+        block_record_release(rec);
     }
 
-    int rc = nats_request_decide(route_req_json, resp_buf, sizeof(resp_buf));
-    free(route_req_json);
-    
-    // End NATS span
+    return route_req_json;
+}
+
+/* Create NATS publish span (child of HTTP span) */
+static otel_span_t *decide_nats_span(otel_span_t *parent_span) {
+    if (!parent_span) {
+        return NULL;
+    }
+    otel_span_t *nats_span = otel_span_start("gateway.nats.publish", SPAN_KIND_CLIENT, parent_span);
     if (nats_span) {
-        otel_span_set_status(nats_span, (rc == 0) ? SPAN_STATUS_OK : SPAN_STATUS_ERROR);
-        otel_span_end(nats_span);
+        const char *subject = getenv("ROUTER_DECIDE_SUBJECT");
+        if (!subject || subject[0] == '\0') {
+            subject = "beamline.router.v1.decide";
+        }
+        otel_span_set_attribute(nats_span, "nats.subject", subject);
+    }
+    return nats_span;
+}
+
+/* Status line a decide answer goes out with, from the Router error status */
+static const char *decide_status_line(int status_code) {
+    switch (status_code)
+    {
+        case 202: return "HTTP/1.1 202 Accepted";
+        case 400: return "HTTP/1.1 400 Bad Request";
+        case 401: return "HTTP/1.1 401 Unauthorized";
+        case 404: return "HTTP/1.1 404 Not Found";
+        case 500: return "HTTP/1.1 500 Internal Server Error";
+        case 503: return "HTTP/1.1 503 Service Unavailable";
+        default:  return "HTTP/1.1 200 OK";
     }
+}
 
+static void decide_reply(int client_fd, request_context_t *ctx, int rc, const char *resp_buf) {
     /* Conflict Contract: Priority 5 - Router Runtime Error (RUNTIME_ROUTER) */
     if (rc != 0) {
+        /* Nothing to replay: duplicates waiting on this request answer
+         * for themselves, and a retry may claim the key again */
+        idempotency_cache_abandon(ctx->idempotency);
+        ctx->idempotency = NULL;
         send_error_response_with_conflict(client_fd,
                             "HTTP/1.1 503 Service Unavailable",
                             "unavailable",
@@ -2532,237 +2111,1381 @@ static void handle_decide(int client_fd,
         return;
     }
 
+    /* One pass over the reply yields the status and every field we log */
+    size_t resp_len = strlen(resp_buf);
+    router_reply_t reply;
+    (void)router_reply_scan(resp_buf, resp_len, &reply);
+
     /* Map Router ErrorResponse.error.code to HTTP status if ok == false */
-    int status_code = map_router_error_status(resp_buf);
-    const char *status_line = "HTTP/1.1 200 OK";
-    
-    /* Extract intake_error_code from Router response (if error) */
-    const char *intake_error_code = NULL;
-    conflict_type_t conflict_type = CONFLICT_TYPE_ROUTER_INTAKE;
-    
+    int status_code = reply.http_status;
+    const char *status_line = decide_status_line(status_code);
+
     if (status_code >= 400) {
-        /* Parse Router response to extract intake_error_code */
-        json_error_t json_err;
-        json_t *resp_root = json_loads(resp_buf, 0, &json_err);
-        if (resp_root != NULL) {
-            json_t *ok_val = json_object_get(resp_root, "ok");
-            if (json_is_boolean(ok_val) && !json_boolean_value(ok_val)) {
-                json_t *err_obj = json_object_get(resp_root, "error");
-                if (err_obj != NULL) {
-                    json_t *intake_code = json_object_get(err_obj, "intake_error_code");
-                    if (json_is_string(intake_code)) {
-                        intake_error_code = json_string_value(intake_code);
-                    }
-                    
-                    /* Determine conflict type: intake vs runtime */
-                    json_t *code_val = json_object_get(err_obj, "code");
-                    if (json_is_string(code_val)) {
-                        const char *gateway_code = json_string_value(code_val);
-                        /* Runtime errors typically have codes like "internal", "unavailable" */
-                        if (strcmp(gateway_code, "internal") == 0 || 
-                            strcmp(gateway_code, "unavailable") == 0) {
-                            conflict_type = CONFLICT_TYPE_ROUTER_RUNTIME;
-                        } else {
-                            conflict_type = CONFLICT_TYPE_ROUTER_INTAKE;
-                        }
-                    }
-                }
-            }
-            json_decref(resp_root);
+        const char *intake_error_code = reply.has_intake_code ? reply.intake_error_code : NULL;
+
+        /* Runtime errors typically have codes like "internal", "unavailable" */
+        conflict_type_t conflict_type = CONFLICT_TYPE_ROUTER_INTAKE;
+        if (strcmp(reply.code, "internal") == 0 || strcmp(reply.code, "unavailable") == 0) {
+            conflict_type = CONFLICT_TYPE_ROUTER_RUNTIME;
         }
-        
+
         /* If Router returned error, log with conflict contract */
-        if (status_code >= 400) {
-            json_error_t json_err2;
-            json_t *resp_root2 = json_loads(resp_buf, 0, &json_err2);
-            if (resp_root2 != NULL) {
-                json_t *err_obj = json_object_get(resp_root2, "error");
-                if (err_obj != NULL) {
-                    json_t *msg_val = json_object_get(err_obj, "message");
-                    json_t *code_val = json_object_get(err_obj, "code");
-                    const char *message = json_is_string(msg_val) ? json_string_value(msg_val) : "Router error";
-                    const char *error_code = json_is_string(code_val) ? json_string_value(code_val) : "internal";
-                    
-                    log_error_with_conflict_info("router_response", ctx, error_code, message,
-                                                  conflict_type, intake_error_code, status_code);
-                }
-                json_decref(resp_root2);
-            }
+        log_error_with_conflict_info("router_response", ctx, reply.code,
+                                     reply.has_message ? reply.message : "Router error",
+                                     conflict_type, intake_error_code, status_code);
+    }
+
+    /* Error responses must carry intake_error_code; when the Router left
+     * it out, splice a null into the error object and keep every other
+     * byte as the Router sent it */
+    char *updated_json = NULL;
+    if (status_code >= 400 && !reply.has_intake_key) {
+        size_t size = resp_len + ROUTER_REPLY_INTAKE_NULL_EXTRA + 1U;
+        updated_json = request_arena_scratch_alloc(size);
+        if (updated_json != NULL &&
+            router_reply_add_intake_null(resp_buf, resp_len, &reply, updated_json, size) == 0) {
+            request_arena_scratch_free(updated_json);
+            updated_json = NULL;
         }
     }
 
-    switch (status_code)
-    {
-        case 400: status_line = "HTTP/1.1 400 Bad Request"; break;
-        case 401: status_line = "HTTP/1.1 401 Unauthorized"; break;
-        case 404: status_line = "HTTP/1.1 404 Not Found"; break;
-        case 500: status_line = "HTTP/1.1 500 Internal Server Error"; break;
-        case 503: status_line = "HTTP/1.1 503 Service Unavailable"; break;
-        default:  status_line = "HTTP/1.1 200 OK"; break;
+    const char *body = updated_json != NULL ? updated_json : resp_buf;
+    send_response(client_fd, status_line, "application/json", body);
+
+    /* Router verdicts are kept for retries; 5xx ones only reach the
+     * duplicates already waiting, since a later retry may fare better */
+    if (ctx->idempotency != NULL) {
+        idempotency_cache_complete(ctx->idempotency, status_code, body, strlen(body),
+                                   status_code < 500 ? IDEMPOTENCY_TTL_DEFAULT : 0);
+        ctx->idempotency = NULL;
     }
+    request_arena_scratch_free(updated_json);
+}
 
-    /* For error responses, ensure intake_error_code is present in body */
-    if (status_code >= 400) {
-        json_error_t json_err3;
-        json_t *resp_root3 = json_loads(resp_buf, 0, &json_err3);
-        if (resp_root3 != NULL) {
-            json_t *err_obj = json_object_get(resp_root3, "error");
-            if (err_obj != NULL) {
-                json_t *intake_code_check = json_object_get(err_obj, "intake_error_code");
-                if (intake_code_check == NULL) {
-                    /* Add intake_error_code field (null if not present) */
-                    json_object_set_new(err_obj, "intake_error_code", 
-                                       intake_error_code ? json_string(intake_error_code) : json_null());
-                    char *updated_json = json_dumps(resp_root3, JSON_COMPACT);
-                    if (updated_json != NULL) {
-                        strncpy(resp_buf, updated_json, MAX_RESPONSE_SIZE - 1);
-                        resp_buf[MAX_RESPONSE_SIZE - 1] = '\0';
-                        free(updated_json);
-                    }
-                }
-            }
-            json_decref(resp_root3);
+/* ---------------- Asynchronous ingest ----------------
+ *
+ * POST /api/v1/messages with "Prefer: respond-async" skips the Router
+ * round trip: the validated RouteRequest is queued on the tenant's
+ * ingest subject and answered 202 at once. The batcher publishes it
+ * with others for the same tenant, and the consumer's JetStream-style
+ * ack settles the batch; a failed or missing ack is counted and sent to
+ * the tenant's SSE stream as "ingest_failed" with the message ids.
+ */
+
+static ingest_batcher_t *g_ingest = NULL;
+static const char *g_ingest_prefix = "beamline.router.v1.ingest";
+
+/* Does a Prefer header (RFC 7240) ask for respond-async? */
+static int prefer_respond_async(const char *value, size_t len) {
+    static const char token[] = "respond-async";
+    const size_t token_len = sizeof(token) - 1U;
+    size_t i = 0;
+    while (i < len) {
+        while (i < len && (value[i] == ' ' || value[i] == '\t' || value[i] == ',')) i++;
+        size_t start = i;
+        while (i < len && value[i] != ',' && value[i] != ';' && value[i] != '=' &&
+               value[i] != ' ' && value[i] != '\t') i++;
+        if (i - start == token_len && strncasecmp(value + start, token, token_len) == 0) {
+            return 1;
         }
+        while (i < len && value[i] != ',') i++;      /* Skip its parameters */
     }
+    return 0;
+}
 
-    send_response(client_fd, status_line, "application/json", resp_buf);
+/* A tenant id becomes one subject token: no dots, wildcards or spaces */
+static int ingest_subject_token_ok(const char *s) {
+    if (*s == '\0') return 0;
+    for (; *s; s++) {
+        char c = *s;
+        if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+              c == '-' || c == '_')) {
+            return 0;
+        }
+    }
+    return 1;
 }
 
-static void handle_client(int client_fd) {
-    char buffer[MAX_REQUEST_SIZE];
-    clock_t start_clock = clock();
-    struct timeval start_time, end_time;
-    gettimeofday(&start_time, NULL);
-    
-    ssize_t received = read(client_fd, buffer, sizeof(buffer) - 1U);
-    if (received <= 0) {
-        close(client_fd);
-        return;
+/* The ack arrives like a Router reply; an error in it fails the batch */
+static void ingest_on_ack(int status, const char *resp_json, void *closure) {
+    if (status == 0) {
+        router_reply_t reply;
+        if (router_reply_scan(resp_json, strlen(resp_json), &reply) != 0 ||
+            reply.has_error || reply.ok_false) {
+            status = -1;
+        }
     }
-    buffer[received] = '\0';
+    ingest_batch_done((ingest_batch_t *)closure, status);
+}
 
-    metric_requests_total++;
+static int ingest_send(ingest_batch_t *batch, void *arg) {
+    (void)arg;
+    return nats_publish_batch_async(batch->subject, batch->payload, ingest_on_ack, batch);
+}
 
-    /* Split headers and body by first \r\n\r\n */
-    char *headers_end = strstr(buffer, "\r\n\r\n");
-    char *body = NULL;
-    if (headers_end != NULL) {
-        *headers_end = '\0';
-        body = headers_end + 4; /* skip CRLF CRLF */
-    } else {
-        body = (char *)"";
+static void ingest_on_result(const ingest_batch_t *batch, int status, void *arg) {
+    (void)arg;
+    if (status == 0) {
+        return;
     }
+    log_throttled(&log_site_ingest_failed, "ingest", "Ingest batch of %zu messages on %s was not acknowledged",
+                  batch->count, batch->subject);
 
-    char *method = NULL;
-    char *path = NULL;
-    char *saveptr = NULL;
-
-    request_context_t ctx;
-    memset(&ctx, 0, sizeof(ctx));
-    
-    /* Extract client IP address */
-    char client_ip[64] = {0};
-    struct sockaddr_in client_addr;
-    socklen_t addr_len = sizeof(client_addr);
-    if (getpeername(client_fd, (struct sockaddr *)&client_addr, &addr_len) == 0) {
-        inet_ntop(AF_INET, &client_addr.sin_addr, client_ip, sizeof(client_ip));
-    } else {
-        strcpy(client_ip, "unknown");
+    /* Subjects are "<prefix>.<tenant>" */
+    const char *tenant_id = batch->subject + strlen(g_ingest_prefix) + 1U;
+    json_t *evt = json_object();
+    json_t *ids = json_array();
+    if (evt == NULL || ids == NULL) {
+        json_decref(evt);
+        json_decref(ids);
+        return;
     }
+    for (size_t i = 0; i < batch->count; i++) {
+        json_array_append_new(ids, json_string(batch->ids[i]));
+    }
+    json_object_set_new(evt, "subject", json_string(batch->subject));
+    json_object_set_new(evt, "message_ids", ids);
+    json_object_set_new(evt, "reason", json_string("publish_not_acknowledged"));
+    char *body = json_dumps(evt, JSON_COMPACT);
+    json_decref(evt);
+    if (body != NULL) {
+        sse_broadcast_json(tenant_id, "ingest_failed", body);
+        free(body);
+    }
+}
 
-    endpoint_id_t endpoint = ENDPOINT_UNKNOWN;
-    (void)endpoint; /* currently unused, but may be needed for future features */
-    int keep_open = 0; /* for SSE stream */
+/* ---------------- Route table ----------------
+ *
+ * Every endpoint is described once by a route_spec_t: its handler, the
+ * endpoint id, the rate-limit bucket and the request counter it feeds.
+ * The specs are compiled into a segment trie at startup, so dispatch
+ * costs one walk over the path and handlers never re-derive which
+ * endpoint they serve from method/path strings.
+ */
 
-    char *line = strtok_r(buffer, "\r\n", &saveptr);
-    if (line != NULL) {
-        method = strtok(line, " ");
-        path = strtok(NULL, " ");
-    }
+#define ROUTE_NO_RATE_LIMIT RL_ENDPOINT_MAX
 
-    /* Conflict Contract: Priority 3 - Request Gateway Validation (REQ_GW) */
-    if (method == NULL || path == NULL) {
-        send_error_response_with_conflict(client_fd,
-                            "HTTP/1.1 400 Bad Request",
-                            "invalid_request",
-                            "malformed request line",
-                            &ctx,
-                            CONFLICT_TYPE_REQUEST_GATEWAY,
-                            NULL);
-        gettimeofday(&end_time, NULL);
-        uint64_t duration_us = ((uint64_t)(end_time.tv_sec - start_time.tv_sec)) * 1000000ULL + 
-                              (uint64_t)(end_time.tv_usec - start_time.tv_usec);
-        metrics_record_http_request("UNKNOWN", "UNKNOWN", 400, duration_us);
-        // End span if created
-        if (ctx.otel_span) {
-            otel_span_set_attribute_int(ctx.otel_span, "http.status_code", 400);
-            otel_span_set_status(ctx.otel_span, SPAN_STATUS_ERROR);
-            otel_span_end(ctx.otel_span);
-        }
-        close(client_fd);
-        return;
+typedef enum {
+    ROUTE_DONE = 0,     /* Response sent; end the request span and return */
+    ROUTE_RETURN,       /* Response sent; return immediately */
+    ROUTE_PARKED        /* Waiting on the Router; the resume path answers */
+} route_result_t;
+
+typedef struct route_call route_call_t;
+typedef route_result_t (*route_handler_t)(route_call_t *call);
+
+typedef struct {
+    route_handler_t handler;
+    endpoint_id_t endpoint;
+    rl_endpoint_id_t rl_endpoint;            /* ROUTE_NO_RATE_LIMIT if none */
+    _Atomic unsigned long *requests;         /* Per-endpoint counter, NULL if none */
+} route_spec_t;
+
+struct route_call {
+    int client_fd;
+    const char *method;
+    const char *path;
+    char *body;
+    request_context_t *ctx;
+    otel_span_t *http_span;
+    const struct timeval *start_time;
+    int has_tenant_header;
+    int has_auth_header;
+    const char *idempotency_key;             /* Idempotency-Key value, not terminated */
+    size_t idempotency_key_len;
+    const char *if_none_match;               /* If-None-Match value, not terminated */
+    size_t if_none_match_len;
+    int respond_async;                       /* Prefer: respond-async */
+    http_reactor_ticket_t *ticket;           /* For parking on a Router call */
+    const route_spec_t *route;
+    http_route_match_t match;
+
+    /* Results */
+    int latency_ms;
+    int http_status_code;
+    int keep_open;                           /* SSE stream took the fd */
+};
+
+static http_route_table_t *gateway_routes = NULL;
+
+/* Copy a captured path parameter; returns 0 if the route did not capture it */
+static int route_param(const route_call_t *call, const char *name, char *out, size_t out_size) {
+    const http_route_param_t *p = http_route_match_param(&call->match, name);
+    if (!p) {
+        out[0] = '\0';
+        return 0;
     }
+    size_t n = p->len < out_size - 1U ? p->len : out_size - 1U;
+    memcpy(out, p->value, n);
+    out[n] = '\0';
+    return 1;
+}
 
-    /* Minimal header validation: X-Tenant-ID is required for API calls.
-     * Also extract X-Trace-ID into context if present, and optionally
-     * detect presence of Authorization header for auth skeleton.
-     */
-    int has_tenant_header = 0;
-    int has_auth_header   = 0;
-    const char *tenant_header_name = "X-Tenant-ID:";
-    const char *trace_header_name  = "X-Trace-ID:";
-    const char *traceparent_header_name = "traceparent:";
-    const char *auth_header_name   = "Authorization:";
-    
-    // Extract traceparent for OpenTelemetry tracing
-    const char *traceparent_value = NULL;
+static void route_end_span_with_status(const route_call_t *call, int status) {
+    if (call->ctx->otel_span) {
+        otel_span_set_attribute_int(call->ctx->otel_span, "http.status_code", status);
+        otel_span_set_status(call->ctx->otel_span, SPAN_STATUS_ERROR);
+        otel_span_end(call->ctx->otel_span);
+    }
+}
 
-    while ((line = strtok_r(NULL, "\r\n", &saveptr)) != NULL) {
-        if (strncmp(line, tenant_header_name, strlen(tenant_header_name)) == 0) {
-            has_tenant_header = 1;
-            const char *value = line + strlen(tenant_header_name);
-            while (*value == ' ' || *value == '\t') {
-                value++;
-            }
-            strncpy(ctx.tenant_id, value, sizeof(ctx.tenant_id) - 1U);
-            ctx.tenant_id[sizeof(ctx.tenant_id) - 1U] = '\0';
-        } else if (strncmp(line, trace_header_name, strlen(trace_header_name)) == 0) {
-            const char *value = line + strlen(trace_header_name);
-            while (*value == ' ' || *value == '\t') {
-                value++;
-            }
-            strncpy(ctx.trace_id, value, sizeof(ctx.trace_id) - 1U);
-            ctx.trace_id[sizeof(ctx.trace_id) - 1U] = '\0';
-        } else if (strncasecmp(line, traceparent_header_name, strlen(traceparent_header_name)) == 0) {
-            traceparent_value = line + strlen(traceparent_header_name);
-            while (*traceparent_value == ' ' || *traceparent_value == '\t') {
-                traceparent_value++;
-            }
-        } else if (strncmp(line, auth_header_name, strlen(auth_header_name)) == 0) {
-            has_auth_header = 1;
-        }
+static void route_count_request(const route_call_t *call) {
+    if (call->route->requests) {
+        (*call->route->requests)++;
     }
+}
 
-    // Extract trace context from traceparent header if present
-    otel_span_t *parent_span = NULL;
-    trace_id_t extracted_trace_id;
-    span_id_t extracted_span_id;
-    
-    if (traceparent_value && otel_extract_trace_context(traceparent_value, &extracted_trace_id, &extracted_span_id) == 0) {
-        // Create a temporary parent span from extracted context
-        // This allows us to create a child span with the correct trace_id
-        parent_span = calloc(1, sizeof(otel_span_t));
-        if (parent_span) {
-            memcpy(&parent_span->trace_id, &extracted_trace_id, sizeof(trace_id_t));
-            memcpy(&parent_span->span_id, &extracted_span_id, sizeof(span_id_t));
-        }
+/* Apply the route's rate limit; on rejection the 429 has been sent */
+static int route_rate_limited(const route_call_t *call, int end_span) {
+    unsigned int remaining = 0;
+    if (rate_limit_check(call->route->rl_endpoint, call->ctx->tenant_id, NULL, &remaining) == 0) {
+        return 0;
     }
-    
-    // Create HTTP request span (child of extracted parent if traceparent present)
-    otel_span_t *http_span = otel_span_start("gateway.http.request", SPAN_KIND_SERVER, parent_span);
-    if (http_span) {
-        otel_span_set_attribute(http_span, "http.method", method);
-        otel_span_set_attribute(http_span, "http.url", path);
+    send_rate_limit_error(call->client_fd, call->route->rl_endpoint, call->ctx);
+    if (end_span) {
+        route_end_span_with_status(call, 429);
+    }
+    return 1;
+}
+
+static void route_record_latency(route_call_t *call) {
+    call->latency_ms = record_latency_since(call->start_time);
+}
+
+/* Common tail of endpoints that report a 200 to metrics and the log */
+static void route_finish_ok(route_call_t *call) {
+    struct timeval end_time;
+    route_record_latency(call);
+    gettimeofday(&end_time, NULL);
+    uint64_t duration_us = ((uint64_t)(end_time.tv_sec - call->start_time->tv_sec)) * 1000000ULL +
+                          (uint64_t)(end_time.tv_usec - call->start_time->tv_usec);
+    metrics_record_http_request(call->method, call->path, 200, duration_us);
+    call->http_status_code = 200;
+    log_info("http_request", call->ctx, call->method, call->path, 200, call->latency_ms);
+}
+
+static route_result_t route_health(route_call_t *call) {
+    handle_health(call->client_fd);
+    route_finish_ok(call);
+    return ROUTE_DONE;
+}
+
+static route_result_t route_metrics_json(route_call_t *call) {
+    handle_metrics_json(call->client_fd);
+    route_finish_ok(call);
+    return ROUTE_DONE;
+}
+
+static route_result_t route_log_settings(route_call_t *call) {
+    handle_log_settings(call->client_fd);
+    route_finish_ok(call);
+    return ROUTE_DONE;
+}
+
+/* PUT /_log: change throttle settings at runtime */
+static route_result_t route_log_settings_update(route_call_t *call) {
+    if (auth_required && !call->has_auth_header) {
+        send_error_response(call->client_fd, "HTTP/1.1 401 Unauthorized", "unauthorized",
+                            "missing Authorization header", call->ctx);
+        return ROUTE_RETURN;
+    }
+    log_throttle_config_t config;
+    log_throttle_get_config(&config);
+    const char *error = NULL;
+    if (parse_log_settings(call->body, &config, &error) != 0 || log_throttle_configure(&config) != 0) {
+        send_error_response(call->client_fd, "HTTP/1.1 400 Bad Request", "invalid_request",
+                            error ? error : "invalid log settings", call->ctx);
+        return ROUTE_RETURN;
+    }
+    log_json("info", "main", "Log throttle settings changed: level=%s rate_per_sec=%d burst=%d",
+             log_level_name(config.level), config.rate_per_sec, config.burst);
+    handle_log_settings(call->client_fd);
+    route_finish_ok(call);
+    return ROUTE_DONE;
+}
+
+static route_result_t route_metrics(route_call_t *call) {
+    struct timeval metrics_start_time, metrics_end_time;
+    gettimeofday(&metrics_start_time, NULL);
+    nats_client_collect_metrics();
+    if (g_ingest != NULL) {
+        ingest_batcher_stats_t ingest_stats;
+        ingest_batcher_get_stats(g_ingest, &ingest_stats);
+        metrics_update_ingest(&ingest_stats);
+    }
+    if (handle_metrics_request(call->client_fd, tls_keep_alive) != 0) {
+        /* Export or send failed part-way; the framing cannot be trusted */
+        tls_keep_alive = 0;
+    }
+    gettimeofday(&metrics_end_time, NULL);
+    uint64_t duration_us = ((uint64_t)(metrics_end_time.tv_sec - metrics_start_time.tv_sec)) * 1000000ULL +
+                          (uint64_t)(metrics_end_time.tv_usec - metrics_start_time.tv_usec);
+    route_record_latency(call);
+    metrics_record_http_request(call->method, call->path, 200, duration_us);
+    call->http_status_code = 200;
+    log_info("http_request", call->ctx, call->method, call->path, 200, call->latency_ms);
+    return ROUTE_DONE;
+}
+
+/* ---------------- Parked Router calls ----------------
+ *
+ * A Router request is submitted asynchronously and the connection is
+ * parked, so the reactor thread keeps serving other sockets while NATS
+ * is in flight. The request state moves to the heap (router_call_t);
+ * the NATS reply callback, on whatever thread delivers it, hands it back
+ * to the reactor, whose resume step renders the answer.
+ *
+ * The reply may also arrive before the handler had a chance to park (the
+ * stub client answers inline). The state word settles the race: whoever
+ * moves it off ROUTER_CALL_SUBMITTING first decides that the handler
+ * answers inline (reply first) or the resume path does (park first).
+ */
+
+typedef void (*router_reply_fn)(int client_fd, request_context_t *ctx, int rc, const char *resp);
+typedef void (*route_finish_fn)(route_call_t *call);
+
+enum {
+    ROUTER_CALL_SUBMITTING = 0,
+    ROUTER_CALL_PARKED,
+    ROUTER_CALL_REPLIED
+};
+
+typedef struct {
+    http_reactor_ticket_t *ticket;
+    atomic_int state;
+    route_call_t call;                       /* ctx and start_time point below */
+    request_context_t ctx;
+    struct timeval start_time;
+    otel_span_t *nats_span;
+    router_reply_fn reply;
+    route_finish_fn finish;                  /* Route's metrics/log tail */
+    int status;                              /* Router call result */
+    char *resp;                              /* Router JSON (heap), NULL on error */
+} router_call_t;
+
+/* Render a Router answer and run the route's tail */
+static route_result_t router_call_answer(route_call_t *call, router_reply_fn reply,
+                                         route_finish_fn finish, int status, const char *resp) {
+    reply(call->client_fd, call->ctx, status, resp);
+    finish(call);
+    return ROUTE_DONE;
+}
+
+static router_call_t *router_call_new(route_call_t *call, router_reply_fn reply, route_finish_fn finish) {
+    router_call_t *rc = calloc(1, sizeof(*rc));
+    if (!rc) {
+        return NULL;
+    }
+    rc->ticket = call->ticket;
+    atomic_init(&rc->state, ROUTER_CALL_SUBMITTING);
+    rc->call = *call;
+    rc->ctx = *call->ctx;
+    rc->start_time = *call->start_time;
+    rc->call.ctx = &rc->ctx;
+    rc->call.start_time = &rc->start_time;
+    rc->reply = reply;
+    rc->finish = finish;
+    rc->status = -1;
+    return rc;
+}
+
+static void router_call_free(router_call_t *rc) {
+    free(rc->resp);
+    free(rc);
+}
+
+static void router_call_end_nats_span(router_call_t *rc) {
+    if (rc->nats_span) {
+        otel_span_set_status(rc->nats_span, (rc->status == 0) ? SPAN_STATUS_OK : SPAN_STATUS_ERROR);
+        otel_span_end(rc->nats_span);
+        rc->nats_span = NULL;
+    }
+}
+
+/* Runs on the connection's reactor thread once the Router has answered */
+static http_conn_action_t router_call_resume(int fd, int keep_alive, void *arg) {
+    router_call_t *rc = (router_call_t *)arg;
+    route_call_t *call = &rc->call;
+    (void)fd;
+
+    tls_keep_alive = keep_alive;
+    request_arena_begin();
+    router_call_end_nats_span(rc);
+    (void)router_call_answer(call, rc->reply, rc->finish, rc->status, rc->resp);
+
+    // End HTTP span with status
+    if (call->http_span) {
+        otel_span_set_attribute_int(call->http_span, "http.status_code", call->http_status_code);
+        otel_span_set_status(call->http_span,
+                             (call->http_status_code < 400) ? SPAN_STATUS_OK : SPAN_STATUS_ERROR);
+        otel_span_end(call->http_span);
+    }
+    http_conn_action_t action = response_conn_action();
+    request_arena_end();
+    router_call_free(rc);
+    return action;
+}
+
+/* Hand a settled call to whoever answers it: the handler if it has not
+ * parked yet, else the connection's reactor */
+static void router_call_settle(router_call_t *rc) {
+    int expected = ROUTER_CALL_SUBMITTING;
+    if (atomic_compare_exchange_strong(&rc->state, &expected, ROUTER_CALL_REPLIED)) {
+        return;                              /* The handler answers inline */
+    }
+    http_reactor_resume(rc->ticket, router_call_resume, rc);
+}
+
+/* nats_reply_cb_t: any thread, exactly once per submitted call */
+static void router_call_on_reply(int status, const char *resp_json, void *closure) {
+    router_call_t *rc = (router_call_t *)closure;
+
+    rc->status = status;
+    if (status == 0 && resp_json != NULL) {
+        rc->resp = strdup(resp_json);
+        if (rc->resp == NULL) {
+            rc->status = -1;
+        }
+    }
+    router_call_settle(rc);
+}
+
+/*
+ * Park the connection on a submitted Router call, or answer right away
+ * when the reply already came back or the submit failed (submitted != 0).
+ */
+static route_result_t router_call_park(route_call_t *call, router_call_t *rc, int submitted) {
+    int expected = ROUTER_CALL_SUBMITTING;
+    if (submitted == 0 &&
+        atomic_compare_exchange_strong(&rc->state, &expected, ROUTER_CALL_PARKED)) {
+        /* Spans outlive this request's arena scope */
+        rc->call.http_span = request_arena_scratch_detach(rc->call.http_span, sizeof(otel_span_t));
+        rc->ctx.otel_span = rc->call.http_span;
+        rc->nats_span = request_arena_scratch_detach(rc->nats_span, sizeof(otel_span_t));
+        if (rc->nats_span) {
+            rc->nats_span->parent = rc->call.http_span;
+        }
+        return ROUTE_PARKED;
+    }
+
+    router_call_end_nats_span(rc);
+    route_result_t result = router_call_answer(call, rc->reply, rc->finish, rc->status, rc->resp);
+    router_call_free(rc);
+    return result;
+}
+
+/* ---------------- Idempotency-Key ----------------
+ *
+ * A decide request carrying an Idempotency-Key claims the key before its
+ * Router call and publishes the answer when decide_reply sends it. A
+ * retry of a completed request is answered from the cache; one arriving
+ * while the first is still in flight is parked like a Router call and
+ * woken with the same answer, so retries never reach the Router twice.
+ */
+static idempotency_cache_t *g_idempotency = NULL;
+
+static void send_replayed_response(int client_fd, int status_code, const char *body, size_t len) {
+    http_response_t resp;
+    http_response_init(&resp, decide_status_line(status_code));
+    http_response_add_raw(&resp, HTTP_RESPONSE_CONTENT_TYPE_JSON);
+    http_response_add_header(&resp, "Idempotent-Replayed", "true");
+    (void)http_response_send(&resp, client_fd, tls_keep_alive, body, len);
+}
+
+/* router_reply_fn of a parked duplicate: rc is the stored status, -1 if none */
+static void decide_replay_reply(int client_fd, request_context_t *ctx, int rc, const char *resp_buf) {
+    if (rc < 0 || resp_buf == NULL) {
+        /* The first request got no Router answer; neither does this one */
+        decide_reply(client_fd, ctx, -1, NULL);
+        return;
+    }
+    send_replayed_response(client_fd, rc, resp_buf, strlen(resp_buf));
+}
+
+/* idempotency_waiter_fn: the request this one repeats was answered, so
+ * the parked call settles with its status and body */
+static void router_call_on_cached_response(const idempotency_response_t *response, void *closure) {
+    router_call_t *rc = (router_call_t *)closure;
+
+    rc->status = -1;
+    if (response != NULL) {
+        rc->resp = strdup(response->body);
+        if (rc->resp != NULL) {
+            rc->status = response->status;
+        }
+    }
+    idempotency_response_release(response);
+    router_call_settle(rc);
+}
+
+/*
+ * Returns 0 to go on to the Router, holding the key's claim in ctx when
+ * the request has a key, or 1 with *result set once the request was
+ * answered or parked behind the one it repeats.
+ */
+static int decide_idempotency(route_call_t *call, route_result_t *result) {
+    if (g_idempotency == NULL || call->idempotency_key == NULL) {
+        return 0;
+    }
+    *result = ROUTE_DONE;
+    if (call->idempotency_key_len == 0 || call->idempotency_key_len > IDEMPOTENCY_KEY_MAX) {
+        send_error_response(call->client_fd, "HTTP/1.1 400 Bad Request", "invalid_request",
+                            "invalid Idempotency-Key header", call->ctx);
+        route_finish_ok(call);
+        return 1;
+    }
+
+    /* Keys are scoped to the tenant and the endpoint */
+    char key[512];
+    int n = snprintf(key, sizeof(key), "%s\n%.*s\n%.*s", call->ctx->tenant_id,
+                     (int)strcspn(call->path, "?"), call->path,
+                     (int)call->idempotency_key_len, call->idempotency_key);
+    if (n < 0 || (size_t)n >= sizeof(key)) {
+        return 0;
+    }
+    uint64_t fingerprint = idempotency_cache_fingerprint(call->body, call->ctx->body_len);
+
+    router_call_t *waiter = router_call_new(call, decide_replay_reply, route_finish_ok);
+    idempotency_claim_t *claim = NULL;
+    const idempotency_response_t *hit = NULL;
+    idempotency_result_t found = idempotency_cache_begin(g_idempotency, key, (size_t)n, fingerprint,
+                                                         waiter ? router_call_on_cached_response : NULL,
+                                                         waiter, &claim, &hit);
+    if (found == IDEMPOTENCY_WAITING) {
+        metrics_record_idempotency_hit();
+        *result = router_call_park(call, waiter, 0);
+        return 1;
+    }
+    if (waiter) {
+        router_call_free(waiter);
+    }
+
+    switch (found) {
+        case IDEMPOTENCY_MISS:
+            metrics_record_idempotency_miss();
+            call->ctx->idempotency = claim;
+            return 0;
+        case IDEMPOTENCY_HIT:
+            metrics_record_idempotency_hit();
+            send_replayed_response(call->client_fd, hit->status, hit->body, hit->len);
+            idempotency_response_release(hit);
+            break;
+        case IDEMPOTENCY_MISMATCH:
+            send_error_response(call->client_fd, "HTTP/1.1 422 Unprocessable Entity", "invalid_request",
+                                "Idempotency-Key reused with a different request body", call->ctx);
+            break;
+        case IDEMPOTENCY_BUSY:
+            send_error_response(call->client_fd, "HTTP/1.1 409 Conflict", "conflict",
+                                "a request with this Idempotency-Key is in progress", call->ctx);
+            break;
+        default:
+            return 0;                        /* Out of memory: serve it uncached */
+    }
+    route_finish_ok(call);
+    return 1;
+}
+
+/* ---------------- Decision cache ----------------
+ *
+ * Clients poll GET /api/v1/routes/decide/:message_id until the decision
+ * shows up. Decisions are immutable once made, so the answer is kept per
+ * tenant and message and later polls never reach the Router; "not found"
+ * is kept briefly so a hot poll loop costs one Router call per negative
+ * TTL. Polls arriving while a lookup is in flight park behind it, the
+ * same way Idempotency-Key duplicates do. get_decision_reply decides
+ * what is kept and for how long.
+ */
+static idempotency_cache_t *g_decisions = NULL;
+
+/* router_reply_fn of a poll answered from the cache: rc is the stored
+ * status, -1 if the lookup it waited on failed */
+static void get_decision_cached_reply(int client_fd, request_context_t *ctx, int rc, const char *resp_buf)
+{
+    if (rc < 0 || resp_buf == NULL) {
+        get_decision_reply(client_fd, ctx, -1, NULL);
+        return;
+    }
+    send_response(client_fd, router_lookup_status_line(rc), "application/json", resp_buf);
+}
+
+/*
+ * Returns 0 to go on to the Router, holding the message's claim in ctx
+ * when the cache handed one out, or 1 with *result set once the poll was
+ * answered or parked behind the lookup in flight.
+ */
+static int get_decision_cached(route_call_t *call, const char *message_id, route_result_t *result) {
+    if (g_decisions == NULL) {
+        return 0;
+    }
+
+    char key[512];
+    int n = snprintf(key, sizeof(key), "%s\n%s", call->ctx->tenant_id, message_id);
+    if (n < 0 || (size_t)n >= sizeof(key)) {
+        return 0;
+    }
+
+    router_call_t *waiter = router_call_new(call, get_decision_cached_reply, route_record_latency);
+    idempotency_claim_t *claim = NULL;
+    const idempotency_response_t *hit = NULL;
+    idempotency_result_t found = idempotency_cache_begin(g_decisions, key, (size_t)n, 0,
+                                                         waiter ? router_call_on_cached_response : NULL,
+                                                         waiter, &claim, &hit);
+    if (found == IDEMPOTENCY_WAITING) {
+        metrics_record_decision_cache_coalesced();
+        *result = router_call_park(call, waiter, 0);
+        return 1;
+    }
+    if (waiter) {
+        router_call_free(waiter);
+    }
+
+    if (found == IDEMPOTENCY_HIT) {
+        metrics_record_decision_cache_hit();
+        send_response(call->client_fd, router_lookup_status_line(hit->status), "application/json", hit->body);
+        idempotency_response_release(hit);
+        route_record_latency(call);
+        *result = ROUTE_DONE;
+        return 1;
+    }
+    if (found == IDEMPOTENCY_MISS) {
+        metrics_record_decision_cache_miss();
+        call->ctx->decision = claim;
+    }
+    return 0;                                /* Busy or out of memory: ask uncached */
+}
+
+/* ---------------- Admin views ----------------
+ *
+ * Extension health, circuit breaker states and pipeline complexity are
+ * polled by monitoring every few seconds from many places but change
+ * slowly, so each is served from an admin_view_cache view that a
+ * background thread keeps fresh while it is being read. Only the first
+ * read of a view waits on the Router. Views carry an ETag, and a
+ * matching If-None-Match gets a 304.
+ *
+ * View keys name the Router lookup: the two extension views, or
+ * "complexity\n<tenant_id>\n<policy_id>".
+ */
+static admin_view_cache_t *g_admin_views = NULL;
+
+#define ADMIN_VIEW_EXTENSION_HEALTH  "extensions/health"
+#define ADMIN_VIEW_CIRCUIT_BREAKERS  "extensions/circuit-breakers"
+#define ADMIN_VIEW_COMPLEXITY        "complexity\n"
+
+/* nats_reply_cb_t of an extension view fetch: always answered with 200 */
+static void admin_view_on_reply(int status, const char *resp_json, void *closure) {
+    admin_view_fetch_t *fetch = (admin_view_fetch_t *)closure;
+    if (status != 0 || resp_json == NULL) {
+        admin_view_cache_publish(fetch, 0, NULL, 0);
+        return;
+    }
+    admin_view_cache_publish(fetch, 0, resp_json, strlen(resp_json));
+}
+
+/* nats_reply_cb_t of a complexity view fetch: keeps the Router error status */
+static void admin_view_on_lookup_reply(int status, const char *resp_json, void *closure) {
+    admin_view_fetch_t *fetch = (admin_view_fetch_t *)closure;
+    if (status != 0 || resp_json == NULL) {
+        admin_view_cache_publish(fetch, 0, NULL, 0);
+        return;
+    }
+    admin_view_cache_publish(fetch, map_router_error_status(resp_json), resp_json, strlen(resp_json));
+}
+
+/* admin_view_fetch_fn: ask the Router for the lookup a view key names */
+static void admin_view_fetch(admin_view_fetch_t *fetch, const char *key, size_t key_len, void *arg) {
+    (void)arg;
+    int submitted = -1;
+    size_t prefix = sizeof(ADMIN_VIEW_COMPLEXITY) - 1U;
+
+    if (key_len == strlen(ADMIN_VIEW_EXTENSION_HEALTH) &&
+        memcmp(key, ADMIN_VIEW_EXTENSION_HEALTH, key_len) == 0) {
+        submitted = nats_request_get_extension_health_async(admin_view_on_reply, fetch);
+    } else if (key_len == strlen(ADMIN_VIEW_CIRCUIT_BREAKERS) &&
+               memcmp(key, ADMIN_VIEW_CIRCUIT_BREAKERS, key_len) == 0) {
+        submitted = nats_request_get_circuit_breaker_states_async(admin_view_on_reply, fetch);
+    } else if (key_len > prefix && memcmp(key, ADMIN_VIEW_COMPLEXITY, prefix) == 0) {
+        /* The key may go away once the reply is published; copy it out */
+        char tenant_id[64];
+        char policy_id[64];
+        const char *sep = memchr(key + prefix, '\n', key_len - prefix);
+        if (sep != NULL) {
+            int n = snprintf(tenant_id, sizeof(tenant_id), "%.*s", (int)(sep - key - (ptrdiff_t)prefix),
+                             key + prefix);
+            int m = snprintf(policy_id, sizeof(policy_id), "%.*s", (int)(key + key_len - sep - 1), sep + 1);
+            if (n > 0 && m > 0 && (size_t)n < sizeof(tenant_id) && (size_t)m < sizeof(policy_id)) {
+                submitted = nats_request_get_pipeline_complexity_async(tenant_id, policy_id,
+                                                                       admin_view_on_lookup_reply, fetch);
+            }
+        }
+    }
+    if (submitted != 0) {
+        admin_view_cache_publish(fetch, 0, NULL, 0);
+    }
+}
+
+/* Send a view, or 304 when If-None-Match shows the client already has it */
+static void send_admin_view(int client_fd, const char *if_none_match, size_t if_none_match_len,
+                            int status, const char *body, size_t len, const char *etag) {
+    const char *status_line = router_lookup_status_line(status);
+    http_response_t resp;
+    if (strcmp(status_line, "HTTP/1.1 200 OK") == 0 &&
+        admin_view_etag_matches(etag, if_none_match, if_none_match_len)) {
+        http_response_init(&resp, "HTTP/1.1 304 Not Modified");
+        http_response_add_header(&resp, "ETag", etag);
+        (void)http_response_send_head(&resp, client_fd, tls_keep_alive);
+        return;
+    }
+    http_response_init(&resp, status_line);
+    http_response_add_raw(&resp, HTTP_RESPONSE_CONTENT_TYPE_JSON);
+    http_response_add_header(&resp, "ETag", etag);
+    (void)http_response_send(&resp, client_fd, tls_keep_alive, body, len);
+}
+
+/* router_reply_fn of a read that waited on a view's first fetch: rc is
+ * the view status, -1 if the fetch failed */
+static void admin_view_loaded_reply(int client_fd, request_context_t *ctx, int rc, const char *resp_buf) {
+    if (rc < 0 || resp_buf == NULL) {
+        send_error_response(client_fd,
+                            "HTTP/1.1 503 Service Unavailable",
+                            "SERVICE_UNAVAILABLE",
+                            "Router or NATS unavailable",
+                            ctx);
+        return;
+    }
+    /* The request's headers are gone by now; answer in full */
+    char etag[ADMIN_VIEW_ETAG_MAX];
+    size_t len = strlen(resp_buf);
+    admin_view_etag(rc, resp_buf, len, etag);
+    send_admin_view(client_fd, NULL, 0, rc, resp_buf, len, etag);
+}
+
+/* admin_view_waiter_fn: the first fetch of the view landed */
+static void router_call_on_admin_view(const admin_view_t *view, void *closure) {
+    router_call_t *rc = (router_call_t *)closure;
+
+    rc->status = -1;
+    if (view != NULL) {
+        rc->resp = strdup(view->body);
+        if (rc->resp != NULL) {
+            rc->status = view->status;
+        }
+    }
+    admin_view_release(view);
+    router_call_settle(rc);
+}
+
+/*
+ * Returns 0 to ask the Router directly (no cache, or too many views), or
+ * 1 with *result set once the request was answered from its view or
+ * parked on the view's first fetch.
+ */
+static int admin_view_serve(route_call_t *call, const char *key, size_t key_len, route_result_t *result) {
+    if (g_admin_views == NULL) {
+        return 0;
+    }
+
+    router_call_t *waiter = router_call_new(call, admin_view_loaded_reply, route_finish_ok);
+    const admin_view_t *view = NULL;
+    admin_view_result_t found = admin_view_cache_get(g_admin_views, key, key_len,
+                                                     waiter ? router_call_on_admin_view : NULL,
+                                                     waiter, &view);
+    if (found == ADMIN_VIEW_WAITING) {
+        *result = router_call_park(call, waiter, 0);
+        return 1;
+    }
+    if (waiter) {
+        router_call_free(waiter);
+    }
+    if (found != ADMIN_VIEW_HIT) {
+        return 0;
+    }
+    send_admin_view(call->client_fd, call->if_none_match, call->if_none_match_len, view->status,
+                    view->body, view->len, view->etag);
+    admin_view_release(view);
+    route_finish_ok(call);
+    *result = ROUTE_DONE;
+    return 1;
+}
+
+/* GET|POST|PUT|DELETE /api/v1/registry/blocks/:type/:version (version may hold slashes) */
+static route_result_t route_registry_block(route_call_t *call) {
+    char type[128];
+    char version[256];
+    (void)route_param(call, "type", type, sizeof(type));
+    if (!route_param(call, "version", version, sizeof(version))) {
+        send_error_response(call->client_fd, "HTTP/1.1 400 Bad Request", "invalid_request", "missing version segment", call->ctx);
+        route_record_latency(call);
+        return ROUTE_RETURN;
+    }
+    if (version[0] == '\0') {
+        send_error_response(call->client_fd, "HTTP/1.1 400 Bad Request", "invalid_request", "empty version", call->ctx);
+        route_record_latency(call);
+        route_end_span_with_status(call, 400);
+        return ROUTE_RETURN;
+    }
+
+    /* Apply rate limiting to registry endpoints */
+    if (route_rate_limited(call, 1)) {
+        return ROUTE_RETURN;
+    }
+
+    if (call->route->endpoint == ENDPOINT_REGISTRY_GET) {
+        handle_registry_get(call->client_fd, type, version, call->if_none_match, call->if_none_match_len);
+    } else if (call->route->endpoint == ENDPOINT_REGISTRY_DELETE) {
+        handle_registry_delete(call->client_fd, type, version);
+    } else {
+        handle_registry_write_common(call->client_fd, call->method, type, version, call->body);
+    }
+    route_record_latency(call);
+    log_info("http_request", call->ctx, call->method, call->path, 200, call->latency_ms);
+    return ROUTE_DONE;
+}
+
+/* GET /api/v1/routes/decide/:message_id */
+static route_result_t route_get_decision(route_call_t *call) {
+    char message_id[256];
+    (void)route_param(call, "message_id", message_id, sizeof(message_id));
+    if (message_id[0] == '\0') {
+        send_error_response(call->client_fd,
+                            "HTTP/1.1 400 Bad Request",
+                            "invalid_request",
+                            "missing message_id path parameter",
+                            call->ctx);
+        route_end_span_with_status(call, 400);
+        return ROUTE_RETURN;
+    }
+
+    /* Apply rate limiting to GET /api/v1/routes/decide/:messageId */
+    if (route_rate_limited(call, 1)) {
+        return ROUTE_RETURN;
+    }
+
+    route_count_request(call);
+    if (get_decision_check(call->client_fd, message_id, call->ctx) != 0) {
+        route_record_latency(call);
+        return ROUTE_DONE;
+    }
+    route_result_t cached;
+    if (get_decision_cached(call, message_id, &cached) != 0) {
+        return cached;
+    }
+    /* get_decision_reply sends the response and logs errors if needed */
+    router_call_t *rc = router_call_new(call, get_decision_reply, route_record_latency);
+    if (!rc) {
+        return router_call_answer(call, get_decision_reply, route_record_latency, -1, NULL);
+    }
+    int submitted = nats_request_get_decision_async(call->ctx->tenant_id, message_id,
+                                                    router_call_on_reply, rc);
+    return router_call_park(call, rc, submitted);
+}
+
+/* Shared checks of PUT/DELETE /api/v1/messages/:message_id */
+static int message_route_prologue(route_call_t *call, char *message_id, size_t size) {
+    (void)route_param(call, "message_id", message_id, size);
+    if (message_id[0] == '\0') {
+        send_error_response(call->client_fd, "HTTP/1.1 400 Bad Request", "invalid_request", "missing message_id", call->ctx);
+        return -1;
+    }
+    if (call->ctx->tenant_id[0] == '\0') {
+        send_error_response(call->client_fd, "HTTP/1.1 400 Bad Request", "invalid_request", "missing X-Tenant-ID header", call->ctx);
+        return -1;
+    }
+    /* Apply rate limiting to messages endpoints */
+    if (route_rate_limited(call, 0)) {
+        return -1;
+    }
+    return 0;
+}
+
+/* Minimal CP1 handler to emit the SSE update */
+static route_result_t route_message_update(route_call_t *call) {
+    char message_id[256];
+    if (message_route_prologue(call, message_id, sizeof(message_id)) != 0) {
+        return ROUTE_RETURN;
+    }
+    const char *body = call->body;
+    if (body == NULL || body[0] == '\0') {
+        send_error_response(call->client_fd, "HTTP/1.1 400 Bad Request", "invalid_request", "empty body", call->ctx);
+        route_end_span_with_status(call, 400);
+        return ROUTE_RETURN;
+    }
+    /* validate JSON and broadcast */
+    json_error_t jerr; json_t *root = json_loads(body, 0, &jerr);
+    if (!root || !json_is_object(root)) {
+        if (root) json_decref(root);
+        send_error_response(call->client_fd, "HTTP/1.1 400 Bad Request", "invalid_request", "invalid JSON", call->ctx);
+        route_end_span_with_status(call, 400);
+        return ROUTE_RETURN;
+    }
+    /* enforce message_id match if present in body */
+    json_t *mid = json_object_get(root, "message_id");
+    if (mid && json_is_string(mid)) {
+        const char *mid_s = json_string_value(mid);
+        if (strcmp(mid_s, message_id) != 0) {
+            json_decref(root);
+            send_error_response(call->client_fd, "HTTP/1.1 409 Conflict", "conflict", "message_id mismatch with path", call->ctx);
+            route_end_span_with_status(call, 409);
+            return ROUTE_RETURN;
+        }
+    }
+    send_response(call->client_fd, "HTTP/1.1 200 OK", "application/json", body);
+    sse_broadcast_json(call->ctx->tenant_id, "message_updated", body);
+    json_decref(root);
+    route_record_latency(call);
+    return ROUTE_DONE;
+}
+
+/* Minimal CP1 handler to emit the SSE delete */
+static route_result_t route_message_delete(route_call_t *call) {
+    char message_id[256];
+    if (message_route_prologue(call, message_id, sizeof(message_id)) != 0) {
+        return ROUTE_RETURN;
+    }
+    char resp[256];
+    int len = snprintf(resp, sizeof(resp), "{\"status\":\"deleted\",\"message_id\":\"%s\"}", message_id);
+    if (len < 0 || (size_t)len >= sizeof(resp)) {
+        send_error_response(call->client_fd, "HTTP/1.1 400 Bad Request", "invalid_request", "bad message_id", call->ctx);
+        return ROUTE_RETURN;
+    }
+    send_response(call->client_fd, "HTTP/1.1 200 OK", "application/json", resp);
+    char evt[128];
+    int l = snprintf(evt, sizeof(evt), "{\"message_id\":\"%s\"}", message_id);
+    if (l > 0 && (size_t)l < sizeof(evt)) {
+        sse_broadcast_json(call->ctx->tenant_id, "message_deleted", evt);
+    }
+    route_record_latency(call);
+    return ROUTE_DONE;
+}
+
+static route_result_t route_message_stream(route_call_t *call) {
+    char tenant_q[64]; tenant_q[0] = '\0';
+    if (!query_get_param(call->path, "tenant_id", tenant_q, sizeof(tenant_q)) || tenant_q[0] == '\0') {
+        send_error_response(call->client_fd,
+                            "HTTP/1.1 400 Bad Request",
+                            "invalid_request",
+                            "missing tenant_id",
+                            call->ctx);
+        return ROUTE_RETURN;
+    }
+    if (sse_register_client(call->client_fd, tenant_q) == 0) {
+        call->keep_open = 1;
+    } else {
+        /* Pool full or the stream head failed: always close, the
+         * request never got a framed response to keep alive after */
+        tls_keep_alive = 0;
+    }
+    route_record_latency(call);
+    return ROUTE_DONE;
+}
+
+/* Queue a validated RouteRequest for asynchronous ingest and answer 202 */
+static route_result_t ingest_accept(route_call_t *call, const char *route_req_json) {
+    request_context_t *ctx = call->ctx;
+    char subject[256];
+    int n = snprintf(subject, sizeof(subject), "%s.%s", g_ingest_prefix, ctx->tenant_id);
+    if (!ingest_subject_token_ok(ctx->tenant_id) || n < 0 || (size_t)n >= sizeof(subject)) {
+        idempotency_cache_abandon(ctx->idempotency);
+        ctx->idempotency = NULL;
+        send_error_response(call->client_fd, "HTTP/1.1 400 Bad Request", "invalid_request",
+                            "X-Tenant-ID cannot be used for asynchronous ingest", ctx);
+        return ROUTE_RETURN;
+    }
+    if (ingest_batcher_submit(g_ingest, subject, ctx->request_id, route_req_json,
+                              strlen(route_req_json)) != 0) {
+        idempotency_cache_abandon(ctx->idempotency);
+        ctx->idempotency = NULL;
+        send_error_response_with_retry_after(call->client_fd,
+                                            "HTTP/1.1 503 Service Unavailable",
+                                            "service_overloaded",
+                                            "ingest queue is full, please retry later",
+                                            1,
+                                            ctx);
+        route_end_span_with_status(call, 503);
+        return ROUTE_RETURN;
+    }
+
+    char body[768];
+    int len = snprintf(body, sizeof(body),
+                       "{\"ok\":true,\"status\":\"accepted\",\"message_id\":\"%s\",\"subject\":\"%s\","
+                       "\"context\":{\"request_id\":\"%s\",\"trace_id\":\"%s\",\"tenant_id\":\"%s\"}}",
+                       ctx->request_id, subject, ctx->request_id, ctx->trace_id, ctx->tenant_id);
+    size_t body_len = len > 0 && (size_t)len < sizeof(body) ? (size_t)len : strlen(body);
+    http_response_t resp;
+    http_response_init(&resp, "HTTP/1.1 202 Accepted");
+    http_response_add_raw(&resp, HTTP_RESPONSE_CONTENT_TYPE_JSON);
+    http_response_add_header(&resp, "Preference-Applied", "respond-async");
+    (void)http_response_send(&resp, call->client_fd, tls_keep_alive, body, body_len);
+
+    if (ctx->idempotency != NULL) {
+        idempotency_cache_complete(ctx->idempotency, 202, body, body_len, IDEMPOTENCY_TTL_DEFAULT);
+        ctx->idempotency = NULL;
+    }
+    route_finish_ok(call);
+    return ROUTE_DONE;
+}
+
+/* POST /api/v1/routes/decide and POST /api/v1/messages */
+static route_result_t route_decide(route_call_t *call) {
+    /* Conflict Contract: Priority 2 - Authentication Gateway (AUTH_GW) */
+    if (auth_required && !call->has_auth_header) {
+        send_error_response_with_conflict(call->client_fd,
+                            "HTTP/1.1 401 Unauthorized",
+                            "unauthorized",
+                            "missing Authorization header",
+                            call->ctx,
+                            CONFLICT_TYPE_AUTH_GATEWAY,
+                            NULL);
+        return ROUTE_RETURN;
+    }
+
+    /* Conflict Contract: Priority 3 - Request Gateway Validation (REQ_GW) */
+    if (!call->has_tenant_header) {
+        send_error_response_with_conflict(call->client_fd,
+                            "HTTP/1.1 400 Bad Request",
+                            "invalid_request",
+                            "missing X-Tenant-ID header",
+                            call->ctx,
+                            CONFLICT_TYPE_REQUEST_GATEWAY,
+                            NULL);
+        return ROUTE_RETURN;
+    }
+
+    if (call->route->endpoint == ENDPOINT_ROUTES_DECIDE_POST) {
+        if (rate_limit_check_routes_decide(call->client_fd, call->ctx) != 0) {
+            /* Enhanced 429 error response is already sent by send_rate_limit_error */
+            route_end_span_with_status(call, 429);
+            return ROUTE_RETURN;
+        }
+        route_count_request(call);
+    } else if (route_rate_limited(call, 1)) {
+        /* POST /api/v1/messages: no endpoint-specific metric yet */
+        return ROUTE_RETURN;
+    }
+
+    /* Для успешного кейса логируем 200, коды ошибок уже покрыты log_error */
+    char *route_req_json = decide_prepare(call->client_fd, call->body, call->ctx);
+    if (route_req_json == NULL) {
+        route_finish_ok(call);
+        return ROUTE_DONE;
+    }
+    route_result_t replayed;
+    if (decide_idempotency(call, &replayed) != 0) {
+        request_arena_scratch_free(route_req_json);
+        return replayed;
+    }
+    if (call->respond_async && g_ingest != NULL && call->route->endpoint != ENDPOINT_ROUTES_DECIDE_POST) {
+        route_result_t accepted = ingest_accept(call, route_req_json);
+        request_arena_scratch_free(route_req_json);
+        return accepted;
+    }
+    router_call_t *rc = router_call_new(call, decide_reply, route_finish_ok);
+    if (!rc) {
+        request_arena_scratch_free(route_req_json);
+        return router_call_answer(call, decide_reply, route_finish_ok, -1, NULL);
+    }
+    rc->nats_span = decide_nats_span(call->http_span);
+    /* A keyed request is safe to repeat, so a late reply may be hedged */
+    int submitted = call->idempotency_key != NULL
+                        ? nats_request_decide_idempotent_async(route_req_json, router_call_on_reply, rc)
+                        : nats_request_decide_async(route_req_json, router_call_on_reply, rc);
+    request_arena_scratch_free(route_req_json);
+    return router_call_park(call, rc, submitted);
+}
+
+static route_result_t route_extensions_health(route_call_t *call) {
+    route_result_t cached;
+    if (admin_view_serve(call, ADMIN_VIEW_EXTENSION_HEALTH, strlen(ADMIN_VIEW_EXTENSION_HEALTH), &cached) != 0) {
+        return cached;
+    }
+    router_call_t *rc = router_call_new(call, extensions_health_reply, route_finish_ok);
+    if (!rc) {
+        return router_call_answer(call, extensions_health_reply, route_finish_ok, -1, NULL);
+    }
+    int submitted = nats_request_get_extension_health_async(router_call_on_reply, rc);
+    return router_call_park(call, rc, submitted);
+}
+
+static route_result_t route_circuit_breakers(route_call_t *call) {
+    route_result_t cached;
+    if (admin_view_serve(call, ADMIN_VIEW_CIRCUIT_BREAKERS, strlen(ADMIN_VIEW_CIRCUIT_BREAKERS), &cached) != 0) {
+        return cached;
+    }
+    router_call_t *rc = router_call_new(call, circuit_breakers_reply, route_finish_ok);
+    if (!rc) {
+        return router_call_answer(call, circuit_breakers_reply, route_finish_ok, -1, NULL);
+    }
+    int submitted = nats_request_get_circuit_breaker_states_async(router_call_on_reply, rc);
+    return router_call_park(call, rc, submitted);
+}
+
+static route_result_t route_policy_dry_run(route_call_t *call) {
+    if (dry_run_pipeline_check(call->client_fd, call->body, call->ctx) != 0) {
+        route_finish_ok(call);
+        return ROUTE_DONE;
+    }
+    router_call_t *rc = router_call_new(call, dry_run_pipeline_reply, route_finish_ok);
+    if (!rc) {
+        return router_call_answer(call, dry_run_pipeline_reply, route_finish_ok, -1, NULL);
+    }
+    int submitted = nats_request_dry_run_pipeline_async(call->body, router_call_on_reply, rc);
+    return router_call_park(call, rc, submitted);
+}
+
+/* GET /api/v1/policies/:tenant_id/:policy_id/complexity
+ * (also reached with a single segment, which is rejected) */
+static route_result_t route_policy_complexity(route_call_t *call) {
+    char tenant_id[64];
+    char policy_id[64];
+    (void)route_param(call, "tenant_id", tenant_id, sizeof(tenant_id));
+    (void)route_param(call, "policy_id", policy_id, sizeof(policy_id));
+
+    if (tenant_id[0] == '\0' || policy_id[0] == '\0') {
+        send_error_response(call->client_fd, "HTTP/1.1 400 Bad Request", "INVALID_REQUEST", "missing tenant_id or policy_id", call->ctx);
+        return ROUTE_RETURN;
+    }
+    if (pipeline_complexity_check(call->client_fd, tenant_id, policy_id, call->ctx) != 0) {
+        route_finish_ok(call);
+        return ROUTE_DONE;
+    }
+    char key[192];
+    int n = snprintf(key, sizeof(key), ADMIN_VIEW_COMPLEXITY "%s\n%s", tenant_id, policy_id);
+    route_result_t cached;
+    if (n > 0 && (size_t)n < sizeof(key) && admin_view_serve(call, key, (size_t)n, &cached) != 0) {
+        return cached;
+    }
+    router_call_t *rc = router_call_new(call, pipeline_complexity_reply, route_finish_ok);
+    if (!rc) {
+        return router_call_answer(call, pipeline_complexity_reply, route_finish_ok, -1, NULL);
+    }
+    int submitted = nats_request_get_pipeline_complexity_async(tenant_id, policy_id,
+                                                               router_call_on_reply, rc);
+    return router_call_park(call, rc, submitted);
+}
+
+/* Any other GET under /api/v1/policies/ */
+static route_result_t route_policy_not_found(route_call_t *call) {
+    send_error_response(call->client_fd, "HTTP/1.1 404 Not Found", "NOT_FOUND", "endpoint not found", call->ctx);
+    return ROUTE_RETURN;
+}
+
+static const route_spec_t route_spec_health = {
+    route_health, ENDPOINT_HEALTH, ROUTE_NO_RATE_LIMIT, NULL };
+static const route_spec_t route_spec_metrics_json = {
+    route_metrics_json, ENDPOINT_METRICS_JSON, ROUTE_NO_RATE_LIMIT, NULL };
+static const route_spec_t route_spec_metrics = {
+    route_metrics, ENDPOINT_METRICS, ROUTE_NO_RATE_LIMIT, NULL };
+static const route_spec_t route_spec_log_settings = {
+    route_log_settings, ENDPOINT_UNKNOWN, ROUTE_NO_RATE_LIMIT, NULL };
+static const route_spec_t route_spec_log_settings_update = {
+    route_log_settings_update, ENDPOINT_UNKNOWN, ROUTE_NO_RATE_LIMIT, NULL };
+static const route_spec_t route_spec_registry_post = {
+    route_registry_block, ENDPOINT_REGISTRY_POST, RL_ENDPOINT_REGISTRY_BLOCKS, NULL };
+static const route_spec_t route_spec_registry_put = {
+    route_registry_block, ENDPOINT_REGISTRY_PUT, RL_ENDPOINT_REGISTRY_BLOCKS, NULL };
+static const route_spec_t route_spec_registry_delete = {
+    route_registry_block, ENDPOINT_REGISTRY_DELETE, RL_ENDPOINT_REGISTRY_BLOCKS, NULL };
+static const route_spec_t route_spec_registry_get = {
+    route_registry_block, ENDPOINT_REGISTRY_GET, RL_ENDPOINT_REGISTRY_BLOCKS, NULL };
+static const route_spec_t route_spec_decision_get = {
+    route_get_decision, ENDPOINT_ROUTES_DECIDE_GET, RL_ENDPOINT_ROUTES_DECIDE,
+    &metric_requests_routes_decide_get };
+static const route_spec_t route_spec_decide_post = {
+    route_decide, ENDPOINT_ROUTES_DECIDE_POST, RL_ENDPOINT_ROUTES_DECIDE,
+    &metric_requests_routes_decide_post };
+static const route_spec_t route_spec_message_post = {
+    route_decide, ENDPOINT_UNKNOWN, RL_ENDPOINT_MESSAGES, NULL };
+static const route_spec_t route_spec_message_update = {
+    route_message_update, ENDPOINT_UNKNOWN, RL_ENDPOINT_MESSAGES, NULL };
+static const route_spec_t route_spec_message_delete = {
+    route_message_delete, ENDPOINT_UNKNOWN, RL_ENDPOINT_MESSAGES, NULL };
+static const route_spec_t route_spec_message_stream = {
+    route_message_stream, ENDPOINT_UNKNOWN, ROUTE_NO_RATE_LIMIT, NULL };
+static const route_spec_t route_spec_extensions_health = {
+    route_extensions_health, ENDPOINT_UNKNOWN, ROUTE_NO_RATE_LIMIT, NULL };
+static const route_spec_t route_spec_circuit_breakers = {
+    route_circuit_breakers, ENDPOINT_UNKNOWN, ROUTE_NO_RATE_LIMIT, NULL };
+static const route_spec_t route_spec_policy_dry_run = {
+    route_policy_dry_run, ENDPOINT_UNKNOWN, ROUTE_NO_RATE_LIMIT, NULL };
+static const route_spec_t route_spec_policy_complexity = {
+    route_policy_complexity, ENDPOINT_UNKNOWN, ROUTE_NO_RATE_LIMIT, NULL };
+static const route_spec_t route_spec_policy_not_found = {
+    route_policy_not_found, ENDPOINT_UNKNOWN, ROUTE_NO_RATE_LIMIT, NULL };
+
+static const struct {
+    const char *method;
+    const char *pattern;
+    const route_spec_t *spec;
+} gateway_route_defs[] = {
+    { "GET",    "/health",                                       &route_spec_health },
+    { "GET",    "/_health",                                      &route_spec_health },
+    { "GET",    "/_metrics",                                     &route_spec_metrics_json },
+    { "GET",    "/metrics",                                      &route_spec_metrics },
+    { "GET",    "/_log",                                         &route_spec_log_settings },
+    { "PUT",    "/_log",                                         &route_spec_log_settings_update },
+    { "GET",    "/api/v1/registry/blocks/:type",                 &route_spec_registry_get },
+    { "GET",    "/api/v1/registry/blocks/:type/*version",        &route_spec_registry_get },
+    { "POST",   "/api/v1/registry/blocks/:type",                 &route_spec_registry_post },
+    { "POST",   "/api/v1/registry/blocks/:type/*version",        &route_spec_registry_post },
+    { "PUT",    "/api/v1/registry/blocks/:type",                 &route_spec_registry_put },
+    { "PUT",    "/api/v1/registry/blocks/:type/*version",        &route_spec_registry_put },
+    { "DELETE", "/api/v1/registry/blocks/:type",                 &route_spec_registry_delete },
+    { "DELETE", "/api/v1/registry/blocks/:type/*version",        &route_spec_registry_delete },
+    { "GET",    "/api/v1/routes/decide/*message_id",             &route_spec_decision_get },
+    { "POST",   "/api/v1/routes/decide",                         &route_spec_decide_post },
+    { "POST",   "/api/v1/messages",                              &route_spec_message_post },
+    { "PUT",    "/api/v1/messages/*message_id",                  &route_spec_message_update },
+    { "DELETE", "/api/v1/messages/*message_id",                  &route_spec_message_delete },
+    { "GET",    "/api/v1/messages/stream",                       &route_spec_message_stream },
+    { "GET",    "/api/v1/extensions/health",                     &route_spec_extensions_health },
+    { "GET",    "/api/v1/extensions/circuit-breakers",           &route_spec_circuit_breakers },
+    { "POST",   "/api/v1/policies/dry-run",                      &route_spec_policy_dry_run },
+    { "GET",    "/api/v1/policies/:tenant_id/:policy_id/complexity", &route_spec_policy_complexity },
+    { "GET",    "/api/v1/policies/:tenant_id/complexity",        &route_spec_policy_complexity },
+    { "GET",    "/api/v1/policies/*rest",                        &route_spec_policy_not_found },
+};
+
+/* Compile gateway_route_defs; called once before the reactor starts */
+static int routes_init(void) {
+    gateway_routes = http_route_table_create();
+    if (!gateway_routes) {
+        return -1;
+    }
+    for (size_t i = 0; i < sizeof(gateway_route_defs) / sizeof(gateway_route_defs[0]); i++) {
+        if (http_route_table_add(gateway_routes, gateway_route_defs[i].method,
+                                 gateway_route_defs[i].pattern, gateway_route_defs[i].spec) != 0) {
+            fprintf(stderr, "Invalid route %s %s\n",
+                    gateway_route_defs[i].method, gateway_route_defs[i].pattern);
+            http_route_table_destroy(gateway_routes);
+            gateway_routes = NULL;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Serve one request. The reactor has already assembled the complete
+ * request in req->data.
+ */
+static http_conn_action_t handle_request(const http_reactor_request_t *req) {
+    int client_fd = req->fd;
+    char *buffer = req->data;
+    tls_keep_alive = req->keep_alive;
+    struct timeval start_time, end_time;
+    gettimeofday(&start_time, NULL);
+
+    metric_requests_total++;
+
+    /* The reactor has parsed the head; everything below points into buffer */
+    const http_request_head_t *head = req->head;
+    char *body = buffer + head->head_len;
+
+    char *method = NULL;
+    char *path = NULL;
+
+    request_context_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.body = body;
+    ctx.body_len = req->len - head->head_len;
+    
+    /* Extract client IP address */
+    char client_ip[64] = {0};
+    struct sockaddr_in client_addr;
+    socklen_t addr_len = sizeof(client_addr);
+    if (getpeername(client_fd, (struct sockaddr *)&client_addr, &addr_len) == 0) {
+        inet_ntop(AF_INET, &client_addr.sin_addr, client_ip, sizeof(client_ip));
+    } else {
+        strcpy(client_ip, "unknown");
+    }
+
+    endpoint_id_t endpoint = ENDPOINT_UNKNOWN;
+    (void)endpoint; /* currently unused, but may be needed for future features */
+    int keep_open = 0; /* for SSE stream */
+
+    /* Method and target are each followed by a space in the request line,
+     * so they can be terminated in place */
+    if (head->method.len > 0 && head->target.len > 0) {
+        method = buffer + head->method.off;
+        method[head->method.len] = '\0';
+        path = buffer + head->target.off;
+        path[head->target.len] = '\0';
+    }
+    ctx.method = method;
+    ctx.path = path;
+
+    /* Conflict Contract: Priority 3 - Request Gateway Validation (REQ_GW) */
+    if (method == NULL || path == NULL) {
+        send_error_response_with_conflict(client_fd,
+                            "HTTP/1.1 400 Bad Request",
+                            "invalid_request",
+                            "malformed request line",
+                            &ctx,
+                            CONFLICT_TYPE_REQUEST_GATEWAY,
+                            NULL);
+        gettimeofday(&end_time, NULL);
+        uint64_t duration_us = ((uint64_t)(end_time.tv_sec - start_time.tv_sec)) * 1000000ULL + 
+                              (uint64_t)(end_time.tv_usec - start_time.tv_usec);
+        metrics_record_http_request("UNKNOWN", "UNKNOWN", 400, duration_us);
+        // End span if created
+        if (ctx.otel_span) {
+            otel_span_set_attribute_int(ctx.otel_span, "http.status_code", 400);
+            otel_span_set_status(ctx.otel_span, SPAN_STATUS_ERROR);
+            otel_span_end(ctx.otel_span);
+        }
+        return response_conn_action();
+    }
+
+    /* Minimal header validation: X-Tenant-ID is required for API calls.
+     * Also extract X-Trace-ID into context if present, and optionally
+     * detect presence of Authorization header for auth skeleton.
+     * Header names match case-insensitively.
+     */
+    const http_header_t *tenant_header = http_request_find_header(head, buffer, "X-Tenant-ID");
+    const http_header_t *trace_header = http_request_find_header(head, buffer, "X-Trace-ID");
+    const http_header_t *traceparent_header = http_request_find_header(head, buffer, "traceparent");
+    int has_tenant_header = tenant_header != NULL;
+    int has_auth_header   = http_request_find_header(head, buffer, "Authorization") != NULL;
+    const http_header_t *idempotency_header = http_request_find_header(head, buffer, "Idempotency-Key");
+    const http_header_t *if_none_match_header = http_request_find_header(head, buffer, "If-None-Match");
+    const http_header_t *prefer_header = http_request_find_header(head, buffer, "Prefer");
+
+    if (tenant_header) {
+        copy_header_value(ctx.tenant_id, sizeof(ctx.tenant_id), buffer, tenant_header);
+    }
+    if (trace_header) {
+        copy_header_value(ctx.trace_id, sizeof(ctx.trace_id), buffer, trace_header);
+    }
+
+    // Extract traceparent for OpenTelemetry tracing
+    const char *traceparent_value = NULL;
+    if (traceparent_header) {
+        /* The value ends before CRLF or trailing OWS; terminate it in place */
+        char *value = buffer + traceparent_header->value.off;
+        value[traceparent_header->value.len] = '\0';
+        traceparent_value = value;
+    }
+
+    // Extract trace context from traceparent header if present
+    otel_span_t *parent_span = NULL;
+    trace_id_t extracted_trace_id;
+    span_id_t extracted_span_id;
+    
+    if (traceparent_value && otel_extract_trace_context(traceparent_value, &extracted_trace_id, &extracted_span_id) == 0) {
+        // Create a temporary parent span from extracted context
+        // This allows us to create a child span with the correct trace_id
+        parent_span = request_arena_scratch_calloc(1, sizeof(otel_span_t));
+        if (parent_span) {
+            memcpy(&parent_span->trace_id, &extracted_trace_id, sizeof(trace_id_t));
+            memcpy(&parent_span->span_id, &extracted_span_id, sizeof(span_id_t));
+        }
+    }
+    
+    // Create HTTP request span (child of extracted parent if traceparent present)
+    otel_span_t *http_span = otel_span_start("gateway.http.request", SPAN_KIND_SERVER, parent_span);
+    if (http_span) {
+        otel_span_set_attribute(http_span, "http.method", method);
+        otel_span_set_attribute(http_span, "http.url", path);
         if (ctx.tenant_id[0] != '\0') {
             otel_span_set_attribute(http_span, "tenant_id", ctx.tenant_id);
         }
@@ -2776,393 +3499,59 @@ static void handle_client(int client_fd) {
     
     // Free temporary parent span if created
     if (parent_span && parent_span != http_span) {
-        free(parent_span);
+        request_arena_scratch_free(parent_span);
     }
     
     // Store span in context for NATS propagation
     ctx.otel_span = http_span;
     
-    int latency_ms = 0;
     int http_status_code = 200;
-    if (strcmp(method, "GET") == 0 && (strcmp(path, "/health") == 0 || strcmp(path, "/_health") == 0)) {
-        endpoint = ENDPOINT_HEALTH;
-        handle_health(client_fd);
-        latency_ms = (int)((clock() - start_clock) * 1000 / CLOCKS_PER_SEC);
-        record_latency_ms(latency_ms);
-        gettimeofday(&end_time, NULL);
-        uint64_t duration_us = ((uint64_t)(end_time.tv_sec - start_time.tv_sec)) * 1000000ULL + 
-                              (uint64_t)(end_time.tv_usec - start_time.tv_usec);
-        metrics_record_http_request(method, path, 200, duration_us);
-        http_status_code = 200;
-        log_info("http_request", &ctx, method, path, 200, latency_ms);
-    } else if (strcmp(method, "GET") == 0 && strcmp(path, "/_metrics") == 0) {
-        endpoint = ENDPOINT_METRICS_JSON;
-        handle_metrics_json(client_fd);
-        latency_ms = (int)((clock() - start_clock) * 1000 / CLOCKS_PER_SEC);
-        record_latency_ms(latency_ms);
-        gettimeofday(&end_time, NULL);
-        uint64_t duration_us = ((uint64_t)(end_time.tv_sec - start_time.tv_sec)) * 1000000ULL + 
-                              (uint64_t)(end_time.tv_usec - start_time.tv_usec);
-        metrics_record_http_request(method, path, 200, duration_us);
-        http_status_code = 200;
-        log_info("http_request", &ctx, method, path, 200, latency_ms);
-    } else if (strcmp(method, "GET") == 0 && strcmp(path, "/metrics") == 0) {
-        endpoint = ENDPOINT_METRICS;
-        struct timeval metrics_start_time, metrics_end_time;
-        gettimeofday(&metrics_start_time, NULL);
-        handle_metrics_request(client_fd);
-        gettimeofday(&metrics_end_time, NULL);
-        uint64_t duration_us = ((uint64_t)(metrics_end_time.tv_sec - metrics_start_time.tv_sec)) * 1000000ULL + 
-                              (uint64_t)(metrics_end_time.tv_usec - metrics_start_time.tv_usec);
-        latency_ms = (int)((clock() - start_clock) * 1000 / CLOCKS_PER_SEC);
-        record_latency_ms(latency_ms);
-        metrics_record_http_request(method, path, 200, duration_us);
-        http_status_code = 200;
-        log_info("http_request", &ctx, method, path, 200, latency_ms);
-    } else if ((strcmp(method, "POST") == 0 || strcmp(method, "PUT") == 0 || strcmp(method, "DELETE") == 0) &&
-               strncmp(path, "/api/v1/registry/blocks/", strlen("/api/v1/registry/blocks/")) == 0) {
-        /* Parse /api/v1/registry/blocks/:type/:version */
-        const char *prefix = "/api/v1/registry/blocks/";
-        const char *p = path + strlen(prefix);
-        const char *slash = strchr(p, '/');
-        if (!slash) {
-            send_error_response(client_fd, "HTTP/1.1 400 Bad Request", "invalid_request", "missing version segment", &ctx);
-            latency_ms = (int)((clock() - start_clock) * 1000 / CLOCKS_PER_SEC);
-            record_latency_ms(latency_ms);
-            close(client_fd);
-            return;
-        }
-        char type[128]; memset(type, 0, sizeof(type));
-        size_t tlen = (size_t)(slash - p);
-        if (tlen >= sizeof(type)) tlen = sizeof(type) - 1;
-        strncpy(type, p, tlen);
-        const char *version = slash + 1;
-        if (version == NULL || *version == '\0') {
-            send_error_response(client_fd, "HTTP/1.1 400 Bad Request", "invalid_request", "empty version", &ctx);
-            latency_ms = (int)((clock() - start_clock) * 1000 / CLOCKS_PER_SEC);
-            record_latency_ms(latency_ms);
-            if (ctx.otel_span) {
-                otel_span_set_attribute_int(ctx.otel_span, "http.status_code", 400);
-                otel_span_set_status(ctx.otel_span, SPAN_STATUS_ERROR);
-                otel_span_end(ctx.otel_span);
-            }
-            close(client_fd);
-            return;
-        }
-        
-        /* Apply rate limiting to registry endpoints */
-        unsigned int remaining = 0;
-        if (rate_limit_check(RL_ENDPOINT_REGISTRY_BLOCKS, ctx.tenant_id, NULL, &remaining) != 0) {
-            send_rate_limit_error(client_fd, RL_ENDPOINT_REGISTRY_BLOCKS, &ctx);
-            if (ctx.otel_span) {
-                otel_span_set_attribute_int(ctx.otel_span, "http.status_code", 429);
-                otel_span_set_status(ctx.otel_span, SPAN_STATUS_ERROR);
-                otel_span_end(ctx.otel_span);
-            }
-            close(client_fd);
-            return;
-        }
-        
-        if (strcmp(method, "DELETE") == 0) {
-            endpoint = ENDPOINT_REGISTRY_DELETE;
-            handle_registry_delete(client_fd, type, version);
-        } else {
-            endpoint = (strcmp(method, "POST") == 0) ? ENDPOINT_REGISTRY_POST : ENDPOINT_REGISTRY_PUT;
-            handle_registry_write_common(client_fd, method, type, version, body);
-        }
-        latency_ms = (int)((clock() - start_clock) * 1000 / CLOCKS_PER_SEC);
-        record_latency_ms(latency_ms);
-        log_info("http_request", &ctx, method, path, 200, latency_ms);
-    } else if (strcmp(method, "GET") == 0 &&
-               strncmp(path, "/api/v1/routes/decide/", strlen("/api/v1/routes/decide/")) == 0) {
-        /* Extract message_id part after the prefix. */
-        const char *prefix = "/api/v1/routes/decide/";
-        const char *message_id = path + strlen(prefix);
-
-        if (message_id == NULL || message_id[0] == '\0') {
-            send_error_response(client_fd,
-                                "HTTP/1.1 400 Bad Request",
-                                "invalid_request",
-                                "missing message_id path parameter",
-                                &ctx);
-            if (ctx.otel_span) {
-                otel_span_set_attribute_int(ctx.otel_span, "http.status_code", 400);
-                otel_span_set_status(ctx.otel_span, SPAN_STATUS_ERROR);
-                otel_span_end(ctx.otel_span);
-            }
-            close(client_fd);
-            return;
-        }
 
-        /* Apply rate limiting to GET /api/v1/routes/decide/:messageId */
-        unsigned int remaining = 0;
-        if (rate_limit_check(RL_ENDPOINT_ROUTES_DECIDE, ctx.tenant_id, NULL, &remaining) != 0) {
-            send_rate_limit_error(client_fd, RL_ENDPOINT_ROUTES_DECIDE, &ctx);
-            if (ctx.otel_span) {
-                otel_span_set_attribute_int(ctx.otel_span, "http.status_code", 429);
-                otel_span_set_status(ctx.otel_span, SPAN_STATUS_ERROR);
-                otel_span_end(ctx.otel_span);
-            }
-            close(client_fd);
-            return;
-        }
-
-        endpoint = ENDPOINT_ROUTES_DECIDE_GET;
-        metric_requests_routes_decide_get++;
-        handle_get_decision(client_fd, message_id, &ctx);
-        /* handle_get_decision already sends response and logs error if needed */
-        latency_ms = (int)((clock() - start_clock) * 1000 / CLOCKS_PER_SEC);
-        record_latency_ms(latency_ms);
-    } else if ((strcmp(method, "PUT") == 0 || strcmp(method, "DELETE") == 0) &&
-               strncmp(path, "/api/v1/messages/", strlen("/api/v1/messages/")) == 0) {
-        /* Minimal CP1 handlers to emit SSE update/delete */
-        const char *prefix = "/api/v1/messages/";
-        const char *message_id = path + strlen(prefix);
-        if (message_id == NULL || message_id[0] == '\0') {
-            send_error_response(client_fd, "HTTP/1.1 400 Bad Request", "invalid_request", "missing message_id", &ctx);
-            close(client_fd);
-            return;
-        }
-        if (ctx.tenant_id[0] == '\0') {
-            send_error_response(client_fd, "HTTP/1.1 400 Bad Request", "invalid_request", "missing X-Tenant-ID header", &ctx);
-            close(client_fd);
-            return;
-        }
-        
-        /* Apply rate limiting to messages endpoints */
-        unsigned int remaining = 0;
-        if (rate_limit_check(RL_ENDPOINT_MESSAGES, ctx.tenant_id, NULL, &remaining) != 0) {
-            send_rate_limit_error(client_fd, RL_ENDPOINT_MESSAGES, &ctx);
-            close(client_fd);
-            return;
-        }
-        
-        if (strcmp(method, "PUT") == 0) {
-            if (body == NULL || body[0] == '\0') {
-                send_error_response(client_fd, "HTTP/1.1 400 Bad Request", "invalid_request", "empty body", &ctx);
-                if (ctx.otel_span) {
-                    otel_span_set_attribute_int(ctx.otel_span, "http.status_code", 400);
-                    otel_span_set_status(ctx.otel_span, SPAN_STATUS_ERROR);
-                    otel_span_end(ctx.otel_span);
-                }
-                close(client_fd);
-                return;
-            }
-            /* validate JSON and broadcast */
-            json_error_t jerr; json_t *root = json_loads(body, 0, &jerr);
-            if (!root || !json_is_object(root)) {
-                if (root) json_decref(root);
-                send_error_response(client_fd, "HTTP/1.1 400 Bad Request", "invalid_request", "invalid JSON", &ctx);
-                if (ctx.otel_span) {
-                    otel_span_set_attribute_int(ctx.otel_span, "http.status_code", 400);
-                    otel_span_set_status(ctx.otel_span, SPAN_STATUS_ERROR);
-                    otel_span_end(ctx.otel_span);
-                }
-                close(client_fd);
-                return;
-            }
-            /* enforce message_id match if present in body */
-            json_t *mid = json_object_get(root, "message_id");
-            if (mid && json_is_string(mid)) {
-                const char *mid_s = json_string_value(mid);
-                if (strcmp(mid_s, message_id) != 0) {
-                    json_decref(root);
-                    send_error_response(client_fd, "HTTP/1.1 409 Conflict", "conflict", "message_id mismatch with path", &ctx);
-                    if (ctx.otel_span) {
-                        otel_span_set_attribute_int(ctx.otel_span, "http.status_code", 409);
-                        otel_span_set_status(ctx.otel_span, SPAN_STATUS_ERROR);
-                        otel_span_end(ctx.otel_span);
-                    }
-                    close(client_fd);
-                    return;
-                }
-            }
-            send_response(client_fd, "HTTP/1.1 200 OK", "application/json", body);
-            sse_broadcast_json(ctx.tenant_id, "message_updated", body);
-            json_decref(root);
-        } else { /* DELETE */
-            char resp[256];
-            int len = snprintf(resp, sizeof(resp), "{\"status\":\"deleted\",\"message_id\":\"%s\"}", message_id);
-            if (len < 0 || (size_t)len >= sizeof(resp)) {
-                send_error_response(client_fd, "HTTP/1.1 400 Bad Request", "invalid_request", "bad message_id", &ctx);
-                close(client_fd);
-                return;
-            }
-            send_response(client_fd, "HTTP/1.1 200 OK", "application/json", resp);
-            char evt[128];
-            int l = snprintf(evt, sizeof(evt), "{\"message_id\":\"%s\"}", message_id);
-            if (l > 0 && (size_t)l < sizeof(evt)) {
-                sse_broadcast_json(ctx.tenant_id, "message_deleted", evt);
-            }
-        }
-        latency_ms = (int)((clock() - start_clock) * 1000 / CLOCKS_PER_SEC);
-        record_latency_ms(latency_ms);
-    } else if (strcmp(method, "GET") == 0 &&
-               strncmp(path, "/api/v1/messages/stream", strlen("/api/v1/messages/stream")) == 0) {
-        char tenant_q[64]; tenant_q[0] = '\0';
-        if (!query_get_param(path, "tenant_id", tenant_q, sizeof(tenant_q)) || tenant_q[0] == '\0') {
-            send_error_response(client_fd,
-                                "HTTP/1.1 400 Bad Request",
-                                "invalid_request",
-                                "missing tenant_id",
-                                &ctx);
-            close(client_fd);
-            return;
-        }
-        if (sse_register_client(client_fd, tenant_q) == 0) {
-            keep_open = 1;
-            endpoint = ENDPOINT_UNKNOWN;
-        } else {
-            /* registration failed, close */
-        }
-        latency_ms = (int)((clock() - start_clock) * 1000 / CLOCKS_PER_SEC);
-        record_latency_ms(latency_ms);
-    } else if (strcmp(method, "POST") == 0 &&
-               (strcmp(path, "/api/v1/messages") == 0 ||
-                strcmp(path, "/api/v1/routes/decide") == 0)) {
-        /* Conflict Contract: Priority 2 - Authentication Gateway (AUTH_GW) */
-        if (auth_required && !has_auth_header) {
-            send_error_response_with_conflict(client_fd,
-                                "HTTP/1.1 401 Unauthorized",
-                                "unauthorized",
-                                "missing Authorization header",
-                                &ctx,
-                                CONFLICT_TYPE_AUTH_GATEWAY,
-                                NULL);
-            close(client_fd);
-            return;
-        }
-
-        /* Conflict Contract: Priority 3 - Request Gateway Validation (REQ_GW) */
-        if (!has_tenant_header) {
-            send_error_response_with_conflict(client_fd,
-                                "HTTP/1.1 400 Bad Request",
-                                "invalid_request",
-                                "missing X-Tenant-ID header",
-                                &ctx,
-                                CONFLICT_TYPE_REQUEST_GATEWAY,
-                                NULL);
-            close(client_fd);
-            return;
-        }
-
-        if (strcmp(path, "/api/v1/routes/decide") == 0) {
-            if (rate_limit_check_routes_decide(client_fd, &ctx) != 0) {
-                /* Enhanced 429 error response is already sent by send_rate_limit_error */
-                if (ctx.otel_span) {
-                    otel_span_set_attribute_int(ctx.otel_span, "http.status_code", 429);
-                    otel_span_set_status(ctx.otel_span, SPAN_STATUS_ERROR);
-                    otel_span_end(ctx.otel_span);
-                }
-                close(client_fd);
-                return;
-            }
-            endpoint = ENDPOINT_ROUTES_DECIDE_POST;
-            metric_requests_routes_decide_post++;
-        } else if (strcmp(path, "/api/v1/messages") == 0) {
-            /* Apply rate limiting to POST /api/v1/messages */
-            unsigned int remaining = 0;
-            if (rate_limit_check(RL_ENDPOINT_MESSAGES, ctx.tenant_id, NULL, &remaining) != 0) {
-                send_rate_limit_error(client_fd, RL_ENDPOINT_MESSAGES, &ctx);
-                if (ctx.otel_span) {
-                    otel_span_set_attribute_int(ctx.otel_span, "http.status_code", 429);
-                    otel_span_set_status(ctx.otel_span, SPAN_STATUS_ERROR);
-                    otel_span_end(ctx.otel_span);
-                }
-                close(client_fd);
-                return;
-            }
-            /* For now, just handle it as a simple message - no specific metric tracking */
-        }
-
-        handle_decide(client_fd, body, &ctx, http_span);
-        /* Для успешного кейса логируем 200, коды ошибок уже покрыты log_error */
-        latency_ms = (int)((clock() - start_clock) * 1000 / CLOCKS_PER_SEC);
-        record_latency_ms(latency_ms);
-        gettimeofday(&end_time, NULL);
-        uint64_t duration_us = ((uint64_t)(end_time.tv_sec - start_time.tv_sec)) * 1000000ULL + 
-                              (uint64_t)(end_time.tv_usec - start_time.tv_usec);
-        metrics_record_http_request(method, path, 200, duration_us);
-        http_status_code = 200;
-        log_info("http_request", &ctx, method, path, 200, latency_ms);
-    } else if (strcmp(method, "GET") == 0 && strcmp(path, "/api/v1/extensions/health") == 0) {
-        handle_extensions_health(client_fd, &ctx);
-        latency_ms = (int)((clock() - start_clock) * 1000 / CLOCKS_PER_SEC);
-        record_latency_ms(latency_ms);
-        gettimeofday(&end_time, NULL);
-        uint64_t duration_us = ((uint64_t)(end_time.tv_sec - start_time.tv_sec)) * 1000000ULL + 
-                              (uint64_t)(end_time.tv_usec - start_time.tv_usec);
-        metrics_record_http_request(method, path, 200, duration_us);
-        http_status_code = 200;
-        log_info("http_request", &ctx, method, path, 200, latency_ms);
-    } else if (strcmp(method, "GET") == 0 && strcmp(path, "/api/v1/extensions/circuit-breakers") == 0) {
-        handle_circuit_breakers(client_fd, &ctx);
-        latency_ms = (int)((clock() - start_clock) * 1000 / CLOCKS_PER_SEC);
-        record_latency_ms(latency_ms);
-        gettimeofday(&end_time, NULL);
-        uint64_t duration_us = ((uint64_t)(end_time.tv_sec - start_time.tv_sec)) * 1000000ULL + 
-                              (uint64_t)(end_time.tv_usec - start_time.tv_usec);
-        metrics_record_http_request(method, path, 200, duration_us);
-        http_status_code = 200;
-        log_info("http_request", &ctx, method, path, 200, latency_ms);
-    } else if (strcmp(method, "POST") == 0 && strcmp(path, "/api/v1/policies/dry-run") == 0) {
-        handle_dry_run_pipeline(client_fd, body, &ctx);
-        latency_ms = (int)((clock() - start_clock) * 1000 / CLOCKS_PER_SEC);
-        record_latency_ms(latency_ms);
-        gettimeofday(&end_time, NULL);
-        uint64_t duration_us = ((uint64_t)(end_time.tv_sec - start_time.tv_sec)) * 1000000ULL + 
-                              (uint64_t)(end_time.tv_usec - start_time.tv_usec);
-        metrics_record_http_request(method, path, 200, duration_us);
-        http_status_code = 200;
-        log_info("http_request", &ctx, method, path, 200, latency_ms);
-    } else if (strcmp(method, "GET") == 0 &&
-               strncmp(path, "/api/v1/policies/", strlen("/api/v1/policies/")) == 0) {
-        /* Parse /api/v1/policies/:tenant_id/:policy_id/complexity */
-        const char *prefix = "/api/v1/policies/";
-        const char *suffix = strstr(path + strlen(prefix), "/complexity");
-        if (suffix != NULL) {
-            /* Extract tenant_id and policy_id from path */
-            char tenant_id[64] = {0};
-            char policy_id[64] = {0};
-            size_t path_len = (size_t)(suffix - (path + strlen(prefix)));
-            if (path_len > 0 && path_len < 128) {
-                char temp_path[128];
-                strncpy(temp_path, path + strlen(prefix), path_len);
-                temp_path[path_len] = '\0';
-                
-                /* Split by '/' to get tenant_id and policy_id */
-                char *slash = strchr(temp_path, '/');
-                if (slash != NULL) {
-                    *slash = '\0';
-                    strncpy(tenant_id, temp_path, sizeof(tenant_id) - 1);
-                    strncpy(policy_id, slash + 1, sizeof(policy_id) - 1);
-                } else {
-                    /* If no slash, treat entire path as policy_id (fallback) */
-                    strncpy(policy_id, temp_path, sizeof(policy_id) - 1);
-                }
-            }
-            
-            if (tenant_id[0] != '\0' && policy_id[0] != '\0') {
-                handle_pipeline_complexity(client_fd, tenant_id, policy_id, &ctx);
-                latency_ms = (int)((clock() - start_clock) * 1000 / CLOCKS_PER_SEC);
-                record_latency_ms(latency_ms);
-                gettimeofday(&end_time, NULL);
-                uint64_t duration_us = ((uint64_t)(end_time.tv_sec - start_time.tv_sec)) * 1000000ULL + 
-                                      (uint64_t)(end_time.tv_usec - start_time.tv_usec);
-                metrics_record_http_request(method, path, 200, duration_us);
-                http_status_code = 200;
-                log_info("http_request", &ctx, method, path, 200, latency_ms);
-            } else {
-                send_error_response(client_fd, "HTTP/1.1 400 Bad Request", "INVALID_REQUEST", "missing tenant_id or policy_id", &ctx);
-                close(client_fd);
-                return;
-            }
-        } else {
-            /* Not a complexity endpoint, continue with other handlers */
-            send_error_response(client_fd, "HTTP/1.1 404 Not Found", "NOT_FOUND", "endpoint not found", &ctx);
-            close(client_fd);
-            return;
-        }
+    /* Route on the path without its query string */
+    route_call_t call;
+    memset(&call, 0, sizeof(call));
+    if (gateway_routes != NULL &&
+        http_route_table_match(gateway_routes, method, strlen(method),
+                               path, strcspn(path, "?"), &call.match) == 0) {
+        call.route = (const route_spec_t *)call.match.data;
+    }
+
+    if (call.route != NULL) {
+        call.client_fd = client_fd;
+        call.method = method;
+        call.path = path;
+        call.body = body;
+        call.ctx = &ctx;
+        call.http_span = http_span;
+        call.start_time = &start_time;
+        call.has_tenant_header = has_tenant_header;
+        call.has_auth_header = has_auth_header;
+        if (idempotency_header) {
+            call.idempotency_key = buffer + idempotency_header->value.off;
+            call.idempotency_key_len = idempotency_header->value.len;
+        }
+        if (if_none_match_header) {
+            call.if_none_match = buffer + if_none_match_header->value.off;
+            call.if_none_match_len = if_none_match_header->value.len;
+        }
+        if (prefer_header) {
+            call.respond_async = prefer_respond_async(buffer + prefer_header->value.off,
+                                                      prefer_header->value.len);
+        }
+        call.ticket = req->ticket;
+        call.http_status_code = 200;
+        endpoint = call.route->endpoint;
+
+        route_result_t result = call.route->handler(&call);
+        if (result == ROUTE_PARKED) {
+            /* The request span and buffer now belong to the parked call */
+            return HTTP_CONN_PARK;
+        }
+        if (result == ROUTE_RETURN) {
+            return response_conn_action();
+        }
+        http_status_code = call.http_status_code;
+        keep_open = call.keep_open;
     } else {
         http_status_code = 404;
         send_error_response(client_fd,
@@ -3170,8 +3559,7 @@ static void handle_client(int client_fd) {
                             "invalid_request",
                             "route not found",
                             &ctx);
-        latency_ms = (int)((clock() - start_clock) * 1000 / CLOCKS_PER_SEC);
-        record_latency_ms(latency_ms);
+        (void)record_latency_since(&start_time);
         gettimeofday(&end_time, NULL);
         uint64_t duration_us = ((uint64_t)(end_time.tv_sec - start_time.tv_sec)) * 1000000ULL + 
                               (uint64_t)(end_time.tv_usec - start_time.tv_usec);
@@ -3185,7 +3573,110 @@ static void handle_client(int client_fd) {
         otel_span_end(http_span);
     }
 
-    if (!keep_open) close(client_fd);
+    return keep_open ? HTTP_CONN_DETACH : response_conn_action();
+}
+
+/*
+ * Serve a request on the calling thread (reactor or worker).
+ * Scratch memory (jansson values and dumps, log lines, spans) comes from
+ * the thread's request arena and is dropped in one go once the response
+ * has been written.
+ */
+static http_conn_action_t handle_client_inline(const http_reactor_request_t *req) {
+    request_arena_begin();
+    http_conn_action_t action = handle_request(req);
+    request_arena_end();
+    return action;
+}
+
+/*
+ * Worker pool admission.
+ *
+ * With a pool configured, reactor threads only frame requests: each one
+ * is parked and queued for a worker, with a deadline counted from when
+ * its first byte arrived. A full queue, or a request that would start
+ * past its deadline, is answered 503 with Retry-After before any work or
+ * Router call is spent on it.
+ */
+static worker_pool_t *g_worker_pool = NULL;
+static int g_admission_deadline_ms = 1000;
+static int g_worker_send_timeout_ms = 0;
+
+#define WORKER_SHED_RETRY_AFTER_SECONDS 1
+
+typedef struct {
+    http_reactor_request_t req;      /* data and head stay valid while parked */
+} queued_request_t;
+
+static void send_overloaded(int client_fd) {
+    send_error_response_with_retry_after(client_fd,
+                                         "HTTP/1.1 503 Service Unavailable",
+                                         "service_overloaded",
+                                         "Gateway is overloaded, please retry later",
+                                         WORKER_SHED_RETRY_AFTER_SECONDS,
+                                         NULL);
+}
+
+/* http_reactor_resume_fn: the worker already wrote the response */
+static http_conn_action_t worker_resume(int fd, int keep_alive, void *arg) {
+    (void)fd;
+    (void)keep_alive;
+    return (http_conn_action_t)(uintptr_t)arg;
+}
+
+static void worker_thread_init(void *user_data) {
+    (void)user_data;
+    http_reactor_set_thread_send_timeout(g_worker_send_timeout_ms);
+}
+
+/* worker_pool_task_fn: picked up in time */
+static void worker_run(void *task, uint64_t sojourn_us, void *user_data) {
+    queued_request_t *q = (queued_request_t *)task;
+    (void)user_data;
+
+    metrics_record_worker_dequeue(sojourn_us, worker_pool_depth(g_worker_pool));
+    http_conn_action_t action = handle_client_inline(&q->req);
+    if (action != HTTP_CONN_PARK) {
+        /* Otherwise a parked Router call now holds the ticket */
+        http_reactor_resume(q->req.ticket, worker_resume, (void *)(uintptr_t)action);
+    }
+    free(q);
+}
+
+/* worker_pool_task_fn: deadline passed while queued */
+static void worker_shed(void *task, uint64_t sojourn_us, void *user_data) {
+    queued_request_t *q = (queued_request_t *)task;
+    (void)user_data;
+
+    metrics_record_worker_shed_deadline(sojourn_us, worker_pool_depth(g_worker_pool));
+    tls_keep_alive = q->req.keep_alive;
+    send_overloaded(q->req.fd);
+    http_reactor_resume(q->req.ticket, worker_resume, (void *)(uintptr_t)response_conn_action());
+    free(q);
+}
+
+/* Request handler run on a reactor thread (see http_reactor.h) */
+static http_conn_action_t handle_client(const http_reactor_request_t *req, void *user_data) {
+    (void)user_data;
+    if (!g_worker_pool) {
+        return handle_client_inline(req);
+    }
+
+    queued_request_t *q = malloc(sizeof(queued_request_t));
+    if (q) {
+        q->req = *req;
+        uint64_t deadline_ms = req->received_ms + (uint64_t)g_admission_deadline_ms;
+        if (worker_pool_submit(g_worker_pool, q, deadline_ms) == 0) {
+            metrics_update_worker_queue_depth(worker_pool_depth(g_worker_pool));
+            return HTTP_CONN_PARK;
+        }
+        free(q);
+    }
+
+    metrics_record_worker_shed_queue_full();
+    tls_keep_alive = req->keep_alive;
+    send_overloaded(req->fd);
+    return response_conn_action();
 }
 
 int http_server_run(const char *port_str) {
@@ -3197,13 +3688,6 @@ int http_server_run(const char *port_str) {
         }
     }
 
-    int server_fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_fd < 0) {
-        perror("socket");
-        return 1;
-    }
-    g_server_fd = server_fd;
-
     struct sigaction sa;
     memset(&sa, 0, sizeof(sa));
     sa.sa_handler = on_signal;
@@ -3211,38 +3695,82 @@ int http_server_run(const char *port_str) {
     sa.sa_flags = 0;
     (void)sigaction(SIGTERM, &sa, NULL);
     (void)sigaction(SIGINT, &sa, NULL);
+    (void)signal(SIGPIPE, SIG_IGN);
 
-    int opt = 1;
-    (void)setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-
-    struct sockaddr_in addr;
-    memset(&addr, 0, sizeof(addr));
-    addr.sin_family = AF_INET;
-    addr.sin_addr.s_addr = htonl(INADDR_ANY);
-    addr.sin_port = htons((uint16_t)port);
-
-    if (bind(server_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
-        perror("bind");
-        close(server_fd);
+    start_time_sec = time(NULL);
+    request_arena_install_json();
+    if (sse_start() != 0) {
+        log_json("error", "main", "Failed to start the SSE hub");
         return 1;
     }
-
-    if (listen(server_fd, 16) < 0) {
-        perror("listen");
-        close(server_fd);
+    g_latency = latency_histogram_create(NULL);
+    if (!g_latency) {
+        log_json("error", "main", "Failed to create the latency histogram");
         return 1;
     }
-
-    log_json("info", "main", "C-Gateway listening on port %d", port);
-    start_time_sec = time(NULL);
-    sse_init_pool();
+    if (routes_init() != 0) {
+        log_json("error", "main", "Failed to build the route table");
+        return 1;
+    }
+    if (env_to_bool("GATEWAY_IDEMPOTENCY_ENABLED", 1)) {
+        idempotency_cache_config_t idempotency_config;
+        idempotency_cache_get_default_config(&idempotency_config);
+        (void)idempotency_cache_parse_config(&idempotency_config);
+        g_idempotency = idempotency_cache_create(&idempotency_config);
+        if (!g_idempotency) {
+            log_json("error", "main", "Failed to create the idempotency cache");
+            return 1;
+        }
+    }
+    if (env_to_bool("GATEWAY_DECISION_CACHE_ENABLED", 1)) {
+        idempotency_cache_config_t decision_config;
+        idempotency_cache_get_default_config(&decision_config);
+        decision_config.max_bytes = (size_t)env_to_int("GATEWAY_DECISION_CACHE_MAX_BYTES", 16 * 1024 * 1024);
+        g_decision_ttl_ms = env_to_int("GATEWAY_DECISION_CACHE_TTL_MS", g_decision_ttl_ms);
+        g_decision_negative_ttl_ms = env_to_int("GATEWAY_DECISION_CACHE_NEGATIVE_TTL_MS",
+                                                g_decision_negative_ttl_ms);
+        decision_config.ttl_ms = g_decision_ttl_ms;
+        g_decisions = idempotency_cache_create(&decision_config);
+        if (!g_decisions) {
+            log_json("error", "main", "Failed to create the decision cache");
+            return 1;
+        }
+    }
+    g_registry = block_registry_create();
+    if (!g_registry) {
+        log_json("error", "main", "Failed to create the block registry");
+        return 1;
+    }
+    block_registry_set_hooks(g_registry, registry_attach_validator, registry_detach_validator, NULL);
+    g_registry_snapshot_path = getenv("GATEWAY_REGISTRY_SNAPSHOT_PATH");
+    if (g_registry_snapshot_path != NULL && g_registry_snapshot_path[0] == '\0') {
+        g_registry_snapshot_path = NULL;
+    }
+    if (g_registry_snapshot_path != NULL) {
+        size_t loaded = 0;
+        if (block_registry_load_snapshot(g_registry, g_registry_snapshot_path, &loaded) != 0) {
+            log_json("warn", "main", "Ignoring unreadable registry snapshot %s", g_registry_snapshot_path);
+        } else if (loaded > 0) {
+            log_json("info", "main", "Loaded %zu block versions from %s", loaded, g_registry_snapshot_path);
+        }
+    }
+    if (env_to_bool("GATEWAY_ADMIN_CACHE_ENABLED", 1)) {
+        admin_view_cache_config_t admin_view_config;
+        admin_view_cache_get_default_config(&admin_view_config);
+        (void)admin_view_cache_parse_config(&admin_view_config);
+        g_admin_views = admin_view_cache_create(&admin_view_config, admin_view_fetch, NULL);
+        if (!g_admin_views) {
+            log_json("error", "main", "Failed to create the admin view cache");
+            return 1;
+        }
+    }
     
     // Initialize Prometheus metrics
     if (metrics_registry_init() != 0) {
         log_json("error", "main", "Failed to initialize metrics registry");
-        close(server_fd);
         return 1;
     }
+    log_throttle_set_hook(log_throttle_metrics);
     
     // Initialize OpenTelemetry tracing
     {
@@ -3258,19 +3786,114 @@ int http_server_run(const char *port_str) {
         }
     }
 
-    for (;;) {
-        if (g_terminate) break;
-        int client_fd = accept(server_fd, NULL, NULL);
-        if (client_fd < 0) {
-            if (g_terminate) break;
-            perror("accept");
-            continue;
+    /* Reactor threads share the limiter; initialize it before they start */
+    rate_limit_init_if_needed();
+
+    http_reactor_config_t reactor_config;
+    http_reactor_get_default_config(&reactor_config);
+    (void)http_reactor_parse_config(&reactor_config);
+    reactor_config.port = (uint16_t)port;
+    reactor_config.max_request_size = MAX_REQUEST_SIZE;
+    reactor_config.handler = handle_client;
+
+    http_reactor_t *reactor = http_reactor_create(&reactor_config);
+    if (!reactor) {
+        log_json("error", "main", "Failed to bind HTTP listeners on port %d", port);
+        return 1;
+    }
+
+    /* Block termination signals until we are waiting for them, so a
+     * signal cannot slip in between the g_terminate check and sigsuspend */
+    sigset_t term_mask, wait_mask;
+    sigemptyset(&term_mask);
+    sigaddset(&term_mask, SIGTERM);
+    sigaddset(&term_mask, SIGINT);
+    pthread_sigmask(SIG_BLOCK, &term_mask, &wait_mask);
+    sigdelset(&wait_mask, SIGTERM);
+    sigdelset(&wait_mask, SIGINT);
+
+    /* The Router connection's threads inherit the mask too; a server
+     * that is down is retried in the background */
+    if (nats_client_init() != 0) {
+        log_json("warn", "main", "NATS client failed to start; Router requests will fail");
+    }
+
+    /* Batches for "Prefer: respond-async" messages; the ack callbacks run
+     * on NATS threads, so the batcher goes before the client does */
+    if (env_to_bool("GATEWAY_INGEST_ASYNC_ENABLED", 1)) {
+        const char *prefix = getenv("GATEWAY_INGEST_SUBJECT_PREFIX");
+        if (prefix != NULL && prefix[0] != '\0') {
+            g_ingest_prefix = prefix;
+        }
+        ingest_batcher_config_t ingest_config;
+        ingest_batcher_get_default_config(&ingest_config);
+        (void)ingest_batcher_parse_config(&ingest_config);
+        g_ingest = ingest_batcher_create(&ingest_config, ingest_send, ingest_on_result, NULL);
+        if (!g_ingest) {
+            log_json("warn", "main", "Failed to start the ingest batcher; messages are answered synchronously");
+        }
+    }
+
+    /* Workers start after the mask so they inherit it, before the
+     * reactors so no request finds the pool missing */
+    int worker_threads = 0;
+    int worker_queue_size = 0;
+    if (env_to_bool("GATEWAY_WORKER_POOL_ENABLED", 1)) {
+        worker_pool_config_t pool_config;
+        memset(&pool_config, 0, sizeof(pool_config));
+        pool_config.num_threads = env_to_int("GATEWAY_WORKER_THREADS", 0);
+        pool_config.queue_capacity = (size_t)env_to_int("GATEWAY_WORKER_QUEUE_SIZE", 1024);
+        pool_config.run = worker_run;
+        pool_config.shed = worker_shed;
+        pool_config.thread_init = worker_thread_init;
+        g_admission_deadline_ms = env_to_int("GATEWAY_ADMISSION_DEADLINE_MS", 1000);
+        g_worker_send_timeout_ms = reactor_config.send_timeout_ms;
+        g_worker_pool = worker_pool_create(&pool_config);
+        if (!g_worker_pool) {
+            log_json("error", "main", "Failed to start worker threads");
+            http_reactor_destroy(reactor);
+            return 1;
         }
-        handle_client(client_fd);
+        worker_threads = worker_pool_get_num_threads(g_worker_pool);
+        worker_queue_size = (int)pool_config.queue_capacity;
+    }
+
+    if (http_reactor_start(reactor) != 0) {
+        log_json("error", "main", "Failed to start HTTP reactor threads");
+        http_reactor_destroy(reactor);
+        worker_pool_destroy(g_worker_pool);
+        g_worker_pool = NULL;
+        return 1;
+    }
+
+    log_json("info", "main",
+             "C-Gateway listening on port %d (reactors=%d, backlog=%d, workers=%d, queue=%d, deadline_ms=%d)",
+             port, http_reactor_get_num_threads(reactor), reactor_config.listen_backlog,
+             worker_threads, worker_queue_size, g_admission_deadline_ms);
+
+    while (!g_terminate) {
+        sigsuspend(&wait_mask);
     }
 
+    /* Stopping the reactors waits for parked requests, queued ones included */
+    http_reactor_destroy(reactor);
+    worker_pool_destroy(g_worker_pool);
+    g_worker_pool = NULL;
+    /* Publishes what is still queued and waits for its acks */
+    ingest_batcher_destroy(g_ingest);
+    g_ingest = NULL;
+    nats_client_shutdown();
     sse_shutdown();
-    if (server_fd != -1) close(server_fd);
+    latency_histogram_destroy(g_latency);
+    g_latency = NULL;
+    idempotency_cache_destroy(g_idempotency);
+    g_idempotency = NULL;
+    idempotency_cache_destroy(g_decisions);
+    g_decisions = NULL;
+    admin_view_cache_destroy(g_admin_views);
+    g_admin_views = NULL;
+    block_registry_destroy(g_registry);
+    g_registry = NULL;
     log_json("info", "main", "C-Gateway shutdown complete");
     return 0;
 }
@@ -0,0 +1,498 @@
+/**
+ * idempotency_cache.c - Idempotency-Key response cache
+ *
+ * Each shard is a chained hash table under one mutex. An entry is either
+ * an open claim, holding the queue of duplicates waiting on it, or a
+ * completed response on the shard's LRU list. Only completed entries are
+ * evicted or expire; claims are bounded by the requests in flight and
+ * leave when their owner completes or abandons them.
+ *
+ * Responses are reference counted so a hit or a woken duplicate can send
+ * one after the lock is dropped, even if the entry is evicted meanwhile.
+ */
+
+#define _GNU_SOURCE
+#include "idempotency_cache.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MIN_BUCKETS      64              /* Per shard, power of two */
+#define MAX_SHARDS       1024
+#define SWEEP_PER_BEGIN  2               /* LRU tail entries checked for age */
+
+typedef struct {
+    idempotency_response_t pub;          /* First: handed out as the response */
+    atomic_size_t refs;
+    size_t charge;
+    char data[];
+} cache_response_t;
+
+typedef struct waiter {
+    idempotency_waiter_fn fn;
+    void *arg;
+    struct waiter *next;
+} waiter_t;
+
+typedef struct lru_link {
+    struct lru_link *prev;
+    struct lru_link *next;
+} lru_link_t;
+
+typedef struct shard shard_t;
+
+struct idempotency_claim_t {
+    lru_link_t lru;                      /* First; completed entries only */
+    struct idempotency_claim_t *hnext;   /* Hash chain */
+    shard_t *shard;
+    uint64_t hash;
+    uint64_t fingerprint;
+    uint64_t expires_ms;
+    cache_response_t *response;          /* NULL while the claim is open */
+    waiter_t *waiters;                   /* FIFO */
+    waiter_t **waiters_tail;
+    int num_waiters;
+    size_t charge;                       /* Bytes counted against the shard */
+    size_t key_len;
+    char key[];
+};
+
+typedef struct idempotency_claim_t entry_t;
+
+struct shard {
+    pthread_mutex_t lock;
+    entry_t **buckets;
+    size_t bucket_mask;
+    size_t count;
+    lru_link_t lru;                      /* Sentinel: next is newest */
+    size_t bytes;
+    size_t budget;
+    uint64_t ttl_ms;
+    int max_waiters;
+    idempotency_cache_stats_t stats;     /* entries/bytes filled on read */
+} __attribute__((aligned(64)));
+
+struct idempotency_cache_t {
+    shard_t *shards;
+    size_t shard_mask;
+};
+
+static uint64_t now_ms_monotonic(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000U + (uint64_t)ts.tv_nsec / 1000000U;
+}
+
+static int env_positive_int(const char *name, int def_val) {
+    const char *val = getenv(name);
+    if (val == NULL || *val == '\0') {
+        return def_val;
+    }
+    int parsed = atoi(val);
+    return parsed > 0 ? parsed : def_val;
+}
+
+uint64_t idempotency_cache_fingerprint(const void *data, size_t len) {
+    uint64_t h = 14695981039346656037ULL;   /* FNV-1a */
+    const unsigned char *p = data;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/* ---------------- Responses ---------------- */
+
+static cache_response_t *response_new(int status, const char *body, size_t len) {
+    cache_response_t *r = malloc(sizeof(*r) + len + 1U);
+    if (!r) return NULL;
+    if (len > 0) memcpy(r->data, body, len);
+    r->data[len] = '\0';
+    r->pub.status = status;
+    r->pub.len = len;
+    r->pub.body = r->data;
+    r->charge = sizeof(*r) + len + 1U;
+    atomic_init(&r->refs, 1);
+    return r;
+}
+
+void idempotency_response_release(const idempotency_response_t *response) {
+    if (!response) return;
+    cache_response_t *r = (cache_response_t *)(uintptr_t)response;
+    if (atomic_fetch_sub_explicit(&r->refs, 1, memory_order_acq_rel) == 1) {
+        free(r);
+    }
+}
+
+/* ---------------- Shard internals (lock held) ---------------- */
+
+static entry_t *shard_find(shard_t *s, uint64_t hash, const char *key, size_t key_len) {
+    for (entry_t *e = s->buckets[hash & s->bucket_mask]; e; e = e->hnext) {
+        if (e->hash == hash && e->key_len == key_len && memcmp(e->key, key, key_len) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+static void shard_grow(shard_t *s) {
+    size_t n = (s->bucket_mask + 1U) * 2U;
+    entry_t **buckets = calloc(n, sizeof(*buckets));
+    if (!buckets) return;                /* Longer chains, still correct */
+    for (size_t i = 0; i <= s->bucket_mask; i++) {
+        entry_t *e = s->buckets[i];
+        while (e) {
+            entry_t *next = e->hnext;
+            e->hnext = buckets[e->hash & (n - 1U)];
+            buckets[e->hash & (n - 1U)] = e;
+            e = next;
+        }
+    }
+    free(s->buckets);
+    s->buckets = buckets;
+    s->bucket_mask = n - 1U;
+}
+
+static void lru_unlink(entry_t *e) {
+    e->lru.prev->next = e->lru.next;
+    e->lru.next->prev = e->lru.prev;
+    e->lru.prev = e->lru.next = NULL;
+}
+
+static void lru_push_front(shard_t *s, entry_t *e) {
+    e->lru.prev = &s->lru;
+    e->lru.next = s->lru.next;
+    s->lru.next->prev = &e->lru;
+    s->lru.next = &e->lru;
+}
+
+static entry_t *lru_coldest(shard_t *s) {
+    return s->lru.prev != &s->lru ? (entry_t *)s->lru.prev : NULL;
+}
+
+/* Take e out of the table; the caller frees it */
+static void shard_remove(shard_t *s, entry_t *e) {
+    entry_t **link = &s->buckets[e->hash & s->bucket_mask];
+    while (*link != e) {
+        link = &(*link)->hnext;
+    }
+    *link = e->hnext;
+    if (e->response) lru_unlink(e);
+    s->bytes -= e->charge;
+    s->count--;
+}
+
+static void entry_free(entry_t *e) {
+    if (e->response) idempotency_response_release(&e->response->pub);
+    free(e);
+}
+
+/* Drop completed entries from the cold end until the shard fits */
+static void shard_evict(shard_t *s, const entry_t *keep) {
+    lru_link_t *link = s->lru.prev;
+    while (s->bytes > s->budget && link != &s->lru) {
+        lru_link_t *prev = link->prev;
+        entry_t *e = (entry_t *)link;
+        if (e != keep) {
+            shard_remove(s, e);
+            entry_free(e);
+            s->stats.evictions++;
+        }
+        link = prev;
+    }
+}
+
+static void shard_sweep(shard_t *s, uint64_t now_ms) {
+    for (int i = 0; i < SWEEP_PER_BEGIN; i++) {
+        entry_t *e = lru_coldest(s);
+        if (!e || e->expires_ms > now_ms) break;
+        shard_remove(s, e);
+        entry_free(e);
+        s->stats.expirations++;
+    }
+}
+
+/* Detach the queue of an entry leaving the open state */
+static waiter_t *take_waiters(entry_t *e) {
+    waiter_t *w = e->waiters;
+    e->waiters = NULL;
+    e->waiters_tail = &e->waiters;
+    e->num_waiters = 0;
+    return w;
+}
+
+static void wake_waiters(waiter_t *w, cache_response_t *r) {
+    while (w) {
+        waiter_t *next = w->next;
+        w->fn(r ? &r->pub : NULL, w->arg);
+        free(w);
+        w = next;
+    }
+}
+
+/* ---------------- API ---------------- */
+
+void idempotency_cache_get_default_config(idempotency_cache_config_t *config) {
+    if (!config) return;
+    config->max_bytes = 64U * 1024U * 1024U;
+    config->shards = 16;
+    config->ttl_ms = 10 * 60 * 1000;
+    config->max_waiters = 64;
+}
+
+int idempotency_cache_parse_config(idempotency_cache_config_t *config) {
+    if (!config) return -1;
+
+    const char *bytes = getenv("GATEWAY_IDEMPOTENCY_MAX_BYTES");
+    if (bytes != NULL && *bytes != '\0') {
+        unsigned long long parsed = strtoull(bytes, NULL, 10);
+        if (parsed > 0) config->max_bytes = (size_t)parsed;
+    }
+    config->shards = env_positive_int("GATEWAY_IDEMPOTENCY_SHARDS", config->shards);
+    config->ttl_ms = env_positive_int("GATEWAY_IDEMPOTENCY_TTL_MS", config->ttl_ms);
+    config->max_waiters = env_positive_int("GATEWAY_IDEMPOTENCY_MAX_WAITERS", config->max_waiters);
+    return 0;
+}
+
+idempotency_cache_t *idempotency_cache_create(const idempotency_cache_config_t *config) {
+    idempotency_cache_config_t defaults;
+    if (!config) {
+        idempotency_cache_get_default_config(&defaults);
+        config = &defaults;
+    }
+    if (config->max_bytes == 0 || config->shards <= 0 || config->shards > MAX_SHARDS ||
+        config->ttl_ms <= 0 || config->max_waiters < 0) {
+        return NULL;
+    }
+
+    size_t shards = 1;
+    while (shards < (size_t)config->shards) {
+        shards <<= 1;
+    }
+
+    idempotency_cache_t *c = calloc(1, sizeof(*c));
+    if (!c) return NULL;
+    if (posix_memalign((void **)&c->shards, 64, shards * sizeof(shard_t)) != 0) {
+        free(c);
+        return NULL;
+    }
+    memset(c->shards, 0, shards * sizeof(shard_t));
+    c->shard_mask = shards - 1U;
+
+    for (size_t i = 0; i < shards; i++) {
+        shard_t *s = &c->shards[i];
+        s->buckets = calloc(MIN_BUCKETS, sizeof(*s->buckets));
+        if (!s->buckets) {
+            for (size_t j = 0; j < i; j++) {
+                free(c->shards[j].buckets);
+                pthread_mutex_destroy(&c->shards[j].lock);
+            }
+            free(c->shards);
+            free(c);
+            return NULL;
+        }
+        pthread_mutex_init(&s->lock, NULL);
+        s->bucket_mask = MIN_BUCKETS - 1U;
+        s->lru.prev = s->lru.next = &s->lru;
+        s->budget = config->max_bytes / shards;
+        s->ttl_ms = (uint64_t)config->ttl_ms;
+        s->max_waiters = config->max_waiters;
+    }
+    return c;
+}
+
+idempotency_result_t idempotency_cache_begin(idempotency_cache_t *c, const char *key, size_t key_len,
+                                             uint64_t fingerprint, idempotency_waiter_fn waiter,
+                                             void *waiter_arg, idempotency_claim_t **claim,
+                                             const idempotency_response_t **hit) {
+    return idempotency_cache_begin_at(c, key, key_len, fingerprint, waiter, waiter_arg, claim, hit,
+                                      now_ms_monotonic());
+}
+
+idempotency_result_t idempotency_cache_begin_at(idempotency_cache_t *c, const char *key, size_t key_len,
+                                                uint64_t fingerprint, idempotency_waiter_fn waiter,
+                                                void *waiter_arg, idempotency_claim_t **claim,
+                                                const idempotency_response_t **hit, uint64_t now_ms) {
+    if (claim) *claim = NULL;
+    if (hit) *hit = NULL;
+    if (!c || !key || key_len == 0 || !claim || !hit) return IDEMPOTENCY_ERROR;
+
+    uint64_t hash = idempotency_cache_fingerprint(key, key_len);
+    shard_t *s = &c->shards[(hash >> 32) & c->shard_mask];
+
+    pthread_mutex_lock(&s->lock);
+    shard_sweep(s, now_ms);
+
+    entry_t *e = shard_find(s, hash, key, key_len);
+    if (e && e->response && e->expires_ms <= now_ms) {
+        shard_remove(s, e);
+        entry_free(e);
+        s->stats.expirations++;
+        e = NULL;
+    }
+
+    if (e) {
+        idempotency_result_t result;
+        if (e->fingerprint != fingerprint) {
+            s->stats.mismatches++;
+            result = IDEMPOTENCY_MISMATCH;
+        } else if (e->response) {
+            atomic_fetch_add_explicit(&e->response->refs, 1, memory_order_relaxed);
+            *hit = &e->response->pub;
+            lru_unlink(e);
+            lru_push_front(s, e);
+            s->stats.hits++;
+            result = IDEMPOTENCY_HIT;
+        } else if (!waiter || e->num_waiters >= s->max_waiters) {
+            s->stats.busy++;
+            result = IDEMPOTENCY_BUSY;
+        } else {
+            waiter_t *w = malloc(sizeof(*w));
+            if (w) {
+                w->fn = waiter;
+                w->arg = waiter_arg;
+                w->next = NULL;
+                *e->waiters_tail = w;
+                e->waiters_tail = &w->next;
+                e->num_waiters++;
+                s->stats.coalesced++;
+                result = IDEMPOTENCY_WAITING;
+            } else {
+                result = IDEMPOTENCY_ERROR;
+            }
+        }
+        pthread_mutex_unlock(&s->lock);
+        return result;
+    }
+
+    e = calloc(1, sizeof(*e) + key_len + 1U);
+    if (!e) {
+        pthread_mutex_unlock(&s->lock);
+        return IDEMPOTENCY_ERROR;
+    }
+    e->shard = s;
+    e->hash = hash;
+    e->fingerprint = fingerprint;
+    e->waiters_tail = &e->waiters;
+    e->charge = sizeof(*e) + key_len + 1U;
+    e->key_len = key_len;
+    memcpy(e->key, key, key_len);
+
+    entry_t **bucket = &s->buckets[hash & s->bucket_mask];
+    e->hnext = *bucket;
+    *bucket = e;
+    s->count++;
+    s->bytes += e->charge;
+    s->stats.misses++;
+    if (s->count > s->bucket_mask + 1U) {
+        shard_grow(s);
+    }
+    shard_evict(s, NULL);
+    pthread_mutex_unlock(&s->lock);
+
+    *claim = e;
+    return IDEMPOTENCY_MISS;
+}
+
+void idempotency_cache_complete(idempotency_claim_t *claim, int status, const char *body, size_t len,
+                                int ttl_ms) {
+    idempotency_cache_complete_at(claim, status, body, len, ttl_ms, now_ms_monotonic());
+}
+
+void idempotency_cache_complete_at(idempotency_claim_t *claim, int status, const char *body, size_t len,
+                                   int ttl_ms, uint64_t now_ms) {
+    if (!claim) return;
+    if (!body) len = 0;
+    entry_t *e = claim;
+    shard_t *s = e->shard;
+
+    cache_response_t *r = response_new(status, body, len);
+
+    pthread_mutex_lock(&s->lock);
+    int waiting = e->num_waiters;
+    waiter_t *w = take_waiters(e);
+    if (r) {
+        /* One reference per woken duplicate, taken before anyone else
+         * can see the entry and evict it */
+        atomic_fetch_add_explicit(&r->refs, (size_t)waiting, memory_order_relaxed);
+    }
+    uint64_t ttl = ttl_ms == IDEMPOTENCY_TTL_DEFAULT ? s->ttl_ms : (uint64_t)(ttl_ms > 0 ? ttl_ms : 0);
+    int stored = r != NULL && ttl > 0 && e->charge + r->charge <= s->budget;
+    if (stored) {
+        e->response = r;                 /* The table keeps our reference */
+        e->charge += r->charge;
+        /* Entries with a shorter TTL than the coldest may outlive it until
+         * looked up or evicted; a lookup never returns one past expiry */
+        e->expires_ms = now_ms + ttl;
+        s->bytes += r->charge;
+        lru_push_front(s, e);
+        shard_evict(s, e);
+    } else {
+        shard_remove(s, e);
+    }
+    pthread_mutex_unlock(&s->lock);
+
+    if (!stored) {
+        entry_free(e);
+    }
+    wake_waiters(w, r);
+    if (r && !stored) {
+        idempotency_response_release(&r->pub);
+    }
+}
+
+void idempotency_cache_abandon(idempotency_claim_t *claim) {
+    if (!claim) return;
+    entry_t *e = claim;
+    shard_t *s = e->shard;
+
+    pthread_mutex_lock(&s->lock);
+    waiter_t *w = take_waiters(e);
+    shard_remove(s, e);
+    pthread_mutex_unlock(&s->lock);
+
+    entry_free(e);
+    wake_waiters(w, NULL);
+}
+
+int idempotency_cache_get_stats(idempotency_cache_t *c, idempotency_cache_stats_t *stats) {
+    if (!c || !stats) return -1;
+    memset(stats, 0, sizeof(*stats));
+    for (size_t i = 0; i <= c->shard_mask; i++) {
+        shard_t *s = &c->shards[i];
+        pthread_mutex_lock(&s->lock);
+        stats->hits += s->stats.hits;
+        stats->misses += s->stats.misses;
+        stats->coalesced += s->stats.coalesced;
+        stats->mismatches += s->stats.mismatches;
+        stats->busy += s->stats.busy;
+        stats->evictions += s->stats.evictions;
+        stats->expirations += s->stats.expirations;
+        stats->entries += s->count;
+        stats->bytes += s->bytes;
+        pthread_mutex_unlock(&s->lock);
+    }
+    return 0;
+}
+
+void idempotency_cache_destroy(idempotency_cache_t *c) {
+    if (!c) return;
+    for (size_t i = 0; i <= c->shard_mask; i++) {
+        shard_t *s = &c->shards[i];
+        for (size_t b = 0; b <= s->bucket_mask; b++) {
+            entry_t *e = s->buckets[b];
+            while (e) {
+                entry_t *next = e->hnext;
+                entry_free(e);
+                e = next;
+            }
+        }
+        free(s->buckets);
+        pthread_mutex_destroy(&s->lock);
+    }
+    free(c->shards);
+    free(c);
+}
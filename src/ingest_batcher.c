@@ -0,0 +1,419 @@
+/**
+ * ingest_batcher.c - Per-subject batching for fire-and-forget ingest
+ *
+ * An open batch is found through a small chained hash on its subject
+ * and is also linked, oldest first, on a list ordered by linger
+ * deadline; since every batch lingers equally long, appending new ones
+ * keeps that list sorted. Sealing a batch (full, expired, evicted for a
+ * new subject, or flushed) moves it to the ready list. The flusher
+ * thread sleeps until the oldest deadline or until something is ready,
+ * then closes each ready batch's JSON array and calls send with the
+ * mutex released.
+ */
+
+#define _GNU_SOURCE
+#include "ingest_batcher.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MIN_BATCH_BYTES 64U
+
+typedef struct batch_node {
+    ingest_batch_t pub;              /* First: ingest_batch_done() casts back */
+    struct ingest_batcher_t *owner;
+    char *subject;
+    char *buf;                       /* "[m1,m2" until sealed */
+    size_t len;
+    size_t cap;
+    char *id_buf;                    /* Ids back to back, NUL-terminated */
+    size_t id_len;
+    size_t id_cap;
+    const char **ids;                /* Built when sent */
+    size_t bytes;                    /* Charged to pending_bytes */
+    uint64_t deadline_us;
+    struct batch_node *hnext;        /* Open: hash chain */
+    struct batch_node *prev;         /* Open: linger order */
+    struct batch_node *next;         /* Open: linger order; sealed: ready list */
+} batch_node_t;
+
+struct ingest_batcher_t {
+    ingest_batcher_config_t config;
+    ingest_send_fn send;
+    ingest_result_fn result;
+    void *arg;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;             /* Wakes the flusher */
+    pthread_cond_t idle;             /* in_flight dropped to zero */
+    pthread_t thread;
+    int stopping;
+    uint64_t linger_us;
+
+    batch_node_t **buckets;
+    size_t bucket_mask;
+    int open_count;
+    batch_node_t *oldest;            /* Open batches by deadline */
+    batch_node_t *newest;
+    batch_node_t *ready_head;
+    batch_node_t *ready_tail;
+
+    uint64_t next_seq;
+    ingest_batcher_stats_t stats;
+};
+
+static int env_int(const char *name, int min_val, int def_val) {
+    const char *val = getenv(name);
+    if (val == NULL || *val == '\0') {
+        return def_val;
+    }
+    char *end = NULL;
+    long parsed = strtol(val, &end, 10);
+    if (*end != '\0' || parsed < min_val || parsed > 1000000) {
+        return def_val;
+    }
+    return (int)parsed;
+}
+
+static uint64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+static size_t hash_subject(const char *s) {
+    uint64_t h = 1469598103934665603ULL;
+    for (; *s; s++) {
+        h ^= (unsigned char)*s;
+        h *= 1099511628211ULL;
+    }
+    return (size_t)h;
+}
+
+void ingest_batcher_get_default_config(ingest_batcher_config_t *config) {
+    if (!config) return;
+    config->max_batch_messages = 256;
+    config->max_batch_bytes = 256U * 1024U;
+    config->linger_ms = 5;
+    config->max_pending_bytes = 64U * 1024U * 1024U;
+    config->max_subjects = 1024;
+}
+
+int ingest_batcher_parse_config(ingest_batcher_config_t *config) {
+    if (!config) return -1;
+    config->max_batch_messages = env_int("GATEWAY_INGEST_BATCH_MESSAGES", 1, config->max_batch_messages);
+    config->max_batch_bytes = (size_t)env_int("GATEWAY_INGEST_BATCH_KB", 1,
+                                              (int)(config->max_batch_bytes / 1024U)) * 1024U;
+    config->linger_ms = env_int("GATEWAY_INGEST_LINGER_MS", 0, config->linger_ms);
+    config->max_pending_bytes = (size_t)env_int("GATEWAY_INGEST_MAX_PENDING_MB", 1,
+                                                (int)(config->max_pending_bytes / (1024U * 1024U)))
+                                * 1024U * 1024U;
+    config->max_subjects = env_int("GATEWAY_INGEST_MAX_SUBJECTS", 1, config->max_subjects);
+    return 0;
+}
+
+static void node_free(batch_node_t *node) {
+    free(node->subject);
+    free(node->buf);
+    free(node->id_buf);
+    free(node->ids);
+    free(node);
+}
+
+static int grow(char **buf, size_t *cap, size_t need) {
+    if (need <= *cap) return 0;
+    size_t n = *cap ? *cap : 256U;
+    while (n < need) n *= 2U;
+    char *p = realloc(*buf, n);
+    if (!p) return -1;
+    *buf = p;
+    *cap = n;
+    return 0;
+}
+
+/* Caller holds the mutex */
+static batch_node_t *open_find(ingest_batcher_t *b, const char *subject, size_t h) {
+    for (batch_node_t *node = b->buckets[h & b->bucket_mask]; node; node = node->hnext) {
+        if (strcmp(node->subject, subject) == 0) return node;
+    }
+    return NULL;
+}
+
+static batch_node_t *open_new(ingest_batcher_t *b, const char *subject, size_t h) {
+    batch_node_t *node = calloc(1, sizeof(*node));
+    if (!node) return NULL;
+    node->owner = b;
+    node->subject = strdup(subject);
+    if (!node->subject) {
+        free(node);
+        return NULL;
+    }
+    node->pub.subject = node->subject;
+    node->pub.oldest_us = monotonic_us();
+    node->deadline_us = node->pub.oldest_us + b->linger_us;
+
+    size_t slot = h & b->bucket_mask;
+    node->hnext = b->buckets[slot];
+    b->buckets[slot] = node;
+    node->prev = b->newest;
+    if (b->newest) b->newest->next = node;
+    else b->oldest = node;
+    b->newest = node;
+    b->open_count++;
+    return node;
+}
+
+static void open_unlink(ingest_batcher_t *b, batch_node_t *node) {
+    batch_node_t **link = &b->buckets[hash_subject(node->subject) & b->bucket_mask];
+    while (*link != node) link = &(*link)->hnext;
+    *link = node->hnext;
+    if (node->prev) node->prev->next = node->next;
+    else b->oldest = node->next;
+    if (node->next) node->next->prev = node->prev;
+    else b->newest = node->prev;
+    b->open_count--;
+    node->hnext = NULL;
+    node->prev = NULL;
+    node->next = NULL;
+}
+
+/* Move an open batch to the ready list */
+static void seal(ingest_batcher_t *b, batch_node_t *node) {
+    open_unlink(b, node);
+    if (b->ready_tail) b->ready_tail->next = node;
+    else b->ready_head = node;
+    b->ready_tail = node;
+}
+
+static int append(batch_node_t *node, const char *id, const char *json, size_t len) {
+    size_t id_size = strlen(id) + 1U;
+    /* Separator, the message, and room for the closing bracket and NUL */
+    if (grow(&node->buf, &node->cap, node->len + len + 3U) != 0 ||
+        grow(&node->id_buf, &node->id_cap, node->id_len + id_size) != 0) {
+        return -1;
+    }
+    node->buf[node->len++] = node->pub.count == 0 ? '[' : ',';
+    memcpy(node->buf + node->len, json, len);
+    node->len += len;
+    memcpy(node->id_buf + node->id_len, id, id_size);
+    node->id_len += id_size;
+    node->pub.count++;
+    return 0;
+}
+
+int ingest_batcher_submit(ingest_batcher_t *b, const char *subject, const char *id,
+                          const char *json, size_t len) {
+    if (!b || !subject || !*subject || !json || len == 0) return -1;
+    if (!id) id = "";
+    size_t cost = len + strlen(id) + 2U;
+    size_t h = hash_subject(subject);
+
+    pthread_mutex_lock(&b->mutex);
+    if (b->stopping || b->stats.pending_bytes + cost > b->config.max_pending_bytes) {
+        b->stats.refused++;
+        pthread_mutex_unlock(&b->mutex);
+        return -1;
+    }
+    int wake = 0;
+    batch_node_t *node = open_find(b, subject, h);
+    if (node && node->len + len + 2U > b->config.max_batch_bytes) {
+        seal(b, node);
+        node = NULL;
+        wake = 1;
+    }
+    if (!node) {
+        if (b->open_count >= b->config.max_subjects) {
+            seal(b, b->oldest);
+        }
+        wake = 1;                    /* A new deadline, or a sealed batch */
+        node = open_new(b, subject, h);
+    }
+    if (!node || append(node, id, json, len) != 0) {
+        b->stats.refused++;
+        if (node && node->pub.count == 0) {
+            open_unlink(b, node);
+            node_free(node);
+        }
+        if (wake) pthread_cond_signal(&b->cond);
+        pthread_mutex_unlock(&b->mutex);
+        return -1;
+    }
+    node->bytes += cost;
+    b->stats.pending_bytes += cost;
+    b->stats.accepted++;
+    if (node->pub.count >= (size_t)b->config.max_batch_messages || node->len >= b->config.max_batch_bytes) {
+        seal(b, node);
+        wake = 1;
+    }
+    if (wake) pthread_cond_signal(&b->cond);
+    pthread_mutex_unlock(&b->mutex);
+    return 0;
+}
+
+static void batch_release(ingest_batcher_t *b, batch_node_t *node, int status) {
+    if (b->result) b->result(&node->pub, status, b->arg);
+    pthread_mutex_lock(&b->mutex);
+    b->stats.pending_bytes -= node->bytes;
+    if (status == 0) {
+        b->stats.acked += node->pub.count;
+    } else {
+        b->stats.failed += node->pub.count;
+        b->stats.failed_batches++;
+    }
+    if (--b->stats.in_flight == 0) pthread_cond_broadcast(&b->idle);
+    pthread_mutex_unlock(&b->mutex);
+    node_free(node);
+}
+
+void ingest_batch_done(ingest_batch_t *batch, int status) {
+    if (!batch) return;
+    batch_node_t *node = (batch_node_t *)batch;
+    batch_release(node->owner, node, status);
+}
+
+/* Close the array and index the ids; 0 on success */
+static int finish(batch_node_t *node) {
+    node->buf[node->len++] = ']';
+    node->buf[node->len] = '\0';
+    node->pub.payload = node->buf;
+    node->pub.payload_len = node->len;
+    node->ids = malloc(node->pub.count * sizeof(*node->ids));
+    if (!node->ids) return -1;
+    const char *id = node->id_buf;
+    for (size_t i = 0; i < node->pub.count; i++) {
+        node->ids[i] = id;
+        id += strlen(id) + 1U;
+    }
+    node->pub.ids = node->ids;
+    return 0;
+}
+
+static void *flusher_main(void *arg) {
+    ingest_batcher_t *b = (ingest_batcher_t *)arg;
+    pthread_mutex_lock(&b->mutex);
+    for (;;) {
+        uint64_t now = monotonic_us();
+        while (b->oldest && (b->stopping || b->oldest->deadline_us <= now)) {
+            seal(b, b->oldest);
+        }
+        if (b->ready_head) {
+            batch_node_t *list = b->ready_head;
+            b->ready_head = NULL;
+            b->ready_tail = NULL;
+            for (batch_node_t *node = list; node; node = node->next) {
+                node->pub.seq = ++b->next_seq;
+                b->stats.batches++;
+                b->stats.in_flight++;
+            }
+            pthread_mutex_unlock(&b->mutex);
+            while (list) {
+                batch_node_t *node = list;
+                list = node->next;
+                node->next = NULL;
+                int rc = finish(node) == 0 ? b->send(&node->pub, b->arg) : -1;
+                if (rc != 0) batch_release(b, node, rc);
+            }
+            pthread_mutex_lock(&b->mutex);
+            continue;
+        }
+        if (b->stopping) break;
+        if (b->oldest) {
+            uint64_t deadline = b->oldest->deadline_us;
+            struct timespec ts;
+            ts.tv_sec = (time_t)(deadline / 1000000ULL);
+            ts.tv_nsec = (long)(deadline % 1000000ULL) * 1000L;
+            pthread_cond_timedwait(&b->cond, &b->mutex, &ts);
+        } else {
+            pthread_cond_wait(&b->cond, &b->mutex);
+        }
+    }
+    pthread_mutex_unlock(&b->mutex);
+    return NULL;
+}
+
+ingest_batcher_t *ingest_batcher_create(const ingest_batcher_config_t *config,
+                                        ingest_send_fn send, ingest_result_fn result, void *arg) {
+    if (!config || !send || config->max_batch_messages < 1 ||
+        config->max_batch_bytes < MIN_BATCH_BYTES || config->linger_ms < 0 ||
+        config->max_pending_bytes == 0 || config->max_subjects < 1) {
+        return NULL;
+    }
+    ingest_batcher_t *b = calloc(1, sizeof(*b));
+    if (!b) return NULL;
+    b->config = *config;
+    b->send = send;
+    b->result = result;
+    b->arg = arg;
+    b->linger_us = (uint64_t)config->linger_ms * 1000U;
+
+    size_t nbuckets = 16;
+    while (nbuckets < (size_t)config->max_subjects * 2U) nbuckets *= 2U;
+    b->buckets = calloc(nbuckets, sizeof(*b->buckets));
+    if (!b->buckets) {
+        free(b);
+        return NULL;
+    }
+    b->bucket_mask = nbuckets - 1U;
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&b->mutex, NULL);
+    pthread_cond_init(&b->cond, &attr);
+    pthread_cond_init(&b->idle, NULL);
+    pthread_condattr_destroy(&attr);
+
+    if (pthread_create(&b->thread, NULL, flusher_main, b) != 0) {
+        pthread_cond_destroy(&b->idle);
+        pthread_cond_destroy(&b->cond);
+        pthread_mutex_destroy(&b->mutex);
+        free(b->buckets);
+        free(b);
+        return NULL;
+    }
+    return b;
+}
+
+void ingest_batcher_flush(ingest_batcher_t *b) {
+    if (!b) return;
+    pthread_mutex_lock(&b->mutex);
+    if (b->oldest) {
+        while (b->oldest) seal(b, b->oldest);
+        pthread_cond_signal(&b->cond);
+    }
+    pthread_mutex_unlock(&b->mutex);
+}
+
+void ingest_batcher_get_stats(ingest_batcher_t *b, ingest_batcher_stats_t *stats) {
+    if (!stats) return;
+    if (!b) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    pthread_mutex_lock(&b->mutex);
+    *stats = b->stats;
+    pthread_mutex_unlock(&b->mutex);
+}
+
+void ingest_batcher_destroy(ingest_batcher_t *b) {
+    if (!b) return;
+    pthread_mutex_lock(&b->mutex);
+    b->stopping = 1;
+    pthread_cond_signal(&b->cond);
+    pthread_mutex_unlock(&b->mutex);
+    pthread_join(b->thread, NULL);
+
+    /* Acks come back on other threads; they still need the batcher */
+    pthread_mutex_lock(&b->mutex);
+    while (b->stats.in_flight > 0) {
+        pthread_cond_wait(&b->idle, &b->mutex);
+    }
+    pthread_mutex_unlock(&b->mutex);
+
+    pthread_cond_destroy(&b->idle);
+    pthread_cond_destroy(&b->cond);
+    pthread_mutex_destroy(&b->mutex);
+    free(b->buckets);
+    free(b);
+}
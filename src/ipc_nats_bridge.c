@@ -6,6 +6,8 @@
 #include "router_contract.h"
 #include "nats_resilience.h"
 #include "nats_client_stub.h"  /* For nats_request_decide */
+#include "log_throttle.h"
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -25,6 +27,29 @@ struct ipc_nats_bridge_t {
     size_t overload_rejects;  /* Rejected due to inflight limit */
 };
 
+/* Per-request lines; the payload dumps only show at debug level */
+static log_callsite_t log_site_received = LOG_CALLSITE_INIT("bridge_received", LOG_LEVEL_INFO);
+static log_callsite_t log_site_request = LOG_CALLSITE_INIT("bridge_nats_request", LOG_LEVEL_DEBUG);
+static log_callsite_t log_site_response = LOG_CALLSITE_INIT("bridge_nats_response", LOG_LEVEL_DEBUG);
+static log_callsite_t log_site_failure = LOG_CALLSITE_INIT("bridge_nats_failure", LOG_LEVEL_WARN);
+
+/**
+ * Print a "[bridge]" line if its callsite allows it
+ */
+static void bridge_log(log_callsite_t *site, const char *fmt, ...) {
+    uint64_t suppressed = 0;
+    if (!log_throttle_allow(site, &suppressed)) return;
+    va_list args;
+    va_start(args, fmt);
+    fputs("[bridge] ", stdout);
+    vprintf(fmt, args);
+    va_end(args);
+    if (suppressed > 0) {
+        printf(" (suppressed %llu similar messages)", (unsigned long long)suppressed);
+    }
+    putchar('\n');
+}
+
 /**
  * Generate unique task ID
  */
@@ -119,8 +144,8 @@ static void bridge_message_handler(const ipc_message_t *request,
     bridge->total_requests++;
     
     /* Log request */
-    printf("[bridge] Received IPC message type=0x%02x payload_len=%zu\n",
-           request->type, request->payload_len);
+    bridge_log(&log_site_received, "Received IPC message type=0x%02x payload_len=%zu",
+               request->type, request->payload_len);
     
     /* Handle based on message type */
     switch (request->type) {
@@ -154,7 +179,7 @@ static void bridge_message_handler(const ipc_message_t *request,
         return;
     }
     
-    printf("[bridge] NATS request: %s\n", nats_req);
+    bridge_log(&log_site_request, "NATS request: %s", nats_req);
     
     /* Call NATS client */
     char nats_resp[8192];
@@ -172,10 +197,11 @@ static void bridge_message_handler(const ipc_message_t *request,
             request->payload ? request->payload : "null");
     }
     
-    printf("[bridge] NATS response (rc=%d): %s\n", nats_rc, nats_resp);
-    
     if (nats_rc != 0) {
+        bridge_log(&log_site_failure, "NATS response (rc=%d): %s", nats_rc, nats_resp);
         bridge->nats_errors++;
+    } else {
+        bridge_log(&log_site_response, "NATS response (rc=%d): %s", nats_rc, nats_resp);
     }
     
     /* Transform NATS response to IPC format */
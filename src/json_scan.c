@@ -0,0 +1,336 @@
+/**
+ * json_scan.c - Validating JSON lexer for single-pass readers
+ *
+ * Recursive descent over the raw bytes, following jansson's decoder
+ * rule for rule so that readers built on it accept the same documents.
+ */
+
+#include "json_scan.h"
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+void json_scan_init(json_scan_t *s, const char *json, size_t len) {
+    s->base = json;
+    s->p = json;
+    s->end = json + len;
+    s->depth = 0;
+}
+
+static void skip_ws(json_scan_t *s) {
+    while (s->p < s->end &&
+           (*s->p == ' ' || *s->p == '\t' || *s->p == '\n' || *s->p == '\r')) {
+        s->p++;
+    }
+}
+
+static int hex4(const char *p, unsigned *out) {
+    unsigned v = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9') v |= (unsigned)(c - '0');
+        else if (c >= 'a' && c <= 'f') v |= (unsigned)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') v |= (unsigned)(c - 'A' + 10);
+        else return -1;
+    }
+    *out = v;
+    return 0;
+}
+
+/* Append one byte to a bounded output; silently truncates */
+static void put(char *out, size_t size, size_t *n, char c) {
+    if (out && *n + 1U < size) {
+        out[*n] = c;
+    }
+    (*n)++;
+}
+
+static void put_utf8(char *out, size_t size, size_t *n, unsigned cp) {
+    if (cp < 0x80U) {
+        put(out, size, n, (char)cp);
+    } else if (cp < 0x800U) {
+        put(out, size, n, (char)(0xC0U | (cp >> 6)));
+        put(out, size, n, (char)(0x80U | (cp & 0x3FU)));
+    } else if (cp < 0x10000U) {
+        put(out, size, n, (char)(0xE0U | (cp >> 12)));
+        put(out, size, n, (char)(0x80U | ((cp >> 6) & 0x3FU)));
+        put(out, size, n, (char)(0x80U | (cp & 0x3FU)));
+    } else {
+        put(out, size, n, (char)(0xF0U | (cp >> 18)));
+        put(out, size, n, (char)(0x80U | ((cp >> 12) & 0x3FU)));
+        put(out, size, n, (char)(0x80U | ((cp >> 6) & 0x3FU)));
+        put(out, size, n, (char)(0x80U | (cp & 0x3FU)));
+    }
+}
+
+/* Length of the well-formed UTF-8 sequence at p, 0 if malformed */
+static size_t utf8_len(const unsigned char *p, const unsigned char *end) {
+    unsigned c = p[0];
+    size_t n;
+    unsigned cp;
+    if (c < 0xC2U) return 0;                             /* Continuation or overlong */
+    if (c < 0xE0U) { n = 2; cp = c & 0x1FU; }
+    else if (c < 0xF0U) { n = 3; cp = c & 0x0FU; }
+    else if (c < 0xF5U) { n = 4; cp = c & 0x07U; }
+    else return 0;
+    if ((size_t)(end - p) < n) return 0;
+    for (size_t i = 1; i < n; i++) {
+        if ((p[i] & 0xC0U) != 0x80U) return 0;
+        cp = (cp << 6) | (p[i] & 0x3FU);
+    }
+    if ((n == 3 && cp < 0x800U) || (n == 4 && cp < 0x10000U)) return 0;
+    if (cp > 0x10FFFFU || (cp >= 0xD800U && cp <= 0xDFFFU)) return 0;
+    return n;
+}
+
+int json_scan_string(json_scan_t *s, char *out, size_t size) {
+    size_t n = 0;
+    if (json_scan_peek(s) != '"') return -1;
+    s->p++;
+    for (;;) {
+        if (s->p >= s->end) return -1;
+        unsigned char c = (unsigned char)*s->p;
+        if (c == '"') {
+            s->p++;
+            break;
+        }
+        if (c < 0x20U) return -1;
+        if (c == '\\') {
+            if (s->end - s->p < 2) return -1;
+            char e = s->p[1];
+            s->p += 2;
+            switch (e) {
+                case '"':  put(out, size, &n, '"'); break;
+                case '\\': put(out, size, &n, '\\'); break;
+                case '/':  put(out, size, &n, '/'); break;
+                case 'b':  put(out, size, &n, '\b'); break;
+                case 'f':  put(out, size, &n, '\f'); break;
+                case 'n':  put(out, size, &n, '\n'); break;
+                case 'r':  put(out, size, &n, '\r'); break;
+                case 't':  put(out, size, &n, '\t'); break;
+                case 'u': {
+                    unsigned cp;
+                    if (s->end - s->p < 4 || hex4(s->p, &cp) != 0) return -1;
+                    s->p += 4;
+                    if (cp >= 0xD800U && cp <= 0xDBFFU) {
+                        unsigned lo;
+                        if (s->end - s->p < 6 || s->p[0] != '\\' || s->p[1] != 'u' ||
+                            hex4(s->p + 2, &lo) != 0 || lo < 0xDC00U || lo > 0xDFFFU) {
+                            return -1;
+                        }
+                        s->p += 6;
+                        cp = 0x10000U + ((cp - 0xD800U) << 10) + (lo - 0xDC00U);
+                    } else if (cp >= 0xDC00U && cp <= 0xDFFFU) {
+                        return -1;
+                    } else if (cp == 0) {
+                        return -1;
+                    }
+                    put_utf8(out, size, &n, cp);
+                    break;
+                }
+                default:
+                    return -1;
+            }
+            continue;
+        }
+        if (c < 0x80U) {
+            put(out, size, &n, (char)c);
+            s->p++;
+            continue;
+        }
+        size_t len = utf8_len((const unsigned char *)s->p, (const unsigned char *)s->end);
+        if (len == 0) return -1;
+        for (size_t i = 0; i < len; i++) {
+            put(out, size, &n, s->p[i]);
+        }
+        s->p += len;
+    }
+    if (out && size > 0) {
+        out[n < size ? n : size - 1U] = '\0';
+    }
+    return 0;
+}
+
+static int is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+/* jansson rejects integers outside json_int_t (long long) */
+static int integer_fits(const char *digits, size_t n, int negative) {
+    static const char max_digits[] = "9223372036854775807";
+    static const char min_digits[] = "9223372036854775808";
+    const size_t limit = sizeof(max_digits) - 1U;
+    if (n != limit) return n < limit;
+    return memcmp(digits, negative ? min_digits : max_digits, limit) <= 0;
+}
+
+/* ...and reals that overflow to infinity; only huge magnitudes need strtod */
+static int real_fits(const char *start, const char *end, size_t int_digits, long exp10) {
+    if ((long)int_digits + exp10 < 300) return 1;
+
+    char small[128];
+    char *copy = small;
+    size_t n = (size_t)(end - start);
+    if (n >= sizeof(small)) {
+        copy = malloc(n + 1U);
+        if (!copy) return 0;
+    }
+    memcpy(copy, start, n);
+    copy[n] = '\0';
+    errno = 0;
+    double v = strtod(copy, NULL);
+    int fits = !(errno == ERANGE && (v == HUGE_VAL || v == -HUGE_VAL));
+    if (copy != small) free(copy);
+    return fits;
+}
+
+static int scan_number(json_scan_t *s) {
+    const char *start = s->p;
+    int negative = 0;
+    if (s->p < s->end && *s->p == '-') {
+        negative = 1;
+        s->p++;
+    }
+    const char *digits = s->p;
+    if (s->p >= s->end || !is_digit(*s->p)) return -1;
+    if (*s->p == '0') {
+        s->p++;
+    } else {
+        while (s->p < s->end && is_digit(*s->p)) s->p++;
+    }
+    size_t int_digits = (size_t)(s->p - digits);
+    int is_real = 0;
+    long exp10 = 0;
+    if (s->p < s->end && *s->p == '.') {
+        is_real = 1;
+        s->p++;
+        if (s->p >= s->end || !is_digit(*s->p)) return -1;
+        while (s->p < s->end && is_digit(*s->p)) s->p++;
+    }
+    if (s->p < s->end && (*s->p == 'e' || *s->p == 'E')) {
+        is_real = 1;
+        int exp_negative = 0;
+        s->p++;
+        if (s->p < s->end && (*s->p == '+' || *s->p == '-')) {
+            exp_negative = *s->p == '-';
+            s->p++;
+        }
+        if (s->p >= s->end || !is_digit(*s->p)) return -1;
+        while (s->p < s->end && is_digit(*s->p)) {
+            if (exp10 < 100000) exp10 = exp10 * 10 + (*s->p - '0');
+            s->p++;
+        }
+        if (exp_negative) exp10 = -exp10;
+    }
+    if (!is_real) {
+        return integer_fits(digits, int_digits, negative) ? 0 : -1;
+    }
+    return real_fits(start, s->p, int_digits, exp10) ? 0 : -1;
+}
+
+static int scan_literal(json_scan_t *s, const char *lit) {
+    size_t n = strlen(lit);
+    if ((size_t)(s->end - s->p) < n || memcmp(s->p, lit, n) != 0) return -1;
+    s->p += n;
+    return 0;
+}
+
+static int scan_array(json_scan_t *s) {
+    if (json_scan_array_open(s) != 0) return -1;
+    int count = 0;
+    int rc;
+    while ((rc = json_scan_array_next(s, &count)) == 1) {
+        if (json_scan_value(s) != 0) return -1;
+    }
+    return rc;
+}
+
+static int scan_object(json_scan_t *s) {
+    if (json_scan_object_open(s) != 0) return -1;
+    int count = 0;
+    int rc;
+    while ((rc = json_scan_object_next(s, &count, NULL, 0)) == 1) {
+        if (json_scan_value(s) != 0) return -1;
+    }
+    return rc;
+}
+
+char json_scan_peek(json_scan_t *s) {
+    skip_ws(s);
+    return s->p < s->end ? *s->p : '\0';
+}
+
+int json_scan_value(json_scan_t *s) {
+    switch (json_scan_peek(s)) {
+        case '\0': return -1;
+        case '{': return scan_object(s);
+        case '[': return scan_array(s);
+        case '"': return json_scan_string(s, NULL, 0);
+        case 't': return scan_literal(s, "true");
+        case 'f': return scan_literal(s, "false");
+        case 'n': return scan_literal(s, "null");
+        default:  return scan_number(s);
+    }
+}
+
+int json_scan_object_open(json_scan_t *s) {
+    if (json_scan_peek(s) != '{' || s->depth >= JSON_SCAN_MAX_DEPTH) return -1;
+    s->depth++;
+    s->p++;
+    return 0;
+}
+
+int json_scan_object_next(json_scan_t *s, int *count, char *key, size_t key_size) {
+    skip_ws(s);
+    if (s->p >= s->end) return -1;
+    if (*s->p == '}') {
+        s->p++;
+        s->depth--;
+        return 0;
+    }
+    if (*count > 0) {
+        if (*s->p != ',') return -1;
+        s->p++;
+    }
+    if (json_scan_string(s, key, key_size) != 0) return -1;
+    /* A key that may have been truncated must not match a short name */
+    if (key && key_size > 0 && strlen(key) == key_size - 1U) key[0] = '\0';
+
+    skip_ws(s);
+    if (s->p >= s->end || *s->p != ':') return -1;
+    s->p++;
+    (*count)++;
+    return 1;
+}
+
+int json_scan_array_open(json_scan_t *s) {
+    if (json_scan_peek(s) != '[' || s->depth >= JSON_SCAN_MAX_DEPTH) return -1;
+    s->depth++;
+    s->p++;
+    return 0;
+}
+
+int json_scan_array_next(json_scan_t *s, int *count) {
+    skip_ws(s);
+    if (s->p >= s->end) return -1;
+    if (*s->p == ']') {
+        s->p++;
+        s->depth--;
+        return 0;
+    }
+    if (*count > 0) {
+        if (*s->p != ',') return -1;
+        s->p++;
+        skip_ws(s);
+        if (s->p < s->end && *s->p == ']') return -1;
+    }
+    (*count)++;
+    return 1;
+}
+
+int json_scan_finish(json_scan_t *s) {
+    skip_ws(s);
+    return s->p == s->end ? 0 : -1;
+}
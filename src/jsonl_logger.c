@@ -1,28 +1,18 @@
 /**
  * jsonl_logger.c - JSONL logging implementation
+ *
+ * Each call copies its fields into a record on the shared log pipeline
+ * (log_pipeline.h); the line is formatted and written to stderr by the
+ * pipeline thread.
  */
 
 #include "jsonl_logger.h"
+#include "log_pipeline.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 #include <stdarg.h>
-#include <sys/time.h>
-
-/* Get ISO8601 timestamp */
-static void get_timestamp(char *buf, size_t size) {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    
-    struct tm tm;
-    localtime_r(&tv.tv_sec, &tm);
-    
-    snprintf(buf, size, "%04d-%02d-%02dT%02d:%02d:%02d.%03ldZ",
-             tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
-             tm.tm_hour, tm.tm_min, tm.tm_sec,
-             tv.tv_usec / 1000);
-}
+#include <unistd.h>
 
 /* Get log level string */
 static const char* level_to_string(log_level_t level) {
@@ -35,31 +25,47 @@ static const char* level_to_string(log_level_t level) {
     }
 }
 
+static void emit(log_format_fn format, const log_value_t *values, size_t count) {
+    (void)log_pipeline_write(log_pipeline_default(), STDERR_FILENO, format, values, count);
+}
+
+/* Append ,"name":value when the value was given */
+static void put_optional(log_line_t *l, const char *name, const log_value_t *v) {
+    if (v->kind == LOG_VALUE_NULL) return;
+    log_line_raw(l, ",\"");
+    log_line_raw(l, name);
+    log_line_raw(l, "\":");
+    log_line_value(l, v);
+}
+
+/* Event record: level, component, request_id, trace_id, tenant_id, message */
+static size_t format_event(const log_record_t *rec, char *out, size_t cap) {
+    const log_value_t *v = rec->values;
+    log_line_t l = { out, cap, 0 };
+    log_line_raw(&l, "{\"timestamp\":");
+    log_line_timestamp(&l, rec->ts_us, 3);
+    log_line_raw(&l, ",\"level\":");
+    log_line_value(&l, &v[0]);
+    put_optional(&l, "component", &v[1]);
+    put_optional(&l, "request_id", &v[2]);
+    put_optional(&l, "trace_id", &v[3]);
+    put_optional(&l, "tenant_id", &v[4]);
+    log_line_raw(&l, ",\"message\":");
+    log_line_value(&l, &v[5]);
+    log_line_raw(&l, "}");
+    return log_line_end(&l);
+}
+
 void jsonl_log(log_level_t level, const log_context_t *ctx, const char *message) {
-    char timestamp[32];
-    get_timestamp(timestamp, sizeof(timestamp));
-    
-    /* Build JSONL output */
-    fprintf(stderr, "{\"timestamp\":\"%s\",\"level\":\"%s\"",
-            timestamp, level_to_string(level));
-    
-    if (ctx) {
-        if (ctx->component) {
-            fprintf(stderr, ",\"component\":\"%s\"", ctx->component);
-        }
-        if (ctx->request_id) {
-            fprintf(stderr, ",\"request_id\":\"%s\"", ctx->request_id);
-        }
-        if (ctx->trace_id) {
-            fprintf(stderr, ",\"trace_id\":\"%s\"", ctx->trace_id);
-        }
-        if (ctx->tenant_id) {
-            fprintf(stderr, ",\"tenant_id\":\"%s\"", ctx->tenant_id);
-        }
-    }
-    
-    fprintf(stderr, ",\"message\":\"%s\"}\n", message ? message : "");
-    fflush(stderr);
+    log_value_t values[] = {
+        LOG_STR(level_to_string(level)),
+        LOG_STR(ctx ? ctx->component : NULL),
+        LOG_STR(ctx ? ctx->request_id : NULL),
+        LOG_STR(ctx ? ctx->trace_id : NULL),
+        LOG_STR(ctx ? ctx->tenant_id : NULL),
+        LOG_STR(message ? message : ""),
+    };
+    emit(format_event, values, sizeof(values) / sizeof(values[0]));
 }
 
 void jsonl_logf(log_level_t level, const log_context_t *ctx, const char *fmt, ...) {
@@ -73,52 +79,88 @@ void jsonl_logf(log_level_t level, const log_context_t *ctx, const char *fmt, ..
     jsonl_log(level, ctx, message);
 }
 
+/* Fixed head of the component events below */
+static void put_head(log_line_t *l, const log_record_t *rec, const char *level, const char *event) {
+    log_line_raw(l, "{\"timestamp\":");
+    log_line_timestamp(l, rec->ts_us, 3);
+    log_line_raw(l, ",\"level\":\"");
+    log_line_raw(l, level);
+    log_line_raw(l, "\",\"event\":\"");
+    log_line_raw(l, event);
+    log_line_raw(l, "\",\"component\":");
+    log_line_value(l, &rec->values[0]);
+    log_line_raw(l, ",\"request_id\":");
+    log_line_value(l, &rec->values[1]);
+}
+
+/* component, request_id, method, payload_size */
+static size_t format_request(const log_record_t *rec, char *out, size_t cap) {
+    log_line_t l = { out, cap, 0 };
+    put_head(&l, rec, "INFO", "request_received");
+    log_line_raw(&l, ",\"method\":");
+    log_line_value(&l, &rec->values[2]);
+    log_line_raw(&l, ",\"payload_size\":");
+    log_line_value(&l, &rec->values[3]);
+    log_line_raw(&l, "}");
+    return log_line_end(&l);
+}
+
 void jsonl_log_request(const char *component, const char *request_id,
                        const char *method, size_t payload_size) {
-    char timestamp[32];
-    get_timestamp(timestamp, sizeof(timestamp));
-    
-    fprintf(stderr, 
-        "{\"timestamp\":\"%s\",\"level\":\"INFO\",\"event\":\"request_received\","
-        "\"component\":\"%s\",\"request_id\":\"%s\",\"method\":\"%s\","
-        "\"payload_size\":%zu}\n",
-        timestamp, component ? component : "unknown",
-        request_id ? request_id : "none",
-        method ? method : "unknown",
-        payload_size);
-    
-    fflush(stderr);
+    log_value_t values[] = {
+        LOG_STR(component ? component : "unknown"),
+        LOG_STR(request_id ? request_id : "none"),
+        LOG_STR(method ? method : "unknown"),
+        LOG_INT(payload_size),
+    };
+    emit(format_request, values, sizeof(values) / sizeof(values[0]));
+}
+
+/* component, request_id, status_code, response_size, duration_ms */
+static size_t format_response(const log_record_t *rec, char *out, size_t cap) {
+    log_line_t l = { out, cap, 0 };
+    put_head(&l, rec, "INFO", "response_sent");
+    log_line_raw(&l, ",\"status_code\":");
+    log_line_value(&l, &rec->values[2]);
+    log_line_raw(&l, ",\"response_size\":");
+    log_line_value(&l, &rec->values[3]);
+    log_line_raw(&l, ",\"duration_ms\":");
+    log_line_value(&l, &rec->values[4]);
+    log_line_raw(&l, "}");
+    return log_line_end(&l);
 }
 
 void jsonl_log_response(const char *component, const char *request_id,
                         int status_code, size_t response_size, int duration_ms) {
-    char timestamp[32];
-    get_timestamp(timestamp, sizeof(timestamp));
-    
-    fprintf(stderr,
-        "{\"timestamp\":\"%s\",\"level\":\"INFO\",\"event\":\"response_sent\","
-        "\"component\":\"%s\",\"request_id\":\"%s\",\"status_code\":%d,"
-        "\"response_size\":%zu,\"duration_ms\":%d}\n",
-        timestamp, component ? component : "unknown",
-        request_id ? request_id : "none",
-        status_code, response_size, duration_ms);
-    
-    fflush(stderr);
+    log_value_t values[] = {
+        LOG_STR(component ? component : "unknown"),
+        LOG_STR(request_id ? request_id : "none"),
+        LOG_INT(status_code),
+        LOG_INT(response_size),
+        LOG_INT(duration_ms),
+    };
+    emit(format_response, values, sizeof(values) / sizeof(values[0]));
+}
+
+/* component, request_id, error_code, error_message */
+static size_t format_error(const log_record_t *rec, char *out, size_t cap) {
+    log_line_t l = { out, cap, 0 };
+    put_head(&l, rec, "ERROR", "error");
+    log_line_raw(&l, ",\"error_code\":");
+    log_line_value(&l, &rec->values[2]);
+    log_line_raw(&l, ",\"error_message\":");
+    log_line_value(&l, &rec->values[3]);
+    log_line_raw(&l, "}");
+    return log_line_end(&l);
 }
 
 void jsonl_log_error(const char *component, const char *request_id,
                      const char *error_code, const char *error_message) {
-    char timestamp[32];
-    get_timestamp(timestamp, sizeof(timestamp));
-    
-    fprintf(stderr,
-        "{\"timestamp\":\"%s\",\"level\":\"ERROR\",\"event\":\"error\","
-        "\"component\":\"%s\",\"request_id\":\"%s\",\"error_code\":\"%s\","
-        "\"error_message\":\"%s\"}\n",
-        timestamp, component ? component : "unknown",
-        request_id ? request_id : "none",
-        error_code ? error_code : "unknown",
-        error_message ? error_message : "");
-    
-    fflush(stderr);
+    log_value_t values[] = {
+        LOG_STR(component ? component : "unknown"),
+        LOG_STR(request_id ? request_id : "none"),
+        LOG_STR(error_code ? error_code : "unknown"),
+        LOG_STR(error_message ? error_message : ""),
+    };
+    emit(format_error, values, sizeof(values) / sizeof(values[0]));
 }
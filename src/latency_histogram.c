@@ -0,0 +1,238 @@
+/**
+ * latency_histogram.c - Mergeable log-linear latency histograms
+ *
+ * A shard belongs to one recording thread and holds `slices` rows of
+ * bucket counters, row epoch % slices serving slice `epoch`. Only the
+ * owner writes a shard, so a sample is a relaxed load and store of one
+ * counter. When the owner moves into a new slice it reuses the row with
+ * a seqlock-style handshake: the row's tag goes to ROW_RESETTING while
+ * the counters are cleared, then to the new epoch. Readers copy a row
+ * between two reads of its tag and retry if the tag moved, so they never
+ * merge a half-cleared row or one from the wrong slice.
+ */
+
+#define _GNU_SOURCE
+#include "latency_histogram.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define ROW_EMPTY         0ULL               /* Row never used */
+#define ROW_RESETTING     UINT64_MAX         /* Owner is clearing the row */
+#define SHARD_CACHE_SIZE  4                  /* Histograms a thread records into
+                                                without a list walk */
+#define SNAPSHOT_RETRIES  4
+
+#define SUB_COUNT   (1U << LATENCY_HISTOGRAM_SUB_BITS)
+#define EXACT_LIMIT (2U << LATENCY_HISTOGRAM_SUB_BITS)
+#define MAX_VALUE   ((1ULL << LATENCY_HISTOGRAM_MAX_BITS) - 1ULL)
+
+typedef struct {
+    atomic_uint_fast64_t tag;        /* epoch + 1, ROW_EMPTY or ROW_RESETTING */
+    atomic_uint counts[LATENCY_HISTOGRAM_BUCKETS];
+} hist_row_t;
+
+typedef struct hist_shard {
+    struct hist_shard *next;         /* Immutable once published */
+    hist_row_t rows[];
+} hist_shard_t;
+
+struct latency_histogram_t {
+    latency_histogram_config_t config;
+    uint64_t id;                     /* Never reused, keys the thread caches */
+    _Atomic(hist_shard_t *) shards;  /* Treiber list, push-only until destroy */
+};
+
+typedef struct {
+    uint64_t id;
+    hist_shard_t *shard;
+} shard_cache_entry_t;
+
+static atomic_uint_fast64_t g_next_id = 1;
+static _Thread_local shard_cache_entry_t tls_shards[SHARD_CACHE_SIZE];
+static _Thread_local unsigned tls_shard_next = 0;
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000ULL;
+}
+
+static unsigned bucket_index(uint64_t v) {
+    if (v > MAX_VALUE) v = MAX_VALUE;
+    if (v < EXACT_LIMIT) return (unsigned)v;
+    unsigned msb = 63U - (unsigned)__builtin_clzll(v);
+    unsigned shift = msb - LATENCY_HISTOGRAM_SUB_BITS;
+    unsigned sub = (unsigned)(v >> shift) & (SUB_COUNT - 1U);
+    return EXACT_LIMIT + (msb - LATENCY_HISTOGRAM_SUB_BITS - 1U) * SUB_COUNT + sub;
+}
+
+/* Highest value that lands in bucket idx */
+static uint64_t bucket_high(unsigned idx) {
+    if (idx < EXACT_LIMIT) return idx;
+    unsigned octave = (idx - EXACT_LIMIT) / SUB_COUNT;
+    unsigned sub = (idx - EXACT_LIMIT) % SUB_COUNT;
+    unsigned shift = octave + 1U;
+    uint64_t low = ((uint64_t)(SUB_COUNT + sub)) << shift;
+    return low + (1ULL << shift) - 1ULL;
+}
+
+void latency_histogram_get_default_config(latency_histogram_config_t *config) {
+    if (!config) return;
+    config->slice_ms = 10000;
+    config->slices = 30;
+}
+
+latency_histogram_t *latency_histogram_create(const latency_histogram_config_t *config) {
+    latency_histogram_config_t defaults;
+    if (!config) {
+        latency_histogram_get_default_config(&defaults);
+        config = &defaults;
+    }
+    if (config->slice_ms <= 0 || config->slices <= 0) return NULL;
+
+    latency_histogram_t *h = calloc(1, sizeof(*h));
+    if (!h) return NULL;
+    h->config = *config;
+    h->id = atomic_fetch_add(&g_next_id, 1);
+    atomic_init(&h->shards, NULL);
+    return h;
+}
+
+static hist_shard_t *shard_new(latency_histogram_t *h) {
+    size_t size = sizeof(hist_shard_t) + (size_t)h->config.slices * sizeof(hist_row_t);
+    hist_shard_t *shard = calloc(1, size);
+    if (!shard) return NULL;
+
+    hist_shard_t *head = atomic_load_explicit(&h->shards, memory_order_relaxed);
+    do {
+        shard->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&h->shards, &head, shard,
+                                                    memory_order_release,
+                                                    memory_order_relaxed));
+    return shard;
+}
+
+/* This thread's shard of h; a cache miss just starts a fresh shard */
+static hist_shard_t *shard_for_thread(latency_histogram_t *h) {
+    for (unsigned i = 0; i < SHARD_CACHE_SIZE; i++) {
+        if (tls_shards[i].id == h->id) return tls_shards[i].shard;
+    }
+    hist_shard_t *shard = shard_new(h);
+    if (!shard) return NULL;
+    shard_cache_entry_t *e = &tls_shards[tls_shard_next++ % SHARD_CACHE_SIZE];
+    e->id = h->id;
+    e->shard = shard;
+    return shard;
+}
+
+void latency_histogram_record_at(latency_histogram_t *h, uint64_t value_us, uint64_t now) {
+    if (!h) return;
+    hist_shard_t *shard = shard_for_thread(h);
+    if (!shard) return;
+
+    uint64_t epoch = now / (uint64_t)h->config.slice_ms;
+    hist_row_t *row = &shard->rows[epoch % (uint64_t)h->config.slices];
+    uint64_t tag = epoch + 1U;
+
+    if (atomic_load_explicit(&row->tag, memory_order_relaxed) != tag) {
+        atomic_store_explicit(&row->tag, ROW_RESETTING, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        for (unsigned i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+            atomic_store_explicit(&row->counts[i], 0U, memory_order_relaxed);
+        }
+        atomic_store_explicit(&row->tag, tag, memory_order_release);
+    }
+
+    atomic_uint *c = &row->counts[bucket_index(value_us)];
+    atomic_store_explicit(c, atomic_load_explicit(c, memory_order_relaxed) + 1U,
+                          memory_order_relaxed);
+}
+
+void latency_histogram_record(latency_histogram_t *h, uint64_t value_us) {
+    if (!h) return;
+    latency_histogram_record_at(h, value_us, now_ms());
+}
+
+/* Add row to snap if it serves a slice in [first, last]; 0 if it moved under us */
+static int merge_row(const hist_row_t *row, uint64_t first, uint64_t last,
+                     latency_histogram_snapshot_t *snap) {
+    unsigned copy[LATENCY_HISTOGRAM_BUCKETS];
+
+    uint64_t tag = atomic_load_explicit(&row->tag, memory_order_acquire);
+    if (tag == ROW_EMPTY) return 1;
+    if (tag == ROW_RESETTING) return 0;
+    if (tag - 1U < first || tag - 1U > last) return 1;
+
+    for (unsigned i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+        copy[i] = atomic_load_explicit(&row->counts[i], memory_order_relaxed);
+    }
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&row->tag, memory_order_relaxed) != tag) return 0;
+
+    for (unsigned i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+        snap->counts[i] += copy[i];
+        snap->total += copy[i];
+    }
+    return 1;
+}
+
+int latency_histogram_snapshot_at(const latency_histogram_t *h, int window_ms, uint64_t now,
+                                  latency_histogram_snapshot_t *snap) {
+    if (!h || !snap || window_ms <= 0) return -1;
+    memset(snap, 0, sizeof(*snap));
+
+    uint64_t slice_ms = (uint64_t)h->config.slice_ms;
+    uint64_t span = ((uint64_t)window_ms + slice_ms - 1U) / slice_ms;
+    if (span > (uint64_t)h->config.slices) span = (uint64_t)h->config.slices;
+    uint64_t last = now / slice_ms;
+    uint64_t first = last + 1U > span ? last + 1U - span : 0U;
+
+    for (const hist_shard_t *s = atomic_load_explicit(&h->shards, memory_order_acquire);
+         s != NULL; s = s->next) {
+        for (int i = 0; i < h->config.slices; i++) {
+            /* A lost race means the owner just rotated the row; its new
+             * slice may be the current one, so look again */
+            for (int attempt = 0; attempt < SNAPSHOT_RETRIES; attempt++) {
+                if (merge_row(&s->rows[i], first, last, snap)) break;
+            }
+        }
+    }
+    return 0;
+}
+
+int latency_histogram_snapshot(const latency_histogram_t *h, int window_ms,
+                               latency_histogram_snapshot_t *snap) {
+    return latency_histogram_snapshot_at(h, window_ms, now_ms(), snap);
+}
+
+uint64_t latency_histogram_percentile(const latency_histogram_snapshot_t *snap, double percentile) {
+    if (!snap || snap->total == 0) return 0;
+    if (percentile < 0.0) percentile = 0.0;
+    if (percentile > 100.0) percentile = 100.0;
+
+    /* Nearest rank: the smallest sample with at least p% at or below it */
+    double want = (percentile / 100.0) * (double)snap->total;
+    uint64_t rank = (uint64_t)want;
+    if ((double)rank < want || rank == 0) rank++;
+    if (rank > snap->total) rank = snap->total;
+
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+        seen += snap->counts[i];
+        if (seen >= rank) return bucket_high(i);
+    }
+    return bucket_high(LATENCY_HISTOGRAM_BUCKETS - 1U);
+}
+
+void latency_histogram_destroy(latency_histogram_t *h) {
+    if (!h) return;
+    hist_shard_t *s = atomic_load(&h->shards);
+    while (s) {
+        hist_shard_t *next = s->next;
+        free(s);
+        s = next;
+    }
+    free(h);
+}
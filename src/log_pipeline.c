@@ -0,0 +1,812 @@
+/**
+ * log_pipeline.c - Asynchronous batched JSONL logging
+ *
+ * Every producing thread owns a byte ring of records. A record is a
+ * header (size, fd, timestamp, formatter), a table of values and the
+ * string bytes, always contiguous: when one does not fit before the end
+ * of the ring the producer pads to the end and starts again at 0. The
+ * producer publishes a record by moving head, the writer thread frees it
+ * by moving tail, so each side only ever stores its own cursor.
+ *
+ * The writer wakes every flush_interval_ms, when a ring passes half
+ * full, or on request (flush, a blocked producer, close). It formats
+ * records straight into per-stream batches of 64KB chunks and hands each
+ * batch to one writev. Draining and formatting run under sync_lock, which
+ * after close is what lets producers drain their own rings.
+ */
+
+#define _GNU_SOURCE
+#include "log_pipeline.h"
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LOG_PIPELINE_CACHE_LINE 64
+#define RING_CACHE_SIZE         4        /* Pipelines a thread writes to
+                                            without a list walk */
+#define MIN_RING_SIZE           (64U * 1024U)
+#define CHUNK_SIZE              (64U * 1024U)
+#define MAX_CHUNKS              64       /* Per batch, so 4MB at most */
+#define MAX_STREAMS             4        /* Distinct fds batched at once */
+#define BLOCK_WAIT_MS           10       /* Recheck period of a blocked producer */
+#define SYNC_SCRATCH            16384    /* Records encoded on the stack */
+
+typedef struct {
+    uint32_t size;                   /* Whole record, a multiple of 8 */
+    uint16_t count;
+    uint16_t reserved;
+    int32_t fd;
+    uint32_t reserved2;
+    uint64_t ts_us;
+    log_format_fn format;            /* NULL: padding to the end of the ring */
+} rec_hdr_t;
+
+typedef struct {
+    uint32_t kind;
+    uint32_t len;
+    long long num;
+} rec_value_t;
+
+typedef struct log_ring {
+    _Alignas(LOG_PIPELINE_CACHE_LINE) atomic_size_t head;   /* Producer's cursor */
+    atomic_uint_fast64_t queued;     /* Owner only: relaxed load and store */
+    atomic_uint_fast64_t dropped;
+    atomic_uint_fast64_t blocked;
+    _Alignas(LOG_PIPELINE_CACHE_LINE) atomic_size_t tail;   /* Writer's cursor */
+    struct log_ring *next;           /* Immutable once published */
+    size_t size;
+    unsigned char *data;
+} log_ring_t;
+
+typedef struct {
+    int fd;                          /* -1: unused */
+    size_t used;                     /* Chunks holding data */
+    size_t fill;                     /* Bytes in the last of them */
+    struct iovec iov[MAX_CHUNKS];
+} stream_batch_t;
+
+struct log_pipeline_t {
+    log_pipeline_config_t config;
+    uint64_t id;                     /* Never reused, keys the thread caches */
+    size_t ring_size;
+    size_t max_record;
+    size_t max_chunks;
+    _Atomic(log_ring_t *) rings;     /* Treiber list, push-only until destroy */
+    atomic_int closed;
+    atomic_int sleeping;             /* Writer is waiting for work */
+
+    /* Writer thread handshake, under mutex */
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;             /* Wakes the writer */
+    pthread_cond_t flushed;          /* flush_done moved or the writer stopped */
+    pthread_cond_t space;            /* Rings drained, for blocked producers */
+    pthread_t thread;
+    int running;
+    int stopping;
+    int joining;
+    int wake;
+    int waiters;
+    uint64_t flush_req;
+    uint64_t flush_done;
+
+    /* Formatting and output, under sync_lock */
+    pthread_mutex_t sync_lock;
+    stream_batch_t streams[MAX_STREAMS];
+
+    atomic_uint_fast64_t dropped;    /* Not tied to a ring */
+    atomic_uint_fast64_t written;
+    atomic_uint_fast64_t batches;
+    atomic_uint_fast64_t write_errors;
+};
+
+typedef struct {
+    uint64_t id;
+    log_ring_t *ring;
+} ring_cache_entry_t;
+
+static atomic_uint_fast64_t g_next_id = 1;
+static _Thread_local ring_cache_entry_t tls_rings[RING_CACHE_SIZE];
+static _Thread_local unsigned tls_ring_next = 0;
+
+static log_pipeline_t *g_default = NULL;
+static pthread_once_t g_default_once = PTHREAD_ONCE_INIT;
+
+static int env_positive_int(const char *name, int def_val) {
+    const char *val = getenv(name);
+    if (val == NULL || *val == '\0') {
+        return def_val;
+    }
+    int parsed = atoi(val);
+    return parsed > 0 ? parsed : def_val;
+}
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+static void counter_inc(atomic_uint_fast64_t *c) {
+    atomic_store_explicit(c, atomic_load_explicit(c, memory_order_relaxed) + 1U,
+                          memory_order_relaxed);
+}
+
+static size_t align8(size_t n) {
+    return (n + 7U) & ~(size_t)7U;
+}
+
+/* ---------------- Record encoding ---------------- */
+
+/* Queued length of a string value, cut back to a UTF-8 boundary */
+static size_t value_len(const log_value_t *v) {
+    size_t len = v->len == LOG_VALUE_CSTR ? strlen(v->str) : v->len;
+    if (len <= LOG_PIPELINE_STRING_MAX) return len;
+    len = LOG_PIPELINE_STRING_MAX;
+    while (len > 0 && ((unsigned char)v->str[len] & 0xC0U) == 0x80U) len--;
+    return len;
+}
+
+static int value_is_str(const log_value_t *v) {
+    return v->kind == LOG_VALUE_STR && v->str != NULL;
+}
+
+static size_t record_size(const log_value_t *values, size_t count, size_t *lens) {
+    size_t size = sizeof(rec_hdr_t) + count * sizeof(rec_value_t);
+    for (size_t i = 0; i < count; i++) {
+        lens[i] = value_is_str(&values[i]) ? value_len(&values[i]) : 0;
+        if (value_is_str(&values[i])) size += lens[i] + 1U;
+    }
+    return align8(size);
+}
+
+static void record_encode(unsigned char *dst, size_t size, int fd, uint64_t ts_us,
+                          log_format_fn format, const log_value_t *values, size_t count,
+                          const size_t *lens) {
+    rec_hdr_t hdr = { (uint32_t)size, (uint16_t)count, 0, (int32_t)fd, 0, ts_us, format };
+    memcpy(dst, &hdr, sizeof(hdr));
+    unsigned char *table = dst + sizeof(hdr);
+    unsigned char *strings = table + count * sizeof(rec_value_t);
+    for (size_t i = 0; i < count; i++) {
+        rec_value_t rv = { LOG_VALUE_NULL, 0, 0 };
+        if (value_is_str(&values[i])) {
+            rv.kind = LOG_VALUE_STR;
+            rv.len = (uint32_t)lens[i];
+            memcpy(strings, values[i].str, lens[i]);
+            strings[lens[i]] = '\0';
+            strings += lens[i] + 1U;
+        } else if (values[i].kind == LOG_VALUE_INT) {
+            rv.kind = LOG_VALUE_INT;
+            rv.num = values[i].num;
+        }
+        memcpy(table + i * sizeof(rec_value_t), &rv, sizeof(rv));
+    }
+}
+
+/* ---------------- Output (under sync_lock) ---------------- */
+
+/* Write all of iov; 0 on success, -1 if the stream refused it */
+static int write_all(int fd, struct iovec *iov, int iovcnt) {
+    while (iovcnt > 0) {
+        ssize_t n = writev(fd, iov, iovcnt);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                struct pollfd pfd = { fd, POLLOUT, 0 };
+                (void)poll(&pfd, 1, 100);
+                continue;
+            }
+            return -1;
+        }
+        size_t left = (size_t)n;
+        while (iovcnt > 0 && left >= iov->iov_len) {
+            left -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + left;
+            iov->iov_len -= left;
+        }
+    }
+    return 0;
+}
+
+static void batch_write(log_pipeline_t *p, stream_batch_t *b) {
+    if (b->used == 0) return;
+    struct iovec iov[MAX_CHUNKS];
+    for (size_t i = 0; i < b->used; i++) {
+        iov[i].iov_base = b->iov[i].iov_base;
+        iov[i].iov_len = i + 1U < b->used ? b->iov[i].iov_len : b->fill;
+    }
+    if (write_all(b->fd, iov, (int)b->used) != 0) {
+        atomic_fetch_add_explicit(&p->write_errors, 1, memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&p->batches, 1, memory_order_relaxed);
+    b->used = 0;
+    b->fill = 0;
+}
+
+static void batches_write(log_pipeline_t *p) {
+    for (int i = 0; i < MAX_STREAMS; i++) {
+        if (p->streams[i].fd >= 0) batch_write(p, &p->streams[i]);
+    }
+}
+
+/* Room for one more line in fd's batch; NULL if none can be had */
+static char *batch_reserve(log_pipeline_t *p, int fd, stream_batch_t **out) {
+    stream_batch_t *b = NULL;
+    for (int i = 0; i < MAX_STREAMS && !b; i++) {
+        if (p->streams[i].fd == fd) b = &p->streams[i];
+    }
+    for (int i = 0; i < MAX_STREAMS && !b; i++) {
+        if (p->streams[i].fd < 0) b = &p->streams[i];
+    }
+    if (!b) {
+        /* More streams than slots: write everything and take the first */
+        batches_write(p);
+        b = &p->streams[0];
+    }
+    b->fd = fd;
+
+    if (b->used > 0 && CHUNK_SIZE - b->fill < LOG_PIPELINE_LINE_MAX + 1U) {
+        if (b->used == p->max_chunks) {
+            batch_write(p, b);
+        } else {
+            b->iov[b->used - 1].iov_len = b->fill;
+            b->fill = 0;
+            b->used++;
+        }
+    }
+    if (b->used == 0) {
+        b->used = 1;
+        b->fill = 0;
+    }
+    struct iovec *chunk = &b->iov[b->used - 1];
+    if (!chunk->iov_base) {
+        chunk->iov_base = malloc(CHUNK_SIZE);
+        if (!chunk->iov_base) {
+            b->used--;
+            b->fill = b->used > 0 ? b->iov[b->used - 1].iov_len : 0;
+            return NULL;
+        }
+    }
+    *out = b;
+    return (char *)chunk->iov_base + b->fill;
+}
+
+/* Decode the record at src into hdr and rec; values receive its table */
+static void record_decode(const unsigned char *src, rec_hdr_t *out_hdr, log_value_t *values,
+                          log_record_t *rec) {
+    rec_hdr_t hdr;
+    memcpy(&hdr, src, sizeof(hdr));
+    const unsigned char *table = src + sizeof(hdr);
+    const char *strings = (const char *)(table + (size_t)hdr.count * sizeof(rec_value_t));
+    for (size_t i = 0; i < hdr.count; i++) {
+        rec_value_t rv;
+        memcpy(&rv, table + i * sizeof(rec_value_t), sizeof(rv));
+        values[i].kind = (log_value_kind_t)rv.kind;
+        values[i].str = NULL;
+        values[i].len = 0;
+        values[i].num = rv.num;
+        if (rv.kind == LOG_VALUE_STR) {
+            values[i].str = strings;
+            values[i].len = rv.len;
+            strings += rv.len + 1U;
+        }
+    }
+    rec->ts_us = hdr.ts_us;
+    rec->values = values;
+    rec->count = hdr.count;
+    *out_hdr = hdr;
+}
+
+/* Format the record at src into its stream's batch */
+static void record_emit(log_pipeline_t *p, const unsigned char *src) {
+    log_value_t values[LOG_PIPELINE_MAX_VALUES];
+    log_record_t rec;
+    rec_hdr_t hdr;
+    record_decode(src, &hdr, values, &rec);
+
+    stream_batch_t *b = NULL;
+    char *out = batch_reserve(p, hdr.fd, &b);
+    size_t n = out ? hdr.format(&rec, out, LOG_PIPELINE_LINE_MAX) : 0;
+    if (n == 0 || n > LOG_PIPELINE_LINE_MAX) {
+        atomic_fetch_add_explicit(&p->dropped, 1, memory_order_relaxed);
+        return;
+    }
+    out[n] = '\n';
+    b->fill += n + 1U;
+    atomic_fetch_add_explicit(&p->written, 1, memory_order_relaxed);
+}
+
+/* Emit everything queued in r; the caller holds sync_lock */
+static void ring_drain(log_pipeline_t *p, log_ring_t *r) {
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&r->head, memory_order_seq_cst);
+    while (tail != head) {
+        size_t pos = tail & (r->size - 1U);
+        size_t contiguous = r->size - pos;
+        size_t size = contiguous;
+        if (contiguous >= sizeof(rec_hdr_t)) {
+            rec_hdr_t hdr;
+            memcpy(&hdr, r->data + pos, sizeof(hdr));
+            if (hdr.format) {
+                record_emit(p, r->data + pos);
+                size = hdr.size;
+            }
+        }
+        tail += size;
+        atomic_store_explicit(&r->tail, tail, memory_order_release);
+    }
+}
+
+static void rings_drain(log_pipeline_t *p) {
+    for (log_ring_t *r = atomic_load_explicit(&p->rings, memory_order_acquire); r; r = r->next) {
+        ring_drain(p, r);
+    }
+}
+
+/* Format and write one record on the calling thread */
+static int write_sync(log_pipeline_t *p, int fd, log_format_fn format, uint64_t ts_us,
+                      const log_value_t *values, size_t count) {
+    static pthread_mutex_t bare_lock = PTHREAD_MUTEX_INITIALIZER;
+    static char bare_line[LOG_PIPELINE_LINE_MAX + 1];
+
+    size_t lens[LOG_PIPELINE_MAX_VALUES];
+    size_t size = record_size(values, count, lens);
+    _Alignas(8) unsigned char scratch[SYNC_SCRATCH];
+    unsigned char *buf = size <= sizeof(scratch) ? scratch : malloc(size);
+    if (!buf) {
+        if (p) atomic_fetch_add_explicit(&p->dropped, 1, memory_order_relaxed);
+        return -1;
+    }
+    record_encode(buf, size, fd, ts_us, format, values, count, lens);
+
+    int rc = -1;
+    if (p) {
+        pthread_mutex_lock(&p->sync_lock);
+        uint64_t before = atomic_load_explicit(&p->written, memory_order_relaxed);
+        record_emit(p, buf);
+        batches_write(p);
+        if (atomic_load_explicit(&p->written, memory_order_relaxed) != before) rc = 0;
+        pthread_mutex_unlock(&p->sync_lock);
+    } else {
+        /* No pipeline: same formatting, one line per write */
+        log_value_t decoded[LOG_PIPELINE_MAX_VALUES];
+        log_record_t rec;
+        rec_hdr_t hdr;
+        record_decode(buf, &hdr, decoded, &rec);
+        pthread_mutex_lock(&bare_lock);
+        size_t n = format(&rec, bare_line, LOG_PIPELINE_LINE_MAX);
+        if (n > 0 && n <= LOG_PIPELINE_LINE_MAX) {
+            bare_line[n] = '\n';
+            struct iovec iov = { bare_line, n + 1U };
+            rc = write_all(fd, &iov, 1);
+        }
+        pthread_mutex_unlock(&bare_lock);
+    }
+    if (buf != scratch) free(buf);
+    return rc;
+}
+
+/* ---------------- Writer thread ---------------- */
+
+static void wake_writer(log_pipeline_t *p) {
+    pthread_mutex_lock(&p->mutex);
+    p->wake = 1;
+    pthread_cond_signal(&p->cond);
+    pthread_mutex_unlock(&p->mutex);
+}
+
+static void deadline_after_ms(struct timespec *ts, int ms) {
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += (time_t)(ms / 1000);
+    ts->tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+static void *writer_main(void *arg) {
+    log_pipeline_t *p = arg;
+    pthread_mutex_lock(&p->mutex);
+    for (;;) {
+        if (!p->stopping && !p->wake && p->flush_done == p->flush_req) {
+            struct timespec deadline;
+            deadline_after_ms(&deadline, p->config.flush_interval_ms);
+            atomic_store_explicit(&p->sleeping, 1, memory_order_relaxed);
+            (void)pthread_cond_timedwait(&p->cond, &p->mutex, &deadline);
+            atomic_store_explicit(&p->sleeping, 0, memory_order_relaxed);
+        }
+        p->wake = 0;
+        uint64_t req = p->flush_req;
+        int stop = p->stopping;
+        pthread_mutex_unlock(&p->mutex);
+
+        pthread_mutex_lock(&p->sync_lock);
+        rings_drain(p);
+        batches_write(p);
+        pthread_mutex_unlock(&p->sync_lock);
+
+        pthread_mutex_lock(&p->mutex);
+        p->flush_done = req;
+        pthread_cond_broadcast(&p->flushed);
+        if (p->waiters > 0) pthread_cond_broadcast(&p->space);
+        if (stop) break;
+    }
+    p->running = 0;
+    pthread_cond_broadcast(&p->flushed);
+    pthread_cond_broadcast(&p->space);
+    pthread_mutex_unlock(&p->mutex);
+    return NULL;
+}
+
+/* ---------------- Producers ---------------- */
+
+static log_ring_t *ring_new(log_pipeline_t *p) {
+    log_ring_t *r = calloc(1, sizeof(*r));
+    if (!r) return NULL;
+    r->data = malloc(p->ring_size);
+    if (!r->data) {
+        free(r);
+        return NULL;
+    }
+    r->size = p->ring_size;
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    atomic_init(&r->queued, 0);
+    atomic_init(&r->dropped, 0);
+    atomic_init(&r->blocked, 0);
+
+    log_ring_t *head = atomic_load_explicit(&p->rings, memory_order_relaxed);
+    do {
+        r->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&p->rings, &head, r,
+                                                    memory_order_release,
+                                                    memory_order_relaxed));
+    return r;
+}
+
+/* This thread's ring of p; a cache miss just starts a fresh ring */
+static log_ring_t *ring_for_thread(log_pipeline_t *p) {
+    for (unsigned i = 0; i < RING_CACHE_SIZE; i++) {
+        if (tls_rings[i].id == p->id) return tls_rings[i].ring;
+    }
+    log_ring_t *r = ring_new(p);
+    if (!r) return NULL;
+    ring_cache_entry_t *e = &tls_rings[tls_ring_next++ % RING_CACHE_SIZE];
+    e->id = p->id;
+    e->ring = r;
+    return r;
+}
+
+/* Emit what this thread queued, once no writer thread will */
+static void ring_drain_own(log_pipeline_t *p, log_ring_t *r) {
+    pthread_mutex_lock(&p->sync_lock);
+    ring_drain(p, r);
+    batches_write(p);
+    pthread_mutex_unlock(&p->sync_lock);
+}
+
+/* Wait a little for the writer to free room in r */
+static void ring_wait(log_pipeline_t *p) {
+    pthread_mutex_lock(&p->mutex);
+    if (p->running) {
+        struct timespec deadline;
+        deadline_after_ms(&deadline, BLOCK_WAIT_MS);
+        p->waiters++;
+        p->wake = 1;
+        pthread_cond_signal(&p->cond);
+        (void)pthread_cond_timedwait(&p->space, &p->mutex, &deadline);
+        p->waiters--;
+    }
+    pthread_mutex_unlock(&p->mutex);
+}
+
+int log_pipeline_write(log_pipeline_t *p, int fd, log_format_fn format,
+                       const log_value_t *values, size_t count) {
+    if (!format || count > LOG_PIPELINE_MAX_VALUES || (count > 0 && !values)) return -1;
+    uint64_t ts_us = now_us();
+    if (!p || atomic_load_explicit(&p->closed, memory_order_acquire)) {
+        return write_sync(p, fd, format, ts_us, values, count);
+    }
+    log_ring_t *r = ring_for_thread(p);
+    if (!r) return write_sync(p, fd, format, ts_us, values, count);
+
+    size_t lens[LOG_PIPELINE_MAX_VALUES];
+    size_t size = record_size(values, count, lens);
+    if (size > p->max_record) {
+        counter_inc(&r->dropped);
+        return -1;
+    }
+
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    int waited = 0;
+    for (;;) {
+        size_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+        size_t contiguous = r->size - (head & (r->size - 1U));
+        size_t need = size + (contiguous < size ? contiguous : 0U);
+        if (r->size - (head - tail) >= need) break;
+        if (p->config.overflow == LOG_OVERFLOW_DROP) {
+            counter_inc(&r->dropped);
+            return -1;
+        }
+        if (!waited) {
+            counter_inc(&r->blocked);
+            waited = 1;
+        }
+        if (atomic_load_explicit(&p->closed, memory_order_seq_cst)) {
+            ring_drain_own(p, r);
+        } else {
+            ring_wait(p);
+        }
+    }
+
+    size_t pos = head & (r->size - 1U);
+    size_t contiguous = r->size - pos;
+    if (contiguous < size) {
+        /* Pad to the end; a gap too short for a header is skipped unread */
+        if (contiguous >= sizeof(rec_hdr_t)) {
+            rec_hdr_t pad = { (uint32_t)contiguous, 0, 0, -1, 0, 0, NULL };
+            memcpy(r->data + pos, &pad, sizeof(pad));
+        }
+        head += contiguous;
+        pos = 0;
+    }
+    record_encode(r->data + pos, size, fd, ts_us, format, values, count, lens);
+    head += size;
+    atomic_store_explicit(&r->head, head, memory_order_seq_cst);
+    counter_inc(&r->queued);
+
+    if (atomic_load_explicit(&p->closed, memory_order_seq_cst)) {
+        /* The writer may have stopped before seeing this record */
+        ring_drain_own(p, r);
+    } else if (atomic_load_explicit(&p->sleeping, memory_order_relaxed) &&
+               head - atomic_load_explicit(&r->tail, memory_order_relaxed) > r->size / 2U) {
+        wake_writer(p);
+    }
+    return 0;
+}
+
+/* ---------------- API ---------------- */
+
+void log_pipeline_get_default_config(log_pipeline_config_t *config) {
+    if (!config) return;
+    config->ring_kb = 256;
+    config->batch_kb = 256;
+    config->flush_interval_ms = 20;
+    config->overflow = LOG_OVERFLOW_DROP;
+}
+
+int log_pipeline_parse_config(log_pipeline_config_t *config) {
+    if (!config) return -1;
+
+    config->ring_kb = env_positive_int("GATEWAY_LOG_RING_KB", config->ring_kb);
+    config->batch_kb = env_positive_int("GATEWAY_LOG_BATCH_KB", config->batch_kb);
+    config->flush_interval_ms = env_positive_int("GATEWAY_LOG_FLUSH_MS", config->flush_interval_ms);
+    const char *overflow = getenv("GATEWAY_LOG_OVERFLOW");
+    if (overflow && strcmp(overflow, "block") == 0) {
+        config->overflow = LOG_OVERFLOW_BLOCK;
+    } else if (overflow && strcmp(overflow, "drop") == 0) {
+        config->overflow = LOG_OVERFLOW_DROP;
+    }
+    return 0;
+}
+
+static void pipeline_free(log_pipeline_t *p) {
+    log_ring_t *r = atomic_load_explicit(&p->rings, memory_order_acquire);
+    while (r) {
+        log_ring_t *next = r->next;
+        free(r->data);
+        free(r);
+        r = next;
+    }
+    for (int i = 0; i < MAX_STREAMS; i++) {
+        for (size_t c = 0; c < MAX_CHUNKS; c++) free(p->streams[i].iov[c].iov_base);
+    }
+    pthread_cond_destroy(&p->cond);
+    pthread_cond_destroy(&p->flushed);
+    pthread_cond_destroy(&p->space);
+    pthread_mutex_destroy(&p->mutex);
+    pthread_mutex_destroy(&p->sync_lock);
+    free(p);
+}
+
+log_pipeline_t *log_pipeline_create(const log_pipeline_config_t *config) {
+    log_pipeline_config_t defaults;
+    if (!config) {
+        log_pipeline_get_default_config(&defaults);
+        config = &defaults;
+    }
+    if (config->ring_kb <= 0 || config->batch_kb <= 0 || config->flush_interval_ms <= 0) return NULL;
+
+    log_pipeline_t *p = calloc(1, sizeof(*p));
+    if (!p) return NULL;
+    p->config = *config;
+    p->id = atomic_fetch_add(&g_next_id, 1);
+
+    /* Records over a quarter of the ring are dropped rather than stall it */
+    size_t want = (size_t)config->ring_kb * 1024U;
+    p->ring_size = MIN_RING_SIZE;
+    while (p->ring_size < want) p->ring_size <<= 1;
+    p->max_record = p->ring_size / 4U;
+    p->max_chunks = ((size_t)config->batch_kb * 1024U + CHUNK_SIZE - 1U) / CHUNK_SIZE;
+    if (p->max_chunks > MAX_CHUNKS) p->max_chunks = MAX_CHUNKS;
+    for (int i = 0; i < MAX_STREAMS; i++) p->streams[i].fd = -1;
+    atomic_init(&p->rings, NULL);
+    atomic_init(&p->closed, 0);
+    atomic_init(&p->sleeping, 0);
+    atomic_init(&p->dropped, 0);
+    atomic_init(&p->written, 0);
+    atomic_init(&p->batches, 0);
+    atomic_init(&p->write_errors, 0);
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&p->cond, &attr);
+    pthread_cond_init(&p->flushed, &attr);
+    pthread_cond_init(&p->space, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&p->mutex, NULL);
+    pthread_mutex_init(&p->sync_lock, NULL);
+
+    p->running = 1;
+    if (pthread_create(&p->thread, NULL, writer_main, p) != 0) {
+        pipeline_free(p);
+        return NULL;
+    }
+    return p;
+}
+
+static void default_close(void) {
+    log_pipeline_close(g_default);
+}
+
+static void default_init(void) {
+    log_pipeline_config_t config;
+    log_pipeline_get_default_config(&config);
+    (void)log_pipeline_parse_config(&config);
+    g_default = log_pipeline_create(&config);
+    if (g_default) atexit(default_close);
+}
+
+log_pipeline_t *log_pipeline_default(void) {
+    pthread_once(&g_default_once, default_init);
+    return g_default;
+}
+
+void log_pipeline_flush(log_pipeline_t *p) {
+    if (!p) return;
+    pthread_mutex_lock(&p->mutex);
+    uint64_t ticket = ++p->flush_req;
+    p->wake = 1;
+    pthread_cond_signal(&p->cond);
+    while (p->running && p->flush_done < ticket) {
+        pthread_cond_wait(&p->flushed, &p->mutex);
+    }
+    pthread_mutex_unlock(&p->mutex);
+}
+
+void log_pipeline_close(log_pipeline_t *p) {
+    if (!p) return;
+    pthread_mutex_lock(&p->mutex);
+    int join = !p->joining;
+    p->joining = 1;
+    atomic_store_explicit(&p->closed, 1, memory_order_seq_cst);
+    p->stopping = 1;
+    pthread_cond_signal(&p->cond);
+    pthread_mutex_unlock(&p->mutex);
+    if (join) pthread_join(p->thread, NULL);
+}
+
+void log_pipeline_get_stats(log_pipeline_t *p, log_pipeline_stats_t *stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!p) return;
+    for (log_ring_t *r = atomic_load_explicit(&p->rings, memory_order_acquire); r; r = r->next) {
+        stats->queued += atomic_load_explicit(&r->queued, memory_order_relaxed);
+        stats->dropped += atomic_load_explicit(&r->dropped, memory_order_relaxed);
+        stats->blocked += atomic_load_explicit(&r->blocked, memory_order_relaxed);
+    }
+    stats->dropped += atomic_load_explicit(&p->dropped, memory_order_relaxed);
+    stats->written = atomic_load_explicit(&p->written, memory_order_relaxed);
+    stats->batches = atomic_load_explicit(&p->batches, memory_order_relaxed);
+    stats->write_errors = atomic_load_explicit(&p->write_errors, memory_order_relaxed);
+}
+
+void log_pipeline_destroy(log_pipeline_t *p) {
+    if (!p) return;
+    log_pipeline_close(p);
+    pipeline_free(p);
+}
+
+/* ---------------- Line building ---------------- */
+
+static void line_put(log_line_t *l, const char *s, size_t n) {
+    if (l->len + n <= l->cap) memcpy(l->buf + l->len, s, n);
+    l->len += n;
+}
+
+void log_line_raw(log_line_t *l, const char *text) {
+    line_put(l, text, strlen(text));
+}
+
+void log_line_str(log_line_t *l, const char *s, size_t len) {
+    static const char hex[] = "0123456789abcdef";
+    line_put(l, "\"", 1);
+    size_t run = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c >= 0x20U && c != '"' && c != '\\') continue;
+        line_put(l, s + run, i - run);
+        run = i + 1U;
+        char esc[6] = { '\\', (char)c, 0, 0, 0, 0 };
+        size_t n = 2;
+        switch (c) {
+            case '"': case '\\': break;
+            case '\n': esc[1] = 'n'; break;
+            case '\r': esc[1] = 'r'; break;
+            case '\t': esc[1] = 't'; break;
+            case '\b': esc[1] = 'b'; break;
+            case '\f': esc[1] = 'f'; break;
+            default:
+                esc[1] = 'u';
+                esc[2] = '0';
+                esc[3] = '0';
+                esc[4] = hex[c >> 4];
+                esc[5] = hex[c & 0x0FU];
+                n = 6;
+                break;
+        }
+        line_put(l, esc, n);
+    }
+    line_put(l, s + run, len - run);
+    line_put(l, "\"", 1);
+}
+
+void log_line_int(log_line_t *l, long long n) {
+    char num[24];
+    int len = snprintf(num, sizeof(num), "%lld", n);
+    if (len > 0) line_put(l, num, (size_t)len);
+}
+
+void log_line_value(log_line_t *l, const log_value_t *v) {
+    if (v->kind == LOG_VALUE_STR && v->str) {
+        log_line_str(l, v->str, v->len == LOG_VALUE_CSTR ? strlen(v->str) : v->len);
+    } else if (v->kind == LOG_VALUE_INT) {
+        log_line_int(l, v->num);
+    } else {
+        line_put(l, "null", 4);
+    }
+}
+
+void log_line_timestamp(log_line_t *l, uint64_t ts_us, int digits) {
+    static _Thread_local time_t cached_sec = (time_t)-1;
+    static _Thread_local char cached[24];
+
+    time_t sec = (time_t)(ts_us / 1000000U);
+    if (sec != cached_sec) {
+        struct tm tm;
+        gmtime_r(&sec, &tm);
+        strftime(cached, sizeof(cached), "%Y-%m-%dT%H:%M:%S", &tm);
+        cached_sec = sec;
+    }
+    char ts[40];
+    unsigned frac = (unsigned)(ts_us % 1000000U);
+    int len = digits == 6 ? snprintf(ts, sizeof(ts), "\"%s.%06uZ\"", cached, frac)
+                          : snprintf(ts, sizeof(ts), "\"%s.%03uZ\"", cached, frac / 1000U);
+    if (len > 0) line_put(l, ts, (size_t)len);
+}
+
+size_t log_line_end(const log_line_t *l) {
+    return l->len <= l->cap ? l->len : 0;
+}
@@ -0,0 +1,230 @@
+/**
+ * log_throttle.c - Per-callsite rate limiting for repetitive log lines
+ *
+ * The bucket is kept as a GCRA theoretical arrival time: a line may go
+ * out when tat is at most burst-1 intervals ahead of now, and emitting
+ * it moves tat one interval further. That is a single 64-bit word, so a
+ * callsite needs no lock and a message over the limit is rejected with
+ * a load. Callsites link themselves into a push-only list the first time
+ * they are reached, which is what the stats walk.
+ */
+
+#define _GNU_SOURCE
+#include "log_throttle.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+static const char *const LEVEL_NAMES[LOG_LEVEL_COUNT] = { "error", "warn", "info", "debug" };
+
+/* Settings: each word is read independently, so a reconfiguration may be
+ * seen half-applied by a call already under way, never torn */
+static atomic_int g_level;
+static atomic_int g_rate;                   /* Per second, 0: no limit */
+static atomic_int g_burst;
+static atomic_int g_sample_every[LOG_LEVEL_COUNT];
+static pthread_once_t g_settings_once = PTHREAD_ONCE_INIT;
+
+static _Atomic(log_throttle_hook_fn) g_hook;
+static _Atomic(log_callsite_t *) g_sites;
+
+static int env_int(const char *name, int min_val, int def_val) {
+    const char *val = getenv(name);
+    if (val == NULL || *val == '\0') {
+        return def_val;
+    }
+    char *end = NULL;
+    long parsed = strtol(val, &end, 10);
+    if (*end != '\0' || parsed < min_val || parsed > 1000000) {
+        return def_val;
+    }
+    return (int)parsed;
+}
+
+static uint64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+static int config_valid(const log_throttle_config_t *config) {
+    if (config->level < LOG_LEVEL_ERROR || config->level >= LOG_LEVEL_COUNT) return 0;
+    if (config->rate_per_sec < 0 || config->rate_per_sec > 1000000) return 0;
+    if (config->burst < 1) return 0;
+    for (int i = 0; i < LOG_LEVEL_COUNT; i++) {
+        if (config->sample_every[i] < 1) return 0;
+    }
+    return 1;
+}
+
+static void store_settings(const log_throttle_config_t *config) {
+    atomic_store_explicit(&g_level, (int)config->level, memory_order_relaxed);
+    atomic_store_explicit(&g_rate, config->rate_per_sec, memory_order_relaxed);
+    atomic_store_explicit(&g_burst, config->burst, memory_order_relaxed);
+    for (int i = 0; i < LOG_LEVEL_COUNT; i++) {
+        atomic_store_explicit(&g_sample_every[i], config->sample_every[i], memory_order_relaxed);
+    }
+}
+
+static void settings_init(void) {
+    log_throttle_config_t config;
+    log_throttle_get_default_config(&config);
+    (void)log_throttle_parse_config(&config);
+    store_settings(&config);
+}
+
+void log_throttle_get_default_config(log_throttle_config_t *config) {
+    if (!config) return;
+    config->level = LOG_LEVEL_INFO;
+    config->rate_per_sec = 1;
+    config->burst = 5;
+    for (int i = 0; i < LOG_LEVEL_COUNT; i++) {
+        config->sample_every[i] = 1;
+    }
+}
+
+int log_throttle_parse_config(log_throttle_config_t *config) {
+    if (!config) return -1;
+    const char *level = getenv("GATEWAY_LOG_LEVEL");
+    if (level && *level) {
+        (void)log_level_parse(level, &config->level);
+    }
+    config->rate_per_sec = env_int("GATEWAY_LOG_RATE", 0, config->rate_per_sec);
+    config->burst = env_int("GATEWAY_LOG_BURST", 1, config->burst);
+
+    static const char *const SAMPLE_ENV[LOG_LEVEL_COUNT] = {
+        "GATEWAY_LOG_SAMPLE_ERROR", "GATEWAY_LOG_SAMPLE_WARN",
+        "GATEWAY_LOG_SAMPLE_INFO", "GATEWAY_LOG_SAMPLE_DEBUG",
+    };
+    for (int i = 0; i < LOG_LEVEL_COUNT; i++) {
+        config->sample_every[i] = env_int(SAMPLE_ENV[i], 1, config->sample_every[i]);
+    }
+    return 0;
+}
+
+int log_throttle_configure(const log_throttle_config_t *config) {
+    if (!config || !config_valid(config)) return -1;
+    pthread_once(&g_settings_once, settings_init);
+    store_settings(config);
+    return 0;
+}
+
+void log_throttle_get_config(log_throttle_config_t *config) {
+    if (!config) return;
+    pthread_once(&g_settings_once, settings_init);
+    config->level = (log_level_t)atomic_load_explicit(&g_level, memory_order_relaxed);
+    config->rate_per_sec = atomic_load_explicit(&g_rate, memory_order_relaxed);
+    config->burst = atomic_load_explicit(&g_burst, memory_order_relaxed);
+    for (int i = 0; i < LOG_LEVEL_COUNT; i++) {
+        config->sample_every[i] = atomic_load_explicit(&g_sample_every[i], memory_order_relaxed);
+    }
+}
+
+void log_throttle_set_hook(log_throttle_hook_fn hook) {
+    atomic_store_explicit(&g_hook, hook, memory_order_release);
+}
+
+static void site_register(log_callsite_t *site) {
+    int expected = 0;
+    if (!atomic_compare_exchange_strong(&site->registered, &expected, 1)) return;
+    log_callsite_t *head = atomic_load_explicit(&g_sites, memory_order_relaxed);
+    do {
+        site->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&g_sites, &head, site,
+                                                    memory_order_release, memory_order_relaxed));
+}
+
+static int site_suppress(log_callsite_t *site, log_throttle_reason_t reason) {
+    atomic_fetch_add_explicit(&site->pending, 1U, memory_order_relaxed);
+    atomic_fetch_add_explicit(&site->suppressed, 1U, memory_order_relaxed);
+    log_throttle_hook_fn hook = atomic_load_explicit(&g_hook, memory_order_acquire);
+    if (hook) hook(site, reason);
+    return 0;
+}
+
+int log_throttle_allow_at(log_callsite_t *site, uint64_t now_us, uint64_t *suppressed) {
+    if (suppressed) *suppressed = 0;
+    if (!site) return 0;
+    pthread_once(&g_settings_once, settings_init);
+    if (!atomic_load_explicit(&site->registered, memory_order_relaxed)) {
+        site_register(site);
+    }
+
+    int level = (int)site->level;
+    if (level < 0 || level >= LOG_LEVEL_COUNT) level = LOG_LEVEL_DEBUG;
+    if (level > atomic_load_explicit(&g_level, memory_order_relaxed)) {
+        return 0;
+    }
+
+    int every = atomic_load_explicit(&g_sample_every[level], memory_order_relaxed);
+    if (every > 1) {
+        uint64_t seen = atomic_fetch_add_explicit(&site->seen, 1U, memory_order_relaxed);
+        if (seen % (uint64_t)every != 0U) {
+            return site_suppress(site, LOG_THROTTLE_SAMPLED);
+        }
+    }
+
+    int rate = atomic_load_explicit(&g_rate, memory_order_relaxed);
+    if (rate > 0) {
+        uint64_t interval = (uint64_t)(1000000 / rate);
+        int burst = atomic_load_explicit(&g_burst, memory_order_relaxed);
+        uint64_t tolerance = interval * (uint64_t)(burst > 1 ? burst - 1 : 0);
+        uint64_t tat = atomic_load_explicit(&site->tat_us, memory_order_relaxed);
+        for (;;) {
+            if (tat > now_us + tolerance) {
+                return site_suppress(site, LOG_THROTTLE_RATE_LIMITED);
+            }
+            uint64_t next = (tat > now_us ? tat : now_us) + interval;
+            if (atomic_compare_exchange_weak_explicit(&site->tat_us, &tat, next,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        }
+    }
+
+    uint64_t missed = atomic_exchange_explicit(&site->pending, 0U, memory_order_relaxed);
+    atomic_fetch_add_explicit(&site->emitted, 1U, memory_order_relaxed);
+    if (suppressed) *suppressed = missed;
+    return 1;
+}
+
+int log_throttle_allow(log_callsite_t *site, uint64_t *suppressed) {
+    return log_throttle_allow_at(site, monotonic_us(), suppressed);
+}
+
+size_t log_throttle_get_stats(log_callsite_stats_t *stats, size_t max) {
+    size_t n = 0;
+    for (log_callsite_t *site = atomic_load_explicit(&g_sites, memory_order_acquire);
+         site != NULL; site = site->next) {
+        if (stats && n < max) {
+            stats[n].name = site->name;
+            stats[n].level = site->level;
+            stats[n].emitted = atomic_load_explicit(&site->emitted, memory_order_relaxed);
+            stats[n].suppressed = atomic_load_explicit(&site->suppressed, memory_order_relaxed);
+        }
+        n++;
+    }
+    return n;
+}
+
+const char *log_level_name(log_level_t level) {
+    if (level < LOG_LEVEL_ERROR || level >= LOG_LEVEL_COUNT) return "unknown";
+    return LEVEL_NAMES[level];
+}
+
+int log_level_parse(const char *name, log_level_t *level) {
+    if (!name || !level) return -1;
+    for (int i = 0; i < LOG_LEVEL_COUNT; i++) {
+        if (strcasecmp(name, LEVEL_NAMES[i]) == 0) {
+            *level = (log_level_t)i;
+            return 0;
+        }
+    }
+    if (strcasecmp(name, "warning") == 0) {
+        *level = LOG_LEVEL_WARN;
+        return 0;
+    }
+    return -1;
+}
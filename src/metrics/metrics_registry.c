@@ -2,6 +2,7 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <stdatomic.h>
 
 // Global metric pointers
 prometheus_counter_t *metric_http_requests_total = NULL;
@@ -14,11 +15,35 @@ prometheus_counter_t *metric_rate_limit_allowed_total = NULL;
 prometheus_counter_t *metric_idempotency_hits_total = NULL;
 prometheus_counter_t *metric_idempotency_misses_total = NULL;
 
+prometheus_counter_t *metric_decision_cache_hits_total = NULL;
+prometheus_counter_t *metric_decision_cache_misses_total = NULL;
+prometheus_counter_t *metric_decision_cache_coalesced_total = NULL;
+
 prometheus_counter_t *metric_nats_messages_sent_total = NULL;
 prometheus_counter_t *metric_nats_messages_received_total = NULL;
 prometheus_counter_t *metric_nats_publish_failures_total = NULL;
 prometheus_gauge_t *metric_nats_connection_status = NULL;
 
+prometheus_gauge_t *metric_nats_pool_connections = NULL;
+prometheus_gauge_t *metric_nats_pool_healthy_connections = NULL;
+prometheus_gauge_t *metric_nats_pool_bound_threads = NULL;
+prometheus_counter_t *metric_nats_pool_connections_created_total = NULL;
+prometheus_counter_t *metric_nats_pool_connections_destroyed_total = NULL;
+prometheus_counter_t *metric_nats_pool_health_check_failures_total = NULL;
+prometheus_counter_t *metric_nats_pool_rebinds_total = NULL;
+prometheus_counter_t *metric_nats_pool_acquire_timeouts_total = NULL;
+
+prometheus_counter_t *metric_ingest_accepted_total = NULL;
+prometheus_counter_t *metric_ingest_refused_total = NULL;
+prometheus_counter_t *metric_ingest_batches_total = NULL;
+prometheus_counter_t *metric_ingest_acked_total = NULL;
+prometheus_counter_t *metric_ingest_failed_total = NULL;
+prometheus_gauge_t *metric_ingest_pending_bytes = NULL;
+prometheus_gauge_t *metric_ingest_in_flight_batches = NULL;
+prometheus_counter_t *metric_router_hedges_sent_total = NULL;
+prometheus_counter_t *metric_router_hedges_won_total = NULL;
+prometheus_counter_t *metric_router_hedge_budget_exhausted_total = NULL;
+
 prometheus_counter_t *metric_json_parse_success_total = NULL;
 prometheus_counter_t *metric_json_parse_failure_total = NULL;
 prometheus_histogram_t *metric_json_parse_duration_seconds = NULL;
@@ -31,6 +56,16 @@ prometheus_counter_t *metric_abuse_heavy_payload_total = NULL;
 prometheus_counter_t *metric_abuse_multi_tenant_flood_total = NULL;
 prometheus_gauge_t *metric_abuse_blocked_tenants = NULL;
 
+// Worker Pool Metrics
+prometheus_gauge_t *metric_worker_queue_depth = NULL;
+prometheus_histogram_t *metric_worker_queue_sojourn_seconds = NULL;
+prometheus_counter_t *metric_worker_shed_queue_full_total = NULL;
+prometheus_counter_t *metric_worker_shed_deadline_total = NULL;
+
+// Log Throttle Metrics
+prometheus_counter_t *metric_log_rate_limited_total = NULL;
+prometheus_counter_t *metric_log_sampled_total = NULL;
+
 int metrics_registry_init(void) {
     // Initialize Prometheus subsystem
     if (prometheus_init() != 0) {
@@ -82,6 +117,25 @@ int metrics_registry_init(void) {
     );
     if (!metric_idempotency_misses_total) return -1;
     
+    // Decision cache metrics
+    metric_decision_cache_hits_total = prometheus_counter_create(
+        "gateway_decision_cache_hits_total",
+        "Total number of decision lookups answered from the cache"
+    );
+    if (!metric_decision_cache_hits_total) return -1;
+    
+    metric_decision_cache_misses_total = prometheus_counter_create(
+        "gateway_decision_cache_misses_total",
+        "Total number of decision lookups sent to the Router"
+    );
+    if (!metric_decision_cache_misses_total) return -1;
+    
+    metric_decision_cache_coalesced_total = prometheus_counter_create(
+        "gateway_decision_cache_coalesced_total",
+        "Total number of decision lookups coalesced with one in flight"
+    );
+    if (!metric_decision_cache_coalesced_total) return -1;
+    
     // NATS metrics
     metric_nats_messages_sent_total = prometheus_counter_create(
         "gateway_nats_messages_sent_total",
@@ -170,6 +224,154 @@ int metrics_registry_init(void) {
     );
     if (!metric_abuse_blocked_tenants) return -1;
     
+    // Worker Pool Metrics
+    metric_worker_queue_depth = prometheus_gauge_create(
+        "gateway_worker_queue_depth",
+        "Requests waiting in the worker queue"
+    );
+    if (!metric_worker_queue_depth) return -1;
+    
+    metric_worker_queue_sojourn_seconds = prometheus_histogram_create(
+        "gateway_worker_queue_sojourn_seconds",
+        "Time requests spent queued before a worker picked them up"
+    );
+    if (!metric_worker_queue_sojourn_seconds) return -1;
+    
+    metric_worker_shed_queue_full_total = prometheus_counter_create(
+        "gateway_worker_shed_queue_full_total",
+        "Requests refused with 503 because the worker queue was full"
+    );
+    if (!metric_worker_shed_queue_full_total) return -1;
+    
+    metric_worker_shed_deadline_total = prometheus_counter_create(
+        "gateway_worker_shed_deadline_total",
+        "Requests refused with 503 because their admission deadline passed"
+    );
+    if (!metric_worker_shed_deadline_total) return -1;
+    
+    // Log Throttle Metrics
+    metric_log_rate_limited_total = prometheus_counter_create(
+        "gateway_log_rate_limited_total",
+        "Log messages suppressed by their callsite's rate limit"
+    );
+    if (!metric_log_rate_limited_total) return -1;
+    
+    metric_log_sampled_total = prometheus_counter_create(
+        "gateway_log_sampled_total",
+        "Log messages dropped by level sampling"
+    );
+    if (!metric_log_sampled_total) return -1;
+    
+    // NATS Pool Metrics
+    metric_nats_pool_connections = prometheus_gauge_create(
+        "gateway_nats_pool_connections",
+        "Pooled NATS connections currently open"
+    );
+    if (!metric_nats_pool_connections) return -1;
+    
+    metric_nats_pool_healthy_connections = prometheus_gauge_create(
+        "gateway_nats_pool_healthy_connections",
+        "Pooled NATS connections currently connected"
+    );
+    if (!metric_nats_pool_healthy_connections) return -1;
+    
+    metric_nats_pool_bound_threads = prometheus_gauge_create(
+        "gateway_nats_pool_bound_threads",
+        "Threads bound to a pooled NATS connection"
+    );
+    if (!metric_nats_pool_bound_threads) return -1;
+    
+    metric_nats_pool_connections_created_total = prometheus_counter_create(
+        "gateway_nats_pool_connections_created_total",
+        "Pooled NATS connections opened"
+    );
+    if (!metric_nats_pool_connections_created_total) return -1;
+    
+    metric_nats_pool_connections_destroyed_total = prometheus_counter_create(
+        "gateway_nats_pool_connections_destroyed_total",
+        "Pooled NATS connections closed"
+    );
+    if (!metric_nats_pool_connections_destroyed_total) return -1;
+    
+    metric_nats_pool_health_check_failures_total = prometheus_counter_create(
+        "gateway_nats_pool_health_check_failures_total",
+        "Pooled NATS connections that failed a health check"
+    );
+    if (!metric_nats_pool_health_check_failures_total) return -1;
+    
+    metric_nats_pool_rebinds_total = prometheus_counter_create(
+        "gateway_nats_pool_rebinds_total",
+        "Thread bindings moved off a NATS connection that went down"
+    );
+    if (!metric_nats_pool_rebinds_total) return -1;
+    
+    metric_nats_pool_acquire_timeouts_total = prometheus_counter_create(
+        "gateway_nats_pool_acquire_timeouts_total",
+        "NATS pool acquisitions that timed out"
+    );
+    if (!metric_nats_pool_acquire_timeouts_total) return -1;
+    
+    // Async Ingest Metrics
+    metric_ingest_accepted_total = prometheus_counter_create(
+        "gateway_ingest_accepted_total",
+        "Messages accepted for asynchronous ingest"
+    );
+    if (!metric_ingest_accepted_total) return -1;
+    
+    metric_ingest_refused_total = prometheus_counter_create(
+        "gateway_ingest_refused_total",
+        "Messages refused because the ingest queue was full"
+    );
+    if (!metric_ingest_refused_total) return -1;
+    
+    metric_ingest_batches_total = prometheus_counter_create(
+        "gateway_ingest_batches_total",
+        "Ingest batches published"
+    );
+    if (!metric_ingest_batches_total) return -1;
+    
+    metric_ingest_acked_total = prometheus_counter_create(
+        "gateway_ingest_acked_total",
+        "Ingest messages acknowledged by the consumer"
+    );
+    if (!metric_ingest_acked_total) return -1;
+    
+    metric_ingest_failed_total = prometheus_counter_create(
+        "gateway_ingest_failed_total",
+        "Ingest messages whose publish or acknowledgement failed"
+    );
+    if (!metric_ingest_failed_total) return -1;
+    
+    metric_ingest_pending_bytes = prometheus_gauge_create(
+        "gateway_ingest_pending_bytes",
+        "Ingest bytes queued or waiting for an acknowledgement"
+    );
+    if (!metric_ingest_pending_bytes) return -1;
+    
+    metric_ingest_in_flight_batches = prometheus_gauge_create(
+        "gateway_ingest_in_flight_batches",
+        "Ingest batches waiting for an acknowledgement"
+    );
+    if (!metric_ingest_in_flight_batches) return -1;
+    
+    metric_router_hedges_sent_total = prometheus_counter_create(
+        "gateway_router_hedges_sent_total",
+        "Second attempts sent for late idempotent Router requests"
+    );
+    if (!metric_router_hedges_sent_total) return -1;
+    
+    metric_router_hedges_won_total = prometheus_counter_create(
+        "gateway_router_hedges_won_total",
+        "Hedged Router requests answered by the second attempt"
+    );
+    if (!metric_router_hedges_won_total) return -1;
+    
+    metric_router_hedge_budget_exhausted_total = prometheus_counter_create(
+        "gateway_router_hedge_budget_exhausted_total",
+        "Router requests due a hedge when the hedge budget was spent"
+    );
+    if (!metric_router_hedge_budget_exhausted_total) return -1;
+    
     return 0;
 }
 
@@ -213,6 +415,18 @@ void metrics_record_idempotency_miss(void) {
     prometheus_counter_inc(metric_idempotency_misses_total);
 }
 
+void metrics_record_decision_cache_hit(void) {
+    prometheus_counter_inc(metric_decision_cache_hits_total);
+}
+
+void metrics_record_decision_cache_miss(void) {
+    prometheus_counter_inc(metric_decision_cache_misses_total);
+}
+
+void metrics_record_decision_cache_coalesced(void) {
+    prometheus_counter_inc(metric_decision_cache_coalesced_total);
+}
+
 void metrics_record_nats_sent(const char *subject) {
     // Note: subject parameter reserved for CP2 label support enhancement
     // See apps/c-gateway/TODO.md GATEWAY-CP2-3 for implementation plan
@@ -305,3 +519,95 @@ void metrics_update_abuse_blocked_tenants(int count) {
     }
 }
 
+void metrics_update_worker_queue_depth(uint64_t depth) {
+    if (metric_worker_queue_depth) {
+        prometheus_gauge_set(metric_worker_queue_depth, (int64_t)depth);
+    }
+}
+
+void metrics_record_worker_dequeue(uint64_t sojourn_us, uint64_t depth) {
+    if (metric_worker_queue_sojourn_seconds) {
+        prometheus_histogram_observe(metric_worker_queue_sojourn_seconds, sojourn_us);
+    }
+    metrics_update_worker_queue_depth(depth);
+}
+
+void metrics_record_worker_shed_queue_full(void) {
+    if (metric_worker_shed_queue_full_total) {
+        prometheus_counter_inc(metric_worker_shed_queue_full_total);
+    }
+}
+
+void metrics_record_worker_shed_deadline(uint64_t sojourn_us, uint64_t depth) {
+    if (metric_worker_shed_deadline_total) {
+        prometheus_counter_inc(metric_worker_shed_deadline_total);
+    }
+    metrics_record_worker_dequeue(sojourn_us, depth);
+}
+
+void metrics_record_log_rate_limited(void) {
+    if (metric_log_rate_limited_total) {
+        prometheus_counter_inc(metric_log_rate_limited_total);
+    }
+}
+
+void metrics_record_log_sampled(void) {
+    if (metric_log_sampled_total) {
+        prometheus_counter_inc(metric_log_sampled_total);
+    }
+}
+
+/* Last exported pool totals, which counters only move forward from */
+static atomic_uint_fast64_t nats_pool_exported[5];
+
+static void counter_advance(prometheus_counter_t *counter, atomic_uint_fast64_t *exported,
+                            uint64_t total) {
+    uint64_t prev = atomic_load(exported);
+    while (total > prev) {
+        if (atomic_compare_exchange_weak(exported, &prev, total)) {
+            prometheus_counter_add(counter, total - prev);
+            return;
+        }
+    }
+}
+
+void metrics_update_nats_pool(const nats_pool_stats_t *stats) {
+    if (!stats || !metric_nats_pool_connections) return;
+    prometheus_gauge_set(metric_nats_pool_connections, (int64_t)stats->open_connections);
+    prometheus_gauge_set(metric_nats_pool_healthy_connections, (int64_t)stats->healthy_connections);
+    prometheus_gauge_set(metric_nats_pool_bound_threads, (int64_t)stats->bound_threads);
+    metrics_update_nats_connection_status(stats->open_connections > 0 &&
+                                          stats->healthy_connections == stats->open_connections);
+    counter_advance(metric_nats_pool_connections_created_total, &nats_pool_exported[0],
+                    stats->total_created);
+    counter_advance(metric_nats_pool_connections_destroyed_total, &nats_pool_exported[1],
+                    stats->total_destroyed);
+    counter_advance(metric_nats_pool_health_check_failures_total, &nats_pool_exported[2],
+                    stats->health_check_failures);
+    counter_advance(metric_nats_pool_rebinds_total, &nats_pool_exported[3], stats->rebinds);
+    counter_advance(metric_nats_pool_acquire_timeouts_total, &nats_pool_exported[4],
+                    stats->acquire_timeouts);
+}
+
+static atomic_uint_fast64_t ingest_exported[5];
+
+void metrics_update_ingest(const ingest_batcher_stats_t *stats) {
+    if (!stats || !metric_ingest_pending_bytes) return;
+    prometheus_gauge_set(metric_ingest_pending_bytes, (int64_t)stats->pending_bytes);
+    prometheus_gauge_set(metric_ingest_in_flight_batches, (int64_t)stats->in_flight);
+    counter_advance(metric_ingest_accepted_total, &ingest_exported[0], stats->accepted);
+    counter_advance(metric_ingest_refused_total, &ingest_exported[1], stats->refused);
+    counter_advance(metric_ingest_batches_total, &ingest_exported[2], stats->batches);
+    counter_advance(metric_ingest_acked_total, &ingest_exported[3], stats->acked);
+    counter_advance(metric_ingest_failed_total, &ingest_exported[4], stats->failed);
+}
+
+static atomic_uint_fast64_t hedger_exported[3];
+
+void metrics_update_hedger(const request_hedger_stats_t *stats) {
+    if (!stats || !metric_router_hedges_sent_total) return;
+    counter_advance(metric_router_hedges_sent_total, &hedger_exported[0], stats->hedges_sent);
+    counter_advance(metric_router_hedges_won_total, &hedger_exported[1], stats->hedges_won);
+    counter_advance(metric_router_hedge_budget_exhausted_total, &hedger_exported[2],
+                    stats->budget_exhausted);
+}
@@ -2,6 +2,9 @@
 #define METRICS_REGISTRY_H
 
 #include "prometheus.h"
+#include "nats_pool.h"
+#include "ingest_batcher.h"
+#include "request_hedger.h"
 
 /**
  * Global metrics registry for C-Gateway
@@ -35,6 +38,17 @@ extern prometheus_counter_t *metric_idempotency_hits_total;
 // Counter: Idempotency cache misses
 extern prometheus_counter_t *metric_idempotency_misses_total;
 
+// === Decision Cache Metrics ===
+
+// Counter: Decision lookups answered from the cache
+extern prometheus_counter_t *metric_decision_cache_hits_total;
+
+// Counter: Decision lookups sent to the Router
+extern prometheus_counter_t *metric_decision_cache_misses_total;
+
+// Counter: Decision lookups parked behind one already in flight
+extern prometheus_counter_t *metric_decision_cache_coalesced_total;
+
 // === NATS Metrics ===
 
 // Counter: NATS messages sent by subject
@@ -103,6 +117,21 @@ void metrics_record_idempotency_hit(void);
  */
 void metrics_record_idempotency_miss(void);
 
+/**
+ * Helper: Record decision cache hit
+ */
+void metrics_record_decision_cache_hit(void);
+
+/**
+ * Helper: Record decision cache miss
+ */
+void metrics_record_decision_cache_miss(void);
+
+/**
+ * Helper: Record decision lookup coalesced with one in flight
+ */
+void metrics_record_decision_cache_coalesced(void);
+
 /**
  * Helper: Record NATS message sent
  * @param subject NATS subject
@@ -198,5 +227,143 @@ void metrics_record_abuse_multi_tenant_flood(void);
  */
 void metrics_update_abuse_blocked_tenants(int count);
 
+// === Worker Pool Metrics ===
+
+// Gauge: Requests waiting in the worker queue
+extern prometheus_gauge_t *metric_worker_queue_depth;
+
+// Histogram: Time requests spent queued before a worker picked them up
+extern prometheus_histogram_t *metric_worker_queue_sojourn_seconds;
+
+// Counter: Requests refused with 503 because the worker queue was full
+extern prometheus_counter_t *metric_worker_shed_queue_full_total;
+
+// Counter: Requests refused with 503 because their admission deadline passed
+extern prometheus_counter_t *metric_worker_shed_deadline_total;
+
+/**
+ * Helper: Update worker queue depth
+ * @param depth Requests currently queued
+ */
+void metrics_update_worker_queue_depth(uint64_t depth);
+
+/**
+ * Helper: Record a request picked up from the worker queue
+ * @param sojourn_us Time spent queued in microseconds
+ * @param depth Requests still queued
+ */
+void metrics_record_worker_dequeue(uint64_t sojourn_us, uint64_t depth);
+
+/**
+ * Helper: Record a request shed because the worker queue was full
+ */
+void metrics_record_worker_shed_queue_full(void);
+
+/**
+ * Helper: Record a request shed at its admission deadline
+ * @param sojourn_us Time spent queued in microseconds
+ * @param depth Requests still queued
+ */
+void metrics_record_worker_shed_deadline(uint64_t sojourn_us, uint64_t depth);
+
+// === Log Throttle Metrics ===
+
+// Counter: Log messages suppressed by their callsite's rate limit
+extern prometheus_counter_t *metric_log_rate_limited_total;
+
+// Counter: Log messages dropped by level sampling
+extern prometheus_counter_t *metric_log_sampled_total;
+
+/**
+ * Helper: Record a log message held back by its callsite's rate limit
+ */
+void metrics_record_log_rate_limited(void);
+
+/**
+ * Helper: Record a log message dropped by sampling
+ */
+void metrics_record_log_sampled(void);
+
+// === NATS Pool Metrics ===
+
+// Gauge: Pooled NATS connections currently open
+extern prometheus_gauge_t *metric_nats_pool_connections;
+
+// Gauge: Pooled NATS connections currently connected
+extern prometheus_gauge_t *metric_nats_pool_healthy_connections;
+
+// Gauge: Threads bound to a pooled connection
+extern prometheus_gauge_t *metric_nats_pool_bound_threads;
+
+// Counter: Pooled NATS connections opened
+extern prometheus_counter_t *metric_nats_pool_connections_created_total;
+
+// Counter: Pooled NATS connections closed
+extern prometheus_counter_t *metric_nats_pool_connections_destroyed_total;
+
+// Counter: Pooled NATS connections that failed a health check
+extern prometheus_counter_t *metric_nats_pool_health_check_failures_total;
+
+// Counter: Thread bindings moved off a connection that went down
+extern prometheus_counter_t *metric_nats_pool_rebinds_total;
+
+// Counter: Pool acquisitions that timed out
+extern prometheus_counter_t *metric_nats_pool_acquire_timeouts_total;
+
+/**
+ * Helper: Export a NATS pool statistics snapshot
+ *
+ * Gauges take the snapshot's values; counters advance to its totals, so
+ * snapshots may be exported from several threads in any order.
+ * @param stats Pool statistics (nats_pool_get_stats)
+ */
+void metrics_update_nats_pool(const nats_pool_stats_t *stats);
+
+// === Async Ingest Metrics ===
+
+// Counter: Messages accepted for asynchronous ingest
+extern prometheus_counter_t *metric_ingest_accepted_total;
+
+// Counter: Messages refused because the ingest queue was full
+extern prometheus_counter_t *metric_ingest_refused_total;
+
+// Counter: Ingest batches published
+extern prometheus_counter_t *metric_ingest_batches_total;
+
+// Counter: Ingest messages acknowledged by the consumer
+extern prometheus_counter_t *metric_ingest_acked_total;
+
+// Counter: Ingest messages whose publish or ack failed
+extern prometheus_counter_t *metric_ingest_failed_total;
+
+// Gauge: Ingest bytes queued or waiting for an ack
+extern prometheus_gauge_t *metric_ingest_pending_bytes;
+
+// Gauge: Ingest batches waiting for an ack
+extern prometheus_gauge_t *metric_ingest_in_flight_batches;
+
+/**
+ * Helper: Export an ingest batcher statistics snapshot
+ * @param stats Batcher statistics (ingest_batcher_get_stats)
+ */
+void metrics_update_ingest(const ingest_batcher_stats_t *stats);
+
+// === Router Hedging Metrics ===
+
+// Counter: Second attempts sent for late idempotent Router requests
+extern prometheus_counter_t *metric_router_hedges_sent_total;
+
+// Counter: Hedged requests answered by the second attempt
+extern prometheus_counter_t *metric_router_hedges_won_total;
+
+// Counter: Requests due a hedge when the hedge budget was spent
+extern prometheus_counter_t *metric_router_hedge_budget_exhausted_total;
+
+/**
+ * Helper: Export a request hedger statistics snapshot
+ * @param stats Hedger statistics (request_hedger_get_stats)
+ */
+void metrics_update_hedger(const request_hedger_stats_t *stats);
+
 #endif // METRICS_REGISTRY_H
 
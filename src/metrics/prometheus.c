@@ -93,6 +93,12 @@ void prometheus_counter_inc(prometheus_counter_t *counter) {
     }
 }
 
+void prometheus_counter_add(prometheus_counter_t *counter, uint64_t delta) {
+    if (counter) {
+        atomic_counter_add(&counter->value, delta);
+    }
+}
+
 void prometheus_counter_add_label(prometheus_counter_t *counter, const char *key, const char *value) {
     if (!counter || counter->num_labels >= MAX_LABELS) return;
     
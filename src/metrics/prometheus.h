@@ -1,6 +1,7 @@
 #ifndef PROMETHEUS_H
 #define PROMETHEUS_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include "../utils/atomic_counter.h"
@@ -98,6 +99,11 @@ prometheus_counter_t* prometheus_counter_create(const char *name, const char *he
  */
 void prometheus_counter_inc(prometheus_counter_t *counter);
 
+/**
+ * Increment counter by delta
+ */
+void prometheus_counter_add(prometheus_counter_t *counter, uint64_t delta);
+
 /**
  * Add labels to counter (before first use)
  */
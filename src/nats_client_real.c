@@ -7,186 +7,737 @@
 
 #include <nats/nats.h>
 
+#include "nats_client_stub.h"
+#include "nats_pool.h"
+#include "request_hedger.h"
+#include "metrics/metrics_registry.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 static const char *DEFAULT_DECIDE_SUBJECT      = "beamline.router.v1.decide";
 static const char *DEFAULT_GET_DECISION_SUBJECT = "beamline.router.v1.get_decision";
 
-static const char *g_last_nats_status = "unknown"; /* connected|disconnected|unknown */
+#define MAX_CONNECTIONS     16
+#define PENDING_BUCKETS     4096      /* Power of two */
+#define INBOX_PREFIX_MAX    96
+
+/* connected|disconnected|unknown, driven by connection events */
+static _Atomic(const char *) g_last_nats_status = "unknown";
 
 const char *nats_get_status_string(void)
 {
-    return g_last_nats_status;
+    return atomic_load(&g_last_nats_status);
 }
 
-static int nats_request_common(const char *subject,
-                               const char *req_json,
-                               char *resp_buf,
-                               size_t resp_size)
+static const char *nats_url(void)
 {
-    if (subject == NULL || subject[0] == '\0' ||
-        req_json == NULL || resp_buf == NULL || resp_size == 0U)
+    const char *url = getenv("NATS_URL");
+    if (url == NULL || url[0] == '\0')
     {
-        return -1;
+        url = "nats://nats:4222";
+    }
+    return url;
+}
+
+static int env_positive_int(const char *name, int def_val)
+{
+    const char *val = getenv(name);
+    if (val == NULL || val[0] == '\0')
+    {
+        return def_val;
     }
+    int parsed = atoi(val);
+    return parsed > 0 ? parsed : def_val;
+}
 
-    natsStatus      s       = NATS_OK;
-    natsConnection *conn    = NULL;
-    natsMsg        *reply   = NULL;
-    natsOptions    *opts    = NULL;
+static int router_timeout_ms(void)
+{
+    return env_positive_int("ROUTER_REQUEST_TIMEOUT_MS", 5000);
+}
 
-    const char *url = getenv("NATS_URL");
-    if (url == NULL || url[0] == '\0')
+static uint64_t monotonic_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000ULL;
+}
+
+/* ---------------- Multiplexed requests ----------------
+ *
+ * The process keeps a few long-lived connections (NATS_CONNECTIONS,
+ * default 1) in a nats_pool, opened by nats_client_init(). Each one
+ * subscribes once to a wildcard inbox "_INBOX.<nuid>.*"; a request
+ * publishes on the calling thread's pooled connection with reply subject
+ * "<inbox>.<token>" and parks a pending entry under that token, and the
+ * connection's delivery thread hands the reply to whichever entry the
+ * token names. Entries are also kept in deadline order, so a single
+ * timer thread fails the ones the Router never answers.
+ *
+ * Worker threads are spread over the connections by the pool's thread
+ * affinity, so they neither share one socket nor take a lock to find
+ * theirs. The library reconnects on its own. While it does, and while
+ * the first connect is still being retried, publishes go to its
+ * reconnect buffer and the wildcard subscription is replayed on connect,
+ * so requests made during a blip are answered once the link is back, or
+ * time out. The connection events, not request outcomes, set the status
+ * string.
+ *
+ * Idempotent reads go through a request_hedger on top: a read still
+ * unanswered past its subject's p95 is published a second time, which
+ * the Router's queue group most likely hands to another replica, and
+ * the pending entry of whichever attempt loses is dropped so its reply
+ * is ignored like a late one.
+ */
+
+typedef struct nats_pending {
+    uint64_t token;
+    uint64_t deadline_ms;
+    nats_reply_cb_t cb;
+    void *closure;
+    struct nats_pending *hnext;          /* Bucket chain */
+    struct nats_pending *prev;           /* Deadline order */
+    struct nats_pending *next;
+} nats_pending_t;
+
+/* Per-connection state, attached to the pooled connection */
+typedef struct {
+    natsSubscription *sub;
+    char inbox[INBOX_PREFIX_MAX];        /* "_INBOX.<nuid>." */
+    size_t inbox_len;
+} nats_link_t;
+
+static nats_pool_t *g_pool = NULL;
+static size_t g_num_links = 0;
+static int g_init_rc = -1;
+static pthread_once_t g_init_once = PTHREAD_ONCE_INIT;
+
+/* Pending table and timer, under g_pending_lock */
+static pthread_mutex_t g_pending_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_timer_cond;
+static nats_pending_t *g_buckets[PENDING_BUCKETS];
+static nats_pending_t *g_oldest = NULL;
+static nats_pending_t *g_newest = NULL;
+static uint64_t g_next_token = 1;
+static int g_stopping = 0;
+static pthread_t g_timer_thread;
+static int g_timer_running = 0;
+static request_hedger_t *g_hedger = NULL;
+
+static void on_link_state(nats_connection_t *conn, int connected, size_t healthy, void *arg)
+{
+    (void)conn;
+    (void)arg;
+    if (!connected)
     {
-        url = "nats://nats:4222";
+        fprintf(stderr, "[c-gateway] nats connection down (%zu of %zu up)\n", healthy, g_num_links);
+    }
+    atomic_store(&g_last_nats_status, healthy >= g_num_links ? "connected" : "disconnected");
+}
+
+/* Caller holds g_pending_lock */
+static void pending_insert_locked(nats_pending_t *p)
+{
+    nats_pending_t **bucket = &g_buckets[p->token & (PENDING_BUCKETS - 1U)];
+    p->hnext = *bucket;
+    *bucket = p;
+
+    /* Deadlines only go backwards if the timeout setting shrank */
+    nats_pending_t *after = g_newest;
+    while (after != NULL && after->deadline_ms > p->deadline_ms)
+    {
+        after = after->prev;
+    }
+    p->prev = after;
+    p->next = after != NULL ? after->next : g_oldest;
+    if (p->next != NULL) p->next->prev = p; else g_newest = p;
+    if (after != NULL) after->next = p; else g_oldest = p;
+}
+
+/* Caller holds g_pending_lock; returns the entry, now owned by the caller */
+static nats_pending_t *pending_take_locked(uint64_t token)
+{
+    nats_pending_t **slot = &g_buckets[token & (PENDING_BUCKETS - 1U)];
+    while (*slot != NULL && (*slot)->token != token)
+    {
+        slot = &(*slot)->hnext;
+    }
+    nats_pending_t *p = *slot;
+    if (p == NULL)
+    {
+        return NULL;
+    }
+    *slot = p->hnext;
+    if (p->prev != NULL) p->prev->next = p->next; else g_oldest = p->next;
+    if (p->next != NULL) p->next->prev = p->prev; else g_newest = p->prev;
+    return p;
+}
+
+static nats_pending_t *pending_take(uint64_t token)
+{
+    pthread_mutex_lock(&g_pending_lock);
+    nats_pending_t *p = pending_take_locked(token);
+    pthread_mutex_unlock(&g_pending_lock);
+    return p;
+}
+
+/* Wildcard inbox handler: one per link, on the library's delivery thread */
+static void on_inbox_reply(natsConnection *nc, natsSubscription *sub, natsMsg *msg, void *closure)
+{
+    (void)nc;
+    (void)sub;
+    const nats_link_t *link = (const nats_link_t *)closure;
+    const char *subject = natsMsg_GetSubject(msg);
+    if (subject == NULL || strncmp(subject, link->inbox, link->inbox_len) != 0)
+    {
+        natsMsg_Destroy(msg);
+        return;
+    }
+    char *end = NULL;
+    uint64_t token = strtoull(subject + link->inbox_len, &end, 16);
+    nats_pending_t *p = (end != NULL && *end == '\0') ? pending_take(token) : NULL;
+    if (p == NULL)
+    {
+        /* Already timed out, or a duplicate reply */
+        natsMsg_Destroy(msg);
+        return;
     }
 
-    int timeout_ms = 5000;
-    const char *timeout_env = getenv("ROUTER_REQUEST_TIMEOUT_MS");
-    if (timeout_env != NULL && timeout_env[0] != '\0')
+    const char *data = natsMsg_GetData(msg);
+    if (data == NULL || natsMsg_GetDataLength(msg) <= 0)
+    {
+        p->cb(-1, NULL, p->closure);
+    }
+    else
     {
-        int val = atoi(timeout_env);
-        if (val > 0)
+        /* natsMsg data is NUL-terminated by the library */
+        p->cb(0, data, p->closure);
+    }
+    natsMsg_Destroy(msg);
+    free(p);
+}
+
+/* Fails entries past their deadline; sleeps until the oldest one's */
+static void *timer_main(void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&g_pending_lock);
+    while (!g_stopping)
+    {
+        uint64_t now = monotonic_ms();
+        nats_pending_t *expired = NULL;
+        while (g_oldest != NULL && g_oldest->deadline_ms <= now)
         {
-            timeout_ms = val;
+            nats_pending_t *p = pending_take_locked(g_oldest->token);
+            p->next = expired;
+            expired = p;
+        }
+        if (expired != NULL)
+        {
+            pthread_mutex_unlock(&g_pending_lock);
+            while (expired != NULL)
+            {
+                nats_pending_t *p = expired;
+                expired = p->next;
+                p->cb(-1, NULL, p->closure);
+                free(p);
+            }
+            pthread_mutex_lock(&g_pending_lock);
+            continue;
+        }
+        if (g_oldest == NULL)
+        {
+            pthread_cond_wait(&g_timer_cond, &g_pending_lock);
+        }
+        else
+        {
+            uint64_t wake_ms = g_oldest->deadline_ms;
+            struct timespec ts;
+            ts.tv_sec = (time_t)(wake_ms / 1000U);
+            ts.tv_nsec = (long)(wake_ms % 1000U) * 1000000L;
+            (void)pthread_cond_timedwait(&g_timer_cond, &g_pending_lock, &ts);
         }
     }
+    pthread_mutex_unlock(&g_pending_lock);
+    return NULL;
+}
 
-    s = natsOptions_Create(&opts);
+/* Pool hook: subscribe a new connection to its wildcard inbox */
+static int link_open(nats_connection_t *conn, void *arg)
+{
+    (void)arg;
+    nats_link_t *link = calloc(1, sizeof(*link));
+    if (link == NULL)
+    {
+        return -1;
+    }
+    natsInbox *inbox = NULL;
+    natsStatus s = natsInbox_Create(&inbox);
     if (s == NATS_OK)
     {
-        s = natsOptions_SetURL(opts, url);
+        int len = snprintf(link->inbox, sizeof(link->inbox), "%s.", (const char *)inbox);
+        if (len < 0 || (size_t)len + 2U > sizeof(link->inbox))
+        {
+            s = NATS_ERR;
+        }
+        else
+        {
+            char wildcard[INBOX_PREFIX_MAX + 2];
+            link->inbox_len = (size_t)len;
+            (void)snprintf(wildcard, sizeof(wildcard), "%s*", link->inbox);
+            s = natsConnection_Subscribe(&link->sub, (natsConnection *)nats_pool_get_handle(conn),
+                                         wildcard, on_inbox_reply, link);
+        }
     }
+    natsInbox_Destroy(inbox);
+    if (s != NATS_OK)
+    {
+        fprintf(stderr, "[c-gateway] nats subscribe error: %s\n", natsStatus_GetText(s));
+        free(link);
+        return -1;
+    }
+    nats_pool_set_user(conn, link);
+    return 0;
+}
 
-    if (s == NATS_OK)
+/* Pool hook: the connection is closed, so no reply is being delivered */
+static void link_close(nats_connection_t *conn, void *arg)
+{
+    (void)arg;
+    nats_link_t *link = nats_pool_get_user(conn);
+    if (link != NULL)
     {
-        s = natsConnection_Connect(&conn, opts);
+        natsSubscription_Destroy(link->sub);
+        free(link);
     }
+}
 
-    if (s != NATS_OK)
+static int request_send(const char *subject, const char *req_json, nats_reply_cb_t cb,
+                        void *closure, uint64_t *token_out);
+
+/* Hedger hooks: an attempt is a pending entry, cancelled by dropping it */
+static int hedge_send(const char *subject, const char *request, request_hedger_reply_fn reply,
+                      void *closure, uint64_t *handle, void *arg)
+{
+    (void)arg;
+    return request_send(subject, request, reply, closure, handle);
+}
+
+static int hedge_cancel(uint64_t handle, void *arg)
+{
+    (void)arg;
+    nats_pending_t *p = pending_take(handle);
+    if (p == NULL)
+    {
+        return -1;
+    }
+    free(p);
+    return 0;
+}
+
+static void client_init(void)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&g_timer_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    int wanted = env_positive_int("NATS_CONNECTIONS", 1);
+    if (wanted > MAX_CONNECTIONS) wanted = MAX_CONNECTIONS;
+    g_num_links = (size_t)wanted;
+    atomic_store(&g_last_nats_status, "disconnected");
+
+    nats_pool_config_t config = {
+        .min_connections = (size_t)wanted,
+        .max_connections = (size_t)wanted,
+        .connection_timeout_ms = 2000,
+        .idle_timeout_sec = 60,
+        .max_reconnect_attempts = -1,
+        .nats_url = nats_url(),
+        .name = "c-gateway",
+        .reconnect_wait_ms = env_positive_int("NATS_RECONNECT_WAIT_MS", 250),
+        .reconnect_buf_kb = env_positive_int("NATS_RECONNECT_BUF_KB", 8192),
+        /* A server that is down at startup is retried in the background */
+        .retry_connect = 1,
+        .hooks = { link_open, link_close, on_link_state, NULL },
+    };
+    g_pool = nats_pool_init(&config);
+    if (g_pool == NULL)
+    {
+        return;
+    }
+    nats_pool_stats_t stats;
+    if (nats_pool_get_stats(g_pool, &stats) != 0 || stats.open_connections < g_num_links)
+    {
+        fprintf(stderr, "[c-gateway] nats connect error: %zu of %zu connections opened\n",
+                stats.open_connections, g_num_links);
+        return;
+    }
+    if (pthread_create(&g_timer_thread, NULL, timer_main, NULL) != 0)
+    {
+        return;
+    }
+    g_timer_running = 1;
+
+    /* GATEWAY_HEDGE_BUDGET_PERCENT=0 turns hedging off */
+    request_hedger_config_t hedge_config;
+    request_hedger_get_default_config(&hedge_config);
+    request_hedger_parse_config(&hedge_config);
+    if (hedge_config.budget_percent > 0)
+    {
+        g_hedger = request_hedger_create(&hedge_config, hedge_send, hedge_cancel, NULL);
+        if (g_hedger == NULL)
+        {
+            fprintf(stderr, "[c-gateway] request hedging disabled: hedger init failed\n");
+        }
+    }
+    g_init_rc = 0;
+}
+
+int nats_client_init(void)
+{
+    pthread_once(&g_init_once, client_init);
+    return g_init_rc;
+}
+
+void nats_client_shutdown(void)
+{
+    if (g_pool == NULL)
+    {
+        return;                  /* Never started */
+    }
+    /* No hedges from here on; hedged requests finish with the rest */
+    request_hedger_stop(g_hedger);
+    pthread_mutex_lock(&g_pending_lock);
+    g_stopping = 1;
+    pthread_cond_signal(&g_timer_cond);
+    pthread_mutex_unlock(&g_pending_lock);
+    if (g_timer_running)
+    {
+        pthread_join(g_timer_thread, NULL);
+        g_timer_running = 0;
+    }
+
+    /* Closing stops reply delivery, so what is still pending never gets one */
+    nats_pool_destroy(g_pool);
+    g_pool = NULL;
+
+    pthread_mutex_lock(&g_pending_lock);
+    while (g_oldest != NULL)
+    {
+        nats_pending_t *p = pending_take_locked(g_oldest->token);
+        pthread_mutex_unlock(&g_pending_lock);
+        p->cb(-1, NULL, p->closure);
+        free(p);
+        pthread_mutex_lock(&g_pending_lock);
+    }
+    pthread_mutex_unlock(&g_pending_lock);
+    request_hedger_destroy(g_hedger);
+    g_hedger = NULL;
+    g_init_rc = -1;
+}
+
+void nats_client_collect_metrics(void)
+{
+    nats_pool_stats_t stats;
+    if (g_pool != NULL && nats_pool_get_stats(g_pool, &stats) == 0)
+    {
+        metrics_update_nats_pool(&stats);
+    }
+    if (g_hedger != NULL)
+    {
+        request_hedger_stats_t hedge_stats;
+        request_hedger_get_stats(g_hedger, &hedge_stats);
+        metrics_update_hedger(&hedge_stats);
+    }
+}
+
+/* Publish one request; *token (if given) names its pending entry */
+static int request_send(const char *subject, const char *req_json, nats_reply_cb_t cb,
+                        void *closure, uint64_t *token_out)
+{
+    if (subject == NULL || subject[0] == '\0' || req_json == NULL || cb == NULL)
+    {
+        return -1;
+    }
+    if (nats_client_init() != 0)
     {
-        fprintf(stderr, "[c-gateway] nats connect error: %s\n", natsStatus_GetText(s));
-        natsOptions_Destroy(opts);
-        g_last_nats_status = "disconnected";
         return -1;
     }
 
-    s = natsConnection_RequestString(&reply,
-                                     conn,
-                                     subject,
-                                     req_json,
-                                     (int)strlen(req_json),
-                                     timeout_ms);
+    nats_pending_t *p = calloc(1, sizeof(*p));
+    if (p == NULL)
+    {
+        return -1;
+    }
+    p->cb = cb;
+    p->closure = closure;
+    p->deadline_ms = monotonic_ms() + (uint64_t)router_timeout_ms();
+
+    pthread_mutex_lock(&g_pending_lock);
+    if (g_stopping)
+    {
+        pthread_mutex_unlock(&g_pending_lock);
+        free(p);
+        return -1;
+    }
+    p->token = g_next_token++;
+    if (token_out != NULL)
+    {
+        *token_out = p->token;
+    }
+    pending_insert_locked(p);
+    if (g_oldest == p)
+    {
+        pthread_cond_signal(&g_timer_cond);
+    }
+    pthread_mutex_unlock(&g_pending_lock);
+
+    uint64_t token = p->token;
+    nats_connection_t *conn = nats_pool_thread_connection(g_pool);
+    const nats_link_t *link = nats_pool_get_user(conn);
+    natsStatus s = NATS_ERR;
+    if (link != NULL)
+    {
+        char reply[INBOX_PREFIX_MAX + 20];
+        (void)snprintf(reply, sizeof(reply), "%s%llx", link->inbox, (unsigned long long)token);
+        s = natsConnection_PublishRequestString((natsConnection *)nats_pool_get_handle(conn),
+                                                subject, reply, req_json);
+    }
     if (s != NATS_OK)
     {
         fprintf(stderr, "[c-gateway] nats request error: %s\n", natsStatus_GetText(s));
-        natsMsg_Destroy(reply);
-        natsConnection_Destroy(conn);
-        natsOptions_Destroy(opts);
-        g_last_nats_status = "disconnected";
+        /* Not submitted, unless the timer got to it first */
+        nats_pending_t *mine = pending_take(token);
+        if (mine == NULL)
+        {
+            return 0;
+        }
+        free(mine);
         return -1;
     }
+    return 0;
+}
 
-    const char *data = natsMsg_GetData(reply);
-    int         len  = natsMsg_GetDataLength(reply);
+static int nats_request_common_async(const char *subject,
+                                     const char *req_json,
+                                     nats_reply_cb_t cb,
+                                     void *closure)
+{
+    return request_send(subject, req_json, cb, closure, NULL);
+}
 
-    if (data == NULL || len <= 0)
+/* For requests that are safe to repeat: hedged when hedging is on */
+static int nats_request_idempotent_async(const char *subject,
+                                         const char *req_json,
+                                         nats_reply_cb_t cb,
+                                         void *closure)
+{
+    if (nats_client_init() != 0)
     {
-        natsMsg_Destroy(reply);
-        natsConnection_Destroy(conn);
-        natsOptions_Destroy(opts);
         return -1;
     }
-
-    if ((size_t)len + 1U > resp_size)
+    if (g_hedger == NULL)
+    {
+        return nats_request_common_async(subject, req_json, cb, closure);
+    }
+    if (subject == NULL || subject[0] == '\0' || req_json == NULL || cb == NULL)
     {
-        /* Not enough space in buffer */
-        natsMsg_Destroy(reply);
-        natsConnection_Destroy(conn);
-        natsOptions_Destroy(opts);
         return -1;
     }
+    return request_hedger_submit(g_hedger, subject, req_json, cb, closure);
+}
 
-    memcpy(resp_buf, data, (size_t)len);
-    resp_buf[len] = '\0';
+/* Synchronous requests wait on the multiplexed path */
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int done;
+    int status;
+    char *buf;
+    size_t size;
+} nats_waiter_t;
+
+static void on_sync_reply(int status, const char *resp_json, void *closure)
+{
+    nats_waiter_t *w = (nats_waiter_t *)closure;
+    int rc = status;
+    if (rc == 0)
+    {
+        size_t len = strlen(resp_json);
+        if (len + 1U > w->size)
+        {
+            rc = -1;             /* Not enough space in buffer */
+        }
+        else
+        {
+            memcpy(w->buf, resp_json, len + 1U);
+        }
+    }
+    pthread_mutex_lock(&w->lock);
+    w->status = rc;
+    w->done = 1;
+    pthread_cond_signal(&w->cond);
+    pthread_mutex_unlock(&w->lock);
+}
+
+static int nats_request_common(const char *subject,
+                               const char *req_json,
+                               char *resp_buf,
+                               size_t resp_size)
+{
+    if (subject == NULL || subject[0] == '\0' ||
+        req_json == NULL || resp_buf == NULL || resp_size == 0U)
+    {
+        return -1;
+    }
 
-    natsMsg_Destroy(reply);
-    natsConnection_Destroy(conn);
-    natsOptions_Destroy(opts);
+    nats_waiter_t w;
+    memset(&w, 0, sizeof(w));
+    pthread_mutex_init(&w.lock, NULL);
+    pthread_cond_init(&w.cond, NULL);
+    w.buf = resp_buf;
+    w.size = resp_size;
 
-    g_last_nats_status = "connected";
-    return 0;
+    int rc = nats_request_common_async(subject, req_json, on_sync_reply, &w);
+    if (rc == 0)
+    {
+        pthread_mutex_lock(&w.lock);
+        while (!w.done)
+        {
+            pthread_cond_wait(&w.cond, &w.lock);
+        }
+        rc = w.status;
+        pthread_mutex_unlock(&w.lock);
+    }
+    pthread_cond_destroy(&w.cond);
+    pthread_mutex_destroy(&w.lock);
+    return rc;
 }
 
-int nats_request_decide(const char *req_json, char *resp_buf, size_t resp_size)
+static const char *subject_from_env(const char *env_name, const char *fallback)
 {
-    const char *subject = getenv("ROUTER_DECIDE_SUBJECT");
+    const char *subject = getenv(env_name);
     if (subject == NULL || subject[0] == '\0')
     {
-        subject = DEFAULT_DECIDE_SUBJECT;
+        subject = fallback;
     }
+    return subject;
+}
+
+int nats_request_decide(const char *req_json, char *resp_buf, size_t resp_size)
+{
+    const char *subject = subject_from_env("ROUTER_DECIDE_SUBJECT", DEFAULT_DECIDE_SUBJECT);
     return nats_request_common(subject, req_json, resp_buf, resp_size);
 }
 
-int nats_request_get_decision(const char *tenant_id,
-                              const char *message_id,
-                              char *resp_buf,
-                              size_t resp_size)
+int nats_request_decide_async(const char *req_json, nats_reply_cb_t cb, void *closure)
 {
-    (void)tenant_id; /* currently unused, but reserved for future Router contracts */
+    const char *subject = subject_from_env("ROUTER_DECIDE_SUBJECT", DEFAULT_DECIDE_SUBJECT);
+    return nats_request_common_async(subject, req_json, cb, closure);
+}
 
-    const char *subject = getenv("ROUTER_GET_DECISION_SUBJECT");
-    if (subject == NULL || subject[0] == '\0')
-    {
-        subject = DEFAULT_GET_DECISION_SUBJECT;
-    }
+int nats_request_decide_idempotent_async(const char *req_json, nats_reply_cb_t cb, void *closure)
+{
+    const char *subject = subject_from_env("ROUTER_DECIDE_SUBJECT", DEFAULT_DECIDE_SUBJECT);
+    return nats_request_idempotent_async(subject, req_json, cb, closure);
+}
 
-    /* For now Router expects only message_id in the request JSON or reuses existing contract.
-     * If a dedicated DTO is required later, this function can build it here.
-     */
+/* For now Router expects only message_id in the request JSON or reuses existing contract.
+ * If a dedicated DTO is required later, it can be built here.
+ */
+static int build_get_decision_json(const char *message_id, char *req_json, size_t size)
+{
     if (message_id == NULL || message_id[0] == '\0')
     {
         return -1;
     }
 
     /* Minimal JSON body: { "message_id": "..." } */
-    char req_json[256];
-    int  len = snprintf(req_json, sizeof(req_json),
-                        "{\"message_id\":\"%s\"}", message_id);
-    if (len < 0 || (size_t)len >= sizeof(req_json))
+    int len = snprintf(req_json, size, "{\"message_id\":\"%s\"}", message_id);
+    if (len < 0 || (size_t)len >= size)
     {
         return -1;
     }
+    return 0;
+}
 
+int nats_request_get_decision(const char *tenant_id,
+                              const char *message_id,
+                              char *resp_buf,
+                              size_t resp_size)
+{
+    (void)tenant_id; /* currently unused, but reserved for future Router contracts */
+
+    char req_json[256];
+    if (build_get_decision_json(message_id, req_json, sizeof(req_json)) != 0)
+    {
+        return -1;
+    }
+    const char *subject = subject_from_env("ROUTER_GET_DECISION_SUBJECT",
+                                           DEFAULT_GET_DECISION_SUBJECT);
     return nats_request_common(subject, req_json, resp_buf, resp_size);
 }
 
-int nats_request_get_extension_health(char *resp_buf, size_t resp_size)
+int nats_request_get_decision_async(const char *tenant_id,
+                                    const char *message_id,
+                                    nats_reply_cb_t cb,
+                                    void *closure)
 {
-    const char *subject = getenv("ROUTER_ADMIN_GET_EXTENSION_HEALTH_SUBJECT");
-    if (subject == NULL || subject[0] == '\0')
+    (void)tenant_id;
+
+    char req_json[256];
+    if (build_get_decision_json(message_id, req_json, sizeof(req_json)) != 0)
     {
-        subject = "beamline.router.v1.admin.get_extension_health";
+        return -1;
     }
+    const char *subject = subject_from_env("ROUTER_GET_DECISION_SUBJECT",
+                                           DEFAULT_GET_DECISION_SUBJECT);
+    return nats_request_idempotent_async(subject, req_json, cb, closure);
+}
+
+#define EXTENSION_HEALTH_SUBJECT_ENV "ROUTER_ADMIN_GET_EXTENSION_HEALTH_SUBJECT"
+#define EXTENSION_HEALTH_SUBJECT     "beamline.router.v1.admin.get_extension_health"
+#define CB_STATES_SUBJECT_ENV        "ROUTER_ADMIN_GET_CIRCUIT_BREAKER_STATES_SUBJECT"
+#define CB_STATES_SUBJECT            "beamline.router.v1.admin.get_circuit_breaker_states"
+#define DRY_RUN_SUBJECT_ENV          "ROUTER_ADMIN_DRY_RUN_PIPELINE_SUBJECT"
+#define DRY_RUN_SUBJECT              "beamline.router.v1.admin.dry_run_pipeline"
+#define COMPLEXITY_SUBJECT_ENV       "ROUTER_ADMIN_GET_PIPELINE_COMPLEXITY_SUBJECT"
+#define COMPLEXITY_SUBJECT           "beamline.router.v1.admin.get_pipeline_complexity"
+
+int nats_request_get_extension_health(char *resp_buf, size_t resp_size)
+{
+    const char *subject = subject_from_env(EXTENSION_HEALTH_SUBJECT_ENV, EXTENSION_HEALTH_SUBJECT);
 
     /* Empty request body (no parameters needed) */
-    const char *req_json = "{}";
-    return nats_request_common(subject, req_json, resp_buf, resp_size);
+    return nats_request_common(subject, "{}", resp_buf, resp_size);
+}
+
+int nats_request_get_extension_health_async(nats_reply_cb_t cb, void *closure)
+{
+    const char *subject = subject_from_env(EXTENSION_HEALTH_SUBJECT_ENV, EXTENSION_HEALTH_SUBJECT);
+    return nats_request_idempotent_async(subject, "{}", cb, closure);
 }
 
 int nats_request_get_circuit_breaker_states(char *resp_buf, size_t resp_size)
 {
-    const char *subject = getenv("ROUTER_ADMIN_GET_CIRCUIT_BREAKER_STATES_SUBJECT");
-    if (subject == NULL || subject[0] == '\0')
-    {
-        subject = "beamline.router.v1.admin.get_circuit_breaker_states";
-    }
+    const char *subject = subject_from_env(CB_STATES_SUBJECT_ENV, CB_STATES_SUBJECT);
 
     /* Empty request body (no parameters needed) */
-    const char *req_json = "{}";
-    return nats_request_common(subject, req_json, resp_buf, resp_size);
+    return nats_request_common(subject, "{}", resp_buf, resp_size);
+}
+
+int nats_request_get_circuit_breaker_states_async(nats_reply_cb_t cb, void *closure)
+{
+    const char *subject = subject_from_env(CB_STATES_SUBJECT_ENV, CB_STATES_SUBJECT);
+    return nats_request_idempotent_async(subject, "{}", cb, closure);
 }
 
 int nats_request_dry_run_pipeline(const char *req_json, char *resp_buf, size_t resp_size)
@@ -196,19 +747,24 @@ int nats_request_dry_run_pipeline(const char *req_json, char *resp_buf, size_t r
         return -1;
     }
 
-    const char *subject = getenv("ROUTER_ADMIN_DRY_RUN_PIPELINE_SUBJECT");
-    if (subject == NULL || subject[0] == '\0')
+    const char *subject = subject_from_env(DRY_RUN_SUBJECT_ENV, DRY_RUN_SUBJECT);
+    return nats_request_common(subject, req_json, resp_buf, resp_size);
+}
+
+int nats_request_dry_run_pipeline_async(const char *req_json, nats_reply_cb_t cb, void *closure)
+{
+    if (req_json == NULL || req_json[0] == '\0')
     {
-        subject = "beamline.router.v1.admin.dry_run_pipeline";
+        return -1;
     }
 
-    return nats_request_common(subject, req_json, resp_buf, resp_size);
+    const char *subject = subject_from_env(DRY_RUN_SUBJECT_ENV, DRY_RUN_SUBJECT);
+    return nats_request_common_async(subject, req_json, cb, closure);
 }
 
-int nats_request_get_pipeline_complexity(const char *tenant_id,
-                                        const char *policy_id,
-                                        char *resp_buf,
-                                        size_t resp_size)
+/* Build request JSON: { "tenant_id": "...", "policy_id": "..." } */
+static int build_complexity_json(const char *tenant_id, const char *policy_id,
+                                 char *req_json, size_t size)
 {
     if (tenant_id == NULL || tenant_id[0] == '\0' ||
         policy_id == NULL || policy_id[0] == '\0')
@@ -216,25 +772,56 @@ int nats_request_get_pipeline_complexity(const char *tenant_id,
         return -1;
     }
 
-    const char *subject = getenv("ROUTER_ADMIN_GET_PIPELINE_COMPLEXITY_SUBJECT");
-    if (subject == NULL || subject[0] == '\0')
+    int len = snprintf(req_json, size,
+                       "{\"tenant_id\":\"%s\",\"policy_id\":\"%s\"}",
+                       tenant_id, policy_id);
+    if (len < 0 || (size_t)len >= size)
     {
-        subject = "beamline.router.v1.admin.get_pipeline_complexity";
+        return -1;
     }
+    return 0;
+}
 
-    /* Build request JSON: { "tenant_id": "...", "policy_id": "..." } */
+int nats_request_get_pipeline_complexity(const char *tenant_id,
+                                        const char *policy_id,
+                                        char *resp_buf,
+                                        size_t resp_size)
+{
     char req_json[512];
-    int  len = snprintf(req_json, sizeof(req_json),
-                        "{\"tenant_id\":\"%s\",\"policy_id\":\"%s\"}",
-                        tenant_id, policy_id);
-    if (len < 0 || (size_t)len >= sizeof(req_json))
+    if (build_complexity_json(tenant_id, policy_id, req_json, sizeof(req_json)) != 0)
     {
         return -1;
     }
 
+    const char *subject = subject_from_env(COMPLEXITY_SUBJECT_ENV, COMPLEXITY_SUBJECT);
     return nats_request_common(subject, req_json, resp_buf, resp_size);
 }
 
+int nats_request_get_pipeline_complexity_async(const char *tenant_id,
+                                              const char *policy_id,
+                                              nats_reply_cb_t cb,
+                                              void *closure)
+{
+    char req_json[512];
+    if (build_complexity_json(tenant_id, policy_id, req_json, sizeof(req_json)) != 0)
+    {
+        return -1;
+    }
+
+    const char *subject = subject_from_env(COMPLEXITY_SUBJECT_ENV, COMPLEXITY_SUBJECT);
+    return nats_request_idempotent_async(subject, req_json, cb, closure);
+}
+
+int nats_publish_batch_async(const char *subject, const char *payload,
+                             nats_reply_cb_t cb, void *closure)
+{
+    if (payload == NULL || payload[0] == '\0')
+    {
+        return -1;
+    }
+    return nats_request_common_async(subject, payload, cb, closure);
+}
+
 #else /* USE_NATS_LIB not defined */
 
 /* Stub implementations when NATS library is not available */
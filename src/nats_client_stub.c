@@ -1,13 +1,30 @@
 #include "nats_client_stub.h"
 
+#include <stdatomic.h>
 #include <stdio.h>
 #include <string.h>
 
+/* Response buffer for the async variants (matches the HTTP layer) */
+#define STUB_ASYNC_RESP_SIZE 65536U
+
 const char *nats_get_status_string(void)
 {
     return "stub"; /* indicates stubbed NATS client */
 }
 
+int nats_client_init(void)
+{
+    return 0; /* nothing to connect */
+}
+
+void nats_client_shutdown(void)
+{
+}
+
+void nats_client_collect_metrics(void)
+{
+}
+
 int nats_request_decide(const char *req_json, char *resp_buf, size_t resp_size) {
     (void)req_json; /* unused for stub */
 
@@ -196,3 +213,107 @@ int nats_request_get_pipeline_complexity(const char *tenant_id,
     memcpy(resp_buf, dummy, len + 1U);
     return 0;
 }
+
+/*
+ * Async variants: the stub answers immediately, so the callback runs
+ * inline before the submit call returns.
+ */
+static void stub_complete(int rc, const char *resp_buf, nats_reply_cb_t cb, void *closure)
+{
+    cb(rc, rc == 0 ? resp_buf : NULL, closure);
+}
+
+int nats_request_decide_async(const char *req_json, nats_reply_cb_t cb, void *closure)
+{
+    if (cb == NULL) {
+        return -1;
+    }
+    char resp_buf[STUB_ASYNC_RESP_SIZE];
+    int rc = nats_request_decide(req_json, resp_buf, sizeof(resp_buf));
+    stub_complete(rc, resp_buf, cb, closure);
+    return 0;
+}
+
+int nats_request_decide_idempotent_async(const char *req_json, nats_reply_cb_t cb, void *closure)
+{
+    /* Nothing to hedge: the stub answers at once */
+    return nats_request_decide_async(req_json, cb, closure);
+}
+
+int nats_request_get_decision_async(const char *tenant_id,
+                                    const char *message_id,
+                                    nats_reply_cb_t cb,
+                                    void *closure)
+{
+    if (cb == NULL) {
+        return -1;
+    }
+    char resp_buf[STUB_ASYNC_RESP_SIZE];
+    int rc = nats_request_get_decision(tenant_id, message_id, resp_buf, sizeof(resp_buf));
+    stub_complete(rc, resp_buf, cb, closure);
+    return 0;
+}
+
+int nats_request_get_extension_health_async(nats_reply_cb_t cb, void *closure)
+{
+    if (cb == NULL) {
+        return -1;
+    }
+    char resp_buf[STUB_ASYNC_RESP_SIZE];
+    int rc = nats_request_get_extension_health(resp_buf, sizeof(resp_buf));
+    stub_complete(rc, resp_buf, cb, closure);
+    return 0;
+}
+
+int nats_request_get_circuit_breaker_states_async(nats_reply_cb_t cb, void *closure)
+{
+    if (cb == NULL) {
+        return -1;
+    }
+    char resp_buf[STUB_ASYNC_RESP_SIZE];
+    int rc = nats_request_get_circuit_breaker_states(resp_buf, sizeof(resp_buf));
+    stub_complete(rc, resp_buf, cb, closure);
+    return 0;
+}
+
+int nats_request_dry_run_pipeline_async(const char *req_json, nats_reply_cb_t cb, void *closure)
+{
+    if (cb == NULL) {
+        return -1;
+    }
+    char resp_buf[STUB_ASYNC_RESP_SIZE];
+    int rc = nats_request_dry_run_pipeline(req_json, resp_buf, sizeof(resp_buf));
+    stub_complete(rc, resp_buf, cb, closure);
+    return 0;
+}
+
+int nats_request_get_pipeline_complexity_async(const char *tenant_id,
+                                              const char *policy_id,
+                                              nats_reply_cb_t cb,
+                                              void *closure)
+{
+    if (cb == NULL) {
+        return -1;
+    }
+    char resp_buf[STUB_ASYNC_RESP_SIZE];
+    int rc = nats_request_get_pipeline_complexity(tenant_id, policy_id, resp_buf, sizeof(resp_buf));
+    stub_complete(rc, resp_buf, cb, closure);
+    return 0;
+}
+
+/* Every batch is acknowledged, in order, as if stored in a stream */
+static atomic_ulong stub_stream_seq = 0;
+
+int nats_publish_batch_async(const char *subject, const char *payload,
+                             nats_reply_cb_t cb, void *closure)
+{
+    if (cb == NULL || subject == NULL || subject[0] == '\0' ||
+        payload == NULL || payload[0] == '\0') {
+        return -1;
+    }
+    char ack[64];
+    (void)snprintf(ack, sizeof(ack), "{\"stream\":\"stub\",\"seq\":%lu}",
+                   atomic_fetch_add(&stub_stream_seq, 1UL) + 1UL);
+    stub_complete(0, ack, cb, closure);
+    return 0;
+}
@@ -13,6 +13,28 @@ extern "C" {
  */
 const char *nats_get_status_string(void);
 
+/*
+ * Open the Router connection(s) before serving requests. A server that
+ * is not reachable yet is retried in the background; requests made
+ * meanwhile are buffered until it is, or time out. Called lazily by the
+ * first request otherwise.
+ *
+ * Returns 0 on success, non-zero on error.
+ */
+int nats_client_init(void);
+
+/*
+ * Close the connection(s); requests still outstanding complete with an
+ * error. Call once no more requests are being submitted.
+ */
+void nats_client_shutdown(void);
+
+/*
+ * Export connection pool statistics to the metrics registry (no-op
+ * without a real client). Called before /metrics is rendered.
+ */
+void nats_client_collect_metrics(void);
+
 /*
  * Minimal stub for NATS request-reply to Router.
  *
@@ -83,6 +105,62 @@ int nats_request_get_pipeline_complexity(const char *tenant_id,
                                         char *resp_buf,
                                         size_t resp_size);
 
+/*
+ * Asynchronous variants.
+ *
+ * Each call publishes the request and returns without waiting for the
+ * Router. The callback then runs exactly once, from any thread (possibly
+ * inline, before the submit call returns):
+ *
+ *   status    - 0 on success, non-zero on error or timeout
+ *   resp_json - NUL-terminated response, NULL on error; only valid
+ *               during the callback
+ *   closure   - caller pointer passed through
+ *
+ * Request arguments are copied before the call returns.
+ *
+ * Returns 0 if the request was submitted, non-zero if it was not (the
+ * callback will not run).
+ */
+typedef void (*nats_reply_cb_t)(int status, const char *resp_json, void *closure);
+
+int nats_request_decide_async(const char *req_json, nats_reply_cb_t cb, void *closure);
+
+/*
+ * Decide for a request the client marked safe to repeat (it carries an
+ * Idempotency-Key), so a late Router reply may be hedged like a read.
+ * The read variants below (get_decision, extension health, circuit
+ * breaker states, pipeline complexity) are always hedged; decide and
+ * dry-run otherwise never are.
+ */
+int nats_request_decide_idempotent_async(const char *req_json, nats_reply_cb_t cb, void *closure);
+
+int nats_request_get_decision_async(const char *tenant_id,
+                                    const char *message_id,
+                                    nats_reply_cb_t cb,
+                                    void *closure);
+
+int nats_request_get_extension_health_async(nats_reply_cb_t cb, void *closure);
+
+int nats_request_get_circuit_breaker_states_async(nats_reply_cb_t cb, void *closure);
+
+int nats_request_dry_run_pipeline_async(const char *req_json, nats_reply_cb_t cb, void *closure);
+
+int nats_request_get_pipeline_complexity_async(const char *tenant_id,
+                                              const char *policy_id,
+                                              nats_reply_cb_t cb,
+                                              void *closure);
+
+/*
+ * Publish an ingest batch to subject and deliver the consumer's publish
+ * acknowledgement to cb like a Router reply. A JetStream-style ack is
+ * {"stream":"...","seq":N}; a rejected batch is acked with an "error"
+ * object, which cb has to check for. No ack within the Router timeout
+ * is a non-zero status.
+ */
+int nats_publish_batch_async(const char *subject, const char *payload,
+                             nats_reply_cb_t cb, void *closure);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,7 +1,13 @@
 /**
  * nats_pool.c - NATS connection pool implementation
- * 
+ *
  * Task 23: Connection pooling to reduce connection overhead
+ *
+ * Connections live in a fixed array of slots that never move, so a slot
+ * pointer stays valid for the life of the pool: the library's callbacks
+ * and the per-thread affinity cache both hold one. A slot's generation
+ * goes up each time it is reused, which is how a cached pointer notices
+ * that its connection was replaced.
  */
 
 #define _GNU_SOURCE
@@ -10,10 +16,19 @@
 #include <stdio.h>
 #include <string.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include <sys/time.h>
 #include <unistd.h>
 #include <errno.h>
 
+#ifdef USE_NATS_LIB
+#include <nats/nats.h>
+#endif
+
+#define AFFINITY_CACHE_SIZE 4           /* Pools a thread is bound in
+                                           without a list walk */
+#define CLOSE_WAIT_MS       2000        /* For the library to report a close */
+
 /**
  * Pooled connection wrapper
  */
@@ -22,8 +37,14 @@ struct nats_connection_t {
     time_t created_at;              /* Creation timestamp */
     time_t last_used;               /* Last usage timestamp */
     int in_use;                     /* 1 if currently acquired */
-    int healthy;                    /* 1 if health check passed */
-    int reconnect_attempts;         /* Reconnection attempts */
+    atomic_int healthy;             /* 1 while connected */
+    size_t bound_threads;           /* Threads with affinity to it */
+    atomic_uint generation;         /* Bumped each time the slot is reused */
+    int closing;                    /* Being closed, not to be handed out */
+    int closed;                     /* Library reported it closed */
+    void *user;                     /* nats_pool_set_user() */
+    nats_pool_t *pool;
+    unsigned index;
 };
 
 /**
@@ -31,15 +52,18 @@ struct nats_connection_t {
  */
 struct nats_pool_t {
     nats_pool_config_t config;
+    uint64_t id;                    /* Never reused: keys the affinity cache */
     
-    /* Connection array */
+    /* Connection slots (never moved or compacted) */
     nats_connection_t *connections;
-    size_t num_connections;
+    size_t num_connections;         /* Open slots */
     size_t max_connections;
+    atomic_size_t healthy;          /* Open and connected */
     
     /* Synchronization */
     pthread_mutex_t mutex;
     pthread_cond_t cond_available; /* Signal when connection available */
+    pthread_cond_t cond_closed;    /* Signal when the library closed one */
     
     /* Statistics */
     nats_pool_stats_t stats;
@@ -48,6 +72,19 @@ struct nats_pool_t {
     int shutdown;
 };
 
+/**
+ * A thread's binding in one pool
+ */
+typedef struct {
+    uint64_t pool_id;
+    nats_connection_t *conn;
+    unsigned generation;
+} affinity_entry_t;
+
+static atomic_uint_fast64_t g_next_id = 1;
+static _Thread_local affinity_entry_t tls_affinity[AFFINITY_CACHE_SIZE];
+static _Thread_local unsigned tls_affinity_next = 0;
+
 /**
  * Get current time in seconds
  */
@@ -56,39 +93,236 @@ static time_t now_sec(void) {
 }
 
 /**
- * Create a new NATS connection
- * 
- * NOTE: This is a stub. In real implementation, would use natsConnection_ConnectTo()
+ * Absolute CLOCK_REALTIME time timeout_ms from now
+ */
+static void deadline_after(struct timespec *ts, int timeout_ms) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    ts->tv_sec = tv.tv_sec + (timeout_ms / 1000);
+    ts->tv_nsec = (tv.tv_usec * 1000) + ((timeout_ms % 1000) * 1000000);
+    if (ts->tv_nsec >= 1000000000) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000;
+    }
+}
+
+/**
+ * Record a connection going up or down (any thread)
+ */
+static void set_healthy(nats_connection_t *conn, int healthy) {
+    nats_pool_t *pool = conn->pool;
+    if (atomic_exchange(&conn->healthy, healthy) == healthy) {
+        return;
+    }
+    size_t now_healthy = healthy ? atomic_fetch_add(&pool->healthy, 1) + 1
+                                 : atomic_fetch_sub(&pool->healthy, 1) - 1;
+    if (pool->config.hooks.on_state) {
+        pool->config.hooks.on_state(conn, healthy, now_healthy, pool->config.hooks.arg);
+    }
+}
+
+#ifdef USE_NATS_LIB
+
+static void on_conn_connected(natsConnection *nc, void *closure) {
+    (void)nc;
+    set_healthy((nats_connection_t*)closure, 1);
+}
+
+static void on_conn_disconnected(natsConnection *nc, void *closure) {
+    (void)nc;
+    set_healthy((nats_connection_t*)closure, 0);
+}
+
+static void on_conn_closed(natsConnection *nc, void *closure) {
+    (void)nc;
+    nats_connection_t *conn = (nats_connection_t*)closure;
+    nats_pool_t *pool = conn->pool;
+    set_healthy(conn, 0);
+    pthread_mutex_lock(&pool->mutex);
+    conn->closed = 1;
+    pthread_cond_broadcast(&pool->cond_closed);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+/**
+ * Create a NATS connection for a slot
+ *
+ * With retry_connect a server that is down is retried by the library in
+ * the background; the connection is handed out anyway and buffers
+ * publishes until the connected callback marks it healthy.
  */
-static void* create_nats_connection(const char *url, int timeout_ms) {
-    (void)url;
-    (void)timeout_ms;
+static void* create_nats_connection(nats_pool_t *pool, nats_connection_t *conn) {
+    const nats_pool_config_t *cfg = &pool->config;
+    natsOptions *opts = NULL;
+    natsConnection *nc = NULL;
+    
+    natsStatus s = natsOptions_Create(&opts);
+    if (s == NATS_OK) s = natsOptions_SetURL(opts, cfg->nats_url);
+    if (s == NATS_OK && cfg->name) {
+        char name[64];
+        (void)snprintf(name, sizeof(name), "%s-%u", cfg->name, conn->index);
+        s = natsOptions_SetName(opts, name);
+    }
+    if (s == NATS_OK) s = natsOptions_SetTimeout(opts, (int64_t)cfg->connection_timeout_ms);
+    if (s == NATS_OK) s = natsOptions_SetMaxReconnect(opts, cfg->max_reconnect_attempts);
+    if (s == NATS_OK && cfg->reconnect_wait_ms > 0) {
+        s = natsOptions_SetReconnectWait(opts, (int64_t)cfg->reconnect_wait_ms);
+    }
+    if (s == NATS_OK && cfg->reconnect_buf_kb > 0) {
+        s = natsOptions_SetReconnectBufSize(opts, cfg->reconnect_buf_kb * 1024);
+    }
+    if (s == NATS_OK) s = natsOptions_SetDisconnectedCB(opts, on_conn_disconnected, conn);
+    if (s == NATS_OK) s = natsOptions_SetReconnectedCB(opts, on_conn_connected, conn);
+    if (s == NATS_OK) s = natsOptions_SetClosedCB(opts, on_conn_closed, conn);
+    if (s == NATS_OK && cfg->retry_connect) {
+        s = natsOptions_SetRetryOnFailedConnect(opts, true, on_conn_connected, conn);
+    }
+    if (s == NATS_OK) {
+        s = natsConnection_Connect(&nc, opts);
+        if (s == NATS_NOT_YET_CONNECTED) {
+            s = NATS_OK;
+        }
+    }
+    natsOptions_Destroy(opts);
     
-    /* Stub: In real implementation, use natsConnection_ConnectTo() */
-    /* For now, return a dummy pointer to indicate "connection created" */
-    void *conn = malloc(16);  /* Placeholder */
-    return conn;
+    if (s != NATS_OK) {
+        fprintf(stderr, "[nats_pool] Connect to %s failed: %s\n",
+                cfg->nats_url, natsStatus_GetText(s));
+        natsConnection_Destroy(nc);
+        return NULL;
+    }
+    if (natsConnection_Status(nc) == NATS_CONN_STATUS_CONNECTED) {
+        set_healthy(conn, 1);
+    }
+    return nc;
+}
+
+/**
+ * Close a connection and wait for the library's closed event, after
+ * which it calls nothing more on the slot (caller holds the lock)
+ */
+static void close_nats_connection(nats_pool_t *pool, nats_connection_t *conn) {
+    natsConnection_Close((natsConnection*)conn->nats_handle);
+    struct timespec ts;
+    deadline_after(&ts, CLOSE_WAIT_MS);
+    while (!conn->closed) {
+        if (pthread_cond_timedwait(&pool->cond_closed, &pool->mutex, &ts) == ETIMEDOUT) {
+            fprintf(stderr, "[nats_pool] Connection %u did not report closing\n", conn->index);
+            break;
+        }
+    }
 }
 
 /**
  * Destroy a NATS connection
  */
 static void destroy_nats_connection(void *handle) {
-    if (!handle) return;
-    
-    /* Stub: In real implementation, use natsConnection_Destroy() */
-    free(handle);
+    natsConnection_Destroy((natsConnection*)handle);
 }
 
 /**
  * Health check a NATS connection
  */
-static int health_check_connection(void *handle) {
-    if (!handle) return 0;
+static int health_check_connection(nats_connection_t *conn) {
+    if (!conn->nats_handle) return 0;
+    int ok = natsConnection_Status((natsConnection*)conn->nats_handle) == NATS_CONN_STATUS_CONNECTED;
+    set_healthy(conn, ok);
+    return ok;
+}
+
+#else /* Placeholder connections, for builds without libnats */
+
+static void* create_nats_connection(nats_pool_t *pool, nats_connection_t *conn) {
+    (void)pool;
+    void *handle = malloc(16);
+    if (handle) {
+        set_healthy(conn, 1);
+    }
+    return handle;
+}
+
+static void close_nats_connection(nats_pool_t *pool, nats_connection_t *conn) {
+    (void)pool;
+    (void)conn;
+}
+
+static void destroy_nats_connection(void *handle) {
+    free(handle);
+}
+
+static int health_check_connection(nats_connection_t *conn) {
+    return conn->nats_handle != NULL && atomic_load(&conn->healthy);
+}
+
+#endif /* USE_NATS_LIB */
+
+/**
+ * Can the slot be handed out?
+ */
+static int slot_open(const nats_connection_t *conn) {
+    return conn->nats_handle != NULL && !conn->closing;
+}
+
+/**
+ * Open a connection in a free slot (caller holds the lock)
+ *
+ * @return The slot, or NULL if none is free or the connection failed
+ */
+static nats_connection_t* open_connection(nats_pool_t *pool, time_t now) {
+    nats_connection_t *conn = NULL;
+    for (size_t i = 0; i < pool->max_connections; i++) {
+        if (!pool->connections[i].nats_handle) {
+            conn = &pool->connections[i];
+            break;
+        }
+    }
+    if (!conn) return NULL;
+    
+    conn->created_at = now;
+    conn->last_used = now;
+    conn->in_use = 0;
+    conn->bound_threads = 0;
+    conn->closing = 0;
+    conn->closed = 0;
+    conn->user = NULL;
+    atomic_fetch_add(&conn->generation, 1);
+    
+    void *handle = create_nats_connection(pool, conn);
+    if (!handle) return NULL;
+    conn->nats_handle = handle;
+    
+    if (pool->config.hooks.on_open &&
+        pool->config.hooks.on_open(conn, pool->config.hooks.arg) != 0) {
+        close_nats_connection(pool, conn);
+        set_healthy(conn, 0);
+        destroy_nats_connection(handle);
+        conn->nats_handle = NULL;
+        return NULL;
+    }
     
-    /* Stub: In real implementation, use natsConnection_Status() */
-    /* For now, assume healthy */
-    return 1;
+    pool->num_connections++;
+    pool->stats.total_created++;
+    return conn;
+}
+
+/**
+ * Close an open connection and free its slot (caller holds the lock,
+ * which is released while waiting for the library)
+ */
+static void retire_connection(nats_pool_t *pool, nats_connection_t *conn) {
+    conn->closing = 1;
+    pool->num_connections--;
+    pool->stats.total_destroyed++;
+    
+    close_nats_connection(pool, conn);
+    set_healthy(conn, 0);
+    if (pool->config.hooks.on_close) {
+        pool->config.hooks.on_close(conn, pool->config.hooks.arg);
+    }
+    destroy_nats_connection(conn->nats_handle);
+    conn->nats_handle = NULL;
+    conn->user = NULL;
+    conn->closing = 0;
 }
 
 nats_pool_t* nats_pool_init(const nats_pool_config_t *config) {
@@ -103,6 +337,7 @@ nats_pool_t* nats_pool_init(const nats_pool_config_t *config) {
     
     /* Copy configuration */
     pool->config = *config;
+    pool->id = atomic_fetch_add(&g_next_id, 1);
     
     /* Validate config */
     if (pool->config.min_connections < 1) pool->config.min_connections = 1;
@@ -112,36 +347,33 @@ nats_pool_t* nats_pool_init(const nats_pool_config_t *config) {
     if (pool->config.connection_timeout_ms <= 0) pool->config.connection_timeout_ms = 5000;
     if (pool->config.idle_timeout_sec <= 0) pool->config.idle_timeout_sec = 60;
     
-    /* Allocate connection array */
-    pool->max_connections = config->max_connections;
-    pool->connections = (nats_connection_t*)calloc(pool->max_connections, 
+    /* Allocate connection slots */
+    pool->max_connections = pool->config.max_connections;
+    pool->connections = (nats_connection_t*)calloc(pool->max_connections,
                                                    sizeof(nats_connection_t));
     if (!pool->connections) {
         free(pool);
         return NULL;
     }
+    for (size_t i = 0; i < pool->max_connections; i++) {
+        pool->connections[i].pool = pool;
+        pool->connections[i].index = (unsigned)i;
+    }
     
     /* Initialize synchronization */
     pthread_mutex_init(&pool->mutex, NULL);
     pthread_cond_init(&pool->cond_available, NULL);
+    pthread_cond_init(&pool->cond_closed, NULL);
     
     /* Create minimum connections */
+    pthread_mutex_lock(&pool->mutex);
     time_t now = now_sec();
     for (size_t i = 0; i < pool->config.min_connections; i++) {
-        void *handle = create_nats_connection(pool->config.nats_url,
-                                              pool->config.connection_timeout_ms);
-        if (handle) {
-            pool->connections[i].nats_handle = handle;
-            pool->connections[i].created_at = now;
-            pool->connections[i].last_used = now;
-            pool->connections[i].in_use = 0;
-            pool->connections[i].healthy = 1;
-            pool->connections[i].reconnect_attempts = 0;
-            pool->num_connections++;
-            pool->stats.total_created++;
+        if (open_connection(pool, now)) {
             pool->stats.idle_connections++;  /* Track idle */
         }
     }
+    pthread_mutex_unlock(&pool->mutex);
     
     printf("[nats_pool] Initialized with %zu/%zu connections (url=%s)\n",
            pool->num_connections, pool->max_connections, pool->config.nats_url);
@@ -158,14 +390,7 @@ nats_connection_t* nats_pool_acquire(nats_pool_t *pool, int timeout_ms) {
     
     struct timespec ts;
     if (timeout_ms > 0) {
-        struct timeval tv;
-        gettimeofday(&tv, NULL);
-        ts.tv_sec = tv.tv_sec + (timeout_ms / 1000);
-        ts.tv_nsec = (tv.tv_usec * 1000) + ((timeout_ms % 1000) * 1000000);
-        if (ts.tv_nsec >= 1000000000) {
-            ts.tv_sec++;
-            ts.tv_nsec -= 1000000000;
-        }
+        deadline_after(&ts, timeout_ms);
     }
     
     nats_connection_t *conn = NULL;
@@ -174,9 +399,10 @@ nats_connection_t* nats_pool_acquire(nats_pool_t *pool, int timeout_ms) {
     /* Wait loop */
     while (!pool->shutdown) {
         /* Try to find idle healthy connection */
-        for (size_t i = 0; i < pool->num_connections; i++) {
-            if (!pool->connections[i].in_use && pool->connections[i].healthy) {
-                conn = &pool->connections[i];
+        for (size_t i = 0; i < pool->max_connections; i++) {
+            nats_connection_t *c = &pool->connections[i];
+            if (slot_open(c) && !c->in_use && atomic_load(&c->healthy)) {
+                conn = c;
                 conn->in_use = 1;
                 conn->last_used = now;
                 pool->stats.active_connections++;
@@ -184,29 +410,18 @@ nats_connection_t* nats_pool_acquire(nats_pool_t *pool, int timeout_ms) {
                 goto done;
             }
         }
-        
+    
         /* Try to create new connection if under max */
         if (pool->num_connections < pool->max_connections) {
-            void *handle = create_nats_connection(pool->config.nats_url,
-                                                  pool->config.connection_timeout_ms);
-            if (handle) {
-                nats_connection_t *new_conn = &pool->connections[pool->num_connections];
-                new_conn->nats_handle = handle;
-                new_conn->created_at = now;
-                new_conn->last_used = now;
+            nats_connection_t *new_conn = open_connection(pool, now);
+            if (new_conn) {
                 new_conn->in_use = 1;
-                new_conn->healthy = 1;
-                new_conn->reconnect_attempts = 0;
-                
-                pool->num_connections++;
-                pool->stats.total_created++;
                 pool->stats.active_connections++;
-                
                 conn = new_conn;
                 goto done;
             }
         }
-        
+    
         /* Wait for available connection */
         if (timeout_ms == 0) {
             /* No wait */
@@ -224,7 +439,7 @@ nats_connection_t* nats_pool_acquire(nats_pool_t *pool, int timeout_ms) {
             }
         }
     }
-    
+
 done:
     pthread_mutex_unlock(&pool->mutex);
     return conn;
@@ -248,11 +463,103 @@ void nats_pool_release(nats_pool_t *pool, nats_connection_t *conn) {
     pthread_mutex_unlock(&pool->mutex);
 }
 
+/**
+ * Connection for a thread to bind to (caller holds the lock)
+ *
+ * The healthy connection with the fewest threads, other than exclude. A
+ * new one is opened when all healthy ones already have threads, or when
+ * there is none at all; while connections are merely down no new one is
+ * tried, since that would block the caller on a connect timeout.
+ */
+static nats_connection_t* pick_for_thread(nats_pool_t *pool, const nats_connection_t *exclude) {
+    nats_connection_t *best = NULL;
+    for (size_t i = 0; i < pool->max_connections; i++) {
+        nats_connection_t *c = &pool->connections[i];
+        if (c == exclude || !slot_open(c) || !atomic_load(&c->healthy)) continue;
+        if (!best || c->bound_threads < best->bound_threads) best = c;
+    }
+    int room = pool->num_connections < pool->max_connections;
+    if (room && ((best && best->bound_threads > 0) || pool->num_connections == 0)) {
+        nats_connection_t *fresh = open_connection(pool, now_sec());
+        if (fresh) {
+            pool->stats.idle_connections++;
+            if (!best || atomic_load(&fresh->healthy)) best = fresh;
+        }
+    }
+    return best;
+}
+
+/* Slow path of nats_pool_thread_connection(): first call, or the bound
+ * connection went down or was replaced */
+static nats_connection_t* bind_thread(nats_pool_t *pool, affinity_entry_t *entry) {
+    pthread_mutex_lock(&pool->mutex);
+    if (pool->shutdown) {
+        pthread_mutex_unlock(&pool->mutex);
+        return NULL;
+    }
+    
+    nats_connection_t *current = NULL;
+    if (entry && slot_open(entry->conn) &&
+        atomic_load(&entry->conn->generation) == entry->generation) {
+        current = entry->conn;
+        if (atomic_load(&current->healthy)) {
+            /* Came back meanwhile */
+            pthread_mutex_unlock(&pool->mutex);
+            return current;
+        }
+    }
+    
+    nats_connection_t *conn = pick_for_thread(pool, current);
+    if (!conn) {
+        /* Nothing healthy: stay, the library buffers while reconnecting */
+        conn = current;
+    }
+    if (conn && conn != current) {
+        if (current) {
+            current->bound_threads--;
+            pool->stats.rebinds++;
+        }
+        conn->bound_threads++;
+        conn->last_used = now_sec();
+        if (!entry) {
+            entry = &tls_affinity[tls_affinity_next++ % AFFINITY_CACHE_SIZE];
+        }
+        entry->pool_id = pool->id;
+        entry->conn = conn;
+        entry->generation = atomic_load(&conn->generation);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return conn;
+}
+
+nats_connection_t* nats_pool_thread_connection(nats_pool_t *pool) {
+    if (!pool) return NULL;
+    
+    affinity_entry_t *entry = NULL;
+    for (unsigned i = 0; i < AFFINITY_CACHE_SIZE; i++) {
+        if (tls_affinity[i].pool_id == pool->id) {
+            entry = &tls_affinity[i];
+            break;
+        }
+    }
+    if (entry && atomic_load_explicit(&entry->conn->healthy, memory_order_relaxed) &&
+        atomic_load_explicit(&entry->conn->generation, memory_order_relaxed) == entry->generation) {
+        return entry->conn;
+    }
+    return bind_thread(pool, entry);
+}
+
 int nats_pool_get_stats(const nats_pool_t *pool, nats_pool_stats_t *stats) {
     if (!pool || !stats) return -1;
     
     pthread_mutex_lock((pthread_mutex_t*)&pool->mutex);
     *stats = pool->stats;
+    stats->open_connections = pool->num_connections;
+    stats->healthy_connections = atomic_load(&pool->healthy);
+    stats->bound_threads = 0;
+    for (size_t i = 0; i < pool->max_connections; i++) {
+        stats->bound_threads += pool->connections[i].bound_threads;
+    }
     pthread_mutex_unlock((pthread_mutex_t*)&pool->mutex);
     
     return 0;
@@ -266,48 +573,30 @@ int nats_pool_health_check(nats_pool_t *pool) {
     int removed = 0;
     time_t now = now_sec();
     
-    for (size_t i = 0; i < pool->num_connections; i++) {
+    for (size_t i = 0; i < pool->max_connections; i++) {
         nats_connection_t *conn = &pool->connections[i];
-        
-        /* Skip in-use connections */
-        if (conn->in_use) continue;
-        
-        /* Check idle timeout */
-        time_t idle_time_sec = now - conn->last_used;
-        if (idle_time_sec > (time_t)pool->config.idle_timeout_sec) {
-            destroy_nats_connection(conn->nats_handle);
-            conn->nats_handle = NULL;
-            conn->healthy = 0;
-            pool->stats.idle_connections--;
-            pool->stats.total_destroyed++;
-            removed++;
-            continue;
-        }
-        
+        if (!slot_open(conn)) continue;
+    
+        /* Skip in-use and thread-bound connections */
+        if (conn->in_use || conn->bound_threads > 0) continue;
+    
         /* Health check */
-        if (conn->nats_handle && !health_check_connection(conn->nats_handle)) {
-            destroy_nats_connection(conn->nats_handle);
-            conn->nats_handle = NULL;
-            conn->healthy = 0;
+        if (!health_check_connection(conn)) {
             pool->stats.health_check_failures++;
             pool->stats.idle_connections--;
-            pool->stats.total_destroyed++;
+            retire_connection(pool, conn);
             removed++;
+            continue;
         }
-    }
     
-    /* Compact array (remove dead connections) */
-    if (removed > 0) {
-        size_t write_idx = 0;
-        for (size_t read_idx = 0; read_idx < pool->num_connections; read_idx++) {
-            if (pool->connections[read_idx].nats_handle) {
-                if (write_idx != read_idx) {
-                    pool->connections[write_idx] = pool->connections[read_idx];
-                }
-                write_idx++;
-            }
+        /* Check idle timeout */
+        time_t idle_time_sec = now - conn->last_used;
+        if (idle_time_sec > (time_t)pool->config.idle_timeout_sec &&
+            pool->num_connections > pool->config.min_connections) {
+            pool->stats.idle_connections--;
+            retire_connection(pool, conn);
+            removed++;
         }
-        pool->num_connections = write_idx;
     }
     
     pthread_mutex_unlock(&pool->mutex);
@@ -325,14 +614,14 @@ void nats_pool_destroy(nats_pool_t *pool) {
     pthread_mutex_lock(&pool->mutex);
     pool->shutdown = 1;
     pthread_cond_broadcast(&pool->cond_available);
-    pthread_mutex_unlock(&pool->mutex);
     
     /* Close all connections */
-    for (size_t i = 0; i < pool->num_connections; i++) {
-        if (pool->connections[i].nats_handle) {
-            destroy_nats_connection(pool->connections[i].nats_handle);
+    for (size_t i = 0; i < pool->max_connections; i++) {
+        if (slot_open(&pool->connections[i])) {
+            retire_connection(pool, &pool->connections[i]);
         }
     }
+    pthread_mutex_unlock(&pool->mutex);
     
     printf("[nats_pool] Destroyed (created=%zu, destroyed=%zu, acquired=%zu)\n",
            pool->stats.total_created, pool->stats.total_destroyed,
@@ -340,6 +629,7 @@ void nats_pool_destroy(nats_pool_t *pool) {
     
     pthread_mutex_destroy(&pool->mutex);
     pthread_cond_destroy(&pool->cond_available);
+    pthread_cond_destroy(&pool->cond_closed);
     free(pool->connections);
     free(pool);
 }
@@ -347,3 +637,15 @@ void nats_pool_destroy(nats_pool_t *pool) {
 void* nats_pool_get_handle(nats_connection_t *conn) {
     return conn ? conn->nats_handle : NULL;
 }
+
+int nats_pool_connection_healthy(const nats_connection_t *conn) {
+    return conn ? atomic_load(&conn->healthy) : 0;
+}
+
+void nats_pool_set_user(nats_connection_t *conn, void *user) {
+    if (conn) conn->user = user;
+}
+
+void* nats_pool_get_user(const nats_connection_t *conn) {
+    return conn ? conn->user : NULL;
+}
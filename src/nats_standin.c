@@ -0,0 +1,1019 @@
+/**
+ * nats_standin.c - Local NATS server stand-in with a mock Router
+ *
+ * One thread owns everything: the listener, every client, the
+ * subscription table and the responder's timers, so none of it is
+ * locked. Client sockets are non-blocking; input is parsed as soon as a
+ * whole control line (and, for PUB and HPUB, its payload) has arrived,
+ * and output is queued per client and written once per loop pass, or
+ * when the socket becomes writable again. Responder answers wait in a
+ * min-heap on their due time behind a timerfd, which gives them
+ * microsecond resolution without busy polling.
+ */
+
+#define _GNU_SOURCE
+#include "nats_standin.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_EVENTS      256
+#define MAX_LINE        4096             /* Control line, without payload */
+#define READ_CHUNK      65536U
+#define MAX_TOKENS      6
+#define MAX_LATENCY_US  60000000ULL      /* Draws are capped at a minute */
+
+typedef struct client {
+    int fd;
+    uint64_t id;
+    int verbose;                     /* CONNECT asked for +OK */
+    int headers;                     /* CONNECT announced header support */
+    int dead;                        /* Closed at the end of the pass */
+    int dirty;                       /* On the flush list */
+    int want_write;                  /* EPOLLOUT armed */
+    char *in;
+    size_t in_len;
+    size_t in_cap;
+    char *out;
+    size_t out_off;
+    size_t out_len;
+    size_t out_cap;
+    struct client *next;             /* All clients */
+    struct client *next_dirty;
+} client_t;
+
+typedef struct {
+    client_t *client;                /* NULL: removed */
+    char *subject;
+    char *queue;                     /* NULL: not in a queue group */
+    char sid[32];
+    uint64_t max;                    /* Auto-unsubscribe after, 0: never */
+    uint64_t delivered;
+} sub_t;
+
+typedef struct {
+    uint64_t due_us;
+    char *reply;
+    int ingest;                      /* Answer with a publish ack */
+    int error;
+} pending_reply_t;
+
+struct nats_standin_t {
+    nats_standin_config_t config;
+    char host[64];
+    char responder_subject[256];
+    uint16_t port;
+    int listen_fd;
+    int epoll_fd;
+    int wake_fd;                     /* eventfd: stop */
+    int timer_fd;
+    pthread_t thread;
+    atomic_int stopping;
+
+    client_t *clients;
+    client_t *dirty;
+    uint64_t next_client_id;
+
+    sub_t *subs;
+    size_t nsubs;
+    size_t subs_cap;
+    size_t removed_subs;
+    size_t *candidates;              /* Queue subscribers of one publish */
+    size_t candidates_cap;
+
+    pending_reply_t *heap;
+    size_t heap_len;
+    size_t heap_cap;
+    uint64_t armed_us;               /* timerfd deadline, 0: disarmed */
+    uint64_t rng;
+    uint64_t answer_seq;
+    uint64_t ack_seq;
+    char *scratch;                   /* Responder payloads */
+    size_t scratch_cap;
+
+    atomic_uint_fast64_t connections;
+    atomic_uint_fast64_t nclients;
+    atomic_uint_fast64_t msgs_in;
+    atomic_uint_fast64_t msgs_out;
+    atomic_uint_fast64_t bytes_in;
+    atomic_uint_fast64_t bytes_out;
+    atomic_uint_fast64_t requests;
+    atomic_uint_fast64_t responses;
+    atomic_uint_fast64_t errors_injected;
+    atomic_uint_fast64_t slow_consumers;
+    atomic_uint_fast64_t protocol_errors;
+};
+
+static const char *const LATENCY_NAMES[] = { "fixed", "lognormal", "bimodal" };
+
+static void count(atomic_uint_fast64_t *counter, uint64_t n) {
+    atomic_fetch_add_explicit(counter, n, memory_order_relaxed);
+}
+
+static uint64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+/* ---------------- Configuration ---------------- */
+
+void nats_standin_get_default_config(nats_standin_config_t *config) {
+    if (!config) return;
+    memset(config, 0, sizeof(*config));
+    config->host = "127.0.0.1";
+    config->port = 4222;
+    config->max_clients = 1024;
+    config->max_payload = 1024U * 1024U;
+    config->max_pending = 64U * 1024U * 1024U;
+    config->responder = 1;
+    config->responder_subject = "beamline.router.>";
+    config->latency.kind = NATS_STANDIN_LATENCY_FIXED;
+    config->latency.sigma = 0.5;
+    config->latency.slow_ratio = 0.01;
+    config->seed = 0x9e3779b97f4a7c15ULL;
+}
+
+int nats_standin_parse_latency_kind(const char *name, nats_standin_latency_kind_t *kind) {
+    if (!name || !kind) return -1;
+    for (size_t i = 0; i < sizeof(LATENCY_NAMES) / sizeof(LATENCY_NAMES[0]); i++) {
+        if (strcasecmp(name, LATENCY_NAMES[i]) == 0) {
+            *kind = (nats_standin_latency_kind_t)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static int env_u64(const char *name, uint64_t max_val, uint64_t *out) {
+    const char *val = getenv(name);
+    if (val == NULL || *val == '\0') return 0;
+    char *end = NULL;
+    errno = 0;
+    unsigned long long parsed = strtoull(val, &end, 10);
+    if (errno != 0 || *end != '\0' || val[0] == '-' || parsed > max_val) return -1;
+    *out = parsed;
+    return 0;
+}
+
+static int env_double(const char *name, double min_val, double max_val, double *out) {
+    const char *val = getenv(name);
+    if (val == NULL || *val == '\0') return 0;
+    char *end = NULL;
+    double parsed = strtod(val, &end);
+    if (*end != '\0' || !(parsed >= min_val && parsed <= max_val)) return -1;
+    *out = parsed;
+    return 0;
+}
+
+int nats_standin_parse_config(nats_standin_config_t *config) {
+    if (!config) return -1;
+    int rc = 0;
+    uint64_t v = config->port;
+    rc |= env_u64("NATS_STANDIN_PORT", 65535U, &v);
+    config->port = (uint16_t)v;
+    const char *kind = getenv("NATS_STANDIN_LATENCY");
+    if (kind && *kind && nats_standin_parse_latency_kind(kind, &config->latency.kind) != 0) {
+        rc = -1;
+    }
+    rc |= env_u64("NATS_STANDIN_LATENCY_US", MAX_LATENCY_US, &config->latency.median_us);
+    rc |= env_double("NATS_STANDIN_SIGMA", 0.0, 10.0, &config->latency.sigma);
+    rc |= env_u64("NATS_STANDIN_SLOW_US", MAX_LATENCY_US, &config->latency.slow_us);
+    rc |= env_double("NATS_STANDIN_SLOW_RATIO", 0.0, 1.0, &config->latency.slow_ratio);
+    rc |= env_double("NATS_STANDIN_ERROR_RATE", 0.0, 1.0, &config->error_rate);
+    v = config->response_bytes;
+    rc |= env_u64("NATS_STANDIN_RESPONSE_BYTES", 64U * 1024U * 1024U, &v);
+    config->response_bytes = (size_t)v;
+    return rc == 0 ? 0 : -1;
+}
+
+/* ---------------- Latency draws ---------------- */
+
+static uint64_t rng_next(uint64_t *state) {
+    /* xorshift64* */
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+/* Uniform in (0, 1] */
+static double rng_unit(uint64_t *state) {
+    return ((double)(rng_next(state) >> 11) + 1.0) / 9007199254740992.0;
+}
+
+uint64_t nats_standin_sample_latency(const nats_standin_latency_t *latency, uint64_t *rng) {
+    if (!latency || !rng) return 0;
+    if (*rng == 0) *rng = 0x9e3779b97f4a7c15ULL;
+    switch (latency->kind) {
+        case NATS_STANDIN_LATENCY_LOGNORMAL: {
+            /* Box-Muller; the median of exp(mu + sigma Z) is exp(mu) */
+            double u1 = rng_unit(rng);
+            double u2 = rng_unit(rng);
+            double z = sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+            double us = (double)latency->median_us * exp(latency->sigma * z);
+            return us >= (double)MAX_LATENCY_US ? MAX_LATENCY_US : (uint64_t)us;
+        }
+        case NATS_STANDIN_LATENCY_BIMODAL:
+            return rng_unit(rng) <= latency->slow_ratio ? latency->slow_us : latency->median_us;
+        case NATS_STANDIN_LATENCY_FIXED:
+        default:
+            return latency->median_us;
+    }
+}
+
+/* ---------------- Client output ---------------- */
+
+static void mark_dirty(nats_standin_t *s, client_t *c) {
+    if (c->dirty) return;
+    c->dirty = 1;
+    c->next_dirty = s->dirty;
+    s->dirty = c;
+}
+
+static void queue_out(nats_standin_t *s, client_t *c, const char *data, size_t len) {
+    if (c->dead || len == 0) return;
+    size_t pending = c->out_len - c->out_off;
+    if (pending + len > s->config.max_pending) {
+        count(&s->slow_consumers, 1);
+        c->dead = 1;
+        return;
+    }
+    if (c->out_len + len > c->out_cap) {
+        if (c->out_off > 0) {
+            memmove(c->out, c->out + c->out_off, pending);
+            c->out_len = pending;
+            c->out_off = 0;
+        }
+        if (c->out_len + len > c->out_cap) {
+            size_t cap = c->out_cap ? c->out_cap : READ_CHUNK;
+            while (cap < c->out_len + len) cap *= 2U;
+            char *p = realloc(c->out, cap);
+            if (!p) {
+                c->dead = 1;
+                return;
+            }
+            c->out = p;
+            c->out_cap = cap;
+        }
+    }
+    memcpy(c->out + c->out_len, data, len);
+    c->out_len += len;
+    mark_dirty(s, c);
+}
+
+static void queue_str(nats_standin_t *s, client_t *c, const char *text) {
+    queue_out(s, c, text, strlen(text));
+}
+
+static void set_want_write(nats_standin_t *s, client_t *c, int want) {
+    if (c->want_write == want) return;
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | (want ? (uint32_t)EPOLLOUT : 0U);
+    ev.data.ptr = c;
+    if (epoll_ctl(s->epoll_fd, EPOLL_CTL_MOD, c->fd, &ev) == 0) {
+        c->want_write = want;
+    }
+}
+
+static void flush_client(nats_standin_t *s, client_t *c) {
+    while (!c->dead && c->out_off < c->out_len) {
+        ssize_t n = send(c->fd, c->out + c->out_off, c->out_len - c->out_off, MSG_NOSIGNAL);
+        if (n > 0) {
+            c->out_off += (size_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            set_want_write(s, c, 1);
+            return;
+        } else {
+            c->dead = 1;
+            return;
+        }
+    }
+    c->out_off = 0;
+    c->out_len = 0;
+    set_want_write(s, c, 0);
+}
+
+/* ---------------- Subscriptions ---------------- */
+
+/* NATS subject match: '*' is one token, a final '>' one or more */
+static int subject_matches(const char *pattern, const char *subject) {
+    const char *p = pattern;
+    const char *t = subject;
+    for (;;) {
+        size_t plen = strcspn(p, ".");
+        size_t tlen = strcspn(t, ".");
+        if (plen == 1 && p[0] == '>' && p[1] == '\0') {
+            return tlen > 0;
+        }
+        if (tlen == 0) return 0;
+        if (!(plen == 1 && p[0] == '*') && (plen != tlen || memcmp(p, t, plen) != 0)) {
+            return 0;
+        }
+        p += plen;
+        t += tlen;
+        if (*p == '\0' || *t == '\0') {
+            return *p == '\0' && *t == '\0';
+        }
+        p++;
+        t++;
+    }
+}
+
+static void sub_release(nats_standin_t *s, sub_t *sub) {
+    free(sub->subject);
+    free(sub->queue);
+    sub->subject = NULL;
+    sub->queue = NULL;
+    sub->client = NULL;
+    s->removed_subs++;
+}
+
+/* Drop removed entries once they make up half the table */
+static void subs_compact(nats_standin_t *s) {
+    if (s->removed_subs * 2U < s->nsubs) return;
+    size_t n = 0;
+    for (size_t i = 0; i < s->nsubs; i++) {
+        if (s->subs[i].client) s->subs[n++] = s->subs[i];
+    }
+    s->nsubs = n;
+    s->removed_subs = 0;
+}
+
+static int sub_add(nats_standin_t *s, client_t *c, const char *subject, const char *queue, const char *sid) {
+    if (strlen(sid) >= sizeof(s->subs[0].sid)) return -1;
+    if (s->nsubs == s->subs_cap) {
+        size_t cap = s->subs_cap ? s->subs_cap * 2U : 64U;
+        sub_t *p = realloc(s->subs, cap * sizeof(*p));
+        if (!p) return -1;
+        s->subs = p;
+        s->subs_cap = cap;
+    }
+    sub_t *sub = &s->subs[s->nsubs];
+    memset(sub, 0, sizeof(*sub));
+    sub->subject = strdup(subject);
+    sub->queue = queue ? strdup(queue) : NULL;
+    if (!sub->subject || (queue && !sub->queue)) {
+        free(sub->subject);
+        free(sub->queue);
+        return -1;
+    }
+    snprintf(sub->sid, sizeof(sub->sid), "%s", sid);
+    sub->client = c;
+    s->nsubs++;
+    return 0;
+}
+
+static sub_t *sub_find(nats_standin_t *s, client_t *c, const char *sid) {
+    for (size_t i = 0; i < s->nsubs; i++) {
+        if (s->subs[i].client == c && strcmp(s->subs[i].sid, sid) == 0) return &s->subs[i];
+    }
+    return NULL;
+}
+
+/* Write one MSG or HMSG for sub */
+static void deliver(nats_standin_t *s, sub_t *sub, const char *subject, const char *reply,
+                    const char *data, size_t hdr_len, size_t total_len) {
+    client_t *c = sub->client;
+    char line[MAX_LINE + 128];
+    int n;
+    const char *sep = reply && *reply ? " " : "";
+    const char *rep = reply ? reply : "";
+    if (hdr_len > 0 && c->headers) {
+        n = snprintf(line, sizeof(line), "HMSG %s %s%s%s %zu %zu\r\n",
+                     subject, sub->sid, sep, rep, hdr_len, total_len);
+    } else {
+        /* A client without header support gets the payload alone */
+        data += hdr_len;
+        total_len -= hdr_len;
+        n = snprintf(line, sizeof(line), "MSG %s %s%s%s %zu\r\n", subject, sub->sid, sep, rep, total_len);
+    }
+    if (n < 0 || (size_t)n >= sizeof(line)) return;
+    queue_out(s, c, line, (size_t)n);
+    queue_out(s, c, data, total_len);
+    queue_out(s, c, "\r\n", 2U);
+    count(&s->msgs_out, 1);
+    count(&s->bytes_out, total_len);
+
+    if (sub->max > 0 && ++sub->delivered >= sub->max) {
+        sub_release(s, sub);
+    }
+}
+
+static void respond_schedule(nats_standin_t *s, const char *subject, const char *reply);
+
+/* Route one published message to its subscribers and the responder */
+static void route_message(nats_standin_t *s, const char *subject, const char *reply,
+                          const char *data, size_t hdr_len, size_t total_len) {
+    size_t ncand = 0;
+    size_t nsubs = s->nsubs;         /* Delivery never adds subscriptions */
+    for (size_t i = 0; i < nsubs; i++) {
+        sub_t *sub = &s->subs[i];
+        if (!sub->client || sub->client->dead || !subject_matches(sub->subject, subject)) continue;
+        if (!sub->queue) {
+            deliver(s, sub, subject, reply, data, hdr_len, total_len);
+            continue;
+        }
+        if (ncand == s->candidates_cap) {
+            size_t cap = s->candidates_cap ? s->candidates_cap * 2U : 16U;
+            size_t *p = realloc(s->candidates, cap * sizeof(*p));
+            if (!p) continue;
+            s->candidates = p;
+            s->candidates_cap = cap;
+        }
+        s->candidates[ncand++] = i;
+    }
+
+    /* One member per queue group, picked at random */
+    for (size_t i = 0; i < ncand; i++) {
+        if (s->candidates[i] == SIZE_MAX) continue;
+        const char *group = s->subs[s->candidates[i]].queue;
+        size_t members = 0;
+        for (size_t j = i; j < ncand; j++) {
+            if (s->candidates[j] != SIZE_MAX && strcmp(s->subs[s->candidates[j]].queue, group) == 0) {
+                members++;
+            }
+        }
+        size_t pick = (size_t)(rng_next(&s->rng) % members);
+        size_t chosen = SIZE_MAX;
+        for (size_t j = i; j < ncand; j++) {
+            if (s->candidates[j] == SIZE_MAX || strcmp(s->subs[s->candidates[j]].queue, group) != 0) continue;
+            if (pick-- == 0) chosen = s->candidates[j];
+            if (j > i) s->candidates[j] = SIZE_MAX;
+        }
+        s->candidates[i] = SIZE_MAX;
+        deliver(s, &s->subs[chosen], subject, reply, data, hdr_len, total_len);
+    }
+
+    if (s->config.responder && reply && *reply && subject_matches(s->responder_subject, subject)) {
+        respond_schedule(s, subject, reply);
+    }
+}
+
+/* ---------------- Responder ---------------- */
+
+static void timer_arm(nats_standin_t *s) {
+    uint64_t due = s->heap_len > 0 ? s->heap[0].due_us : 0;
+    if (due == s->armed_us) return;
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    if (due > 0) {
+        its.it_value.tv_sec = (time_t)(due / 1000000ULL);
+        its.it_value.tv_nsec = (long)(due % 1000000ULL) * 1000L;
+    }
+    (void)timerfd_settime(s->timer_fd, TFD_TIMER_ABSTIME, &its, NULL);
+    s->armed_us = due;
+}
+
+static void heap_push(nats_standin_t *s, pending_reply_t item) {
+    size_t i = s->heap_len++;
+    while (i > 0) {
+        size_t parent = (i - 1U) / 2U;
+        if (s->heap[parent].due_us <= item.due_us) break;
+        s->heap[i] = s->heap[parent];
+        i = parent;
+    }
+    s->heap[i] = item;
+}
+
+static void heap_pop(nats_standin_t *s) {
+    pending_reply_t last = s->heap[--s->heap_len];
+    size_t i = 0;
+    for (;;) {
+        size_t child = i * 2U + 1U;
+        if (child >= s->heap_len) break;
+        if (child + 1U < s->heap_len && s->heap[child + 1U].due_us < s->heap[child].due_us) child++;
+        if (last.due_us <= s->heap[child].due_us) break;
+        s->heap[i] = s->heap[child];
+        i = child;
+    }
+    if (s->heap_len > 0) s->heap[i] = last;
+}
+
+static int scratch_reserve(nats_standin_t *s, size_t size) {
+    if (size <= s->scratch_cap) return 0;
+    size_t cap = s->scratch_cap ? s->scratch_cap : 1024U;
+    while (cap < size) cap *= 2U;
+    char *p = realloc(s->scratch, cap);
+    if (!p) return -1;
+    s->scratch = p;
+    s->scratch_cap = cap;
+    return 0;
+}
+
+/* Build the answer in scratch; returns its length, 0 on error */
+static size_t build_answer(nats_standin_t *s, const pending_reply_t *r) {
+    char head[512];
+    int n;
+    if (r->ingest && r->error) {
+        n = snprintf(head, sizeof(head),
+                     "{\"error\":{\"code\":503,\"description\":\"injected by nats-standin\"}");
+    } else if (r->ingest) {
+        n = snprintf(head, sizeof(head), "{\"stream\":\"STANDIN\",\"seq\":%llu",
+                     (unsigned long long)++s->ack_seq);
+    } else if (r->error) {
+        n = snprintf(head, sizeof(head),
+                     "{\"ok\":false,\"error\":{\"code\":\"internal\",\"message\":\"injected by nats-standin\","
+                     "\"intake_error_code\":null}");
+    } else {
+        n = snprintf(head, sizeof(head),
+                     "{\"ok\":true,\"message_id\":\"standin-%llu\",\"provider_id\":\"provider-1\","
+                     "\"reason\":\"standin\",\"priority\":1,\"expected_latency_ms\":1,"
+                     "\"expected_cost\":0.001,\"currency\":\"USD\"",
+                     (unsigned long long)++s->answer_seq);
+    }
+    if (n < 0 || (size_t)n >= sizeof(head)) return 0;
+    size_t len = (size_t)n;
+    /* ,"padding":"xxx"} brings a successful answer up to response_bytes */
+    size_t pad = 0;
+    if (!r->error && s->config.response_bytes > len + 14U) {
+        pad = s->config.response_bytes - len - 14U;
+    }
+    if (scratch_reserve(s, len + pad + 16U) != 0) return 0;
+    memcpy(s->scratch, head, len);
+    if (pad > 0) {
+        memcpy(s->scratch + len, ",\"padding\":\"", 12U);
+        len += 12U;
+        memset(s->scratch + len, 'x', pad);
+        len += pad;
+        s->scratch[len++] = '"';
+    }
+    s->scratch[len++] = '}';
+    return len;
+}
+
+static void respond_now(nats_standin_t *s, const pending_reply_t *r) {
+    size_t len = build_answer(s, r);
+    if (len == 0) return;
+    count(&s->responses, 1);
+    route_message(s, r->reply, NULL, s->scratch, 0, len);
+}
+
+static void respond_schedule(nats_standin_t *s, const char *subject, const char *reply) {
+    count(&s->requests, 1);
+    pending_reply_t r;
+    memset(&r, 0, sizeof(r));
+    r.ingest = strstr(subject, ".ingest.") != NULL;
+    if (s->config.error_rate > 0.0 && rng_unit(&s->rng) <= s->config.error_rate) {
+        r.error = 1;
+        count(&s->errors_injected, 1);
+    }
+    uint64_t delay = nats_standin_sample_latency(&s->config.latency, &s->rng);
+    if (delay == 0) {
+        r.reply = (char *)(uintptr_t)reply;
+        respond_now(s, &r);
+        return;
+    }
+    if (s->heap_len == s->heap_cap) {
+        size_t cap = s->heap_cap ? s->heap_cap * 2U : 256U;
+        pending_reply_t *p = realloc(s->heap, cap * sizeof(*p));
+        if (!p) return;
+        s->heap = p;
+        s->heap_cap = cap;
+    }
+    r.reply = strdup(reply);
+    if (!r.reply) return;
+    r.due_us = monotonic_us() + delay;
+    heap_push(s, r);
+    timer_arm(s);
+}
+
+static void respond_due(nats_standin_t *s) {
+    uint64_t expirations;
+    (void)read(s->timer_fd, &expirations, sizeof(expirations));
+    s->armed_us = 0;
+    uint64_t now = monotonic_us();
+    while (s->heap_len > 0 && s->heap[0].due_us <= now) {
+        pending_reply_t r = s->heap[0];
+        heap_pop(s);
+        respond_now(s, &r);
+        free(r.reply);
+    }
+    timer_arm(s);
+}
+
+/* ---------------- Protocol ---------------- */
+
+static void protocol_error(nats_standin_t *s, client_t *c, const char *message) {
+    char line[128];
+    int n = snprintf(line, sizeof(line), "-ERR '%s'\r\n", message);
+    count(&s->protocol_errors, 1);
+    if (n > 0 && (size_t)n < sizeof(line)) queue_out(s, c, line, (size_t)n);
+    flush_client(s, c);
+    c->dead = 1;
+}
+
+static void ok(nats_standin_t *s, client_t *c) {
+    if (c->verbose) queue_str(s, c, "+OK\r\n");
+}
+
+static size_t split(char *line, char **tokens) {
+    size_t n = 0;
+    char *save = NULL;
+    for (char *tok = strtok_r(line, " \t", &save); tok && n < MAX_TOKENS; tok = strtok_r(NULL, " \t", &save)) {
+        tokens[n++] = tok;
+    }
+    return n;
+}
+
+static int parse_size(const char *text, size_t *out) {
+    char *end = NULL;
+    errno = 0;
+    unsigned long long v = strtoull(text, &end, 10);
+    if (errno != 0 || *end != '\0' || text[0] == '-' || text[0] == '\0') return -1;
+    *out = (size_t)v;
+    return 0;
+}
+
+static int json_flag(const char *json, const char *key) {
+    const char *p = strstr(json, key);
+    if (!p) return 0;
+    p += strlen(key);
+    while (*p == ' ' || *p == ':') p++;
+    return strncmp(p, "true", 4) == 0;
+}
+
+/*
+ * Handle the complete operations at the start of c->in.
+ * Returns the bytes consumed.
+ */
+static size_t parse_input(nats_standin_t *s, client_t *c) {
+    size_t off = 0;
+    while (!c->dead && off < c->in_len) {
+        char *start = c->in + off;
+        size_t avail = c->in_len - off;
+        char *nl = memchr(start, '\n', avail);
+        if (!nl) {
+            if (avail > MAX_LINE) protocol_error(s, c, "Maximum Control Line Exceeded");
+            break;
+        }
+        size_t line_len = (size_t)(nl - start);
+        size_t next = line_len + 1U;
+        if (line_len > 0 && start[line_len - 1U] == '\r') line_len--;
+        if (line_len > MAX_LINE) {
+            protocol_error(s, c, "Maximum Control Line Exceeded");
+            break;
+        }
+
+        char line[MAX_LINE + 1];
+        memcpy(line, start, line_len);
+        line[line_len] = '\0';
+        char *tokens[MAX_TOKENS];
+        size_t ntok = split(line, tokens);
+        if (ntok == 0) {
+            off += next;
+            continue;
+        }
+        const char *op = tokens[0];
+
+        if (strcasecmp(op, "PUB") == 0 || strcasecmp(op, "HPUB") == 0) {
+            int with_headers = strcasecmp(op, "HPUB") == 0;
+            size_t fixed = with_headers ? 4U : 3U;       /* Tokens without a reply */
+            if (ntok != fixed && ntok != fixed + 1U) {
+                protocol_error(s, c, "Unknown Protocol Operation");
+                break;
+            }
+            const char *reply = ntok == fixed + 1U ? tokens[2] : NULL;
+            size_t hdr_len = 0;
+            size_t total_len = 0;
+            if (parse_size(tokens[ntok - 1U], &total_len) != 0 ||
+                (with_headers && (parse_size(tokens[ntok - 2U], &hdr_len) != 0 || hdr_len > total_len))) {
+                protocol_error(s, c, "Unknown Protocol Operation");
+                break;
+            }
+            if (total_len > s->config.max_payload) {
+                protocol_error(s, c, "Maximum Payload Violation");
+                break;
+            }
+            if (avail < next + total_len + 2U) break;   /* Payload not all here */
+            count(&s->msgs_in, 1);
+            count(&s->bytes_in, total_len);
+            route_message(s, tokens[1], reply, start + next, hdr_len, total_len);
+            ok(s, c);
+            off += next + total_len + 2U;
+            continue;
+        }
+
+        if (strcasecmp(op, "PING") == 0) {
+            queue_str(s, c, "PONG\r\n");
+        } else if (strcasecmp(op, "PONG") == 0) {
+            /* Our PINGs are never sent; nothing to do */
+        } else if (strcasecmp(op, "CONNECT") == 0) {
+            /* line was cut up by split(); read the options from the input */
+            char opts[MAX_LINE + 1];
+            memcpy(opts, start, line_len);
+            opts[line_len] = '\0';
+            c->verbose = json_flag(opts, "\"verbose\"");
+            c->headers = json_flag(opts, "\"headers\"");
+            ok(s, c);
+        } else if (strcasecmp(op, "SUB") == 0) {
+            if (ntok != 3U && ntok != 4U) {
+                protocol_error(s, c, "Unknown Protocol Operation");
+                break;
+            }
+            const char *queue = ntok == 4U ? tokens[2] : NULL;
+            if (sub_add(s, c, tokens[1], queue, tokens[ntok - 1U]) != 0) {
+                protocol_error(s, c, "Invalid Subscription");
+                break;
+            }
+            ok(s, c);
+        } else if (strcasecmp(op, "UNSUB") == 0) {
+            if (ntok != 2U && ntok != 3U) {
+                protocol_error(s, c, "Unknown Protocol Operation");
+                break;
+            }
+            sub_t *sub = sub_find(s, c, tokens[1]);
+            size_t max = 0;
+            if (ntok == 3U && parse_size(tokens[2], &max) != 0) {
+                protocol_error(s, c, "Unknown Protocol Operation");
+                break;
+            }
+            if (sub) {
+                sub->max = max;
+                if (max == 0 || sub->delivered >= max) sub_release(s, sub);
+            }
+            ok(s, c);
+        } else {
+            protocol_error(s, c, "Unknown Protocol Operation");
+            break;
+        }
+        off += next;
+    }
+    return off;
+}
+
+/* ---------------- Connections ---------------- */
+
+static void client_close(nats_standin_t *s, client_t *c) {
+    for (size_t i = 0; i < s->nsubs; i++) {
+        if (s->subs[i].client == c) sub_release(s, &s->subs[i]);
+    }
+    (void)epoll_ctl(s->epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    free(c->in);
+    free(c->out);
+    free(c);
+    atomic_fetch_sub_explicit(&s->nclients, 1U, memory_order_relaxed);
+}
+
+static void accept_clients(nats_standin_t *s) {
+    for (;;) {
+        int fd = accept4(s->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        if (atomic_load_explicit(&s->nclients, memory_order_relaxed) >= (uint64_t)s->config.max_clients) {
+            close(fd);
+            continue;
+        }
+        int one = 1;
+        (void)setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        client_t *c = calloc(1, sizeof(*c));
+        if (!c) {
+            close(fd);
+            continue;
+        }
+        c->fd = fd;
+        c->id = ++s->next_client_id;
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.ptr = c;
+        if (epoll_ctl(s->epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            close(fd);
+            free(c);
+            continue;
+        }
+        c->next = s->clients;
+        s->clients = c;
+        count(&s->connections, 1);
+        count(&s->nclients, 1);
+
+        char info[512];
+        int n = snprintf(info, sizeof(info),
+                         "INFO {\"server_id\":\"NATSSTANDIN\",\"server_name\":\"nats-standin\","
+                         "\"version\":\"2.10.0\",\"proto\":1,\"go\":\"none\",\"host\":\"%s\",\"port\":%u,"
+                         "\"headers\":true,\"max_payload\":%zu,\"client_id\":%llu}\r\n",
+                         s->host, (unsigned)s->port, s->config.max_payload,
+                         (unsigned long long)c->id);
+        if (n > 0 && (size_t)n < sizeof(info)) queue_out(s, c, info, (size_t)n);
+    }
+}
+
+static void read_client(nats_standin_t *s, client_t *c) {
+    while (!c->dead) {
+        if (c->in_cap - c->in_len < READ_CHUNK / 4U) {
+            size_t cap = c->in_cap ? c->in_cap * 2U : READ_CHUNK;
+            if (cap > s->config.max_payload * 2U + READ_CHUNK * 2U) {
+                protocol_error(s, c, "Maximum Payload Violation");
+                return;
+            }
+            char *p = realloc(c->in, cap);
+            if (!p) {
+                c->dead = 1;
+                return;
+            }
+            c->in = p;
+            c->in_cap = cap;
+        }
+        ssize_t n = recv(c->fd, c->in + c->in_len, c->in_cap - c->in_len, 0);
+        if (n > 0) {
+            c->in_len += (size_t)n;
+            size_t used = parse_input(s, c);
+            if (used > 0) {
+                memmove(c->in, c->in + used, c->in_len - used);
+                c->in_len -= used;
+            }
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        c->dead = 1;                 /* Peer closed or failed */
+        return;
+    }
+}
+
+/* Write what the pass queued, then close the clients that died in it */
+static void end_pass(nats_standin_t *s) {
+    while (s->dirty) {
+        client_t *c = s->dirty;
+        s->dirty = c->next_dirty;
+        c->dirty = 0;
+        if (!c->want_write) flush_client(s, c);
+    }
+    client_t **link = &s->clients;
+    while (*link) {
+        client_t *c = *link;
+        if (c->dead) {
+            *link = c->next;
+            client_close(s, c);
+        } else {
+            link = &c->next;
+        }
+    }
+    subs_compact(s);
+}
+
+static void *standin_main(void *arg) {
+    nats_standin_t *s = (nats_standin_t *)arg;
+    struct epoll_event events[MAX_EVENTS];
+    while (!atomic_load(&s->stopping)) {
+        int n = epoll_wait(s->epoll_fd, events, MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            void *ptr = events[i].data.ptr;
+            if (ptr == &s->listen_fd) {
+                accept_clients(s);
+            } else if (ptr == &s->timer_fd) {
+                respond_due(s);
+            } else if (ptr == &s->wake_fd) {
+                /* Stop; checked by the loop */
+            } else {
+                client_t *c = (client_t *)ptr;
+                if (c->dead) continue;
+                if (events[i].events & EPOLLOUT) flush_client(s, c);
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) read_client(s, c);
+            }
+        }
+        end_pass(s);
+    }
+    return NULL;
+}
+
+static int watch(nats_standin_t *s, int fd, void *ptr) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = ptr;
+    return epoll_ctl(s->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+static void standin_free(nats_standin_t *s) {
+    while (s->clients) {
+        client_t *c = s->clients;
+        s->clients = c->next;
+        client_close(s, c);
+    }
+    for (size_t i = 0; i < s->nsubs; i++) {
+        if (s->subs[i].client) sub_release(s, &s->subs[i]);
+    }
+    for (size_t i = 0; i < s->heap_len; i++) free(s->heap[i].reply);
+    if (s->listen_fd >= 0) close(s->listen_fd);
+    if (s->epoll_fd >= 0) close(s->epoll_fd);
+    if (s->wake_fd >= 0) close(s->wake_fd);
+    if (s->timer_fd >= 0) close(s->timer_fd);
+    free(s->subs);
+    free(s->candidates);
+    free(s->heap);
+    free(s->scratch);
+    free(s);
+}
+
+nats_standin_t *nats_standin_create(const nats_standin_config_t *config) {
+    if (!config || !config->host || config->max_clients < 1 || config->max_payload == 0 ||
+        config->max_pending == 0 || !(config->error_rate >= 0.0 && config->error_rate <= 1.0) ||
+        !(config->latency.sigma >= 0.0) ||
+        !(config->latency.slow_ratio >= 0.0 && config->latency.slow_ratio <= 1.0) ||
+        (config->responder && (!config->responder_subject || !*config->responder_subject))) {
+        return NULL;
+    }
+    nats_standin_t *s = calloc(1, sizeof(*s));
+    if (!s) return NULL;
+    s->config = *config;
+    s->listen_fd = -1;
+    s->epoll_fd = -1;
+    s->wake_fd = -1;
+    s->timer_fd = -1;
+    s->rng = config->seed ? config->seed : 0x9e3779b97f4a7c15ULL;
+    snprintf(s->host, sizeof(s->host), "%s", config->host);
+    if (config->responder) {
+        snprintf(s->responder_subject, sizeof(s->responder_subject), "%s", config->responder_subject);
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(config->port);
+    if (inet_pton(AF_INET, s->host, &addr.sin_addr) != 1) {
+        standin_free(s);
+        return NULL;
+    }
+    s->listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int one = 1;
+    if (s->listen_fd < 0 ||
+        setsockopt(s->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+        bind(s->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(s->listen_fd, 128) != 0) {
+        standin_free(s);
+        return NULL;
+    }
+    socklen_t addr_len = sizeof(addr);
+    if (getsockname(s->listen_fd, (struct sockaddr *)&addr, &addr_len) != 0) {
+        standin_free(s);
+        return NULL;
+    }
+    s->port = ntohs(addr.sin_port);
+
+    s->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    s->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    s->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (s->epoll_fd < 0 || s->wake_fd < 0 || s->timer_fd < 0 ||
+        watch(s, s->listen_fd, &s->listen_fd) != 0 ||
+        watch(s, s->wake_fd, &s->wake_fd) != 0 ||
+        watch(s, s->timer_fd, &s->timer_fd) != 0 ||
+        pthread_create(&s->thread, NULL, standin_main, s) != 0) {
+        standin_free(s);
+        return NULL;
+    }
+    return s;
+}
+
+uint16_t nats_standin_get_port(const nats_standin_t *s) {
+    return s ? s->port : 0;
+}
+
+void nats_standin_get_stats(nats_standin_t *s, nats_standin_stats_t *stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!s) return;
+    stats->connections = atomic_load_explicit(&s->connections, memory_order_relaxed);
+    stats->clients = atomic_load_explicit(&s->nclients, memory_order_relaxed);
+    stats->msgs_in = atomic_load_explicit(&s->msgs_in, memory_order_relaxed);
+    stats->msgs_out = atomic_load_explicit(&s->msgs_out, memory_order_relaxed);
+    stats->bytes_in = atomic_load_explicit(&s->bytes_in, memory_order_relaxed);
+    stats->bytes_out = atomic_load_explicit(&s->bytes_out, memory_order_relaxed);
+    stats->requests = atomic_load_explicit(&s->requests, memory_order_relaxed);
+    stats->responses = atomic_load_explicit(&s->responses, memory_order_relaxed);
+    stats->errors_injected = atomic_load_explicit(&s->errors_injected, memory_order_relaxed);
+    stats->slow_consumers = atomic_load_explicit(&s->slow_consumers, memory_order_relaxed);
+    stats->protocol_errors = atomic_load_explicit(&s->protocol_errors, memory_order_relaxed);
+}
+
+void nats_standin_destroy(nats_standin_t *s) {
+    if (!s) return;
+    atomic_store(&s->stopping, 1);
+    uint64_t one = 1;
+    (void)write(s->wake_fd, &one, sizeof(one));
+    pthread_join(s->thread, NULL);
+    standin_free(s);
+}
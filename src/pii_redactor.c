@@ -0,0 +1,409 @@
+/**
+ * pii_redactor.c - Sensitive key matching and streaming JSON redaction
+ *
+ * The automaton is a dense transition table: one row per trie node, one
+ * column per byte class (every byte that occurs in a name, letters
+ * folded, plus class 0 for all other bytes). Exact mode sends missing
+ * edges to an absorbing dead state; contains mode fills them from the
+ * failure links and marks a state accepting if any suffix of it is.
+ *
+ * The redaction pass only stops on structural bytes ('"' and brackets
+ * and commas, found 16 at a time with SSE2 when available). Keys are
+ * run through the automaton as they are read; a sensitive key's value
+ * is skipped and the mask written in its place. Everything else is
+ * moved as one run per mask, which is what makes writing over the input
+ * safe: in place, the input is first moved to the end of the buffer and
+ * the output then never overtakes the read position.
+ */
+
+#include "pii_redactor.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define MAX_STATES 65535U                /* States are uint16_t */
+
+struct pii_redactor_t {
+    pii_match_t match;
+    uint8_t cls[256];                    /* Byte to class */
+    size_t num_classes;
+    size_t num_states;
+    uint16_t dead;                       /* Exact mode only */
+    uint16_t *delta;                     /* num_states x num_classes */
+    uint8_t *accept;
+    size_t min_key;                      /* Shortest name */
+    char *mask;
+    size_t mask_len;
+};
+
+static unsigned char fold(unsigned char c) {
+    return c >= 'A' && c <= 'Z' ? (unsigned char)(c - 'A' + 'a') : c;
+}
+
+/* ---------------- Compilation ---------------- */
+
+pii_redactor_t *pii_redactor_create(const char *const *keys, size_t count, pii_match_t match,
+                                    const char *mask) {
+    if (!keys || count == 0 || !mask || mask[0] == '\0') return NULL;
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!keys[i] || keys[i][0] == '\0') return NULL;
+        for (const char *p = keys[i]; *p; p++) {
+            if ((unsigned char)*p >= 0x80U) return NULL;
+        }
+        total += strlen(keys[i]);
+    }
+    if (total + 2U > MAX_STATES) return NULL;
+
+    pii_redactor_t *r = calloc(1, sizeof(*r));
+    if (!r) return NULL;
+    r->match = match;
+    r->mask_len = strlen(mask);
+    r->mask = malloc(r->mask_len + 1U);
+    r->min_key = SIZE_MAX;
+
+    /* Classes: one per distinct folded byte of the names */
+    r->num_classes = 1;
+    for (size_t i = 0; i < count; i++) {
+        for (const unsigned char *p = (const unsigned char *)keys[i]; *p; p++) {
+            unsigned char c = fold(*p);
+            if (r->cls[c] == 0) r->cls[c] = (uint8_t)r->num_classes++;
+        }
+        size_t n = strlen(keys[i]);
+        if (n < r->min_key) r->min_key = n;
+    }
+    for (unsigned c = 'A'; c <= 'Z'; c++) r->cls[c] = r->cls[fold((unsigned char)c)];
+
+    /* Room for the trie plus the dead state */
+    size_t cap = total + 2U;
+    r->delta = calloc(cap * r->num_classes, sizeof(r->delta[0]));
+    r->accept = calloc(cap, 1);
+    uint16_t *fail = calloc(cap, sizeof(*fail));
+    uint16_t *queue = calloc(cap, sizeof(*queue));
+    if (!r->mask || !r->delta || !r->accept || !fail || !queue) {
+        free(fail);
+        free(queue);
+        pii_redactor_free(r);
+        return NULL;
+    }
+    memcpy(r->mask, mask, r->mask_len + 1U);
+
+    /* Trie; 0 in delta means "no edge" until the links are filled */
+    r->num_states = 1;
+    for (size_t i = 0; i < count; i++) {
+        size_t s = 0;
+        for (const unsigned char *p = (const unsigned char *)keys[i]; *p; p++) {
+            uint16_t *edge = &r->delta[s * r->num_classes + r->cls[*p]];
+            if (*edge == 0) *edge = (uint16_t)r->num_states++;
+            s = *edge;
+        }
+        r->accept[s] = 1;
+    }
+
+    if (match == PII_MATCH_EXACT) {
+        r->dead = (uint16_t)r->num_states++;
+        for (size_t s = 0; s < r->num_states; s++) {
+            for (size_t c = 0; c < r->num_classes; c++) {
+                uint16_t *edge = &r->delta[s * r->num_classes + c];
+                if (*edge == 0 || s == r->dead) *edge = r->dead;
+            }
+        }
+    } else {
+        /* Breadth-first, so a state's failure target is complete first */
+        size_t head = 0, tail = 0;
+        for (size_t c = 0; c < r->num_classes; c++) {
+            uint16_t t = r->delta[c];
+            if (t != 0) {
+                fail[t] = 0;
+                queue[tail++] = t;
+            }
+        }
+        while (head < tail) {
+            uint16_t s = queue[head++];
+            r->accept[s] |= r->accept[fail[s]];
+            for (size_t c = 0; c < r->num_classes; c++) {
+                uint16_t *edge = &r->delta[s * r->num_classes + c];
+                uint16_t via = r->delta[fail[s] * r->num_classes + c];
+                if (*edge != 0) {
+                    fail[*edge] = via;
+                    queue[tail++] = *edge;
+                } else {
+                    *edge = via;
+                }
+            }
+        }
+    }
+    free(fail);
+    free(queue);
+    return r;
+}
+
+void pii_redactor_free(pii_redactor_t *r) {
+    if (!r) return;
+    free(r->delta);
+    free(r->accept);
+    free(r->mask);
+    free(r);
+}
+
+/* ---------------- Matching ---------------- */
+
+static unsigned step(const pii_redactor_t *r, unsigned s, unsigned char c) {
+    return r->delta[s * r->num_classes + r->cls[c]];
+}
+
+/* Nothing more can change the answer */
+static int settled(const pii_redactor_t *r, unsigned s) {
+    return r->match == PII_MATCH_EXACT ? s == r->dead : r->accept[s] != 0;
+}
+
+int pii_redactor_matches(const pii_redactor_t *r, const char *text, size_t len) {
+    if (!r || (!text && len > 0)) return 0;
+    unsigned s = 0;
+    for (size_t i = 0; i < len && !settled(r, s); i++) {
+        s = step(r, s, (unsigned char)text[i]);
+    }
+    return r->accept[s] != 0;
+}
+
+size_t pii_redact_bound(const pii_redactor_t *r, size_t len) {
+    if (!r) return len;
+    /* Each masked member spends at least "k":v of input, and its value
+     * shrank to no less than one byte */
+    size_t member = r->min_key + 4U;
+    return len + (len / member + 1U) * (r->mask_len > 1U ? r->mask_len - 1U : 0U);
+}
+
+/* ---------------- Scanning ---------------- */
+
+/* Next '"' or '\\' at or after p (end if none) */
+static const char *find_string_special(const char *p, const char *end) {
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(const void *)p);
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)));
+        if (mask != 0) return p + __builtin_ctz((unsigned int)mask);
+        p += 16;
+    }
+#endif
+    while (p < end && *p != '"' && *p != '\\') p++;
+    return p;
+}
+
+/* Next structural byte ('"', brackets, ',') at or after p */
+static const char *find_structural(const char *p, const char *end) {
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i open_square = _mm_set1_epi8('[');
+    const __m128i close_square = _mm_set1_epi8(']');
+    const __m128i open_curly = _mm_set1_epi8('{');
+    const __m128i close_curly = _mm_set1_epi8('}');
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(const void *)p);
+        __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, comma)),
+                                   _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, open_square),
+                                                             _mm_cmpeq_epi8(v, close_square)),
+                                                _mm_or_si128(_mm_cmpeq_epi8(v, open_curly),
+                                                             _mm_cmpeq_epi8(v, close_curly))));
+        int mask = _mm_movemask_epi8(hit);
+        if (mask != 0) return p + __builtin_ctz((unsigned int)mask);
+        p += 16;
+    }
+#endif
+    while (p < end && *p != '"' && *p != ',' && *p != '[' && *p != ']' && *p != '{' && *p != '}') p++;
+    return p;
+}
+
+/* Past the string starting at p (a '"'), NULL if unterminated */
+static const char *string_end(const char *p, const char *end) {
+    p++;
+    for (;;) {
+        p = find_string_special(p, end);
+        if (p >= end) return NULL;
+        if (*p == '"') return p + 1;
+        if (end - p < 2) return NULL;
+        p += 2;
+    }
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/* Run the key string at p through the automaton; returns the position
+ * past it (NULL if malformed) and whether it matched */
+static const char *scan_key(const pii_redactor_t *r, const char *p, const char *end, int *sensitive) {
+    unsigned s = 0;
+    p++;
+    while (p < end && *p != '"') {
+        if (settled(r, s)) break;
+        unsigned char c = (unsigned char)*p++;
+        if (c == '\\') {
+            if (p >= end) return NULL;
+            char e = *p++;
+            switch (e) {
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 'n': c = '\n'; break;
+                case 'r': c = '\r'; break;
+                case 't': c = '\t'; break;
+                case 'u': {
+                    if (end - p < 4) return NULL;
+                    int v = 0;
+                    for (int i = 0; i < 4; i++) {
+                        int d = hex_digit(p[i]);
+                        if (d < 0) return NULL;
+                        v = v * 16 + d;
+                    }
+                    p += 4;
+                    c = (unsigned char)(v < 0x80 ? v : 0x80);   /* Names are ASCII */
+                    break;
+                }
+                default: c = (unsigned char)e; break;
+            }
+        }
+        s = step(r, s, c);
+    }
+    *sensitive = r->accept[s] != 0;
+    /* Whatever is left of the key cannot change the answer */
+    return p < end && *p == '"' ? p + 1 : string_end(p - 1, end);
+}
+
+static const char *skip_ws(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) p++;
+    return p;
+}
+
+/* Past the value starting at p, NULL if malformed */
+static const char *value_end(const char *p, const char *end) {
+    if (p >= end) return NULL;
+    if (*p == '"') return string_end(p, end);
+    if (*p == '{' || *p == '[') {
+        int depth = 0;
+        do {
+            p = find_structural(p, end);
+            if (p >= end) return NULL;
+            if (*p == '"') {
+                p = string_end(p, end);
+                if (!p) return NULL;
+                continue;
+            }
+            if (*p == '{' || *p == '[') depth++;
+            else if (*p == '}' || *p == ']') depth--;
+            p++;
+        } while (depth > 0);
+        return p;
+    }
+    const char *start = p;
+    while (p < end && *p != ',' && *p != '}' && *p != ']' && *p != ' ' && *p != '\t' &&
+           *p != '\n' && *p != '\r') {
+        p++;
+    }
+    return p > start ? p : NULL;
+}
+
+/* ---------------- Redaction ---------------- */
+
+typedef struct {
+    char *out;
+    size_t pos;
+    size_t cap;
+    int in_place;                        /* out lies before the input in one buffer */
+} writer_t;
+
+/* Append n bytes; src may be inside the input, read is how far the
+ * input has been consumed */
+static int emit(writer_t *w, const char *src, size_t n, const char *read) {
+    if (n > w->cap - w->pos) return -1;
+    if (w->in_place && w->out + w->pos + n > read) return -1;
+    memmove(w->out + w->pos, src, n);
+    w->pos += n;
+    return 0;
+}
+
+static int redact(const pii_redactor_t *r, const char *json, size_t len, writer_t *w) {
+    const char *p = json;
+    const char *end = json + len;
+    const char *run = p;                 /* Input not yet written */
+    uint64_t objects[PII_REDACT_MAX_DEPTH / 64] = { 0 };
+    int depth = 0;
+    int expect_key = 0;
+
+    for (;;) {
+        p = find_structural(p, end);
+        if (p >= end) break;
+        char c = *p;
+        if (c == '{' || c == '[') {
+            if (depth == PII_REDACT_MAX_DEPTH) return -1;
+            uint64_t bit = 1ULL << (depth % 64);
+            if (c == '{') objects[depth / 64] |= bit;
+            else objects[depth / 64] &= ~bit;
+            depth++;
+            expect_key = c == '{';
+            p++;
+        } else if (c == '}' || c == ']') {
+            if (depth == 0) return -1;
+            depth--;
+            int was_object = (int)((objects[depth / 64] >> (depth % 64)) & 1U);
+            if (was_object != (c == '}')) return -1;
+            expect_key = 0;
+            p++;
+        } else if (c == ',') {
+            expect_key = depth > 0 && ((objects[(depth - 1) / 64] >> ((depth - 1) % 64)) & 1U) != 0;
+            p++;
+        } else if (!expect_key) {
+            p = string_end(p, end);
+            if (!p) return -1;
+        } else {
+            int sensitive = 0;
+            p = scan_key(r, p, end, &sensitive);
+            if (!p) return -1;
+            expect_key = 0;
+            if (!sensitive) continue;
+            p = skip_ws(p, end);
+            if (p >= end || *p != ':') return -1;
+            p = skip_ws(p + 1, end);
+            if (emit(w, run, (size_t)(p - run), p) != 0) return -1;
+            p = value_end(p, end);
+            if (!p) return -1;
+            if (emit(w, r->mask, r->mask_len, p) != 0) return -1;
+            run = p;
+        }
+    }
+    if (depth != 0) return -1;
+    return emit(w, run, (size_t)(end - run), end);
+}
+
+int pii_redact(const pii_redactor_t *r, const char *json, size_t len, char *out, size_t out_size,
+               size_t *out_len) {
+    if (!r || (!json && len > 0) || !out) return -1;
+    writer_t w = { out, 0, out_size, 0 };
+    if (redact(r, json, len, &w) != 0) {
+        if (out_size > 0) out[0] = '\0';
+        return -1;
+    }
+    if (w.pos < out_size) out[w.pos] = '\0';
+    if (out_len) *out_len = w.pos;
+    return 0;
+}
+
+int pii_redact_in_place(const pii_redactor_t *r, char *buf, size_t len, size_t cap, size_t *out_len) {
+    if (!r || !buf || len > cap) return -1;
+    char *in = buf + (cap - len);
+    memmove(in, buf, len);
+    writer_t w = { buf, 0, cap, 1 };
+    if (redact(r, in, len, &w) != 0) return -1;
+    if (w.pos < cap) buf[w.pos] = '\0';
+    if (out_len) *out_len = w.pos;
+    return 0;
+}
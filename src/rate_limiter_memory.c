@@ -9,6 +9,7 @@
 #include <string.h>
 #include <time.h>
 #include <stdio.h>
+#include <pthread.h>
 
 #define MAX_ENDPOINTS RL_ENDPOINT_MAX
 
@@ -20,6 +21,7 @@ typedef struct {
     int limits[MAX_ENDPOINTS];
     unsigned long total_hits;
     unsigned long total_exceeded;
+    pthread_mutex_t lock;  /* checks arrive concurrently from reactor threads */
 } memory_rl_state_t;
 
 /* Get endpoint limit */
@@ -74,6 +76,7 @@ static int memory_rl_init(rate_limiter_t *self, const distributed_rl_config_t *c
     
     state->ttl_seconds = get_ttl_seconds();
     state->window_started_at = 0;
+    pthread_mutex_init(&state->lock, NULL);
     
     /* Initialize limits for each endpoint */
     for (int i = 0; i < MAX_ENDPOINTS; i++) {
@@ -97,8 +100,12 @@ static rl_result_t memory_rl_check(rate_limiter_t *self,
     memory_rl_state_t *state = (memory_rl_state_t *)self->internal;
     if (!state) return RL_ERROR;
     
+    if (endpoint >= MAX_ENDPOINTS) return RL_ERROR;
+    
     time_t now = time(NULL);
     
+    pthread_mutex_lock(&state->lock);
+    
     /* Reset window if expired */
     if (state->window_started_at == 0 || 
         (now - state->window_started_at) >= state->ttl_seconds) {
@@ -108,8 +115,6 @@ static rl_result_t memory_rl_check(rate_limiter_t *self,
         }
     }
     
-    if (endpoint >= MAX_ENDPOINTS) return RL_ERROR;
-    
     int limit = state->limits[endpoint];
     unsigned int current = state->counters[endpoint];
     
@@ -119,14 +124,17 @@ static rl_result_t memory_rl_check(rate_limiter_t *self,
     if (current >= (unsigned int)limit) {
         /* Rate limit exceeded */
         state->total_exceeded++;
+        pthread_mutex_unlock(&state->lock);
         if (remaining_out) *remaining_out = 0;
         return RL_EXCEEDED;
     }
     
     /* Increment counter */
     state->counters[endpoint]++;
+    unsigned int remaining = (unsigned int)limit - state->counters[endpoint];
+    pthread_mutex_unlock(&state->lock);
     if (remaining_out) {
-        *remaining_out = (unsigned int)limit - state->counters[endpoint];
+        *remaining_out = remaining;
     }
     return RL_ALLOWED;
 }
@@ -134,6 +142,8 @@ static rl_result_t memory_rl_check(rate_limiter_t *self,
 /* Cleanup memory rate limiter */
 static void memory_rl_cleanup(rate_limiter_t *self) {
     if (self && self->internal) {
+        memory_rl_state_t *state = (memory_rl_state_t *)self->internal;
+        pthread_mutex_destroy(&state->lock);
         free(self->internal);
         self->internal = NULL;
     }
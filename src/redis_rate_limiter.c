@@ -12,6 +12,7 @@
 
 #include "redis_rate_limiter.h"
 #include "metrics/prometheus.h"
+#include "log_pipeline.h"
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
@@ -22,32 +23,32 @@
 #include <pthread.h>
 #include <stdarg.h>
 
-/* JSON logging helper */
+/* JSON logging helper: the line is formatted and written on the log thread */
+static size_t format_log_event(const log_record_t *rec, char *out, size_t cap) {
+    log_line_t l = { out, cap, 0 };
+    log_line_raw(&l, "{\"timestamp\":");
+    log_line_timestamp(&l, rec->ts_us, 3);
+    log_line_raw(&l, ",\"level\":");
+    log_line_value(&l, &rec->values[0]);
+    log_line_raw(&l, ",\"component\":\"c-gateway\",\"subsystem\":");
+    log_line_value(&l, &rec->values[1]);
+    log_line_raw(&l, ",\"message\":");
+    log_line_value(&l, &rec->values[2]);
+    log_line_raw(&l, "}");
+    return log_line_end(&l);
+}
+
 static void log_json(const char *level, const char *subsystem, const char *message, ...) {
-    char log_buffer[2048] = {0};
     va_list args;
     va_start(args, message);
     
-    /* Get current timestamp */
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    time_t now = tv.tv_sec;
-    struct tm *tm_info = gmtime(&now);
-    char timestamp[64];
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S", tm_info);
-    snprintf(timestamp + strlen(timestamp), sizeof(timestamp) - strlen(timestamp), ".%03ldZ", tv.tv_usec / 1000);
-    
     /* Format message */
     char formatted_message[512];
     vsnprintf(formatted_message, sizeof(formatted_message), message, args);
     va_end(args);
     
-    /* Build JSON log */
-    snprintf(log_buffer, sizeof(log_buffer),
-        "{\"timestamp\":\"%s\",\"level\":\"%s\",\"component\":\"c-gateway\",\"subsystem\":\"%s\",\"message\":\"%s\"}",
-        timestamp, level, subsystem, formatted_message);
-    
-    fprintf(stderr, "%s\n", log_buffer);
+    log_value_t values[] = { LOG_STR(level), LOG_STR(subsystem), LOG_STR(formatted_message) };
+    (void)log_pipeline_write(log_pipeline_default(), STDERR_FILENO, format_log_event, values, 3);
 }
 
 /* Forward declarations for hiredis */
@@ -388,7 +389,7 @@ static cb_state_t cb_get_state(void) {
 }
 
 /* Execute Redis command with retries (simplified for Lua script) */
-static redisReply *__attribute__((unused)) execute_redis_lua_script(redisContext *conn, const char *script, const char *key, int window_sec) {
+static __attribute__((unused)) redisReply *execute_redis_lua_script(redisContext *conn, const char *script, const char *key, int window_sec) {
     (void)window_sec;  /* Parameter kept for API compatibility */
     if (!conn || !script || !key) return NULL;
     
@@ -0,0 +1,261 @@
+/**
+ * request_arena.c - Per-request bump allocator
+ *
+ * Chunks form a singly linked list. Allocation bumps a cursor in the
+ * current chunk and moves on to the next retained chunk (or mallocs a
+ * new one) when it does not fit. Reset rewinds to the first chunk and
+ * frees only the oversized ones, so steady-state requests reuse memory.
+ */
+
+#include "request_arena.h"
+#include <jansson.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGN 16U
+
+typedef struct arena_chunk_t {
+    struct arena_chunk_t *next;
+    size_t size;                     /* Usable bytes in data */
+    int oversized;                   /* Dedicated to one large allocation */
+    _Alignas(16) unsigned char data[];
+} arena_chunk_t;
+
+struct request_arena_t {
+    size_t chunk_size;
+    arena_chunk_t *head;
+    arena_chunk_t *current;
+    size_t offset;                   /* Next free byte in current */
+    void *last;                      /* Most recent allocation */
+    size_t last_offset;              /* Offset to rewind to when last is released */
+    size_t used;                     /* Bytes handed out in this scope */
+    request_arena_stats_t stats;
+};
+
+static size_t align_up(size_t n) {
+    return (n + (ARENA_ALIGN - 1U)) & ~(size_t)(ARENA_ALIGN - 1U);
+}
+
+static arena_chunk_t *chunk_new(size_t size, int oversized) {
+    arena_chunk_t *c = malloc(sizeof(arena_chunk_t) + size);
+    if (c) {
+        c->next = NULL;
+        c->size = size;
+        c->oversized = oversized;
+    }
+    return c;
+}
+
+request_arena_t *request_arena_create(size_t chunk_size) {
+    request_arena_t *arena = calloc(1, sizeof(request_arena_t));
+    if (!arena) {
+        return NULL;
+    }
+    arena->chunk_size = chunk_size ? align_up(chunk_size) : REQUEST_ARENA_CHUNK_SIZE;
+    arena->head = chunk_new(arena->chunk_size, 0);
+    if (!arena->head) {
+        free(arena);
+        return NULL;
+    }
+    arena->stats.chunk_allocs = 1;
+    arena->current = arena->head;
+    return arena;
+}
+
+void request_arena_destroy(request_arena_t *arena) {
+    if (!arena) return;
+    arena_chunk_t *c = arena->head;
+    while (c) {
+        arena_chunk_t *next = c->next;
+        free(c);
+        c = next;
+    }
+    free(arena);
+}
+
+void *request_arena_alloc(request_arena_t *arena, size_t size) {
+    if (!arena || size > SIZE_MAX - ARENA_ALIGN) {
+        return NULL;
+    }
+    size_t need = align_up(size ? size : 1U);
+
+    /* Walk forward through retained chunks until one fits */
+    while (arena->offset + need > arena->current->size) {
+        arena_chunk_t *next = arena->current->next;
+        if (next && !next->oversized && need <= next->size) {
+            arena->current = next;
+            arena->offset = 0;
+            continue;
+        }
+        int oversized = need > arena->chunk_size;
+        arena_chunk_t *c = chunk_new(oversized ? need : arena->chunk_size, oversized);
+        if (!c) {
+            return NULL;
+        }
+        arena->stats.chunk_allocs++;
+        c->next = arena->current->next;
+        arena->current->next = c;
+        arena->current = c;
+        arena->offset = 0;
+    }
+
+    void *p = arena->current->data + arena->offset;
+    arena->last = p;
+    arena->last_offset = arena->offset;
+    arena->offset += need;
+    arena->used += need;
+    arena->stats.allocations++;
+    return p;
+}
+
+void *request_arena_calloc(request_arena_t *arena, size_t n, size_t size) {
+    if (size != 0 && n > SIZE_MAX / size) {
+        return NULL;
+    }
+    void *p = request_arena_alloc(arena, n * size);
+    if (p) {
+        memset(p, 0, n * size);
+    }
+    return p;
+}
+
+void request_arena_release(request_arena_t *arena, void *ptr) {
+    if (arena && ptr && ptr == arena->last) {
+        arena->used -= arena->offset - arena->last_offset;
+        arena->offset = arena->last_offset;
+        arena->last = NULL;
+    }
+}
+
+int request_arena_owns(const request_arena_t *arena, const void *ptr) {
+    if (!arena || !ptr) {
+        return 0;
+    }
+    const unsigned char *p = ptr;
+    for (const arena_chunk_t *c = arena->head; c; c = c->next) {
+        if (p >= c->data && p < c->data + c->size) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void request_arena_reset(request_arena_t *arena) {
+    if (!arena) return;
+
+    /* Oversized chunks are one-offs; give them back */
+    arena_chunk_t *prev = arena->head;
+    arena_chunk_t *c = prev->next;
+    while (c) {
+        arena_chunk_t *next = c->next;
+        if (c->oversized) {
+            prev->next = next;
+            free(c);
+        } else {
+            prev = c;
+        }
+        c = next;
+    }
+
+    if (arena->used > arena->stats.high_water) {
+        arena->stats.high_water = arena->used;
+    }
+    arena->stats.resets++;
+    arena->current = arena->head;
+    arena->offset = 0;
+    arena->last = NULL;
+    arena->used = 0;
+}
+
+void request_arena_get_stats(const request_arena_t *arena, request_arena_stats_t *stats) {
+    if (!arena || !stats) return;
+    *stats = arena->stats;
+}
+
+/* ---------------- Thread request scope ---------------- */
+
+static _Thread_local request_arena_t *tls_arena = NULL;
+static _Thread_local int tls_in_scope = 0;
+
+static pthread_key_t arena_key;
+static pthread_once_t arena_key_once = PTHREAD_ONCE_INIT;
+
+static void arena_key_destroy(void *arena) {
+    request_arena_destroy(arena);
+}
+
+static void arena_key_create(void) {
+    (void)pthread_key_create(&arena_key, arena_key_destroy);
+}
+
+void request_arena_begin(void) {
+    if (tls_in_scope) {
+        return;
+    }
+    if (!tls_arena) {
+        tls_arena = request_arena_create(0);
+        if (!tls_arena) {
+            return;                  /* Scope stays closed: plain malloc */
+        }
+        /* Free the arena when the thread exits */
+        (void)pthread_once(&arena_key_once, arena_key_create);
+        (void)pthread_setspecific(arena_key, tls_arena);
+    }
+    tls_in_scope = 1;
+}
+
+void request_arena_end(void) {
+    if (!tls_in_scope) {
+        return;
+    }
+    tls_in_scope = 0;
+    request_arena_reset(tls_arena);
+}
+
+request_arena_t *request_arena_current(void) {
+    return tls_in_scope ? tls_arena : NULL;
+}
+
+void *request_arena_scratch_alloc(size_t size) {
+    if (tls_in_scope) {
+        return request_arena_alloc(tls_arena, size);
+    }
+    return malloc(size);
+}
+
+void *request_arena_scratch_calloc(size_t n, size_t size) {
+    if (tls_in_scope) {
+        return request_arena_calloc(tls_arena, n, size);
+    }
+    return calloc(n, size);
+}
+
+void request_arena_scratch_free(void *ptr) {
+    if (!ptr) {
+        return;
+    }
+    /* The arena outlives its scopes, so ownership is checked even after
+     * the scope closed (e.g. a value dropped after request_arena_end) */
+    if (tls_arena && request_arena_owns(tls_arena, ptr)) {
+        request_arena_release(tls_arena, ptr);
+        return;
+    }
+    free(ptr);
+}
+
+void *request_arena_scratch_detach(void *ptr, size_t size) {
+    if (!ptr || !tls_arena || !request_arena_owns(tls_arena, ptr)) {
+        return ptr;
+    }
+    void *copy = malloc(size);
+    if (copy) {
+        memcpy(copy, ptr, size);
+        request_arena_release(tls_arena, ptr);
+    }
+    return copy;
+}
+
+void request_arena_install_json(void) {
+    json_set_alloc_funcs(request_arena_scratch_alloc, request_arena_scratch_free);
+}
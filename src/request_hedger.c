@@ -0,0 +1,556 @@
+/**
+ * request_hedger.c - Hedged requests for idempotent Router calls
+ *
+ * Every request under a hedge threshold is linked on a list ordered by
+ * the time its hedge is due. Thresholds change slowly, so inserting from
+ * the newest end is close to an append. One thread sleeps until the
+ * earliest due time (or the next once-a-second threshold refresh),
+ * takes a hedge from the budget for each request still unanswered, and
+ * sends the second attempts with the mutex released.
+ *
+ * A request is freed once nothing can reach it any more: each attempt
+ * whose reply may still run, the due list, and any thread working on it
+ * outside the mutex hold a reference. An attempt's handle is only known
+ * once send returns, so the loser of a race that finished inside send
+ * is cancelled by whoever sent it.
+ */
+
+#define _GNU_SOURCE
+#include "request_hedger.h"
+#include "latency_histogram.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define REFRESH_US      1000000ULL       /* Threshold refresh interval */
+#define WINDOW_MS       60000            /* Latency window thresholds use */
+#define SLICE_MS        1000
+
+typedef struct {
+    char *name;
+    latency_histogram_t *latency;        /* Single attempts, successes only */
+    uint64_t threshold_us;               /* 0: not hedging */
+} subject_t;
+
+struct hedge_req;
+
+typedef struct {
+    struct hedge_req *req;
+    int index;                           /* 0: first attempt, 1: hedge */
+} attempt_t;
+
+typedef struct hedge_req {
+    request_hedger_t *owner;
+    subject_t *subject;
+    char *request;
+    request_hedger_reply_fn reply;
+    void *closure;
+    attempt_t attempts[2];
+    uint64_t sent_us[2];
+    uint64_t handle[2];
+    int has_handle[2];
+    int live[2];                         /* Reply may still run */
+    uint64_t hedge_at_us;
+    int queued;                          /* On the due list */
+    int done;                            /* Caller answered */
+    unsigned refs;
+    struct hedge_req *prev;
+    struct hedge_req *next;
+} hedge_req_t;
+
+struct request_hedger_t {
+    request_hedger_config_t config;
+    request_hedger_send_fn send;
+    request_hedger_cancel_fn cancel;
+    void *arg;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;                 /* Wakes the timer thread */
+    pthread_cond_t idle;                 /* live dropped to zero */
+    pthread_t thread;
+    int thread_running;
+    int stopping;
+
+    subject_t *subjects;
+    int nsubjects;
+    hedge_req_t *first;                  /* Due list, earliest first */
+    hedge_req_t *last;
+    uint64_t budget;                     /* Hundredths of a hedge */
+    uint64_t budget_max;
+    uint64_t next_refresh_us;
+    size_t live;                         /* Requests not yet freed */
+    latency_histogram_snapshot_t snap;   /* Timer thread only */
+    request_hedger_stats_t stats;
+};
+
+static int env_int(const char *name, int min_val, int def_val) {
+    const char *val = getenv(name);
+    if (val == NULL || *val == '\0') {
+        return def_val;
+    }
+    char *end = NULL;
+    long parsed = strtol(val, &end, 10);
+    if (*end != '\0' || parsed < min_val || parsed > 1000000) {
+        return def_val;
+    }
+    return (int)parsed;
+}
+
+static double env_percentile(const char *name, double def_val) {
+    const char *val = getenv(name);
+    if (val == NULL || *val == '\0') {
+        return def_val;
+    }
+    char *end = NULL;
+    double parsed = strtod(val, &end);
+    if (*end != '\0' || !(parsed >= 50.0 && parsed <= 99.9)) {
+        return def_val;
+    }
+    return parsed;
+}
+
+static uint64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+void request_hedger_get_default_config(request_hedger_config_t *config) {
+    if (!config) return;
+    config->budget_percent = 5;
+    config->burst = 10;
+    config->percentile = 95.0;
+    config->min_samples = 50;
+    config->min_delay_us = 1000;
+    config->max_subjects = 32;
+}
+
+int request_hedger_parse_config(request_hedger_config_t *config) {
+    if (!config) return -1;
+    config->budget_percent = env_int("GATEWAY_HEDGE_BUDGET_PERCENT", 0, config->budget_percent);
+    if (config->budget_percent > 100) config->budget_percent = 100;
+    config->burst = env_int("GATEWAY_HEDGE_BURST", 1, config->burst);
+    config->percentile = env_percentile("GATEWAY_HEDGE_PERCENTILE", config->percentile);
+    config->min_samples = env_int("GATEWAY_HEDGE_MIN_SAMPLES", 1, config->min_samples);
+    config->min_delay_us = env_int("GATEWAY_HEDGE_MIN_DELAY_MS", 0, config->min_delay_us / 1000) * 1000;
+    return 0;
+}
+
+/* ---------------- Due list (caller holds the mutex) ---------------- */
+
+static void due_insert(request_hedger_t *h, hedge_req_t *r) {
+    hedge_req_t *after = h->last;
+    while (after != NULL && after->hedge_at_us > r->hedge_at_us) {
+        after = after->prev;
+    }
+    r->prev = after;
+    r->next = after != NULL ? after->next : h->first;
+    if (r->next != NULL) r->next->prev = r; else h->last = r;
+    if (after != NULL) after->next = r; else h->first = r;
+    r->queued = 1;
+    r->refs++;
+}
+
+/* Unlink r; the caller takes over the list's reference */
+static void due_remove(request_hedger_t *h, hedge_req_t *r) {
+    if (r->prev != NULL) r->prev->next = r->next; else h->first = r->next;
+    if (r->next != NULL) r->next->prev = r->prev; else h->last = r->prev;
+    r->prev = NULL;
+    r->next = NULL;
+    r->queued = 0;
+}
+
+/* Drop one reference; returns r if it is now to be freed, outside the mutex */
+static hedge_req_t *unref(request_hedger_t *h, hedge_req_t *r) {
+    if (--r->refs > 0) return NULL;
+    if (--h->live == 0) pthread_cond_broadcast(&h->idle);
+    return r;
+}
+
+static void req_free(hedge_req_t *r) {
+    if (!r) return;
+    free(r->request);
+    free(r);
+}
+
+/* Caller holds the mutex; NULL when the subject table is full */
+static subject_t *subject_find(request_hedger_t *h, const char *name, int create) {
+    for (int i = 0; i < h->nsubjects; i++) {
+        if (strcmp(h->subjects[i].name, name) == 0) return &h->subjects[i];
+    }
+    if (!create || h->nsubjects >= h->config.max_subjects) return NULL;
+    latency_histogram_config_t hc = { SLICE_MS, WINDOW_MS / SLICE_MS };
+    subject_t *s = &h->subjects[h->nsubjects];
+    s->name = strdup(name);
+    s->latency = latency_histogram_create(&hc);
+    if (!s->name || !s->latency) {
+        free(s->name);
+        latency_histogram_destroy(s->latency);
+        memset(s, 0, sizeof(*s));
+        return NULL;
+    }
+    s->threshold_us = 0;
+    h->nsubjects++;
+    return s;
+}
+
+/* ---------------- Attempts ---------------- */
+
+/*
+ * Record attempt i's handle once its send has returned. If the request
+ * was answered meanwhile by the other attempt, this one lost and is
+ * cancelled by the caller; returns 1 then.
+ */
+static int attempt_sent(hedge_req_t *r, int i, uint64_t handle) {
+    r->handle[i] = handle;
+    r->has_handle[i] = 1;
+    return r->done && r->live[i];
+}
+
+/* Cancel the losing attempt i; drops its reference if it will never reply */
+static void attempt_cancel(request_hedger_t *h, hedge_req_t *r, int i) {
+    if (h->cancel(r->handle[i], h->arg) != 0) return;
+    pthread_mutex_lock(&h->mutex);
+    r->live[i] = 0;
+    h->stats.cancelled++;
+    if (i == 0 && r->subject) {
+        /* Still a sample: the first attempt took at least this long */
+        latency_histogram_record(r->subject->latency, monotonic_us() - r->sent_us[0]);
+    }
+    hedge_req_t *dead = unref(h, r);
+    pthread_mutex_unlock(&h->mutex);
+    req_free(dead);
+}
+
+static void on_attempt_reply(int status, const char *reply, void *closure) {
+    attempt_t *a = (attempt_t *)closure;
+    hedge_req_t *r = a->req;
+    request_hedger_t *h = r->owner;
+    int i = a->index;
+    int other = 1 - i;
+    uint64_t now = monotonic_us();
+
+    pthread_mutex_lock(&h->mutex);
+    r->live[i] = 0;
+    if (status == 0 && r->subject) {
+        latency_histogram_record(r->subject->latency, now - r->sent_us[i]);
+    }
+    /* Already answered, or failed while the other attempt may still win */
+    if (r->done || (status != 0 && r->live[other])) {
+        hedge_req_t *dead = unref(h, r);
+        pthread_mutex_unlock(&h->mutex);
+        req_free(dead);
+        return;
+    }
+    r->done = 1;
+    h->stats.in_flight--;
+    if (i == 1) h->stats.hedges_won++;
+    if (r->queued) {
+        due_remove(h, r);
+        r->refs--;                       /* Still held by this attempt */
+    }
+    int cancel_other = r->live[other] && r->has_handle[other];
+    pthread_mutex_unlock(&h->mutex);
+
+    r->reply(status, reply, r->closure);
+    if (cancel_other) attempt_cancel(h, r, other);
+
+    pthread_mutex_lock(&h->mutex);
+    hedge_req_t *dead = unref(h, r);
+    pthread_mutex_unlock(&h->mutex);
+    req_free(dead);
+}
+
+/* ---------------- Timer thread ---------------- */
+
+/* Recompute every subject's threshold from its latency window */
+static void refresh_thresholds(request_hedger_t *h) {
+    pthread_mutex_lock(&h->mutex);
+    int n = h->nsubjects;
+    pthread_mutex_unlock(&h->mutex);
+    for (int i = 0; i < n; i++) {
+        subject_t *s = &h->subjects[i];
+        uint64_t threshold = 0;
+        if (latency_histogram_snapshot(s->latency, WINDOW_MS, &h->snap) == 0 &&
+            h->snap.total >= (uint64_t)h->config.min_samples) {
+            threshold = latency_histogram_percentile(&h->snap, h->config.percentile);
+            if (threshold < (uint64_t)h->config.min_delay_us) threshold = (uint64_t)h->config.min_delay_us;
+        }
+        pthread_mutex_lock(&h->mutex);
+        s->threshold_us = threshold;
+        pthread_mutex_unlock(&h->mutex);
+    }
+}
+
+/* Send the hedge of r, whose reference the caller holds */
+static void send_hedge(request_hedger_t *h, hedge_req_t *r) {
+    uint64_t handle = 0;
+    int rc = h->send(r->subject->name, r->request, on_attempt_reply, &r->attempts[1], &handle, h->arg);
+    pthread_mutex_lock(&h->mutex);
+    int lost = 0;
+    if (rc != 0) {
+        r->live[1] = 0;
+        r->refs--;                       /* The attempt's; the caller's remains */
+        h->budget += 100U;
+    } else {
+        h->stats.hedges_sent++;
+        lost = attempt_sent(r, 1, handle);
+    }
+    pthread_mutex_unlock(&h->mutex);
+    if (lost) attempt_cancel(h, r, 1);
+}
+
+static void *hedger_main(void *arg) {
+    request_hedger_t *h = (request_hedger_t *)arg;
+    pthread_mutex_lock(&h->mutex);
+    while (!h->stopping) {
+        uint64_t now = monotonic_us();
+        if (now >= h->next_refresh_us) {
+            h->next_refresh_us = now + REFRESH_US;
+            pthread_mutex_unlock(&h->mutex);
+            refresh_thresholds(h);
+            pthread_mutex_lock(&h->mutex);
+            continue;
+        }
+
+        /* Take what is due; due_remove hands the list reference to us */
+        hedge_req_t *due = NULL;
+        while (h->first != NULL && h->first->hedge_at_us <= now) {
+            hedge_req_t *r = h->first;
+            due_remove(h, r);
+            if (r->done) {
+                hedge_req_t *dead = unref(h, r);
+                if (dead) {
+                    pthread_mutex_unlock(&h->mutex);
+                    req_free(dead);
+                    pthread_mutex_lock(&h->mutex);
+                }
+                continue;
+            }
+            if (h->budget < 100U) {
+                h->stats.budget_exhausted++;
+                hedge_req_t *dead = unref(h, r);
+                if (dead) {
+                    pthread_mutex_unlock(&h->mutex);
+                    req_free(dead);
+                    pthread_mutex_lock(&h->mutex);
+                }
+                continue;
+            }
+            h->budget -= 100U;
+            r->live[1] = 1;
+            r->sent_us[1] = now;
+            r->refs++;
+            r->next = due;
+            due = r;
+        }
+        if (due != NULL) {
+            pthread_mutex_unlock(&h->mutex);
+            while (due != NULL) {
+                hedge_req_t *r = due;
+                due = r->next;
+                r->next = NULL;
+                send_hedge(h, r);
+                pthread_mutex_lock(&h->mutex);
+                hedge_req_t *dead = unref(h, r);
+                pthread_mutex_unlock(&h->mutex);
+                req_free(dead);
+            }
+            pthread_mutex_lock(&h->mutex);
+            continue;
+        }
+
+        uint64_t wake_us = h->next_refresh_us;
+        if (h->first != NULL && h->first->hedge_at_us < wake_us) wake_us = h->first->hedge_at_us;
+        struct timespec ts;
+        ts.tv_sec = (time_t)(wake_us / 1000000ULL);
+        ts.tv_nsec = (long)(wake_us % 1000000ULL) * 1000L;
+        (void)pthread_cond_timedwait(&h->cond, &h->mutex, &ts);
+    }
+    pthread_mutex_unlock(&h->mutex);
+    return NULL;
+}
+
+/* ---------------- API ---------------- */
+
+request_hedger_t *request_hedger_create(const request_hedger_config_t *config,
+                                        request_hedger_send_fn send,
+                                        request_hedger_cancel_fn cancel, void *arg) {
+    if (!config || !send || !cancel || config->budget_percent < 0 || config->burst < 1 ||
+        !(config->percentile >= 50.0 && config->percentile <= 99.9) || config->min_samples < 1 ||
+        config->min_delay_us < 0 || config->max_subjects < 1) {
+        return NULL;
+    }
+    request_hedger_t *h = calloc(1, sizeof(*h));
+    if (!h) return NULL;
+    h->subjects = calloc((size_t)config->max_subjects, sizeof(*h->subjects));
+    if (!h->subjects) {
+        free(h);
+        return NULL;
+    }
+    h->config = *config;
+    h->send = send;
+    h->cancel = cancel;
+    h->arg = arg;
+    h->budget_max = (uint64_t)config->burst * 100U;
+    h->budget = h->budget_max;
+
+    pthread_mutex_init(&h->mutex, NULL);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&h->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_cond_init(&h->idle, NULL);
+
+    if (pthread_create(&h->thread, NULL, hedger_main, h) != 0) {
+        pthread_cond_destroy(&h->idle);
+        pthread_cond_destroy(&h->cond);
+        pthread_mutex_destroy(&h->mutex);
+        free(h->subjects);
+        free(h);
+        return NULL;
+    }
+    h->thread_running = 1;
+    return h;
+}
+
+int request_hedger_submit(request_hedger_t *h, const char *subject, const char *request,
+                          request_hedger_reply_fn reply, void *closure) {
+    if (!h || !subject || !request || !reply) return -1;
+    hedge_req_t *r = calloc(1, sizeof(*r));
+    if (!r) return -1;
+    r->request = strdup(request);
+    if (!r->request) {
+        free(r);
+        return -1;
+    }
+    r->owner = h;
+    r->reply = reply;
+    r->closure = closure;
+    r->attempts[0].req = r;
+    r->attempts[0].index = 0;
+    r->attempts[1].req = r;
+    r->attempts[1].index = 1;
+
+    pthread_mutex_lock(&h->mutex);
+    if (h->stopping) {
+        pthread_mutex_unlock(&h->mutex);
+        req_free(r);
+        return -1;
+    }
+    h->stats.requests++;
+    h->stats.in_flight++;
+    h->live++;
+    h->budget += (uint64_t)h->config.budget_percent;
+    if (h->budget > h->budget_max) h->budget = h->budget_max;
+
+    r->subject = subject_find(h, subject, 1);
+    r->refs = 2;                         /* The attempt's and ours */
+    r->live[0] = 1;
+    r->sent_us[0] = monotonic_us();
+    if (r->subject && r->subject->threshold_us > 0 && h->config.budget_percent > 0) {
+        r->hedge_at_us = r->sent_us[0] + r->subject->threshold_us;
+        due_insert(h, r);
+        if (h->first == r) pthread_cond_signal(&h->cond);
+    }
+    pthread_mutex_unlock(&h->mutex);
+
+    uint64_t handle = 0;
+    int rc = h->send(subject, r->request, on_attempt_reply, &r->attempts[0], &handle, h->arg);
+
+    pthread_mutex_lock(&h->mutex);
+    int lost = 0;
+    int answered = 0;                    /* By a hedge, before send failed */
+    if (rc != 0) {
+        /* Not submitted; a hedge the timer thread has begun is dropped too */
+        r->live[0] = 0;
+        r->refs--;
+        answered = r->done;
+        if (!answered) {
+            r->done = 1;
+            h->stats.in_flight--;
+            h->stats.requests--;
+        }
+        if (r->queued) {
+            due_remove(h, r);
+            r->refs--;
+        }
+        lost = r->live[1] && r->has_handle[1];
+    } else {
+        lost = attempt_sent(r, 0, handle);
+    }
+    pthread_mutex_unlock(&h->mutex);
+
+    if (lost) attempt_cancel(h, r, rc != 0 ? 1 : 0);
+
+    pthread_mutex_lock(&h->mutex);
+    hedge_req_t *dead = unref(h, r);
+    pthread_mutex_unlock(&h->mutex);
+    req_free(dead);
+    return rc != 0 && !answered ? -1 : 0;
+}
+
+uint64_t request_hedger_threshold_us(request_hedger_t *h, const char *subject) {
+    if (!h || !subject) return 0;
+    pthread_mutex_lock(&h->mutex);
+    subject_t *s = subject_find(h, subject, 0);
+    uint64_t threshold = s ? s->threshold_us : 0;
+    pthread_mutex_unlock(&h->mutex);
+    return threshold;
+}
+
+void request_hedger_get_stats(request_hedger_t *h, request_hedger_stats_t *stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!h) return;
+    pthread_mutex_lock(&h->mutex);
+    *stats = h->stats;
+    pthread_mutex_unlock(&h->mutex);
+}
+
+void request_hedger_stop(request_hedger_t *h) {
+    if (!h) return;
+    pthread_mutex_lock(&h->mutex);
+    h->stopping = 1;
+    pthread_cond_signal(&h->cond);
+    int joining = h->thread_running;
+    h->thread_running = 0;
+    pthread_mutex_unlock(&h->mutex);
+    if (joining) pthread_join(h->thread, NULL);
+
+    /* Nothing will be hedged now; the first attempts answer on their own */
+    pthread_mutex_lock(&h->mutex);
+    while (h->first != NULL) {
+        hedge_req_t *r = h->first;
+        due_remove(h, r);
+        hedge_req_t *dead = unref(h, r);
+        if (dead) {
+            pthread_mutex_unlock(&h->mutex);
+            req_free(dead);
+            pthread_mutex_lock(&h->mutex);
+        }
+    }
+    pthread_mutex_unlock(&h->mutex);
+}
+
+void request_hedger_destroy(request_hedger_t *h) {
+    if (!h) return;
+    request_hedger_stop(h);
+    pthread_mutex_lock(&h->mutex);
+    while (h->live > 0) {
+        pthread_cond_wait(&h->idle, &h->mutex);
+    }
+    pthread_mutex_unlock(&h->mutex);
+
+    for (int i = 0; i < h->nsubjects; i++) {
+        free(h->subjects[i].name);
+        latency_histogram_destroy(h->subjects[i].latency);
+    }
+    free(h->subjects);
+    pthread_cond_destroy(&h->idle);
+    pthread_cond_destroy(&h->cond);
+    pthread_mutex_destroy(&h->mutex);
+    free(h);
+}
@@ -0,0 +1,356 @@
+/**
+ * route_request.c - Decide request to RouteRequest transcoding
+ *
+ * The streaming path walks the body once, remembering where each field
+ * of interest starts and ends (the last occurrence wins, as in jansson)
+ * and validating everything else with json_scan. The RouteRequest is
+ * then assembled by copying those byte ranges into one buffer sized up
+ * front, so no tree is built and nothing is re-encoded. Override values
+ * that would need escaping are left to the jansson path, which then only
+ * writes the output.
+ */
+
+#include "route_request.h"
+#include "json_scan.h"
+#include <jansson.h>
+#include <string.h>
+
+#define KEY_MAX 32
+
+enum {
+    F_VERSION = 0,
+    F_TENANT_ID,
+    F_REQUEST_ID,
+    F_TRACE_ID,
+    F_RUN_ID,
+    F_MESSAGE_ID,
+    F_MESSAGE_TYPE,
+    F_PAYLOAD,
+    F_METADATA,
+    F_POLICY_ID,
+    F_CONTEXT,
+    F_COUNT
+};
+
+static const char *const field_names[F_COUNT] = {
+    "version", "tenant_id", "request_id", "trace_id", "run_id", "message_id",
+    "message_type", "payload", "metadata", "policy_id", "context",
+};
+
+typedef struct {
+    const char *start;
+    size_t len;
+    char kind;                       /* First byte of the value, 0 if absent */
+} span_t;
+
+typedef struct {
+    span_t fields[F_COUNT];
+    char version[4];
+    int task_ok;                     /* Last "task" had a string type and
+                                        an object payload */
+} decide_body_t;
+
+/* Can be written between quotes as is */
+static int is_plain(const char *v) {
+    for (; *v; v++) {
+        unsigned char c = (unsigned char)*v;
+        if (c < 0x20U || c >= 0x7FU || c == '"' || c == '\\') return 0;
+    }
+    return 1;
+}
+
+static const char *override_value(const char *v) {
+    return v != NULL && v[0] != '\0' ? v : NULL;
+}
+
+/* Decode a string that must fit whole; 1 if it did */
+static int scan_name(json_scan_t *s, char *out, size_t size) {
+    if (json_scan_string(s, out, size) != 0) return -1;
+    return strlen(out) < size - 1U;
+}
+
+static int scan_task(json_scan_t *s, decide_body_t *b, route_request_ids_t *ids) {
+    char key[KEY_MAX];
+    int count = 0;
+    int has_type = 0, type_fits = 0;
+    int has_version = 0, version_fits = 0;
+    int has_payload = 0;
+    int rc;
+
+    if (json_scan_object_open(s) != 0) return -1;
+    while ((rc = json_scan_object_next(s, &count, key, sizeof(key))) == 1) {
+        char kind = json_scan_peek(s);
+        const char *start = s->p;
+        if (strcmp(key, "type") == 0) {
+            has_type = kind == '"';
+            rc = has_type ? scan_name(s, ids->task_type, sizeof(ids->task_type)) : json_scan_value(s);
+            type_fits = rc == 1;
+        } else if (strcmp(key, "version") == 0) {
+            has_version = kind == '"';
+            rc = has_version ? scan_name(s, ids->task_version, sizeof(ids->task_version)) : json_scan_value(s);
+            version_fits = rc == 1;
+        } else {
+            rc = json_scan_value(s);
+            if (strcmp(key, "payload") == 0) {
+                has_payload = kind == '{';
+                ids->task_payload = start;
+                ids->task_payload_len = (size_t)(s->p - start);
+            }
+        }
+        if (rc < 0) return -1;
+    }
+    if (rc != 0) return -1;
+    b->task_ok = has_type && has_payload;
+    ids->has_task_block = has_type && type_fits && has_version && version_fits;
+    if (!has_version) ids->task_version[0] = '\0';
+    if (!has_payload) ids->task_payload = NULL;
+    return 0;
+}
+
+static int scan_body(json_scan_t *s, decide_body_t *b, route_request_ids_t *ids) {
+    char key[KEY_MAX];
+    int count = 0;
+    int rc;
+
+    if (json_scan_object_open(s) != 0) return -1;
+    while ((rc = json_scan_object_next(s, &count, key, sizeof(key))) == 1) {
+        char kind = json_scan_peek(s);
+        const char *start = s->p;
+
+        if (strcmp(key, "task") == 0) {
+            b->task_ok = 0;
+            ids->has_task_block = 0;
+            ids->task_payload = NULL;
+            rc = kind == '{' ? scan_task(s, b, ids) : json_scan_value(s);
+            if (rc != 0) return -1;
+            continue;
+        }
+
+        int f = 0;
+        while (f < F_COUNT && strcmp(key, field_names[f]) != 0) {
+            f++;
+        }
+        if (f == F_COUNT) {
+            if (json_scan_value(s) != 0) return -1;
+            continue;
+        }
+
+        if (kind == '"' && f == F_VERSION) {
+            rc = json_scan_string(s, b->version, sizeof(b->version));
+        } else if (kind == '"' && f == F_REQUEST_ID) {
+            rc = json_scan_string(s, ids->request_id, sizeof(ids->request_id));
+        } else if (kind == '"' && f == F_RUN_ID) {
+            rc = json_scan_string(s, ids->run_id, sizeof(ids->run_id));
+        } else {
+            rc = json_scan_value(s);
+        }
+        if (rc != 0) return -1;
+        b->fields[f].start = start;
+        b->fields[f].len = (size_t)(s->p - start);
+        b->fields[f].kind = kind;
+    }
+    if (rc != 0) return -1;
+    return json_scan_finish(s);
+}
+
+typedef struct {
+    char *buf;
+    size_t len;
+    int members;                     /* In the innermost open object */
+} writer_t;
+
+static void emit_raw(writer_t *w, const char *bytes, size_t n) {
+    memcpy(w->buf + w->len, bytes, n);
+    w->len += n;
+}
+
+static void emit_key(writer_t *w, const char *key) {
+    if (w->members++ > 0) w->buf[w->len++] = ',';
+    w->buf[w->len++] = '"';
+    emit_raw(w, key, strlen(key));
+    w->buf[w->len++] = '"';
+    w->buf[w->len++] = ':';
+}
+
+static void emit_span(writer_t *w, const decide_body_t *b, int f, char kind) {
+    if (b->fields[f].kind != kind) return;
+    emit_key(w, field_names[f]);
+    emit_raw(w, b->fields[f].start, b->fields[f].len);
+}
+
+static void emit_string(writer_t *w, const char *key, const char *value) {
+    emit_key(w, key);
+    w->buf[w->len++] = '"';
+    emit_raw(w, value, strlen(value));
+    w->buf[w->len++] = '"';
+}
+
+int route_request_build(const char *body, size_t len, const route_request_overrides_t *ov,
+                        route_request_ids_t *ids, char **out, size_t *out_len) {
+    if (!out) return ROUTE_REQUEST_FAILED;
+    *out = NULL;
+    if (!body) return ROUTE_REQUEST_INVALID;
+
+    const char *tenant = ov ? override_value(ov->tenant_id) : NULL;
+    const char *trace = ov ? override_value(ov->trace_id) : NULL;
+
+    decide_body_t b;
+    route_request_ids_t local_ids;
+    memset(&b, 0, sizeof(b));
+    memset(&local_ids, 0, sizeof(local_ids));
+
+    json_scan_t s;
+    json_scan_init(&s, body, len);
+    if (scan_body(&s, &b, &local_ids) != 0) return ROUTE_REQUEST_INVALID;
+    if (b.fields[F_VERSION].kind != '"' || strcmp(b.version, "1") != 0 ||
+        b.fields[F_TENANT_ID].kind != '"' || b.fields[F_REQUEST_ID].kind != '"' ||
+        !b.task_ok) {
+        return ROUTE_REQUEST_INVALID;
+    }
+    local_ids.has_run_id = b.fields[F_RUN_ID].kind == '"';
+    if (!local_ids.has_run_id) local_ids.run_id[0] = '\0';
+
+    /* The ids still come from the scan, so the payload span survives */
+    if ((tenant && !is_plain(tenant)) || (trace && !is_plain(trace))) {
+        int rc = route_request_build_dom(body, len, ov, NULL, out, out_len);
+        if (rc == ROUTE_REQUEST_OK && ids) *ids = local_ids;
+        return rc;
+    }
+
+    /* Every byte written is either a copied range, an override or a key */
+    size_t size = 128U + (tenant ? strlen(tenant) : 0U) + (trace ? strlen(trace) : 0U);
+    for (int f = 0; f < F_COUNT; f++) {
+        size += b.fields[f].len + strlen(field_names[f]) + 4U;
+    }
+    json_malloc_t jmalloc;
+    json_free_t jfree;
+    json_get_alloc_funcs(&jmalloc, &jfree);
+    writer_t w = { .buf = jmalloc(size), .len = 0, .members = 0 };
+    if (!w.buf) return ROUTE_REQUEST_FAILED;
+
+    w.buf[w.len++] = '{';
+    emit_span(&w, &b, F_VERSION, '"');
+    if (tenant) emit_string(&w, "tenant_id", tenant);
+    else emit_span(&w, &b, F_TENANT_ID, '"');
+    emit_span(&w, &b, F_REQUEST_ID, '"');
+    if (trace) emit_string(&w, "trace_id", trace);
+    else emit_span(&w, &b, F_TRACE_ID, '"');
+    emit_span(&w, &b, F_RUN_ID, '"');
+
+    emit_key(&w, "message");
+    int outer_members = w.members;
+    w.members = 0;
+    w.buf[w.len++] = '{';
+    emit_span(&w, &b, F_MESSAGE_ID, '"');
+    emit_span(&w, &b, F_MESSAGE_TYPE, '"');
+    emit_span(&w, &b, F_PAYLOAD, '{');
+    emit_span(&w, &b, F_METADATA, '{');
+    w.buf[w.len++] = '}';
+    w.members = outer_members;
+
+    emit_span(&w, &b, F_POLICY_ID, '"');
+    emit_span(&w, &b, F_CONTEXT, '{');
+    w.buf[w.len++] = '}';
+    w.buf[w.len] = '\0';
+
+    if (ids) *ids = local_ids;
+    *out = w.buf;
+    if (out_len) *out_len = w.len;
+    return ROUTE_REQUEST_OK;
+}
+
+/* ---------------- jansson path ---------------- */
+
+static void copy_id(char *dst, json_t *value) {
+    strncpy(dst, json_string_value(value), ROUTE_REQUEST_ID_MAX - 1U);
+    dst[ROUTE_REQUEST_ID_MAX - 1U] = '\0';
+}
+
+static void set_if(json_t *obj, const char *key, json_t *value, int ok) {
+    if (ok) json_object_set(obj, key, value);
+}
+
+int route_request_build_dom(const char *body, size_t len, const route_request_overrides_t *ov,
+                            route_request_ids_t *ids, char **out, size_t *out_len) {
+    if (!out) return ROUTE_REQUEST_FAILED;
+    *out = NULL;
+    if (!body) return ROUTE_REQUEST_INVALID;
+
+    json_error_t error;
+    json_t *in_root = json_loadb(body, len, 0, &error);
+    if (!json_is_object(in_root)) {
+        json_decref(in_root);
+        return ROUTE_REQUEST_INVALID;
+    }
+
+    json_t *version = json_object_get(in_root, "version");
+    json_t *tenant_id = json_object_get(in_root, "tenant_id");
+    json_t *request_id = json_object_get(in_root, "request_id");
+    json_t *task = json_object_get(in_root, "task");
+    if (!json_is_string(version) || strcmp(json_string_value(version), "1") != 0 ||
+        !json_is_string(tenant_id) || !json_is_string(request_id) ||
+        !json_is_object(task) || !json_is_string(json_object_get(task, "type")) ||
+        !json_is_object(json_object_get(task, "payload"))) {
+        json_decref(in_root);
+        return ROUTE_REQUEST_INVALID;
+    }
+
+    json_t *route = json_object();
+    json_t *message = json_object();
+    if (!route || !message) {
+        json_decref(route);
+        json_decref(message);
+        json_decref(in_root);
+        return ROUTE_REQUEST_FAILED;
+    }
+
+    const char *tenant = ov ? override_value(ov->tenant_id) : NULL;
+    const char *trace = ov ? override_value(ov->trace_id) : NULL;
+    json_t *trace_id = json_object_get(in_root, "trace_id");
+    json_t *run_id = json_object_get(in_root, "run_id");
+
+    json_object_set(route, "version", version);
+    if (tenant) json_object_set_new(route, "tenant_id", json_string(tenant));
+    else json_object_set(route, "tenant_id", tenant_id);
+    json_object_set(route, "request_id", request_id);
+    if (trace) json_object_set_new(route, "trace_id", json_string(trace));
+    else set_if(route, "trace_id", trace_id, json_is_string(trace_id));
+    set_if(route, "run_id", run_id, json_is_string(run_id));
+
+    json_t *v = json_object_get(in_root, "message_id");
+    set_if(message, "message_id", v, json_is_string(v));
+    v = json_object_get(in_root, "message_type");
+    set_if(message, "message_type", v, json_is_string(v));
+    v = json_object_get(in_root, "payload");
+    set_if(message, "payload", v, json_is_object(v));
+    v = json_object_get(in_root, "metadata");
+    set_if(message, "metadata", v, json_is_object(v));
+    json_object_set_new(route, "message", message);
+
+    v = json_object_get(in_root, "policy_id");
+    set_if(route, "policy_id", v, json_is_string(v));
+    v = json_object_get(in_root, "context");
+    set_if(route, "context", v, json_is_object(v));
+
+    char *dumped = json_dumps(route, JSON_COMPACT);
+    if (dumped && ids) {
+        memset(ids, 0, sizeof(*ids));
+        copy_id(ids->request_id, request_id);
+        ids->has_run_id = json_is_string(run_id);
+        if (ids->has_run_id) copy_id(ids->run_id, run_id);
+        json_t *task_type = json_object_get(task, "type");
+        json_t *task_version = json_object_get(task, "version");
+        copy_id(ids->task_type, task_type);
+        if (json_is_string(task_version)) copy_id(ids->task_version, task_version);
+        ids->has_task_block = json_is_string(task_version) &&
+                              strlen(ids->task_type) < ROUTE_REQUEST_ID_MAX - 1U &&
+                              strlen(ids->task_version) < ROUTE_REQUEST_ID_MAX - 1U;
+    }
+    json_decref(route);
+    json_decref(in_root);
+
+    if (!dumped) return ROUTE_REQUEST_FAILED;
+    *out = dumped;
+    if (out_len) *out_len = strlen(dumped);
+    return ROUTE_REQUEST_OK;
+}
@@ -0,0 +1,140 @@
+/**
+ * router_reply.c - Single-pass reader for Router replies
+ *
+ * Walks the reply with json_scan, so it accepts exactly the documents
+ * jansson would, and copies out only the handful of string values the
+ * gateway looks at. Nothing is allocated.
+ */
+
+#include "router_reply.h"
+#include "json_scan.h"
+#include <string.h>
+
+#define SCAN_KEY_MAX 32                  /* Longer keys are never ones we want */
+
+/* Value of a member we care about: note its type, copy it if a string */
+static int scan_field(json_scan_t *s, int *is_string, char *out, size_t size) {
+    *is_string = json_scan_peek(s) == '"';
+    if (*is_string) return json_scan_string(s, out, size);
+    out[0] = '\0';
+    return json_scan_value(s);
+}
+
+static int scan_error(json_scan_t *s, router_reply_t *r) {
+    char key[SCAN_KEY_MAX];
+    int count = 0;
+    int rc;
+
+    if (json_scan_object_open(s) != 0) return -1;
+    while ((rc = json_scan_object_next(s, &count, key, sizeof(key))) == 1) {
+        if (strcmp(key, "code") == 0) {
+            rc = scan_field(s, &r->has_code, r->code, sizeof(r->code));
+        } else if (strcmp(key, "message") == 0) {
+            rc = scan_field(s, &r->has_message, r->message, sizeof(r->message));
+        } else if (strcmp(key, "intake_error_code") == 0) {
+            r->has_intake_key = 1;
+            rc = scan_field(s, &r->has_intake_code, r->intake_error_code,
+                            sizeof(r->intake_error_code));
+        } else {
+            rc = json_scan_value(s);
+        }
+        if (rc != 0) return -1;
+    }
+    if (rc != 0) return -1;
+    r->error_close = (size_t)(s->p - 1 - s->base);
+    r->error_empty = count == 0;
+    return 0;
+}
+
+static int scan_reply(json_scan_t *s, router_reply_t *r) {
+    char key[SCAN_KEY_MAX];
+    int count = 0;
+    int rc;
+
+    if (json_scan_object_open(s) != 0) return -1;
+    while ((rc = json_scan_object_next(s, &count, key, sizeof(key))) == 1) {
+        if (strcmp(key, "ok") == 0) {
+            r->ok_false = json_scan_peek(s) == 'f';
+            rc = json_scan_value(s);
+        } else if (strcmp(key, "error") == 0) {
+            /* A repeated key replaces the earlier value, as in jansson */
+            r->has_error = 0;
+            r->has_code = r->has_message = r->has_intake_key = r->has_intake_code = 0;
+            r->code[0] = r->message[0] = r->intake_error_code[0] = '\0';
+            if (json_scan_peek(s) == '{') {
+                r->has_error = 1;
+                rc = scan_error(s, r);
+            } else {
+                rc = json_scan_value(s);
+            }
+        } else {
+            rc = json_scan_value(s);
+        }
+        if (rc != 0) return -1;
+    }
+    if (rc != 0) return -1;
+    return json_scan_finish(s);
+}
+
+int router_reply_status_for_code(const char *code) {
+    static const struct {
+        const char *code;
+        int status;
+    } map[] = {
+        { "invalid_request",       400 },
+        { "unauthorized",          401 },
+        { "policy_not_found",      404 },
+        /* Extension error codes (CP2-LC) */
+        { "extension_not_found",   404 },
+        { "extension_timeout",     504 },
+        { "validator_blocked",     403 },
+        { "post_processor_failed", 500 },
+        { "extension_unavailable", 503 },
+        { "extension_error",       500 },
+        { "decision_failed",       500 },
+        { "internal",              500 },
+    };
+    if (!code) return 0;
+    for (size_t i = 0; i < sizeof(map) / sizeof(map[0]); i++) {
+        if (strcmp(code, map[i].code) == 0) return map[i].status;
+    }
+    return 0;
+}
+
+int router_reply_scan(const char *json, size_t len, router_reply_t *reply) {
+    if (!reply) return -1;
+    memset(reply, 0, sizeof(*reply));
+    if (!json) return -1;
+
+    json_scan_t s;
+    json_scan_init(&s, json, len);
+    if (scan_reply(&s, reply) != 0) {
+        memset(reply, 0, sizeof(*reply));
+        return -1;
+    }
+
+    if (reply->ok_false && reply->has_code) {
+        reply->http_status = router_reply_status_for_code(reply->code);
+    }
+    return 0;
+}
+
+size_t router_reply_add_intake_null(const char *json, size_t len, const router_reply_t *reply,
+                                    char *out, size_t out_size) {
+    static const char member[] = "\"intake_error_code\":null";
+
+    if (!json || !reply || !out || !reply->has_error || reply->error_close >= len) return 0;
+    size_t extra = sizeof(member) - 1U + (reply->error_empty ? 0U : 1U);
+    if (out_size < len + extra + 1U) return 0;
+
+    size_t at = reply->error_close;
+    memcpy(out, json, at);
+    size_t n = at;
+    if (!reply->error_empty) out[n++] = ',';
+    memcpy(out + n, member, sizeof(member) - 1U);
+    n += sizeof(member) - 1U;
+    memcpy(out + n, json + at, len - at);
+    n += len - at;
+    out[n] = '\0';
+    return n;
+}
@@ -0,0 +1,811 @@
+/**
+ * schema_validator.c - Compiled JSON Schema (Draft-07 subset) validators
+ *
+ * Compilation checks each subschema the way the registry always has and
+ * appends it to a node array; nodes refer to each other by index, so
+ * recursive $refs are just back edges. Checking recurses over nodes in
+ * step with a json_scan cursor. allOf/anyOf/oneOf and $ref run on copies
+ * of the cursor, so their branches see the same value the node itself
+ * consumes afterwards. enum is the one keyword that parses the value
+ * with jansson, to compare it with each allowed value.
+ */
+
+#include "schema_validator.h"
+#include "json_scan.h"
+#include <jansson.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KEY_BUF          256             /* Instance keys decoded on the stack */
+#define MAX_REF_HOPS     32              /* $refs followed without consuming input */
+
+enum {
+    T_NULL    = 1 << 0,
+    T_BOOLEAN = 1 << 1,
+    T_OBJECT  = 1 << 2,
+    T_ARRAY   = 1 << 3,
+    T_NUMBER  = 1 << 4,
+    T_STRING  = 1 << 5,
+    T_INTEGER = 1 << 6
+};
+
+#define NO_NODE      (-1)
+#define ADDITIONAL_FALSE (-2)
+
+typedef struct {
+    uint32_t name;                       /* Offset in strings */
+    uint32_t name_len;
+    int32_t node;                        /* NO_NODE: only required */
+    int32_t required;                    /* Bit number, -1 if optional */
+} prop_t;
+
+typedef struct {
+    unsigned types;                      /* 0: any */
+    int32_t ref;
+    int32_t items;
+    int32_t additional;                  /* A node, NO_NODE or ADDITIONAL_FALSE */
+    uint32_t props, num_props;           /* Sorted by name */
+    uint32_t num_required;
+    uint32_t key_max;                    /* Longest property name */
+    uint32_t all, num_all;               /* In lists */
+    uint32_t any, num_any;
+    uint32_t one, num_one;
+    int32_t enum_idx;                    /* In enums, -1 if none */
+    int has_minimum, has_maximum;
+    double minimum, maximum;
+    long long min_length, max_length;    /* -1 if absent */
+} node_t;
+
+struct schema_validator_t {
+    node_t *nodes;
+    size_t num_nodes;
+    prop_t *props;
+    size_t num_props;
+    int32_t *lists;
+    size_t num_lists;
+    char *strings;
+    size_t strings_len;
+    json_t **enums;
+    size_t num_enums;
+};
+
+/* ---------------- Compilation ---------------- */
+
+typedef struct {
+    const json_t *schema;
+    int32_t node;
+} memo_t;
+
+typedef struct {
+    schema_validator_t *v;
+    size_t cap_nodes, cap_props, cap_lists, cap_strings, cap_enums;
+    const json_t *root;
+    memo_t *memo;
+    size_t num_memo, cap_memo;
+    char *err;
+    size_t err_size;
+} compiler_t;
+
+static int fail(compiler_t *c, const char *why) {
+    if (c->err && c->err_size > 0 && c->err[0] == '\0') {
+        snprintf(c->err, c->err_size, "%s", why);
+    }
+    return -1;
+}
+
+/* Make room for one more element of a growable array */
+static int reserve(compiler_t *c, void **items, size_t count, size_t *cap, size_t size, size_t more) {
+    if (count + more <= *cap) return 0;
+    size_t n = *cap ? *cap : 8U;
+    while (n < count + more) n *= 2U;
+    void *grown = realloc(*items, n * size);
+    if (!grown) return fail(c, "out of memory");
+    *items = grown;
+    *cap = n;
+    return 0;
+}
+
+static int new_node(compiler_t *c, int32_t *out) {
+    schema_validator_t *v = c->v;
+    if (v->num_nodes >= INT32_MAX ||
+        reserve(c, (void **)&v->nodes, v->num_nodes, &c->cap_nodes, sizeof(node_t), 1) != 0) {
+        return fail(c, "out of memory");
+    }
+    node_t *n = &v->nodes[v->num_nodes];
+    memset(n, 0, sizeof(*n));
+    n->ref = NO_NODE;
+    n->items = NO_NODE;
+    n->additional = NO_NODE;
+    n->enum_idx = -1;
+    n->min_length = -1;
+    n->max_length = -1;
+    *out = (int32_t)v->num_nodes++;
+    return 0;
+}
+
+static unsigned type_bit(const char *name) {
+    static const struct { const char *name; unsigned bit; } types[] = {
+        { "null", T_NULL }, { "boolean", T_BOOLEAN }, { "object", T_OBJECT }, { "array", T_ARRAY },
+        { "number", T_NUMBER }, { "string", T_STRING }, { "integer", T_INTEGER },
+    };
+    for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+        if (strcmp(name, types[i].name) == 0) return types[i].bit;
+    }
+    return 0;
+}
+
+static int compile_types(compiler_t *c, const json_t *type, unsigned *out) {
+    if (json_is_string(type)) {
+        *out = type_bit(json_string_value(type));
+        return *out ? 0 : fail(c, "unknown type");
+    }
+    if (!json_is_array(type) || json_array_size(type) == 0) return fail(c, "type must be a string or a non-empty array");
+    *out = 0;
+    for (size_t i = 0; i < json_array_size(type); i++) {
+        const json_t *t = json_array_get(type, i);
+        unsigned bit = json_is_string(t) ? type_bit(json_string_value(t)) : 0;
+        if (!bit) return fail(c, "unknown type");
+        *out |= bit;
+    }
+    return 0;
+}
+
+static int add_string(compiler_t *c, const char *s, size_t len, uint32_t *offset) {
+    schema_validator_t *v = c->v;
+    if (v->strings_len + len + 1U > UINT32_MAX ||
+        reserve(c, (void **)&v->strings, v->strings_len, &c->cap_strings, 1, len + 1U) != 0) {
+        return fail(c, "out of memory");
+    }
+    memcpy(v->strings + v->strings_len, s, len);
+    v->strings[v->strings_len + len] = '\0';
+    *offset = (uint32_t)v->strings_len;
+    v->strings_len += len + 1U;
+    return 0;
+}
+
+static int compile_node(compiler_t *c, const json_t *schema, int depth, int32_t *out);
+
+/* Resolve a same-document reference ("#", "#/definitions/x", ...) */
+static const json_t *resolve_ref(const compiler_t *c, const char *ref) {
+    if (ref[0] != '#') return NULL;
+    const json_t *at = c->root;
+    const char *p = ref + 1;
+    char token[256];
+    while (*p == '/') {
+        p++;
+        size_t n = 0;
+        while (*p && *p != '/') {
+            char ch = *p++;
+            if (ch == '~' && (*p == '0' || *p == '1')) ch = *p++ == '0' ? '~' : '/';
+            if (n + 1U >= sizeof(token)) return NULL;
+            token[n++] = ch;
+        }
+        token[n] = '\0';
+        if (json_is_object(at)) {
+            at = json_object_get(at, token);
+        } else if (json_is_array(at)) {
+            char *end;
+            unsigned long i = strtoul(token, &end, 10);
+            at = (n > 0 && *end == '\0') ? json_array_get(at, i) : NULL;
+        } else {
+            return NULL;
+        }
+        if (!at) return NULL;
+    }
+    return *p == '\0' ? at : NULL;
+}
+
+static int compile_list(compiler_t *c, const json_t *arr, int depth, uint32_t *start, uint32_t *count) {
+    if (!json_is_array(arr) || json_array_size(arr) == 0) {
+        return fail(c, "allOf/anyOf/oneOf must be a non-empty array of schemas");
+    }
+    size_t n = json_array_size(arr);
+    int32_t nodes[64];
+    int32_t *tmp = n <= 64 ? nodes : malloc(n * sizeof(*tmp));
+    if (!tmp) return fail(c, "out of memory");
+    int rc = 0;
+    for (size_t i = 0; rc == 0 && i < n; i++) {
+        const json_t *sub = json_array_get(arr, i);
+        rc = json_is_object(sub) ? compile_node(c, sub, depth + 1, &tmp[i])
+                                 : fail(c, "allOf/anyOf/oneOf must be a non-empty array of schemas");
+    }
+    schema_validator_t *v = c->v;
+    if (rc == 0 && (v->num_lists + n > UINT32_MAX ||
+                    reserve(c, (void **)&v->lists, v->num_lists, &c->cap_lists, sizeof(int32_t), n) != 0)) {
+        rc = fail(c, "out of memory");
+    }
+    if (rc == 0) {
+        memcpy(v->lists + v->num_lists, tmp, n * sizeof(*tmp));
+        *start = (uint32_t)v->num_lists;
+        *count = (uint32_t)n;
+        v->num_lists += n;
+    }
+    if (tmp != nodes) free(tmp);
+    return rc;
+}
+
+/* Insertion sort: property lists are short, and qsort has no context */
+static void sort_props(prop_t *props, size_t n, const char *strings) {
+    for (size_t i = 1; i < n; i++) {
+        prop_t p = props[i];
+        size_t j = i;
+        while (j > 0 && strcmp(strings + props[j - 1].name, strings + p.name) > 0) {
+            props[j] = props[j - 1];
+            j--;
+        }
+        props[j] = p;
+    }
+}
+
+static int32_t find_prop(const schema_validator_t *v, const node_t *n, const char *name) {
+    size_t lo = 0, hi = n->num_props;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2U;
+        int cmp = strcmp(name, v->strings + v->props[n->props + mid].name);
+        if (cmp == 0) return (int32_t)(n->props + mid);
+        if (cmp < 0) hi = mid;
+        else lo = mid + 1U;
+    }
+    return -1;
+}
+
+static int compile_object_keywords(compiler_t *c, const json_t *schema, int depth, int32_t idx) {
+    schema_validator_t *v = c->v;
+    const json_t *props = json_object_get(schema, "properties");
+    const json_t *required = json_object_get(schema, "required");
+    if (props && !json_is_object(props)) return fail(c, "properties must be an object of schemas");
+    if (required) {
+        if (!json_is_array(required)) return fail(c, "required must be an array of strings");
+        for (size_t i = 0; i < json_array_size(required); i++) {
+            if (!json_is_string(json_array_get(required, i))) return fail(c, "required must be an array of strings");
+        }
+    }
+
+    /* Property subschemas first: they append nodes and props of their own */
+    size_t num_named = props ? json_object_size(props) : 0U;
+    int32_t *subs = num_named ? calloc(num_named, sizeof(*subs)) : NULL;
+    if (num_named && !subs) return fail(c, "out of memory");
+    const char *key;
+    json_t *val;
+    size_t i = 0;
+    if (props) {
+        json_object_foreach((json_t *)props, key, val) {
+            if (!json_is_object(val) || compile_node(c, val, depth + 1, &subs[i]) != 0) {
+                free(subs);
+                return fail(c, "properties must be an object of schemas");
+            }
+            i++;
+        }
+    }
+
+    size_t max = num_named + (required ? json_array_size(required) : 0U);
+    if (v->num_props + max > UINT32_MAX ||
+        reserve(c, (void **)&v->props, v->num_props, &c->cap_props, sizeof(prop_t), max) != 0) {
+        free(subs);
+        return fail(c, "out of memory");
+    }
+    size_t start = v->num_props;
+    i = 0;
+    if (props) {
+        json_object_foreach((json_t *)props, key, val) {
+            prop_t *p = &v->props[v->num_props];
+            size_t len = strlen(key);
+            if (add_string(c, key, len, &p->name) != 0) {
+                free(subs);
+                return -1;
+            }
+            p->name_len = (uint32_t)len;
+            p->node = subs[i++];
+            p->required = -1;
+            v->num_props++;
+        }
+    }
+    free(subs);
+
+    uint32_t num_required = 0;
+    for (size_t r = 0; required && r < json_array_size(required); r++) {
+        const char *name = json_string_value(json_array_get(required, r));
+        prop_t *p = NULL;
+        for (size_t k = start; k < v->num_props; k++) {
+            if (strcmp(v->strings + v->props[k].name, name) == 0) {
+                p = &v->props[k];
+                break;
+            }
+        }
+        if (!p) {
+            p = &v->props[v->num_props];
+            size_t len = strlen(name);
+            if (add_string(c, name, len, &p->name) != 0) return -1;
+            p->name_len = (uint32_t)len;
+            p->node = NO_NODE;
+            p->required = -1;
+            v->num_props++;
+        }
+        if (p->required < 0) p->required = (int32_t)num_required++;
+    }
+
+    node_t *n = &v->nodes[idx];
+    n->props = (uint32_t)start;
+    n->num_props = (uint32_t)(v->num_props - start);
+    n->num_required = num_required;
+    for (size_t k = start; k < v->num_props; k++) {
+        if (v->props[k].name_len > n->key_max) n->key_max = v->props[k].name_len;
+    }
+    sort_props(v->props + start, n->num_props, v->strings);
+    return 0;
+}
+
+static int compile_node(compiler_t *c, const json_t *schema, int depth, int32_t *out) {
+    if (depth > SCHEMA_MAX_DEPTH) return fail(c, "schema nests too deep");
+    if (!json_is_object(schema)) return fail(c, "schema must be an object");
+
+    /* Each subschema compiles once, which also ties $ref cycles */
+    for (size_t i = 0; i < c->num_memo; i++) {
+        if (c->memo[i].schema == schema) {
+            *out = c->memo[i].node;
+            return 0;
+        }
+    }
+    int32_t idx;
+    if (new_node(c, &idx) != 0) return -1;
+    if (reserve(c, (void **)&c->memo, c->num_memo, &c->cap_memo, sizeof(memo_t), 1) != 0) return -1;
+    c->memo[c->num_memo++] = (memo_t){ schema, idx };
+    *out = idx;
+
+    const json_t *k = json_object_get(schema, "$schema");
+    if (k && (!json_is_string(k) || strstr(json_string_value(k), "draft-07") == NULL)) {
+        return fail(c, "$schema must name draft-07");
+    }
+    k = json_object_get(schema, "$ref");
+    if (k) {
+        if (!json_is_string(k)) return fail(c, "$ref must be a string");
+        /* Draft-07 ignores a $ref's siblings */
+        const json_t *target = resolve_ref(c, json_string_value(k));
+        if (target) {
+            int32_t ref;
+            if (compile_node(c, target, depth + 1, &ref) != 0) return -1;
+            c->v->nodes[idx].ref = ref;
+        }
+        return 0;
+    }
+
+    unsigned types = 0;
+    k = json_object_get(schema, "type");
+    if (k && compile_types(c, k, &types) != 0) return -1;
+    c->v->nodes[idx].types = types;
+
+    if (compile_object_keywords(c, schema, depth, idx) != 0) return -1;
+
+    k = json_object_get(schema, "items");
+    if (k) {
+        int32_t items;
+        if (!json_is_object(k) || compile_node(c, k, depth + 1, &items) != 0) {
+            return fail(c, "items must be a schema");
+        }
+        c->v->nodes[idx].items = items;
+    }
+    k = json_object_get(schema, "additionalProperties");
+    if (k) {
+        int32_t additional = NO_NODE;
+        if (json_is_false(k)) {
+            additional = ADDITIONAL_FALSE;
+        } else if (json_is_object(k)) {
+            if (compile_node(c, k, depth + 1, &additional) != 0) return -1;
+        } else if (!json_is_true(k)) {
+            return fail(c, "additionalProperties must be a boolean or a schema");
+        }
+        c->v->nodes[idx].additional = additional;
+    }
+    k = json_object_get(schema, "enum");
+    if (k) {
+        schema_validator_t *v = c->v;
+        if (!json_is_array(k)) return fail(c, "enum must be an array");
+        if (reserve(c, (void **)&v->enums, v->num_enums, &c->cap_enums, sizeof(json_t *), 1) != 0) return -1;
+        json_t *copy = json_deep_copy(k);
+        if (!copy) return fail(c, "out of memory");
+        v->enums[v->num_enums] = copy;
+        v->nodes[idx].enum_idx = (int32_t)v->num_enums++;
+    }
+
+    static const char *const lists[] = { "allOf", "anyOf", "oneOf" };
+    for (size_t l = 0; l < 3; l++) {
+        k = json_object_get(schema, lists[l]);
+        if (!k) continue;
+        uint32_t start, count;
+        if (compile_list(c, k, depth, &start, &count) != 0) return -1;
+        node_t *n = &c->v->nodes[idx];
+        if (l == 0) { n->all = start; n->num_all = count; }
+        else if (l == 1) { n->any = start; n->num_any = count; }
+        else { n->one = start; n->num_one = count; }
+    }
+
+    node_t *n = &c->v->nodes[idx];
+    if ((k = json_object_get(schema, "minimum"))) {
+        if (!json_is_number(k)) return fail(c, "minimum must be a number");
+        n->has_minimum = 1;
+        n->minimum = json_number_value(k);
+    }
+    if ((k = json_object_get(schema, "maximum"))) {
+        if (!json_is_number(k)) return fail(c, "maximum must be a number");
+        n->has_maximum = 1;
+        n->maximum = json_number_value(k);
+    }
+    if ((k = json_object_get(schema, "minLength"))) {
+        if (!json_is_integer(k)) return fail(c, "minLength must be an integer");
+        n->min_length = json_integer_value(k);
+    }
+    if ((k = json_object_get(schema, "maxLength"))) {
+        if (!json_is_integer(k)) return fail(c, "maxLength must be an integer");
+        n->max_length = json_integer_value(k);
+    }
+    if ((k = json_object_get(schema, "format")) && !json_is_string(k)) return fail(c, "format must be a string");
+    if ((k = json_object_get(schema, "definitions")) && !json_is_object(k)) return fail(c, "definitions must be an object");
+    if ((k = json_object_get(schema, "$defs")) && !json_is_object(k)) return fail(c, "$defs must be an object");
+    return 0;
+}
+
+schema_validator_t *schema_validator_compile(const json_t *schema, char *err, size_t err_size) {
+    if (err && err_size > 0) err[0] = '\0';
+    compiler_t c;
+    memset(&c, 0, sizeof(c));
+    c.err = err;
+    c.err_size = err_size;
+    c.root = schema;
+    c.v = calloc(1, sizeof(*c.v));
+    if (!c.v) {
+        fail(&c, "out of memory");
+        return NULL;
+    }
+    int32_t root;
+    int rc = compile_node(&c, schema, 0, &root);
+    free(c.memo);
+    if (rc != 0) {
+        schema_validator_free(c.v);
+        return NULL;
+    }
+    return c.v;
+}
+
+size_t schema_validator_size(const schema_validator_t *v) {
+    return v ? v->num_nodes : 0U;
+}
+
+void schema_validator_free(schema_validator_t *v) {
+    if (!v) return;
+    for (size_t i = 0; i < v->num_enums; i++) {
+        json_decref(v->enums[i]);
+    }
+    free(v->enums);
+    free(v->nodes);
+    free(v->props);
+    free(v->lists);
+    free(v->strings);
+    free(v);
+}
+
+/* ---------------- Checking ---------------- */
+
+typedef struct {
+    const schema_validator_t *v;
+    schema_error_t *error;
+    char path[SCHEMA_PATH_MAX];
+    size_t path_len;
+    int quiet;                           /* Inside anyOf/oneOf: failures are expected */
+} checker_t;
+
+static schema_result_t reject(checker_t *c, const char *reason) {
+    if (!c->quiet && c->error && c->error->reason == NULL) {
+        memcpy(c->error->path, c->path, c->path_len + 1U);
+        c->error->reason = reason;
+    }
+    return SCHEMA_INVALID;
+}
+
+/* Append one reference token in URI fragment form; returns the old length */
+static size_t path_push(checker_t *c, const char *token, size_t len) {
+    static const char hex[] = "0123456789ABCDEF";
+    size_t mark = c->path_len;
+    char enc[4];
+    size_t enc_len;
+    if (c->path_len + 1U < sizeof(c->path)) c->path[c->path_len++] = '/';
+    for (size_t i = 0; i < len; i++) {
+        unsigned char ch = (unsigned char)token[i];
+        if (ch == '~' || ch == '/') {
+            enc[0] = '~';
+            enc[1] = ch == '~' ? '0' : '1';
+            enc_len = 2;
+        } else if ((ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') ||
+                   ch == '-' || ch == '.' || ch == '_') {
+            enc[0] = (char)ch;
+            enc_len = 1;
+        } else {
+            enc[0] = '%';
+            enc[1] = hex[ch >> 4];
+            enc[2] = hex[ch & 0x0FU];
+            enc_len = 3;
+        }
+        if (c->path_len + enc_len >= sizeof(c->path)) break;
+        memcpy(c->path + c->path_len, enc, enc_len);
+        c->path_len += enc_len;
+    }
+    c->path[c->path_len] = '\0';
+    return mark;
+}
+
+static void path_pop(checker_t *c, size_t mark) {
+    c->path_len = mark;
+    c->path[mark] = '\0';
+}
+
+/* Unicode code points in a well-formed raw string, quotes included */
+static long long count_code_points(const char *p, const char *end) {
+    long long n = 0;
+    p++;
+    end--;
+    while (p < end) {
+        if (*p == '\\') {
+            /* A surrogate pair is two escapes and one code point */
+            if (p[1] == 'u' && (p[2] == 'd' || p[2] == 'D') &&
+                (p[3] == '8' || p[3] == '9' || p[3] == 'a' || p[3] == 'A' || p[3] == 'b' || p[3] == 'B')) {
+                p += 12;
+            } else {
+                p += p[1] == 'u' ? 6 : 2;
+            }
+        } else {
+            unsigned char ch = (unsigned char)*p;
+            p += ch < 0x80U ? 1 : ch < 0xE0U ? 2 : ch < 0xF0U ? 3 : 4;
+        }
+        n++;
+    }
+    return n;
+}
+
+static int parse_number(const char *start, const char *end, double *value, int *integral) {
+    char small[64];
+    size_t n = (size_t)(end - start);
+    char *copy = n < sizeof(small) ? small : malloc(n + 1U);
+    if (!copy) return -1;
+    memcpy(copy, start, n);
+    copy[n] = '\0';
+    *value = strtod(copy, NULL);
+    if (copy != small) free(copy);
+    *integral = memchr(start, '.', n) == NULL && memchr(start, 'e', n) == NULL && memchr(start, 'E', n) == NULL;
+    if (!*integral) {
+        /* 1.0 is an integer too; doubles this large have no fraction */
+        *integral = *value <= -9.0e18 || *value >= 9.0e18 || *value == (double)(long long)*value;
+    }
+    return 0;
+}
+
+static schema_result_t check(checker_t *c, json_scan_t *s, int32_t idx, int hops);
+
+/* json_equal(), except that numbers compare by value (1 equals 1.0) */
+static int instance_equal(const json_t *a, const json_t *b) {
+    if (json_is_number(a) && json_is_number(b)) {
+        if (json_is_integer(a) && json_is_integer(b)) return json_integer_value(a) == json_integer_value(b);
+        return json_number_value(a) == json_number_value(b);
+    }
+    if (json_typeof(a) != json_typeof(b)) return 0;
+    if (json_is_array(a)) {
+        if (json_array_size(a) != json_array_size(b)) return 0;
+        for (size_t i = 0; i < json_array_size(a); i++) {
+            if (!instance_equal(json_array_get(a, i), json_array_get(b, i))) return 0;
+        }
+        return 1;
+    }
+    if (json_is_object(a)) {
+        if (json_object_size(a) != json_object_size(b)) return 0;
+        const char *key;
+        json_t *value;
+        json_object_foreach((json_t *)a, key, value) {
+            const json_t *other = json_object_get(b, key);
+            if (!other || !instance_equal(value, other)) return 0;
+        }
+        return 1;
+    }
+    if (json_is_string(a)) {
+        return json_string_length(a) == json_string_length(b) &&
+               memcmp(json_string_value(a), json_string_value(b), json_string_length(a)) == 0;
+    }
+    return 1;                            /* true, false, null */
+}
+
+static schema_result_t check_enum(checker_t *c, const json_scan_t *s, const json_t *values) {
+    json_scan_t t = *s;
+    (void)json_scan_peek(&t);
+    const char *start = t.p;
+    if (json_scan_value(&t) != 0) return SCHEMA_MALFORMED;
+    json_t *value = json_loadb(start, (size_t)(t.p - start), JSON_DECODE_ANY, NULL);
+    if (!value) return SCHEMA_FAILED;
+    int found = 0;
+    for (size_t i = 0; !found && i < json_array_size(values); i++) {
+        found = instance_equal(value, json_array_get(values, i));
+    }
+    json_decref(value);
+    return found ? SCHEMA_VALID : reject(c, "is not one of the enum values");
+}
+
+/* Keys that do not fit read back as "", which only a real "" may match:
+ * right after a member's ':', look back for the key's closing quote */
+static int key_is_empty(const json_scan_t *s) {
+    const char *q = s->p - 2;
+    while (q > s->base && (*q == ' ' || *q == '\t' || *q == '\n' || *q == '\r')) q--;
+    return q - s->base >= 2 && q[0] == '"' && q[-1] == '"' && q[-2] != '\\';
+}
+
+static schema_result_t check_object(checker_t *c, json_scan_t *s, const node_t *n) {
+    const schema_validator_t *v = c->v;
+    uint64_t seen_small = 0;
+    uint64_t *seen = &seen_small;
+    if (n->num_required > 64) {
+        seen = calloc((n->num_required + 63U) / 64U, sizeof(uint64_t));
+        if (!seen) return SCHEMA_FAILED;
+    }
+    /* A key one byte longer than any property comes back empty */
+    char key_small[KEY_BUF];
+    size_t key_size = n->key_max + 2U;
+    char *key = key_size <= sizeof(key_small) ? key_small : malloc(key_size);
+    schema_result_t rc = key ? SCHEMA_VALID : SCHEMA_FAILED;
+    if (key_size <= sizeof(key_small)) key_size = sizeof(key_small);
+
+    int count = 0;
+    int more = 0;
+    if (rc == SCHEMA_VALID && json_scan_object_open(s) != 0) rc = SCHEMA_MALFORMED;
+    while (rc == SCHEMA_VALID && (more = json_scan_object_next(s, &count, key, key_size)) == 1) {
+        int32_t p = n->num_props ? find_prop(v, n, key) : -1;
+        if (p >= 0 && key[0] == '\0' && !key_is_empty(s)) p = -1;
+        int32_t sub = NO_NODE;
+        if (p >= 0) {
+            const prop_t *prop = &v->props[p];
+            if (prop->required >= 0) seen[prop->required / 64] |= 1ULL << (prop->required % 64);
+            sub = prop->node;
+        }
+        if (sub == NO_NODE && p < 0) sub = n->additional;
+        size_t mark = path_push(c, key, strlen(key));
+        if (sub == ADDITIONAL_FALSE) {
+            rc = reject(c, "is not an allowed property");
+        } else if (sub >= 0) {
+            rc = check(c, s, sub, 0);
+        } else if (json_scan_value(s) != 0) {
+            rc = SCHEMA_MALFORMED;
+        }
+        path_pop(c, mark);
+    }
+    if (rc == SCHEMA_VALID && more != 0) rc = SCHEMA_MALFORMED;
+    for (uint32_t k = 0; rc == SCHEMA_VALID && k < n->num_props; k++) {
+        const prop_t *prop = &v->props[n->props + k];
+        if (prop->required >= 0 && !(seen[prop->required / 64] & (1ULL << (prop->required % 64)))) {
+            size_t mark = path_push(c, v->strings + prop->name, prop->name_len);
+            rc = reject(c, "is required");
+            path_pop(c, mark);
+        }
+    }
+    if (key != key_small) free(key);
+    if (seen != &seen_small) free(seen);
+    return rc;
+}
+
+static schema_result_t check_array(checker_t *c, json_scan_t *s, const node_t *n) {
+    int count = 0;
+    int more;
+    if (json_scan_array_open(s) != 0) return SCHEMA_MALFORMED;
+    while ((more = json_scan_array_next(s, &count)) == 1) {
+        if (n->items == NO_NODE) {
+            if (json_scan_value(s) != 0) return SCHEMA_MALFORMED;
+            continue;
+        }
+        char index[24];
+        int len = snprintf(index, sizeof(index), "%d", count - 1);
+        size_t mark = path_push(c, index, (size_t)len);
+        schema_result_t rc = check(c, s, n->items, 0);
+        path_pop(c, mark);
+        if (rc != SCHEMA_VALID) return rc;
+    }
+    return more == 0 ? SCHEMA_VALID : SCHEMA_MALFORMED;
+}
+
+static schema_result_t check_list(checker_t *c, const json_scan_t *s, uint32_t start, uint32_t count,
+                                  int hops, int need) {
+    int matched = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        json_scan_t t = *s;
+        schema_result_t rc = check(c, &t, c->v->lists[start + i], hops);
+        if (rc == SCHEMA_VALID) {
+            if (++matched == 1 && need == 1) return SCHEMA_VALID;
+        } else if (rc != SCHEMA_INVALID || need == 0) {
+            return rc;                   /* allOf fails on the first miss */
+        }
+    }
+    return need == 0 || (need == 1 ? matched > 0 : matched == 1) ? SCHEMA_VALID : SCHEMA_INVALID;
+}
+
+static schema_result_t check(checker_t *c, json_scan_t *s, int32_t idx, int hops) {
+    const node_t *n = &c->v->nodes[idx];
+    schema_result_t rc;
+
+    if (n->ref != NO_NODE) {
+        if (hops >= MAX_REF_HOPS) return reject(c, "follows a $ref loop");
+        return check(c, s, n->ref, hops + 1);
+    }
+    if (n->num_all) {
+        rc = check_list(c, s, n->all, n->num_all, hops + 1, 0);
+        if (rc != SCHEMA_VALID) return rc;
+    }
+    if (n->num_any || n->num_one) {
+        c->quiet++;
+        rc = n->num_any ? check_list(c, s, n->any, n->num_any, hops + 1, 1) : SCHEMA_VALID;
+        if (rc == SCHEMA_VALID && n->num_one) rc = check_list(c, s, n->one, n->num_one, hops + 1, 2);
+        c->quiet--;
+        if (rc == SCHEMA_INVALID) return reject(c, n->num_one ? "does not match anyOf/oneOf" : "does not match anyOf");
+        if (rc != SCHEMA_VALID) return rc;
+    }
+    if (n->enum_idx >= 0) {
+        rc = check_enum(c, s, c->v->enums[n->enum_idx]);
+        if (rc != SCHEMA_VALID) return rc;
+    }
+
+    char kind = json_scan_peek(s);
+    const char *start = s->p;
+    switch (kind) {
+        case '\0':
+            return SCHEMA_MALFORMED;
+        case '{':
+            if (n->types && !(n->types & T_OBJECT)) return reject(c, "is not of the expected type");
+            return check_object(c, s, n);
+        case '[':
+            if (n->types && !(n->types & T_ARRAY)) return reject(c, "is not of the expected type");
+            return check_array(c, s, n);
+        case '"': {
+            if (n->types && !(n->types & T_STRING)) return reject(c, "is not of the expected type");
+            if (json_scan_string(s, NULL, 0) != 0) return SCHEMA_MALFORMED;
+            if (n->min_length < 0 && n->max_length < 0) return SCHEMA_VALID;
+            long long len = count_code_points(start, s->p);
+            if (n->min_length >= 0 && len < n->min_length) return reject(c, "is shorter than minLength");
+            if (n->max_length >= 0 && len > n->max_length) return reject(c, "is longer than maxLength");
+            return SCHEMA_VALID;
+        }
+        case 't':
+        case 'f':
+            if (n->types && !(n->types & T_BOOLEAN)) return reject(c, "is not of the expected type");
+            return json_scan_value(s) == 0 ? SCHEMA_VALID : SCHEMA_MALFORMED;
+        case 'n':
+            if (n->types && !(n->types & T_NULL)) return reject(c, "is not of the expected type");
+            return json_scan_value(s) == 0 ? SCHEMA_VALID : SCHEMA_MALFORMED;
+        default: {
+            if (json_scan_value(s) != 0) return SCHEMA_MALFORMED;
+            double value;
+            int integral;
+            if (parse_number(start, s->p, &value, &integral) != 0) return SCHEMA_FAILED;
+            if (n->types && !(n->types & T_NUMBER) && !(integral && (n->types & T_INTEGER))) {
+                return reject(c, "is not of the expected type");
+            }
+            if (n->has_minimum && value < n->minimum) return reject(c, "is less than minimum");
+            if (n->has_maximum && value > n->maximum) return reject(c, "is greater than maximum");
+            return SCHEMA_VALID;
+        }
+    }
+}
+
+schema_result_t schema_validator_check(const schema_validator_t *v, const char *json, size_t len,
+                                       schema_error_t *error) {
+    if (!v || !json || v->num_nodes == 0) return SCHEMA_FAILED;
+    checker_t c;
+    memset(&c, 0, sizeof(c));
+    c.v = v;
+    c.error = error;
+    c.path[0] = '#';
+    c.path_len = 1;
+    c.path[1] = '\0';
+    if (error) {
+        error->path[0] = '\0';
+        error->reason = NULL;
+    }
+
+    json_scan_t s;
+    json_scan_init(&s, json, len);
+    schema_result_t rc = check(&c, &s, 0, 0);
+    if (rc == SCHEMA_VALID && json_scan_finish(&s) != 0) rc = SCHEMA_MALFORMED;
+    return rc;
+}
@@ -0,0 +1,750 @@
+/**
+ * sse_hub.c - Server-Sent Events fan-out engine
+ *
+ * Everything below the inbox is owned by the loop thread: subscriber
+ * lists, the tenant index, rings and frame reference counts need no
+ * locks. Publishers and subscribers only touch the inbox, a Treiber
+ * stack the loop swaps out whole and replays in FIFO order, so a stream
+ * registered before an event was published always sees it.
+ */
+
+#define _GNU_SOURCE
+#include "sse_hub.h"
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#define HUB_TENANT_BUCKETS 4096         /* Power of two */
+#define HUB_MAX_EVENTS     256          /* epoll_wait batch */
+#define HUB_MAX_IOV        64           /* Frames per writev */
+#define HUB_MIN_TICK_MS    10
+#define HUB_MAX_TICK_MS    1000
+
+/* ---------------- Inbox operations ---------------- */
+
+typedef enum {
+    HUB_OP_SUBSCRIBE,
+    HUB_OP_PUBLISH
+} hub_op_kind_t;
+
+typedef struct hub_op {
+    hub_op_kind_t kind;
+    struct hub_op *next;                /* Link in the inbox stack */
+} hub_op_t;
+
+/* One encoded frame, shared by every ring that holds it */
+typedef struct {
+    hub_op_t op;
+    size_t refs;                        /* Ring slots holding it (loop thread) */
+    int persistent;                     /* Static frame, never freed */
+    char tenant_id[SSE_HUB_TENANT_MAX]; /* "" = every subscriber */
+    size_t len;
+    char *frame;
+} hub_event_t;
+
+struct hub_tenant;
+
+typedef struct hub_sub {
+    hub_op_t op;
+    int fd;                             /* -1 once dropped */
+    char tenant_id[SSE_HUB_TENANT_MAX];
+    struct hub_tenant *tenant;
+    struct hub_sub *tprev;              /* Tenant's subscriber list */
+    struct hub_sub *tnext;
+    struct hub_sub *prev;               /* Hub-wide subscriber list */
+    struct hub_sub *next;
+    struct hub_sub *dirty_next;         /* Pending flush, or graveyard link */
+    int dirty;
+    int blocked;                        /* Last write hit EAGAIN; wait for EPOLLOUT */
+    uint64_t active_ms;                 /* Last write progress, or ring became busy */
+    size_t head;                        /* Ring cursors (free-running) */
+    size_t tail;
+    size_t head_off;                    /* Bytes of ring[head] already written */
+    hub_event_t *ring[];
+} hub_sub_t;
+
+typedef struct hub_tenant {
+    char id[SSE_HUB_TENANT_MAX];
+    uint64_t hash;
+    hub_sub_t *subs;
+    struct hub_tenant *next;            /* Bucket chain */
+} hub_tenant_t;
+
+struct sse_hub_t {
+    sse_hub_config_t config;
+    size_t ring_mask;
+    int epoll_fd;
+    int wake_fd;
+    pthread_t thread;
+    int started;
+    atomic_int stopping;
+    _Atomic(hub_op_t *) inbox;
+
+    /* Loop thread only */
+    hub_sub_t *subs;
+    hub_sub_t *dirty;
+    hub_sub_t *graveyard;
+    hub_tenant_t *tenants[HUB_TENANT_BUCKETS];
+    uint64_t now_ms;
+
+    atomic_int_fast64_t reserved;       /* Subscriber slots taken (any thread) */
+    atomic_uint_fast64_t subscribed;
+    atomic_uint_fast64_t refused;
+    atomic_uint_fast64_t published;
+    atomic_uint_fast64_t delivered;
+    atomic_uint_fast64_t heartbeats;
+    atomic_uint_fast64_t evicted_overflow;
+    atomic_uint_fast64_t evicted_stalled;
+    atomic_uint_fast64_t disconnected;
+};
+
+static char heartbeat_text[] = ": ping\n\n";
+static hub_event_t heartbeat_event = {
+    .persistent = 1,
+    .len = sizeof(heartbeat_text) - 1U,
+    .frame = heartbeat_text,
+};
+
+/* epoll tag for the wake eventfd */
+static char wake_tag;
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000ULL;
+}
+
+static int env_positive_int(const char *name, int def_val) {
+    const char *val = getenv(name);
+    if (val == NULL || *val == '\0') {
+        return def_val;
+    }
+    int parsed = atoi(val);
+    return parsed > 0 ? parsed : def_val;
+}
+
+static uint64_t tenant_hash(const char *id) {
+    uint64_t h = 14695981039346656037ULL;   /* FNV-1a */
+    for (const unsigned char *p = (const unsigned char *)id; *p; p++) {
+        h ^= *p;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static void copy_tenant(char dst[SSE_HUB_TENANT_MAX], const char *src) {
+    size_t n = src ? strnlen(src, SSE_HUB_TENANT_MAX - 1U) : 0U;
+    if (n > 0) {
+        memcpy(dst, src, n);
+    }
+    dst[n] = '\0';
+}
+
+static void inbox_push(sse_hub_t *hub, hub_op_t *op) {
+    hub_op_t *head = atomic_load_explicit(&hub->inbox, memory_order_relaxed);
+    do {
+        op->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&hub->inbox, &head, op,
+                                                    memory_order_release,
+                                                    memory_order_relaxed));
+    /* The loop swaps the whole stack out; only the first push needs a wake */
+    if (head == NULL) {
+        uint64_t one = 1;
+        (void)write(hub->wake_fd, &one, sizeof(one));
+    }
+}
+
+/* ---------------- Frames ---------------- */
+
+static void event_unref(hub_event_t *ev) {
+    if (ev->persistent) {
+        return;
+    }
+    if (--ev->refs == 0) {
+        free(ev);
+    }
+}
+
+/* ---------------- Tenant index ---------------- */
+
+static hub_tenant_t *tenant_find(sse_hub_t *hub, const char *id, uint64_t hash) {
+    hub_tenant_t *t = hub->tenants[hash & (HUB_TENANT_BUCKETS - 1U)];
+    while (t && (t->hash != hash || strcmp(t->id, id) != 0)) {
+        t = t->next;
+    }
+    return t;
+}
+
+static int tenant_attach(sse_hub_t *hub, hub_sub_t *sub) {
+    uint64_t hash = tenant_hash(sub->tenant_id);
+    hub_tenant_t *t = tenant_find(hub, sub->tenant_id, hash);
+    if (!t) {
+        t = calloc(1, sizeof(hub_tenant_t));
+        if (!t) {
+            return -1;
+        }
+        memcpy(t->id, sub->tenant_id, sizeof(t->id));
+        t->hash = hash;
+        hub_tenant_t **bucket = &hub->tenants[hash & (HUB_TENANT_BUCKETS - 1U)];
+        t->next = *bucket;
+        *bucket = t;
+    }
+    sub->tenant = t;
+    sub->tnext = t->subs;
+    if (t->subs) {
+        t->subs->tprev = sub;
+    }
+    t->subs = sub;
+    return 0;
+}
+
+static void tenant_detach(sse_hub_t *hub, hub_sub_t *sub) {
+    hub_tenant_t *t = sub->tenant;
+    if (sub->tprev) {
+        sub->tprev->tnext = sub->tnext;
+    } else {
+        t->subs = sub->tnext;
+    }
+    if (sub->tnext) {
+        sub->tnext->tprev = sub->tprev;
+    }
+    sub->tenant = NULL;
+    if (t->subs) {
+        return;
+    }
+
+    /* Last subscriber gone: drop the tenant */
+    hub_tenant_t **link = &hub->tenants[t->hash & (HUB_TENANT_BUCKETS - 1U)];
+    while (*link != t) {
+        link = &(*link)->next;
+    }
+    *link = t->next;
+    free(t);
+}
+
+/* ---------------- Subscribers ---------------- */
+
+typedef enum {
+    DROP_DISCONNECTED,
+    DROP_OVERFLOW,
+    DROP_STALLED,
+    DROP_SHUTDOWN
+} drop_reason_t;
+
+/* Close and unlink now; the struct is freed at the end of the loop pass,
+ * since epoll events and the dirty list may still point at it */
+static void sub_drop(sse_hub_t *hub, hub_sub_t *sub, drop_reason_t reason) {
+    if (sub->fd < 0) {
+        return;
+    }
+    (void)epoll_ctl(hub->epoll_fd, EPOLL_CTL_DEL, sub->fd, NULL);
+    close(sub->fd);
+    sub->fd = -1;
+
+    while (sub->head != sub->tail) {
+        event_unref(sub->ring[sub->head & hub->ring_mask]);
+        sub->head++;
+    }
+    tenant_detach(hub, sub);
+    if (sub->prev) {
+        sub->prev->next = sub->next;
+    } else {
+        hub->subs = sub->next;
+    }
+    if (sub->next) {
+        sub->next->prev = sub->prev;
+    }
+    if (!sub->dirty) {
+        sub->dirty_next = hub->graveyard;
+        hub->graveyard = sub;
+    }
+    atomic_fetch_sub_explicit(&hub->reserved, 1, memory_order_relaxed);
+
+    switch (reason) {
+    case DROP_OVERFLOW:
+        atomic_fetch_add_explicit(&hub->evicted_overflow, 1, memory_order_relaxed);
+        break;
+    case DROP_STALLED:
+        atomic_fetch_add_explicit(&hub->evicted_stalled, 1, memory_order_relaxed);
+        break;
+    case DROP_DISCONNECTED:
+        atomic_fetch_add_explicit(&hub->disconnected, 1, memory_order_relaxed);
+        break;
+    case DROP_SHUTDOWN:
+        break;
+    }
+}
+
+static void sub_mark_dirty(sse_hub_t *hub, hub_sub_t *sub) {
+    if (!sub->dirty && !sub->blocked) {
+        sub->dirty = 1;
+        sub->dirty_next = hub->dirty;
+        hub->dirty = sub;
+    }
+}
+
+static void sub_enqueue(sse_hub_t *hub, hub_sub_t *sub, hub_event_t *ev) {
+    if (sub->tail - sub->head > hub->ring_mask) {
+        /* Ring full: this consumer is too slow; it reconnects and resyncs */
+        sub_drop(hub, sub, DROP_OVERFLOW);
+        return;
+    }
+    if (sub->head == sub->tail) {
+        sub->active_ms = hub->now_ms;        /* Stall clock starts now */
+    }
+    sub->ring[sub->tail & hub->ring_mask] = ev;
+    sub->tail++;
+    if (!ev->persistent) {
+        ev->refs++;
+    }
+    sub_mark_dirty(hub, sub);
+}
+
+/* Write as much of the ring as the socket takes */
+static void sub_flush(sse_hub_t *hub, hub_sub_t *sub) {
+    while (sub->fd >= 0 && sub->head != sub->tail) {
+        struct iovec iov[HUB_MAX_IOV];
+        int iovcnt = 0;
+        for (size_t i = sub->head; i != sub->tail && iovcnt < HUB_MAX_IOV; i++) {
+            hub_event_t *ev = sub->ring[i & hub->ring_mask];
+            size_t off = (i == sub->head) ? sub->head_off : 0U;
+            iov[iovcnt].iov_base = ev->frame + off;
+            iov[iovcnt].iov_len = ev->len - off;
+            iovcnt++;
+        }
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = (size_t)iovcnt;
+        ssize_t n = sendmsg(sub->fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                sub->blocked = 1;            /* EPOLLOUT resumes the flush */
+                return;
+            }
+            sub_drop(hub, sub, DROP_DISCONNECTED);
+            return;
+        }
+
+        sub->active_ms = hub->now_ms;
+        size_t left = (size_t)n;
+        while (left > 0) {
+            hub_event_t *ev = sub->ring[sub->head & hub->ring_mask];
+            size_t rest = ev->len - sub->head_off;
+            if (left < rest) {
+                sub->head_off += left;
+                break;
+            }
+            left -= rest;
+            event_unref(ev);
+            sub->head++;
+            sub->head_off = 0;
+            atomic_fetch_add_explicit(&hub->delivered, 1, memory_order_relaxed);
+        }
+    }
+}
+
+static void hub_flush_dirty(sse_hub_t *hub) {
+    while (hub->dirty) {
+        hub_sub_t *sub = hub->dirty;
+        hub->dirty = sub->dirty_next;
+        sub->dirty = 0;
+        if (sub->fd < 0) {
+            /* Dropped while queued for a flush */
+            sub->dirty_next = hub->graveyard;
+            hub->graveyard = sub;
+            continue;
+        }
+        sub_flush(hub, sub);
+    }
+}
+
+static void hub_bury(sse_hub_t *hub) {
+    while (hub->graveyard) {
+        hub_sub_t *sub = hub->graveyard;
+        hub->graveyard = sub->dirty_next;
+        free(sub);
+    }
+}
+
+/* Discard anything the client sends; notice when it hangs up */
+static void sub_on_readable(sse_hub_t *hub, hub_sub_t *sub) {
+    char sink[512];
+    for (;;) {
+        ssize_t n = recv(sub->fd, sink, sizeof(sink), 0);
+        if (n > 0) {
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+        sub_drop(hub, sub, DROP_DISCONNECTED);
+        return;
+    }
+}
+
+/* ---------------- Loop ---------------- */
+
+static void hub_add_subscriber(sse_hub_t *hub, hub_sub_t *sub) {
+    if (atomic_load(&hub->stopping) || tenant_attach(hub, sub) != 0) {
+        close(sub->fd);
+        atomic_fetch_sub_explicit(&hub->reserved, 1, memory_order_relaxed);
+        free(sub);
+        return;
+    }
+    sub->next = hub->subs;
+    if (hub->subs) {
+        hub->subs->prev = sub;
+    }
+    hub->subs = sub;
+    sub->active_ms = hub->now_ms;
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    ev.data.ptr = sub;
+    if (epoll_ctl(hub->epoll_fd, EPOLL_CTL_ADD, sub->fd, &ev) != 0) {
+        sub_drop(hub, sub, DROP_DISCONNECTED);
+    }
+}
+
+static void hub_fanout(sse_hub_t *hub, hub_event_t *ev) {
+    /* Hold a reference so evictions during the walk cannot free the frame */
+    ev->refs = 1;
+    if (ev->tenant_id[0] != '\0') {
+        hub_tenant_t *t = tenant_find(hub, ev->tenant_id, tenant_hash(ev->tenant_id));
+        hub_sub_t *sub = t ? t->subs : NULL;
+        while (sub) {
+            /* Dropping the tenant's last subscriber frees t */
+            hub_sub_t *next = sub->tnext;
+            sub_enqueue(hub, sub, ev);
+            sub = next;
+        }
+    } else {
+        hub_sub_t *sub = hub->subs;
+        while (sub) {
+            hub_sub_t *next = sub->next;
+            sub_enqueue(hub, sub, ev);
+            sub = next;
+        }
+    }
+    event_unref(ev);
+}
+
+static void hub_drain_inbox(sse_hub_t *hub) {
+    hub_op_t *stack = atomic_exchange_explicit(&hub->inbox, NULL, memory_order_acquire);
+
+    /* Reverse the LIFO so operations apply in the order they were made */
+    hub_op_t *queue = NULL;
+    while (stack) {
+        hub_op_t *next = stack->next;
+        stack->next = queue;
+        queue = stack;
+        stack = next;
+    }
+
+    while (queue) {
+        hub_op_t *op = queue;
+        queue = op->next;
+        if (op->kind == HUB_OP_SUBSCRIBE) {
+            hub_add_subscriber(hub, (hub_sub_t *)op);
+        } else {
+            hub_fanout(hub, (hub_event_t *)op);
+        }
+    }
+}
+
+/* Heartbeat idle streams, evict stalled ones */
+static void hub_sweep(sse_hub_t *hub) {
+    uint64_t heartbeat = (uint64_t)hub->config.heartbeat_ms;
+    uint64_t stall = (uint64_t)hub->config.stall_timeout_ms;
+    hub_sub_t *sub = hub->subs;
+    while (sub) {
+        hub_sub_t *next = sub->next;
+        uint64_t idle = hub->now_ms - sub->active_ms;
+        if (sub->head != sub->tail) {
+            if (idle >= stall) {
+                sub_drop(hub, sub, DROP_STALLED);
+            }
+        } else if (idle >= heartbeat) {
+            sub_enqueue(hub, sub, &heartbeat_event);
+            atomic_fetch_add_explicit(&hub->heartbeats, 1, memory_order_relaxed);
+        }
+        sub = next;
+    }
+}
+
+static void *hub_thread_main(void *arg) {
+    sse_hub_t *hub = (sse_hub_t *)arg;
+    struct epoll_event events[HUB_MAX_EVENTS];
+
+    int tick = hub->config.heartbeat_ms < hub->config.stall_timeout_ms
+                   ? hub->config.heartbeat_ms : hub->config.stall_timeout_ms;
+    tick /= 4;
+    if (tick < HUB_MIN_TICK_MS) tick = HUB_MIN_TICK_MS;
+    if (tick > HUB_MAX_TICK_MS) tick = HUB_MAX_TICK_MS;
+
+    hub->now_ms = now_ms();
+    uint64_t next_sweep = hub->now_ms + (uint64_t)tick;
+
+    while (!atomic_load(&hub->stopping)) {
+        int n = epoll_wait(hub->epoll_fd, events, HUB_MAX_EVENTS, tick);
+        if (n < 0 && errno != EINTR) {
+            break;
+        }
+        hub->now_ms = now_ms();
+
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.ptr == &wake_tag) {
+                uint64_t count;
+                (void)read(hub->wake_fd, &count, sizeof(count));
+                hub_drain_inbox(hub);
+                continue;
+            }
+            hub_sub_t *sub = events[i].data.ptr;
+            if (sub->fd < 0) {
+                continue;                     /* Dropped earlier in this pass */
+            }
+            uint32_t mask = events[i].events;
+            if (mask & (EPOLLHUP | EPOLLERR | EPOLLRDHUP)) {
+                sub_drop(hub, sub, DROP_DISCONNECTED);
+                continue;
+            }
+            if (mask & EPOLLIN) {
+                sub_on_readable(hub, sub);
+            }
+            if ((mask & EPOLLOUT) && sub->fd >= 0 && sub->blocked) {
+                sub->blocked = 0;
+                sub_mark_dirty(hub, sub);
+            }
+        }
+
+        if (hub->now_ms >= next_sweep) {
+            hub_sweep(hub);
+            next_sweep = hub->now_ms + (uint64_t)tick;
+        }
+        hub_flush_dirty(hub);
+        hub_bury(hub);
+    }
+    return NULL;
+}
+
+/* ---------------- Public API ---------------- */
+
+void sse_hub_get_default_config(sse_hub_config_t *config) {
+    if (!config) return;
+
+    memset(config, 0, sizeof(sse_hub_config_t));
+    config->max_subscribers = 32768;
+    config->queue_events = 64;
+    config->heartbeat_ms = 15000;
+    config->stall_timeout_ms = 30000;
+}
+
+int sse_hub_parse_config(sse_hub_config_t *config) {
+    if (!config) return -1;
+
+    config->max_subscribers = env_positive_int("GATEWAY_SSE_MAX_SUBSCRIBERS",
+                                               config->max_subscribers);
+    config->queue_events = env_positive_int("GATEWAY_SSE_QUEUE_EVENTS", config->queue_events);
+    config->heartbeat_ms = env_positive_int("GATEWAY_SSE_HEARTBEAT_MS", config->heartbeat_ms);
+    config->stall_timeout_ms = env_positive_int("GATEWAY_SSE_STALL_TIMEOUT_MS",
+                                                config->stall_timeout_ms);
+    return 0;
+}
+
+sse_hub_t *sse_hub_create(const sse_hub_config_t *config) {
+    if (!config || config->max_subscribers <= 0 || config->queue_events <= 0 ||
+        config->heartbeat_ms <= 0 || config->stall_timeout_ms <= 0) {
+        return NULL;
+    }
+
+    sse_hub_t *hub = calloc(1, sizeof(sse_hub_t));
+    if (!hub) return NULL;
+
+    hub->config = *config;
+    size_t ring = 1;
+    while (ring < (size_t)config->queue_events) {
+        ring <<= 1;
+    }
+    hub->ring_mask = ring - 1U;
+    atomic_init(&hub->stopping, 0);
+    atomic_init(&hub->inbox, NULL);
+    atomic_init(&hub->reserved, 0);
+    atomic_init(&hub->subscribed, 0);
+    atomic_init(&hub->refused, 0);
+    atomic_init(&hub->published, 0);
+    atomic_init(&hub->delivered, 0);
+    atomic_init(&hub->heartbeats, 0);
+    atomic_init(&hub->evicted_overflow, 0);
+    atomic_init(&hub->evicted_stalled, 0);
+    atomic_init(&hub->disconnected, 0);
+
+    hub->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    hub->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (hub->epoll_fd < 0 || hub->wake_fd < 0) {
+        if (hub->epoll_fd >= 0) close(hub->epoll_fd);
+        if (hub->wake_fd >= 0) close(hub->wake_fd);
+        free(hub);
+        return NULL;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = &wake_tag;
+    if (epoll_ctl(hub->epoll_fd, EPOLL_CTL_ADD, hub->wake_fd, &ev) != 0) {
+        close(hub->epoll_fd);
+        close(hub->wake_fd);
+        free(hub);
+        return NULL;
+    }
+    return hub;
+}
+
+int sse_hub_start(sse_hub_t *hub) {
+    if (!hub || hub->started) return -1;
+
+    /* Keep process signals on the caller's thread */
+    sigset_t block, saved;
+    sigemptyset(&block);
+    sigaddset(&block, SIGINT);
+    sigaddset(&block, SIGTERM);
+    sigaddset(&block, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &block, &saved);
+    int rc = pthread_create(&hub->thread, NULL, hub_thread_main, hub);
+    pthread_sigmask(SIG_SETMASK, &saved, NULL);
+
+    if (rc != 0) {
+        return -1;
+    }
+    hub->started = 1;
+    return 0;
+}
+
+int sse_hub_subscribe(sse_hub_t *hub, int fd, const char *tenant_id) {
+    if (!hub || fd < 0 || atomic_load(&hub->stopping)) {
+        return -1;
+    }
+    if (atomic_fetch_add_explicit(&hub->reserved, 1, memory_order_relaxed) >=
+        hub->config.max_subscribers) {
+        atomic_fetch_sub_explicit(&hub->reserved, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&hub->refused, 1, memory_order_relaxed);
+        return -1;
+    }
+
+    hub_sub_t *sub = calloc(1, sizeof(hub_sub_t) + (hub->ring_mask + 1U) * sizeof(hub_event_t *));
+    if (!sub) {
+        atomic_fetch_sub_explicit(&hub->reserved, 1, memory_order_relaxed);
+        return -1;
+    }
+    sub->op.kind = HUB_OP_SUBSCRIBE;
+    sub->fd = fd;
+    copy_tenant(sub->tenant_id, tenant_id);
+    atomic_fetch_add_explicit(&hub->subscribed, 1, memory_order_relaxed);
+    inbox_push(hub, &sub->op);
+    return 0;
+}
+
+int sse_hub_publish(sse_hub_t *hub, const char *tenant_id, const char *event,
+                    const char *data, size_t len) {
+    if (!hub || !event || (!data && len > 0) || atomic_load(&hub->stopping)) {
+        return -1;
+    }
+
+    /* "event: <event>\ndata: <data>\n\n" */
+    size_t elen = strlen(event);
+    size_t frame_len = 7U + elen + 7U + len + 2U;
+    hub_event_t *ev = malloc(sizeof(hub_event_t) + frame_len);
+    if (!ev) {
+        return -1;
+    }
+    memset(ev, 0, sizeof(hub_event_t));
+    ev->op.kind = HUB_OP_PUBLISH;
+    copy_tenant(ev->tenant_id, tenant_id);
+    ev->frame = (char *)(ev + 1);
+    ev->len = frame_len;
+
+    char *p = ev->frame;
+    memcpy(p, "event: ", 7U);
+    p += 7;
+    memcpy(p, event, elen);
+    p += elen;
+    memcpy(p, "\ndata: ", 7U);
+    p += 7;
+    if (len > 0) {
+        memcpy(p, data, len);
+        p += len;
+    }
+    memcpy(p, "\n\n", 2U);
+
+    atomic_fetch_add_explicit(&hub->published, 1, memory_order_relaxed);
+    inbox_push(hub, &ev->op);
+    return 0;
+}
+
+int sse_hub_get_stats(const sse_hub_t *hub, sse_hub_stats_t *stats) {
+    if (!hub || !stats) return -1;
+
+    memset(stats, 0, sizeof(*stats));
+    int64_t reserved = atomic_load_explicit(&hub->reserved, memory_order_relaxed);
+    stats->subscribers = reserved > 0 ? (uint64_t)reserved : 0U;
+    stats->subscribed = atomic_load_explicit(&hub->subscribed, memory_order_relaxed);
+    stats->refused = atomic_load_explicit(&hub->refused, memory_order_relaxed);
+    stats->published = atomic_load_explicit(&hub->published, memory_order_relaxed);
+    stats->delivered = atomic_load_explicit(&hub->delivered, memory_order_relaxed);
+    stats->heartbeats = atomic_load_explicit(&hub->heartbeats, memory_order_relaxed);
+    stats->evicted_overflow = atomic_load_explicit(&hub->evicted_overflow, memory_order_relaxed);
+    stats->evicted_stalled = atomic_load_explicit(&hub->evicted_stalled, memory_order_relaxed);
+    stats->disconnected = atomic_load_explicit(&hub->disconnected, memory_order_relaxed);
+    return 0;
+}
+
+void sse_hub_destroy(sse_hub_t *hub) {
+    if (!hub) return;
+
+    atomic_store(&hub->stopping, 1);
+    if (hub->started) {
+        uint64_t one = 1;
+        (void)write(hub->wake_fd, &one, sizeof(one));
+        pthread_join(hub->thread, NULL);
+    }
+
+    /* Subscriptions still in the inbox were accepted: the hub owns their fds */
+    hub_op_t *op = atomic_exchange(&hub->inbox, NULL);
+    while (op) {
+        hub_op_t *next = op->next;
+        if (op->kind == HUB_OP_SUBSCRIBE) {
+            close(((hub_sub_t *)op)->fd);
+        }
+        free(op);
+        op = next;
+    }
+
+    while (hub->subs) {
+        sub_drop(hub, hub->subs, DROP_SHUTDOWN);
+    }
+    hub_flush_dirty(hub);                /* Moves dropped members to the graveyard */
+    hub_bury(hub);
+
+    close(hub->epoll_fd);
+    close(hub->wake_fd);
+    free(hub);
+}
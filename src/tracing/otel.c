@@ -1,5 +1,6 @@
 #include "otel.h"
 #include "otlp_exporter.h"
+#include "request_arena.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -68,7 +69,7 @@ static void generate_trace_id(trace_id_t *trace_id) {
 otel_span_t* otel_span_start(const char *name, span_kind_t kind, otel_span_t *parent) {
     if (!name) return NULL;
     
-    otel_span_t *span = calloc(1, sizeof(otel_span_t));
+    otel_span_t *span = request_arena_scratch_calloc(1, sizeof(otel_span_t));
     if (!span) return NULL;
     
     strncpy(span->name, name, sizeof(span->name) - 1);
@@ -104,7 +105,7 @@ void otel_span_end(otel_span_t *span) {
         otlp_exporter_export_span(span);
     }
     
-    free(span);
+    request_arena_scratch_free(span);
 }
 
 void otel_span_set_attribute(otel_span_t *span, const char *key, const char *value) {
@@ -1,7 +1,9 @@
 #include "otlp_exporter.h"
+#include "request_arena.h"
 
 #ifdef HAVE_CURL
 #include <curl/curl.h>
+#include <pthread.h>
 #endif
 #include <jansson.h>
 #include <string.h>
@@ -12,6 +14,8 @@ static char otlp_endpoint[256];
 static otlp_mode_t export_mode = OTLP_MODE_HTTP;
 #ifdef HAVE_CURL
 static CURL *curl_handle = NULL;
+/* An easy handle must not be used by two threads at once */
+static pthread_mutex_t curl_lock = PTHREAD_MUTEX_INITIALIZER;
 #endif
 static bool exporter_initialized = false;
 
@@ -222,6 +226,7 @@ int otlp_exporter_export_span(const otel_span_t *span) {
     struct curl_slist *headers = NULL;
     headers = curl_slist_append(headers, "Content-Type: application/json");
     
+    pthread_mutex_lock(&curl_lock);
     curl_easy_setopt(curl_handle, CURLOPT_URL, otlp_endpoint);
     curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, json_str);
     curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, headers);
@@ -230,8 +235,9 @@ int otlp_exporter_export_span(const otel_span_t *span) {
     
     // Don't fail if collector is unavailable (graceful degradation)
     CURLcode res = curl_easy_perform(curl_handle);
+    pthread_mutex_unlock(&curl_lock);
     
-    free(json_str);
+    request_arena_scratch_free(json_str);
     curl_slist_free_all(headers);
     
     // Return 0 even on error to avoid breaking request flow
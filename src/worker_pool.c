@@ -0,0 +1,280 @@
+/**
+ * worker_pool.c - Bounded worker pool with deadline-aware admission
+ *
+ * The queue is a bounded MPMC ring in the style of Vyukov's: every slot
+ * carries a sequence number telling producers and consumers whose turn
+ * it is, so both sides claim slots with one CAS on their own cursor and
+ * never take a lock. A counting semaphore, posted once per task, lets
+ * idle workers sleep.
+ */
+
+#define _GNU_SOURCE
+#include "worker_pool.h"
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define WORKER_POOL_MAX_THREADS 256
+#define WORKER_POOL_CACHE_LINE  64
+
+typedef struct {
+    atomic_size_t seq;               /* == pos: free for producer at pos;
+                                        == pos + 1: filled, consumer's turn */
+    void *task;
+    uint64_t deadline_ms;
+    uint64_t enqueued_us;
+} pool_slot_t;
+
+struct worker_pool_t {
+    worker_pool_config_t config;
+    pool_slot_t *slots;
+    size_t mask;
+
+    _Alignas(WORKER_POOL_CACHE_LINE) atomic_size_t head;   /* Next slot to fill */
+    _Alignas(WORKER_POOL_CACHE_LINE) atomic_size_t tail;   /* Next slot to drain */
+
+    _Alignas(WORKER_POOL_CACHE_LINE) sem_t ready;          /* One post per task */
+    atomic_int stopping;
+    pthread_t *threads;
+    int num_started;
+
+    atomic_uint_fast64_t submitted;
+    atomic_uint_fast64_t rejected;
+    atomic_uint_fast64_t completed;
+    atomic_uint_fast64_t expired;
+    atomic_int_fast64_t depth;
+    atomic_uint_fast64_t sojourn_us_total;
+};
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+uint64_t worker_pool_now_ms(void) {
+    return now_us() / 1000ULL;
+}
+
+static size_t round_up_pow2(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+static int ring_push(worker_pool_t *pool, void *task, uint64_t deadline_ms) {
+    size_t pos = atomic_load_explicit(&pool->head, memory_order_relaxed);
+    pool_slot_t *slot;
+
+    for (;;) {
+        slot = &pool->slots[pos & pool->mask];
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&pool->head, &pos, pos + 1U,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (dif < 0) {
+            return -1;               /* Full: the consumer has not freed this slot */
+        } else {
+            pos = atomic_load_explicit(&pool->head, memory_order_relaxed);
+        }
+    }
+
+    slot->task = task;
+    slot->deadline_ms = deadline_ms;
+    slot->enqueued_us = now_us();
+    atomic_store_explicit(&slot->seq, pos + 1U, memory_order_release);
+    return 0;
+}
+
+static int ring_pop(worker_pool_t *pool, pool_slot_t *out) {
+    size_t pos = atomic_load_explicit(&pool->tail, memory_order_relaxed);
+    pool_slot_t *slot;
+
+    for (;;) {
+        slot = &pool->slots[pos & pool->mask];
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1U);
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&pool->tail, &pos, pos + 1U,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (dif < 0) {
+            return -1;               /* Empty */
+        } else {
+            pos = atomic_load_explicit(&pool->tail, memory_order_relaxed);
+        }
+    }
+
+    out->task = slot->task;
+    out->deadline_ms = slot->deadline_ms;
+    out->enqueued_us = slot->enqueued_us;
+    /* Hand the slot to the producer one lap ahead */
+    atomic_store_explicit(&slot->seq, pos + pool->mask + 1U, memory_order_release);
+    return 0;
+}
+
+static void *worker_main(void *arg) {
+    worker_pool_t *pool = (worker_pool_t *)arg;
+
+    if (pool->config.thread_init) {
+        pool->config.thread_init(pool->config.user_data);
+    }
+
+    for (;;) {
+        if (sem_wait(&pool->ready) != 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        /* Every post stands for a task, but a producer that claimed an
+         * earlier slot may not have published it yet; wait for it rather
+         * than strand the task. Once stopping, submissions have ended, so
+         * an empty ring means the post came from destroy. */
+        pool_slot_t item;
+        int empty;
+        while ((empty = ring_pop(pool, &item)) != 0 && !atomic_load(&pool->stopping)) {
+            sched_yield();
+        }
+        if (empty) {
+            break;
+        }
+        atomic_fetch_sub_explicit(&pool->depth, 1, memory_order_relaxed);
+
+        uint64_t now = now_us();
+        uint64_t sojourn_us = now > item.enqueued_us ? now - item.enqueued_us : 0U;
+        atomic_fetch_add_explicit(&pool->sojourn_us_total, sojourn_us, memory_order_relaxed);
+
+        if (now / 1000ULL > item.deadline_ms) {
+            atomic_fetch_add_explicit(&pool->expired, 1, memory_order_relaxed);
+            pool->config.shed(item.task, sojourn_us, pool->config.user_data);
+        } else {
+            atomic_fetch_add_explicit(&pool->completed, 1, memory_order_relaxed);
+            pool->config.run(item.task, sojourn_us, pool->config.user_data);
+        }
+    }
+    return NULL;
+}
+
+worker_pool_t *worker_pool_create(const worker_pool_config_t *config) {
+    if (!config || !config->run || !config->shed || config->queue_capacity == 0) {
+        return NULL;
+    }
+
+    worker_pool_t *pool = calloc(1, sizeof(worker_pool_t));
+    if (!pool) {
+        return NULL;
+    }
+    pool->config = *config;
+    if (pool->config.num_threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        pool->config.num_threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (pool->config.num_threads > WORKER_POOL_MAX_THREADS) {
+        pool->config.num_threads = WORKER_POOL_MAX_THREADS;
+    }
+
+    size_t capacity = round_up_pow2(config->queue_capacity);
+    pool->slots = calloc(capacity, sizeof(pool_slot_t));
+    pool->threads = calloc((size_t)pool->config.num_threads, sizeof(pthread_t));
+    if (!pool->slots || !pool->threads || sem_init(&pool->ready, 0, 0) != 0) {
+        free(pool->slots);
+        free(pool->threads);
+        free(pool);
+        return NULL;
+    }
+    pool->mask = capacity - 1U;
+    for (size_t i = 0; i < capacity; i++) {
+        atomic_init(&pool->slots[i].seq, i);
+    }
+    atomic_init(&pool->head, 0);
+    atomic_init(&pool->tail, 0);
+    atomic_init(&pool->stopping, 0);
+    atomic_init(&pool->submitted, 0);
+    atomic_init(&pool->rejected, 0);
+    atomic_init(&pool->completed, 0);
+    atomic_init(&pool->expired, 0);
+    atomic_init(&pool->depth, 0);
+    atomic_init(&pool->sojourn_us_total, 0);
+
+    for (int i = 0; i < pool->config.num_threads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker_main, pool) != 0) {
+            worker_pool_destroy(pool);
+            return NULL;
+        }
+        pool->num_started++;
+    }
+    return pool;
+}
+
+int worker_pool_submit(worker_pool_t *pool, void *task, uint64_t deadline_ms) {
+    if (!pool || atomic_load_explicit(&pool->stopping, memory_order_relaxed)) {
+        return -1;
+    }
+    if (ring_push(pool, task, deadline_ms) != 0) {
+        atomic_fetch_add_explicit(&pool->rejected, 1, memory_order_relaxed);
+        return -1;
+    }
+    atomic_fetch_add_explicit(&pool->submitted, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&pool->depth, 1, memory_order_relaxed);
+    (void)sem_post(&pool->ready);
+    return 0;
+}
+
+int worker_pool_get_num_threads(const worker_pool_t *pool) {
+    return pool ? pool->num_started : 0;
+}
+
+uint64_t worker_pool_depth(const worker_pool_t *pool) {
+    if (!pool) {
+        return 0;
+    }
+    int64_t depth = atomic_load_explicit(&pool->depth, memory_order_relaxed);
+    return depth > 0 ? (uint64_t)depth : 0U;
+}
+
+int worker_pool_get_stats(const worker_pool_t *pool, worker_pool_stats_t *stats) {
+    if (!pool || !stats) {
+        return -1;
+    }
+    memset(stats, 0, sizeof(*stats));
+    stats->submitted = atomic_load_explicit(&pool->submitted, memory_order_relaxed);
+    stats->rejected = atomic_load_explicit(&pool->rejected, memory_order_relaxed);
+    stats->completed = atomic_load_explicit(&pool->completed, memory_order_relaxed);
+    stats->expired = atomic_load_explicit(&pool->expired, memory_order_relaxed);
+    stats->depth = worker_pool_depth(pool);
+    stats->sojourn_us_total = atomic_load_explicit(&pool->sojourn_us_total, memory_order_relaxed);
+    return 0;
+}
+
+void worker_pool_destroy(worker_pool_t *pool) {
+    if (!pool) return;
+
+    /* Each worker exits on a post that finds the queue empty */
+    atomic_store(&pool->stopping, 1);
+    for (int i = 0; i < pool->num_started; i++) {
+        (void)sem_post(&pool->ready);
+    }
+    for (int i = 0; i < pool->num_started; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    sem_destroy(&pool->ready);
+    free(pool->threads);
+    free(pool->slots);
+    free(pool);
+}
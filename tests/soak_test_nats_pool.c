@@ -2,6 +2,10 @@
  * soak_test_nats_pool.c - Long-running NATS pool stress test
  * 
  * Purpose: Validate NATS connection pool stability under sustained load
+ *
+ * Workers alternate between acquiring a connection and using the one
+ * bound to their thread. Built with USE_NATS_LIB each use publishes a
+ * message, so point NATS_URL at a server (a local stand-in will do).
  */
 
 #include "nats_pool.h"
@@ -13,6 +17,10 @@
 #include <signal.h>
 #include <sched.h>
 
+#ifdef USE_NATS_LIB
+#include <nats/nats.h>
+#endif
+
 static volatile int g_running = 1;
 static unsigned long g_total_acquired = 0;
 static unsigned long g_total_released = 0;
@@ -25,6 +33,16 @@ static void sigint_handler(int sig) {
     g_running = 0;
 }
 
+/* Send something on the connection; 0 on success */
+static int use_connection(nats_connection_t *conn) {
+#ifdef USE_NATS_LIB
+    natsConnection *nc = (natsConnection*)nats_pool_get_handle(conn);
+    return natsConnection_PublishString(nc, "soak.nats_pool", "ping") == NATS_OK ? 0 : -1;
+#else
+    return nats_pool_get_handle(conn) != NULL ? 0 : -1;
+#endif
+}
+
 static void* worker_thread(void *arg) {
     nats_pool_t *pool = (nats_pool_t*)arg;
     unsigned long local_acquired = 0;
@@ -39,6 +57,11 @@ static void* worker_thread(void *arg) {
             local_acquired++;
             __sync_fetch_and_add(&g_total_acquired, 1);
             
+            if (use_connection(conn) != 0) {
+                local_errors++;
+                __sync_fetch_and_add(&g_errors, 1);
+            }
+            
             /* Simulate work - small delay */
             usleep((unsigned int)(rand() % 5000));  /* 0-5ms */
             
@@ -51,6 +74,13 @@ static void* worker_thread(void *arg) {
             __sync_fetch_and_add(&g_total_timeouts, 1);
         }
         
+        /* The thread's own connection, taken without the pool lock */
+        nats_connection_t *mine = nats_pool_thread_connection(pool);
+        if (!mine || use_connection(mine) != 0) {
+            local_errors++;
+            __sync_fetch_and_add(&g_errors, 1);
+        }
+        
         /* Occasional yield */
         if (local_acquired % 100 == 0) {
             sched_yield();
@@ -79,15 +109,21 @@ int main(int argc, char *argv[]) {
     printf("========================================\n");
     printf("Duration:  %d seconds\n", duration_sec);
     printf("Threads:   %d\n", num_threads);
+    printf("Server:    %s\n", getenv("NATS_URL") ? getenv("NATS_URL") : "nats://localhost:4222");
     printf("Press Ctrl+C to stop early\n");
     printf("\n");
     
     /* Setup signal handler */
     signal(SIGINT, sigint_handler);
     
+    const char *url = getenv("NATS_URL");
+    if (!url || !*url) {
+        url = "nats://localhost:4222";
+    }
+    
     /* Create pool */
     nats_pool_config_t config = {
-        .nats_url = "nats://localhost:4222",  /* Stub - won't actually connect */
+        .nats_url = url,
         .min_connections = 4,
         .max_connections = 16,
         .connection_timeout_ms = 5000,
@@ -125,9 +161,10 @@ int main(int argc, char *argv[]) {
             
             double rate = (double)current_acquired / (double)(now - start);
             
-            printf("[%lds] acquired=%lu, released=%lu, timeouts=%lu, rate=%.0f/s, pool: %zu active, %zu idle\n",
+            printf("[%lds] acquired=%lu, released=%lu, timeouts=%lu, rate=%.0f/s, pool: %zu active, %zu idle, %zu/%zu healthy, %zu bound\n",
                    now - start, current_acquired, current_released, current_timeouts,
-                   rate, stats.active_connections, stats.idle_connections);
+                   rate, stats.active_connections, stats.idle_connections,
+                   stats.healthy_connections, stats.open_connections, stats.bound_threads);
             
             last_report = now;
         }
@@ -165,6 +202,8 @@ int main(int argc, char *argv[]) {
     printf("  Pool released:    %zu\n", stats.total_released);
     printf("  Pool timeouts:    %zu\n", stats.acquire_timeouts);
     printf("  Health failures:  %zu\n", stats.health_check_failures);
+    printf("  Bound threads:    %zu\n", stats.bound_threads);
+    printf("  Rebinds:          %zu\n", stats.rebinds);
     printf("\nRate:               %.0f ops/sec\n", (double)g_total_acquired / (double)elapsed);
     
     /* Validate */
@@ -172,7 +211,9 @@ int main(int argc, char *argv[]) {
     int pool_mismatch = (stats.total_acquired != stats.total_released);
     int connections_still_active = (stats.active_connections > stats.idle_connections);
     
-    if (leak_detected) {
+    if (g_errors > 0) {
+        printf("\n❌ FAILURE: %lu operations on pooled connections failed\n", g_errors);
+    } else if (leak_detected) {
         printf("\n❌ FAILURE: Leak detected (acquired != released)\n");
     } else if (pool_mismatch) {
         printf("\n❌ FAILURE: Pool mismatch (pool stats inconsistent)\n");
@@ -184,5 +225,5 @@ int main(int argc, char *argv[]) {
     
     nats_pool_destroy(pool);
     
-    return (leak_detected || pool_mismatch || connections_still_active) ? 1 : 0;
+    return (g_errors > 0 || leak_detected || pool_mismatch || connections_still_active) ? 1 : 0;
 }
@@ -0,0 +1,313 @@
+/**
+ * test_admin_view_cache.c - Background-refreshed admin view cache tests
+ */
+
+#define _GNU_SOURCE
+#include "admin_view_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+
+#define MAX_PENDING 16
+
+enum { PARK = 0, INLINE_AT_NOW, INLINE_CLOCK };
+
+/* Fetches are parked here and published by the test, or published
+ * before fetch returns, at ft->now or on the real clock */
+typedef struct {
+    admin_view_fetch_t *pending[MAX_PENDING];
+    char keys[MAX_PENDING][64];
+    int num_pending;
+    int fetches;
+    int mode;
+    uint64_t now;
+} fetcher_t;
+
+static void fetch(admin_view_fetch_t *f, const char *key, size_t key_len, void *arg) {
+    fetcher_t *ft = arg;
+    __atomic_add_fetch(&ft->fetches, 1, __ATOMIC_RELAXED);
+    if (ft->mode != PARK) {
+        char body[96];
+        int n = snprintf(body, sizeof(body), "{\"key\":\"%.*s\",\"n\":%d}", (int)key_len, key,
+                         __atomic_load_n(&ft->fetches, __ATOMIC_RELAXED));
+        if (ft->mode == INLINE_CLOCK) {
+            admin_view_cache_publish(f, 200, body, (size_t)n);
+        } else {
+            admin_view_cache_publish_at(f, 200, body, (size_t)n, ft->now);
+        }
+        return;
+    }
+    assert(ft->num_pending < MAX_PENDING);
+    snprintf(ft->keys[ft->num_pending], sizeof(ft->keys[0]), "%.*s", (int)key_len, key);
+    ft->pending[ft->num_pending++] = f;
+}
+
+/* Publish the oldest parked fetch */
+static void publish(fetcher_t *ft, int status, const char *body, uint64_t now_ms) {
+    assert(ft->num_pending > 0);
+    admin_view_fetch_t *f = ft->pending[0];
+    ft->num_pending--;
+    memmove(&ft->pending[0], &ft->pending[1], (size_t)ft->num_pending * sizeof(ft->pending[0]));
+    memmove(&ft->keys[0], &ft->keys[1], (size_t)ft->num_pending * sizeof(ft->keys[0]));
+    admin_view_cache_publish_at(f, status, body, body ? strlen(body) : 0, now_ms);
+}
+
+static admin_view_cache_t *make_cache(fetcher_t *ft, int refresh_ms, int max_stale_ms, int idle_ms,
+                                      int max_views) {
+    admin_view_cache_config_t config;
+    admin_view_cache_get_default_config(&config);
+    config.refresh_ms = refresh_ms;
+    config.max_stale_ms = max_stale_ms;
+    config.idle_ms = idle_ms;
+    config.max_views = max_views;
+    config.background = 0;
+    memset(ft, 0, sizeof(*ft));
+    admin_view_cache_t *c = admin_view_cache_create(&config, fetch, ft);
+    assert(c != NULL);
+    return c;
+}
+
+static admin_view_result_t get(admin_view_cache_t *c, const char *key, admin_view_waiter_fn fn, void *arg,
+                               const admin_view_t **view, uint64_t now_ms) {
+    return admin_view_cache_get_at(c, key, strlen(key), fn, arg, view, now_ms);
+}
+
+typedef struct {
+    int calls;
+    int status;
+    char body[64];
+} woken_t;
+
+static void on_woken(const admin_view_t *v, void *arg) {
+    woken_t *w = arg;
+    w->calls++;
+    w->status = v ? v->status : -1;
+    if (v) {
+        snprintf(w->body, sizeof(w->body), "%s", v->body);
+        admin_view_release(v);
+    }
+}
+
+static void test_first_fetch_coalesced(void) {
+    printf("Test: reads of a new view share its first fetch... ");
+
+    fetcher_t ft;
+    admin_view_cache_t *c = make_cache(&ft, 1000, 10000, 60000, 16);
+    const admin_view_t *view;
+    woken_t a, b;
+    memset(&a, 0, sizeof(a));
+    memset(&b, 0, sizeof(b));
+
+    assert(get(c, "health", on_woken, &a, &view, 0) == ADMIN_VIEW_WAITING);
+    assert(get(c, "health", on_woken, &b, &view, 1) == ADMIN_VIEW_WAITING);
+    assert(view == NULL && ft.fetches == 1 && strcmp(ft.keys[0], "health") == 0);
+    publish(&ft, 200, "{\"ok\":true}", 5);
+    assert(a.calls == 1 && b.calls == 1 && a.status == 200 && strcmp(b.body, "{\"ok\":true}") == 0);
+
+    assert(get(c, "health", NULL, NULL, &view, 10) == ADMIN_VIEW_HIT);
+    assert(view->status == 200 && view->len == 11 && strcmp(view->body, "{\"ok\":true}") == 0);
+    char etag[ADMIN_VIEW_ETAG_MAX];
+    admin_view_etag(200, "{\"ok\":true}", 11, etag);
+    assert(strcmp(view->etag, etag) == 0 && strlen(etag) == 18);
+    admin_view_release(view);
+
+    /* A read without a waiter cannot wait */
+    assert(get(c, "other", NULL, NULL, &view, 10) == ADMIN_VIEW_ERROR);
+
+    admin_view_cache_stats_t st;
+    assert(admin_view_cache_get_stats(c, &st) == 0);
+    assert(st.misses == 1 && st.coalesced == 1 && st.hits == 1 && st.refreshes == 1 && st.views == 1);
+    admin_view_cache_destroy(c);
+    printf("OK\n");
+}
+
+static void test_stale_while_revalidate(void) {
+    printf("Test: stale views are served while one refetch runs... ");
+
+    fetcher_t ft;
+    admin_view_cache_t *c = make_cache(&ft, 1000, 10000, 60000, 16);
+    const admin_view_t *view;
+    woken_t w;
+    memset(&w, 0, sizeof(w));
+
+    assert(get(c, "cb", on_woken, &w, &view, 0) == ADMIN_VIEW_WAITING);
+    publish(&ft, 200, "v1", 0);
+    char etag_v1[ADMIN_VIEW_ETAG_MAX];
+    assert(get(c, "cb", NULL, NULL, &view, 999) == ADMIN_VIEW_HIT);
+    memcpy(etag_v1, view->etag, sizeof(etag_v1));
+    admin_view_release(view);
+    assert(ft.fetches == 1);
+
+    /* Past refresh_ms: old answer now, one refetch behind it */
+    assert(get(c, "cb", NULL, NULL, &view, 1000) == ADMIN_VIEW_HIT);
+    assert(strcmp(view->body, "v1") == 0);
+    admin_view_release(view);
+    assert(get(c, "cb", NULL, NULL, &view, 1001) == ADMIN_VIEW_HIT);
+    admin_view_release(view);
+    assert(ft.fetches == 2 && ft.num_pending == 1);
+    publish(&ft, 200, "v2", 1100);
+    assert(get(c, "cb", NULL, NULL, &view, 1200) == ADMIN_VIEW_HIT);
+    assert(strcmp(view->body, "v2") == 0 && strcmp(view->etag, etag_v1) != 0);
+    admin_view_release(view);
+
+    /* A failed refetch keeps the old answer */
+    assert(get(c, "cb", NULL, NULL, &view, 2100) == ADMIN_VIEW_HIT);
+    admin_view_release(view);
+    publish(&ft, 0, NULL, 2100);
+    assert(get(c, "cb", NULL, NULL, &view, 2200) == ADMIN_VIEW_HIT);
+    assert(strcmp(view->body, "v2") == 0);
+    admin_view_release(view);
+    assert(ft.num_pending == 1);
+    publish(&ft, 0, NULL, 2200);
+
+    /* Too old to serve: reads wait for the refetch */
+    assert(get(c, "cb", on_woken, &w, &view, 11100) == ADMIN_VIEW_WAITING);
+    assert(view == NULL && ft.num_pending == 1);
+    publish(&ft, 200, "v3", 11200);
+    assert(w.calls == 2 && strcmp(w.body, "v3") == 0);
+
+    admin_view_cache_stats_t st;
+    assert(admin_view_cache_get_stats(c, &st) == 0);
+    assert(st.stale_hits == 4 && st.refresh_failures == 2 && st.refreshes == 3);
+    admin_view_cache_destroy(c);
+    printf("OK\n");
+}
+
+static void test_failed_first_fetch(void) {
+    printf("Test: a failed first fetch wakes readers empty-handed... ");
+
+    fetcher_t ft;
+    admin_view_cache_t *c = make_cache(&ft, 1000, 10000, 60000, 16);
+    const admin_view_t *view;
+    woken_t w;
+    memset(&w, 0, sizeof(w));
+
+    assert(get(c, "cx", on_woken, &w, &view, 0) == ADMIN_VIEW_WAITING);
+    publish(&ft, 0, NULL, 0);
+    assert(w.calls == 1 && w.status == -1);
+    /* The next read tries again */
+    assert(get(c, "cx", on_woken, &w, &view, 1) == ADMIN_VIEW_WAITING);
+    assert(ft.fetches == 2);
+    publish(&ft, 404, "{\"ok\":false}", 1);
+    assert(w.calls == 2 && w.status == 404);
+    admin_view_cache_destroy(c);
+    printf("OK\n");
+}
+
+static void test_tick_refreshes_and_drops(void) {
+    printf("Test: the refresher refetches read views and drops idle ones... ");
+
+    fetcher_t ft;
+    admin_view_cache_t *c = make_cache(&ft, 1000, 10000, 5000, 2);
+    const admin_view_t *view;
+    woken_t w;
+    memset(&w, 0, sizeof(w));
+    ft.mode = INLINE_AT_NOW;
+
+    assert(get(c, "a", on_woken, &w, &view, 0) == ADMIN_VIEW_WAITING);
+    assert(get(c, "b", on_woken, &w, &view, 0) == ADMIN_VIEW_WAITING);
+    assert(w.calls == 2 && ft.fetches == 2);
+    /* Bounded number of views */
+    assert(get(c, "c", on_woken, &w, &view, 0) == ADMIN_VIEW_ERROR);
+
+    admin_view_cache_tick_at(c, 999);
+    assert(ft.fetches == 2);
+    ft.now = 1000;
+    admin_view_cache_tick_at(c, 1000);
+    assert(ft.fetches == 4);
+
+    /* Keep reading a; b goes idle and is dropped */
+    for (uint64_t t = 2000; t <= 6000; t += 1000) {
+        ft.now = t;
+        admin_view_cache_tick_at(c, t);
+        assert(get(c, "a", NULL, NULL, &view, t) == ADMIN_VIEW_HIT);
+        admin_view_release(view);
+    }
+    admin_view_cache_stats_t st;
+    assert(admin_view_cache_get_stats(c, &st) == 0);
+    assert(st.views == 1 && st.stale_hits == 0);
+    assert(get(c, "a", NULL, NULL, &view, 6100) == ADMIN_VIEW_HIT);
+    assert(strncmp(view->body, "{\"key\":\"a\",", 9) == 0);
+    admin_view_release(view);
+    assert(get(c, "c", on_woken, &w, &view, 6100) == ADMIN_VIEW_WAITING);
+    admin_view_cache_destroy(c);
+    printf("OK\n");
+}
+
+static void test_etag_matches(void) {
+    printf("Test: If-None-Match lists are matched weakly... ");
+
+    const char *etag = "\"0123456789abcdef\"";
+#define MATCH(s) admin_view_etag_matches(etag, s, strlen(s))
+    assert(MATCH("\"0123456789abcdef\""));
+    assert(MATCH("W/\"0123456789abcdef\""));
+    assert(MATCH("\"x\", \"0123456789abcdef\""));
+    assert(MATCH(" \"x\",W/\"0123456789abcdef\" "));
+    assert(MATCH("*"));
+    assert(!MATCH(""));
+    assert(!MATCH("\"0123456789abcde\""));
+    assert(!MATCH("0123456789abcdef"));
+    assert(!MATCH("\"0123456789abcdef"));
+    assert(!MATCH("\"x\", \"y\""));
+#undef MATCH
+    assert(!admin_view_etag_matches(etag, NULL, 0));
+    printf("OK\n");
+}
+
+static void test_background_and_shutdown(void) {
+    printf("Test: background refresher runs and shutdown leaves no fetch behind... ");
+
+    admin_view_cache_config_t config;
+    admin_view_cache_get_default_config(&config);
+    config.refresh_ms = 20;
+    config.max_stale_ms = 1000;
+    fetcher_t ft;
+    memset(&ft, 0, sizeof(ft));
+    ft.mode = INLINE_CLOCK;
+    admin_view_cache_t *c = admin_view_cache_create(&config, fetch, &ft);
+    assert(c != NULL);
+
+    const admin_view_t *view;
+    woken_t w;
+    memset(&w, 0, sizeof(w));
+    assert(admin_view_cache_get(c, "live", 4, on_woken, &w, &view) == ADMIN_VIEW_WAITING);
+    assert(w.calls == 1 && w.status == 200);
+    usleep(200000);
+    assert(__atomic_load_n(&ft.fetches, __ATOMIC_RELAXED) >= 3);
+    assert(admin_view_cache_get(c, "live", 4, NULL, NULL, &view) == ADMIN_VIEW_HIT);
+    admin_view_cache_destroy(c);
+    /* Views outlive the cache while referenced */
+    assert(view->status == 200);
+    admin_view_release(view);
+
+    /* A fetch still out at destroy frees the rest when it lands */
+    c = make_cache(&ft, 1000, 10000, 60000, 16);
+    memset(&w, 0, sizeof(w));
+    assert(get(c, "slow", on_woken, &w, &view, 0) == ADMIN_VIEW_WAITING);
+    assert(get(c, "done", on_woken, &w, &view, 0) == ADMIN_VIEW_WAITING);
+    publish(&ft, 200, "x", 0);
+    admin_view_cache_destroy(c);
+    publish(&ft, 200, "late", 0);
+    assert(w.calls == 2 && w.status == -1);
+
+    assert(admin_view_cache_create(&config, NULL, NULL) == NULL);
+    config.max_stale_ms = 10;
+    assert(admin_view_cache_create(&config, fetch, &ft) == NULL);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("=== Admin View Cache Tests ===\n\n");
+
+    test_first_fetch_coalesced();
+    test_stale_while_revalidate();
+    test_failed_first_fetch();
+    test_tick_refreshes_and_drops();
+    test_etag_matches();
+    test_background_and_shutdown();
+
+    printf("\nAll tests passed!\n");
+    return 0;
+}
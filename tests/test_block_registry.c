@@ -0,0 +1,357 @@
+/**
+ * test_block_registry.c - Extension block registry store tests
+ */
+
+#define _GNU_SOURCE
+#include "block_registry.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define NUM_READERS 4
+
+static int put(block_registry_t *reg, const char *type, const char *version, const char *manifest) {
+    int created = -1;
+    int rc = block_registry_upsert(reg, type, strlen(type), version, strlen(version),
+                                   manifest, strlen(manifest), &created);
+    assert(rc == 0);
+    return created;
+}
+
+static const block_record_t *get(block_registry_t *reg, const char *type, const char *version) {
+    return block_registry_get(reg, type, strlen(type), version, strlen(version));
+}
+
+static void test_crud(void) {
+    printf("Test: insert, replace, lookup and delete... ");
+    block_registry_t *reg = block_registry_create();
+    assert(reg != NULL);
+
+    assert(put(reg, "llm", "1.0.0", "{\"a\":1}") == 1);
+    assert(put(reg, "llm", "2.0.0", "{\"a\":2}") == 1);
+    assert(get(reg, "llm", "3.0.0") == NULL);
+    assert(get(reg, "ll", "1.0.0") == NULL);
+
+    const block_record_t *r = get(reg, "llm", "1.0.0");
+    assert(r != NULL);
+    assert(strcmp(r->type, "llm") == 0 && strcmp(r->version, "1.0.0") == 0);
+    assert(r->manifest_len == 7 && strcmp(r->manifest, "{\"a\":1}") == 0);
+    assert(r->etag[0] == '"' && strlen(r->etag) == 18);
+
+    /* A held record outlives its replacement and its deletion */
+    assert(put(reg, "llm", "1.0.0", "{\"a\":10}") == 0);
+    const block_record_t *r2 = get(reg, "llm", "1.0.0");
+    assert(strcmp(r2->manifest, "{\"a\":10}") == 0);
+    assert(strcmp(r->etag, r2->etag) != 0);
+    assert(block_registry_delete(reg, "llm", 3, "1.0.0", 5) == 0);
+    assert(block_registry_delete(reg, "llm", 3, "1.0.0", 5) == -1);
+    assert(get(reg, "llm", "1.0.0") == NULL);
+    assert(strcmp(r->manifest, "{\"a\":1}") == 0);
+    assert(strcmp(r2->manifest, "{\"a\":10}") == 0);
+    block_record_release(r);
+    block_record_release(r2);
+
+    /* Same manifest, same tag */
+    assert(put(reg, "other", "1", "{\"a\":2}") == 1);
+    const block_record_t *x = get(reg, "other", "1");
+    const block_record_t *y = get(reg, "llm", "2.0.0");
+    assert(strcmp(x->etag, y->etag) == 0);
+    block_record_release(x);
+    block_record_release(y);
+
+    assert(block_registry_upsert(reg, "", 0, "1", 1, "{}", 2, NULL) == -1);
+    assert(block_registry_upsert(reg, "t", 1, "", 0, "{}", 2, NULL) == -1);
+
+    block_registry_stats_t st;
+    assert(block_registry_get_stats(reg, &st) == 0);
+    assert(st.entries == 2);
+    assert(st.bytes == strlen("llm2.0.0{\"a\":2}") + strlen("other1{\"a\":2}"));
+    block_registry_destroy(reg);
+    printf("OK\n");
+}
+
+static void test_growth(void) {
+    printf("Test: index grows past its initial size... ");
+    block_registry_t *reg = block_registry_create();
+    char version[32], manifest[64];
+    for (int i = 0; i < 5000; i++) {
+        snprintf(version, sizeof(version), "%d.0.0", i);
+        snprintf(manifest, sizeof(manifest), "{\"v\":%d}", i);
+        assert(put(reg, i % 2 ? "odd" : "even", version, manifest) == 1);
+    }
+    block_registry_stats_t st;
+    block_registry_get_stats(reg, &st);
+    assert(st.entries == 5000);
+    assert(st.buckets >= 5000);
+    for (int i = 0; i < 5000; i++) {
+        snprintf(version, sizeof(version), "%d.0.0", i);
+        snprintf(manifest, sizeof(manifest), "{\"v\":%d}", i);
+        const block_record_t *r = get(reg, i % 2 ? "odd" : "even", version);
+        assert(r != NULL && strcmp(r->manifest, manifest) == 0);
+        block_record_release(r);
+        assert(get(reg, i % 2 ? "even" : "odd", version) == NULL);
+    }
+    /* No reader is active, so nothing waits for reclamation */
+    put(reg, "even", "0.0.0", "{}");
+    block_registry_get_stats(reg, &st);
+    assert(st.retired == 0);
+    block_registry_destroy(reg);
+    printf("OK\n");
+}
+
+static void test_batch(void) {
+    printf("Test: batch upsert... ");
+    block_registry_t *reg = block_registry_create();
+    put(reg, "a", "1", "{\"old\":true}");
+
+    block_registry_item_t items[] = {
+        { "a", 1, "1", 1, "{\"n\":1}", 7, NULL },
+        { "b", 1, "1", 1, "{\"n\":2}", 7, NULL },
+        { "b", 1, "1", 1, "{\"n\":3}", 7, NULL },
+    };
+    int created[3];
+    assert(block_registry_upsert_batch(reg, items, 3, created) == 0);
+    assert(created[0] == 0 && created[1] == 1 && created[2] == 0);
+    const block_record_t *r = get(reg, "b", "1");
+    assert(strcmp(r->manifest, "{\"n\":3}") == 0);
+    block_record_release(r);
+
+    /* One bad item rejects the whole batch */
+    block_registry_item_t bad[] = {
+        { "c", 1, "1", 1, "{}", 2, NULL },
+        { "d", 1, "", 0, "{}", 2, NULL },
+    };
+    assert(block_registry_upsert_batch(reg, bad, 2, NULL) == -1);
+    assert(get(reg, "c", "1") == NULL);
+    assert(block_registry_upsert_batch(reg, NULL, 0, NULL) == 0);
+
+    /* A batch large enough to grow the index lands whole */
+    block_registry_item_t many[300];
+    char versions[300][16];
+    for (int i = 0; i < 300; i++) {
+        int n = snprintf(versions[i], sizeof(versions[i]), "%d", i);
+        many[i] = (block_registry_item_t){ "m", 1, versions[i], (size_t)n, "{}", 2, NULL };
+    }
+    assert(block_registry_upsert_batch(reg, many, 300, NULL) == 0);
+    block_registry_stats_t st;
+    block_registry_get_stats(reg, &st);
+    assert(st.entries == 302);
+    r = get(reg, "a", "1");
+    assert(strcmp(r->manifest, "{\"n\":1}") == 0);
+    block_record_release(r);
+    block_registry_destroy(reg);
+    printf("OK\n");
+}
+
+static void test_snapshot(void) {
+    printf("Test: snapshot round trip... ");
+    char path[] = "/tmp/test_block_registry_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+    unlink(path);
+
+    block_registry_t *reg = block_registry_create();
+    size_t loaded = 99;
+    assert(block_registry_load_snapshot(reg, path, &loaded) == 0);   /* Missing file */
+    assert(loaded == 0);
+
+    char version[32], manifest[64];
+    for (int i = 0; i < 200; i++) {
+        snprintf(version, sizeof(version), "1.%d", i);
+        snprintf(manifest, sizeof(manifest), "{\"i\":%d,\"pad\":\"%.*s\"}", i, i % 13, "xxxxxxxxxxxxx");
+        put(reg, "snap", version, manifest);
+    }
+    put(reg, "empty", "1", "");
+    assert(block_registry_save_snapshot(reg, path) == 0);
+
+    block_registry_t *copy = block_registry_create();
+    assert(block_registry_load_snapshot(copy, path, &loaded) == 0);
+    assert(loaded == 201);
+    for (int i = 0; i < 200; i++) {
+        snprintf(version, sizeof(version), "1.%d", i);
+        const block_record_t *a = get(reg, "snap", version);
+        const block_record_t *b = get(copy, "snap", version);
+        assert(a && b && a->manifest_len == b->manifest_len);
+        assert(memcmp(a->manifest, b->manifest, a->manifest_len) == 0);
+        assert(strcmp(a->etag, b->etag) == 0);
+        block_record_release(a);
+        block_record_release(b);
+    }
+    const block_record_t *e = get(copy, "empty", "1");
+    assert(e && e->manifest_len == 0);
+    block_record_release(e);
+
+    /* A truncated file is refused and leaves the registry alone */
+    FILE *f = fopen(path, "r+");
+    assert(f != NULL);
+    assert(ftruncate(fileno(f), 100) == 0);
+    fclose(f);
+    block_registry_t *broken = block_registry_create();
+    assert(block_registry_load_snapshot(broken, path, &loaded) == -1);
+    block_registry_stats_t st;
+    block_registry_get_stats(broken, &st);
+    assert(st.entries == 0);
+
+    unlink(path);
+    block_registry_destroy(broken);
+    block_registry_destroy(copy);
+    block_registry_destroy(reg);
+    printf("OK\n");
+}
+
+/* Attachments are heap copies of the manifest, counted as they come and go */
+static int g_attached;
+
+static void *attach_copy(const block_record_t *rec, void *arg) {
+    assert(arg == &g_attached);
+    g_attached++;
+    return strdup(rec->manifest);
+}
+
+static void detach_copy(void *attachment) {
+    g_attached--;
+    free(attachment);
+}
+
+static void *attachment(const char *manifest) {
+    g_attached++;
+    return strdup(manifest);
+}
+
+static void test_attachments(void) {
+    printf("Test: attachments live and die with their records... ");
+    char path[] = "/tmp/test_block_registry_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+
+    block_registry_t *reg = block_registry_create();
+    block_registry_set_hooks(reg, attach_copy, detach_copy, &g_attached);
+    block_registry_item_t items[] = {
+        { "a", 1, "1", 1, "{\"n\":1}", 7, attachment("given") },
+        { "a", 1, "2", 1, "{\"n\":2}", 7, NULL },
+    };
+    assert(block_registry_upsert_batch(reg, items, 2, NULL) == 0);
+    assert(g_attached == 2);
+    const block_record_t *r1 = get(reg, "a", "1");
+    const block_record_t *r2 = get(reg, "a", "2");
+    assert(strcmp(r1->attachment, "given") == 0);
+    assert(strcmp(r2->attachment, "{\"n\":2}") == 0);
+
+    /* A replaced record keeps its attachment while held */
+    put(reg, "a", "1", "{\"n\":3}");
+    assert(g_attached == 3);
+    assert(strcmp(r1->attachment, "given") == 0);
+    block_record_release(r1);
+    assert(g_attached == 2);
+    assert(block_registry_delete(reg, "a", 1, "2", 1) == 0);
+    assert(g_attached == 2);
+    block_record_release(r2);
+    assert(g_attached == 1);
+
+    /* A rejected batch frees what it was given */
+    block_registry_item_t bad[] = {
+        { "b", 1, "1", 1, "{}", 2, attachment("x") },
+        { "b", 1, "", 0, "{}", 2, attachment("y") },
+    };
+    assert(g_attached == 3);
+    assert(block_registry_upsert_batch(reg, bad, 2, NULL) == -1);
+    assert(g_attached == 1);
+
+    /* Loaded records get theirs from the hook */
+    assert(block_registry_save_snapshot(reg, path) == 0);
+    block_registry_t *copy = block_registry_create();
+    block_registry_set_hooks(copy, attach_copy, detach_copy, &g_attached);
+    assert(block_registry_load_snapshot(copy, path, NULL) == 0);
+    assert(g_attached == 2);
+    const block_record_t *r = get(copy, "a", "1");
+    assert(strcmp(r->attachment, "{\"n\":3}") == 0);
+    block_record_release(r);
+
+    unlink(path);
+    block_registry_destroy(copy);
+    block_registry_destroy(reg);
+    assert(g_attached == 0);
+    printf("OK\n");
+}
+
+typedef struct {
+    block_registry_t *reg;
+    volatile int stop;
+    long lookups;
+} reader_arg_t;
+
+static void *reader(void *p) {
+    reader_arg_t *a = p;
+    char version[32];
+    unsigned seed = 7;
+    while (!__atomic_load_n(&a->stop, __ATOMIC_ACQUIRE)) {
+        snprintf(version, sizeof(version), "%u", (unsigned)rand_r(&seed) % 64U);
+        const block_record_t *r = get(a->reg, "hot", version);
+        if (r) {
+            /* Every manifest names its own version */
+            char expect[48];
+            int n = snprintf(expect, sizeof(expect), "{\"version\":\"%s\"", version);
+            assert(strncmp(r->manifest, expect, (size_t)n) == 0);
+            block_record_release(r);
+        }
+        a->lookups++;
+    }
+    return NULL;
+}
+
+static void test_concurrent_readers(void) {
+    printf("Test: lookups race a writer... ");
+    block_registry_t *reg = block_registry_create();
+    reader_arg_t args[NUM_READERS];
+    pthread_t threads[NUM_READERS];
+    for (int i = 0; i < NUM_READERS; i++) {
+        args[i] = (reader_arg_t){ reg, 0, 0 };
+        pthread_create(&threads[i], NULL, reader, &args[i]);
+    }
+
+    char version[32], manifest[96], cold[32];
+    for (int round = 0; round < 20000; round++) {
+        snprintf(version, sizeof(version), "%d", round % 64);
+        snprintf(manifest, sizeof(manifest), "{\"version\":\"%d\",\"round\":%d}", round % 64, round);
+        put(reg, "hot", version, manifest);
+        if (round % 7 == 0) {
+            block_registry_delete(reg, "hot", 3, version, strlen(version));
+        }
+        /* Keep the index growing under the readers */
+        snprintf(cold, sizeof(cold), "%d", round);
+        if (round % 4 == 0) put(reg, "cold", cold, "{}");
+    }
+
+    for (int i = 0; i < NUM_READERS; i++) {
+        __atomic_store_n(&args[i].stop, 1, __ATOMIC_RELEASE);
+        pthread_join(threads[i], NULL);
+        assert(args[i].lookups > 0);
+    }
+    /* The readers are gone, so the next write frees everything retired */
+    put(reg, "hot", "0", "{\"version\":\"0\"}");
+    block_registry_stats_t st;
+    block_registry_get_stats(reg, &st);
+    assert(st.retired == 0);
+    assert(st.entries > 5000 && st.entries <= 5064);
+    block_registry_destroy(reg);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("=== Block Registry Tests ===\n\n");
+
+    test_crud();
+    test_growth();
+    test_batch();
+    test_snapshot();
+    test_attachments();
+    test_concurrent_readers();
+
+    printf("\nAll tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,186 @@
+/**
+ * test_http_parser.c - Incremental HTTP request head parser tests
+ */
+
+#include "http_parser.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+static int span_is(const char *buf, http_span_t span, const char *expect) {
+    return span.len == strlen(expect) && memcmp(buf + span.off, expect, span.len) == 0;
+}
+
+static void test_scan(void) {
+    printf("Test: vectorized scan finds CR, LF and colon... ");
+
+    char line[80];
+    memset(line, 'a', sizeof(line));
+    for (size_t i = 0; i < sizeof(line); i++) {
+        line[i] = '\r';
+        assert(http_parser_scan(line, sizeof(line), 0) == i);
+        line[i] = '\n';
+        assert(http_parser_scan(line, sizeof(line), 0) == i);
+        line[i] = ':';
+        assert(http_parser_scan(line, sizeof(line), 1) == i);
+        assert(http_parser_scan(line, sizeof(line), 0) == sizeof(line));
+        line[i] = 'a';
+    }
+    assert(http_parser_scan(line, 0, 1) == 0);
+
+    printf("OK\n");
+}
+
+static void test_complete_head(void) {
+    printf("Test: complete head in one buffer... ");
+
+    const char *req = "POST /api/v1/routes/decide HTTP/1.1\r\n"
+                      "Host: gw\r\n"
+                      "x-tenant-id:  t-1 \r\n"
+                      "Content-Length: 5\r\n"
+                      "\r\nhello";
+    http_parser_t p;
+    http_parser_init(&p);
+    assert(http_parser_execute(&p, req, strlen(req)) == HTTP_PARSE_DONE);
+
+    const http_request_head_t *h = &p.head;
+    assert(span_is(req, h->method, "POST"));
+    assert(span_is(req, h->target, "/api/v1/routes/decide"));
+    assert(h->http11 && h->keep_alive);
+    assert(h->num_headers == 3);
+    assert(h->content_length == 5);
+    assert(h->head_len == strlen(req) - 5);
+
+    /* Names match case-insensitively; values are trimmed */
+    const http_header_t *t = http_request_find_header(h, req, "X-Tenant-ID");
+    assert(t != NULL && span_is(req, t->value, "t-1"));
+    assert(http_request_find_header(h, req, "Authorization") == NULL);
+
+    /* DONE is sticky */
+    assert(http_parser_execute(&p, req, strlen(req)) == HTTP_PARSE_DONE);
+    printf("OK\n");
+}
+
+static void test_byte_at_a_time(void) {
+    printf("Test: head fed one byte at a time... ");
+
+    const char *req = "GET /health HTTP/1.0\r\nConnection: keep-alive\r\nX-Trace-ID: abc\r\n\r\n";
+    size_t len = strlen(req);
+    http_parser_t p;
+    http_parser_init(&p);
+    for (size_t i = 1; i < len; i++) {
+        assert(http_parser_execute(&p, req, i) == HTTP_PARSE_INCOMPLETE);
+    }
+    assert(http_parser_execute(&p, req, len) == HTTP_PARSE_DONE);
+    assert(p.head.head_len == len);
+    assert(!p.head.http11 && p.head.keep_alive);
+    assert(span_is(req, p.head.target, "/health"));
+    printf("OK\n");
+}
+
+static void test_buffer_moved_between_reads(void) {
+    printf("Test: offsets survive the buffer moving... ");
+
+    const char *req = "GET /x HTTP/1.1\r\nX-Tenant-ID: moved\r\n\r\n";
+    char first[64];
+    char second[64];
+    http_parser_t p;
+    http_parser_init(&p);
+
+    memcpy(first, req, 20);
+    assert(http_parser_execute(&p, first, 20) == HTTP_PARSE_INCOMPLETE);
+    memcpy(second, req, strlen(req));
+    assert(http_parser_execute(&p, second, strlen(req)) == HTTP_PARSE_DONE);
+
+    const http_header_t *t = http_request_find_header(&p.head, second, "x-tenant-id");
+    assert(t != NULL && span_is(second, t->value, "moved"));
+    printf("OK\n");
+}
+
+static void test_connection_close(void) {
+    printf("Test: Connection: close disables keep-alive... ");
+
+    const char *req = "GET / HTTP/1.1\r\nConnection: TE, Close\r\n\r\n";
+    http_parser_t p;
+    http_parser_init(&p);
+    assert(http_parser_execute(&p, req, strlen(req)) == HTTP_PARSE_DONE);
+    assert(p.head.http11 && !p.head.keep_alive);
+    printf("OK\n");
+}
+
+static void test_malformed(void) {
+    printf("Test: malformed heads are rejected... ");
+
+    static const char *bad[] = {
+        "GET / HTTP/1.1\nHost: x\r\n\r\n",                        /* bare LF */
+        "GET / HTTP/1.1\r\nHost: x\ry\r\n\r\n",                   /* bare CR */
+        "GET / HTTP/1.1\r\nNoColon\r\n\r\n",
+        "GET / HTTP/1.1\r\nHost : x\r\n\r\n",                     /* space before colon */
+        "GET / HTTP/1.1\r\nHost: x\r\n folded\r\n\r\n",           /* obs-fold */
+        "POST / HTTP/1.1\r\nContent-Length: 12abc\r\n\r\n",
+        "POST / HTTP/1.1\r\nContent-Length: 10, 20\r\n\r\n",
+        "POST / HTTP/1.1\r\nContent-Length: 5\r\nContent-Length: 6\r\n\r\n",
+        "POST / HTTP/1.1\r\nContent-Length:\r\n\r\n",
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        http_parser_t p;
+        http_parser_init(&p);
+        assert(http_parser_execute(&p, bad[i], strlen(bad[i])) == HTTP_PARSE_ERROR);
+    }
+
+    const char *te = "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n";
+    http_parser_t p;
+    http_parser_init(&p);
+    assert(http_parser_execute(&p, te, strlen(te)) == HTTP_PARSE_UNSUPPORTED);
+
+    /* Identical repeats and trailing OWS are fine */
+    const char *dup = "POST / HTTP/1.1\r\nContent-Length: 7 \r\ncontent-length:7\r\n\r\n";
+    http_parser_init(&p);
+    assert(http_parser_execute(&p, dup, strlen(dup)) == HTTP_PARSE_DONE);
+    assert(p.head.content_length == 7);
+    printf("OK\n");
+}
+
+static void test_request_line_without_target(void) {
+    printf("Test: incomplete request line leaves empty spans... ");
+
+    const char *req = "GARBAGE\r\nHost: x\r\n\r\n";
+    http_parser_t p;
+    http_parser_init(&p);
+    assert(http_parser_execute(&p, req, strlen(req)) == HTTP_PARSE_DONE);
+    assert(p.head.method.len == 0 && p.head.target.len == 0);
+    assert(!p.head.keep_alive);
+    printf("OK\n");
+}
+
+static void test_header_limit(void) {
+    printf("Test: too many headers is an error... ");
+
+    char req[4096];
+    size_t len = (size_t)snprintf(req, sizeof(req), "GET / HTTP/1.1\r\n");
+    for (int i = 0; i <= HTTP_PARSER_MAX_HEADERS; i++) {
+        len += (size_t)snprintf(req + len, sizeof(req) - len, "X-H%d: v\r\n", i);
+    }
+    len += (size_t)snprintf(req + len, sizeof(req) - len, "\r\n");
+
+    http_parser_t p;
+    http_parser_init(&p);
+    assert(http_parser_execute(&p, req, len) == HTTP_PARSE_ERROR);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("=== HTTP Parser Tests ===\n");
+
+    test_scan();
+    test_complete_head();
+    test_byte_at_a_time();
+    test_buffer_moved_between_reads();
+    test_connection_close();
+    test_malformed();
+    test_request_line_without_target();
+    test_header_limit();
+
+    printf("\nAll tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,676 @@
+/**
+ * test_http_reactor.c - Multi-reactor HTTP engine tests
+ */
+
+#define _GNU_SOURCE
+#include "http_reactor.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <time.h>
+
+#define BIG_RESPONSE_SIZE (32U * 1024U * 1024U)
+#define PARK_DELAY_US 100000
+static atomic_int big_send_failed;
+
+/* A parked request, answered later by a backend thread */
+typedef struct {
+    http_reactor_ticket_t *ticket;
+    char *data;                      /* Request buffer, valid while parked */
+    unsigned int seq;
+} parked_t;
+
+static http_conn_action_t park_resume(int fd, int keep_alive, void *arg) {
+    parked_t *p = (parked_t *)arg;
+    char body[64];
+    int body_len = snprintf(body, sizeof(body), "parked %.5s seq=%u", p->data + 5, p->seq);
+    char resp[256];
+    int n = snprintf(resp, sizeof(resp),
+                     "HTTP/1.1 200 OK\r\nContent-Length: %d\r\nConnection: %s\r\n\r\n%s",
+                     body_len, keep_alive ? "keep-alive" : "close", body);
+    free(p);
+    assert(http_reactor_send_all(fd, resp, (size_t)n) == 0);
+    return keep_alive ? HTTP_CONN_KEEP_ALIVE : HTTP_CONN_CLOSE;
+}
+
+static void *park_backend(void *arg) {
+    parked_t *p = (parked_t *)arg;
+    usleep(PARK_DELAY_US);
+    http_reactor_resume(p->ticket, park_resume, p);
+    return NULL;
+}
+
+/* Echo handler: replies with the request length and its sequence number.
+ * "GET /big" answers with a body far larger than any socket buffer. */
+static http_conn_action_t echo_handler(const http_reactor_request_t *req, void *user_data) {
+    (void)user_data;
+    assert(req->data[req->len] == '\0');
+
+    if (strncmp(req->data, "GET /big ", 9) == 0) {
+        char *big = calloc(1, BIG_RESPONSE_SIZE);
+        assert(big != NULL);
+        int rc = http_reactor_send_all(req->fd, big, BIG_RESPONSE_SIZE);
+        free(big);
+        if (rc != 0) {
+            atomic_store(&big_send_failed, 1);
+        }
+        return HTTP_CONN_CLOSE;
+    }
+    if (strncmp(req->data, "GET /park", 9) == 0) {
+        parked_t *p = malloc(sizeof(*p));
+        assert(p != NULL);
+        p->ticket = req->ticket;
+        p->data = req->data;
+        p->seq = req->seq;
+        pthread_t t;
+        assert(pthread_create(&t, NULL, park_backend, p) == 0);
+        pthread_detach(t);
+        return HTTP_CONN_PARK;
+    }
+
+    char body[64];
+    int body_len = snprintf(body, sizeof(body), "len=%zu seq=%u", req->len, req->seq);
+    char resp[256];
+    int n = snprintf(resp, sizeof(resp),
+                     "HTTP/1.1 200 OK\r\nContent-Length: %d\r\nConnection: %s\r\n\r\n%s",
+                     body_len, req->keep_alive ? "keep-alive" : "close", body);
+    assert(http_reactor_send_all(req->fd, resp, (size_t)n) == 0);
+    return req->keep_alive ? HTTP_CONN_KEEP_ALIVE : HTTP_CONN_CLOSE;
+}
+
+static int connect_to(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    assert(fd >= 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    assert(connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+    return fd;
+}
+
+static size_t read_all(int fd, char *buf, size_t cap) {
+    size_t total = 0;
+    for (;;) {
+        ssize_t n = read(fd, buf + total, cap - total - 1);
+        if (n <= 0) break;
+        total += (size_t)n;
+        if (total >= cap - 1) break;
+    }
+    buf[total] = '\0';
+    return total;
+}
+
+/* Read until `count` complete responses (head + Content-Length body) arrived */
+static size_t read_responses(int fd, char *buf, size_t cap, int count) {
+    size_t total = 0;
+    buf[0] = '\0';
+    for (;;) {
+        int complete = 0;
+        const char *p = buf;
+        const char *head_end;
+        while ((head_end = strstr(p, "\r\n\r\n")) != NULL) {
+            const char *cl = strstr(p, "Content-Length: ");
+            size_t body_len = cl && cl < head_end ? (size_t)atoi(cl + 16) : 0;
+            if ((size_t)(buf + total - (head_end + 4)) < body_len) break;
+            p = head_end + 4 + body_len;
+            complete++;
+        }
+        if (complete >= count || total >= cap - 1) break;
+
+        ssize_t n = read(fd, buf + total, cap - total - 1);
+        if (n <= 0) break;
+        total += (size_t)n;
+        buf[total] = '\0';
+    }
+    return total;
+}
+
+static http_reactor_t *start_reactor_ex(int threads, size_t max_request, int timeout_ms,
+                                        int keepalive_ms, int max_per_conn) {
+    http_reactor_config_t config;
+    http_reactor_get_default_config(&config);
+    config.port = 0;
+    config.num_threads = threads;
+    config.max_request_size = max_request;
+    config.request_timeout_ms = timeout_ms;
+    config.keepalive_timeout_ms = keepalive_ms;
+    config.max_requests_per_connection = max_per_conn;
+    config.handler = echo_handler;
+
+    http_reactor_t *reactor = http_reactor_create(&config);
+    assert(reactor != NULL);
+    assert(http_reactor_get_port(reactor) != 0);
+    assert(http_reactor_start(reactor) == 0);
+    return reactor;
+}
+
+static http_reactor_t *start_reactor(int threads, size_t max_request, int timeout_ms) {
+    return start_reactor_ex(threads, max_request, timeout_ms, 5000, 1000);
+}
+
+static void test_create_invalid(void) {
+    printf("Test: create rejects missing handler... ");
+
+    http_reactor_config_t config;
+    http_reactor_get_default_config(&config);
+    config.port = 0;
+    assert(http_reactor_create(&config) == NULL);
+    assert(http_reactor_create(NULL) == NULL);
+
+    printf("OK\n");
+}
+
+static void test_single_request(void) {
+    printf("Test: single request dispatch... ");
+
+    http_reactor_t *reactor = start_reactor(2, 65536, 30000);
+    assert(http_reactor_get_num_threads(reactor) == 2);
+
+    int fd = connect_to(http_reactor_get_port(reactor));
+    const char *req = "GET /health HTTP/1.1\r\nHost: x\r\nConnection: close\r\n\r\n";
+    assert(write(fd, req, strlen(req)) == (ssize_t)strlen(req));
+
+    char resp[512];
+    read_all(fd, resp, sizeof(resp));
+    close(fd);
+
+    char expect[32];
+    snprintf(expect, sizeof(expect), "len=%zu", strlen(req));
+    assert(strstr(resp, "200 OK") != NULL);
+    assert(strstr(resp, expect) != NULL);
+
+    http_reactor_destroy(reactor);
+    printf("OK\n");
+}
+
+static void test_body_across_segments(void) {
+    printf("Test: body split across writes is reassembled... ");
+
+    http_reactor_t *reactor = start_reactor(1, 65536, 30000);
+    int fd = connect_to(http_reactor_get_port(reactor));
+
+    char body[20000];
+    memset(body, 'a', sizeof(body));
+    char head[128];
+    int head_len = snprintf(head, sizeof(head),
+                            "POST /api/v1/routes/decide HTTP/1.1\r\ncontent-length: %zu\r\n"
+                            "Connection: close\r\n\r\n",
+                            sizeof(body));
+    assert(write(fd, head, (size_t)head_len) == head_len);
+    usleep(20000);
+    assert(write(fd, body, 7000) == 7000);
+    usleep(20000);
+    assert(write(fd, body + 7000, sizeof(body) - 7000) == (ssize_t)(sizeof(body) - 7000));
+
+    char resp[512];
+    read_all(fd, resp, sizeof(resp));
+    close(fd);
+
+    char expect[32];
+    snprintf(expect, sizeof(expect), "len=%zu", (size_t)head_len + sizeof(body));
+    assert(strstr(resp, expect) != NULL);
+
+    http_reactor_destroy(reactor);
+    printf("OK\n");
+}
+
+static void test_oversized_request(void) {
+    printf("Test: oversized request gets 413... ");
+
+    http_reactor_t *reactor = start_reactor(1, 1024, 30000);
+    int fd = connect_to(http_reactor_get_port(reactor));
+
+    const char *req = "POST /x HTTP/1.1\r\nContent-Length: 4096\r\n\r\n";
+    assert(write(fd, req, strlen(req)) == (ssize_t)strlen(req));
+
+    char resp[512];
+    read_all(fd, resp, sizeof(resp));
+    close(fd);
+    assert(strstr(resp, "413") != NULL);
+
+    http_reactor_stats_t stats;
+    assert(http_reactor_get_stats(reactor, &stats) == 0);
+    assert(stats.oversized == 1);
+
+    http_reactor_destroy(reactor);
+    printf("OK\n");
+}
+
+static void test_request_timeout(void) {
+    printf("Test: incomplete request times out... ");
+
+    http_reactor_t *reactor = start_reactor(1, 65536, 100);
+    int fd = connect_to(http_reactor_get_port(reactor));
+
+    const char *partial = "GET /health HTTP/1.1\r\n";
+    assert(write(fd, partial, strlen(partial)) == (ssize_t)strlen(partial));
+
+    char resp[512];
+    read_all(fd, resp, sizeof(resp));  /* returns once the reactor closes */
+    close(fd);
+    assert(strstr(resp, "408") != NULL);
+
+    http_reactor_stats_t stats;
+    http_reactor_get_stats(reactor, &stats);
+    assert(stats.timeouts == 1);
+    assert(stats.active_connections == 0);
+
+    http_reactor_destroy(reactor);
+    printf("OK\n");
+}
+
+static void test_keep_alive_reuse(void) {
+    printf("Test: keep-alive connection serves several requests... ");
+
+    http_reactor_t *reactor = start_reactor(1, 65536, 30000);
+    int fd = connect_to(http_reactor_get_port(reactor));
+    const char *req = "GET /health HTTP/1.1\r\nHost: x\r\n\r\n";
+
+    for (int i = 1; i <= 3; i++) {
+        assert(write(fd, req, strlen(req)) == (ssize_t)strlen(req));
+        char resp[512];
+        read_responses(fd, resp, sizeof(resp), 1);
+        char expect[32];
+        snprintf(expect, sizeof(expect), "seq=%d", i);
+        assert(strstr(resp, "Connection: keep-alive") != NULL);
+        assert(strstr(resp, expect) != NULL);
+    }
+    close(fd);
+
+    http_reactor_stats_t stats;
+    http_reactor_get_stats(reactor, &stats);
+    assert(stats.accepted == 1);
+    assert(stats.requests == 3);
+    assert(stats.reused == 2);
+
+    http_reactor_destroy(reactor);
+    printf("OK\n");
+}
+
+static void test_pipelined_in_order(void) {
+    printf("Test: pipelined requests answered in order... ");
+
+    http_reactor_t *reactor = start_reactor(1, 65536, 30000);
+    int fd = connect_to(http_reactor_get_port(reactor));
+
+    /* Three requests in one segment; the middle one has a body */
+    const char *batch =
+        "GET /a HTTP/1.1\r\n\r\n"
+        "POST /b HTTP/1.1\r\nContent-Length: 5\r\n\r\nhello"
+        "GET /c HTTP/1.1\r\nConnection: close\r\n\r\n";
+    assert(write(fd, batch, strlen(batch)) == (ssize_t)strlen(batch));
+
+    char resp[1024];
+    read_all(fd, resp, sizeof(resp));  /* last request closes */
+    close(fd);
+
+    const char *r1 = strstr(resp, "len=19 seq=1");
+    const char *r2 = strstr(resp, "len=44 seq=2");
+    const char *r3 = strstr(resp, "len=38 seq=3");
+    assert(r1 && r2 && r3);
+    assert(r1 < r2 && r2 < r3);
+    assert(strstr(r2, "Connection: close") != NULL);
+
+    http_reactor_destroy(reactor);
+    printf("OK\n");
+}
+
+static void test_max_requests_per_connection(void) {
+    printf("Test: per-connection request cap forces close... ");
+
+    http_reactor_t *reactor = start_reactor_ex(1, 65536, 30000, 5000, 2);
+    int fd = connect_to(http_reactor_get_port(reactor));
+    const char *req = "GET /health HTTP/1.1\r\n\r\n";
+
+    assert(write(fd, req, strlen(req)) == (ssize_t)strlen(req));
+    char resp[512];
+    read_responses(fd, resp, sizeof(resp), 1);
+    assert(strstr(resp, "Connection: keep-alive") != NULL);
+
+    assert(write(fd, req, strlen(req)) == (ssize_t)strlen(req));
+    read_all(fd, resp, sizeof(resp));  /* returns on close */
+    assert(strstr(resp, "seq=2") != NULL);
+    assert(strstr(resp, "Connection: close") != NULL);
+    close(fd);
+
+    http_reactor_destroy(reactor);
+    printf("OK\n");
+}
+
+static void test_keepalive_idle_timeout(void) {
+    printf("Test: idle keep-alive connection is closed... ");
+
+    http_reactor_t *reactor = start_reactor_ex(1, 65536, 30000, 100, 1000);
+    int fd = connect_to(http_reactor_get_port(reactor));
+    const char *req = "GET /health HTTP/1.1\r\n\r\n";
+
+    assert(write(fd, req, strlen(req)) == (ssize_t)strlen(req));
+    char resp[512];
+    read_responses(fd, resp, sizeof(resp), 1);
+    assert(strstr(resp, "seq=1") != NULL);
+
+    /* Idle close is silent: the next read sees EOF without a 408 */
+    size_t n = read_all(fd, resp, sizeof(resp));
+    close(fd);
+    assert(n == 0);
+
+    http_reactor_stats_t stats;
+    http_reactor_get_stats(reactor, &stats);
+    assert(stats.idle_closed == 1);
+    assert(stats.timeouts == 0);
+    assert(stats.active_connections == 0);
+
+    http_reactor_destroy(reactor);
+    printf("OK\n");
+}
+
+static void test_chunked_rejected(void) {
+    printf("Test: chunked request gets 501... ");
+
+    http_reactor_t *reactor = start_reactor(1, 65536, 30000);
+    int fd = connect_to(http_reactor_get_port(reactor));
+
+    const char *req = "POST /x HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n0\r\n\r\n";
+    assert(write(fd, req, strlen(req)) == (ssize_t)strlen(req));
+
+    char resp[512];
+    read_all(fd, resp, sizeof(resp));
+    close(fd);
+    assert(strstr(resp, "501") != NULL);
+
+    http_reactor_stats_t stats;
+    http_reactor_get_stats(reactor, &stats);
+    assert(stats.unsupported == 1);
+    assert(stats.requests == 0);
+
+    http_reactor_destroy(reactor);
+    printf("OK\n");
+}
+
+/* Send one raw request and expect the reactor to answer 400 and close */
+static void expect_bad_request(http_reactor_t *reactor, const char *req) {
+    int fd = connect_to(http_reactor_get_port(reactor));
+    assert(write(fd, req, strlen(req)) == (ssize_t)strlen(req));
+
+    char resp[512];
+    read_all(fd, resp, sizeof(resp));
+    close(fd);
+    assert(strstr(resp, "400 Bad Request") != NULL);
+}
+
+static void test_conflicting_content_length(void) {
+    printf("Test: duplicate or conflicting Content-Length gets 400... ");
+
+    http_reactor_t *reactor = start_reactor(1, 65536, 30000);
+
+    expect_bad_request(reactor,
+        "POST /x HTTP/1.1\r\nContent-Length: 5\r\nContent-Length: 6\r\n\r\nhello!");
+    expect_bad_request(reactor,
+        "POST /x HTTP/1.1\r\nContent-Length: 10, 20\r\n\r\n0123456789");
+
+    /* Identical repeats are harmless and still served */
+    int fd = connect_to(http_reactor_get_port(reactor));
+    const char *req = "POST /x HTTP/1.1\r\nContent-Length: 5\r\nContent-Length: 5\r\n"
+                      "Connection: close\r\n\r\nhello";
+    assert(write(fd, req, strlen(req)) == (ssize_t)strlen(req));
+    char resp[512];
+    read_all(fd, resp, sizeof(resp));
+    close(fd);
+    assert(strstr(resp, "200 OK") != NULL);
+
+    http_reactor_stats_t stats;
+    http_reactor_get_stats(reactor, &stats);
+    assert(stats.requests == 1);
+
+    http_reactor_destroy(reactor);
+    printf("OK\n");
+}
+
+static void test_content_length_trailing_garbage(void) {
+    printf("Test: Content-Length with trailing garbage gets 400... ");
+
+    http_reactor_t *reactor = start_reactor(1, 65536, 30000);
+
+    expect_bad_request(reactor, "POST /x HTTP/1.1\r\nContent-Length: 12abc\r\n\r\n");
+    expect_bad_request(reactor, "POST /x HTTP/1.1\r\nContent-Length: 5 5\r\n\r\nhello");
+    expect_bad_request(reactor, "POST /x HTTP/1.1\r\nContent-Length: +5\r\n\r\nhello");
+
+    /* Trailing whitespace is allowed OWS */
+    int fd = connect_to(http_reactor_get_port(reactor));
+    const char *req = "POST /x HTTP/1.1\r\nContent-Length: 5 \t\r\nConnection: close\r\n\r\nhello";
+    assert(write(fd, req, strlen(req)) == (ssize_t)strlen(req));
+    char resp[512];
+    read_all(fd, resp, sizeof(resp));
+    close(fd);
+    assert(strstr(resp, "200 OK") != NULL);
+
+    http_reactor_destroy(reactor);
+    printf("OK\n");
+}
+
+static void test_stalled_reader_times_out(void) {
+    printf("Test: client that stops reading cannot freeze its reactor... ");
+
+    http_reactor_config_t config;
+    http_reactor_get_default_config(&config);
+    config.port = 0;
+    config.num_threads = 1;
+    config.send_timeout_ms = 200;
+    config.handler = echo_handler;
+    http_reactor_t *reactor = http_reactor_create(&config);
+    assert(reactor != NULL);
+    assert(http_reactor_start(reactor) == 0);
+    uint16_t port = http_reactor_get_port(reactor);
+
+    /* Never read the 32MB answer */
+    int stalled = connect_to(port);
+    const char *big = "GET /big HTTP/1.1\r\n\r\n";
+    assert(write(stalled, big, strlen(big)) == (ssize_t)strlen(big));
+    usleep(50000);
+
+    /* The only reactor must still serve other clients */
+    int fd = connect_to(port);
+    const char *req = "GET /health HTTP/1.1\r\nConnection: close\r\n\r\n";
+    assert(write(fd, req, strlen(req)) == (ssize_t)strlen(req));
+    char resp[512];
+    read_all(fd, resp, sizeof(resp));
+    close(fd);
+    assert(strstr(resp, "200 OK") != NULL);
+    assert(atomic_load(&big_send_failed) == 1);
+
+    close(stalled);
+    http_reactor_destroy(reactor);
+    printf("OK\n");
+}
+
+typedef struct {
+    uint16_t port;
+    int iterations;
+    int ok;
+} client_arg_t;
+
+static void *client_thread(void *arg) {
+    client_arg_t *ca = (client_arg_t *)arg;
+    const char *req = "GET /health HTTP/1.0\r\n\r\n";
+    for (int i = 0; i < ca->iterations; i++) {
+        int fd = connect_to(ca->port);
+        if (write(fd, req, strlen(req)) != (ssize_t)strlen(req)) {
+            close(fd);
+            continue;
+        }
+        char resp[256];
+        read_all(fd, resp, sizeof(resp));
+        close(fd);
+        if (strstr(resp, "200 OK")) ca->ok++;
+    }
+    return NULL;
+}
+
+static void test_concurrent_clients(void) {
+    printf("Test: concurrent clients across reactors... ");
+
+    http_reactor_t *reactor = start_reactor(4, 65536, 30000);
+    uint16_t port = http_reactor_get_port(reactor);
+
+    pthread_t threads[8];
+    client_arg_t args[8];
+    for (int i = 0; i < 8; i++) {
+        args[i].port = port;
+        args[i].iterations = 50;
+        args[i].ok = 0;
+        pthread_create(&threads[i], NULL, client_thread, &args[i]);
+    }
+    int ok = 0;
+    for (int i = 0; i < 8; i++) {
+        pthread_join(threads[i], NULL);
+        ok += args[i].ok;
+    }
+    assert(ok == 400);
+
+    http_reactor_stats_t stats;
+    http_reactor_get_stats(reactor, &stats);
+    assert(stats.accepted == 400);
+    assert(stats.requests == 400);
+
+    printf("(requests=%llu) ", (unsigned long long)stats.requests);
+    http_reactor_destroy(reactor);
+    printf("OK\n");
+}
+
+static uint64_t mono_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000U + (uint64_t)ts.tv_nsec / 1000000U;
+}
+
+static void test_parked_requests_overlap(void) {
+    printf("Test: parked requests do not block the reactor... ");
+
+    http_reactor_t *reactor = start_reactor(1, 65536, 30000);
+    uint16_t port = http_reactor_get_port(reactor);
+
+    /* Eight slow requests on one reactor thread, plus a fast one meanwhile */
+    int fds[8];
+    uint64_t start = mono_ms();
+    for (int i = 0; i < 8; i++) {
+        fds[i] = connect_to(port);
+        const char *req = "GET /park1 HTTP/1.1\r\n\r\n";
+        assert(write(fds[i], req, strlen(req)) == (ssize_t)strlen(req));
+    }
+    int fast = connect_to(port);
+    const char *req = "GET /health HTTP/1.1\r\nConnection: close\r\n\r\n";
+    assert(write(fast, req, strlen(req)) == (ssize_t)strlen(req));
+    char resp[512];
+    read_all(fast, resp, sizeof(resp));
+    close(fast);
+    assert(strstr(resp, "seq=1") != NULL);
+    assert(mono_ms() - start < PARK_DELAY_US / 1000);
+
+    http_reactor_stats_t stats;
+    http_reactor_get_stats(reactor, &stats);
+    assert(stats.parked > 0);
+
+    for (int i = 0; i < 8; i++) {
+        read_responses(fds[i], resp, sizeof(resp), 1);
+        assert(strstr(resp, "parked park1 seq=1") != NULL);
+        assert(strstr(resp, "Connection: keep-alive") != NULL);
+        close(fds[i]);
+    }
+    /* Answered together, not one delay after another */
+    assert(mono_ms() - start < 4U * (PARK_DELAY_US / 1000));
+
+    http_reactor_get_stats(reactor, &stats);
+    assert(stats.parked == 0);
+    http_reactor_destroy(reactor);
+    printf("OK\n");
+}
+
+static void test_parked_pipeline_in_order(void) {
+    printf("Test: requests pipelined behind a parked one wait their turn... ");
+
+    http_reactor_t *reactor = start_reactor(1, 65536, 30000);
+    int fd = connect_to(http_reactor_get_port(reactor));
+
+    const char *batch =
+        "GET /a HTTP/1.1\r\n\r\n"
+        "GET /park2 HTTP/1.1\r\n\r\n"
+        "GET /c HTTP/1.1\r\n\r\n";
+    assert(write(fd, batch, strlen(batch)) == (ssize_t)strlen(batch));
+
+    char resp[1024];
+    read_responses(fd, resp, sizeof(resp), 3);
+    const char *r1 = strstr(resp, "len=19 seq=1");
+    const char *r2 = strstr(resp, "parked park2 seq=2");
+    const char *r3 = strstr(resp, "len=19 seq=3");
+    assert(r1 && r2 && r3);
+    assert(r1 < r2 && r2 < r3);
+
+    /* The connection stays usable after the resume */
+    const char *next = "GET /park3 HTTP/1.1\r\nConnection: close\r\n\r\n";
+    assert(write(fd, next, strlen(next)) == (ssize_t)strlen(next));
+    read_all(fd, resp, sizeof(resp));
+    assert(strstr(resp, "parked park3 seq=4") != NULL);
+    assert(strstr(resp, "Connection: close") != NULL);
+    close(fd);
+
+    http_reactor_destroy(reactor);
+    printf("OK\n");
+}
+
+static void test_stop_drains_parked(void) {
+    printf("Test: destroy waits for parked requests... ");
+
+    http_reactor_t *reactor = start_reactor(1, 65536, 30000);
+    int fd = connect_to(http_reactor_get_port(reactor));
+    const char *req = "GET /park4 HTTP/1.1\r\n\r\n";
+    assert(write(fd, req, strlen(req)) == (ssize_t)strlen(req));
+
+    http_reactor_stats_t stats;
+    do {
+        usleep(1000);
+        http_reactor_get_stats(reactor, &stats);
+    } while (stats.parked == 0);
+    http_reactor_destroy(reactor);
+
+    /* Answered, and closed because the reactor was stopping */
+    char resp[512];
+    read_all(fd, resp, sizeof(resp));
+    assert(strstr(resp, "parked park4 seq=1") != NULL);
+    assert(strstr(resp, "Connection: close") != NULL);
+    close(fd);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("=== HTTP Reactor Tests ===\n");
+
+    test_create_invalid();
+    test_single_request();
+    test_body_across_segments();
+    test_oversized_request();
+    test_request_timeout();
+    test_keep_alive_reuse();
+    test_pipelined_in_order();
+    test_max_requests_per_connection();
+    test_keepalive_idle_timeout();
+    test_chunked_rejected();
+    test_conflicting_content_length();
+    test_content_length_trailing_garbage();
+    test_stalled_reader_times_out();
+    test_concurrent_clients();
+    test_parked_requests_overlap();
+    test_parked_pipeline_in_order();
+    test_stop_drains_parked();
+
+    printf("\nAll tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,210 @@
+/**
+ * test_http_response.c - Scatter-gather response writer tests
+ */
+
+#include "http_response.h"
+#include "http_reactor.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+static void make_pair(int sv[2]) {
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    int flags = fcntl(sv[0], F_GETFL, 0);
+    assert(fcntl(sv[0], F_SETFL, flags | O_NONBLOCK) == 0);
+}
+
+static size_t read_all(int fd, char *buf, size_t cap) {
+    size_t got = 0;
+    for (;;) {
+        ssize_t n = read(fd, buf + got, cap - got);
+        if (n <= 0) break;
+        got += (size_t)n;
+    }
+    return got;
+}
+
+static void test_exact_bytes(void) {
+    printf("Test: response is rendered byte for byte... ");
+
+    int sv[2];
+    make_pair(sv);
+    http_response_t resp;
+    http_response_init(&resp, "HTTP/1.1 429 Too Many Requests");
+    http_response_add_raw(&resp, HTTP_RESPONSE_CONTENT_TYPE_JSON);
+    http_response_add_uint(&resp, "Retry-After", 60);
+    http_response_add_uint(&resp, "X-RateLimit-Remaining", 0);
+    http_response_add_header(&resp, "X-Mode", "memory");
+    const char *body = "{\"ok\":false}";
+    assert(http_response_send(&resp, sv[0], 1, body, strlen(body)) == 0);
+    /* status, CRLF, content type, one merged field run, connection, body */
+    assert(resp.iovcnt == 6);
+    close(sv[0]);
+
+    char buf[1024];
+    size_t n = read_all(sv[1], buf, sizeof(buf) - 1U);
+    buf[n] = '\0';
+    assert(strcmp(buf,
+                  "HTTP/1.1 429 Too Many Requests\r\n"
+                  "Content-Type: application/json\r\n"
+                  "Retry-After: 60\r\n"
+                  "X-RateLimit-Remaining: 0\r\n"
+                  "X-Mode: memory\r\n"
+                  "Content-Length: 12\r\n"
+                  "Connection: keep-alive\r\n"
+                  "\r\n"
+                  "{\"ok\":false}") == 0);
+    close(sv[1]);
+    printf("OK\n");
+}
+
+static void test_close_and_empty_body(void) {
+    printf("Test: Connection: close and empty body... ");
+
+    int sv[2];
+    make_pair(sv);
+    http_response_t resp;
+    http_response_init(&resp, "HTTP/1.1 204 No Content");
+    http_response_add_uint(&resp, "X-Big", 18446744073709551615ULL);
+    assert(http_response_send(&resp, sv[0], 0, NULL, 0) == 0);
+    close(sv[0]);
+
+    char buf[512];
+    size_t n = read_all(sv[1], buf, sizeof(buf) - 1U);
+    buf[n] = '\0';
+    assert(strcmp(buf,
+                  "HTTP/1.1 204 No Content\r\n"
+                  "X-Big: 18446744073709551615\r\n"
+                  "Content-Length: 0\r\n"
+                  "Connection: close\r\n"
+                  "\r\n") == 0);
+    close(sv[1]);
+    printf("OK\n");
+}
+
+static void test_head_only(void) {
+    printf("Test: head-only response has no Content-Length... ");
+
+    int sv[2];
+    make_pair(sv);
+    http_response_t resp;
+    http_response_init(&resp, "HTTP/1.1 304 Not Modified");
+    http_response_add_header(&resp, "ETag", "\"abc\"");
+    assert(http_response_send_head(&resp, sv[0], 1) == 0);
+    close(sv[0]);
+
+    char buf[512];
+    size_t n = read_all(sv[1], buf, sizeof(buf) - 1U);
+    buf[n] = '\0';
+    assert(strcmp(buf,
+                  "HTTP/1.1 304 Not Modified\r\n"
+                  "ETag: \"abc\"\r\n"
+                  "Connection: keep-alive\r\n"
+                  "\r\n") == 0);
+    close(sv[1]);
+    printf("OK\n");
+}
+
+static void test_overflow(void) {
+    printf("Test: too many parts is refused without writing... ");
+
+    int sv[2];
+    make_pair(sv);
+    http_response_t resp;
+    http_response_init(&resp, "HTTP/1.1 200 OK");
+    for (int i = 0; i < HTTP_RESPONSE_MAX_IOV; i++) {
+        http_response_add_raw(&resp, "X-A: 1\r\n");
+    }
+    assert(http_response_send(&resp, sv[0], 1, "x", 1) == -1);
+
+    char big[HTTP_RESPONSE_FIELDS_SIZE];
+    memset(big, 'v', sizeof(big) - 1U);
+    big[sizeof(big) - 1U] = '\0';
+    http_response_init(&resp, "HTTP/1.1 200 OK");
+    http_response_add_header(&resp, "X-Huge", big);
+    assert(http_response_send(&resp, sv[0], 1, "x", 1) == -1);
+    close(sv[0]);
+
+    char buf[16];
+    assert(read_all(sv[1], buf, sizeof(buf)) == 0);
+    close(sv[1]);
+    printf("OK\n");
+}
+
+typedef struct {
+    int fd;
+    size_t expect;
+    char *out;
+} drain_arg_t;
+
+static void *slow_drain(void *p) {
+    drain_arg_t *a = p;
+    size_t got = 0;
+    usleep(50000);                   /* let the writer hit EAGAIN first */
+    while (got < a->expect) {
+        size_t want = a->expect - got < 4096U ? a->expect - got : 4096U;
+        ssize_t n = read(a->fd, a->out + got, want);
+        if (n <= 0) break;
+        got += (size_t)n;
+    }
+    a->expect = got;
+    return NULL;
+}
+
+static void test_short_writes(void) {
+    printf("Test: short writes resume mid-vector... ");
+
+    int sv[2];
+    make_pair(sv);
+    int small = 4096;
+    (void)setsockopt(sv[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+
+    /* Three segments, each larger than the socket buffer */
+    size_t seg = 300000U;
+    char *parts[3];
+    struct iovec iov[3];
+    for (int i = 0; i < 3; i++) {
+        parts[i] = malloc(seg);
+        assert(parts[i] != NULL);
+        memset(parts[i], 'a' + i, seg);
+        iov[i].iov_base = parts[i];
+        iov[i].iov_len = seg;
+    }
+
+    drain_arg_t arg = { .fd = sv[1], .expect = 3U * seg, .out = malloc(3U * seg) };
+    assert(arg.out != NULL);
+    pthread_t t;
+    assert(pthread_create(&t, NULL, slow_drain, &arg) == 0);
+    assert(http_reactor_sendv(sv[0], iov, 3) == 0);
+    pthread_join(t, NULL);
+
+    assert(arg.expect == 3U * seg);
+    for (size_t i = 0; i < 3U * seg; i++) {
+        assert(arg.out[i] == (char)('a' + (int)(i / seg)));
+    }
+    for (int i = 0; i < 3; i++) {
+        free(parts[i]);
+    }
+    free(arg.out);
+    close(sv[0]);
+    close(sv[1]);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("=== HTTP Response Writer Tests ===\n");
+
+    test_exact_bytes();
+    test_close_and_empty_body();
+    test_head_only();
+    test_overflow();
+    test_short_writes();
+
+    printf("\nAll tests passed!\n");
+    return 0;
+}
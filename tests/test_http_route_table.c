@@ -0,0 +1,123 @@
+/**
+ * test_http_route_table.c - Compiled HTTP route table tests
+ */
+
+#include "http_route_table.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+static const int r_health = 1, r_stream = 2, r_msg_put = 3, r_msg_post = 4;
+static const int r_block = 5, r_block_short = 6, r_policy = 7, r_policy_other = 8;
+
+static http_route_table_t *build(void) {
+    http_route_table_t *t = http_route_table_create();
+    assert(t != NULL);
+    assert(http_route_table_add(t, "GET", "/health", &r_health) == 0);
+    assert(http_route_table_add(t, "GET", "/api/v1/messages/stream", &r_stream) == 0);
+    assert(http_route_table_add(t, "PUT", "/api/v1/messages/*message_id", &r_msg_put) == 0);
+    assert(http_route_table_add(t, "POST", "/api/v1/messages", &r_msg_post) == 0);
+    assert(http_route_table_add(t, "POST", "/api/v1/registry/blocks/:type/*version", &r_block) == 0);
+    assert(http_route_table_add(t, "POST", "/api/v1/registry/blocks/:type", &r_block_short) == 0);
+    assert(http_route_table_add(t, "GET", "/api/v1/policies/:tenant_id/:policy_id/complexity", &r_policy) == 0);
+    assert(http_route_table_add(t, "GET", "/api/v1/policies/*rest", &r_policy_other) == 0);
+    return t;
+}
+
+static const void *lookup(const http_route_table_t *t, const char *method, const char *path,
+                          http_route_match_t *m) {
+    if (http_route_table_match(t, method, strlen(method), path, strlen(path), m) != 0) {
+        return NULL;
+    }
+    return m->data;
+}
+
+static int param_is(const http_route_match_t *m, const char *name, const char *expect) {
+    const http_route_param_t *p = http_route_match_param(m, name);
+    return p && p->len == strlen(expect) && memcmp(p->value, expect, p->len) == 0;
+}
+
+static void test_literal_routes(void) {
+    printf("Test: literal routes match exactly... ");
+
+    http_route_table_t *t = build();
+    http_route_match_t m;
+    assert(lookup(t, "GET", "/health", &m) == &r_health);
+    assert(m.num_params == 0);
+    assert(lookup(t, "GET", "/health/", &m) == NULL);
+    assert(lookup(t, "GET", "/healthz", &m) == NULL);
+    assert(lookup(t, "POST", "/health", &m) == NULL);
+    assert(lookup(t, "PATCH", "/health", &m) == NULL);
+    assert(lookup(t, "POST", "/api/v1/messages", &m) == &r_msg_post);
+    http_route_table_destroy(t);
+    printf("OK\n");
+}
+
+static void test_params_and_wildcards(void) {
+    printf("Test: parameters and wildcards are captured... ");
+
+    http_route_table_t *t = build();
+    http_route_match_t m;
+
+    assert(lookup(t, "POST", "/api/v1/registry/blocks/router/1.0/beta", &m) == &r_block);
+    assert(param_is(&m, "type", "router"));
+    assert(param_is(&m, "version", "1.0/beta"));
+
+    assert(lookup(t, "POST", "/api/v1/registry/blocks/router", &m) == &r_block_short);
+    assert(param_is(&m, "type", "router"));
+    assert(http_route_match_param(&m, "version") == NULL);
+
+    /* Empty wildcard tail still matches; the handler rejects it */
+    assert(lookup(t, "POST", "/api/v1/registry/blocks/router/", &m) == &r_block);
+    assert(param_is(&m, "version", ""));
+
+    assert(lookup(t, "GET", "/api/v1/policies/t1/p1/complexity", &m) == &r_policy);
+    assert(param_is(&m, "tenant_id", "t1"));
+    assert(param_is(&m, "policy_id", "p1"));
+    assert(lookup(t, "GET", "/api/v1/policies/t1/p1", &m) == &r_policy_other);
+    assert(param_is(&m, "rest", "t1/p1"));
+    assert(m.num_params == 1);
+    http_route_table_destroy(t);
+    printf("OK\n");
+}
+
+static void test_method_backtracking(void) {
+    printf("Test: branch without the method falls back... ");
+
+    http_route_table_t *t = build();
+    http_route_match_t m;
+    assert(lookup(t, "GET", "/api/v1/messages/stream", &m) == &r_stream);
+    /* "stream" has no PUT route, so the wildcard takes it */
+    assert(lookup(t, "PUT", "/api/v1/messages/stream", &m) == &r_msg_put);
+    assert(param_is(&m, "message_id", "stream"));
+    assert(lookup(t, "DELETE", "/api/v1/messages/stream", &m) == NULL);
+    http_route_table_destroy(t);
+    printf("OK\n");
+}
+
+static void test_invalid_patterns(void) {
+    printf("Test: bad or clashing patterns are refused... ");
+
+    http_route_table_t *t = build();
+    assert(http_route_table_add(t, "GET", "/health", &r_health) == -1);                /* duplicate */
+    assert(http_route_table_add(t, "GET", "health", &r_health) == -1);                 /* no slash */
+    assert(http_route_table_add(t, "GET", "/a/*rest/b", &r_health) == -1);             /* wildcard not last */
+    assert(http_route_table_add(t, "GET", "/a/:", &r_health) == -1);                   /* unnamed */
+    assert(http_route_table_add(t, "TRACE", "/a", &r_health) == -1);
+    assert(http_route_table_add(t, "GET", "/api/v1/policies/:other/x", &r_health) == -1); /* name clash */
+    assert(http_route_table_add(t, "GET", "/api/v1/policies/:tenant_id/x", &r_health) == 0);
+    http_route_table_destroy(t);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("=== HTTP Route Table Tests ===\n");
+
+    test_literal_routes();
+    test_params_and_wildcards();
+    test_method_backtracking();
+    test_invalid_patterns();
+
+    printf("\nAll tests passed!\n");
+    return 0;
+}
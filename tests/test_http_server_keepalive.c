@@ -0,0 +1,649 @@
+/**
+ * test_http_server_keepalive.c - c-gateway endpoints over persistent connections
+ *
+ * Starts the c-gateway binary (path in argv[1]) on a free port and drives
+ * real endpoints through handle_client: several requests on one keep-alive
+ * connection, concurrent /metrics scrapes whose bodies must match their
+ * Content-Length, an SSE subscriber beyond the pool that must be closed,
+ * SSE events routed by tenant, decide retries under one
+ * Idempotency-Key, decision polls answered from the cache,
+ * conditional reads of admin views, and registry manifests served with
+ * ETags and kept across a restart through the registry snapshot, with
+ * decide task payloads checked against their block's input schema.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <assert.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#define SSE_POOL_SIZE 64               /* GATEWAY_SSE_MAX_SUBSCRIBERS */
+#define SSE_POOL_SIZE_STR "64"
+
+static uint16_t gateway_port;
+static pid_t gateway_pid = -1;
+static char registry_snapshot[] = "/tmp/test_keepalive_registry_XXXXXX";
+
+typedef struct {
+    int status;
+    int keep_alive;                  /* Connection: keep-alive seen */
+    int has_connection;              /* Any Connection header seen */
+    int replayed;                    /* Idempotent-Replayed: true seen */
+    char etag[64];                   /* ETag value, empty if none */
+    size_t content_length;
+    char body[8192];                 /* First bytes of the body */
+} http_response_t;
+
+static int connect_gateway(void) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    assert(fd >= 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(gateway_port);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    struct timeval tv = { .tv_sec = 10, .tv_usec = 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    return fd;
+}
+
+static uint16_t pick_free_port(void) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+    socklen_t len = sizeof(addr);
+    assert(getsockname(fd, (struct sockaddr *)&addr, &len) == 0);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+static void start_gateway(const char *binary) {
+    gateway_port = pick_free_port();
+    char port_str[16];
+    snprintf(port_str, sizeof(port_str), "%u", gateway_port);
+
+    fflush(stdout);
+    gateway_pid = fork();
+    assert(gateway_pid >= 0);
+    if (gateway_pid == 0) {
+        setenv("GATEWAY_PORT", port_str, 1);
+        setenv("GATEWAY_REACTOR_THREADS", "4", 1);
+        setenv("GATEWAY_SSE_MAX_SUBSCRIBERS", SSE_POOL_SIZE_STR, 1);
+        setenv("OTLP_ENDPOINT", "http://127.0.0.1:1", 1);
+        setenv("GATEWAY_REGISTRY_SNAPSHOT_PATH", registry_snapshot, 1);
+        if (!freopen("/dev/null", "w", stdout) || !freopen("/dev/null", "w", stderr)) {
+            _exit(127);
+        }
+        execl(binary, binary, (char *)NULL);
+        _exit(127);
+    }
+
+    for (int i = 0; i < 100; i++) {
+        int fd = connect_gateway();
+        if (fd >= 0) {
+            close(fd);
+            return;
+        }
+        usleep(50000);
+    }
+    assert(!"gateway did not start listening");
+}
+
+static void stop_gateway(void) {
+    if (gateway_pid > 0) {
+        kill(gateway_pid, SIGTERM);
+        int status = 0;
+        waitpid(gateway_pid, &status, 0);
+        gateway_pid = -1;
+    }
+}
+
+/**
+ * Read exactly one response framed by Content-Length
+ *
+ * @return 0 on success, -1 if the peer closed or the framing is broken
+ */
+static int read_response(int fd, http_response_t *resp) {
+    char head[4096];
+    size_t head_len = 0;
+    memset(resp, 0, sizeof(*resp));
+
+    /* Byte-wise head read keeps pipelined bytes in the socket */
+    while (head_len < sizeof(head) - 1) {
+        ssize_t n = read(fd, head + head_len, 1);
+        if (n <= 0) return -1;
+        head_len++;
+        if (head_len >= 4 && memcmp(head + head_len - 4, "\r\n\r\n", 4) == 0) break;
+    }
+    head[head_len] = '\0';
+    if (sscanf(head, "HTTP/1.1 %d", &resp->status) != 1) return -1;
+
+    int has_length = 0;
+    for (char *line = strstr(head, "\r\n"); line && line[2] != '\r'; line = strstr(line + 2, "\r\n")) {
+        const char *h = line + 2;
+        if (strncasecmp(h, "Content-Length:", 15) == 0) {
+            if (has_length) return -1;      /* Exactly one Content-Length */
+            resp->content_length = (size_t)strtoul(h + 15, NULL, 10);
+            has_length = 1;
+        } else if (strncasecmp(h, "Connection:", 11) == 0) {
+            resp->has_connection = 1;
+            resp->keep_alive = strncasecmp(h + 11, " keep-alive", 11) == 0;
+        } else if (strncasecmp(h, "Idempotent-Replayed:", 20) == 0) {
+            resp->replayed = strncasecmp(h + 20, " true", 5) == 0;
+        } else if (strncasecmp(h, "ETag: ", 6) == 0) {
+            size_t n = strcspn(h + 6, "\r");
+            if (n >= sizeof(resp->etag)) return -1;
+            memcpy(resp->etag, h + 6, n);
+            resp->etag[n] = '\0';
+        }
+    }
+    if (resp->status == 304) return has_length ? -1 : 0;   /* Never a body */
+    if (!has_length) return -1;
+
+    size_t got = 0;
+    while (got < resp->content_length) {
+        char chunk[4096];
+        size_t want = resp->content_length - got;
+        if (want > sizeof(chunk)) want = sizeof(chunk);
+        ssize_t n = read(fd, chunk, want);
+        if (n <= 0) return -1;
+        if (got < sizeof(resp->body) - 1) {
+            size_t keep = (size_t)n;
+            if (keep > sizeof(resp->body) - 1 - got) keep = sizeof(resp->body) - 1 - got;
+            memcpy(resp->body + got, chunk, keep);
+        }
+        got += (size_t)n;
+    }
+    return 0;
+}
+
+static void send_str(int fd, const char *s) {
+    assert(write(fd, s, strlen(s)) == (ssize_t)strlen(s));
+}
+
+static void test_endpoints_on_one_connection(void) {
+    printf("Test: endpoints share one keep-alive connection... ");
+
+    int fd = connect_gateway();
+    assert(fd >= 0);
+    http_response_t resp;
+
+    send_str(fd, "GET /health HTTP/1.1\r\nHost: x\r\n\r\n");
+    assert(read_response(fd, &resp) == 0);
+    assert(resp.status == 200 && resp.keep_alive);
+    assert(strstr(resp.body, "healthy") != NULL);
+
+    send_str(fd, "GET /_metrics HTTP/1.1\r\nHost: x\r\n\r\n");
+    assert(read_response(fd, &resp) == 0);
+    assert(resp.status == 200 && resp.keep_alive);
+    assert(strstr(resp.body, "\"latency_us\":{\"1m\":{\"count\":1,") != NULL);
+    assert(strstr(resp.body, "\"p999\":") != NULL);
+
+    send_str(fd, "GET /metrics HTTP/1.1\r\nHost: x\r\n\r\n");
+    assert(read_response(fd, &resp) == 0);
+    assert(resp.status == 200 && resp.keep_alive);
+
+    send_str(fd, "GET /no/such/route HTTP/1.1\r\nHost: x\r\n\r\n");
+    assert(read_response(fd, &resp) == 0);
+    assert(resp.status == 404 && resp.keep_alive);
+
+    /* Pipelined pair, the second one closes */
+    send_str(fd, "GET /health HTTP/1.1\r\nHost: x\r\n\r\n"
+                 "GET /metrics HTTP/1.1\r\nHost: x\r\nConnection: close\r\n\r\n");
+    assert(read_response(fd, &resp) == 0);
+    assert(resp.status == 200 && resp.keep_alive);
+    assert(read_response(fd, &resp) == 0);
+    assert(resp.status == 200 && resp.has_connection && !resp.keep_alive);
+
+    char extra;
+    assert(read(fd, &extra, 1) == 0);
+    close(fd);
+    printf("OK\n");
+}
+
+typedef struct {
+    int iterations;
+    int ok;
+} scrape_arg_t;
+
+static void *scrape_thread(void *arg) {
+    scrape_arg_t *sa = (scrape_arg_t *)arg;
+    int fd = connect_gateway();
+    if (fd < 0) return NULL;
+    for (int i = 0; i < sa->iterations; i++) {
+        http_response_t resp;
+        send_str(fd, "GET /metrics HTTP/1.1\r\nHost: x\r\n\r\n");
+        if (read_response(fd, &resp) != 0) break;
+        /* A torn body would desync the next response head */
+        if (resp.status == 200 && resp.keep_alive) sa->ok++;
+    }
+    close(fd);
+    return NULL;
+}
+
+static void test_concurrent_metrics_scrapes(void) {
+    printf("Test: concurrent /metrics scrapes keep their framing... ");
+
+    pthread_t threads[8];
+    scrape_arg_t args[8];
+    for (int i = 0; i < 8; i++) {
+        args[i].iterations = 25;
+        args[i].ok = 0;
+        pthread_create(&threads[i], NULL, scrape_thread, &args[i]);
+    }
+    int ok = 0;
+    for (int i = 0; i < 8; i++) {
+        pthread_join(threads[i], NULL);
+        ok += args[i].ok;
+    }
+    assert(ok == 200);
+    printf("OK\n");
+}
+
+
+/* Read until `marker` shows up (0) or the peer closes first (-1) */
+static int read_until(int fd, const char *marker, char *buf, size_t cap) {
+    size_t len = 0;
+    buf[0] = '\0';
+    while (len < cap - 1) {
+        ssize_t n = read(fd, buf + len, cap - 1 - len);
+        if (n <= 0) return -1;
+        len += (size_t)n;
+        buf[len] = '\0';
+        if (strstr(buf, marker)) return 0;
+    }
+    return -1;
+}
+
+static void test_sse_pool_full_closes(void) {
+    printf("Test: SSE subscriber beyond the pool is closed... ");
+
+    int streams[SSE_POOL_SIZE];
+    char buf[1024];
+    for (int i = 0; i < SSE_POOL_SIZE; i++) {
+        streams[i] = connect_gateway();
+        assert(streams[i] >= 0);
+        send_str(streams[i], "GET /api/v1/messages/stream?tenant_id=t HTTP/1.1\r\nHost: x\r\n\r\n");
+        assert(read_until(streams[i], ": connected\n\n", buf, sizeof(buf)) == 0);
+    }
+
+    /* A pipelined request behind the rejected stream must not be served */
+    int fd = connect_gateway();
+    assert(fd >= 0);
+    send_str(fd, "GET /api/v1/messages/stream?tenant_id=t HTTP/1.1\r\nHost: x\r\n\r\n"
+                 "GET /health HTTP/1.1\r\nHost: x\r\n\r\n");
+    assert(read_until(fd, "\x01", buf, sizeof(buf)) == -1);
+    assert(strstr(buf, ":pool_full") != NULL);
+    assert(strstr(buf, "healthy") == NULL);
+    close(fd);
+
+    for (int i = 0; i < SSE_POOL_SIZE; i++) {
+        close(streams[i]);
+    }
+    printf("OK\n");
+}
+
+/* Open a stream, retrying while the hub still counts closed streams */
+static int open_stream(const char *tenant) {
+    char req[256], buf[1024];
+    snprintf(req, sizeof(req),
+             "GET /api/v1/messages/stream?tenant_id=%s HTTP/1.1\r\nHost: x\r\n\r\n", tenant);
+    for (int attempt = 0; attempt < 100; attempt++) {
+        int fd = connect_gateway();
+        assert(fd >= 0);
+        send_str(fd, req);
+        assert(read_until(fd, ": connected\n\n", buf, sizeof(buf)) == 0);
+        if (!strstr(buf, ":pool_full")) {
+            /* Give the hub time to register the stream before publishing */
+            usleep(20000);
+            return fd;
+        }
+        close(fd);
+        usleep(20000);
+    }
+    assert(!"SSE pool never freed up");
+    return -1;
+}
+
+static void test_sse_events_by_tenant(void) {
+    printf("Test: SSE events reach only the publishing tenant's streams... ");
+
+    int a = open_stream("tenant-a");
+    int b = open_stream("tenant-b");
+    char buf[1024];
+
+    int fd = connect_gateway();
+    assert(fd >= 0);
+    http_response_t resp;
+    send_str(fd, "DELETE /api/v1/messages/m-1 HTTP/1.1\r\nHost: x\r\nX-Tenant-ID: tenant-a\r\n\r\n");
+    assert(read_response(fd, &resp) == 0);
+    assert(resp.status == 200);
+    send_str(fd, "DELETE /api/v1/messages/m-2 HTTP/1.1\r\nHost: x\r\nX-Tenant-ID: tenant-b\r\n"
+                 "Connection: close\r\n\r\n");
+    assert(read_response(fd, &resp) == 0);
+    assert(resp.status == 200);
+    close(fd);
+
+    /* Each stream's first event is its own tenant's */
+    assert(read_until(a, "\n\n", buf, sizeof(buf)) == 0);
+    assert(strcmp(buf, "event: message_deleted\ndata: {\"message_id\":\"m-1\"}\n\n") == 0);
+    assert(read_until(b, "\n\n", buf, sizeof(buf)) == 0);
+    assert(strcmp(buf, "event: message_deleted\ndata: {\"message_id\":\"m-2\"}\n\n") == 0);
+    close(a);
+    close(b);
+    printf("OK\n");
+}
+
+static void post_decide(int fd, const char *key, const char *request_id, http_response_t *resp) {
+    char body[256];
+    char req[1024];
+    snprintf(body, sizeof(body),
+             "{\"version\":\"1\",\"tenant_id\":\"tenant-a\",\"request_id\":\"%s\","
+             "\"message_id\":\"m-1\",\"task\":{\"type\":\"text.generate\",\"payload\":{}}}",
+             request_id);
+    snprintf(req, sizeof(req),
+             "POST /api/v1/routes/decide HTTP/1.1\r\nHost: x\r\nX-Tenant-ID: tenant-a\r\n"
+             "%s%s%sContent-Type: application/json\r\nContent-Length: %zu\r\n\r\n%s",
+             key ? "Idempotency-Key: " : "", key ? key : "", key ? "\r\n" : "",
+             strlen(body), body);
+    send_str(fd, req);
+    assert(read_response(fd, resp) == 0);
+}
+
+static void test_idempotent_decide(void) {
+    printf("Test: decide retries with one Idempotency-Key replay the first answer... ");
+
+    int fd = connect_gateway();
+    assert(fd >= 0);
+    http_response_t first, resp;
+
+    post_decide(fd, "retry-1", "r-1", &first);
+    assert(first.status == 200 && !first.replayed);
+    post_decide(fd, "retry-1", "r-1", &resp);
+    assert(resp.status == 200 && resp.replayed && resp.keep_alive);
+    assert(resp.content_length == first.content_length);
+    assert(strcmp(resp.body, first.body) == 0);
+
+    /* The key belongs to the first body */
+    post_decide(fd, "retry-1", "r-2", &resp);
+    assert(resp.status == 422 && !resp.replayed);
+
+    /* Without a key nothing is replayed */
+    post_decide(fd, NULL, "r-1", &resp);
+    assert(resp.status == 200 && !resp.replayed);
+    close(fd);
+    printf("OK\n");
+}
+
+/* Value of a counter in a /metrics scrape, -1 if absent */
+static long scrape_counter(int fd, const char *name) {
+    http_response_t resp;
+    send_str(fd, "GET /metrics HTTP/1.1\r\nHost: x\r\n\r\n");
+    assert(read_response(fd, &resp) == 0 && resp.status == 200);
+    char prefix[128];
+    snprintf(prefix, sizeof(prefix), "\n%s ", name);
+    const char *at = strstr(resp.body, prefix);
+    return at ? strtol(at + strlen(prefix), NULL, 10) : -1;
+}
+
+static void test_decision_cache(void) {
+    printf("Test: repeated decision polls are answered from the cache... ");
+
+    int fd = connect_gateway();
+    assert(fd >= 0);
+    long hits = scrape_counter(fd, "gateway_decision_cache_hits_total");
+    long misses = scrape_counter(fd, "gateway_decision_cache_misses_total");
+    assert(hits >= 0 && misses >= 0);
+
+    const char *get = "GET /api/v1/routes/decide/m-poll HTTP/1.1\r\nHost: x\r\n"
+                      "X-Tenant-ID: tenant-a\r\n\r\n";
+    http_response_t first, resp;
+    send_str(fd, get);
+    assert(read_response(fd, &first) == 0 && first.status == 200);
+    for (int i = 0; i < 3; i++) {
+        send_str(fd, get);
+        assert(read_response(fd, &resp) == 0);
+        assert(resp.status == 200 && resp.keep_alive);
+        assert(resp.content_length == first.content_length);
+        assert(strcmp(resp.body, first.body) == 0);
+    }
+    assert(scrape_counter(fd, "gateway_decision_cache_misses_total") == misses + 1);
+    assert(scrape_counter(fd, "gateway_decision_cache_hits_total") == hits + 3);
+
+    /* Another tenant's poll for the same id is its own lookup */
+    send_str(fd, "GET /api/v1/routes/decide/m-poll HTTP/1.1\r\nHost: x\r\n"
+                 "X-Tenant-ID: tenant-b\r\n\r\n");
+    assert(read_response(fd, &resp) == 0 && resp.status == 200);
+    assert(scrape_counter(fd, "gateway_decision_cache_misses_total") == misses + 2);
+    close(fd);
+    printf("OK\n");
+}
+
+static void get_with_etag(int fd, const char *path, const char *etag, http_response_t *resp) {
+    char req[512];
+    snprintf(req, sizeof(req), "GET %s HTTP/1.1\r\nHost: x\r\n%s%s%s\r\n", path,
+             etag ? "If-None-Match: " : "", etag ? etag : "", etag ? "\r\n" : "");
+    send_str(fd, req);
+    assert(read_response(fd, resp) == 0);
+}
+
+static void test_admin_views(void) {
+    printf("Test: admin views carry ETags and answer If-None-Match with 304... ");
+
+    const char *paths[] = {
+        "/api/v1/extensions/health",
+        "/api/v1/extensions/circuit-breakers",
+        "/api/v1/policies/tenant-a/policy-1/complexity",
+    };
+    int fd = connect_gateway();
+    assert(fd >= 0);
+    for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); i++) {
+        http_response_t first, resp;
+        get_with_etag(fd, paths[i], NULL, &first);
+        assert(first.status == 200 && first.etag[0] == '"');
+
+        get_with_etag(fd, paths[i], first.etag, &resp);
+        assert(resp.status == 304 && resp.keep_alive);
+        assert(strcmp(resp.etag, first.etag) == 0);
+
+        /* Another tag, or none: the full view again */
+        get_with_etag(fd, paths[i], "\"nope\"", &resp);
+        assert(resp.status == 200 && strcmp(resp.body, first.body) == 0);
+        assert(strcmp(resp.etag, first.etag) == 0);
+    }
+    close(fd);
+    printf("OK\n");
+}
+
+static void put_block(int fd, const char *version, const char *description, http_response_t *resp) {
+    char body[512];
+    char req[1024];
+    snprintf(body, sizeof(body),
+             "{\"type\":\"llm\",\"version\":\"%s\",\"description\":\"%s\","
+             "\"schema\":{\"input\":{\"type\":\"object\"},\"output\":{\"type\":\"object\"}}}",
+             version, description);
+    snprintf(req, sizeof(req),
+             "PUT /api/v1/registry/blocks/llm/%s HTTP/1.1\r\nHost: x\r\n"
+             "Content-Type: application/json\r\nContent-Length: %zu\r\n\r\n%s",
+             version, strlen(body), body);
+    send_str(fd, req);
+    assert(read_response(fd, resp) == 0);
+}
+
+static void test_registry_blocks(void) {
+    printf("Test: registry manifests are served with ETags... ");
+
+    int fd = connect_gateway();
+    assert(fd >= 0);
+    http_response_t resp, first;
+    put_block(fd, "1.0.0", "first", &resp);
+    assert(resp.status == 201);
+
+    get_with_etag(fd, "/api/v1/registry/blocks/llm/1.0.0", NULL, &first);
+    assert(first.status == 200 && first.keep_alive && first.etag[0] == '"');
+    assert(strstr(first.body, "\"description\":\"first\"") != NULL);
+    get_with_etag(fd, "/api/v1/registry/blocks/llm/1.0.0", first.etag, &resp);
+    assert(resp.status == 304 && strcmp(resp.etag, first.etag) == 0);
+
+    /* A new manifest, a new tag */
+    put_block(fd, "1.0.0", "second", &resp);
+    assert(resp.status == 200);
+    get_with_etag(fd, "/api/v1/registry/blocks/llm/1.0.0", first.etag, &resp);
+    assert(resp.status == 200 && strcmp(resp.etag, first.etag) != 0);
+    assert(strstr(resp.body, "\"description\":\"second\"") != NULL);
+
+    /* Past the old fixed capacity of 64 */
+    char version[32];
+    for (int i = 0; i < 80; i++) {
+        snprintf(version, sizeof(version), "2.%d", i);
+        put_block(fd, version, "bulk", &resp);
+        assert(resp.status == 201);
+    }
+    send_str(fd, "DELETE /api/v1/registry/blocks/llm/2.0 HTTP/1.1\r\nHost: x\r\n\r\n");
+    assert(read_response(fd, &resp) == 0 && resp.status == 200);
+    get_with_etag(fd, "/api/v1/registry/blocks/llm/2.0", NULL, &resp);
+    assert(resp.status == 404);
+    get_with_etag(fd, "/api/v1/registry/blocks/llm/2.79", NULL, &resp);
+    assert(resp.status == 200);
+    close(fd);
+    printf("OK\n");
+}
+
+static void test_registry_snapshot_restart(const char *binary) {
+    printf("Test: registry survives a restart through its snapshot... ");
+
+    int fd = connect_gateway();
+    assert(fd >= 0);
+    http_response_t before, resp;
+    get_with_etag(fd, "/api/v1/registry/blocks/llm/1.0.0", NULL, &before);
+    assert(before.status == 200);
+    close(fd);
+
+    stop_gateway();
+    start_gateway(binary);
+    fd = connect_gateway();
+    assert(fd >= 0);
+    get_with_etag(fd, "/api/v1/registry/blocks/llm/1.0.0", NULL, &resp);
+    assert(resp.status == 200 && strcmp(resp.etag, before.etag) == 0);
+    assert(strcmp(resp.body, before.body) == 0);
+    get_with_etag(fd, "/api/v1/registry/blocks/llm/2.0", NULL, &resp);
+    assert(resp.status == 404);
+    close(fd);
+    printf("OK\n");
+}
+
+static void post_task(int fd, const char *task, http_response_t *resp) {
+    char body[512];
+    char req[1024];
+    snprintf(body, sizeof(body),
+             "{\"version\":\"1\",\"tenant_id\":\"tenant-a\",\"request_id\":\"r-task\","
+             "\"message_id\":\"m-task\",\"task\":%s}", task);
+    snprintf(req, sizeof(req),
+             "POST /api/v1/routes/decide HTTP/1.1\r\nHost: x\r\nX-Tenant-ID: tenant-a\r\n"
+             "Content-Type: application/json\r\nContent-Length: %zu\r\n\r\n%s",
+             strlen(body), body);
+    send_str(fd, req);
+    assert(read_response(fd, resp) == 0);
+}
+
+static void put_manifest(int fd, const char *type, const char *version, const char *schema,
+                         http_response_t *resp) {
+    char body[512];
+    char req[1024];
+    snprintf(body, sizeof(body), "{\"type\":\"%s\",\"version\":\"%s\",\"schema\":%s}",
+             type, version, schema);
+    snprintf(req, sizeof(req),
+             "PUT /api/v1/registry/blocks/%s/%s HTTP/1.1\r\nHost: x\r\n"
+             "Content-Type: application/json\r\nContent-Length: %zu\r\n\r\n%s",
+             type, version, strlen(body), body);
+    send_str(fd, req);
+    assert(read_response(fd, resp) == 0);
+}
+
+static void test_decide_payload_schema(const char *binary) {
+    printf("Test: decide payloads are checked against the block input schema... ");
+
+    int fd = connect_gateway();
+    assert(fd >= 0);
+    http_response_t resp;
+    put_manifest(fd, "summarize", "1.0",
+                 "{\"input\":{\"type\":\"object\",\"required\":[\"text\"],"
+                 "\"properties\":{\"text\":{\"type\":\"string\",\"maxLength\":10}}},"
+                 "\"output\":{\"type\":\"object\"}}", &resp);
+    assert(resp.status == 201);
+    put_manifest(fd, "summarize", "2.0",
+                 "{\"input\":{\"type\":\"object\",\"properties\":{\"text\":{\"type\":\"text\"}}},"
+                 "\"output\":{}}", &resp);
+    assert(resp.status == 400 && strstr(resp.body, "invalid_schema") != NULL);
+
+    post_task(fd, "{\"type\":\"summarize\",\"version\":\"1.0\",\"payload\":{\"text\":\"too long to fit\"}}",
+              &resp);
+    assert(resp.status == 400 && resp.keep_alive);
+    assert(strstr(resp.body, "invalid_payload") != NULL && strstr(resp.body, "#/text") != NULL);
+    close(fd);
+
+    /* Records loaded from the snapshot compile their schema again */
+    stop_gateway();
+    start_gateway(binary);
+    fd = connect_gateway();
+    assert(fd >= 0);
+    post_task(fd, "{\"type\":\"summarize\",\"version\":\"1.0\",\"payload\":{}}", &resp);
+    assert(resp.status == 400 && strstr(resp.body, "invalid_payload") != NULL);
+    post_task(fd, "{\"type\":\"summarize\",\"version\":\"1.0\",\"payload\":{\"text\":\"short\"}}",
+              &resp);
+    assert(resp.status == 200);
+    /* Without a version, or for an unknown one, the Router decides */
+    post_task(fd, "{\"type\":\"summarize\",\"payload\":{}}", &resp);
+    assert(resp.status == 200);
+    post_task(fd, "{\"type\":\"summarize\",\"version\":\"9.9\",\"payload\":{}}", &resp);
+    assert(resp.status == 200);
+    close(fd);
+    printf("OK\n");
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <path-to-c-gateway>\n", argv[0]);
+        return 2;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    printf("=== HTTP Server Keep-Alive Tests ===\n");
+
+    int snapshot_fd = mkstemp(registry_snapshot);
+    assert(snapshot_fd >= 0);
+    close(snapshot_fd);
+    unlink(registry_snapshot);
+
+    start_gateway(argv[1]);
+    test_endpoints_on_one_connection();
+    test_concurrent_metrics_scrapes();
+    test_sse_pool_full_closes();
+    test_sse_events_by_tenant();
+    test_idempotent_decide();
+    test_decision_cache();
+    test_admin_views();
+    test_registry_blocks();
+    test_registry_snapshot_restart(argv[1]);
+    test_decide_payload_schema(argv[1]);
+    stop_gateway();
+    unlink(registry_snapshot);
+
+    printf("\nAll tests passed!\n");
+    return 0;
+}
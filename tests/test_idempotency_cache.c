@@ -0,0 +1,286 @@
+/**
+ * test_idempotency_cache.c - Idempotency-Key response cache tests
+ */
+
+#include "idempotency_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define THREADS 8
+#define ROUNDS  2000
+
+static idempotency_cache_t *make_cache(size_t max_bytes, int shards, int ttl_ms, int max_waiters) {
+    idempotency_cache_config_t config;
+    idempotency_cache_get_default_config(&config);
+    config.max_bytes = max_bytes;
+    config.shards = shards;
+    config.ttl_ms = ttl_ms;
+    config.max_waiters = max_waiters;
+    idempotency_cache_t *c = idempotency_cache_create(&config);
+    assert(c != NULL);
+    return c;
+}
+
+static idempotency_result_t begin(idempotency_cache_t *c, const char *key, uint64_t fp,
+                                  idempotency_waiter_fn fn, void *arg, idempotency_claim_t **claim,
+                                  const idempotency_response_t **hit, uint64_t now_ms) {
+    return idempotency_cache_begin_at(c, key, strlen(key), fp, fn, arg, claim, hit, now_ms);
+}
+
+typedef struct {
+    int calls;
+    int status;
+    char body[64];
+} woken_t;
+
+static void on_woken(const idempotency_response_t *r, void *arg) {
+    woken_t *w = arg;
+    w->calls++;
+    w->status = r ? r->status : -1;
+    if (r) {
+        snprintf(w->body, sizeof(w->body), "%s", r->body);
+        idempotency_response_release(r);
+    }
+}
+
+static void test_claim_complete_hit(void) {
+    printf("Test: first request claims, retries replay its response... ");
+
+    idempotency_cache_t *c = make_cache(1 << 20, 4, 60000, 8);
+    idempotency_claim_t *claim;
+    const idempotency_response_t *hit;
+
+    assert(begin(c, "t1/decide/k1", 7, on_woken, NULL, &claim, &hit, 1000) == IDEMPOTENCY_MISS);
+    assert(claim != NULL && hit == NULL);
+    idempotency_cache_complete_at(claim, 200, "{\"ok\":true}", 11, IDEMPOTENCY_TTL_DEFAULT, 1000);
+
+    assert(begin(c, "t1/decide/k1", 7, on_woken, NULL, &claim, &hit, 2000) == IDEMPOTENCY_HIT);
+    assert(claim == NULL && hit != NULL);
+    assert(hit->status == 200 && hit->len == 11 && strcmp(hit->body, "{\"ok\":true}") == 0);
+
+    /* The reference survives the entry */
+    idempotency_cache_destroy(c);
+    assert(strcmp(hit->body, "{\"ok\":true}") == 0);
+    idempotency_response_release(hit);
+
+    /* Same key, other body: refused while claimed and once stored */
+    c = make_cache(1 << 20, 4, 60000, 8);
+    assert(begin(c, "k", 1, on_woken, NULL, &claim, &hit, 0) == IDEMPOTENCY_MISS);
+    idempotency_claim_t *other;
+    assert(begin(c, "k", 2, on_woken, NULL, &other, &hit, 0) == IDEMPOTENCY_MISMATCH);
+    idempotency_cache_complete_at(claim, 400, "bad", 3, IDEMPOTENCY_TTL_DEFAULT, 0);
+    assert(begin(c, "k", 2, on_woken, NULL, &other, &hit, 0) == IDEMPOTENCY_MISMATCH);
+
+    /* Unstored completions free the key */
+    assert(begin(c, "transient", 1, on_woken, NULL, &claim, &hit, 0) == IDEMPOTENCY_MISS);
+    idempotency_cache_complete_at(claim, 503, "down", 4, 0, 0);
+    assert(begin(c, "transient", 1, on_woken, NULL, &claim, &hit, 0) == IDEMPOTENCY_MISS);
+    idempotency_cache_abandon(claim);
+
+    idempotency_cache_stats_t st;
+    assert(idempotency_cache_get_stats(c, &st) == 0);
+    assert(st.misses == 3 && st.mismatches == 2 && st.entries == 1);
+    idempotency_cache_destroy(c);
+    printf("OK\n");
+}
+
+static void test_coalescing(void) {
+    printf("Test: duplicates in flight wait for the first response... ");
+
+    idempotency_cache_t *c = make_cache(1 << 20, 1, 60000, 2);
+    idempotency_claim_t *claim, *none;
+    const idempotency_response_t *hit;
+    woken_t a, b, d;
+    memset(&a, 0, sizeof(a));
+    memset(&b, 0, sizeof(b));
+    memset(&d, 0, sizeof(d));
+
+    assert(begin(c, "k", 1, on_woken, NULL, &claim, &hit, 0) == IDEMPOTENCY_MISS);
+    assert(begin(c, "k", 1, on_woken, &a, &none, &hit, 0) == IDEMPOTENCY_WAITING);
+    assert(begin(c, "k", 1, on_woken, &b, &none, &hit, 0) == IDEMPOTENCY_WAITING);
+    assert(none == NULL && hit == NULL);
+    /* The queue is full, and a caller that cannot wait is told so */
+    assert(begin(c, "k", 1, on_woken, &d, &none, &hit, 0) == IDEMPOTENCY_BUSY);
+    assert(a.calls == 0 && b.calls == 0);
+
+    /* Waiters get the response even when it is not kept */
+    idempotency_cache_complete_at(claim, 503, "{\"e\":1}", 7, 0, 0);
+    assert(a.calls == 1 && a.status == 503 && strcmp(a.body, "{\"e\":1}") == 0);
+    assert(b.calls == 1 && b.status == 503);
+    assert(d.calls == 0);
+
+    /* Abandoning wakes the queue with nothing and frees the key */
+    memset(&a, 0, sizeof(a));
+    assert(begin(c, "k", 1, on_woken, NULL, &claim, &hit, 0) == IDEMPOTENCY_MISS);
+    assert(begin(c, "k", 1, on_woken, &a, &none, &hit, 0) == IDEMPOTENCY_WAITING);
+    idempotency_cache_abandon(claim);
+    assert(a.calls == 1 && a.status == -1);
+    assert(begin(c, "k", 1, NULL, NULL, &claim, &hit, 0) == IDEMPOTENCY_MISS);
+    assert(begin(c, "k", 1, NULL, NULL, &none, &hit, 0) == IDEMPOTENCY_BUSY);
+    idempotency_cache_abandon(claim);
+
+    idempotency_cache_stats_t st;
+    assert(idempotency_cache_get_stats(c, &st) == 0);
+    assert(st.coalesced == 3 && st.busy == 2 && st.entries == 0 && st.bytes == 0);
+    idempotency_cache_destroy(c);
+    printf("OK\n");
+}
+
+static void test_ttl_and_memory_bound(void) {
+    printf("Test: entries expire and the LRU stays within its budget... ");
+
+    idempotency_cache_t *c = make_cache(1 << 20, 1, 1000, 8);
+    idempotency_claim_t *claim;
+    const idempotency_response_t *hit;
+
+    assert(begin(c, "k", 1, NULL, NULL, &claim, &hit, 0) == IDEMPOTENCY_MISS);
+    idempotency_cache_complete_at(claim, 200, "x", 1, IDEMPOTENCY_TTL_DEFAULT, 500);
+    assert(begin(c, "k", 1, NULL, NULL, &claim, &hit, 1499) == IDEMPOTENCY_HIT);
+    idempotency_response_release(hit);
+    assert(begin(c, "k", 1, NULL, NULL, &claim, &hit, 1500) == IDEMPOTENCY_MISS);
+    idempotency_cache_abandon(claim);
+
+    /* A per-response TTL overrides the configured one */
+    assert(begin(c, "short", 1, NULL, NULL, &claim, &hit, 0) == IDEMPOTENCY_MISS);
+    idempotency_cache_complete_at(claim, 404, "n", 1, 100, 0);
+    assert(begin(c, "long", 1, NULL, NULL, &claim, &hit, 0) == IDEMPOTENCY_MISS);
+    idempotency_cache_complete_at(claim, 200, "y", 1, 5000, 0);
+    assert(begin(c, "short", 1, NULL, NULL, &claim, &hit, 99) == IDEMPOTENCY_HIT);
+    assert(hit->status == 404);
+    idempotency_response_release(hit);
+    assert(begin(c, "short", 1, NULL, NULL, &claim, &hit, 100) == IDEMPOTENCY_MISS);
+    idempotency_cache_abandon(claim);
+    assert(begin(c, "long", 1, NULL, NULL, &claim, &hit, 4999) == IDEMPOTENCY_HIT);
+    idempotency_response_release(hit);
+    idempotency_cache_destroy(c);
+
+    /* About 1 KiB responses into a 16 KiB shard */
+    char body[1024];
+    memset(body, 'b', sizeof(body));
+    c = make_cache(16 * 1024, 1, 60000, 8);
+    char key[32];
+    for (int i = 0; i < 100; i++) {
+        snprintf(key, sizeof(key), "key-%d", i);
+        assert(begin(c, key, 1, NULL, NULL, &claim, &hit, 0) == IDEMPOTENCY_MISS);
+        idempotency_cache_complete_at(claim, 200, body, sizeof(body), IDEMPOTENCY_TTL_DEFAULT, 0);
+        /* Keep key-0 hot so it is never the coldest */
+        assert(begin(c, "key-0", 1, NULL, NULL, &claim, &hit, 0) == IDEMPOTENCY_HIT);
+        idempotency_response_release(hit);
+    }
+    idempotency_cache_stats_t st;
+    assert(idempotency_cache_get_stats(c, &st) == 0);
+    assert(st.bytes <= 16 * 1024 && st.entries >= 10 && st.entries < 16);
+    assert(st.evictions == 100 - st.entries);
+    assert(begin(c, "key-99", 1, NULL, NULL, &claim, &hit, 0) == IDEMPOTENCY_HIT);
+    idempotency_response_release(hit);
+    assert(begin(c, "key-1", 1, NULL, NULL, &claim, &hit, 0) == IDEMPOTENCY_MISS);
+    idempotency_cache_abandon(claim);
+
+    /* A response larger than the shard is delivered but not kept */
+    static char huge[32 * 1024];
+    memset(huge, 'h', sizeof(huge));
+    woken_t w;
+    memset(&w, 0, sizeof(w));
+    idempotency_claim_t *none;
+    assert(begin(c, "huge", 1, NULL, NULL, &claim, &hit, 0) == IDEMPOTENCY_MISS);
+    assert(begin(c, "huge", 1, on_woken, &w, &none, &hit, 0) == IDEMPOTENCY_WAITING);
+    idempotency_cache_complete_at(claim, 200, huge, sizeof(huge), IDEMPOTENCY_TTL_DEFAULT, 0);
+    assert(w.calls == 1 && w.status == 200);
+    assert(begin(c, "huge", 1, NULL, NULL, &claim, &hit, 0) == IDEMPOTENCY_MISS);
+    idempotency_cache_abandon(claim);
+    idempotency_cache_destroy(c);
+    printf("OK\n");
+}
+
+/* ---------------- Concurrency ---------------- */
+
+typedef struct {
+    idempotency_cache_t *c;
+    int id;
+} worker_arg_t;
+
+static atomic_int g_claims;
+static atomic_int g_served;
+static atomic_int g_wrong;
+
+static void on_woken_counted(const idempotency_response_t *r, void *arg) {
+    int round = (int)(intptr_t)arg;
+    if (!r || r->status != round) atomic_fetch_add(&g_wrong, 1);
+    atomic_fetch_add(&g_served, 1);
+    idempotency_response_release(r);
+}
+
+/* Every thread asks for the same key each round; exactly one may claim */
+static void *hammer(void *p) {
+    worker_arg_t *a = p;
+    char key[32];
+    for (int round = 0; round < ROUNDS; round++) {
+        snprintf(key, sizeof(key), "round-%d", round);
+        idempotency_claim_t *claim;
+        const idempotency_response_t *hit;
+        switch (idempotency_cache_begin(a->c, key, strlen(key), 42, on_woken_counted,
+                                        (void *)(intptr_t)round, &claim, &hit)) {
+        case IDEMPOTENCY_MISS:
+            atomic_fetch_add(&g_claims, 1);
+            idempotency_cache_complete(claim, round, "r", 1, IDEMPOTENCY_TTL_DEFAULT);
+            atomic_fetch_add(&g_served, 1);
+            break;
+        case IDEMPOTENCY_HIT:
+            if (hit->status != round) atomic_fetch_add(&g_wrong, 1);
+            idempotency_response_release(hit);
+            atomic_fetch_add(&g_served, 1);
+            break;
+        case IDEMPOTENCY_WAITING:
+            break;
+        default:
+            atomic_fetch_add(&g_wrong, 1);
+            break;
+        }
+    }
+    return NULL;
+}
+
+static void test_concurrent_single_claim(void) {
+    printf("Test: concurrent duplicates produce one claim per key... ");
+
+    idempotency_cache_t *c = make_cache(64 << 20, 8, 60000, THREADS);
+    pthread_t threads[THREADS];
+    worker_arg_t args[THREADS];
+    atomic_init(&g_claims, 0);
+    atomic_init(&g_served, 0);
+    atomic_init(&g_wrong, 0);
+    for (int i = 0; i < THREADS; i++) {
+        args[i].c = c;
+        args[i].id = i;
+        assert(pthread_create(&threads[i], NULL, hammer, &args[i]) == 0);
+    }
+    for (int i = 0; i < THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    assert(atomic_load(&g_claims) == ROUNDS);
+    assert(atomic_load(&g_served) == ROUNDS * THREADS);
+    assert(atomic_load(&g_wrong) == 0);
+
+    idempotency_cache_stats_t st;
+    assert(idempotency_cache_get_stats(c, &st) == 0);
+    assert(st.misses == ROUNDS && st.entries == ROUNDS);
+    assert(st.hits + st.coalesced == (uint64_t)ROUNDS * (THREADS - 1));
+    idempotency_cache_destroy(c);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("=== Idempotency Cache Tests ===\n\n");
+
+    test_claim_complete_hit();
+    test_coalescing();
+    test_ttl_and_memory_bound();
+    test_concurrent_single_claim();
+
+    printf("\nAll tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,340 @@
+/**
+ * test_ingest_batcher.c - Per-subject ingest batching tests
+ */
+
+#define _GNU_SOURCE
+#include "ingest_batcher.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#define THREADS 4
+#define PER_THREAD 5000
+#define MAX_HELD 64
+
+/* What the send callback saw, and batches held back to ack later */
+static pthread_mutex_t seen_lock = PTHREAD_MUTEX_INITIALIZER;
+static char last_subject[64];
+static char last_payload[4096];
+static char last_first_id[32];
+static size_t last_count = 0;
+static atomic_int sent_batches = 0;
+static atomic_int sent_messages = 0;
+static int send_status = 0;              /* Returned by send */
+static int hold = 0;                     /* Keep batches unacked */
+static ingest_batch_t *held[MAX_HELD];
+static int held_count = 0;
+
+static atomic_int results_ok = 0;
+static atomic_int results_failed = 0;
+static atomic_int results_failed_messages = 0;
+
+static int record_send(ingest_batch_t *batch, void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&seen_lock);
+    snprintf(last_subject, sizeof(last_subject), "%s", batch->subject);
+    snprintf(last_payload, sizeof(last_payload), "%s", batch->payload);
+    snprintf(last_first_id, sizeof(last_first_id), "%s", batch->ids[0]);
+    last_count = batch->count;
+    assert(strlen(batch->payload) == batch->payload_len);
+    int status = send_status;
+    int keep = hold && status == 0 && held_count < MAX_HELD;
+    if (keep) held[held_count++] = batch;
+    pthread_mutex_unlock(&seen_lock);
+    atomic_fetch_add(&sent_batches, 1);
+    atomic_fetch_add(&sent_messages, (int)batch->count);
+    if (status != 0) return status;
+    if (!keep) ingest_batch_done(batch, 0);
+    return 0;
+}
+
+static void record_result(const ingest_batch_t *batch, int status, void *arg) {
+    (void)arg;
+    if (status == 0) {
+        atomic_fetch_add(&results_ok, 1);
+    } else {
+        atomic_fetch_add(&results_failed, 1);
+        atomic_fetch_add(&results_failed_messages, (int)batch->count);
+    }
+}
+
+static void reset(void) {
+    atomic_store(&sent_batches, 0);
+    atomic_store(&sent_messages, 0);
+    atomic_store(&results_ok, 0);
+    atomic_store(&results_failed, 0);
+    atomic_store(&results_failed_messages, 0);
+    send_status = 0;
+    hold = 0;
+    held_count = 0;
+}
+
+static void wait_batches(int n) {
+    for (int i = 0; i < 2000 && atomic_load(&sent_batches) < n; i++) {
+        usleep(1000);
+    }
+    assert(atomic_load(&sent_batches) == n);
+}
+
+static ingest_batcher_t *make(int max_messages, size_t max_bytes, int linger_ms, size_t max_pending) {
+    ingest_batcher_config_t config;
+    ingest_batcher_get_default_config(&config);
+    config.max_batch_messages = max_messages;
+    config.max_batch_bytes = max_bytes;
+    config.linger_ms = linger_ms;
+    config.max_pending_bytes = max_pending;
+    ingest_batcher_t *b = ingest_batcher_create(&config, record_send, record_result, NULL);
+    assert(b != NULL);
+    return b;
+}
+
+static void test_full_batch(void) {
+    printf("Test: a batch goes out as one JSON array when it fills... ");
+    reset();
+    ingest_batcher_t *b = make(3, 4096, 60000, 1 << 20);
+    assert(ingest_batcher_submit(b, "ingest.acme", "m1", "{\"a\":1}", 7) == 0);
+    assert(ingest_batcher_submit(b, "ingest.other", "x1", "{}", 2) == 0);
+    assert(ingest_batcher_submit(b, "ingest.acme", "m2", "{\"a\":2}", 7) == 0);
+    usleep(20000);
+    assert(atomic_load(&sent_batches) == 0);
+    assert(ingest_batcher_submit(b, "ingest.acme", "m3", "[3]", 3) == 0);
+    wait_batches(1);
+
+    pthread_mutex_lock(&seen_lock);
+    assert(strcmp(last_subject, "ingest.acme") == 0);
+    assert(strcmp(last_payload, "[{\"a\":1},{\"a\":2},[3]]") == 0);
+    assert(strcmp(last_first_id, "m1") == 0);
+    assert(last_count == 3);
+    pthread_mutex_unlock(&seen_lock);
+
+    ingest_batcher_stats_t stats;
+    ingest_batcher_get_stats(b, &stats);
+    assert(stats.accepted == 4 && stats.acked == 3 && stats.batches == 1);
+    assert(stats.pending_bytes > 0);     /* ingest.other still open */
+
+    /* Destroy sends what is left */
+    ingest_batcher_destroy(b);
+    assert(atomic_load(&sent_batches) == 2);
+    assert(strcmp(last_payload, "[{}]") == 0);
+    assert(atomic_load(&results_ok) == 2);
+    printf("OK\n");
+}
+
+static void test_linger(void) {
+    printf("Test: an open batch goes out after the linger time... ");
+    reset();
+    ingest_batcher_t *b = make(100, 4096, 20, 1 << 20);
+    assert(ingest_batcher_submit(b, "ingest.a", "1", "1", 1) == 0);
+    assert(ingest_batcher_submit(b, "ingest.a", "2", "2", 1) == 0);
+    wait_batches(1);
+    assert(strcmp(last_payload, "[1,2]") == 0);
+
+    /* An explicit flush does not wait */
+    assert(ingest_batcher_submit(b, "ingest.a", "3", "3", 1) == 0);
+    ingest_batcher_flush(b);
+    wait_batches(2);
+    assert(strcmp(last_payload, "[3]") == 0);
+
+    ingest_batcher_stats_t stats;
+    ingest_batcher_get_stats(b, &stats);
+    assert(stats.pending_bytes == 0 && stats.in_flight == 0);
+    ingest_batcher_destroy(b);
+    printf("OK\n");
+}
+
+static void test_byte_limit(void) {
+    printf("Test: batches stay under the byte limit; a large message goes alone... ");
+    reset();
+    ingest_batcher_t *b = make(100, 64, 60000, 1 << 20);
+    char msg[40];
+    memset(msg, '1', sizeof(msg));
+    assert(ingest_batcher_submit(b, "s", "a", msg, 25) == 0);
+    assert(ingest_batcher_submit(b, "s", "b", msg, 25) == 0);
+    assert(atomic_load(&sent_batches) == 0);
+    /* Three of them and the brackets no longer fit in 64 */
+    assert(ingest_batcher_submit(b, "s", "c", msg, 25) == 0);
+    wait_batches(1);
+    assert(last_count == 2);
+
+    char big[100];
+    memset(big, '2', sizeof(big));
+    assert(ingest_batcher_submit(b, "s", "d", big, sizeof(big)) == 0);
+    wait_batches(3);                     /* "c" sealed to make room, then "d" full */
+    assert(last_count == 1 && strcmp(last_first_id, "d") == 0);
+    ingest_batcher_destroy(b);
+    printf("OK\n");
+}
+
+static void test_pending_limit(void) {
+    printf("Test: unacknowledged bytes refuse new messages until acked... ");
+    reset();
+    hold = 1;
+    ingest_batcher_t *b = make(1, 4096, 0, 100);
+    char msg[30];
+    memset(msg, 'x', sizeof(msg));
+    int accepted = 0;
+    for (int i = 0; i < 10; i++) {
+        if (ingest_batcher_submit(b, "s", "id", msg, sizeof(msg)) == 0) accepted++;
+    }
+    assert(accepted == 2);               /* 2 * (30 + 2 + 2) fits in 100, 3 do not */
+    wait_batches(2);
+
+    ingest_batcher_stats_t stats;
+    ingest_batcher_get_stats(b, &stats);
+    assert(stats.refused == 8 && stats.in_flight == 2 && stats.acked == 0);
+
+    pthread_mutex_lock(&seen_lock);
+    ingest_batch_t *first = held[0];
+    ingest_batch_t *second = held[1];
+    held_count = 0;
+    hold = 0;
+    pthread_mutex_unlock(&seen_lock);
+    ingest_batch_done(first, 0);
+    ingest_batch_done(second, 7);
+
+    ingest_batcher_get_stats(b, &stats);
+    assert(stats.pending_bytes == 0 && stats.acked == 1 && stats.failed == 1 && stats.failed_batches == 1);
+    assert(atomic_load(&results_failed) == 1);
+    assert(ingest_batcher_submit(b, "s", "id", msg, sizeof(msg)) == 0);
+    ingest_batcher_destroy(b);
+    printf("OK\n");
+}
+
+static void test_send_failure_and_subjects(void) {
+    printf("Test: send failures are reported; open subjects are capped... ");
+    reset();
+    send_status = -1;
+    ingest_batcher_config_t config;
+    ingest_batcher_get_default_config(&config);
+    config.linger_ms = 60000;
+    config.max_subjects = 2;
+    ingest_batcher_t *b = ingest_batcher_create(&config, record_send, record_result, NULL);
+    assert(b != NULL);
+
+    assert(ingest_batcher_submit(b, "one", "1", "1", 1) == 0);
+    assert(ingest_batcher_submit(b, "one", "2", "2", 1) == 0);
+    assert(ingest_batcher_submit(b, "two", "3", "3", 1) == 0);
+    assert(ingest_batcher_submit(b, "three", "4", "4", 1) == 0);   /* Evicts "one" */
+    wait_batches(1);
+    assert(strcmp(last_subject, "one") == 0);
+
+    ingest_batcher_destroy(b);
+    assert(atomic_load(&results_failed) == 3);
+    assert(atomic_load(&results_failed_messages) == 4);
+    assert(atomic_load(&results_ok) == 0);
+    printf("OK\n");
+}
+
+/* Acks arrive on a thread of their own, like NATS replies */
+static pthread_mutex_t ack_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ack_cond = PTHREAD_COND_INITIALIZER;
+static ingest_batch_t *ack_queue[1024];
+static int ack_len = 0;
+static int ack_stop = 0;
+
+static int queue_send(ingest_batch_t *batch, void *arg) {
+    (void)arg;
+    atomic_fetch_add(&sent_batches, 1);
+    atomic_fetch_add(&sent_messages, (int)batch->count);
+    pthread_mutex_lock(&ack_lock);
+    assert(ack_len < 1024);
+    ack_queue[ack_len++] = batch;
+    pthread_cond_signal(&ack_cond);
+    pthread_mutex_unlock(&ack_lock);
+    return 0;
+}
+
+static void *acker(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&ack_lock);
+    for (;;) {
+        while (ack_len == 0 && !ack_stop) pthread_cond_wait(&ack_cond, &ack_lock);
+        if (ack_len == 0) break;
+        ingest_batch_t *batch = ack_queue[--ack_len];
+        pthread_mutex_unlock(&ack_lock);
+        ingest_batch_done(batch, 0);
+        pthread_mutex_lock(&ack_lock);
+    }
+    pthread_mutex_unlock(&ack_lock);
+    return NULL;
+}
+
+static void *producer(void *arg) {
+    ingest_batcher_t *b = (ingest_batcher_t *)arg;
+    char subject[32];
+    snprintf(subject, sizeof(subject), "ingest.t%lu", (unsigned long)(pthread_self() % 3U));
+    for (int i = 0; i < PER_THREAD; i++) {
+        while (ingest_batcher_submit(b, subject, "id", "{\"n\":1}", 7) != 0) {
+            usleep(100);
+        }
+    }
+    return NULL;
+}
+
+static void test_concurrent(void) {
+    printf("Test: concurrent producers with asynchronous acks lose nothing... ");
+    reset();
+    ingest_batcher_config_t config;
+    ingest_batcher_get_default_config(&config);
+    config.max_batch_messages = 64;
+    config.linger_ms = 1;
+    config.max_pending_bytes = 16384;
+    ingest_batcher_t *b = ingest_batcher_create(&config, queue_send, NULL, NULL);
+    assert(b != NULL);
+
+    pthread_t ack_thread;
+    pthread_create(&ack_thread, NULL, acker, NULL);
+    pthread_t threads[THREADS];
+    for (int t = 0; t < THREADS; t++) pthread_create(&threads[t], NULL, producer, b);
+    for (int t = 0; t < THREADS; t++) pthread_join(threads[t], NULL);
+    ingest_batcher_destroy(b);           /* Waits for the acker */
+
+    pthread_mutex_lock(&ack_lock);
+    ack_stop = 1;
+    pthread_cond_signal(&ack_cond);
+    pthread_mutex_unlock(&ack_lock);
+    pthread_join(ack_thread, NULL);
+    assert(atomic_load(&sent_messages) == THREADS * PER_THREAD);
+    printf("OK\n");
+}
+
+static void test_config(void) {
+    printf("Test: environment overrides and validation... ");
+    setenv("GATEWAY_INGEST_BATCH_MESSAGES", "32", 1);
+    setenv("GATEWAY_INGEST_BATCH_KB", "8", 1);
+    setenv("GATEWAY_INGEST_LINGER_MS", "-1", 1);
+    setenv("GATEWAY_INGEST_MAX_PENDING_MB", "2", 1);
+    ingest_batcher_config_t config;
+    ingest_batcher_get_default_config(&config);
+    assert(ingest_batcher_parse_config(&config) == 0);
+    assert(config.max_batch_messages == 32);
+    assert(config.max_batch_bytes == 8192);
+    assert(config.linger_ms == 5);
+    assert(config.max_pending_bytes == 2U * 1024U * 1024U);
+    assert(config.max_subjects == 1024);
+
+    assert(ingest_batcher_create(&config, NULL, NULL, NULL) == NULL);
+    config.max_batch_bytes = 10;
+    assert(ingest_batcher_create(&config, record_send, NULL, NULL) == NULL);
+    assert(ingest_batcher_submit(NULL, "s", "i", "1", 1) == -1);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("=== Ingest Batcher Tests ===\n\n");
+
+    test_full_batch();
+    test_linger();
+    test_byte_limit();
+    test_pending_limit();
+    test_send_failure_and_subjects();
+    test_concurrent();
+    test_config();
+
+    printf("\nAll tests passed!\n");
+    return 0;
+}
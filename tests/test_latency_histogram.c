@@ -0,0 +1,177 @@
+/**
+ * test_latency_histogram.c - Log-linear latency histogram tests
+ */
+
+#include "latency_histogram.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#define THREADS 4
+#define PER_THREAD 100000
+
+static latency_histogram_t *make_hist(int slice_ms, int slices) {
+    latency_histogram_config_t config;
+    latency_histogram_get_default_config(&config);
+    config.slice_ms = slice_ms;
+    config.slices = slices;
+    latency_histogram_t *h = latency_histogram_create(&config);
+    assert(h != NULL);
+    return h;
+}
+
+/* Reported value must not understate and must stay within 1/64 */
+static void assert_close(uint64_t got, uint64_t want) {
+    assert(got >= want);
+    assert((double)(got - want) <= (double)want / 64.0);
+}
+
+static void test_bounded_relative_error(void) {
+    printf("Test: every value reads back within 1/64... ");
+
+    static latency_histogram_snapshot_t snap;
+    uint64_t values[] = { 0, 1, 127, 128, 129, 255, 256, 1000, 4321, 65535,
+                          1000000, 123456789, 4294967295ULL };
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        latency_histogram_t *h = make_hist(10000, 30);
+        latency_histogram_record_at(h, values[i], 5000);
+        assert(latency_histogram_snapshot_at(h, 60000, 5000, &snap) == 0);
+        assert(snap.total == 1);
+        uint64_t got = latency_histogram_percentile(&snap, 50.0);
+        if (values[i] < 128) {
+            assert(got == values[i]);
+        } else {
+            assert_close(got, values[i]);
+        }
+        latency_histogram_destroy(h);
+    }
+
+    /* Values past the range clamp instead of indexing out of bounds */
+    latency_histogram_t *h = make_hist(10000, 30);
+    latency_histogram_record_at(h, UINT64_MAX, 0);
+    assert(latency_histogram_snapshot_at(h, 10000, 0, &snap) == 0);
+    assert(latency_histogram_percentile(&snap, 100.0) == 4294967295ULL);
+    latency_histogram_destroy(h);
+    printf("OK\n");
+}
+
+static void test_percentiles(void) {
+    printf("Test: percentiles of a uniform distribution... ");
+
+    static latency_histogram_snapshot_t snap;
+    latency_histogram_t *h = make_hist(10000, 30);
+    for (uint64_t v = 1; v <= 100000; v++) {
+        latency_histogram_record_at(h, v, 1000);
+    }
+    assert(latency_histogram_snapshot_at(h, 60000, 1000, &snap) == 0);
+    assert(snap.total == 100000);
+    assert_close(latency_histogram_percentile(&snap, 50.0), 50000);
+    assert_close(latency_histogram_percentile(&snap, 90.0), 90000);
+    assert_close(latency_histogram_percentile(&snap, 99.0), 99000);
+    assert_close(latency_histogram_percentile(&snap, 99.9), 99900);
+    assert(latency_histogram_percentile(&snap, 0.0) == 1);
+    assert_close(latency_histogram_percentile(&snap, 100.0), 100000);
+
+    memset(&snap, 0, sizeof(snap));
+    assert(latency_histogram_percentile(&snap, 99.0) == 0);
+    latency_histogram_destroy(h);
+    printf("OK\n");
+}
+
+static void test_sliding_windows(void) {
+    printf("Test: samples age out of the 1m window, then the 5m one... ");
+
+    static latency_histogram_snapshot_t snap;
+    latency_histogram_t *h = make_hist(10000, 30);
+    latency_histogram_record_at(h, 100, 0);
+    latency_histogram_record_at(h, 200, 65000);
+
+    /* At 65s the 1m window covers slices 1..6: only the second sample */
+    assert(latency_histogram_snapshot_at(h, 60000, 65000, &snap) == 0);
+    assert(snap.total == 1);
+    assert_close(latency_histogram_percentile(&snap, 100.0), 200);
+    assert(latency_histogram_snapshot_at(h, 300000, 65000, &snap) == 0);
+    assert(snap.total == 2);
+    assert(latency_histogram_percentile(&snap, 0.0) == 100);
+
+    /* Nothing recorded since: both windows drain without any writer */
+    assert(latency_histogram_snapshot_at(h, 60000, 130000, &snap) == 0);
+    assert(snap.total == 0);
+    assert(latency_histogram_snapshot_at(h, 300000, 300000, &snap) == 0);
+    assert(snap.total == 1);
+    assert(latency_histogram_snapshot_at(h, 300000, 370000, &snap) == 0);
+    assert(snap.total == 0);
+
+    /* Slice 30 reuses slice 0's row and must not inherit its count */
+    latency_histogram_record_at(h, 300, 300000);
+    assert(latency_histogram_snapshot_at(h, 10000, 300000, &snap) == 0);
+    assert(snap.total == 1);
+    assert_close(latency_histogram_percentile(&snap, 50.0), 300);
+
+    /* A window longer than the ring is capped at the ring */
+    assert(latency_histogram_snapshot_at(h, 3600000, 300000, &snap) == 0);
+    assert(snap.total == 2);
+    latency_histogram_destroy(h);
+    printf("OK\n");
+}
+
+typedef struct {
+    latency_histogram_t *h;
+    uint64_t base;
+} writer_arg_t;
+
+static void *writer(void *p) {
+    writer_arg_t *a = p;
+    for (uint64_t i = 0; i < PER_THREAD; i++) {
+        latency_histogram_record(a->h, a->base + (i % 1000));
+    }
+    return NULL;
+}
+
+static void test_threads_merge(void) {
+    printf("Test: per-thread shards merge into one view... ");
+
+    static latency_histogram_snapshot_t snap;
+    latency_histogram_t *h = make_hist(60000, 5);
+    pthread_t threads[THREADS];
+    writer_arg_t args[THREADS];
+    for (int i = 0; i < THREADS; i++) {
+        args[i].h = h;
+        args[i].base = (uint64_t)i * 1000U;
+        assert(pthread_create(&threads[i], NULL, writer, &args[i]) == 0);
+    }
+    /* Readers may run alongside writers */
+    for (int i = 0; i < 20; i++) {
+        assert(latency_histogram_snapshot(h, 300000, &snap) == 0);
+        assert(snap.total <= (uint64_t)THREADS * PER_THREAD);
+    }
+    for (int i = 0; i < THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    assert(latency_histogram_snapshot(h, 300000, &snap) == 0);
+    assert(snap.total == (uint64_t)THREADS * PER_THREAD);
+    assert_close(latency_histogram_percentile(&snap, 50.0), 1999);
+    assert_close(latency_histogram_percentile(&snap, 100.0), 3999);
+    latency_histogram_destroy(h);
+
+    latency_histogram_config_t bad = { .slice_ms = 0, .slices = 30 };
+    assert(latency_histogram_create(&bad) == NULL);
+    assert(latency_histogram_snapshot(NULL, 60000, &snap) == -1);
+    latency_histogram_record(NULL, 1);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("=== Latency Histogram Tests ===\n");
+
+    test_bounded_relative_error();
+    test_percentiles();
+    test_sliding_windows();
+    test_threads_merge();
+
+    printf("\nAll tests passed!\n");
+    return 0;
+}
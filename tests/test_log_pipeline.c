@@ -0,0 +1,254 @@
+/**
+ * test_log_pipeline.c - Asynchronous batched logging tests
+ */
+
+#define _GNU_SOURCE
+#include "log_pipeline.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#define THREADS 4
+#define PER_THREAD 20000
+
+static atomic_int gate_open = 1;
+
+static size_t format_event(const log_record_t *rec, char *out, size_t cap) {
+    while (!atomic_load(&gate_open)) usleep(1000);
+    log_line_t l = { out, cap, 0 };
+    log_line_raw(&l, "{\"thread\":");
+    log_line_value(&l, &rec->values[0]);
+    log_line_raw(&l, ",\"seq\":");
+    log_line_value(&l, &rec->values[1]);
+    log_line_raw(&l, ",\"message\":");
+    log_line_value(&l, &rec->values[2]);
+    log_line_raw(&l, "}");
+    return log_line_end(&l);
+}
+
+/* Everything written to f so far */
+static char *slurp(FILE *f, size_t *len) {
+    fflush(f);
+    long end = lseek(fileno(f), 0, SEEK_END);
+    char *buf = malloc((size_t)end + 1U);
+    assert(pread(fileno(f), buf, (size_t)end, 0) == end);
+    buf[end] = '\0';
+    *len = (size_t)end;
+    return buf;
+}
+
+typedef struct {
+    log_pipeline_t *p;
+    int fd;
+    int id;
+    int count;
+} producer_t;
+
+static void *producer_main(void *arg) {
+    producer_t *pr = arg;
+    for (int i = 0; i < pr->count; i++) {
+        log_value_t v[] = { LOG_INT(pr->id), LOG_INT(i), LOG_STR("hello") };
+        (void)log_pipeline_write(pr->p, pr->fd, format_event, v, 3);
+    }
+    return NULL;
+}
+
+static void run_producers(log_pipeline_t *p, int fd, int per_thread) {
+    pthread_t threads[THREADS];
+    producer_t pr[THREADS];
+    for (int t = 0; t < THREADS; t++) {
+        pr[t] = (producer_t){ p, fd, t, per_thread };
+        pthread_create(&threads[t], NULL, producer_main, &pr[t]);
+    }
+    for (int t = 0; t < THREADS; t++) pthread_join(threads[t], NULL);
+}
+
+/* Every line well formed and each thread's lines in order; returns lines */
+static int check_lines(const char *buf, int *last_seq) {
+    int lines = 0;
+    for (int t = 0; t < THREADS; t++) last_seq[t] = -1;
+    for (const char *s = buf; *s; ) {
+        const char *nl = strchr(s, '\n');
+        assert(nl != NULL);
+        /* sscanf on the whole buffer would strlen it for every line */
+        char line[128];
+        assert((size_t)(nl - s) < sizeof(line));
+        memcpy(line, s, (size_t)(nl - s));
+        line[nl - s] = '\0';
+        int thread = -1, seq = -1, end = 0;
+        assert(sscanf(line, "{\"thread\":%d,\"seq\":%d,\"message\":\"hello\"}%n", &thread, &seq, &end) == 2);
+        assert(end == nl - s);
+        assert(thread >= 0 && thread < THREADS && seq > last_seq[thread]);
+        last_seq[thread] = seq;
+        lines++;
+        s = nl + 1;
+    }
+    return lines;
+}
+
+static void test_line_building(void) {
+    printf("Test: line building escapes and bounds output... ");
+    char out[64];
+    log_line_t l = { out, sizeof(out), 0 };
+    log_line_str(&l, "a\"b\\c\nd\x01", 8);
+    log_line_raw(&l, ",");
+    log_line_int(&l, -42);
+    log_line_raw(&l, ",");
+    log_value_t null_value = LOG_STR(NULL);
+    null_value.kind = LOG_VALUE_NULL;
+    log_line_value(&l, &null_value);
+    size_t n = log_line_end(&l);
+    assert(n == strlen("\"a\\\"b\\\\c\\nd\\u0001\",-42,null"));
+    assert(memcmp(out, "\"a\\\"b\\\\c\\nd\\u0001\",-42,null", n) == 0);
+
+    l = (log_line_t){ out, sizeof(out), 0 };
+    log_line_timestamp(&l, 1700000000123456ULL, 6);
+    log_line_raw(&l, " ");
+    log_line_timestamp(&l, 1700000000123456ULL, 3);
+    n = log_line_end(&l);
+    assert(n == strlen("\"2023-11-14T22:13:20.123456Z\" \"2023-11-14T22:13:20.123Z\""));
+    assert(memcmp(out, "\"2023-11-14T22:13:20.123456Z\" \"2023-11-14T22:13:20.123Z\"", n) == 0);
+
+    l = (log_line_t){ out, 8, 0 };
+    log_line_raw(&l, "0123456789");
+    assert(log_line_end(&l) == 0);
+    printf("OK\n");
+}
+
+static void test_batched_writes(void) {
+    printf("Test: records from many threads arrive whole and in order... ");
+    FILE *f = tmpfile();
+    log_pipeline_config_t config;
+    log_pipeline_get_default_config(&config);
+    config.overflow = LOG_OVERFLOW_BLOCK;
+    log_pipeline_t *p = log_pipeline_create(&config);
+    assert(p != NULL);
+
+    run_producers(p, fileno(f), PER_THREAD);
+    log_pipeline_flush(p);
+
+    size_t len = 0;
+    char *buf = slurp(f, &len);
+    int last_seq[THREADS];
+    assert(check_lines(buf, last_seq) == THREADS * PER_THREAD);
+    for (int t = 0; t < THREADS; t++) assert(last_seq[t] == PER_THREAD - 1);
+
+    log_pipeline_stats_t stats;
+    log_pipeline_get_stats(p, &stats);
+    assert(stats.queued == THREADS * PER_THREAD && stats.written == stats.queued);
+    assert(stats.dropped == 0 && stats.write_errors == 0);
+    assert(stats.batches > 0 && stats.batches < stats.written / 10U);
+    free(buf);
+    log_pipeline_destroy(p);
+    fclose(f);
+    printf("OK\n");
+}
+
+static void test_overflow_drop(void) {
+    printf("Test: a full ring drops and counts... ");
+    FILE *f = tmpfile();
+    log_pipeline_config_t config;
+    log_pipeline_get_default_config(&config);
+    config.ring_kb = 64;
+    log_pipeline_t *p = log_pipeline_create(&config);
+
+    /* The writer stalls on the first record it formats */
+    atomic_store(&gate_open, 0);
+    producer_t pr = { p, fileno(f), 0, 5000 };
+    producer_main(&pr);
+    log_pipeline_stats_t stats;
+    log_pipeline_get_stats(p, &stats);
+    assert(stats.dropped > 0 && stats.queued + stats.dropped == 5000);
+    atomic_store(&gate_open, 1);
+    log_pipeline_flush(p);
+
+    log_pipeline_get_stats(p, &stats);
+    assert(stats.written == stats.queued);
+    size_t len = 0;
+    char *buf = slurp(f, &len);
+    int last_seq[THREADS];
+    assert(check_lines(buf, last_seq) == (int)stats.written);
+    free(buf);
+    log_pipeline_destroy(p);
+    fclose(f);
+    printf("OK\n");
+}
+
+static void *open_gate_later(void *arg) {
+    (void)arg;
+    usleep(50000);
+    atomic_store(&gate_open, 1);
+    return NULL;
+}
+
+static void test_overflow_block(void) {
+    printf("Test: a full ring blocks the producer until there is room... ");
+    FILE *f = tmpfile();
+    log_pipeline_config_t config;
+    log_pipeline_get_default_config(&config);
+    config.ring_kb = 64;
+    config.overflow = LOG_OVERFLOW_BLOCK;
+    log_pipeline_t *p = log_pipeline_create(&config);
+
+    atomic_store(&gate_open, 0);
+    pthread_t opener;
+    pthread_create(&opener, NULL, open_gate_later, NULL);
+    producer_t pr = { p, fileno(f), 0, 5000 };
+    producer_main(&pr);
+    pthread_join(opener, NULL);
+    log_pipeline_flush(p);
+
+    log_pipeline_stats_t stats;
+    log_pipeline_get_stats(p, &stats);
+    assert(stats.blocked > 0 && stats.dropped == 0);
+    assert(stats.queued == 5000 && stats.written == 5000);
+    log_pipeline_destroy(p);
+    fclose(f);
+    printf("OK\n");
+}
+
+static void test_close_and_sync(void) {
+    printf("Test: close flushes, later writes are synchronous... ");
+    FILE *f = tmpfile();
+    log_pipeline_config_t config;
+    log_pipeline_get_default_config(&config);
+    config.flush_interval_ms = 60000;
+    log_pipeline_t *p = log_pipeline_create(&config);
+
+    producer_t pr = { p, fileno(f), 0, 100 };
+    producer_main(&pr);
+    log_pipeline_close(p);
+    size_t len = 0;
+    char *buf = slurp(f, &len);
+    int last_seq[THREADS];
+    assert(check_lines(buf, last_seq) == 100);
+    free(buf);
+
+    log_value_t v[] = { LOG_INT(1), LOG_INT(0), LOG_STR("hello") };
+    assert(log_pipeline_write(p, fileno(f), format_event, v, 3) == 0);
+    v[1] = LOG_INT(1);
+    assert(log_pipeline_write(NULL, fileno(f), format_event, v, 3) == 0);
+    buf = slurp(f, &len);
+    assert(check_lines(buf, last_seq) == 102);
+    free(buf);
+    log_pipeline_destroy(p);
+    fclose(f);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("=== Log Pipeline Tests ===\n\n");
+
+    test_line_building();
+    test_batched_writes();
+    test_overflow_drop();
+    test_overflow_block();
+    test_close_and_sync();
+
+    printf("\nAll tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,186 @@
+/**
+ * test_log_throttle.c - Per-callsite log rate limiting tests
+ */
+
+#define _GNU_SOURCE
+#include "log_throttle.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define THREADS 4
+#define PER_THREAD 100000
+
+#define T0 1000000000ULL                 /* An arbitrary monotonic time */
+
+static atomic_int hook_sampled = 0;
+static atomic_int hook_limited = 0;
+
+static void count_hook(const log_callsite_t *site, log_throttle_reason_t reason) {
+    (void)site;
+    if (reason == LOG_THROTTLE_SAMPLED) atomic_fetch_add(&hook_sampled, 1);
+    else atomic_fetch_add(&hook_limited, 1);
+}
+
+static void configure(log_level_t level, int rate, int burst) {
+    log_throttle_config_t config;
+    log_throttle_get_default_config(&config);
+    config.level = level;
+    config.rate_per_sec = rate;
+    config.burst = burst;
+    assert(log_throttle_configure(&config) == 0);
+}
+
+static void test_token_bucket(void) {
+    printf("Test: bucket allows a burst, then the rate, and reports what it held back... ");
+    static log_callsite_t site = LOG_CALLSITE_INIT("bucket", LOG_LEVEL_WARN);
+    configure(LOG_LEVEL_INFO, 10, 3);
+
+    uint64_t suppressed = 99;
+    for (int i = 0; i < 3; i++) {
+        assert(log_throttle_allow_at(&site, T0, &suppressed) == 1);
+        assert(suppressed == 0);
+    }
+    for (int i = 0; i < 50; i++) {
+        assert(log_throttle_allow_at(&site, T0 + 1000U, &suppressed) == 0);
+    }
+    /* One interval (100ms) later exactly one more line */
+    assert(log_throttle_allow_at(&site, T0 + 100000U, &suppressed) == 1);
+    assert(suppressed == 50);
+    assert(log_throttle_allow_at(&site, T0 + 100000U, &suppressed) == 0);
+
+    /* A long quiet spell refills the whole burst, not more */
+    int allowed = 0;
+    for (int i = 0; i < 10; i++) {
+        allowed += log_throttle_allow_at(&site, T0 + 10000000U, &suppressed);
+    }
+    assert(allowed == 3);
+    printf("OK\n");
+}
+
+static void test_level_filter(void) {
+    printf("Test: callsites above the level are skipped and not counted... ");
+    static log_callsite_t site = LOG_CALLSITE_INIT("level", LOG_LEVEL_DEBUG);
+    configure(LOG_LEVEL_INFO, 0, 1);
+
+    uint64_t suppressed = 0;
+    for (int i = 0; i < 10; i++) {
+        assert(log_throttle_allow_at(&site, T0, &suppressed) == 0);
+    }
+    configure(LOG_LEVEL_DEBUG, 0, 1);
+    assert(log_throttle_allow_at(&site, T0, &suppressed) == 1);
+    assert(suppressed == 0);
+    printf("OK\n");
+}
+
+static void test_sampling(void) {
+    printf("Test: sampling keeps one message in N per level... ");
+    static log_callsite_t site = LOG_CALLSITE_INIT("sampled", LOG_LEVEL_INFO);
+    log_throttle_config_t config;
+    log_throttle_get_default_config(&config);
+    config.rate_per_sec = 0;
+    config.sample_every[LOG_LEVEL_INFO] = 4;
+    assert(log_throttle_configure(&config) == 0);
+
+    atomic_store(&hook_sampled, 0);
+    log_throttle_set_hook(count_hook);
+    int allowed = 0;
+    uint64_t suppressed = 0;
+    for (int i = 0; i < 12; i++) {
+        if (log_throttle_allow_at(&site, T0, &suppressed)) {
+            assert(suppressed == (allowed == 0 ? 0U : 3U));
+            allowed++;
+        }
+    }
+    assert(allowed == 3);
+    assert(atomic_load(&hook_sampled) == 9);
+    log_throttle_set_hook(NULL);
+
+    log_throttle_config_t current;
+    log_throttle_get_config(&current);
+    assert(current.sample_every[LOG_LEVEL_INFO] == 4 && current.rate_per_sec == 0);
+    printf("OK\n");
+}
+
+static log_callsite_t shared_site = LOG_CALLSITE_INIT("shared", LOG_LEVEL_WARN);
+
+static void *hammer(void *arg) {
+    (void)arg;
+    uint64_t suppressed = 0;
+    for (int i = 0; i < PER_THREAD; i++) {
+        (void)log_throttle_allow_at(&shared_site, T0, &suppressed);
+    }
+    return NULL;
+}
+
+static void test_concurrent_callers(void) {
+    printf("Test: concurrent callers share one bucket exactly... ");
+    configure(LOG_LEVEL_INFO, 1, 10);
+    atomic_store(&hook_limited, 0);
+    log_throttle_set_hook(count_hook);
+
+    pthread_t threads[THREADS];
+    for (int t = 0; t < THREADS; t++) pthread_create(&threads[t], NULL, hammer, NULL);
+    for (int t = 0; t < THREADS; t++) pthread_join(threads[t], NULL);
+    log_throttle_set_hook(NULL);
+
+    log_callsite_stats_t stats[16];
+    size_t n = log_throttle_get_stats(stats, 16);
+    assert(n >= 4 && n <= 16);
+    int found = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (strcmp(stats[i].name, "shared") == 0) {
+            assert(stats[i].emitted == 10);
+            assert(stats[i].suppressed == THREADS * PER_THREAD - 10);
+            assert(stats[i].level == LOG_LEVEL_WARN);
+            found = 1;
+        }
+    }
+    assert(found);
+    assert(atomic_load(&hook_limited) == THREADS * PER_THREAD - 10);
+    printf("OK\n");
+}
+
+static void test_config(void) {
+    printf("Test: environment overrides and validation... ");
+    setenv("GATEWAY_LOG_LEVEL", "warning", 1);
+    setenv("GATEWAY_LOG_RATE", "0", 1);
+    setenv("GATEWAY_LOG_BURST", "0", 1);
+    setenv("GATEWAY_LOG_SAMPLE_DEBUG", "100", 1);
+    log_throttle_config_t config;
+    log_throttle_get_default_config(&config);
+    assert(log_throttle_parse_config(&config) == 0);
+    assert(config.level == LOG_LEVEL_WARN);
+    assert(config.rate_per_sec == 0);
+    assert(config.burst == 5);
+    assert(config.sample_every[LOG_LEVEL_DEBUG] == 100);
+    assert(config.sample_every[LOG_LEVEL_INFO] == 1);
+
+    log_level_t level;
+    assert(log_level_parse("DEBUG", &level) == 0 && level == LOG_LEVEL_DEBUG);
+    assert(log_level_parse("verbose", &level) == -1);
+    assert(strcmp(log_level_name(LOG_LEVEL_ERROR), "error") == 0);
+
+    config.burst = 0;
+    assert(log_throttle_configure(&config) == -1);
+    config.burst = 1;
+    config.sample_every[LOG_LEVEL_WARN] = 0;
+    assert(log_throttle_configure(&config) == -1);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("=== Log Throttle Tests ===\n\n");
+
+    test_token_bucket();
+    test_level_filter();
+    test_sampling();
+    test_concurrent_callers();
+    test_config();
+
+    printf("\nAll tests passed!\n");
+    return 0;
+}
@@ -193,6 +193,75 @@ static void* worker_thread(void *arg) {
     return NULL;
 }
 
+static int hook_opens = 0;
+static int hook_closes = 0;
+
+static int count_open(nats_connection_t *conn, void *arg) {
+    (void)arg;
+    __sync_fetch_and_add(&hook_opens, 1);
+    nats_pool_set_user(conn, conn);
+    return 0;
+}
+
+static void count_close(nats_connection_t *conn, void *arg) {
+    (void)arg;
+    assert(nats_pool_get_user(conn) == conn);
+    __sync_fetch_and_add(&hook_closes, 1);
+}
+
+static nats_pool_t *affinity_pool = NULL;
+
+static void* affinity_thread(void *arg) {
+    nats_connection_t **mine = (nats_connection_t**)arg;
+    *mine = nats_pool_thread_connection(affinity_pool);
+    for (int i = 0; i < 1000; i++) {
+        assert(nats_pool_thread_connection(affinity_pool) == *mine);
+    }
+    return NULL;
+}
+
+static void test_thread_affinity(void) {
+    printf("Test: thread affinity... ");
+    
+    nats_pool_config_t config = {
+        .min_connections = 1,
+        .max_connections = 3,
+        .connection_timeout_ms = 1000,
+        .idle_timeout_sec = 1,
+        .max_reconnect_attempts = 3,
+        .nats_url = "nats://localhost:4222",
+        .hooks = { count_open, count_close, NULL, NULL }
+    };
+    
+    affinity_pool = nats_pool_init(&config);
+    assert(affinity_pool != NULL);
+    
+    /* Each thread keeps one connection; the first three get their own */
+    pthread_t threads[5];
+    nats_connection_t *bound[5];
+    for (int i = 0; i < 5; i++) {
+        pthread_create(&threads[i], NULL, affinity_thread, &bound[i]);
+        pthread_join(threads[i], NULL);
+        assert(bound[i] != NULL && nats_pool_connection_healthy(bound[i]));
+    }
+    assert(bound[0] != bound[1] && bound[1] != bound[2] && bound[0] != bound[2]);
+    
+    nats_pool_stats_t stats;
+    nats_pool_get_stats(affinity_pool, &stats);
+    assert(stats.open_connections == 3);
+    assert(stats.healthy_connections == 3);
+    assert(stats.bound_threads == 5);
+    assert(stats.total_acquired == 0);  /* Bound, not acquired */
+    
+    /* Bound connections survive the idle timeout */
+    sleep(2);
+    assert(nats_pool_health_check(affinity_pool) == 0);
+    
+    nats_pool_destroy(affinity_pool);
+    assert(hook_opens == 3 && hook_closes == 3);
+    printf("OK\n");
+}
+
 static void test_concurrent_access(void) {
     printf("Test: concurrent access... ");
     
@@ -241,6 +310,7 @@ int main(void) {
     test_pool_exhaustion();
     test_health_check();
     test_concurrent_access();
+    test_thread_affinity();
     
     printf("\nAll tests passed!\n");
     return 0;
@@ -0,0 +1,471 @@
+/**
+ * test_nats_standin.c - NATS stand-in and mock Router tests
+ *
+ * Drives an in-process stand-in on a free port over plain sockets, the
+ * way a NATS client would.
+ */
+
+#define _GNU_SOURCE
+#include "nats_standin.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+typedef struct {
+    int fd;
+    char buf[65536];
+    size_t len;
+} conn_t;
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+static nats_standin_t *start(const nats_standin_config_t *overrides) {
+    nats_standin_config_t config;
+    if (overrides) {
+        config = *overrides;
+    } else {
+        nats_standin_get_default_config(&config);
+    }
+    config.port = 0;
+    nats_standin_t *s = nats_standin_create(&config);
+    assert(s != NULL);
+    assert(nats_standin_get_port(s) != 0);
+    return s;
+}
+
+/* Read until buf holds at least want bytes; 0 when the peer closed */
+static int fill(conn_t *c, size_t want) {
+    while (c->len < want) {
+        ssize_t n = recv(c->fd, c->buf + c->len, sizeof(c->buf) - c->len, 0);
+        if (n <= 0) return 0;
+        c->len += (size_t)n;
+    }
+    return 1;
+}
+
+/* Next line, without CRLF, into out; 0 when the peer closed */
+static int read_line(conn_t *c, char *out, size_t cap) {
+    for (;;) {
+        char *nl = memchr(c->buf, '\n', c->len);
+        if (nl) {
+            size_t len = (size_t)(nl - c->buf);
+            size_t copy = len > 0 && c->buf[len - 1] == '\r' ? len - 1 : len;
+            assert(copy < cap);
+            memcpy(out, c->buf, copy);
+            out[copy] = '\0';
+            memmove(c->buf, nl + 1, c->len - len - 1);
+            c->len -= len + 1;
+            return 1;
+        }
+        if (!fill(c, c->len + 1)) return 0;
+    }
+}
+
+/* Payload of n bytes plus its CRLF */
+static void read_payload(conn_t *c, char *out, size_t n) {
+    assert(fill(c, n + 2));
+    memcpy(out, c->buf, n);
+    out[n] = '\0';
+    assert(c->buf[n] == '\r' && c->buf[n + 1] == '\n');
+    memmove(c->buf, c->buf + n + 2, c->len - n - 2);
+    c->len -= n + 2;
+}
+
+static void send_str(conn_t *c, const char *text) {
+    size_t len = strlen(text);
+    assert(send(c->fd, text, len, MSG_NOSIGNAL) == (ssize_t)len);
+}
+
+static void expect(conn_t *c, const char *line) {
+    char got[4096];
+    assert(read_line(c, got, sizeof(got)));
+    if (strcmp(got, line) != 0) {
+        fprintf(stderr, "expected '%s', got '%s'\n", line, got);
+        assert(0);
+    }
+}
+
+/* Connect, read INFO and send CONNECT; PING/PONG makes sure it was seen */
+static void dial(nats_standin_t *s, conn_t *c, int verbose, int headers) {
+    memset(c, 0, sizeof(*c));
+    c->fd = socket(AF_INET, SOCK_STREAM, 0);
+    assert(c->fd >= 0);
+    struct timeval tv = { .tv_sec = 5, .tv_usec = 0 };
+    setsockopt(c->fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(nats_standin_get_port(s));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(connect(c->fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+
+    char line[4096];
+    assert(read_line(c, line, sizeof(line)));
+    assert(strncmp(line, "INFO {", 6) == 0);
+    assert(strstr(line, "\"headers\":true") != NULL);
+    assert(strstr(line, "\"max_payload\":") != NULL);
+
+    char connect_line[256];
+    snprintf(connect_line, sizeof(connect_line),
+             "CONNECT {\"verbose\":%s,\"pedantic\":false,\"headers\":%s,\"protocol\":1}\r\nPING\r\n",
+             verbose ? "true" : "false", headers ? "true" : "false");
+    send_str(c, connect_line);
+    if (verbose) expect(c, "+OK");
+    expect(c, "PONG");
+}
+
+static void hang_up(conn_t *c) {
+    close(c->fd);
+}
+
+/* Round trip, so everything sent before it has been routed */
+static void sync_conn(conn_t *c) {
+    send_str(c, "PING\r\n");
+    expect(c, "PONG");
+}
+
+static void test_handshake(void) {
+    printf("Test: INFO, verbose CONNECT and PING/PONG... ");
+    nats_standin_t *s = start(NULL);
+    conn_t c;
+    dial(s, &c, 1, 1);
+    send_str(&c, "SUB foo 1\r\n");
+    expect(&c, "+OK");
+    sync_conn(&c);
+    hang_up(&c);
+
+    nats_standin_stats_t st;
+    nats_standin_get_stats(s, &st);
+    assert(st.connections == 1);
+    nats_standin_destroy(s);
+    printf("OK\n");
+}
+
+static void test_pub_sub(void) {
+    printf("Test: PUB reaches wildcard subscribers as MSG... ");
+    nats_standin_t *s = start(NULL);
+    conn_t sub, pub;
+    dial(s, &sub, 0, 0);
+    dial(s, &pub, 0, 0);
+    send_str(&sub, "SUB orders.* 1\r\nSUB orders.> 2\r\nSUB other 3\r\n");
+    sync_conn(&sub);
+
+    send_str(&pub, "PUB orders.eu 5\r\nhello\r\nPUB orders.eu.x inbox.1 2\r\nhi\r\nPUB nobody 1\r\nz\r\n");
+    sync_conn(&pub);
+
+    char payload[64];
+    expect(&sub, "MSG orders.eu 1 5");
+    read_payload(&sub, payload, 5);
+    assert(strcmp(payload, "hello") == 0);
+    expect(&sub, "MSG orders.eu 2 5");
+    read_payload(&sub, payload, 5);
+    expect(&sub, "MSG orders.eu.x 2 inbox.1 2");
+    read_payload(&sub, payload, 2);
+    assert(strcmp(payload, "hi") == 0);
+    sync_conn(&sub);
+
+    /* Payload split across writes, then a message in one byte writes */
+    send_str(&pub, "PUB other 10\r\n01234");
+    usleep(20000);
+    send_str(&pub, "56789\r\n");
+    const char *bytes = "PUB other 1\r\nx\r\n";
+    for (const char *p = bytes; *p; p++) {
+        char one[2] = { *p, '\0' };
+        send_str(&pub, one);
+    }
+    expect(&sub, "MSG other 3 10");
+    read_payload(&sub, payload, 10);
+    assert(strcmp(payload, "0123456789") == 0);
+    expect(&sub, "MSG other 3 1");
+    read_payload(&sub, payload, 1);
+
+    nats_standin_stats_t st;
+    nats_standin_get_stats(s, &st);
+    assert(st.msgs_in == 5);
+    assert(st.msgs_out == 5);
+    hang_up(&sub);
+    hang_up(&pub);
+    nats_standin_destroy(s);
+    printf("OK\n");
+}
+
+static void test_headers(void) {
+    printf("Test: HPUB is delivered as HMSG, or as MSG without headers... ");
+    nats_standin_t *s = start(NULL);
+    conn_t with, without, pub;
+    dial(s, &with, 0, 1);
+    dial(s, &without, 0, 0);
+    dial(s, &pub, 0, 1);
+    send_str(&with, "SUB h 7\r\n");
+    send_str(&without, "SUB h 8\r\n");
+    sync_conn(&with);
+    sync_conn(&without);
+
+    const char *hdr = "NATS/1.0\r\nX-Id: 1\r\n\r\n";          /* 21 bytes */
+    char msg[128];
+    snprintf(msg, sizeof(msg), "HPUB h reply.h 21 25\r\n%sbody\r\n", hdr);
+    send_str(&pub, msg);
+
+    char payload[64];
+    expect(&with, "HMSG h 7 reply.h 21 25");
+    read_payload(&with, payload, 25);
+    assert(strncmp(payload, "NATS/1.0", 8) == 0);
+    assert(strcmp(payload + 21, "body") == 0);
+    expect(&without, "MSG h 8 reply.h 4");
+    read_payload(&without, payload, 4);
+    assert(strcmp(payload, "body") == 0);
+
+    hang_up(&with);
+    hang_up(&without);
+    hang_up(&pub);
+    nats_standin_destroy(s);
+    printf("OK\n");
+}
+
+static void test_unsub_and_queue_groups(void) {
+    printf("Test: UNSUB with a limit, and one delivery per queue group... ");
+    nats_standin_t *s = start(NULL);
+    conn_t a, b, pub;
+    dial(s, &a, 0, 0);
+    dial(s, &b, 0, 0);
+    dial(s, &pub, 0, 0);
+    send_str(&a, "SUB limited 1\r\nUNSUB 1 2\r\nSUB work workers 2\r\n");
+    send_str(&b, "SUB work workers 9\r\n");
+    sync_conn(&a);
+    sync_conn(&b);
+
+    for (int i = 0; i < 3; i++) send_str(&pub, "PUB limited 1\r\nx\r\n");
+    for (int i = 0; i < 200; i++) send_str(&pub, "PUB work 1\r\nw\r\n");
+    sync_conn(&pub);
+
+    /* Everything routed before pub's PONG comes before their own */
+    char line[256], payload[8];
+    int limited = 0, work_a = 0, work_b = 0;
+    send_str(&a, "PING\r\n");
+    for (;;) {
+        assert(read_line(&a, line, sizeof(line)));
+        if (strcmp(line, "PONG") == 0) break;
+        assert(strncmp(line, "MSG ", 4) == 0);
+        read_payload(&a, payload, 1);
+        if (strncmp(line, "MSG limited", 11) == 0) limited++;
+        else work_a++;
+    }
+    send_str(&b, "PING\r\n");
+    for (;;) {
+        assert(read_line(&b, line, sizeof(line)));
+        if (strcmp(line, "PONG") == 0) break;
+        read_payload(&b, payload, 1);
+        work_b++;
+    }
+    assert(limited == 2);
+    assert(work_a + work_b == 200);
+    assert(work_a > 20 && work_b > 20);
+
+    hang_up(&a);
+    hang_up(&b);
+    hang_up(&pub);
+    nats_standin_destroy(s);
+    printf("OK\n");
+}
+
+static void test_protocol_errors(void) {
+    printf("Test: unknown operations and oversize payloads close the client... ");
+    nats_standin_config_t config;
+    nats_standin_get_default_config(&config);
+    config.max_payload = 16;
+    nats_standin_t *s = start(&config);
+    conn_t c;
+    char line[256];
+    dial(s, &c, 0, 0);
+    send_str(&c, "BOGUS\r\n");
+    expect(&c, "-ERR 'Unknown Protocol Operation'");
+    assert(!read_line(&c, line, sizeof(line)));
+    hang_up(&c);
+
+    dial(s, &c, 0, 0);
+    send_str(&c, "PUB x 17\r\n");
+    expect(&c, "-ERR 'Maximum Payload Violation'");
+    hang_up(&c);
+
+    nats_standin_stats_t st;
+    nats_standin_get_stats(s, &st);
+    assert(st.protocol_errors == 2);
+    nats_standin_destroy(s);
+    printf("OK\n");
+}
+
+/* One request on the Router subject; returns the answer's latency */
+static uint64_t request(conn_t *c, const char *subject, const char *inbox, char *answer, size_t cap) {
+    char msg[256];
+    snprintf(msg, sizeof(msg), "PUB %s %s 2\r\n{}\r\n", subject, inbox);
+    uint64_t t0 = now_us();
+    send_str(c, msg);
+    char line[256];
+    assert(read_line(c, line, sizeof(line)));
+    uint64_t elapsed = now_us() - t0;
+    unsigned sid;
+    size_t len;
+    char got_subject[128];
+    assert(sscanf(line, "MSG %127s %u %zu", got_subject, &sid, &len) == 3);
+    assert(strcmp(got_subject, inbox) == 0);
+    assert(len < cap);
+    read_payload(c, answer, len);
+    return elapsed;
+}
+
+static void test_responder(void) {
+    printf("Test: the responder answers Router requests after the set latency... ");
+    nats_standin_config_t config;
+    nats_standin_get_default_config(&config);
+    config.latency.median_us = 20000;
+    config.response_bytes = 1024;
+    nats_standin_t *s = start(&config);
+    conn_t c;
+    dial(s, &c, 0, 0);
+    send_str(&c, "SUB _INBOX.test.* 1\r\n");
+    sync_conn(&c);
+
+    char answer[4096];
+    uint64_t elapsed = request(&c, "beamline.router.v1.decide", "_INBOX.test.1", answer, sizeof(answer));
+    assert(elapsed >= 20000);
+    assert(strncmp(answer, "{\"ok\":true,\"message_id\":\"standin-1\"", 35) == 0);
+    assert(strlen(answer) == 1024);
+    assert(answer[1023] == '}');
+    assert(strstr(answer, "\"padding\":\"xxx") != NULL);
+
+    request(&c, "beamline.router.v1.ingest.acme", "_INBOX.test.2", answer, sizeof(answer));
+    assert(strncmp(answer, "{\"stream\":\"STANDIN\",\"seq\":1,", 28) == 0);
+
+    /* Outside the responder's subjects: no answer, nothing queued */
+    send_str(&c, "PUB elsewhere _INBOX.test.3 2\r\n{}\r\n");
+    sync_conn(&c);
+
+    nats_standin_stats_t st;
+    nats_standin_get_stats(s, &st);
+    assert(st.requests == 2);
+    assert(st.responses == 2);
+    hang_up(&c);
+    nats_standin_destroy(s);
+
+    /* Every answer an error, delivered at once */
+    nats_standin_get_default_config(&config);
+    config.error_rate = 1.0;
+    s = start(&config);
+    dial(s, &c, 0, 0);
+    send_str(&c, "SUB _INBOX.e.* 1\r\n");
+    sync_conn(&c);
+    request(&c, "beamline.router.v1.decide", "_INBOX.e.1", answer, sizeof(answer));
+    assert(strncmp(answer, "{\"ok\":false,\"error\":{\"code\":\"internal\"", 38) == 0);
+    request(&c, "beamline.router.v1.ingest.acme", "_INBOX.e.2", answer, sizeof(answer));
+    assert(strncmp(answer, "{\"error\":{\"code\":503", 20) == 0);
+    nats_standin_get_stats(s, &st);
+    assert(st.errors_injected == 2);
+    hang_up(&c);
+    nats_standin_destroy(s);
+    printf("OK\n");
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void test_latency_distributions(void) {
+    printf("Test: latency draws follow the configured distribution... ");
+    enum { N = 20001 };
+    static uint64_t draws[N];
+    uint64_t rng = 42;
+
+    nats_standin_latency_t fixed = { NATS_STANDIN_LATENCY_FIXED, 500, 0.0, 0, 0.0 };
+    assert(nats_standin_sample_latency(&fixed, &rng) == 500);
+
+    nats_standin_latency_t lognormal = { NATS_STANDIN_LATENCY_LOGNORMAL, 1000, 0.5, 0, 0.0 };
+    for (int i = 0; i < N; i++) draws[i] = nats_standin_sample_latency(&lognormal, &rng);
+    qsort(draws, N, sizeof(draws[0]), cmp_u64);
+    uint64_t median = draws[N / 2];
+    assert(median > 950 && median < 1050);
+    /* p95 of a lognormal is median * exp(1.645 sigma), about 2.27x */
+    uint64_t p95 = draws[N * 95 / 100];
+    assert(p95 > 2100 && p95 < 2450);
+
+    nats_standin_latency_t bimodal = { NATS_STANDIN_LATENCY_BIMODAL, 100, 0.0, 50000, 0.1 };
+    int slow = 0;
+    for (int i = 0; i < N; i++) {
+        uint64_t v = nats_standin_sample_latency(&bimodal, &rng);
+        assert(v == 100 || v == 50000);
+        if (v == 50000) slow++;
+    }
+    assert(slow > N / 10 - 400 && slow < N / 10 + 400);
+    printf("OK\n");
+}
+
+static void test_config(void) {
+    printf("Test: config defaults and environment overrides... ");
+    nats_standin_config_t config;
+    nats_standin_get_default_config(&config);
+    assert(config.port == 4222);
+    assert(config.responder == 1);
+    assert(strcmp(config.responder_subject, "beamline.router.>") == 0);
+
+    setenv("NATS_STANDIN_PORT", "5222", 1);
+    setenv("NATS_STANDIN_LATENCY", "bimodal", 1);
+    setenv("NATS_STANDIN_LATENCY_US", "250", 1);
+    setenv("NATS_STANDIN_SLOW_US", "40000", 1);
+    setenv("NATS_STANDIN_SLOW_RATIO", "0.05", 1);
+    setenv("NATS_STANDIN_ERROR_RATE", "0.01", 1);
+    setenv("NATS_STANDIN_RESPONSE_BYTES", "2048", 1);
+    assert(nats_standin_parse_config(&config) == 0);
+    assert(config.port == 5222);
+    assert(config.latency.kind == NATS_STANDIN_LATENCY_BIMODAL);
+    assert(config.latency.median_us == 250);
+    assert(config.latency.slow_us == 40000);
+    assert(config.latency.slow_ratio == 0.05);
+    assert(config.error_rate == 0.01);
+    assert(config.response_bytes == 2048);
+
+    setenv("NATS_STANDIN_ERROR_RATE", "2", 1);
+    assert(nats_standin_parse_config(&config) == -1);
+    setenv("NATS_STANDIN_ERROR_RATE", "0", 1);
+    setenv("NATS_STANDIN_LATENCY", "uniform", 1);
+    assert(nats_standin_parse_config(&config) == -1);
+    unsetenv("NATS_STANDIN_PORT");
+    unsetenv("NATS_STANDIN_LATENCY");
+    unsetenv("NATS_STANDIN_LATENCY_US");
+    unsetenv("NATS_STANDIN_SLOW_US");
+    unsetenv("NATS_STANDIN_SLOW_RATIO");
+    unsetenv("NATS_STANDIN_ERROR_RATE");
+    unsetenv("NATS_STANDIN_RESPONSE_BYTES");
+
+    nats_standin_get_default_config(&config);
+    config.error_rate = 1.5;
+    assert(nats_standin_create(&config) == NULL);
+    assert(nats_standin_create(NULL) == NULL);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("=== NATS Stand-in Tests ===\n\n");
+
+    test_handshake();
+    test_pub_sub();
+    test_headers();
+    test_unsub_and_queue_groups();
+    test_protocol_errors();
+    test_responder();
+    test_latency_distributions();
+    test_config();
+
+    printf("\nAll tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,147 @@
+/**
+ * test_pii_redactor.c - Sensitive key matching and JSON redaction tests
+ */
+
+#include "pii_redactor.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+static const char *const names[] = { "password", "api_key", "token", "access_token", "ssn", "x-api-key" };
+#define NUM_NAMES (sizeof(names) / sizeof(names[0]))
+
+static int matches(const pii_redactor_t *r, const char *key) {
+    return pii_redactor_matches(r, key, strlen(key));
+}
+
+/* Redact into a fresh buffer and compare with the expected text */
+static void expect(const pii_redactor_t *r, const char *json, const char *want) {
+    char out[1024];
+    size_t n = 0;
+    int rc = pii_redact(r, json, strlen(json), out, sizeof(out), &n);
+    if (!want) {
+        assert(rc == -1);
+        return;
+    }
+    assert(rc == 0);
+    assert(n == strlen(want) && strcmp(out, want) == 0);
+
+    /* In place gives the same answer */
+    char buf[1024];
+    size_t len = strlen(json);
+    assert(pii_redact_bound(r, len) <= sizeof(buf));
+    memcpy(buf, json, len);
+    assert(pii_redact_in_place(r, buf, len, pii_redact_bound(r, len), &n) == 0);
+    assert(n == strlen(want) && memcmp(buf, want, n) == 0);
+}
+
+static void test_matching(void) {
+    printf("Test: exact and contains matching... ");
+    pii_redactor_t *exact = pii_redactor_create(names, NUM_NAMES, PII_MATCH_EXACT, "\"***\"");
+    pii_redactor_t *contains = pii_redactor_create(names, NUM_NAMES, PII_MATCH_CONTAINS, "\"***\"");
+    assert(exact && contains);
+
+    assert(matches(exact, "password") && matches(exact, "PassWord") && matches(exact, "X-API-Key"));
+    assert(matches(exact, "token") && matches(exact, "access_token") && matches(exact, "ssn"));
+    assert(!matches(exact, "passwor") && !matches(exact, "passwords") && !matches(exact, "tokens"));
+    assert(!matches(exact, "refresh_token") && !matches(exact, "") && !matches(exact, "user"));
+
+    assert(matches(contains, "refresh_token") && matches(contains, "my_PASSWORD_hash"));
+    assert(matches(contains, "xssn") && matches(contains, "acctoken"));
+    assert(!matches(contains, "tok_en") && !matches(contains, "api-key") && !matches(contains, "s"));
+
+    assert(pii_redactor_create(names, 0, PII_MATCH_EXACT, "\"x\"") == NULL);
+    const char *empty[] = { "" };
+    assert(pii_redactor_create(empty, 1, PII_MATCH_EXACT, "\"x\"") == NULL);
+    pii_redactor_free(exact);
+    pii_redactor_free(contains);
+    printf("OK\n");
+}
+
+static void test_redaction(void) {
+    printf("Test: values of sensitive keys are masked... ");
+    pii_redactor_t *r = pii_redactor_create(names, NUM_NAMES, PII_MATCH_EXACT, "\"[REDACTED]\"");
+    assert(r != NULL);
+
+    expect(r, "{\"user\":\"john\",\"password\":\"hunter2\",\"n\":42}",
+              "{\"user\":\"john\",\"password\":\"[REDACTED]\",\"n\":42}");
+    /* Every value type, nested anywhere */
+    expect(r, "{\"a\":{\"token\":{\"x\":[1,\"}\"]},\"b\":[{\"ssn\":123},{\"ssn\":null}]},\"api_key\":[\"k\"]}",
+              "{\"a\":{\"token\":\"[REDACTED]\",\"b\":[{\"ssn\":\"[REDACTED]\"},{\"ssn\":\"[REDACTED]\"}]},"
+              "\"api_key\":\"[REDACTED]\"}");
+    /* Whitespace, escapes in keys and strings that only look like keys */
+    expect(r, " { \"pass\\u0077ord\" : \"a\\\"b\" , \"note\" : \"password\" , \"l\":[\"token\",\"ssn\"] } ",
+              " { \"pass\\u0077ord\" : \"[REDACTED]\" , \"note\" : \"password\" , \"l\":[\"token\",\"ssn\"] } ");
+    expect(r, "[{\"token\":true},\"token\",{\"TOKEN\":-1.5e3}]",
+              "[{\"token\":\"[REDACTED]\"},\"token\",{\"TOKEN\":\"[REDACTED]\"}]");
+    expect(r, "\"token\"", "\"token\"");
+    expect(r, "{}", "{}");
+
+    /* Broken documents are refused rather than half masked */
+    expect(r, "{\"password\":\"open", NULL);
+    expect(r, "{\"password\"}", NULL);
+    expect(r, "{\"a\":[1}", NULL);
+    expect(r, "{\"a\":1", NULL);
+
+    /* Output that does not fit */
+    char small[16];
+    const char *doc = "{\"ssn\":1}";
+    assert(pii_redact(r, doc, strlen(doc), small, sizeof(small), NULL) == -1);
+    char buf[32];
+    memcpy(buf, doc, strlen(doc));
+    assert(pii_redact_in_place(r, buf, strlen(doc), 12, NULL) == -1);
+
+    /* Too deep */
+    char deep[2 * PII_REDACT_MAX_DEPTH + 8];
+    memset(deep, '[', PII_REDACT_MAX_DEPTH + 1);
+    memset(deep + PII_REDACT_MAX_DEPTH + 1, ']', PII_REDACT_MAX_DEPTH + 1);
+    char out[sizeof(deep)];
+    assert(pii_redact(r, deep, 2 * PII_REDACT_MAX_DEPTH + 2, out, sizeof(out), NULL) == -1);
+    assert(pii_redact(r, deep + 1, 2 * PII_REDACT_MAX_DEPTH, out, sizeof(out), NULL) == 0);
+    pii_redactor_free(r);
+    printf("OK\n");
+}
+
+static void test_in_place_bound(void) {
+    printf("Test: in place redaction within the bound... ");
+    pii_redactor_t *r = pii_redactor_create(names, NUM_NAMES, PII_MATCH_EXACT, "\"[REDACTED]\"");
+
+    /* Worst case: every member is the shortest key with a one-byte value */
+    char doc[2048];
+    size_t len = 0;
+    doc[len++] = '{';
+    for (int i = 0; i < 100; i++) {
+        len += (size_t)snprintf(doc + len, sizeof(doc) - len, "%s\"ssn\":%d", i ? "," : "", i % 10);
+    }
+    doc[len++] = '}';
+    size_t bound = pii_redact_bound(r, len);
+    char *buf = malloc(bound);
+    memcpy(buf, doc, len);
+    size_t n = 0;
+    assert(pii_redact_in_place(r, buf, len, bound, &n) == 0);
+    assert(n <= bound);
+    assert(memcmp(buf, "{\"ssn\":\"[REDACTED]\",\"ssn\":", 26) == 0);
+    assert(memcmp(buf + n - 20, ",\"ssn\":\"[REDACTED]\"}", 20) == 0);
+
+    /* Long values shrink, so a later masked value finds room */
+    const char *shrink = "{\"token\":\"0123456789012345678901234567890123456789\",\"ssn\":1}";
+    len = strlen(shrink);
+    memcpy(buf, shrink, len);
+    assert(pii_redact_in_place(r, buf, len, len, &n) == 0);
+    assert(memcmp(buf, "{\"token\":\"[REDACTED]\",\"ssn\":\"[REDACTED]\"}", n) == 0);
+    free(buf);
+    pii_redactor_free(r);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("=== PII Redactor Tests ===\n\n");
+
+    test_matching();
+    test_redaction();
+    test_in_place_bound();
+
+    printf("\nAll tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,207 @@
+/**
+ * test_request_arena.c - Per-request arena tests
+ */
+
+#include "request_arena.h"
+#include <jansson.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+static void test_alignment(void) {
+    printf("Test: allocations are 16-byte aligned... ");
+
+    request_arena_t *a = request_arena_create(1024);
+    assert(a != NULL);
+    for (size_t size = 1; size < 40; size += 3) {
+        void *p = request_arena_alloc(a, size);
+        assert(p != NULL);
+        assert(((uintptr_t)p % 16U) == 0);
+        memset(p, 0xab, size);
+    }
+    unsigned char *z = request_arena_calloc(a, 10, 7);
+    assert(z != NULL);
+    for (size_t i = 0; i < 70; i++) {
+        assert(z[i] == 0);
+    }
+    assert(request_arena_calloc(a, SIZE_MAX / 2, 4) == NULL);
+    request_arena_destroy(a);
+    printf("OK\n");
+}
+
+static void run_cycle(request_arena_t *a) {
+    for (int i = 0; i < 100; i++) {
+        assert(request_arena_alloc(a, 300) != NULL);
+    }
+    request_arena_reset(a);
+}
+
+static void test_reset_reuses_chunks(void) {
+    printf("Test: identical cycles stop calling malloc... ");
+
+    request_arena_t *a = request_arena_create(4096);
+    request_arena_stats_t st;
+
+    run_cycle(a);
+    request_arena_get_stats(a, &st);
+    uint64_t warmed = st.chunk_allocs;
+    assert(warmed > 1);
+
+    for (int i = 0; i < 50; i++) {
+        run_cycle(a);
+    }
+    request_arena_get_stats(a, &st);
+    assert(st.chunk_allocs == warmed);
+    assert(st.resets == 51);
+    assert(st.allocations == 51U * 100U);
+    assert(st.high_water >= 100U * 300U);
+    request_arena_destroy(a);
+    printf("OK\n");
+}
+
+static void test_oversize_chunk(void) {
+    printf("Test: oversized allocations are freed on reset... ");
+
+    request_arena_t *a = request_arena_create(1024);
+    request_arena_stats_t st;
+
+    char *big = request_arena_alloc(a, 10000);
+    assert(big != NULL);
+    memset(big, 1, 10000);
+    assert(request_arena_owns(a, big + 9999));
+    /* Small allocations keep going after the big one */
+    assert(request_arena_alloc(a, 32) != NULL);
+    request_arena_reset(a);
+    assert(!request_arena_owns(a, big));
+
+    /* Each cycle needs a fresh oversized chunk, but nothing else */
+    request_arena_get_stats(a, &st);
+    uint64_t before = st.chunk_allocs;
+    assert(request_arena_alloc(a, 10000) != NULL);
+    request_arena_reset(a);
+    request_arena_get_stats(a, &st);
+    assert(st.chunk_allocs == before + 1U);
+    request_arena_destroy(a);
+    printf("OK\n");
+}
+
+static void test_owns_and_release(void) {
+    printf("Test: release rewinds only the last allocation... ");
+
+    request_arena_t *a = request_arena_create(1024);
+    char *p1 = request_arena_alloc(a, 64);
+    char *p2 = request_arena_alloc(a, 64);
+    assert(request_arena_owns(a, p1));
+    assert(request_arena_owns(a, p2));
+
+    int on_stack = 0;
+    assert(!request_arena_owns(a, &on_stack));
+    assert(!request_arena_owns(a, NULL));
+
+    request_arena_release(a, p1);                /* not last: kept */
+    char *p3 = request_arena_alloc(a, 64);
+    assert(p3 != p1 && p3 != p2);
+
+    request_arena_release(a, p3);                /* last: rewound */
+    assert(request_arena_alloc(a, 64) == p3);
+    request_arena_destroy(a);
+    printf("OK\n");
+}
+
+static void test_scope(void) {
+    printf("Test: scratch memory follows the thread scope... ");
+
+    assert(request_arena_current() == NULL);
+
+    /* Outside a scope: plain malloc */
+    char *heap = request_arena_scratch_alloc(32);
+    assert(heap != NULL);
+    request_arena_begin();
+    request_arena_t *a = request_arena_current();
+    assert(a != NULL);
+    assert(!request_arena_owns(a, heap));
+    request_arena_scratch_free(heap);           /* still free()d correctly */
+
+    char *s = request_arena_scratch_calloc(4, 8);
+    assert(s != NULL && s[0] == 0);
+    assert(request_arena_owns(a, s));
+    request_arena_scratch_free(s);
+    request_arena_begin();                       /* nested begin is ignored */
+    request_arena_end();
+    assert(request_arena_current() == NULL);
+    request_arena_end();                         /* unbalanced end is harmless */
+
+    request_arena_stats_t st;
+    request_arena_get_stats(a, &st);
+    assert(st.resets == 1);
+    printf("OK\n");
+}
+
+static void test_detach(void) {
+    printf("Test: detached values survive the scope... ");
+
+    request_arena_begin();
+    request_arena_t *a = request_arena_current();
+    char *s = request_arena_scratch_alloc(16);
+    assert(s != NULL);
+    strcpy(s, "kept");
+    char *kept = request_arena_scratch_detach(s, 16);
+    assert(kept != NULL && kept != s);
+    assert(!request_arena_owns(a, kept));
+    assert(request_arena_scratch_detach(kept, 16) == kept);   /* already on the heap */
+    assert(request_arena_scratch_detach(NULL, 16) == NULL);
+    request_arena_end();
+
+    assert(strcmp(kept, "kept") == 0);
+    request_arena_scratch_free(kept);
+    printf("OK\n");
+}
+
+static void test_json_hooks(void) {
+    printf("Test: jansson allocates from the scope... ");
+
+    request_arena_install_json();
+
+    /* Created outside a scope, released inside one */
+    json_t *global = json_object();
+    assert(global != NULL);
+    json_object_set_new(global, "k", json_string("v"));
+
+    request_arena_begin();
+    request_arena_t *a = request_arena_current();
+    request_arena_stats_t st;
+    request_arena_get_stats(a, &st);
+    uint64_t before = st.allocations;
+
+    json_error_t err;
+    json_t *root = json_loads("{\"tenant_id\":\"t1\",\"n\":[1,2,3]}", 0, &err);
+    assert(root != NULL);
+    char *dumped = json_dumps(root, JSON_COMPACT);
+    assert(dumped != NULL);
+    assert(request_arena_owns(a, dumped));
+    assert(strstr(dumped, "\"tenant_id\":\"t1\"") != NULL);
+    request_arena_scratch_free(dumped);
+    json_decref(root);
+    json_decref(global);
+
+    request_arena_get_stats(a, &st);
+    assert(st.allocations > before);
+    request_arena_end();
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("=== Request Arena Tests ===\n");
+
+    test_alignment();
+    test_reset_reuses_chunks();
+    test_oversize_chunk();
+    test_owns_and_release();
+    test_scope();
+    test_detach();
+    test_json_hooks();
+
+    printf("\nAll tests passed!\n");
+    return 0;
+}
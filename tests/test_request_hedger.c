@@ -0,0 +1,466 @@
+/**
+ * test_request_hedger.c - Hedged request tests
+ */
+
+#define _GNU_SOURCE
+#include "request_hedger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_SLOTS 64
+#define THREADS 4
+#define PER_THREAD 1500
+
+/* Fake transport: attempts are answered inline, refused, or held */
+enum { MODE_INLINE, MODE_FAIL, MODE_HOLD, MODE_DELAYED };
+
+typedef struct {
+    int used;
+    uint64_t handle;
+    uint64_t due_us;                     /* MODE_DELAYED */
+    request_hedger_reply_fn reply;
+    void *closure;
+} slot_t;
+
+static pthread_mutex_t transport_lock = PTHREAD_MUTEX_INITIALIZER;
+static slot_t slots[MAX_SLOTS];
+static int mode = MODE_INLINE;
+static uint64_t next_handle = 1;
+static atomic_int sends = 0;
+static atomic_int cancels = 0;
+static uint64_t rng = 88172645463325252ULL;
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+static int fake_send(const char *subject, const char *request, request_hedger_reply_fn reply,
+                     void *closure, uint64_t *handle, void *arg) {
+    (void)subject;
+    (void)arg;
+    assert(strcmp(request, "{\"q\":1}") == 0);
+    pthread_mutex_lock(&transport_lock);
+    int m = mode;
+    if (m == MODE_FAIL) {
+        pthread_mutex_unlock(&transport_lock);
+        return -1;
+    }
+    *handle = next_handle++;
+    atomic_fetch_add(&sends, 1);
+    if (m == MODE_INLINE) {
+        pthread_mutex_unlock(&transport_lock);
+        reply(0, "inline", closure);
+        return 0;
+    }
+    int i = 0;
+    while (slots[i].used) {
+        i++;
+        assert(i < MAX_SLOTS);
+    }
+    slots[i].used = 1;
+    slots[i].handle = *handle;
+    slots[i].reply = reply;
+    slots[i].closure = closure;
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    slots[i].due_us = now_us() + rng % 3000U;
+    pthread_mutex_unlock(&transport_lock);
+    return 0;
+}
+
+static int fake_cancel(uint64_t handle, void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&transport_lock);
+    for (int i = 0; i < MAX_SLOTS; i++) {
+        if (slots[i].used && slots[i].handle == handle) {
+            slots[i].used = 0;
+            pthread_mutex_unlock(&transport_lock);
+            atomic_fetch_add(&cancels, 1);
+            return 0;
+        }
+    }
+    pthread_mutex_unlock(&transport_lock);
+    return -1;
+}
+
+/* Answer the held attempt with this handle; 0 if it was still held */
+static int answer(uint64_t handle, int status, const char *text) {
+    pthread_mutex_lock(&transport_lock);
+    for (int i = 0; i < MAX_SLOTS; i++) {
+        if (slots[i].used && slots[i].handle == handle) {
+            slot_t s = slots[i];
+            slots[i].used = 0;
+            pthread_mutex_unlock(&transport_lock);
+            s.reply(status, status == 0 ? text : NULL, s.closure);
+            return 0;
+        }
+    }
+    pthread_mutex_unlock(&transport_lock);
+    return -1;
+}
+
+static int held(void) {
+    int n = 0;
+    pthread_mutex_lock(&transport_lock);
+    for (int i = 0; i < MAX_SLOTS; i++) n += slots[i].used;
+    pthread_mutex_unlock(&transport_lock);
+    return n;
+}
+
+static void wait_sends(int n) {
+    for (int i = 0; i < 2000 && atomic_load(&sends) < n; i++) usleep(1000);
+    assert(atomic_load(&sends) == n);
+}
+
+/* What the caller was told */
+typedef struct {
+    atomic_int calls;
+    int status;
+    char text[32];
+} result_t;
+
+static void on_result(int status, const char *reply, void *closure) {
+    result_t *r = (result_t *)closure;
+    r->status = status;
+    snprintf(r->text, sizeof(r->text), "%s", status == 0 ? reply : "");
+    atomic_fetch_add(&r->calls, 1);
+}
+
+static void reset(int m) {
+    pthread_mutex_lock(&transport_lock);
+    memset(slots, 0, sizeof(slots));
+    mode = m;
+    next_handle = 1;
+    pthread_mutex_unlock(&transport_lock);
+    atomic_store(&sends, 0);
+    atomic_store(&cancels, 0);
+}
+
+static void set_mode(int m) {
+    pthread_mutex_lock(&transport_lock);
+    mode = m;
+    pthread_mutex_unlock(&transport_lock);
+}
+
+/* A hedger whose "router.get" threshold is already at the 1ms floor */
+static request_hedger_t *make_warm(int budget_percent, int burst) {
+    request_hedger_config_t config;
+    request_hedger_get_default_config(&config);
+    config.budget_percent = budget_percent;
+    config.burst = burst;
+    config.min_samples = 10;
+    config.min_delay_us = 1000;
+    request_hedger_t *h = request_hedger_create(&config, fake_send, fake_cancel, NULL);
+    assert(h != NULL);
+
+    reset(MODE_INLINE);
+    result_t r;
+    memset(&r, 0, sizeof(r));
+    for (int i = 0; i < 20; i++) {
+        assert(request_hedger_submit(h, "router.get", "{\"q\":1}", on_result, &r) == 0);
+    }
+    assert(atomic_load(&r.calls) == 20);
+    for (int i = 0; i < 300 && request_hedger_threshold_us(h, "router.get") == 0; i++) usleep(10000);
+    assert(request_hedger_threshold_us(h, "router.get") == 1000);
+    reset(MODE_HOLD);
+    return h;
+}
+
+static void test_no_hedge_until_warm(void) {
+    printf("Test: a subject is not hedged before it has enough samples... ");
+    request_hedger_config_t config;
+    request_hedger_get_default_config(&config);
+    config.min_samples = 1000;
+    request_hedger_t *h = request_hedger_create(&config, fake_send, fake_cancel, NULL);
+    assert(h != NULL);
+    reset(MODE_INLINE);
+    result_t r;
+    memset(&r, 0, sizeof(r));
+    for (int i = 0; i < 20; i++) {
+        assert(request_hedger_submit(h, "router.get", "{\"q\":1}", on_result, &r) == 0);
+    }
+    assert(atomic_load(&r.calls) == 20);
+    assert(strcmp(r.text, "inline") == 0);
+
+    reset(MODE_HOLD);
+    result_t slow;
+    memset(&slow, 0, sizeof(slow));
+    assert(request_hedger_submit(h, "router.get", "{\"q\":1}", on_result, &slow) == 0);
+    usleep(50000);
+    assert(atomic_load(&sends) == 1);
+    assert(request_hedger_threshold_us(h, "router.get") == 0);
+    assert(answer(1, 0, "late") == 0);
+    assert(atomic_load(&slow.calls) == 1);
+
+    request_hedger_stats_t st;
+    request_hedger_get_stats(h, &st);
+    assert(st.requests == 21);
+    assert(st.hedges_sent == 0);
+    assert(st.in_flight == 0);
+    request_hedger_destroy(h);
+    printf("OK\n");
+}
+
+static void test_hedge_wins(void) {
+    printf("Test: a late request is hedged and the hedge's reply wins... ");
+    request_hedger_t *h = make_warm(50, 10);
+    result_t r;
+    memset(&r, 0, sizeof(r));
+    assert(request_hedger_submit(h, "router.get", "{\"q\":1}", on_result, &r) == 0);
+    wait_sends(2);
+    assert(atomic_load(&r.calls) == 0);
+
+    uint64_t primary = 1, hedge = 2;
+    assert(answer(hedge, 0, "from-hedge") == 0);
+    assert(atomic_load(&r.calls) == 1);
+    assert(strcmp(r.text, "from-hedge") == 0);
+    /* The slow first attempt was cancelled */
+    assert(atomic_load(&cancels) == 1);
+    assert(answer(primary, 0, "too-late") == -1);
+    assert(held() == 0);
+
+    request_hedger_stats_t st;
+    request_hedger_get_stats(h, &st);
+    assert(st.hedges_sent == 1);
+    assert(st.hedges_won == 1);
+    assert(st.cancelled == 1);
+    assert(st.in_flight == 0);
+    request_hedger_destroy(h);
+    printf("OK\n");
+}
+
+static void test_primary_wins(void) {
+    printf("Test: the first attempt can still win, and the hedge is cancelled... ");
+    request_hedger_t *h = make_warm(50, 10);
+    result_t r;
+    memset(&r, 0, sizeof(r));
+    assert(request_hedger_submit(h, "router.get", "{\"q\":1}", on_result, &r) == 0);
+    wait_sends(2);
+    assert(answer(1, 0, "from-primary") == 0);
+    assert(atomic_load(&r.calls) == 1);
+    assert(strcmp(r.text, "from-primary") == 0);
+    assert(held() == 0);
+
+    request_hedger_stats_t st;
+    request_hedger_get_stats(h, &st);
+    assert(st.hedges_sent == 1);
+    assert(st.hedges_won == 0);
+    assert(st.cancelled == 1);
+    request_hedger_destroy(h);
+    printf("OK\n");
+}
+
+static void test_failure_defers(void) {
+    printf("Test: a failed attempt waits for the other one... ");
+    request_hedger_t *h = make_warm(50, 10);
+    result_t r;
+    memset(&r, 0, sizeof(r));
+    assert(request_hedger_submit(h, "router.get", "{\"q\":1}", on_result, &r) == 0);
+    wait_sends(2);
+    assert(answer(1, -1, NULL) == 0);
+    assert(atomic_load(&r.calls) == 0);
+    assert(answer(2, 0, "ok") == 0);
+    assert(atomic_load(&r.calls) == 1);
+    assert(r.status == 0);
+
+    /* Both failing reports the failure once */
+    memset(&r, 0, sizeof(r));
+    assert(request_hedger_submit(h, "router.get", "{\"q\":1}", on_result, &r) == 0);
+    wait_sends(4);
+    assert(answer(4, -1, NULL) == 0);
+    assert(atomic_load(&r.calls) == 0);
+    assert(answer(3, -1, NULL) == 0);
+    assert(atomic_load(&r.calls) == 1);
+    assert(r.status != 0);
+    request_hedger_destroy(h);
+    printf("OK\n");
+}
+
+static void test_budget(void) {
+    printf("Test: the hedge budget caps extra attempts... ");
+    request_hedger_t *h = make_warm(5, 1);
+    result_t r[4];
+    memset(r, 0, sizeof(r));
+    for (int i = 0; i < 4; i++) {
+        assert(request_hedger_submit(h, "router.get", "{\"q\":1}", on_result, &r[i]) == 0);
+    }
+    wait_sends(5);                       /* Four first attempts, one hedge */
+    usleep(20000);
+    assert(atomic_load(&sends) == 5);
+
+    request_hedger_stats_t st;
+    request_hedger_get_stats(h, &st);
+    assert(st.hedges_sent == 1);
+    assert(st.budget_exhausted == 3);
+    for (uint64_t handle = 1; handle <= 5; handle++) (void)answer(handle, 0, "x");
+    for (int i = 0; i < 4; i++) assert(atomic_load(&r[i].calls) == 1);
+
+    /* No budget at all: never hedged */
+    request_hedger_destroy(h);
+    h = make_warm(0, 1);
+    memset(r, 0, sizeof(r));
+    assert(request_hedger_submit(h, "router.get", "{\"q\":1}", on_result, &r[0]) == 0);
+    usleep(20000);
+    assert(atomic_load(&sends) == 1);
+    assert(answer(1, 0, "x") == 0);
+    request_hedger_destroy(h);
+    printf("OK\n");
+}
+
+static void test_send_failure(void) {
+    printf("Test: a request that cannot be sent is refused without a reply... ");
+    request_hedger_t *h = make_warm(50, 10);
+    set_mode(MODE_FAIL);
+    result_t r;
+    memset(&r, 0, sizeof(r));
+    assert(request_hedger_submit(h, "router.get", "{\"q\":1}", on_result, &r) == -1);
+    usleep(20000);
+    assert(atomic_load(&r.calls) == 0);
+    request_hedger_stats_t st;
+    request_hedger_get_stats(h, &st);
+    assert(st.in_flight == 0);
+    assert(request_hedger_submit(h, NULL, "{}", on_result, &r) == -1);
+    request_hedger_destroy(h);
+    printf("OK\n");
+}
+
+/* Answers held attempts once they are due */
+static atomic_int responder_running = 1;
+
+static void *responder_main(void *arg) {
+    (void)arg;
+    while (atomic_load(&responder_running)) {
+        uint64_t now = now_us();
+        uint64_t due = 0;
+        pthread_mutex_lock(&transport_lock);
+        for (int i = 0; i < MAX_SLOTS; i++) {
+            if (slots[i].used && slots[i].due_us <= now) {
+                due = slots[i].handle;
+                break;
+            }
+        }
+        pthread_mutex_unlock(&transport_lock);
+        if (due) {
+            (void)answer(due, 0, "stress");
+        } else {
+            usleep(100);
+        }
+    }
+    return NULL;
+}
+
+typedef struct {
+    request_hedger_t *h;
+    int failures;
+} worker_t;
+
+static void *worker_main(void *arg) {
+    worker_t *w = (worker_t *)arg;
+    for (int i = 0; i < PER_THREAD; i++) {
+        result_t r;
+        memset(&r, 0, sizeof(r));
+        assert(request_hedger_submit(w->h, "router.get", "{\"q\":1}", on_result, &r) == 0);
+        while (atomic_load(&r.calls) == 0) usleep(50);
+        /* A loser must never reach the caller */
+        usleep(10);
+        if (atomic_load(&r.calls) != 1 || r.status != 0) w->failures++;
+    }
+    return NULL;
+}
+
+static void test_concurrent(void) {
+    printf("Test: concurrent requests are each answered exactly once... ");
+    request_hedger_config_t config;
+    request_hedger_get_default_config(&config);
+    config.budget_percent = 50;
+    config.min_samples = 20;
+    config.min_delay_us = 0;
+    request_hedger_t *h = request_hedger_create(&config, fake_send, fake_cancel, NULL);
+    assert(h != NULL);
+    reset(MODE_DELAYED);
+
+    pthread_t responder;
+    atomic_store(&responder_running, 1);
+    assert(pthread_create(&responder, NULL, responder_main, NULL) == 0);
+    pthread_t threads[THREADS];
+    worker_t workers[THREADS];
+    for (int i = 0; i < THREADS; i++) {
+        workers[i].h = h;
+        workers[i].failures = 0;
+        assert(pthread_create(&threads[i], NULL, worker_main, &workers[i]) == 0);
+    }
+    for (int i = 0; i < THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        assert(workers[i].failures == 0);
+    }
+
+    request_hedger_stats_t st;
+    request_hedger_get_stats(h, &st);
+    assert(st.requests == THREADS * PER_THREAD);
+    assert(st.in_flight == 0);
+    assert(st.hedges_sent > 0);
+    assert(st.hedges_sent <= st.requests / 2 + 10);
+    request_hedger_destroy(h);     /* Waits for losers still held */
+    atomic_store(&responder_running, 0);
+    pthread_join(responder, NULL);
+    printf("OK\n");
+}
+
+static void test_config(void) {
+    printf("Test: config defaults and environment overrides... ");
+    request_hedger_config_t config;
+    request_hedger_get_default_config(&config);
+    assert(config.budget_percent == 5);
+    assert(config.percentile == 95.0);
+
+    setenv("GATEWAY_HEDGE_BUDGET_PERCENT", "10", 1);
+    setenv("GATEWAY_HEDGE_BURST", "4", 1);
+    setenv("GATEWAY_HEDGE_PERCENTILE", "99", 1);
+    setenv("GATEWAY_HEDGE_MIN_SAMPLES", "200", 1);
+    setenv("GATEWAY_HEDGE_MIN_DELAY_MS", "3", 1);
+    assert(request_hedger_parse_config(&config) == 0);
+    assert(config.budget_percent == 10);
+    assert(config.burst == 4);
+    assert(config.percentile == 99.0);
+    assert(config.min_samples == 200);
+    assert(config.min_delay_us == 3000);
+
+    setenv("GATEWAY_HEDGE_PERCENTILE", "120", 1);
+    assert(request_hedger_parse_config(&config) == 0);
+    assert(config.percentile == 99.0);
+    unsetenv("GATEWAY_HEDGE_BUDGET_PERCENT");
+    unsetenv("GATEWAY_HEDGE_BURST");
+    unsetenv("GATEWAY_HEDGE_PERCENTILE");
+    unsetenv("GATEWAY_HEDGE_MIN_SAMPLES");
+    unsetenv("GATEWAY_HEDGE_MIN_DELAY_MS");
+
+    assert(request_hedger_create(&config, NULL, fake_cancel, NULL) == NULL);
+    config.percentile = 10.0;
+    assert(request_hedger_create(&config, fake_send, fake_cancel, NULL) == NULL);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("=== Request Hedger Tests ===\n\n");
+
+    test_no_hedge_until_warm();
+    test_hedge_wins();
+    test_primary_wins();
+    test_failure_defers();
+    test_budget();
+    test_send_failure();
+    test_concurrent();
+    test_config();
+
+    printf("\nAll tests passed!\n");
+    return 0;
+}
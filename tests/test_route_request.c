@@ -0,0 +1,262 @@
+/**
+ * test_route_request.c - Decide request to RouteRequest transcoding tests
+ */
+
+#include "route_request.h"
+#include <jansson.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define VALID_BODY \
+    "{\"version\":\"1\",\"tenant_id\":\"t1\",\"request_id\":\"r1\"," \
+    "\"task\":{\"type\":\"text.generate\",\"payload\":{\"prompt\":\"hi\"}}"
+
+static int build(const char *body, const route_request_overrides_t *ov,
+                 route_request_ids_t *ids, char **out) {
+    return route_request_build(body, strlen(body), ov, ids, out, NULL);
+}
+
+static int build_dom(const char *body, const route_request_overrides_t *ov,
+                     route_request_ids_t *ids, char **out) {
+    return route_request_build_dom(body, strlen(body), ov, ids, out, NULL);
+}
+
+/* Compact re-dump, so byte-for-byte copies compare equal to re-encodings */
+static char *canonical(const char *json) {
+    json_error_t err;
+    json_t *root = json_loads(json, 0, &err);
+    assert(root != NULL);
+    char *dumped = json_dumps(root, JSON_COMPACT);
+    json_decref(root);
+    return dumped;
+}
+
+static void release(char *json) {
+    json_free_t jfree;
+    json_malloc_t jmalloc;
+    json_get_alloc_funcs(&jmalloc, &jfree);
+    jfree(json);
+}
+
+static void assert_same_as_dom(const char *body, const route_request_overrides_t *ov) {
+    route_request_ids_t a, b;
+    char *fast = NULL;
+    char *dom = NULL;
+    int rc = build(body, ov, &a, &fast);
+    assert(rc == build_dom(body, ov, &b, &dom));
+    if (rc != ROUTE_REQUEST_OK) {
+        assert(fast == NULL && dom == NULL);
+        return;
+    }
+    char *x = canonical(fast);
+    char *y = canonical(dom);
+    assert(strcmp(x, y) == 0);
+    assert(strcmp(a.request_id, b.request_id) == 0);
+    assert(a.has_run_id == b.has_run_id);
+    assert(!a.has_run_id || strcmp(a.run_id, b.run_id) == 0);
+    assert(strcmp(a.task_type, b.task_type) == 0);
+    assert(a.has_task_block == b.has_task_block);
+    assert(strcmp(a.task_version, b.task_version) == 0);
+    assert(a.task_payload != NULL && b.task_payload == NULL);
+    release(x);
+    release(y);
+    release(fast);
+    release(dom);
+}
+
+static void test_layout(void) {
+    printf("Test: fields are regrouped into the RouteRequest layout... ");
+
+    route_request_ids_t ids;
+    char *out = NULL;
+    size_t len = 0;
+    const char *body =
+        "{\"version\":\"1\",\"tenant_id\":\"t1\",\"request_id\":\"r1\",\"trace_id\":\"tr\","
+        "\"run_id\":\"run-7\",\"message_id\":\"m1\",\"message_type\":\"chat\","
+        "\"payload\":{\"text\":\"a\\u00e9\\/b\",\"n\":1.50},\"metadata\":{\"k\":[true,null]},"
+        "\"policy_id\":\"p\",\"context\":{\"c\":1},\"unused\":[1,2,{\"x\":\"y\"}],"
+        "\"task\":{\"type\":\"text.generate\",\"payload\":{}}}";
+    assert(route_request_build(body, strlen(body), NULL, &ids, &out, &len) == ROUTE_REQUEST_OK);
+    assert(strcmp(out,
+                  "{\"version\":\"1\",\"tenant_id\":\"t1\",\"request_id\":\"r1\",\"trace_id\":\"tr\","
+                  "\"run_id\":\"run-7\",\"message\":{\"message_id\":\"m1\",\"message_type\":\"chat\","
+                  "\"payload\":{\"text\":\"a\\u00e9\\/b\",\"n\":1.50},\"metadata\":{\"k\":[true,null]}},"
+                  "\"policy_id\":\"p\",\"context\":{\"c\":1}}") == 0);
+    assert(len == strlen(out));
+    assert(strcmp(ids.request_id, "r1") == 0);
+    assert(ids.has_run_id && strcmp(ids.run_id, "run-7") == 0);
+    release(out);
+
+    /* Optional fields of the wrong type are dropped, message stays */
+    assert(build(VALID_BODY ",\"trace_id\":7,\"payload\":\"x\",\"context\":null}", NULL, &ids,
+                 &out) == ROUTE_REQUEST_OK);
+    assert(strcmp(out, "{\"version\":\"1\",\"tenant_id\":\"t1\",\"request_id\":\"r1\","
+                       "\"message\":{}}") == 0);
+    assert(!ids.has_run_id && ids.run_id[0] == '\0');
+    release(out);
+    printf("OK\n");
+}
+
+static void test_overrides(void) {
+    printf("Test: context tenant_id and trace_id replace the body's... ");
+
+    route_request_overrides_t ov = { "ctx-tenant", "ctx-trace" };
+    char *out = NULL;
+    assert(build(VALID_BODY ",\"trace_id\":\"body\"}", &ov, NULL, &out) == ROUTE_REQUEST_OK);
+    assert(strcmp(out, "{\"version\":\"1\",\"tenant_id\":\"ctx-tenant\",\"request_id\":\"r1\","
+                       "\"trace_id\":\"ctx-trace\",\"message\":{}}") == 0);
+    release(out);
+
+    /* Empty overrides keep the body's values */
+    route_request_overrides_t empty = { "", "" };
+    assert(build(VALID_BODY ",\"trace_id\":\"body\"}", &empty, NULL, &out) == ROUTE_REQUEST_OK);
+    assert(strstr(out, "\"tenant_id\":\"t1\"") && strstr(out, "\"trace_id\":\"body\""));
+    release(out);
+
+    /* Values that need escaping go through jansson and still come out right */
+    route_request_overrides_t quoted = { "a\"b", "tr\\x\xc3\xa9" };
+    assert(build(VALID_BODY "}", &quoted, NULL, &out) == ROUTE_REQUEST_OK);
+    json_error_t err;
+    json_t *root = json_loads(out, 0, &err);
+    assert(root != NULL);
+    assert(strcmp(json_string_value(json_object_get(root, "tenant_id")), "a\"b") == 0);
+    assert(strcmp(json_string_value(json_object_get(root, "trace_id")), "tr\\x\xc3\xa9") == 0);
+    json_decref(root);
+    release(out);
+    printf("OK\n");
+}
+
+static void test_invalid(void) {
+    printf("Test: bodies that are not decide requests are rejected... ");
+
+    const char *bad[] = {
+        "",
+        "[]",
+        "{\"version\":\"1\"",
+        VALID_BODY,
+        VALID_BODY "} x",
+        VALID_BODY ",}",
+        "{\"version\":\"2\",\"tenant_id\":\"t1\",\"request_id\":\"r1\","
+            "\"task\":{\"type\":\"x\",\"payload\":{}}}",
+        "{\"version\":1,\"tenant_id\":\"t1\",\"request_id\":\"r1\","
+            "\"task\":{\"type\":\"x\",\"payload\":{}}}",
+        "{\"version\":\"1\",\"tenant_id\":7,\"request_id\":\"r1\","
+            "\"task\":{\"type\":\"x\",\"payload\":{}}}",
+        "{\"version\":\"1\",\"tenant_id\":\"t1\",\"task\":{\"type\":\"x\",\"payload\":{}}}",
+        "{\"version\":\"1\",\"tenant_id\":\"t1\",\"request_id\":\"r1\"}",
+        "{\"version\":\"1\",\"tenant_id\":\"t1\",\"request_id\":\"r1\","
+            "\"task\":{\"type\":\"x\",\"payload\":[]}}",
+        "{\"version\":\"1\",\"tenant_id\":\"t1\",\"request_id\":\"r1\","
+            "\"task\":{\"payload\":{}}}",
+        /* A later non-object task replaces a good one */
+        VALID_BODY ",\"task\":null}",
+        /* Valid fields, invalid JSON elsewhere */
+        VALID_BODY ",\"extra\":99999999999999999999}",
+        VALID_BODY ",\"extra\":\"\\u0000\"}",
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        char *out = (char *)1;
+        assert(build(bad[i], NULL, NULL, &out) == ROUTE_REQUEST_INVALID);
+        assert(out == NULL);
+        assert_same_as_dom(bad[i], NULL);
+    }
+
+    char *out = NULL;
+    assert(route_request_build(NULL, 0, NULL, NULL, &out, NULL) == ROUTE_REQUEST_INVALID);
+    assert(route_request_build(VALID_BODY "}", 10, NULL, NULL, &out, NULL) == ROUTE_REQUEST_INVALID);
+    printf("OK\n");
+}
+
+static void test_matches_dom(void) {
+    printf("Test: streaming and jansson paths agree on a corpus... ");
+
+    route_request_overrides_t ov = { "ctx-tenant", "ctx-trace" };
+    const char *corpus[] = {
+        VALID_BODY "}",
+        " \n" VALID_BODY " , \"trace_id\" : \"t\" } \t",
+        /* Duplicates: the last occurrence wins */
+        VALID_BODY ",\"request_id\":\"r2\",\"run_id\":\"a\",\"run_id\":\"b\"}",
+        VALID_BODY ",\"run_id\":\"a\",\"run_id\":null}",
+        VALID_BODY ",\"policy_id\":\"p1\",\"policy_id\":3}",
+        VALID_BODY ",\"task\":{\"type\":\"x\",\"payload\":{\"deep\":[[[{}]]]}}}",
+        /* Escapes in matched values and keys */
+        "{\"version\":\"\\u0031\",\"tenant_\\u0069d\":\"t\\n1\",\"request_id\":\"\\ud83d\\ude00\","
+            "\"task\":{\"type\":\"x\",\"payload\":{}},\"message_id\":\"\\\"q\\\"\"}",
+        VALID_BODY ",\"payload\":{\"n\":-0.0e+0,\"big\":9223372036854775807,\"r\":1.8e307}}",
+        VALID_BODY ",\"metadata\":{},\"context\":{\"a\":{\"b\":{}}},\"message_type\":\"m\"}",
+        VALID_BODY ",\"task\":{\"type\":\"x\",\"version\":\"1.0\",\"payload\":{},\"version\":2}}",
+        VALID_BODY ",\"task\":{\"version\":\"\\u0031\",\"type\":\"x\",\"payload\":{}}}",
+    };
+    for (size_t i = 0; i < sizeof(corpus) / sizeof(corpus[0]); i++) {
+        char *out = NULL;
+        assert(build(corpus[i], NULL, NULL, &out) == ROUTE_REQUEST_OK);
+        release(out);
+        assert_same_as_dom(corpus[i], NULL);
+        assert_same_as_dom(corpus[i], &ov);
+    }
+
+    /* Long ids are truncated the same way */
+    char body[512];
+    snprintf(body, sizeof(body),
+             "{\"version\":\"1\",\"tenant_id\":\"t\",\"request_id\":\"%0100d\","
+             "\"task\":{\"type\":\"x\",\"payload\":{}}}", 7);
+    route_request_ids_t ids;
+    char *out = NULL;
+    assert(build(body, NULL, &ids, &out) == ROUTE_REQUEST_OK);
+    assert(strlen(ids.request_id) == ROUTE_REQUEST_ID_MAX - 1U);
+    release(out);
+    assert_same_as_dom(body, NULL);
+    printf("OK\n");
+}
+
+static void test_task_block(void) {
+    printf("Test: task type, version and payload are located... ");
+
+    route_request_ids_t ids;
+    char *out = NULL;
+    const char *body =
+        "{\"version\":\"1\",\"tenant_id\":\"t1\",\"request_id\":\"r1\","
+        "\"task\":{\"type\":\"llm\",\"payload\":[1],\"version\":\"2.0\",\"payload\" : {\"q\": [1, 2]} }}";
+    assert(build(body, NULL, &ids, &out) == ROUTE_REQUEST_OK);
+    assert(ids.has_task_block);
+    assert(strcmp(ids.task_type, "llm") == 0 && strcmp(ids.task_version, "2.0") == 0);
+    assert(ids.task_payload_len == strlen("{\"q\": [1, 2]}"));
+    assert(memcmp(ids.task_payload, "{\"q\": [1, 2]}", ids.task_payload_len) == 0);
+    release(out);
+
+    /* Escaped overrides go through jansson but keep the span */
+    route_request_overrides_t quoted = { "a\"b", NULL };
+    assert(build(body, &quoted, &ids, &out) == ROUTE_REQUEST_OK);
+    assert(ids.task_payload != NULL && ids.has_task_block);
+    release(out);
+
+    /* No version, or a name too long to be a block key: nothing to look up */
+    assert(build(VALID_BODY "}", NULL, &ids, &out) == ROUTE_REQUEST_OK);
+    assert(!ids.has_task_block && ids.task_version[0] == '\0');
+    assert(strcmp(ids.task_type, "text.generate") == 0 && ids.task_payload != NULL);
+    release(out);
+    char longer[512];
+    snprintf(longer, sizeof(longer),
+             "{\"version\":\"1\",\"tenant_id\":\"t\",\"request_id\":\"r\","
+             "\"task\":{\"type\":\"%0100d\",\"version\":\"1\",\"payload\":{}}}", 7);
+    assert(build(longer, NULL, &ids, &out) == ROUTE_REQUEST_OK);
+    assert(!ids.has_task_block);
+    release(out);
+    assert_same_as_dom(longer, NULL);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("=== Route Request Tests ===\n\n");
+
+    test_layout();
+    test_overrides();
+    test_invalid();
+    test_matches_dom();
+    test_task_block();
+
+    printf("\nAll tests passed!\n");
+    return 0;
+}
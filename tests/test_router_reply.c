@@ -0,0 +1,184 @@
+/**
+ * test_router_reply.c - Single-pass Router reply reader tests
+ */
+
+#include "router_reply.h"
+#include <jansson.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+static int scan(const char *json, router_reply_t *r) {
+    return router_reply_scan(json, strlen(json), r);
+}
+
+static void test_fields(void) {
+    printf("Test: ok, error.code, error.message and intake_error_code... ");
+
+    router_reply_t r;
+    assert(scan("{\"ok\":true,\"decision\":{\"provider_id\":\"p1\"}}", &r) == 0);
+    assert(!r.ok_false && !r.has_error && r.http_status == 0);
+
+    assert(scan(" {\"ok\" : false , \"error\" : {\"code\":\"invalid_request\","
+                "\"message\":\"bad \\\"tenant\\\" \\u00e9\",\"intake_error_code\":\"SCHEMA_VALIDATION_FAILED\","
+                "\"details\":{\"error\":{\"code\":\"internal\"}}},\"context\":[1,2.5e3,null]} ", &r) == 0);
+    assert(r.ok_false && r.has_error && r.has_code && r.has_message);
+    assert(strcmp(r.code, "invalid_request") == 0);
+    assert(strcmp(r.message, "bad \"tenant\" \xc3\xa9") == 0);
+    assert(r.has_intake_key && r.has_intake_code);
+    assert(strcmp(r.intake_error_code, "SCHEMA_VALIDATION_FAILED") == 0);
+    assert(r.http_status == 400);
+
+    /* A null intake code is present but not a string */
+    assert(scan("{\"ok\":false,\"error\":{\"code\":\"internal\",\"intake_error_code\":null}}", &r) == 0);
+    assert(r.has_intake_key && !r.has_intake_code && r.http_status == 500);
+
+    /* Later duplicates win, and a non-object error carries no fields */
+    assert(scan("{\"ok\":true,\"ok\":false,\"error\":{\"code\":\"internal\"},"
+                "\"error\":{\"code\":\"unauthorized\"}}", &r) == 0);
+    assert(r.http_status == 401);
+    assert(scan("{\"ok\":false,\"error\":{\"code\":\"internal\"},\"error\":\"oops\"}", &r) == 0);
+    assert(!r.has_error && !r.has_code && r.http_status == 0);
+
+    /* Escaped keys match like any other, long messages are truncated */
+    char big[1024];
+    memset(big, 0, sizeof(big));
+    strcpy(big, "{\"ok\":false,\"error\":{\"\\u0063ode\":\"policy_not_found\",\"message\":\"");
+    memset(big + strlen(big), 'm', 600);
+    strcat(big, "\"}}");
+    assert(scan(big, &r) == 0);
+    assert(r.http_status == 404);
+    assert(strlen(r.message) == ROUTER_REPLY_MESSAGE_MAX - 1U);
+    printf("OK\n");
+}
+
+static void test_invalid_documents(void) {
+    printf("Test: malformed replies are rejected... ");
+
+    const char *bad[] = {
+        "", "   ", "[]", "\"x\"", "42", "{", "{\"ok\":false", "{\"ok\":fals}",
+        "{\"ok\":false}x", "{\"a\":01}", "{\"a\":1.}", "{\"a\":-}", "{\"a\":[1,]}",
+        "{\"a\":1,}", "{,}", "{\"a\" 1}", "{\"a\":\"\\x\"}", "{\"a\":\"\\u12\"}",
+        "{\"a\":\"\\u0000\"}", "{\"a\":\"\\ud800\"}", "{\"a\":\"\\udc00\"}",
+        "{\"a\":\"\xc3\"}", "{\"a\":\"\xc0\xaf\"}", "{\"a\":\"\xed\xa0\x80\"}",
+        "{\"a\":\"tab\there\"}", "{'a':1}", "{\"a\":tru}", "{\"a\":nul}",
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        router_reply_t r;
+        r.http_status = 123;
+        assert(scan(bad[i], &r) == -1);
+        assert(r.http_status == 0);
+    }
+
+    /* Nesting is bounded like jansson's */
+    char deep[5000];
+    size_t n = 0;
+    deep[n++] = '{';
+    deep[n++] = '"'; deep[n++] = 'a'; deep[n++] = '"'; deep[n++] = ':';
+    for (int i = 0; i < 2100; i++) deep[n++] = '[';
+    for (int i = 0; i < 2100; i++) deep[n++] = ']';
+    deep[n++] = '}';
+    deep[n] = '\0';
+    router_reply_t r;
+    assert(scan(deep, &r) == -1);
+    assert(router_reply_scan(NULL, 0, &r) == -1);
+    printf("OK\n");
+}
+
+/* Same verdict and status as parsing with jansson */
+static int status_via_jansson(const char *json, int *valid) {
+    json_error_t err;
+    json_t *root = json_loads(json, 0, &err);
+    *valid = root != NULL && json_is_object(root);
+    int status = 0;
+    if (*valid) {
+        json_t *ok = json_object_get(root, "ok");
+        json_t *code = json_object_get(json_object_get(root, "error"), "code");
+        if (json_is_false(ok) && json_is_string(code)) {
+            status = router_reply_status_for_code(json_string_value(code));
+        }
+    }
+    json_decref(root);
+    return status;
+}
+
+static void test_matches_jansson(void) {
+    printf("Test: verdicts match jansson on a corpus... ");
+
+    const char *corpus[] = {
+        "{\"ok\":false,\"error\":{\"code\":\"extension_timeout\",\"message\":\"slow\"}}",
+        "{\"ok\":false,\"error\":{\"code\":\"extension_unavailable\"},\"x\":[{},[],\"\",-0.5E-3]}",
+        "{\"ok\":false,\"error\":{\"code\":\"validator_blocked\"}}",
+        "{\"ok\":false,\"error\":{\"code\":\"unknown_code\"}}",
+        "{\"ok\":false,\"error\":{\"code\":7}}",
+        "{\"ok\":0,\"error\":{\"code\":\"internal\"}}",
+        "{\"ok\":false,\"error\":[{\"code\":\"internal\"}]}",
+        "{\"error\":{\"code\":\"internal\"},\"ok\":false}",
+        "{\"ok\":false,\"error\":{\"code\":\"\\u0069nternal\"}}",
+        "{\"ok\":false,\"error\":{\"code\":\"internal\\u0020\"}}",
+        "{\"ok\":false,\"error\":{\"code\":\"\\ud83d\\ude00\"}}",
+        "{\"ok\":false,\"error\":{\"code\":\"decision_failed\"}} \n",
+        "{\"ok\":false,\"error\":{\"code\":\"post_processor_failed\"}}]",
+        "{\"ok\":false,\"error\":{\"code\":\"extension_error\"",
+        "{}",
+        "{\"\":{}}",
+    };
+    for (size_t i = 0; i < sizeof(corpus) / sizeof(corpus[0]); i++) {
+        int valid;
+        int want = status_via_jansson(corpus[i], &valid);
+        router_reply_t r;
+        int rc = scan(corpus[i], &r);
+        assert((rc == 0) == (valid != 0));
+        assert(r.http_status == want);
+    }
+    printf("OK\n");
+}
+
+static void test_splice_intake_null(void) {
+    printf("Test: intake_error_code is spliced in, other bytes untouched... ");
+
+    const char *json = "{\"ok\":false, \"error\" : { \"code\":\"invalid_request\", "
+                       "\"details\":{\"k\":\"}\"} } ,\"context\":{}}";
+    router_reply_t r;
+    assert(scan(json, &r) == 0);
+    assert(!r.has_intake_key);
+
+    size_t len = strlen(json);
+    char out[512];
+    size_t n = router_reply_add_intake_null(json, len, &r, out, sizeof(out));
+    const char *want = "{\"ok\":false, \"error\" : { \"code\":\"invalid_request\", "
+                       "\"details\":{\"k\":\"}\"} ,\"intake_error_code\":null} ,\"context\":{}}";
+    assert(n == strlen(want));
+    assert(strcmp(out, want) == 0);
+
+    /* The result reads back with the field present */
+    router_reply_t again;
+    assert(scan(out, &again) == 0);
+    assert(again.has_intake_key && again.http_status == 400);
+
+    const char *empty = "{\"ok\":false,\"error\":{}}";
+    assert(scan(empty, &r) == 0);
+    n = router_reply_add_intake_null(empty, strlen(empty), &r, out, sizeof(out));
+    assert(strcmp(out, "{\"ok\":false,\"error\":{\"intake_error_code\":null}}") == 0);
+    assert(n == strlen(out));
+
+    /* Too small an output buffer, or no error object, writes nothing */
+    assert(scan(json, &r) == 0);
+    assert(router_reply_add_intake_null(json, len, &r, out, len) == 0);
+    assert(scan("{\"ok\":true}", &r) == 0);
+    assert(router_reply_add_intake_null("{\"ok\":true}", 11, &r, out, sizeof(out)) == 0);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("=== Router Reply Tests ===\n");
+
+    test_fields();
+    test_invalid_documents();
+    test_matches_jansson();
+    test_splice_intake_null();
+
+    printf("\nAll tests passed!\n");
+    return 0;
+}
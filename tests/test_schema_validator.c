@@ -0,0 +1,198 @@
+/**
+ * test_schema_validator.c - Compiled JSON Schema validator tests
+ */
+
+#include "schema_validator.h"
+#include <jansson.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+static schema_validator_t *compile(const char *schema_json) {
+    json_error_t jerr;
+    json_t *schema = json_loads(schema_json, 0, &jerr);
+    assert(schema != NULL);
+    char err[128];
+    schema_validator_t *v = schema_validator_compile(schema, err, sizeof(err));
+    json_decref(schema);
+    return v;
+}
+
+static schema_result_t check(const schema_validator_t *v, const char *json, schema_error_t *error) {
+    return schema_validator_check(v, json, strlen(json), error);
+}
+
+static void test_types_and_bounds(void) {
+    printf("Test: types, numeric bounds and string lengths... ");
+    schema_validator_t *v = compile(
+        "{\"type\":\"object\",\"properties\":{"
+        "\"n\":{\"type\":\"integer\",\"minimum\":1,\"maximum\":10},"
+        "\"x\":{\"type\":\"number\"},"
+        "\"s\":{\"type\":\"string\",\"minLength\":2,\"maxLength\":3},"
+        "\"b\":{\"type\":[\"boolean\",\"null\"]}}}");
+    assert(v != NULL);
+    schema_error_t e;
+
+    assert(check(v, "{}", &e) == SCHEMA_VALID);
+    assert(check(v, "{\"n\":5,\"x\":1.5,\"s\":\"ab\",\"b\":null,\"other\":[1,{}]}", &e) == SCHEMA_VALID);
+    assert(check(v, "{\"n\":3.0}", &e) == SCHEMA_VALID);       /* Integral */
+    assert(check(v, "{\"x\":7}", &e) == SCHEMA_VALID);         /* Integers are numbers */
+
+    assert(check(v, "{\"n\":2.5}", &e) == SCHEMA_INVALID);
+    assert(strcmp(e.path, "#/n") == 0 && strstr(e.reason, "type") != NULL);
+    assert(check(v, "{\"n\":11}", &e) == SCHEMA_INVALID);
+    assert(strcmp(e.reason, "is greater than maximum") == 0);
+    assert(check(v, "{\"n\":0}", &e) == SCHEMA_INVALID);
+    assert(check(v, "{\"n\":\"5\"}", &e) == SCHEMA_INVALID);
+    assert(check(v, "{\"b\":1}", &e) == SCHEMA_INVALID);
+    assert(check(v, "[]", &e) == SCHEMA_INVALID);
+    assert(strcmp(e.path, "#") == 0);
+
+    /* Lengths count code points, escapes included */
+    assert(check(v, "{\"s\":\"\\u00e9\\u00e9\"}", &e) == SCHEMA_VALID);
+    assert(check(v, "{\"s\":\"\xc3\xa9\xc3\xa9\xc3\xa9\"}", &e) == SCHEMA_VALID);
+    assert(check(v, "{\"s\":\"\\ud83d\\ude00\"}", &e) == SCHEMA_INVALID);    /* One code point */
+    assert(strcmp(e.reason, "is shorter than minLength") == 0);
+    assert(check(v, "{\"s\":\"abcd\"}", &e) == SCHEMA_INVALID);
+
+    assert(check(v, "{\"n\":5", &e) == SCHEMA_MALFORMED);
+    assert(check(v, "{\"n\":5} x", &e) == SCHEMA_MALFORMED);
+    assert(check(v, "{\"other\":[1,]}", &e) == SCHEMA_MALFORMED);
+    schema_validator_free(v);
+    printf("OK\n");
+}
+
+static void test_required_and_additional(void) {
+    printf("Test: required and additionalProperties... ");
+    schema_validator_t *v = compile(
+        "{\"type\":\"object\",\"required\":[\"id\",\"meta\",\"id\"],\"additionalProperties\":false,"
+        "\"properties\":{\"id\":{\"type\":\"string\"},\"tags\":{\"type\":\"array\",\"items\":{\"type\":\"string\"}},"
+        "\"meta\":{\"type\":\"object\",\"additionalProperties\":{\"type\":\"integer\"}}}}");
+    assert(v != NULL);
+    schema_error_t e;
+    assert(check(v, "{\"id\":\"a\",\"meta\":{}}", &e) == SCHEMA_VALID);
+    assert(check(v, "{\"id\":\"a\",\"meta\":{\"k\":1},\"tags\":[\"x\",\"y\"]}", &e) == SCHEMA_VALID);
+
+    assert(check(v, "{\"meta\":{}}", &e) == SCHEMA_INVALID);
+    assert(strcmp(e.path, "#/id") == 0 && strcmp(e.reason, "is required") == 0);
+    assert(check(v, "{\"id\":\"a\",\"meta\":{},\"extra\":1}", &e) == SCHEMA_INVALID);
+    assert(strcmp(e.path, "#/extra") == 0 && strcmp(e.reason, "is not an allowed property") == 0);
+    assert(check(v, "{\"id\":\"a\",\"meta\":{\"k\":\"v\"}}", &e) == SCHEMA_INVALID);
+    assert(strcmp(e.path, "#/meta/k") == 0);
+    assert(check(v, "{\"id\":\"a\",\"meta\":{},\"tags\":[\"x\",2]}", &e) == SCHEMA_INVALID);
+    assert(strcmp(e.path, "#/tags/1") == 0);
+
+    /* Paths are percent-encoded JSON pointers */
+    assert(check(v, "{\"id\":\"a\",\"meta\":{},\"a/b \\\"c\\\"\":1}", &e) == SCHEMA_INVALID);
+    assert(strcmp(e.path, "#/a~1b%20%22c%22") == 0);
+    schema_validator_free(v);
+
+    /* A key too long for any property never matches the "" property */
+    v = compile("{\"properties\":{\"\":{\"type\":\"integer\"},\"ab\":{\"type\":\"integer\"}}}");
+    assert(v != NULL);
+    char doc[512];
+    int n = snprintf(doc, sizeof(doc), "{\"\":1,\"abc\":\"x\",\"");
+    memset(doc + n, 'k', 300);
+    snprintf(doc + n + 300, sizeof(doc) - (size_t)n - 300U, "\":\"x\"}");
+    assert(check(v, doc, &e) == SCHEMA_VALID);
+    assert(check(v, "{\"\" : \"x\"}", &e) == SCHEMA_INVALID);
+    assert(check(v, "{\"a\\\"\":\"x\"}", &e) == SCHEMA_VALID);
+    schema_validator_free(v);
+    printf("OK\n");
+}
+
+static void test_composition_enum_ref(void) {
+    printf("Test: allOf/anyOf/oneOf, enum and $ref... ");
+    schema_validator_t *v;
+    v = compile(
+        "{\"definitions\":{\"pos\":{\"type\":\"integer\",\"minimum\":1},"
+        "\"node\":{\"type\":\"object\",\"properties\":{\"kids\":{\"type\":\"array\",\"items\":{\"$ref\":\"#/definitions/node\"}},"
+        "\"v\":{\"$ref\":\"#/definitions/pos\"}}}},"
+        "\"type\":\"object\",\"properties\":{"
+        "\"mode\":{\"enum\":[\"fast\",\"slow\",{\"k\":1}]},"
+        "\"count\":{\"$ref\":\"#/definitions/pos\"},"
+        "\"either\":{\"anyOf\":[{\"type\":\"string\"},{\"type\":\"integer\"}]},"
+        "\"exactly\":{\"oneOf\":[{\"type\":\"integer\"},{\"type\":\"number\",\"minimum\":5}]},"
+        "\"both\":{\"allOf\":[{\"type\":\"integer\"},{\"maximum\":3}]},"
+        "\"tree\":{\"$ref\":\"#/definitions/node\"},"
+        "\"remote\":{\"$ref\":\"http://example.com/schema\"},"
+        "\"dangling\":{\"$ref\":\"#/definitions/missing\",\"type\":\"string\"}}}");
+    assert(v != NULL);
+    schema_error_t e;
+    assert(check(v, "{\"mode\":\"fast\",\"count\":2,\"either\":\"s\",\"exactly\":2,\"both\":3}", &e) == SCHEMA_VALID);
+    assert(check(v, "{\"mode\":{ \"k\" : 1.0 }}", &e) == SCHEMA_VALID);
+    assert(check(v, "{\"mode\":\"medium\"}", &e) == SCHEMA_INVALID);
+    assert(strcmp(e.path, "#/mode") == 0);
+    assert(check(v, "{\"count\":0}", &e) == SCHEMA_INVALID);
+    assert(check(v, "{\"either\":1.5}", &e) == SCHEMA_INVALID);
+    assert(strcmp(e.path, "#/either") == 0);
+    assert(check(v, "{\"exactly\":7}", &e) == SCHEMA_INVALID);      /* Matches both */
+    assert(check(v, "{\"exactly\":7.5}", &e) == SCHEMA_VALID);
+    assert(check(v, "{\"both\":4}", &e) == SCHEMA_INVALID);
+    assert(strcmp(e.path, "#/both") == 0 && strcmp(e.reason, "is greater than maximum") == 0);
+    assert(check(v, "{\"remote\":[1,2]}", &e) == SCHEMA_VALID);
+    assert(check(v, "{\"dangling\":[1,2]}", &e) == SCHEMA_VALID);
+
+    /* Recursive $ref through the tree */
+    assert(check(v, "{\"tree\":{\"v\":1,\"kids\":[{\"v\":2,\"kids\":[{\"v\":3}]}]}}", &e) == SCHEMA_VALID);
+    assert(check(v, "{\"tree\":{\"v\":1,\"kids\":[{\"v\":2,\"kids\":[{\"v\":0}]}]}}", &e) == SCHEMA_INVALID);
+    assert(strcmp(e.path, "#/tree/kids/0/kids/0/v") == 0);
+    schema_validator_free(v);
+
+    /* A reference loop that never reaches the instance */
+    v = compile("{\"$ref\":\"#\"}");
+    assert(v != NULL);
+    assert(check(v, "{}", &e) == SCHEMA_INVALID);
+    schema_validator_free(v);
+    printf("OK\n");
+}
+
+static void test_compile_errors(void) {
+    printf("Test: malformed schemas do not compile... ");
+    const char *bad[] = {
+        "{\"type\":\"thing\"}",
+        "{\"type\":[]}",
+        "{\"properties\":[]}",
+        "{\"properties\":{\"a\":1}}",
+        "{\"required\":[1]}",
+        "{\"items\":[{}]}",
+        "{\"additionalProperties\":1}",
+        "{\"enum\":{}}",
+        "{\"anyOf\":[]}",
+        "{\"oneOf\":[1]}",
+        "{\"minimum\":\"1\"}",
+        "{\"maxLength\":1.5}",
+        "{\"format\":1}",
+        "{\"$ref\":1}",
+        "{\"definitions\":[]}",
+        "{\"$schema\":\"http://json-schema.org/draft-04/schema#\"}",
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        assert(compile(bad[i]) == NULL);
+    }
+
+    char deep[4096] = "";
+    for (int i = 0; i <= SCHEMA_MAX_DEPTH + 1; i++) strcat(deep, "{\"items\":");
+    strcat(deep, "{}");
+    for (int i = 0; i <= SCHEMA_MAX_DEPTH + 1; i++) strcat(deep, "}");
+    assert(compile(deep) == NULL);
+
+    schema_validator_t *v = compile("{\"$schema\":\"http://json-schema.org/draft-07/schema#\","
+                                    "\"format\":\"email\",\"$defs\":{}}");
+    assert(v != NULL && schema_validator_size(v) == 1);
+    schema_validator_free(v);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("=== Schema Validator Tests ===\n\n");
+
+    test_types_and_bounds();
+    test_required_and_additional();
+    test_composition_enum_ref();
+    test_compile_errors();
+
+    printf("\nAll tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,252 @@
+/**
+ * test_sse_hub.c - SSE fan-out engine tests
+ */
+
+#define _GNU_SOURCE
+#include "sse_hub.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+/* Subscriber end handed to the hub in sv[0], test end in sv[1] */
+static void make_pair(int sv[2]) {
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    int flags = fcntl(sv[0], F_GETFL, 0);
+    assert(fcntl(sv[0], F_SETFL, flags | O_NONBLOCK) == 0);
+}
+
+static sse_hub_t *make_hub(int max_subscribers, int queue_events, int heartbeat_ms, int stall_ms) {
+    sse_hub_config_t config;
+    sse_hub_get_default_config(&config);
+    config.max_subscribers = max_subscribers;
+    config.queue_events = queue_events;
+    config.heartbeat_ms = heartbeat_ms;
+    config.stall_timeout_ms = stall_ms;
+    sse_hub_t *hub = sse_hub_create(&config);
+    assert(hub != NULL);
+    assert(sse_hub_start(hub) == 0);
+    return hub;
+}
+
+/* Read until `want` bytes arrived, the peer closed, or timeout_ms passed */
+static size_t read_for(int fd, char *buf, size_t want, int timeout_ms) {
+    size_t got = 0;
+    while (got < want) {
+        struct pollfd p = { .fd = fd, .events = POLLIN };
+        if (poll(&p, 1, timeout_ms) <= 0) break;
+        ssize_t n = read(fd, buf + got, want - got);
+        if (n <= 0) break;
+        got += (size_t)n;
+    }
+    buf[got] = '\0';
+    return got;
+}
+
+static int peer_closed(int fd, int timeout_ms) {
+    char sink[65536];
+    for (;;) {
+        struct pollfd p = { .fd = fd, .events = POLLIN };
+        if (poll(&p, 1, timeout_ms) <= 0) return 0;
+        ssize_t n = read(fd, sink, sizeof(sink));
+        if (n <= 0) return 1;
+    }
+}
+
+static void test_tenant_routing(void) {
+    printf("Test: events reach only their tenant, broadcasts reach all... ");
+
+    sse_hub_t *hub = make_hub(16, 16, 60000, 60000);
+    int a[2], b[2];
+    make_pair(a);
+    make_pair(b);
+    assert(sse_hub_subscribe(hub, a[0], "tenant-a") == 0);
+    assert(sse_hub_subscribe(hub, b[0], "tenant-b") == 0);
+
+    const char *json = "{\"id\":1}";
+    assert(sse_hub_publish(hub, "tenant-a", "message_created", json, strlen(json)) == 0);
+    assert(sse_hub_publish(hub, NULL, "notice", "{}", 2) == 0);
+
+    const char *for_a = "event: message_created\ndata: {\"id\":1}\n\n"
+                        "event: notice\ndata: {}\n\n";
+    const char *for_b = "event: notice\ndata: {}\n\n";
+    char buf[256];
+    assert(read_for(a[1], buf, strlen(for_a), 2000) == strlen(for_a));
+    assert(strcmp(buf, for_a) == 0);
+    assert(read_for(b[1], buf, strlen(for_b), 2000) == strlen(for_b));
+    assert(strcmp(buf, for_b) == 0);
+    assert(read_for(b[1], buf, 1, 50) == 0);
+
+    sse_hub_stats_t stats;
+    assert(sse_hub_get_stats(hub, &stats) == 0);
+    assert(stats.subscribers == 2);
+    assert(stats.published == 2);
+    assert(stats.delivered == 3);
+
+    sse_hub_destroy(hub);
+    assert(peer_closed(a[1], 1000));
+    assert(peer_closed(b[1], 1000));
+    close(a[1]);
+    close(b[1]);
+    printf("OK\n");
+}
+
+static void test_capacity(void) {
+    printf("Test: subscriptions beyond capacity are refused... ");
+
+    sse_hub_t *hub = make_hub(2, 16, 60000, 60000);
+    int s[3][2];
+    for (int i = 0; i < 3; i++) {
+        make_pair(s[i]);
+    }
+    assert(sse_hub_subscribe(hub, s[0][0], "t") == 0);
+    assert(sse_hub_subscribe(hub, s[1][0], "t") == 0);
+    assert(sse_hub_subscribe(hub, s[2][0], "t") == -1);   /* caller keeps the fd */
+
+    /* A hang-up frees the slot */
+    close(s[0][1]);
+    sse_hub_stats_t stats;
+    for (int i = 0; i < 200; i++) {
+        assert(sse_hub_get_stats(hub, &stats) == 0);
+        if (stats.subscribers == 1) break;
+        usleep(5000);
+    }
+    assert(stats.subscribers == 1);
+    assert(stats.disconnected == 1);
+    assert(stats.refused == 1);
+    assert(sse_hub_subscribe(hub, s[2][0], "t") == 0);
+
+    sse_hub_destroy(hub);
+    close(s[1][1]);
+    close(s[2][1]);
+    printf("OK\n");
+}
+
+static void test_slow_consumer_evicted(void) {
+    printf("Test: a slow consumer is evicted without holding up others... ");
+
+    sse_hub_t *hub = make_hub(16, 8, 60000, 60000);
+    int slow[2], fast[2];
+    make_pair(slow);
+    make_pair(fast);
+    int small = 4096;
+    (void)setsockopt(slow[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+    assert(sse_hub_subscribe(hub, slow[0], "t") == 0);
+    assert(sse_hub_subscribe(hub, fast[0], "t") == 0);
+
+    /* The slow side never reads: its socket fills, then its ring */
+    char payload[1024];
+    memset(payload, 'x', sizeof(payload));
+    char buf[2048];
+    for (int i = 0; i < 200; i++) {
+        assert(sse_hub_publish(hub, "t", "e", payload, sizeof(payload)) == 0);
+        size_t frame = 15U + sizeof(payload) + 2U;    /* "event: e\ndata: " ... "\n\n" */
+        assert(read_for(fast[1], buf, frame, 2000) == frame);
+    }
+
+    sse_hub_stats_t stats;
+    assert(sse_hub_get_stats(hub, &stats) == 0);
+    assert(stats.evicted_overflow == 1);
+    assert(stats.subscribers == 1);
+    assert(peer_closed(slow[1], 1000));
+
+    sse_hub_destroy(hub);
+    close(slow[1]);
+    close(fast[1]);
+    printf("OK\n");
+}
+
+static void test_stalled_consumer_evicted(void) {
+    printf("Test: a consumer with no write progress is evicted... ");
+
+    sse_hub_t *hub = make_hub(16, 1024, 60000, 100);
+    int s[2];
+    make_pair(s);
+    int small = 4096;
+    (void)setsockopt(s[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+    assert(sse_hub_subscribe(hub, s[0], "t") == 0);
+
+    /* Fill the socket but not the ring, then wait out the stall timeout */
+    char payload[1024];
+    memset(payload, 'y', sizeof(payload));
+    for (int i = 0; i < 512; i++) {
+        assert(sse_hub_publish(hub, "t", "e", payload, sizeof(payload)) == 0);
+    }
+    usleep(400000);
+
+    sse_hub_stats_t stats;
+    assert(sse_hub_get_stats(hub, &stats) == 0);
+    assert(stats.evicted_stalled == 1);
+    assert(stats.evicted_overflow == 0);
+    assert(peer_closed(s[1], 1000));
+
+    sse_hub_destroy(hub);
+    close(s[1]);
+    printf("OK\n");
+}
+
+static void test_heartbeat(void) {
+    printf("Test: idle streams get heartbeats... ");
+
+    sse_hub_t *hub = make_hub(16, 16, 50, 60000);
+    int s[2];
+    make_pair(s);
+    assert(sse_hub_subscribe(hub, s[0], "t") == 0);
+
+    char buf[64];
+    const char *ping = ": ping\n\n";
+    assert(read_for(s[1], buf, strlen(ping), 2000) == strlen(ping));
+    assert(strcmp(buf, ping) == 0);
+    assert(read_for(s[1], buf, strlen(ping), 2000) == strlen(ping));
+
+    sse_hub_stats_t stats;
+    assert(sse_hub_get_stats(hub, &stats) == 0);
+    assert(stats.heartbeats >= 2);
+
+    sse_hub_destroy(hub);
+    close(s[1]);
+    printf("OK\n");
+}
+
+static void test_many_subscribers(void) {
+    printf("Test: one event reaches hundreds of subscribers... ");
+
+    enum { N = 400 };
+    sse_hub_t *hub = make_hub(N, 16, 60000, 60000);
+    static int s[N][2];
+    for (int i = 0; i < N; i++) {
+        make_pair(s[i]);
+        assert(sse_hub_subscribe(hub, s[i][0], "t") == 0);
+    }
+    assert(sse_hub_publish(hub, "t", "e", "{}", 2) == 0);
+
+    const char *frame = "event: e\ndata: {}\n\n";
+    char buf[64];
+    for (int i = 0; i < N; i++) {
+        assert(read_for(s[i][1], buf, strlen(frame), 2000) == strlen(frame));
+        assert(strcmp(buf, frame) == 0);
+    }
+    sse_hub_destroy(hub);
+    for (int i = 0; i < N; i++) {
+        close(s[i][1]);
+    }
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("=== SSE Hub Tests ===\n");
+
+    test_tenant_routing();
+    test_capacity();
+    test_slow_consumer_evicted();
+    test_stalled_consumer_evicted();
+    test_heartbeat();
+    test_many_subscribers();
+
+    printf("\nAll tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,203 @@
+/**
+ * test_worker_pool.c - Bounded worker pool tests
+ */
+
+#include "worker_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#define PRODUCERS 4
+#define PER_PRODUCER 5000
+
+typedef struct {
+    atomic_int runs[PRODUCERS * PER_PRODUCER];
+    atomic_int ran;
+    atomic_int shed;
+    atomic_int inits;
+    atomic_int release;              /* Workers block in run until set */
+    atomic_uint_fast64_t max_sojourn_us;
+} counters_t;
+
+static void count_run(void *task, uint64_t sojourn_us, void *user_data) {
+    counters_t *c = user_data;
+    (void)sojourn_us;
+    if (task) {
+        atomic_fetch_add(&c->runs[(intptr_t)task - 1], 1);
+    }
+    while (!atomic_load(&c->release)) {
+        usleep(1000);
+    }
+    atomic_fetch_add(&c->ran, 1);
+}
+
+static void count_shed(void *task, uint64_t sojourn_us, void *user_data) {
+    counters_t *c = user_data;
+    (void)task;
+    uint64_t prev = atomic_load(&c->max_sojourn_us);
+    while (sojourn_us > prev &&
+           !atomic_compare_exchange_weak(&c->max_sojourn_us, &prev, sojourn_us)) {
+    }
+    atomic_fetch_add(&c->shed, 1);
+}
+
+static void count_init(void *user_data) {
+    counters_t *c = user_data;
+    atomic_fetch_add(&c->inits, 1);
+}
+
+static worker_pool_t *make_pool(counters_t *c, int threads, size_t capacity) {
+    worker_pool_config_t config = {
+        .num_threads = threads,
+        .queue_capacity = capacity,
+        .run = count_run,
+        .shed = count_shed,
+        .thread_init = count_init,
+        .user_data = c,
+    };
+    return worker_pool_create(&config);
+}
+
+typedef struct {
+    worker_pool_t *pool;
+    int base;
+} producer_arg_t;
+
+static void *produce(void *p) {
+    producer_arg_t *a = p;
+    for (int i = 0; i < PER_PRODUCER; i++) {
+        intptr_t id = a->base + i + 1;
+        /* Spin on a full queue; every task must get in eventually */
+        while (worker_pool_submit(a->pool, (void *)id,
+                                  worker_pool_now_ms() + 60000U) != 0) {
+            usleep(100);
+        }
+    }
+    return NULL;
+}
+
+static void test_every_task_runs_once(void) {
+    printf("Test: concurrent producers, every task runs exactly once... ");
+
+    static counters_t c;
+    memset(&c, 0, sizeof(c));
+    atomic_store(&c.release, 1);
+    worker_pool_t *pool = make_pool(&c, 4, 64);
+    assert(pool != NULL);
+    assert(worker_pool_get_num_threads(pool) == 4);
+
+    pthread_t threads[PRODUCERS];
+    producer_arg_t args[PRODUCERS];
+    for (int i = 0; i < PRODUCERS; i++) {
+        args[i].pool = pool;
+        args[i].base = i * PER_PRODUCER;
+        assert(pthread_create(&threads[i], NULL, produce, &args[i]) == 0);
+    }
+    for (int i = 0; i < PRODUCERS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    worker_pool_destroy(pool);
+
+    assert(atomic_load(&c.inits) == 4);
+    assert(atomic_load(&c.ran) == PRODUCERS * PER_PRODUCER);
+    assert(atomic_load(&c.shed) == 0);
+    for (int i = 0; i < PRODUCERS * PER_PRODUCER; i++) {
+        assert(atomic_load(&c.runs[i]) == 1);
+    }
+    printf("OK\n");
+}
+
+static void test_full_queue_rejects(void) {
+    printf("Test: a full queue refuses submissions... ");
+
+    static counters_t c;
+    memset(&c, 0, sizeof(c));
+    worker_pool_t *pool = make_pool(&c, 1, 3);     /* rounds up to 4 */
+    assert(pool != NULL);
+
+    /* The only worker holds one task; four more fill the ring */
+    uint64_t deadline = worker_pool_now_ms() + 60000U;
+    assert(worker_pool_submit(pool, NULL, deadline) == 0);
+    while (worker_pool_depth(pool) != 0) {
+        usleep(1000);
+    }
+    for (int i = 0; i < 4; i++) {
+        assert(worker_pool_submit(pool, NULL, deadline) == 0);
+    }
+    assert(worker_pool_depth(pool) == 4);
+    assert(worker_pool_submit(pool, NULL, deadline) == -1);
+
+    worker_pool_stats_t stats;
+    assert(worker_pool_get_stats(pool, &stats) == 0);
+    assert(stats.submitted == 5);
+    assert(stats.rejected == 1);
+    assert(stats.depth == 4);
+
+    atomic_store(&c.release, 1);
+    worker_pool_destroy(pool);
+    assert(atomic_load(&c.ran) == 5);
+    printf("OK\n");
+}
+
+static void test_expired_tasks_are_shed(void) {
+    printf("Test: tasks past their deadline are shed, not run... ");
+
+    static counters_t c;
+    memset(&c, 0, sizeof(c));
+    worker_pool_t *pool = make_pool(&c, 1, 16);
+    assert(pool != NULL);
+
+    /* Occupy the worker, then queue tasks that expire while waiting */
+    uint64_t now = worker_pool_now_ms();
+    assert(worker_pool_submit(pool, NULL, now + 60000U) == 0);
+    for (int i = 0; i < 3; i++) {
+        assert(worker_pool_submit(pool, NULL, now + 20U) == 0);
+    }
+    assert(worker_pool_submit(pool, NULL, now + 60000U) == 0);
+    usleep(50000);
+    atomic_store(&c.release, 1);
+    worker_pool_destroy(pool);
+
+    assert(atomic_load(&c.ran) == 2);
+    assert(atomic_load(&c.shed) == 3);
+    assert(atomic_load(&c.max_sojourn_us) >= 40000U);
+    printf("OK\n");
+}
+
+static void test_destroy_drains_queue(void) {
+    printf("Test: destroy runs everything already queued... ");
+
+    static counters_t c;
+    memset(&c, 0, sizeof(c));
+    worker_pool_t *pool = make_pool(&c, 2, 128);
+    assert(pool != NULL);
+
+    uint64_t deadline = worker_pool_now_ms() + 60000U;
+    for (int i = 0; i < 100; i++) {
+        assert(worker_pool_submit(pool, NULL, deadline) == 0);
+    }
+    atomic_store(&c.release, 1);
+    worker_pool_destroy(pool);
+    assert(atomic_load(&c.ran) == 100);
+
+    worker_pool_config_t bad = { .queue_capacity = 8, .run = count_run };
+    assert(worker_pool_create(&bad) == NULL);
+    assert(worker_pool_submit(NULL, NULL, 0) == -1);
+    printf("OK\n");
+}
+
+int main(void) {
+    printf("=== Worker Pool Tests ===\n");
+
+    test_every_task_runs_once();
+    test_full_queue_rejects();
+    test_expired_tasks_are_shed();
+    test_destroy_drains_queue();
+
+    printf("\nAll tests passed!\n");
+    return 0;
+}